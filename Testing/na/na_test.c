@@ -15,6 +15,8 @@
 #include "na_mpi.h"
 #endif
 
+#include "mercury_time.h"
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
@@ -539,3 +541,65 @@ NA_Test_bcast(char *buf, int count, int root, struct na_test_info *na_test_info)
     (void) na_test_info;
 #endif
 }
+
+/*---------------------------------------------------------------------------*/
+int
+na_test_unit_cb(const struct na_cb_info *callback_info)
+{
+    struct na_test_unit_cb_info *cb_info =
+        (struct na_test_unit_cb_info *) callback_info->arg;
+
+    cb_info->ret = callback_info->ret;
+    if (callback_info->type == NA_CB_LOOKUP)
+        cb_info->addr = callback_info->info.lookup.addr;
+    else if (callback_info->type == NA_CB_RECV_UNEXPECTED
+        && callback_info->ret == NA_SUCCESS) {
+        cb_info->addr = callback_info->info.recv_unexpected.source;
+        cb_info->tag = callback_info->info.recv_unexpected.tag;
+        cb_info->buf = callback_info->info.recv_unexpected.actual_buf;
+        cb_info->buf_size = callback_info->info.recv_unexpected.actual_buf_size;
+    } else if (callback_info->type == NA_CB_RECV_EXPECTED
+        && callback_info->ret == NA_SUCCESS) {
+        cb_info->buf = callback_info->info.recv_expected.actual_buf;
+        cb_info->buf_size = callback_info->info.recv_expected.actual_buf_size;
+    }
+    cb_info->completed++;
+
+    return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+void
+na_test_unit_trigger(struct na_test_unit *na_test_unit)
+{
+    unsigned int actual_count;
+
+    do {
+        actual_count = 0;
+        NA_Trigger(na_test_unit->context, 0, 16, NULL, &actual_count);
+    } while (actual_count);
+}
+
+/*---------------------------------------------------------------------------*/
+na_return_t
+na_test_unit_progress(struct na_test_unit *na_test_unit, const int *completed,
+    int target)
+{
+    hg_time_t deadline, now;
+
+    hg_time_get_current(&now);
+    deadline = hg_time_add(now,
+        hg_time_from_double(NA_TEST_UNIT_TIMEOUT / 1000.0));
+    while (*completed < target) {
+        if (hg_time_less(deadline, now)) {
+            NA_LOG_ERROR("Timed out with %d of %d completions", *completed,
+                target);
+            return NA_TIMEOUT;
+        }
+        NA_Progress(na_test_unit->na_class, na_test_unit->context, 10);
+        na_test_unit_trigger(na_test_unit);
+        hg_time_get_current(&now);
+    }
+
+    return NA_SUCCESS;
+}
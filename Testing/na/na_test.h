@@ -49,12 +49,31 @@ struct na_test_info {
     na_bool_t extern_init;      /* Extern init */
 };
 
+/* Class and context of single process unit tests */
+struct na_test_unit {
+    na_class_t *na_class;       /* NA class */
+    na_context_t *context;      /* NA context */
+};
+
+/* Completion of unit test operations, passed as na_test_unit_cb() arg */
+struct na_test_unit_cb_info {
+    int completed;              /* Number of completed operations */
+    na_return_t ret;            /* Return code of last completion */
+    na_addr_t addr;             /* Lookup or unexpected source address */
+    na_tag_t tag;               /* Unexpected tag */
+    void *buf;                  /* Actual received buffer */
+    na_size_t buf_size;         /* Actual received size */
+};
+
 /*****************/
 /* Public Macros */
 /*****************/
 
 #define NA_TEST_MAX_ADDR_NAME 256
 
+/* Max time to wait for unit test completions (ms) */
+#define NA_TEST_UNIT_TIMEOUT 10000
+
 /*********************/
 /* Public Prototypes */
 /*********************/
@@ -105,6 +124,26 @@ NA_Test_barrier(struct na_test_info *na_test_info);
 void
 NA_Test_bcast(char *buf, int count, int root, struct na_test_info *na_test_info);
 
+/**
+ * Completion callback of unit tests, arg must be a na_test_unit_cb_info
+ */
+int
+na_test_unit_cb(const struct na_cb_info *callback_info);
+
+/**
+ * Trigger completed callbacks of unit test context
+ */
+void
+na_test_unit_trigger(struct na_test_unit *na_test_unit);
+
+/**
+ * Progress and trigger until completed reaches target, returns NA_TIMEOUT
+ * if it did not within NA_TEST_UNIT_TIMEOUT
+ */
+na_return_t
+na_test_unit_progress(struct na_test_unit *na_test_unit, const int *completed,
+    int target);
+
 #ifdef __cplusplus
 }
 #endif
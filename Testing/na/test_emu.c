@@ -0,0 +1,413 @@
+/*
+ * Copyright (C) 2013-2019 Argonne National Laboratory, Department of Energy,
+ *                    UChicago Argonne, LLC and The HDF Group.
+ * All rights reserved.
+ *
+ * The full copyright notice, including terms governing use, modification,
+ * and redistribution, is contained in the COPYING file that can be
+ * found at the root of the source code distribution tree.
+ */
+
+#include "na_test.h"
+
+#include "mercury_time.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/****************/
+/* Local Macros */
+/****************/
+
+#define NA_TEST_SERVER_INFO     "inproc://"
+/* Emulated link on top of the in-process plugin */
+#define NA_TEST_CLIENT_INFO     "emu+inproc+inproc://"
+
+#define NA_TEST_LATENCY_ENV     "HG_NA_EMU_LATENCY"
+#define NA_TEST_JITTER_ENV      "HG_NA_EMU_JITTER"
+#define NA_TEST_LOSS_ENV        "HG_NA_EMU_LOSS"
+
+#define NA_TEST_LATENCY         "20000"     /* us */
+#define NA_TEST_JITTER          "10000"     /* us */
+#define NA_TEST_LONG_LATENCY    "10000000"  /* us */
+
+/* Messages sent at once with jitter */
+#define NA_TEST_MSG_COUNT       32
+
+/* Time during which lost messages must not be received (ms) */
+#define NA_TEST_LOSS_WAIT       100
+
+#define NA_TEST_RMA_SIZE        64
+
+#define NA_TEST_TAG             42
+
+/*******************/
+/* Local Variables */
+/*******************/
+
+/* Class receiving unexpected messages */
+static na_class_t *na_test_server_class_g = NULL;
+
+/*---------------------------------------------------------------------------*/
+static int
+na_test_cb(const struct na_cb_info *callback_info)
+{
+    struct na_test_unit_cb_info *cb_info =
+        (struct na_test_unit_cb_info *) callback_info->arg;
+
+    na_test_unit_cb(callback_info);
+    if (callback_info->type == NA_CB_RECV_UNEXPECTED
+        && callback_info->ret == NA_SUCCESS)
+        NA_Addr_free(na_test_server_class_g, cb_info->addr);
+
+    return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+na_test_progress(struct na_test_unit *info)
+{
+    NA_Progress(info->na_class, info->context, 1);
+    na_test_unit_trigger(info);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_test_wait(struct na_test_unit *server, struct na_test_unit *client,
+    const int *completed, int target)
+{
+    hg_time_t deadline, now;
+
+    hg_time_get_current(&now);
+    deadline = hg_time_add(now,
+        hg_time_from_double(NA_TEST_UNIT_TIMEOUT / 1000.0));
+    while (*completed < target) {
+        if (hg_time_less(deadline, now)) {
+            fprintf(stderr, "Error: timed out with %d of %d completions\n",
+                *completed, target);
+            return NA_TIMEOUT;
+        }
+        na_test_progress(client);
+        na_test_progress(server);
+        hg_time_get_current(&now);
+    }
+
+    return NA_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+na_test_client_init(struct na_test_unit *client, const char *env,
+    const char *value, const char *addr_string, na_addr_t *addr)
+{
+    setenv(env, value, 1);
+    client->na_class = NA_Initialize(NA_TEST_CLIENT_INFO, NA_FALSE);
+    unsetenv(env);
+    if (!client->na_class) {
+        fprintf(stderr, "Error: could not initialize emu class\n");
+        return EXIT_FAILURE;
+    }
+    client->context = NA_Context_create(client->na_class);
+    if (!client->context) {
+        fprintf(stderr, "Error: could not create emu context\n");
+        NA_Finalize(client->na_class);
+        return EXIT_FAILURE;
+    }
+    if (NA_Addr_lookup2(client->na_class, addr_string, addr) != NA_SUCCESS) {
+        fprintf(stderr, "Error: could not look up server address\n");
+        NA_Context_destroy(client->na_class, client->context);
+        NA_Finalize(client->na_class);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+na_test_client_finalize(struct na_test_unit *client, na_addr_t addr)
+{
+    int rc = EXIT_SUCCESS;
+
+    NA_Addr_free(client->na_class, addr);
+    if (NA_Context_destroy(client->na_class, client->context) != NA_SUCCESS) {
+        fprintf(stderr, "Error: could not destroy emu context\n");
+        rc = EXIT_FAILURE;
+    }
+    if (NA_Finalize(client->na_class) != NA_SUCCESS) {
+        fprintf(stderr, "Error: could not finalize emu class\n");
+        rc = EXIT_FAILURE;
+    }
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+test_latency(struct na_test_unit *server, const char *addr_string)
+{
+    struct na_test_unit client;
+    struct na_test_unit_cb_info cb_info;
+    hg_time_t t1, t2;
+    double elapsed;
+    na_addr_t addr;
+    char buf[16];
+    int rc;
+
+    rc = na_test_client_init(&client, NA_TEST_LATENCY_ENV, NA_TEST_LATENCY,
+        addr_string, &addr);
+    if (rc != EXIT_SUCCESS)
+        return rc;
+
+    /* Message is not delivered before the link latency has elapsed */
+    memset(&cb_info, 0, sizeof(cb_info));
+    NA_Msg_recv_unexpected(server->na_class, server->context, na_test_cb,
+        &cb_info, buf, sizeof(buf), NULL, NA_OP_ID_IGNORE);
+    hg_time_get_current(&t1);
+    NA_Msg_send_unexpected(client.na_class, client.context, na_test_cb,
+        &cb_info, buf, sizeof(buf), NULL, addr, 0, NA_TEST_TAG,
+        NA_OP_ID_IGNORE);
+    if (na_test_wait(server, &client, &cb_info.completed, 2) != NA_SUCCESS)
+        rc = EXIT_FAILURE;
+    hg_time_get_current(&t2);
+    elapsed = hg_time_to_double(hg_time_subtract(t2, t1));
+    if (rc == EXIT_SUCCESS && (cb_info.ret != NA_SUCCESS
+        || elapsed < atof(NA_TEST_LATENCY) / 1e6)) {
+        fprintf(stderr, "Error: message delivered after %g s\n", elapsed);
+        rc = EXIT_FAILURE;
+    }
+
+    if (na_test_client_finalize(&client, addr) != EXIT_SUCCESS)
+        rc = EXIT_FAILURE;
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+test_jitter(struct na_test_unit *server, const char *addr_string)
+{
+    struct na_test_unit client;
+    struct na_test_unit_cb_info cb_info;
+    na_addr_t addr;
+    int send_bufs[NA_TEST_MSG_COUNT], recv_bufs[NA_TEST_MSG_COUNT];
+    int i, rc;
+
+    rc = na_test_client_init(&client, NA_TEST_JITTER_ENV, NA_TEST_JITTER,
+        addr_string, &addr);
+    if (rc != EXIT_SUCCESS)
+        return rc;
+
+    /* Messages are delayed by a random amount but not reordered */
+    memset(&cb_info, 0, sizeof(cb_info));
+    for (i = 0; i < NA_TEST_MSG_COUNT; i++)
+        NA_Msg_recv_unexpected(server->na_class, server->context, na_test_cb,
+            &cb_info, &recv_bufs[i], sizeof(recv_bufs[i]), NULL,
+            NA_OP_ID_IGNORE);
+    for (i = 0; i < NA_TEST_MSG_COUNT; i++) {
+        /* Buffers are only copied when the deadline is reached */
+        send_bufs[i] = i;
+        NA_Msg_send_unexpected(client.na_class, client.context, na_test_cb,
+            &cb_info, &send_bufs[i], sizeof(send_bufs[i]), NULL, addr, 0,
+            NA_TEST_TAG, NA_OP_ID_IGNORE);
+    }
+    if (na_test_wait(server, &client, &cb_info.completed,
+        2 * NA_TEST_MSG_COUNT) != NA_SUCCESS)
+        rc = EXIT_FAILURE;
+    for (i = 0; i < NA_TEST_MSG_COUNT && rc == EXIT_SUCCESS; i++) {
+        if (recv_bufs[i] != i) {
+            fprintf(stderr, "Error: expected message %d, received %d\n", i,
+                recv_bufs[i]);
+            rc = EXIT_FAILURE;
+            break;
+        }
+    }
+
+    if (na_test_client_finalize(&client, addr) != EXIT_SUCCESS)
+        rc = EXIT_FAILURE;
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+test_loss(struct na_test_unit *server, const char *addr_string)
+{
+    struct na_test_unit client;
+    struct na_test_unit_cb_info send_cb_info, recv_cb_info;
+    na_mem_handle_t local_handle = NA_MEM_HANDLE_NULL,
+        remote_handle = NA_MEM_HANDLE_NULL;
+    char rma_buf[NA_TEST_RMA_SIZE], buf[16];
+    na_op_id_t op_id;
+    hg_time_t t1, t2;
+    na_addr_t addr;
+    int rc;
+
+    rc = na_test_client_init(&client, NA_TEST_LOSS_ENV, "100", addr_string,
+        &addr);
+    if (rc != EXIT_SUCCESS)
+        return rc;
+
+    /* Lost messages complete on the sender but are never received */
+    memset(&send_cb_info, 0, sizeof(send_cb_info));
+    memset(&recv_cb_info, 0, sizeof(recv_cb_info));
+    op_id = NA_Op_create(server->na_class);
+    NA_Msg_recv_unexpected(server->na_class, server->context, na_test_cb,
+        &recv_cb_info, buf, sizeof(buf), NULL, &op_id);
+    NA_Msg_send_unexpected(client.na_class, client.context, na_test_cb,
+        &send_cb_info, buf, sizeof(buf), NULL, addr, 0, NA_TEST_TAG,
+        NA_OP_ID_IGNORE);
+    hg_time_get_current(&t1);
+    do {
+        na_test_progress(&client);
+        na_test_progress(server);
+        hg_time_get_current(&t2);
+    } while (hg_time_to_double(hg_time_subtract(t2, t1))
+        < NA_TEST_LOSS_WAIT / 1000.0);
+    if (send_cb_info.completed != 1 || send_cb_info.ret != NA_SUCCESS) {
+        fprintf(stderr, "Error: lost message did not complete\n");
+        rc = EXIT_FAILURE;
+    }
+    if (recv_cb_info.completed) {
+        fprintf(stderr, "Error: lost message was received\n");
+        rc = EXIT_FAILURE;
+    }
+    NA_Cancel(server->na_class, server->context, op_id);
+    if (na_test_wait(server, &client, &recv_cb_info.completed, 1)
+        != NA_SUCCESS)
+        rc = EXIT_FAILURE;
+    NA_Op_destroy(server->na_class, op_id);
+    if (rc != EXIT_SUCCESS)
+        goto done;
+
+    /* Lost RMA ops fail */
+    NA_Mem_handle_create(server->na_class, rma_buf, sizeof(rma_buf),
+        NA_MEM_READWRITE, &remote_handle);
+    NA_Mem_register(server->na_class, remote_handle);
+    NA_Mem_handle_create(client.na_class, rma_buf, sizeof(rma_buf),
+        NA_MEM_READWRITE, &local_handle);
+    NA_Mem_register(client.na_class, local_handle);
+    NA_Put(client.na_class, client.context, na_test_cb, &send_cb_info,
+        local_handle, 0, remote_handle, 0, sizeof(rma_buf), addr, 0,
+        NA_OP_ID_IGNORE);
+    if (na_test_wait(server, &client, &send_cb_info.completed, 2)
+        != NA_SUCCESS)
+        rc = EXIT_FAILURE;
+    else if (send_cb_info.ret != NA_TIMEOUT) {
+        fprintf(stderr, "Error: lost put completed with %s\n",
+            NA_Error_to_string(send_cb_info.ret));
+        rc = EXIT_FAILURE;
+    }
+    NA_Mem_deregister(client.na_class, local_handle);
+    NA_Mem_handle_free(client.na_class, local_handle);
+    NA_Mem_deregister(server->na_class, remote_handle);
+    NA_Mem_handle_free(server->na_class, remote_handle);
+
+done:
+    if (na_test_client_finalize(&client, addr) != EXIT_SUCCESS)
+        rc = EXIT_FAILURE;
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+test_cancel_queued(struct na_test_unit *server, const char *addr_string)
+{
+    struct na_test_unit client;
+    struct na_test_unit_cb_info send_cb_info, recv_cb_info;
+    na_op_id_t op_id, recv_op_id;
+    na_addr_t addr;
+    char buf[16];
+    int rc;
+
+    rc = na_test_client_init(&client, NA_TEST_LATENCY_ENV,
+        NA_TEST_LONG_LATENCY, addr_string, &addr);
+    if (rc != EXIT_SUCCESS)
+        return rc;
+
+    /* Op waiting for its deadline completes as canceled without being sent */
+    memset(&send_cb_info, 0, sizeof(send_cb_info));
+    memset(&recv_cb_info, 0, sizeof(recv_cb_info));
+    recv_op_id = NA_Op_create(server->na_class);
+    NA_Msg_recv_unexpected(server->na_class, server->context, na_test_cb,
+        &recv_cb_info, buf, sizeof(buf), NULL, &recv_op_id);
+    op_id = NA_Op_create(client.na_class);
+    NA_Msg_send_unexpected(client.na_class, client.context, na_test_cb,
+        &send_cb_info, buf, sizeof(buf), NULL, addr, 0, NA_TEST_TAG, &op_id);
+    if (NA_Poll_try_wait(client.na_class, client.context)) {
+        fprintf(stderr, "Error: context with queued ops may wait\n");
+        rc = EXIT_FAILURE;
+    }
+    NA_Cancel(client.na_class, client.context, op_id);
+    if (na_test_wait(server, &client, &send_cb_info.completed, 1)
+        != NA_SUCCESS)
+        rc = EXIT_FAILURE;
+    else if (send_cb_info.ret != NA_CANCELED) {
+        fprintf(stderr, "Error: queued send completed with %s\n",
+            NA_Error_to_string(send_cb_info.ret));
+        rc = EXIT_FAILURE;
+    }
+    na_test_progress(server);
+    if (recv_cb_info.completed) {
+        fprintf(stderr, "Error: canceled message was received\n");
+        rc = EXIT_FAILURE;
+    }
+    NA_Cancel(server->na_class, server->context, recv_op_id);
+    if (na_test_wait(server, &client, &recv_cb_info.completed, 1)
+        != NA_SUCCESS)
+        rc = EXIT_FAILURE;
+    NA_Op_destroy(server->na_class, recv_op_id);
+    NA_Op_destroy(client.na_class, op_id);
+
+    /* Nothing is left in the timer list */
+    if (na_test_client_finalize(&client, addr) != EXIT_SUCCESS)
+        rc = EXIT_FAILURE;
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+int
+main(void)
+{
+    struct na_test_unit server;
+    char addr_string[64];
+    na_size_t addr_string_size = sizeof(addr_string);
+    na_addr_t self_addr;
+    int rc;
+
+    server.na_class = NA_Initialize(NA_TEST_SERVER_INFO, NA_TRUE);
+    if (!server.na_class) {
+        fprintf(stderr, "Error: could not initialize NA\n");
+        return EXIT_FAILURE;
+    }
+    na_test_server_class_g = server.na_class;
+    server.context = NA_Context_create(server.na_class);
+    if (!server.context) {
+        fprintf(stderr, "Error: could not create NA context\n");
+        NA_Finalize(server.na_class);
+        return EXIT_FAILURE;
+    }
+    NA_Addr_self(server.na_class, &self_addr);
+    NA_Addr_to_string(server.na_class, addr_string, &addr_string_size,
+        self_addr);
+    NA_Addr_free(server.na_class, self_addr);
+
+    rc = test_latency(&server, addr_string);
+    if (rc == EXIT_SUCCESS)
+        rc = test_jitter(&server, addr_string);
+    if (rc == EXIT_SUCCESS)
+        rc = test_loss(&server, addr_string);
+    if (rc == EXIT_SUCCESS)
+        rc = test_cancel_queued(&server, addr_string);
+
+    if (NA_Context_destroy(server.na_class, server.context) != NA_SUCCESS
+        || NA_Finalize(server.na_class) != NA_SUCCESS) {
+        fprintf(stderr, "Error: could not finalize NA\n");
+        rc = EXIT_FAILURE;
+    }
+
+    return rc;
+}
@@ -0,0 +1,596 @@
+/*
+ * Copyright (C) 2013-2019 Argonne National Laboratory, Department of Energy,
+ *                    UChicago Argonne, LLC and The HDF Group.
+ * All rights reserved.
+ *
+ * The full copyright notice, including terms governing use, modification,
+ * and redistribution, is contained in the COPYING file that can be
+ * found at the root of the source code distribution tree.
+ */
+
+#include "na_test.h"
+
+#include "mercury_atomic.h"
+#include "mercury_thread.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/****************/
+/* Local Macros */
+/****************/
+
+#define NA_TEST_SERVER_INFO     "inproc://"
+#define NA_TEST_CLIENT_INFO     "inproc+inproc://"
+
+/* Messages sent before any receive is posted */
+#define NA_TEST_MSG_COUNT       16
+#define NA_TEST_MSG_SIZE        64
+
+/* Messages sent by a thread while receives are posted and canceled */
+#define NA_TEST_STRESS_COUNT    10000
+
+#define NA_TEST_RMA_SIZE        4096
+
+#define NA_TEST_TAG             42
+
+/************************************/
+/* Local Type and Struct Definition */
+/************************************/
+
+struct na_test_stress {
+    struct na_test_unit *client;
+    na_addr_t addr;
+    hg_atomic_int32_t sent;
+};
+
+/*---------------------------------------------------------------------------*/
+static int
+test_unexpected(struct na_test_unit *server, struct na_test_unit *client,
+    na_addr_t addr)
+{
+    struct na_test_unit_cb_info cb_info;
+    char buf[NA_TEST_MSG_SIZE];
+    na_op_id_t op_id;
+    int i, rc = EXIT_SUCCESS;
+
+    /* Messages are kept until receives are posted */
+    memset(&cb_info, 0, sizeof(cb_info));
+    for (i = 0; i < NA_TEST_MSG_COUNT; i++) {
+        memset(buf, i, sizeof(buf));
+        NA_Msg_send_unexpected(client->na_class, client->context,
+            na_test_unit_cb, &cb_info, buf, sizeof(buf), NULL, addr, 0,
+            NA_TEST_TAG + i, NA_OP_ID_IGNORE);
+    }
+    if (na_test_unit_progress(client, &cb_info.completed, NA_TEST_MSG_COUNT)
+        != NA_SUCCESS) {
+        fprintf(stderr, "Error: could not send messages\n");
+        return EXIT_FAILURE;
+    }
+
+    /* A canceled receive does not consume a message */
+    memset(&cb_info, 0, sizeof(cb_info));
+    op_id = NA_Op_create(server->na_class);
+    NA_Msg_recv_unexpected(server->na_class, server->context, na_test_unit_cb,
+        &cb_info, buf, sizeof(buf), NULL, &op_id);
+    NA_Cancel(server->na_class, server->context, op_id);
+    if (na_test_unit_progress(server, &cb_info.completed, 1) != NA_SUCCESS) {
+        rc = EXIT_FAILURE;
+        i = NA_TEST_MSG_COUNT;
+    } else if (cb_info.ret == NA_SUCCESS) {
+        NA_Addr_free(server->na_class, cb_info.addr);
+        if (buf[0] != 0) {
+            fprintf(stderr, "Error: received message %d first\n", buf[0]);
+            rc = EXIT_FAILURE;
+        }
+        i = 1;
+    } else if (cb_info.ret != NA_CANCELED) {
+        fprintf(stderr, "Error: canceled receive completed with %s\n",
+            NA_Error_to_string(cb_info.ret));
+        rc = EXIT_FAILURE;
+        i = NA_TEST_MSG_COUNT;
+    } else
+        i = 0;
+
+    /* Messages are received in the order they were sent */
+    for (; i < NA_TEST_MSG_COUNT; i++) {
+        memset(&cb_info, 0, sizeof(cb_info));
+        NA_Msg_recv_unexpected(server->na_class, server->context,
+            na_test_unit_cb, &cb_info, buf, sizeof(buf), NULL, &op_id);
+        if (na_test_unit_progress(server, &cb_info.completed, 1) != NA_SUCCESS
+            || cb_info.ret != NA_SUCCESS) {
+            fprintf(stderr, "Error: receive completed with %s\n",
+                NA_Error_to_string(cb_info.ret));
+            rc = EXIT_FAILURE;
+            break;
+        }
+        NA_Addr_free(server->na_class, cb_info.addr);
+        if (buf[0] != i || cb_info.tag != (na_tag_t) (NA_TEST_TAG + i)
+            || cb_info.buf_size != sizeof(buf)) {
+            fprintf(stderr, "Error: expected message %d, received %d\n", i,
+                buf[0]);
+            rc = EXIT_FAILURE;
+            break;
+        }
+    }
+    NA_Op_destroy(server->na_class, op_id);
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+static HG_THREAD_RETURN_TYPE
+stress_send_cb(void *arg)
+{
+    hg_thread_ret_t thread_ret = (hg_thread_ret_t) 0;
+    struct na_test_stress *stress = (struct na_test_stress *) arg;
+    struct na_test_unit *client = stress->client;
+    struct na_test_unit_cb_info cb_info;
+    int i;
+
+    memset(&cb_info, 0, sizeof(cb_info));
+    for (i = 0; i < NA_TEST_STRESS_COUNT; i++) {
+        NA_Msg_send_unexpected(client->na_class, client->context,
+            na_test_unit_cb, &cb_info, &i, sizeof(i), NULL, stress->addr, 0,
+            NA_TEST_TAG, NA_OP_ID_IGNORE);
+        if (na_test_unit_progress(client, &cb_info.completed, i + 1)
+            != NA_SUCCESS) {
+            /* Let the receiver drain and give up */
+            hg_atomic_set32(&stress->sent, NA_TEST_STRESS_COUNT);
+            break;
+        }
+        hg_atomic_incr32(&stress->sent);
+    }
+
+    hg_thread_exit(thread_ret);
+    return thread_ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+test_unexpected_stress(struct na_test_unit *server,
+    struct na_test_unit *client, na_addr_t addr)
+{
+    struct na_test_stress stress;
+    struct na_test_unit_cb_info cb_info[2];
+    na_op_id_t op_ids[2];
+    hg_thread_t thread;
+    int bufs[2], received = 0, rc = EXIT_SUCCESS;
+
+    stress.client = client;
+    stress.addr = addr;
+    hg_atomic_init32(&stress.sent, 0);
+    op_ids[0] = NA_Op_create(server->na_class);
+    op_ids[1] = NA_Op_create(server->na_class);
+    hg_thread_create(&thread, stress_send_cb, &stress);
+
+    /* Receives canceled while messages arrive must not reorder them */
+    while (received < NA_TEST_STRESS_COUNT && rc == EXIT_SUCCESS) {
+        int i;
+
+        memset(cb_info, 0, sizeof(cb_info));
+        for (i = 0; i < 2; i++)
+            NA_Msg_recv_unexpected(server->na_class, server->context,
+                na_test_unit_cb, &cb_info[i], &bufs[i], sizeof(bufs[i]), NULL,
+                &op_ids[i]);
+        NA_Cancel(server->na_class, server->context, op_ids[0]);
+        if (received == NA_TEST_STRESS_COUNT - 1)
+            NA_Cancel(server->na_class, server->context, op_ids[1]);
+        if (na_test_unit_progress(server, &cb_info[0].completed, 1)
+            != NA_SUCCESS
+            || na_test_unit_progress(server, &cb_info[1].completed, 1)
+            != NA_SUCCESS) {
+            rc = EXIT_FAILURE;
+            break;
+        }
+
+        for (i = 0; i < 2; i++) {
+            if (cb_info[i].ret == NA_CANCELED)
+                continue;
+            if (cb_info[i].ret != NA_SUCCESS) {
+                fprintf(stderr, "Error: receive completed with %s\n",
+                    NA_Error_to_string(cb_info[i].ret));
+                rc = EXIT_FAILURE;
+                break;
+            }
+            NA_Addr_free(server->na_class, cb_info[i].addr);
+            if (bufs[i] != received) {
+                fprintf(stderr, "Error: expected message %d, received %d\n",
+                    received, bufs[i]);
+                rc = EXIT_FAILURE;
+                break;
+            }
+            received++;
+        }
+    }
+
+    /* Drain what is left so that the sender can exit */
+    while (received < NA_TEST_STRESS_COUNT) {
+        memset(cb_info, 0, sizeof(cb_info));
+        NA_Msg_recv_unexpected(server->na_class, server->context,
+            na_test_unit_cb, &cb_info[0], &bufs[0], sizeof(bufs[0]), NULL,
+            &op_ids[0]);
+        while (!cb_info[0].completed
+            && hg_atomic_get32(&stress.sent) < NA_TEST_STRESS_COUNT) {
+            NA_Progress(server->na_class, server->context, 0);
+            na_test_unit_trigger(server);
+        }
+        if (!cb_info[0].completed) {
+            NA_Cancel(server->na_class, server->context, op_ids[0]);
+            received = NA_TEST_STRESS_COUNT;
+        }
+        if (na_test_unit_progress(server, &cb_info[0].completed, 1)
+            != NA_SUCCESS) {
+            rc = EXIT_FAILURE;
+            break;
+        }
+        if (cb_info[0].ret == NA_SUCCESS)
+            NA_Addr_free(server->na_class, cb_info[0].addr);
+        received++;
+    }
+    hg_thread_join(thread);
+    NA_Op_destroy(server->na_class, op_ids[0]);
+    NA_Op_destroy(server->na_class, op_ids[1]);
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+test_expected_order(struct na_test_unit *server, struct na_test_unit *client,
+    na_addr_t addr, na_addr_t source_addr, na_bool_t posted)
+{
+    struct na_test_unit_cb_info send_info, recv_info;
+    char send_bufs[NA_TEST_MSG_COUNT], recv_bufs[NA_TEST_MSG_COUNT];
+    int i;
+
+    memset(&send_info, 0, sizeof(send_info));
+    memset(&recv_info, 0, sizeof(recv_info));
+    memset(recv_bufs, 0, sizeof(recv_bufs));
+    for (i = 0; i < NA_TEST_MSG_COUNT && posted; i++)
+        NA_Msg_recv_expected(client->na_class, client->context,
+            na_test_unit_cb, &recv_info, &recv_bufs[i], sizeof(recv_bufs[i]),
+            NULL, addr, 0, NA_TEST_TAG, NA_OP_ID_IGNORE);
+    for (i = 0; i < NA_TEST_MSG_COUNT; i++) {
+        send_bufs[i] = (char) i;
+        NA_Msg_send_expected(server->na_class, server->context,
+            na_test_unit_cb, &send_info, &send_bufs[i], sizeof(send_bufs[i]),
+            NULL, source_addr, 0, NA_TEST_TAG, NA_OP_ID_IGNORE);
+    }
+    if (na_test_unit_progress(server, &send_info.completed, NA_TEST_MSG_COUNT)
+        != NA_SUCCESS)
+        return EXIT_FAILURE;
+    for (i = 0; i < NA_TEST_MSG_COUNT && !posted; i++)
+        NA_Msg_recv_expected(client->na_class, client->context,
+            na_test_unit_cb, &recv_info, &recv_bufs[i], sizeof(recv_bufs[i]),
+            NULL, addr, 0, NA_TEST_TAG, NA_OP_ID_IGNORE);
+    if (na_test_unit_progress(client, &recv_info.completed, NA_TEST_MSG_COUNT)
+        != NA_SUCCESS)
+        return EXIT_FAILURE;
+
+    /* Messages with the same (addr, tag) are matched in order */
+    for (i = 0; i < NA_TEST_MSG_COUNT; i++) {
+        if (recv_bufs[i] != (char) i) {
+            fprintf(stderr, "Error: receive %d got expected message %d\n", i,
+                (int) recv_bufs[i]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+test_expected(struct na_test_unit *server, struct na_test_unit *client,
+    na_addr_t addr)
+{
+    struct na_test_unit_cb_info cb_info;
+    char send_buf[NA_TEST_MSG_SIZE], recv_buf[NA_TEST_MSG_SIZE];
+    na_addr_t source_addr;
+    int i, rc = EXIT_SUCCESS;
+
+    /* Get client address from an unexpected message */
+    memset(&cb_info, 0, sizeof(cb_info));
+    NA_Msg_recv_unexpected(server->na_class, server->context, na_test_unit_cb,
+        &cb_info, recv_buf, sizeof(recv_buf), NULL, NA_OP_ID_IGNORE);
+    NA_Msg_send_unexpected(client->na_class, client->context, na_test_unit_cb,
+        &cb_info, send_buf, sizeof(send_buf), NULL, addr, 0, NA_TEST_TAG,
+        NA_OP_ID_IGNORE);
+    if (na_test_unit_progress(client, &cb_info.completed, 1) != NA_SUCCESS
+        || na_test_unit_progress(server, &cb_info.completed, 2) != NA_SUCCESS
+        || cb_info.ret != NA_SUCCESS) {
+        fprintf(stderr, "Error: could not get client address\n");
+        return EXIT_FAILURE;
+    }
+    source_addr = cb_info.addr;
+
+    /* Receive posted before the send, then send before the receive */
+    for (i = 0; i < 2 && rc == EXIT_SUCCESS; i++) {
+        memset(&cb_info, 0, sizeof(cb_info));
+        memset(send_buf, i + 1, sizeof(send_buf));
+        memset(recv_buf, 0, sizeof(recv_buf));
+        if (i == 0)
+            NA_Msg_recv_expected(client->na_class, client->context,
+                na_test_unit_cb, &cb_info, recv_buf, sizeof(recv_buf), NULL,
+                addr, 0, NA_TEST_TAG, NA_OP_ID_IGNORE);
+        NA_Msg_send_expected(server->na_class, server->context, na_test_unit_cb,
+            &cb_info, send_buf, sizeof(send_buf), NULL, source_addr, 0,
+            NA_TEST_TAG, NA_OP_ID_IGNORE);
+        if (na_test_unit_progress(server, &cb_info.completed, 1)
+            != NA_SUCCESS) {
+            rc = EXIT_FAILURE;
+            break;
+        }
+        if (i == 1)
+            NA_Msg_recv_expected(client->na_class, client->context,
+                na_test_unit_cb, &cb_info, recv_buf, sizeof(recv_buf), NULL,
+                addr, 0, NA_TEST_TAG, NA_OP_ID_IGNORE);
+        if (na_test_unit_progress(client, &cb_info.completed, 2)
+            != NA_SUCCESS || cb_info.ret != NA_SUCCESS
+            || memcmp(send_buf, recv_buf, sizeof(send_buf)) != 0) {
+            fprintf(stderr, "Error: expected message %d not received\n", i);
+            rc = EXIT_FAILURE;
+        }
+    }
+    if (rc == EXIT_SUCCESS)
+        rc = test_expected_order(server, client, addr, source_addr, NA_TRUE);
+    if (rc == EXIT_SUCCESS)
+        rc = test_expected_order(server, client, addr, source_addr, NA_FALSE);
+    NA_Addr_free(server->na_class, source_addr);
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+test_rma(struct na_test_unit *server, struct na_test_unit *client,
+    na_addr_t addr)
+{
+    struct na_test_unit_cb_info cb_info;
+    char *server_buf, *client_buf;
+    na_mem_handle_t server_handle = NA_MEM_HANDLE_NULL,
+        remote_handle = NA_MEM_HANDLE_NULL, client_handle = NA_MEM_HANDLE_NULL;
+    char handle_buf[256];
+    na_size_t handle_size;
+    int i, rc = EXIT_SUCCESS;
+
+    server_buf = (char *) malloc(NA_TEST_RMA_SIZE);
+    client_buf = (char *) malloc(NA_TEST_RMA_SIZE);
+    memset(server_buf, 0, NA_TEST_RMA_SIZE);
+    for (i = 0; i < NA_TEST_RMA_SIZE; i++)
+        client_buf[i] = (char) i;
+
+    /* Exchange server memory handle */
+    NA_Mem_handle_create(server->na_class, server_buf, NA_TEST_RMA_SIZE,
+        NA_MEM_READWRITE, &server_handle);
+    NA_Mem_register(server->na_class, server_handle);
+    handle_size = NA_Mem_handle_get_serialize_size(server->na_class,
+        server_handle);
+    if (handle_size > sizeof(handle_buf)
+        || NA_Mem_handle_serialize(server->na_class, handle_buf, handle_size,
+            server_handle) != NA_SUCCESS
+        || NA_Mem_handle_deserialize(client->na_class, &remote_handle,
+            handle_buf, handle_size) != NA_SUCCESS) {
+        fprintf(stderr, "Error: could not exchange memory handle\n");
+        rc = EXIT_FAILURE;
+        goto done;
+    }
+    NA_Mem_handle_create(client->na_class, client_buf, NA_TEST_RMA_SIZE,
+        NA_MEM_READWRITE, &client_handle);
+    NA_Mem_register(client->na_class, client_handle);
+
+    /* Put to the second half, then get it back into the first half */
+    memset(&cb_info, 0, sizeof(cb_info));
+    NA_Put(client->na_class, client->context, na_test_unit_cb, &cb_info,
+        client_handle, 0, remote_handle, NA_TEST_RMA_SIZE / 2,
+        NA_TEST_RMA_SIZE / 2, addr, 0, NA_OP_ID_IGNORE);
+    if (na_test_unit_progress(client, &cb_info.completed, 1) != NA_SUCCESS
+        || cb_info.ret != NA_SUCCESS
+        || memcmp(server_buf + NA_TEST_RMA_SIZE / 2, client_buf,
+            NA_TEST_RMA_SIZE / 2) != 0) {
+        fprintf(stderr, "Error: put data does not match\n");
+        rc = EXIT_FAILURE;
+        goto done;
+    }
+
+    memset(client_buf, 0, NA_TEST_RMA_SIZE / 2);
+    NA_Get(client->na_class, client->context, na_test_unit_cb, &cb_info,
+        client_handle, 0, remote_handle, NA_TEST_RMA_SIZE / 2,
+        NA_TEST_RMA_SIZE / 2, addr, 0, NA_OP_ID_IGNORE);
+    if (na_test_unit_progress(client, &cb_info.completed, 2) != NA_SUCCESS
+        || cb_info.ret != NA_SUCCESS) {
+        fprintf(stderr, "Error: get failed\n");
+        rc = EXIT_FAILURE;
+        goto done;
+    }
+    for (i = 0; i < NA_TEST_RMA_SIZE / 2; i++) {
+        if (client_buf[i] != (char) i) {
+            fprintf(stderr, "Error: get data does not match at %d\n", i);
+            rc = EXIT_FAILURE;
+            break;
+        }
+    }
+
+done:
+    if (client_handle != NA_MEM_HANDLE_NULL) {
+        NA_Mem_deregister(client->na_class, client_handle);
+        NA_Mem_handle_free(client->na_class, client_handle);
+    }
+    if (remote_handle != NA_MEM_HANDLE_NULL)
+        NA_Mem_handle_free(client->na_class, remote_handle);
+    if (server_handle != NA_MEM_HANDLE_NULL) {
+        NA_Mem_deregister(server->na_class, server_handle);
+        NA_Mem_handle_free(server->na_class, server_handle);
+    }
+    free(server_buf);
+    free(client_buf);
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+test_cancel(struct na_test_unit *server, na_addr_t addr)
+{
+    struct na_test_unit_cb_info cb_info;
+    char buf[NA_TEST_MSG_SIZE];
+    na_op_id_t op_id;
+    int rc = EXIT_SUCCESS;
+
+    /* Posted receives complete with NA_CANCELED */
+    memset(&cb_info, 0, sizeof(cb_info));
+    op_id = NA_Op_create(server->na_class);
+    NA_Msg_recv_unexpected(server->na_class, server->context, na_test_unit_cb,
+        &cb_info, buf, sizeof(buf), NULL, &op_id);
+    NA_Cancel(server->na_class, server->context, op_id);
+    if (na_test_unit_progress(server, &cb_info.completed, 1) != NA_SUCCESS
+        || cb_info.ret != NA_CANCELED) {
+        fprintf(stderr, "Error: unexpected receive completed with %s\n",
+            NA_Error_to_string(cb_info.ret));
+        rc = EXIT_FAILURE;
+    }
+
+    NA_Msg_recv_expected(server->na_class, server->context, na_test_unit_cb,
+        &cb_info, buf, sizeof(buf), NULL, addr, 0, NA_TEST_TAG, &op_id);
+    NA_Cancel(server->na_class, server->context, op_id);
+    if (na_test_unit_progress(server, &cb_info.completed, 2) != NA_SUCCESS
+        || cb_info.ret != NA_CANCELED) {
+        fprintf(stderr, "Error: expected receive completed with %s\n",
+            NA_Error_to_string(cb_info.ret));
+        rc = EXIT_FAILURE;
+    }
+    NA_Op_destroy(server->na_class, op_id);
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+test_multi_context(struct na_test_unit *server, struct na_test_unit *client,
+    na_addr_t addr)
+{
+    struct na_test_unit server1 = { server->na_class, NULL };
+    struct na_test_unit_cb_info cb_info[2];
+    na_uint8_t ids[2];
+    int i, rc = EXIT_SUCCESS;
+
+    server1.context = NA_Context_create_id(server->na_class, 1);
+    if (!server1.context) {
+        fprintf(stderr, "Error: could not create context with ID 1\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Each message is delivered to the context it targets */
+    memset(cb_info, 0, sizeof(cb_info));
+    NA_Msg_recv_unexpected(server->na_class, server->context, na_test_unit_cb,
+        &cb_info[0], &ids[0], sizeof(ids[0]), NULL, NA_OP_ID_IGNORE);
+    NA_Msg_recv_unexpected(server1.na_class, server1.context, na_test_unit_cb,
+        &cb_info[1], &ids[1], sizeof(ids[1]), NULL, NA_OP_ID_IGNORE);
+    for (i = 1; i >= 0 && rc == EXIT_SUCCESS; i--) {
+        na_uint8_t id = (na_uint8_t) i;
+        struct na_test_unit_cb_info send_cb_info;
+
+        memset(&send_cb_info, 0, sizeof(send_cb_info));
+        NA_Msg_send_unexpected(client->na_class, client->context,
+            na_test_unit_cb, &send_cb_info, &id, sizeof(id), NULL, addr, id,
+            NA_TEST_TAG, NA_OP_ID_IGNORE);
+        if (na_test_unit_progress(client, &send_cb_info.completed, 1)
+            != NA_SUCCESS)
+            rc = EXIT_FAILURE;
+    }
+    if (rc != EXIT_SUCCESS
+        || na_test_unit_progress(server, &cb_info[0].completed, 1)
+        != NA_SUCCESS
+        || na_test_unit_progress(&server1, &cb_info[1].completed, 1)
+        != NA_SUCCESS)
+        rc = EXIT_FAILURE;
+    for (i = 0; i < 2; i++) {
+        if (cb_info[i].ret != NA_SUCCESS || ids[i] != i) {
+            fprintf(stderr, "Error: context %d did not receive its message\n",
+                i);
+            rc = EXIT_FAILURE;
+        }
+        if (cb_info[i].ret == NA_SUCCESS)
+            NA_Addr_free(server->na_class, cb_info[i].addr);
+    }
+
+    if (NA_Context_destroy(server1.na_class, server1.context) != NA_SUCCESS) {
+        fprintf(stderr, "Error: could not destroy context with ID 1\n");
+        rc = EXIT_FAILURE;
+    }
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+int
+main(void)
+{
+    struct na_test_unit server, client;
+    struct na_test_unit_cb_info cb_info;
+    char addr_string[64];
+    na_size_t addr_string_size = sizeof(addr_string);
+    na_addr_t self_addr, addr = NA_ADDR_NULL;
+    int rc = EXIT_FAILURE;
+
+    server.na_class = NA_Initialize(NA_TEST_SERVER_INFO, NA_TRUE);
+    client.na_class = NA_Initialize(NA_TEST_CLIENT_INFO, NA_FALSE);
+    if (!server.na_class || !client.na_class) {
+        fprintf(stderr, "Error: could not initialize NA\n");
+        goto done;
+    }
+    server.context = NA_Context_create(server.na_class);
+    client.context = NA_Context_create(client.na_class);
+    if (!server.context || !client.context) {
+        fprintf(stderr, "Error: could not create NA contexts\n");
+        goto done;
+    }
+
+    NA_Addr_self(server.na_class, &self_addr);
+    NA_Addr_to_string(server.na_class, addr_string, &addr_string_size,
+        self_addr);
+    NA_Addr_free(server.na_class, self_addr);
+    memset(&cb_info, 0, sizeof(cb_info));
+    NA_Addr_lookup(client.na_class, client.context, na_test_unit_cb, &cb_info,
+        addr_string, NA_OP_ID_IGNORE);
+    if (na_test_unit_progress(&client, &cb_info.completed, 1) != NA_SUCCESS
+        || cb_info.ret != NA_SUCCESS) {
+        fprintf(stderr, "Error: could not look up server address\n");
+        goto done;
+    }
+    addr = cb_info.addr;
+
+    rc = test_unexpected(&server, &client, addr);
+    if (rc == EXIT_SUCCESS)
+        rc = test_unexpected_stress(&server, &client, addr);
+    if (rc == EXIT_SUCCESS)
+        rc = test_expected(&server, &client, addr);
+    if (rc == EXIT_SUCCESS)
+        rc = test_rma(&server, &client, addr);
+    if (rc == EXIT_SUCCESS)
+        rc = test_cancel(&server, addr);
+    if (rc == EXIT_SUCCESS)
+        rc = test_multi_context(&server, &client, addr);
+
+done:
+    if (addr)
+        NA_Addr_free(client.na_class, addr);
+    if (client.context
+        && NA_Context_destroy(client.na_class, client.context) != NA_SUCCESS) {
+        fprintf(stderr, "Error: could not destroy client context\n");
+        rc = EXIT_FAILURE;
+    }
+    if (server.context
+        && NA_Context_destroy(server.na_class, server.context) != NA_SUCCESS) {
+        fprintf(stderr, "Error: could not destroy server context\n");
+        rc = EXIT_FAILURE;
+    }
+    if (client.na_class)
+        NA_Finalize(client.na_class);
+    if (server.na_class)
+        NA_Finalize(server.na_class);
+
+    return rc;
+}
@@ -0,0 +1,226 @@
+/*
+ * Copyright (C) 2013-2019 Argonne National Laboratory, Department of Energy,
+ *                    UChicago Argonne, LLC and The HDF Group.
+ * All rights reserved.
+ *
+ * The full copyright notice, including terms governing use, modification,
+ * and redistribution, is contained in the COPYING file that can be
+ * found at the root of the source code distribution tree.
+ */
+
+#include "na.h"
+
+#include "mercury_thread.h"
+#include "mercury_thread_condition.h"
+#include "mercury_thread_mutex.h"
+#include "mercury_time.h"
+
+#include "mercury_test_config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/****************/
+/* Local Macros */
+/****************/
+
+/* Op IDs reset by a thread, more than fit in its own cache */
+#define NA_TEST_OP_COUNT        64
+
+#define NA_TEST_BENCH_ITER      1000000
+
+/* Threads exiting while their class is finalized */
+#define NA_TEST_RACE_THREADS    4
+#define NA_TEST_RACE_ITER       50
+
+/************************************/
+/* Local Type and Struct Definition */
+/************************************/
+
+struct na_test_op_thread {
+    na_class_t *na_class;
+    na_op_id_t op_ids[NA_TEST_OP_COUNT];
+    hg_thread_mutex_t mutex;
+    hg_thread_cond_t cond;
+    int done;           /* Op IDs have been destroyed */
+    int exit;           /* Thread may exit */
+};
+
+/*---------------------------------------------------------------------------*/
+static HG_THREAD_RETURN_TYPE
+op_thread_cb(void *arg)
+{
+    hg_thread_ret_t thread_ret = (hg_thread_ret_t) 0;
+    struct na_test_op_thread *op_thread = (struct na_test_op_thread *) arg;
+    int i;
+
+    for (i = 0; i < NA_TEST_OP_COUNT; i++)
+        op_thread->op_ids[i] = NA_Op_create(op_thread->na_class);
+    for (i = 0; i < NA_TEST_OP_COUNT; i++)
+        NA_Op_destroy(op_thread->na_class, op_thread->op_ids[i]);
+
+    /* Keep cache alive until told to exit */
+    hg_thread_mutex_lock(&op_thread->mutex);
+    op_thread->done = 1;
+    hg_thread_cond_signal(&op_thread->cond);
+    while (!op_thread->exit)
+        hg_thread_cond_wait(&op_thread->cond, &op_thread->mutex);
+    hg_thread_mutex_unlock(&op_thread->mutex);
+
+    hg_thread_exit(thread_ret);
+    return thread_ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+op_thread_start(struct na_test_op_thread *op_thread, na_class_t *na_class,
+    hg_thread_t *thread)
+{
+    op_thread->na_class = na_class;
+    op_thread->done = 0;
+    op_thread->exit = 0;
+    hg_thread_mutex_init(&op_thread->mutex);
+    hg_thread_cond_init(&op_thread->cond);
+    hg_thread_create(thread, op_thread_cb, op_thread);
+
+    hg_thread_mutex_lock(&op_thread->mutex);
+    while (!op_thread->done)
+        hg_thread_cond_wait(&op_thread->cond, &op_thread->mutex);
+    hg_thread_mutex_unlock(&op_thread->mutex);
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+op_thread_stop(struct na_test_op_thread *op_thread, hg_thread_t thread)
+{
+    hg_thread_mutex_lock(&op_thread->mutex);
+    op_thread->exit = 1;
+    hg_thread_cond_signal(&op_thread->cond);
+    hg_thread_mutex_unlock(&op_thread->mutex);
+    hg_thread_join(thread);
+
+    hg_thread_cond_destroy(&op_thread->cond);
+    hg_thread_mutex_destroy(&op_thread->mutex);
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+test_op_reuse(na_class_t *na_class)
+{
+    struct na_test_op_thread op_thread;
+    hg_thread_t thread;
+    na_op_id_t op_id, op_id2;
+    int i, found = 0;
+
+    /* Op ID destroyed by the calling thread is returned again */
+    op_id = NA_Op_create(na_class);
+    if (op_id == NA_OP_ID_NULL) {
+        fprintf(stderr, "Error: could not create op ID\n");
+        return EXIT_FAILURE;
+    }
+    NA_Op_destroy(na_class, op_id);
+    op_id2 = NA_Op_create(na_class);
+    if (op_id2 != op_id) {
+        fprintf(stderr, "Error: op ID was not reused\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Op IDs cached by an exiting thread are handed to other threads */
+    op_thread_start(&op_thread, na_class, &thread);
+    op_thread_stop(&op_thread, thread);
+    op_id = NA_Op_create(na_class);
+    for (i = 0; i < NA_TEST_OP_COUNT; i++)
+        if (op_thread.op_ids[i] == op_id)
+            found = 1;
+    NA_Op_destroy(na_class, op_id);
+    NA_Op_destroy(na_class, op_id2);
+    if (!found) {
+        fprintf(stderr, "Error: op IDs of exited thread were not reused\n");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+test_op_finalize_race(void)
+{
+    struct na_test_op_thread op_threads[NA_TEST_RACE_THREADS];
+    hg_thread_t threads[NA_TEST_RACE_THREADS];
+    na_class_t *na_class;
+    int i, j;
+
+    /* Thread destructors releasing caches concurrently with NA_Finalize() */
+    for (i = 0; i < NA_TEST_RACE_ITER; i++) {
+        na_class = NA_Initialize("na+sm", NA_FALSE);
+        if (!na_class) {
+            fprintf(stderr, "Error: could not initialize NA\n");
+            return EXIT_FAILURE;
+        }
+        for (j = 0; j < NA_TEST_RACE_THREADS; j++)
+            op_thread_start(&op_threads[j], na_class, &threads[j]);
+        for (j = 0; j < NA_TEST_RACE_THREADS; j++) {
+            hg_thread_mutex_lock(&op_threads[j].mutex);
+            op_threads[j].exit = 1;
+            hg_thread_cond_signal(&op_threads[j].cond);
+            hg_thread_mutex_unlock(&op_threads[j].mutex);
+        }
+        NA_Finalize(na_class);
+        for (j = 0; j < NA_TEST_RACE_THREADS; j++)
+            op_thread_stop(&op_threads[j], threads[j]);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+test_op_bench(na_class_t *na_class)
+{
+    hg_time_ticks_t start;
+    int i;
+
+    start = hg_time_get_ticks();
+    for (i = 0; i < NA_TEST_BENCH_ITER; i++)
+        NA_Op_destroy(na_class, NA_Op_create(na_class));
+    printf("NA_Op_create/NA_Op_destroy: %.2f ns\n", (double)
+        hg_time_ticks_to_ns(hg_time_get_ticks() - start) / NA_TEST_BENCH_ITER);
+}
+
+/*---------------------------------------------------------------------------*/
+int
+main(void)
+{
+    struct na_test_op_thread op_thread;
+    hg_thread_t thread;
+    na_class_t *na_class;
+    int ret;
+
+    na_class = NA_Initialize("na+sm", NA_FALSE);
+    if (!na_class) {
+        fprintf(stderr, "Error: could not initialize NA\n");
+        return EXIT_FAILURE;
+    }
+
+    ret = test_op_reuse(na_class);
+    if (ret != EXIT_SUCCESS)
+        goto done;
+
+    test_op_bench(na_class);
+
+    ret = test_op_finalize_race();
+    if (ret != EXIT_SUCCESS)
+        goto done;
+
+    /* Caches of threads still running are released by NA_Finalize() */
+    op_thread_start(&op_thread, na_class, &thread);
+    NA_Finalize(na_class);
+    na_class = NULL;
+    op_thread_stop(&op_thread, thread);
+
+done:
+    if (na_class)
+        NA_Finalize(na_class);
+    return ret;
+}
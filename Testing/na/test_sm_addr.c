@@ -0,0 +1,244 @@
+/*
+ * Copyright (C) 2013-2019 Argonne National Laboratory, Department of Energy,
+ *                    UChicago Argonne, LLC and The HDF Group.
+ * All rights reserved.
+ *
+ * The full copyright notice, including terms governing use, modification,
+ * and redistribution, is contained in the COPYING file that can be
+ * found at the root of the source code distribution tree.
+ */
+
+#include "na_test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/****************/
+/* Local Macros */
+/****************/
+
+#define NA_TEST_INFO            "na+sm"
+
+/* Max size of serialized addr and addr string sent to the client */
+#define NA_TEST_ADDR_MAX        256
+
+#define NA_TEST_MSG_SIZE        64
+#define NA_TEST_TAG             42
+
+/************************************/
+/* Local Type and Struct Definition */
+/************************************/
+
+/* Server addr handed to the client over a pipe */
+struct na_test_addr {
+    char buf[NA_TEST_ADDR_MAX];
+    na_size_t buf_size;
+    char string[NA_TEST_ADDR_MAX];
+};
+
+/*---------------------------------------------------------------------------*/
+static int
+test_client(int fd)
+{
+    struct na_test_unit client;
+    struct na_test_unit_cb_info cb_info;
+    struct na_test_addr test_addr;
+    char send_buf[NA_TEST_MSG_SIZE], recv_buf[NA_TEST_MSG_SIZE];
+    na_addr_t addr = NA_ADDR_NULL, addr2 = NA_ADDR_NULL;
+    int rc = EXIT_FAILURE;
+
+    if (read(fd, &test_addr, sizeof(test_addr)) != sizeof(test_addr)) {
+        fprintf(stderr, "Error: could not read server address\n");
+        return EXIT_FAILURE;
+    }
+
+    client.na_class = NA_Initialize(NA_TEST_INFO, NA_FALSE);
+    if (!client.na_class) {
+        fprintf(stderr, "Error: could not initialize client\n");
+        return EXIT_FAILURE;
+    }
+    client.context = NA_Context_create(client.na_class);
+    if (!client.context) {
+        fprintf(stderr, "Error: could not create client context\n");
+        goto done;
+    }
+
+    /* Address serialized by another process can be used to send */
+    if (NA_Addr_deserialize(client.na_class, &addr, test_addr.buf,
+        test_addr.buf_size) != NA_SUCCESS) {
+        fprintf(stderr, "Error: could not deserialize server address\n");
+        goto done;
+    }
+
+    /* Looking up the same peer again reuses the connection */
+    if (NA_Addr_lookup2(client.na_class, test_addr.string, &addr2)
+        != NA_SUCCESS) {
+        fprintf(stderr, "Error: could not look up server address\n");
+        goto done;
+    }
+    if (addr2 != addr) {
+        fprintf(stderr, "Error: second lookup did not reuse connection\n");
+        goto done;
+    }
+
+    /* Free one reference, the connection must remain usable */
+    NA_Addr_free(client.na_class, addr2);
+    addr2 = NA_ADDR_NULL;
+
+    memset(&cb_info, 0, sizeof(cb_info));
+    NA_Msg_recv_expected(client.na_class, client.context, na_test_unit_cb,
+        &cb_info, recv_buf, sizeof(recv_buf), NULL, addr, 0, NA_TEST_TAG,
+        NA_OP_ID_IGNORE);
+    memset(send_buf, 1, sizeof(send_buf));
+    NA_Msg_send_unexpected(client.na_class, client.context, na_test_unit_cb,
+        &cb_info, send_buf, sizeof(send_buf), NULL, addr, 0, NA_TEST_TAG,
+        NA_OP_ID_IGNORE);
+
+    /* Second message through a deserialized address, then wait for reply */
+    if (NA_Addr_deserialize(client.na_class, &addr2, test_addr.buf,
+        test_addr.buf_size) != NA_SUCCESS || addr2 != addr) {
+        fprintf(stderr, "Error: second deserialize did not reuse connection\n");
+        goto done;
+    }
+    NA_Msg_send_unexpected(client.na_class, client.context, na_test_unit_cb,
+        &cb_info, send_buf, sizeof(send_buf), NULL, addr2, 0, NA_TEST_TAG,
+        NA_OP_ID_IGNORE);
+    if (na_test_unit_progress(&client, &cb_info.completed, 3) != NA_SUCCESS
+        || recv_buf[0] != 2) {
+        fprintf(stderr, "Error: did not receive reply from server\n");
+        goto done;
+    }
+
+    rc = EXIT_SUCCESS;
+
+done:
+    if (addr2)
+        NA_Addr_free(client.na_class, addr2);
+    if (addr)
+        NA_Addr_free(client.na_class, addr);
+    if (client.context)
+        NA_Context_destroy(client.na_class, client.context);
+    NA_Finalize(client.na_class);
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+test_server(int fd)
+{
+    struct na_test_unit server;
+    struct na_test_unit_cb_info cb_info[2];
+    struct na_test_addr test_addr;
+    char bufs[2][NA_TEST_MSG_SIZE];
+    na_size_t string_size = sizeof(test_addr.string);
+    na_addr_t self_addr;
+    int i, rc = EXIT_FAILURE;
+
+    server.na_class = NA_Initialize(NA_TEST_INFO, NA_TRUE);
+    if (!server.na_class) {
+        fprintf(stderr, "Error: could not initialize server\n");
+        return EXIT_FAILURE;
+    }
+    server.context = NA_Context_create(server.na_class);
+    if (!server.context) {
+        fprintf(stderr, "Error: could not create server context\n");
+        goto done;
+    }
+
+    /* Hand serialized self address to the client */
+    memset(&test_addr, 0, sizeof(test_addr));
+    NA_Addr_self(server.na_class, &self_addr);
+    test_addr.buf_size = NA_Addr_get_serialize_size(server.na_class,
+        self_addr);
+    if (test_addr.buf_size > sizeof(test_addr.buf)
+        || NA_Addr_serialize(server.na_class, test_addr.buf,
+            test_addr.buf_size, self_addr) != NA_SUCCESS
+        || NA_Addr_to_string(server.na_class, test_addr.string, &string_size,
+            self_addr) != NA_SUCCESS) {
+        fprintf(stderr, "Error: could not serialize server address\n");
+        NA_Addr_free(server.na_class, self_addr);
+        goto done;
+    }
+    NA_Addr_free(server.na_class, self_addr);
+
+    memset(cb_info, 0, sizeof(cb_info));
+    for (i = 0; i < 2; i++)
+        NA_Msg_recv_unexpected(server.na_class, server.context, na_test_unit_cb,
+            &cb_info[i], bufs[i], sizeof(bufs[i]), NULL, NA_OP_ID_IGNORE);
+    if (write(fd, &test_addr, sizeof(test_addr)) != sizeof(test_addr)) {
+        fprintf(stderr, "Error: could not write server address\n");
+        goto done;
+    }
+    if (na_test_unit_progress(&server, &cb_info[0].completed, 1) != NA_SUCCESS
+        || na_test_unit_progress(&server, &cb_info[1].completed, 1)
+            != NA_SUCCESS
+        || cb_info[0].ret != NA_SUCCESS || cb_info[1].ret != NA_SUCCESS) {
+        fprintf(stderr, "Error: did not receive client messages\n");
+        goto done;
+    }
+
+    /* Both messages came through the same connection */
+    if (cb_info[0].addr != cb_info[1].addr) {
+        fprintf(stderr, "Error: client messages used different connections\n");
+        rc = EXIT_FAILURE;
+    } else {
+        memset(bufs[0], 2, sizeof(bufs[0]));
+        NA_Msg_send_expected(server.na_class, server.context, na_test_unit_cb,
+            &cb_info[0], bufs[0], sizeof(bufs[0]), NULL, cb_info[0].addr, 0,
+            NA_TEST_TAG, NA_OP_ID_IGNORE);
+        if (na_test_unit_progress(&server, &cb_info[0].completed, 2)
+            == NA_SUCCESS && cb_info[0].ret == NA_SUCCESS)
+            rc = EXIT_SUCCESS;
+    }
+    NA_Addr_free(server.na_class, cb_info[0].addr);
+    NA_Addr_free(server.na_class, cb_info[1].addr);
+
+done:
+    if (server.context)
+        NA_Context_destroy(server.na_class, server.context);
+    NA_Finalize(server.na_class);
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+int
+main(void)
+{
+    int fds[2], status, rc;
+    pid_t pid;
+
+    if (pipe(fds) != 0) {
+        fprintf(stderr, "Error: could not create pipe\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Fork before initializing NA so that nothing is shared */
+    pid = fork();
+    if (pid < 0) {
+        fprintf(stderr, "Error: could not fork\n");
+        return EXIT_FAILURE;
+    }
+    if (pid == 0) {
+        close(fds[1]);
+        rc = test_client(fds[0]);
+        close(fds[0]);
+        _exit(rc);
+    }
+
+    close(fds[0]);
+    rc = test_server(fds[1]);
+    close(fds[1]);
+    if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status)
+        || WEXITSTATUS(status) != EXIT_SUCCESS) {
+        fprintf(stderr, "Error: client failed\n");
+        rc = EXIT_FAILURE;
+    }
+
+    return rc;
+}
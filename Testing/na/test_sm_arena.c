@@ -0,0 +1,369 @@
+/*
+ * Copyright (C) 2013-2019 Argonne National Laboratory, Department of Energy,
+ *                    UChicago Argonne, LLC and The HDF Group.
+ * All rights reserved.
+ *
+ * The full copyright notice, including terms governing use, modification,
+ * and redistribution, is contained in the COPYING file that can be
+ * found at the root of the source code distribution tree.
+ */
+
+#include "na_test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/****************/
+/* Local Macros */
+/****************/
+
+#define NA_TEST_INFO            "na+sm"
+
+#define NA_TEST_ADDR_MAX        256
+#define NA_TEST_HANDLE_MAX      4096
+
+#define NA_TEST_BUF_SIZE        (1 << 20)
+
+/* Upper bound on allocations needed to exhaust the arena */
+#define NA_TEST_ALLOC_MAX       4096
+
+#define NA_TEST_GET_VALUE(i)    ((unsigned char) ((i) * 7))
+#define NA_TEST_PUT_VALUE(i)    ((unsigned char) ((i) * 3 + 1))
+
+/************************************/
+/* Local Type and Struct Definition */
+/************************************/
+
+/* Server addr and memory handle handed to the client over a pipe */
+struct na_test_handle {
+    char addr_string[NA_TEST_ADDR_MAX];
+    char buf[NA_TEST_HANDLE_MAX];
+    na_size_t buf_size;
+};
+
+/*---------------------------------------------------------------------------*/
+static int
+na_test_is_zero(const unsigned char *buf, size_t buf_size)
+{
+    size_t i;
+
+    for (i = 0; i < buf_size; i++)
+        if (buf[i])
+            return 0;
+
+    return 1;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+test_mem_alloc(na_class_t *na_class)
+{
+    void *bufs[NA_TEST_ALLOC_MAX], *plugin_data[NA_TEST_ALLOC_MAX];
+    void *buf, *buf_plugin_data;
+    int i, count, rc = EXIT_FAILURE;
+
+    /* Allocate until the arena is exhausted, memory then comes from the
+     * regular allocator (no plugin data) */
+    for (count = 0; count < NA_TEST_ALLOC_MAX; count++) {
+        bufs[count] = NA_Mem_alloc(na_class, NA_TEST_BUF_SIZE,
+            &plugin_data[count]);
+        if (!bufs[count]) {
+            fprintf(stderr, "Error: could not allocate buffer %d\n", count);
+            goto done;
+        }
+        if (!na_test_is_zero((unsigned char *) bufs[count], NA_TEST_BUF_SIZE)) {
+            fprintf(stderr, "Error: allocated buffer is not zeroed\n");
+            count++;
+            goto done;
+        }
+        memset(bufs[count], 1, NA_TEST_BUF_SIZE);
+        if (!plugin_data[count]) {
+            count++;
+            break;
+        }
+    }
+    if (count < 2 || count == NA_TEST_ALLOC_MAX || plugin_data[0]
+        == NULL || plugin_data[count - 1] != NULL) {
+        fprintf(stderr, "Error: arena was not used or never exhausted\n");
+        goto done;
+    }
+
+    /* Arena buffers are page aligned and do not overlap */
+    for (i = 1; i < count - 1; i++)
+        if ((char *) bufs[i] < (char *) bufs[i - 1] + NA_TEST_BUF_SIZE
+            && (char *) bufs[i - 1] < (char *) bufs[i] + NA_TEST_BUF_SIZE) {
+            fprintf(stderr, "Error: arena buffers overlap\n");
+            goto done;
+        }
+
+    /* Buffer that was not returned by NA_Mem_alloc() is rejected */
+    if (NA_Mem_free(na_class, (char *) bufs[0] + 1, plugin_data[0])
+        != NA_INVALID_ARG) {
+        fprintf(stderr, "Error: free of misaligned buffer not rejected\n");
+        goto done;
+    }
+
+    /* Freed pages are reused */
+    if (NA_Mem_free(na_class, bufs[0], plugin_data[0]) != NA_SUCCESS) {
+        fprintf(stderr, "Error: could not free arena buffer\n");
+        goto done;
+    }
+    buf = NA_Mem_alloc(na_class, NA_TEST_BUF_SIZE, &buf_plugin_data);
+    if (buf != bufs[0] || !buf_plugin_data
+        || !na_test_is_zero((unsigned char *) buf, NA_TEST_BUF_SIZE)) {
+        fprintf(stderr, "Error: freed arena pages were not reused\n");
+        bufs[0] = buf;
+        plugin_data[0] = buf_plugin_data;
+        goto done;
+    }
+
+    rc = EXIT_SUCCESS;
+
+done:
+    for (i = 0; i < count; i++)
+        if (bufs[i] && NA_Mem_free(na_class, bufs[i], plugin_data[i])
+            != NA_SUCCESS) {
+            fprintf(stderr, "Error: could not free buffer %d\n", i);
+            rc = EXIT_FAILURE;
+        }
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+test_client(int read_fd, int write_fd)
+{
+    struct na_test_unit client;
+    struct na_test_unit_cb_info cb_info;
+    struct na_test_handle test_handle;
+    na_mem_handle_t local_handle = NA_MEM_HANDLE_NULL,
+        remote_handle = NA_MEM_HANDLE_NULL;
+    unsigned char *buf = NULL;
+    void *plugin_data = NULL;
+    size_t i;
+    int rc = EXIT_FAILURE;
+
+    if (read(read_fd, &test_handle, sizeof(test_handle))
+        != sizeof(test_handle)) {
+        fprintf(stderr, "Error: could not read server handle\n");
+        return EXIT_FAILURE;
+    }
+
+    client.na_class = NA_Initialize(NA_TEST_INFO, NA_FALSE);
+    if (!client.na_class) {
+        fprintf(stderr, "Error: could not initialize client\n");
+        return EXIT_FAILURE;
+    }
+    client.context = NA_Context_create(client.na_class);
+    if (!client.context) {
+        fprintf(stderr, "Error: could not create client context\n");
+        goto done;
+    }
+
+    memset(&cb_info, 0, sizeof(cb_info));
+    NA_Addr_lookup(client.na_class, client.context, na_test_unit_cb, &cb_info,
+        test_handle.addr_string, NA_OP_ID_IGNORE);
+    if (na_test_unit_progress(&client, &cb_info.completed, 1) != NA_SUCCESS
+        || cb_info.ret != NA_SUCCESS) {
+        fprintf(stderr, "Error: could not look up server address\n");
+        goto done;
+    }
+
+    /* Local buffer also lies in an arena */
+    buf = (unsigned char *) NA_Mem_alloc(client.na_class, NA_TEST_BUF_SIZE,
+        &plugin_data);
+    if (!buf) {
+        fprintf(stderr, "Error: could not allocate client buffer\n");
+        goto done;
+    }
+    NA_Mem_handle_create(client.na_class, buf, NA_TEST_BUF_SIZE,
+        NA_MEM_READWRITE, &local_handle);
+    NA_Mem_register(client.na_class, local_handle);
+    if (NA_Mem_handle_deserialize(client.na_class, &remote_handle,
+        test_handle.buf, test_handle.buf_size) != NA_SUCCESS) {
+        fprintf(stderr, "Error: could not deserialize server handle\n");
+        goto done;
+    }
+
+    /* Get both halves at matching offsets */
+    cb_info.completed = 0;
+    NA_Get(client.na_class, client.context, na_test_unit_cb, &cb_info,
+        local_handle, 0, remote_handle, 0, NA_TEST_BUF_SIZE / 2, cb_info.addr,
+        0, NA_OP_ID_IGNORE);
+    NA_Get(client.na_class, client.context, na_test_unit_cb, &cb_info,
+        local_handle, NA_TEST_BUF_SIZE / 2, remote_handle,
+        NA_TEST_BUF_SIZE / 2, NA_TEST_BUF_SIZE / 2, cb_info.addr, 0,
+        NA_OP_ID_IGNORE);
+    if (na_test_unit_progress(&client, &cb_info.completed, 2) != NA_SUCCESS
+        || cb_info.ret != NA_SUCCESS) {
+        fprintf(stderr, "Error: get failed\n");
+        goto done;
+    }
+    for (i = 0; i < NA_TEST_BUF_SIZE; i++)
+        if (buf[i] != NA_TEST_GET_VALUE(i)) {
+            fprintf(stderr, "Error: get data does not match at %zu\n", i);
+            goto done;
+        }
+
+    for (i = 0; i < NA_TEST_BUF_SIZE; i++)
+        buf[i] = NA_TEST_PUT_VALUE(i);
+    cb_info.completed = 0;
+    NA_Put(client.na_class, client.context, na_test_unit_cb, &cb_info,
+        local_handle, 0, remote_handle, 0, NA_TEST_BUF_SIZE, cb_info.addr, 0,
+        NA_OP_ID_IGNORE);
+    if (na_test_unit_progress(&client, &cb_info.completed, 1) != NA_SUCCESS
+        || cb_info.ret != NA_SUCCESS) {
+        fprintf(stderr, "Error: put failed\n");
+        goto done;
+    }
+
+    rc = EXIT_SUCCESS;
+
+done:
+    if (remote_handle != NA_MEM_HANDLE_NULL)
+        NA_Mem_handle_free(client.na_class, remote_handle);
+    if (local_handle != NA_MEM_HANDLE_NULL) {
+        NA_Mem_deregister(client.na_class, local_handle);
+        NA_Mem_handle_free(client.na_class, local_handle);
+    }
+    if (buf)
+        NA_Mem_free(client.na_class, buf, plugin_data);
+    if (cb_info.addr)
+        NA_Addr_free(client.na_class, cb_info.addr);
+    if (client.context)
+        NA_Context_destroy(client.na_class, client.context);
+    NA_Finalize(client.na_class);
+
+    /* Server checks put data once the client is gone */
+    if (write(write_fd, &rc, sizeof(rc)) != sizeof(rc))
+        rc = EXIT_FAILURE;
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+test_server(int read_fd, int write_fd)
+{
+    na_class_t *na_class;
+    struct na_test_handle test_handle;
+    na_size_t addr_string_size = sizeof(test_handle.addr_string);
+    na_mem_handle_t mem_handle = NA_MEM_HANDLE_NULL;
+    na_addr_t self_addr;
+    unsigned char *buf = NULL;
+    void *small_buf = NULL, *plugin_data = NULL, *small_plugin_data = NULL;
+    size_t i;
+    int client_rc, rc = EXIT_FAILURE;
+
+    na_class = NA_Initialize(NA_TEST_INFO, NA_TRUE);
+    if (!na_class) {
+        fprintf(stderr, "Error: could not initialize server\n");
+        return EXIT_FAILURE;
+    }
+
+    if (test_mem_alloc(na_class) != EXIT_SUCCESS)
+        goto done;
+
+    /* Exposed buffer does not start at the arena base */
+    small_buf = NA_Mem_alloc(na_class, 100, &small_plugin_data);
+    buf = (unsigned char *) NA_Mem_alloc(na_class, NA_TEST_BUF_SIZE,
+        &plugin_data);
+    if (!small_buf || !buf || !plugin_data) {
+        fprintf(stderr, "Error: could not allocate server buffer\n");
+        goto done;
+    }
+    for (i = 0; i < NA_TEST_BUF_SIZE; i++)
+        buf[i] = NA_TEST_GET_VALUE(i);
+    NA_Mem_handle_create(na_class, buf, NA_TEST_BUF_SIZE, NA_MEM_READWRITE,
+        &mem_handle);
+    NA_Mem_register(na_class, mem_handle);
+
+    memset(&test_handle, 0, sizeof(test_handle));
+    NA_Addr_self(na_class, &self_addr);
+    NA_Addr_to_string(na_class, test_handle.addr_string, &addr_string_size,
+        self_addr);
+    NA_Addr_free(na_class, self_addr);
+    test_handle.buf_size = NA_Mem_handle_get_serialize_size(na_class,
+        mem_handle);
+    if (test_handle.buf_size > sizeof(test_handle.buf)
+        || NA_Mem_handle_serialize(na_class, test_handle.buf,
+            test_handle.buf_size, mem_handle) != NA_SUCCESS) {
+        fprintf(stderr, "Error: could not serialize memory handle\n");
+        goto done;
+    }
+    if (write(write_fd, &test_handle, sizeof(test_handle))
+        != sizeof(test_handle)) {
+        fprintf(stderr, "Error: could not write server handle\n");
+        goto done;
+    }
+
+    if (read(read_fd, &client_rc, sizeof(client_rc)) != sizeof(client_rc)
+        || client_rc != EXIT_SUCCESS)
+        goto done;
+    for (i = 0; i < NA_TEST_BUF_SIZE; i++)
+        if (buf[i] != NA_TEST_PUT_VALUE(i)) {
+            fprintf(stderr, "Error: put data does not match at %zu\n", i);
+            goto done;
+        }
+
+    rc = EXIT_SUCCESS;
+
+done:
+    if (mem_handle != NA_MEM_HANDLE_NULL) {
+        NA_Mem_deregister(na_class, mem_handle);
+        NA_Mem_handle_free(na_class, mem_handle);
+    }
+    if (buf)
+        NA_Mem_free(na_class, buf, plugin_data);
+    if (small_buf)
+        NA_Mem_free(na_class, small_buf, small_plugin_data);
+    NA_Finalize(na_class);
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+int
+main(void)
+{
+    int to_client[2], to_server[2], status, rc;
+    pid_t pid;
+
+    if (pipe(to_client) != 0 || pipe(to_server) != 0) {
+        fprintf(stderr, "Error: could not create pipes\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Fork before initializing NA so that nothing is shared */
+    pid = fork();
+    if (pid < 0) {
+        fprintf(stderr, "Error: could not fork\n");
+        return EXIT_FAILURE;
+    }
+    if (pid == 0) {
+        close(to_client[1]);
+        close(to_server[0]);
+        rc = test_client(to_client[0], to_server[1]);
+        close(to_client[0]);
+        close(to_server[1]);
+        _exit(rc);
+    }
+
+    close(to_client[0]);
+    close(to_server[1]);
+    rc = test_server(to_server[0], to_client[1]);
+    close(to_server[0]);
+    close(to_client[1]);
+    if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status)
+        || WEXITSTATUS(status) != EXIT_SUCCESS) {
+        fprintf(stderr, "Error: client failed\n");
+        rc = EXIT_FAILURE;
+    }
+
+    return rc;
+}
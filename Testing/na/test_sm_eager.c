@@ -0,0 +1,437 @@
+/*
+ * Copyright (C) 2013-2019 Argonne National Laboratory, Department of Energy,
+ *                    UChicago Argonne, LLC and The HDF Group.
+ * All rights reserved.
+ *
+ * The full copyright notice, including terms governing use, modification,
+ * and redistribution, is contained in the COPYING file that can be
+ * found at the root of the source code distribution tree.
+ */
+
+#include "na_test.h"
+
+#include "mercury_time.h"
+
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/****************/
+/* Local Macros */
+/****************/
+
+#define NA_TEST_INFO            "na+sm"
+
+#define NA_TEST_ADDR_MAX        256
+
+/* Size of a copy buf slot, messages past that use contiguous slots when
+ * NA_SM_EAGER_SIZE is configured above it */
+#define NA_TEST_SLOT_SIZE       4096
+
+/* Messages of mixed sizes sent without waiting, a lot more slots than the
+ * 256 a connection has are needed so that reservations wrap around and fail
+ * while slots are only free in between larger reservations */
+#define NA_TEST_SIZE_COUNT      6
+#define NA_TEST_MSG_COUNT       (NA_TEST_SIZE_COUNT * 32)
+
+/* One byte messages sent while the server does not progress until the ring
+ * buffer is full (one entry less than the 256 copy buf slots), then does not
+ * receive until all slots are used */
+#define NA_TEST_RING_COUNT      255
+#define NA_TEST_FILL_COUNT      257
+
+/* Time during which the server leaves the ring buffer full and then holds on
+ * to all slots (ms) */
+#define NA_TEST_FILL_WAIT       100
+
+#define NA_TEST_TAG             42
+
+/*---------------------------------------------------------------------------*/
+static na_size_t
+na_test_msg_size(na_size_t max_size, int i)
+{
+    const na_size_t sizes[NA_TEST_SIZE_COUNT] = {1, NA_TEST_SLOT_SIZE - 1,
+        NA_TEST_SLOT_SIZE, NA_TEST_SLOT_SIZE + 1, max_size - 1, max_size};
+    na_size_t size = sizes[i % NA_TEST_SIZE_COUNT];
+
+    return (size > max_size) ? max_size : size;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+na_test_fill_buf(char *buf, na_size_t buf_size, int i)
+{
+    na_size_t j;
+
+    /* Offset by message index so that stale or shifted slots are caught */
+    for (j = 0; j < buf_size; j++)
+        buf[j] = (char) (i + j);
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+na_test_check_buf(const struct na_test_unit_cb_info *cb_info,
+    na_size_t max_size, int i)
+{
+    const char *buf = (const char *) cb_info->buf;
+    na_size_t j;
+
+    if (cb_info->ret != NA_SUCCESS || !buf
+        || cb_info->buf_size != na_test_msg_size(max_size, i))
+        return EXIT_FAILURE;
+    for (j = 0; j < cb_info->buf_size; j++)
+        if (buf[j] != (char) (i + j))
+            return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+test_client_fill(struct na_test_unit *client, na_addr_t addr, int read_fd,
+    int write_fd)
+{
+    struct na_test_unit_cb_info cb_info, recv_info;
+    struct pollfd pfd;
+    char bufs[NA_TEST_FILL_COUNT], ack, sync = 0;
+    int i;
+
+    memset(&recv_info, 0, sizeof(recv_info));
+    NA_Msg_recv_expected(client->na_class, client->context, na_test_unit_cb,
+        &recv_info, &ack, sizeof(ack), NULL, addr, 0, NA_TEST_TAG,
+        NA_OP_ID_IGNORE);
+
+    /* Sends past the ring buffer size and then past the number of slots must
+     * wait for the server instead of failing */
+    memset(&cb_info, 0, sizeof(cb_info));
+    for (i = 0; i < NA_TEST_FILL_COUNT; i++) {
+        if (i == NA_TEST_RING_COUNT && write(write_fd, &sync, 1) != 1) {
+            fprintf(stderr, "Error: could not notify server\n");
+            return EXIT_FAILURE;
+        }
+        bufs[i] = (char) i;
+        if (NA_Msg_send_unexpected(client->na_class, client->context,
+            na_test_unit_cb, &cb_info, &bufs[i], 1, NULL, addr, 0,
+            NA_TEST_TAG, NA_OP_ID_IGNORE) != NA_SUCCESS) {
+            fprintf(stderr, "Error: could not send message %d\n", i);
+            return EXIT_FAILURE;
+        }
+    }
+
+    /* Last message only fits once the server has started releasing slots */
+    pfd.fd = read_fd;
+    pfd.events = POLLIN;
+    if (poll(&pfd, 1, 0) != 1 || read(read_fd, &sync, 1) != 1) {
+        fprintf(stderr, "Error: send did not wait for free slots\n");
+        return EXIT_FAILURE;
+    }
+    if (na_test_unit_progress(client, &cb_info.completed, NA_TEST_FILL_COUNT)
+        != NA_SUCCESS || cb_info.ret != NA_SUCCESS) {
+        fprintf(stderr, "Error: messages were not sent\n");
+        return EXIT_FAILURE;
+    }
+    if (na_test_unit_progress(client, &recv_info.completed, 1)
+        != NA_SUCCESS || recv_info.ret != NA_SUCCESS) {
+        fprintf(stderr, "Error: server did not acknowledge messages\n");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+test_client(int read_fd, int write_fd)
+{
+    struct na_test_unit client;
+    struct na_test_unit_cb_info cb_info, recv_info;
+    char addr_string[NA_TEST_ADDR_MAX], ack;
+    char *send_bufs = NULL;
+    na_size_t max_size;
+    na_addr_t addr = NA_ADDR_NULL;
+    int i, rc = EXIT_FAILURE;
+
+    if (read(read_fd, addr_string, sizeof(addr_string))
+        != sizeof(addr_string)) {
+        fprintf(stderr, "Error: could not read server address\n");
+        return EXIT_FAILURE;
+    }
+
+    client.na_class = NA_Initialize(NA_TEST_INFO, NA_FALSE);
+    if (!client.na_class) {
+        fprintf(stderr, "Error: could not initialize client\n");
+        return EXIT_FAILURE;
+    }
+    client.context = NA_Context_create(client.na_class);
+    if (!client.context) {
+        fprintf(stderr, "Error: could not create client context\n");
+        goto done;
+    }
+    if (NA_Addr_lookup2(client.na_class, addr_string, &addr) != NA_SUCCESS) {
+        fprintf(stderr, "Error: could not look up server address\n");
+        goto done;
+    }
+
+    /* Buffers must stay valid until sends complete */
+    max_size = NA_Msg_get_max_unexpected_size(client.na_class);
+    send_bufs = (char *) malloc(NA_TEST_MSG_COUNT * max_size);
+    if (!send_bufs) {
+        fprintf(stderr, "Error: could not allocate send buffers\n");
+        goto done;
+    }
+
+    memset(&recv_info, 0, sizeof(recv_info));
+    NA_Msg_recv_expected(client.na_class, client.context, na_test_unit_cb,
+        &recv_info, &ack, sizeof(ack), NULL, addr, 0, NA_TEST_TAG,
+        NA_OP_ID_IGNORE);
+
+    /* Sends wait for the server to free slots once all of them are used */
+    memset(&cb_info, 0, sizeof(cb_info));
+    for (i = 0; i < NA_TEST_MSG_COUNT; i++) {
+        char *buf = send_bufs + (size_t) i * max_size;
+        na_size_t buf_size = na_test_msg_size(max_size, i);
+
+        na_test_fill_buf(buf, buf_size, i);
+        if (NA_Msg_send_unexpected(client.na_class, client.context,
+            na_test_unit_cb, &cb_info, buf, buf_size, NULL, addr, 0,
+            NA_TEST_TAG, NA_OP_ID_IGNORE) != NA_SUCCESS) {
+            fprintf(stderr, "Error: could not send message %d\n", i);
+            goto done;
+        }
+    }
+    if (na_test_unit_progress(&client, &cb_info.completed, NA_TEST_MSG_COUNT)
+        != NA_SUCCESS || cb_info.ret != NA_SUCCESS) {
+        fprintf(stderr, "Error: messages were not sent\n");
+        goto done;
+    }
+
+    /* Server must be done reading from the copy buf before disconnecting */
+    if (na_test_unit_progress(&client, &recv_info.completed, 1)
+        != NA_SUCCESS || recv_info.ret != NA_SUCCESS) {
+        fprintf(stderr, "Error: server did not acknowledge messages\n");
+        goto done;
+    }
+
+    rc = test_client_fill(&client, addr, read_fd, write_fd);
+
+done:
+    free(send_bufs);
+    if (addr)
+        NA_Addr_free(client.na_class, addr);
+    if (client.context)
+        NA_Context_destroy(client.na_class, client.context);
+    NA_Finalize(client.na_class);
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+test_server_fill(struct na_test_unit *server, int read_fd, int write_fd)
+{
+    struct na_test_unit_cb_info cb_info, send_info;
+    struct pollfd pfd;
+    hg_time_t t1, t2;
+    char buf, ack = 1, sync = 0;
+    na_addr_t source_addr = NA_ADDR_NULL;
+    int i, rc = EXIT_FAILURE;
+
+    /* Client fills the ring buffer while nothing is popped from it */
+    pfd.fd = read_fd;
+    pfd.events = POLLIN;
+    if (poll(&pfd, 1, NA_TEST_UNIT_TIMEOUT) != 1
+        || read(read_fd, &sync, 1) != 1) {
+        fprintf(stderr, "Error: client did not fill ring buffer\n");
+        return EXIT_FAILURE;
+    }
+    hg_time_sleep(hg_time_from_double(NA_TEST_FILL_WAIT / 1000.0));
+
+    /* Queued unexpected messages hold on to their slots */
+    hg_time_get_current(&t1);
+    do {
+        NA_Progress(server->na_class, server->context, 10);
+        hg_time_get_current(&t2);
+    } while (hg_time_to_double(hg_time_subtract(t2, t1))
+        < NA_TEST_FILL_WAIT / 1000.0);
+    if (write(write_fd, &sync, 1) != 1) {
+        fprintf(stderr, "Error: could not notify client\n");
+        return EXIT_FAILURE;
+    }
+
+    for (i = 0; i < NA_TEST_FILL_COUNT; i++) {
+        memset(&cb_info, 0, sizeof(cb_info));
+        NA_Msg_recv_unexpected(server->na_class, server->context,
+            na_test_unit_cb, &cb_info, &buf, sizeof(buf), NULL,
+            NA_OP_ID_IGNORE);
+        if (na_test_unit_progress(server, &cb_info.completed, 1)
+            != NA_SUCCESS || cb_info.ret != NA_SUCCESS
+            || buf != (char) i) {
+            fprintf(stderr, "Error: message %d does not match\n", i);
+            if (cb_info.addr)
+                NA_Addr_free(server->na_class, cb_info.addr);
+            goto done;
+        }
+        if (source_addr)
+            NA_Addr_free(server->na_class, source_addr);
+        source_addr = cb_info.addr;
+    }
+
+    memset(&send_info, 0, sizeof(send_info));
+    NA_Msg_send_expected(server->na_class, server->context, na_test_unit_cb,
+        &send_info, &ack, sizeof(ack), NULL, source_addr, 0, NA_TEST_TAG,
+        NA_OP_ID_IGNORE);
+    if (na_test_unit_progress(server, &send_info.completed, 1)
+        != NA_SUCCESS || send_info.ret != NA_SUCCESS) {
+        fprintf(stderr, "Error: could not acknowledge messages\n");
+        goto done;
+    }
+
+    rc = EXIT_SUCCESS;
+
+done:
+    if (source_addr)
+        NA_Addr_free(server->na_class, source_addr);
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+test_server(int read_fd, int write_fd)
+{
+    struct na_test_unit server;
+    struct na_test_unit_cb_info cb_info, send_info;
+    char addr_string[NA_TEST_ADDR_MAX], *buf = NULL, ack = 1;
+    na_size_t addr_string_size = sizeof(addr_string), max_size;
+    na_addr_t self_addr, source_addr = NA_ADDR_NULL;
+    int i, rc = EXIT_FAILURE;
+
+    server.na_class = NA_Initialize(NA_TEST_INFO, NA_TRUE);
+    if (!server.na_class) {
+        fprintf(stderr, "Error: could not initialize server\n");
+        return EXIT_FAILURE;
+    }
+    server.context = NA_Context_create(server.na_class);
+    if (!server.context) {
+        fprintf(stderr, "Error: could not create server context\n");
+        goto done;
+    }
+
+    max_size = NA_Msg_get_max_unexpected_size(server.na_class);
+    buf = (char *) malloc(max_size);
+    if (!buf) {
+        fprintf(stderr, "Error: could not allocate receive buffer\n");
+        goto done;
+    }
+
+    memset(addr_string, 0, sizeof(addr_string));
+    NA_Addr_self(server.na_class, &self_addr);
+    NA_Addr_to_string(server.na_class, addr_string, &addr_string_size,
+        self_addr);
+    NA_Addr_free(server.na_class, self_addr);
+    if (write(write_fd, addr_string, sizeof(addr_string))
+        != sizeof(addr_string)) {
+        fprintf(stderr, "Error: could not write server address\n");
+        goto done;
+    }
+
+    /* Receive one message at a time so that the client runs out of slots,
+     * every other message is loaned to also free slots on release */
+    for (i = 0; i < NA_TEST_MSG_COUNT; i++) {
+        na_bool_t loan = (na_bool_t) (i % 2);
+
+        memset(&cb_info, 0, sizeof(cb_info));
+        NA_Msg_recv_unexpected(server.na_class, server.context,
+            na_test_unit_cb, &cb_info, loan ? NULL : buf, max_size, NULL,
+            NA_OP_ID_IGNORE);
+        if (na_test_unit_progress(&server, &cb_info.completed, 1)
+            != NA_SUCCESS
+            || na_test_check_buf(&cb_info, max_size, i) != EXIT_SUCCESS) {
+            fprintf(stderr, "Error: message %d does not match\n", i);
+            if (cb_info.addr)
+                NA_Addr_free(server.na_class, cb_info.addr);
+            goto done;
+        }
+        if (loan && NA_Msg_loan_release(server.na_class, cb_info.buf,
+            cb_info.buf_size, cb_info.addr) != NA_SUCCESS) {
+            fprintf(stderr, "Error: could not release message %d\n", i);
+            NA_Addr_free(server.na_class, cb_info.addr);
+            goto done;
+        }
+        if (source_addr)
+            NA_Addr_free(server.na_class, source_addr);
+        source_addr = cb_info.addr;
+    }
+
+    memset(&send_info, 0, sizeof(send_info));
+    NA_Msg_send_expected(server.na_class, server.context, na_test_unit_cb,
+        &send_info, &ack, sizeof(ack), NULL, source_addr, 0, NA_TEST_TAG,
+        NA_OP_ID_IGNORE);
+    if (na_test_unit_progress(&server, &send_info.completed, 1)
+        != NA_SUCCESS || send_info.ret != NA_SUCCESS) {
+        fprintf(stderr, "Error: could not acknowledge messages\n");
+        goto done;
+    }
+
+    rc = test_server_fill(&server, read_fd, write_fd);
+
+done:
+    if (source_addr)
+        NA_Addr_free(server.na_class, source_addr);
+    free(buf);
+    if (server.context)
+        NA_Context_destroy(server.na_class, server.context);
+    NA_Finalize(server.na_class);
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+int
+main(void)
+{
+    int server_fds[2], client_fds[2], status, rc;
+    pid_t pid;
+
+    /* Server writes to client through server_fds and reads from client_fds */
+    if (pipe(server_fds) != 0 || pipe(client_fds) != 0) {
+        fprintf(stderr, "Error: could not create pipes\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Fork before initializing NA so that nothing is shared */
+    pid = fork();
+    if (pid < 0) {
+        fprintf(stderr, "Error: could not fork\n");
+        return EXIT_FAILURE;
+    }
+    if (pid == 0) {
+        close(server_fds[1]);
+        close(client_fds[0]);
+        rc = test_client(server_fds[0], client_fds[1]);
+        close(server_fds[0]);
+        close(client_fds[1]);
+        _exit(rc);
+    }
+
+    close(server_fds[0]);
+    close(client_fds[1]);
+    rc = test_server(client_fds[0], server_fds[1]);
+    close(server_fds[1]);
+    close(client_fds[0]);
+    /* Client would otherwise wait forever for slots to be freed */
+    if (rc != EXIT_SUCCESS)
+        kill(pid, SIGKILL);
+    if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status)
+        || WEXITSTATUS(status) != EXIT_SUCCESS) {
+        fprintf(stderr, "Error: client failed\n");
+        rc = EXIT_FAILURE;
+    }
+
+    return rc;
+}
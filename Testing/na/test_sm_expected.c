@@ -0,0 +1,265 @@
+/*
+ * Copyright (C) 2013-2019 Argonne National Laboratory, Department of Energy,
+ *                    UChicago Argonne, LLC and The HDF Group.
+ * All rights reserved.
+ *
+ * The full copyright notice, including terms governing use, modification,
+ * and redistribution, is contained in the COPYING file that can be
+ * found at the root of the source code distribution tree.
+ */
+
+#include "na_test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/****************/
+/* Local Macros */
+/****************/
+
+#define NA_TEST_INFO            "na+sm"
+
+#define NA_TEST_ADDR_MAX        256
+
+/* Receives posted with the same (addr, tag), the second one is canceled */
+#define NA_TEST_RECV_COUNT      4
+#define NA_TEST_CANCELED        1
+
+#define NA_TEST_TAG             42
+/* Falls into the same expected op bucket as NA_TEST_TAG */
+#define NA_TEST_OTHER_TAG       (NA_TEST_TAG + 256)
+
+/*---------------------------------------------------------------------------*/
+static int
+test_client(int fd)
+{
+    struct na_test_unit client;
+    struct na_test_unit_cb_info cb_info[NA_TEST_RECV_COUNT], other_info,
+        send_info;
+    char addr_string[NA_TEST_ADDR_MAX];
+    char bufs[NA_TEST_RECV_COUNT], other_buf = 0, send_buf = 0;
+    na_op_id_t op_ids[NA_TEST_RECV_COUNT];
+    na_addr_t addr = NA_ADDR_NULL;
+    int i, expected, rc = EXIT_FAILURE;
+
+    for (i = 0; i < NA_TEST_RECV_COUNT; i++)
+        op_ids[i] = NA_OP_ID_NULL;
+    if (read(fd, addr_string, sizeof(addr_string)) != sizeof(addr_string)) {
+        fprintf(stderr, "Error: could not read server address\n");
+        return EXIT_FAILURE;
+    }
+
+    client.na_class = NA_Initialize(NA_TEST_INFO, NA_FALSE);
+    if (!client.na_class) {
+        fprintf(stderr, "Error: could not initialize client\n");
+        return EXIT_FAILURE;
+    }
+    client.context = NA_Context_create(client.na_class);
+    if (!client.context) {
+        fprintf(stderr, "Error: could not create client context\n");
+        goto done;
+    }
+    if (NA_Addr_lookup2(client.na_class, addr_string, &addr) != NA_SUCCESS) {
+        fprintf(stderr, "Error: could not look up server address\n");
+        goto done;
+    }
+
+    /* Other tag is posted first so that it comes before in the bucket */
+    memset(&other_info, 0, sizeof(other_info));
+    NA_Msg_recv_expected(client.na_class, client.context, na_test_unit_cb,
+        &other_info, &other_buf, sizeof(other_buf), NULL, addr, 0,
+        NA_TEST_OTHER_TAG, NA_OP_ID_IGNORE);
+    memset(cb_info, 0, sizeof(cb_info));
+    memset(bufs, 0, sizeof(bufs));
+    for (i = 0; i < NA_TEST_RECV_COUNT; i++)
+        NA_Msg_recv_expected(client.na_class, client.context, na_test_unit_cb,
+            &cb_info[i], &bufs[i], sizeof(bufs[i]), NULL, addr, 0,
+            NA_TEST_TAG, &op_ids[i]);
+
+    /* Canceled op is unlinked from the middle of its bucket */
+    NA_Cancel(client.na_class, client.context, op_ids[NA_TEST_CANCELED]);
+    if (na_test_unit_progress(&client, &cb_info[NA_TEST_CANCELED].completed,
+        1) != NA_SUCCESS || cb_info[NA_TEST_CANCELED].ret != NA_CANCELED) {
+        fprintf(stderr, "Error: expected receive was not canceled\n");
+        goto done;
+    }
+
+    /* Server replies once receives are posted */
+    memset(&send_info, 0, sizeof(send_info));
+    NA_Msg_send_unexpected(client.na_class, client.context, na_test_unit_cb,
+        &send_info, &send_buf, sizeof(send_buf), NULL, addr, 0, NA_TEST_TAG,
+        NA_OP_ID_IGNORE);
+    if (na_test_unit_progress(&client, &other_info.completed, 1) != NA_SUCCESS
+        || other_info.ret != NA_SUCCESS
+        || other_buf != NA_TEST_RECV_COUNT) {
+        fprintf(stderr, "Error: other tag was not received\n");
+        goto done;
+    }
+
+    /* Receives that were not canceled complete in posting order */
+    for (i = 0, expected = 1; i < NA_TEST_RECV_COUNT; i++) {
+        if (i == NA_TEST_CANCELED)
+            continue;
+        if (na_test_unit_progress(&client, &cb_info[i].completed, 1)
+            != NA_SUCCESS || cb_info[i].ret != NA_SUCCESS
+            || bufs[i] != expected) {
+            fprintf(stderr, "Error: receive %d got message %d\n", i,
+                (int) bufs[i]);
+            goto done;
+        }
+        expected++;
+    }
+
+    /* Server must be done before disconnecting */
+    NA_Msg_send_unexpected(client.na_class, client.context, na_test_unit_cb,
+        &send_info, &send_buf, sizeof(send_buf), NULL, addr, 0, NA_TEST_TAG,
+        NA_OP_ID_IGNORE);
+    if (na_test_unit_progress(&client, &send_info.completed, 2)
+        != NA_SUCCESS) {
+        fprintf(stderr, "Error: could not notify server\n");
+        goto done;
+    }
+
+    rc = EXIT_SUCCESS;
+
+done:
+    for (i = 0; i < NA_TEST_RECV_COUNT; i++)
+        if (op_ids[i] != NA_OP_ID_NULL)
+            NA_Op_destroy(client.na_class, op_ids[i]);
+    if (addr)
+        NA_Addr_free(client.na_class, addr);
+    if (client.context)
+        NA_Context_destroy(client.na_class, client.context);
+    NA_Finalize(client.na_class);
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+test_server(int fd)
+{
+    struct na_test_unit server;
+    struct na_test_unit_cb_info cb_info, send_info;
+    char addr_string[NA_TEST_ADDR_MAX], buf;
+    char send_bufs[NA_TEST_RECV_COUNT];
+    na_size_t addr_string_size = sizeof(addr_string);
+    na_addr_t self_addr;
+    int i, rc = EXIT_FAILURE;
+
+    server.na_class = NA_Initialize(NA_TEST_INFO, NA_TRUE);
+    if (!server.na_class) {
+        fprintf(stderr, "Error: could not initialize server\n");
+        return EXIT_FAILURE;
+    }
+    server.context = NA_Context_create(server.na_class);
+    if (!server.context) {
+        fprintf(stderr, "Error: could not create server context\n");
+        goto done;
+    }
+
+    memset(addr_string, 0, sizeof(addr_string));
+    NA_Addr_self(server.na_class, &self_addr);
+    NA_Addr_to_string(server.na_class, addr_string, &addr_string_size,
+        self_addr);
+    NA_Addr_free(server.na_class, self_addr);
+
+    memset(&cb_info, 0, sizeof(cb_info));
+    NA_Msg_recv_unexpected(server.na_class, server.context, na_test_unit_cb,
+        &cb_info, &buf, sizeof(buf), NULL, NA_OP_ID_IGNORE);
+    if (write(fd, addr_string, sizeof(addr_string)) != sizeof(addr_string)) {
+        fprintf(stderr, "Error: could not write server address\n");
+        goto done;
+    }
+    if (na_test_unit_progress(&server, &cb_info.completed, 1) != NA_SUCCESS
+        || cb_info.ret != NA_SUCCESS) {
+        fprintf(stderr, "Error: client did not post receives\n");
+        goto done;
+    }
+
+    /* One message less than receives were posted, other tag in between */
+    memset(&send_info, 0, sizeof(send_info));
+    for (i = 1; i < NA_TEST_RECV_COUNT; i++) {
+        send_bufs[i] = (char) i;
+        NA_Msg_send_expected(server.na_class, server.context,
+            na_test_unit_cb, &send_info, &send_bufs[i], sizeof(send_bufs[i]),
+            NULL, cb_info.addr, 0, NA_TEST_TAG, NA_OP_ID_IGNORE);
+        if (i != 1)
+            continue;
+        send_bufs[0] = NA_TEST_RECV_COUNT;
+        NA_Msg_send_expected(server.na_class, server.context,
+            na_test_unit_cb, &send_info, &send_bufs[0], sizeof(send_bufs[0]),
+            NULL, cb_info.addr, 0, NA_TEST_OTHER_TAG, NA_OP_ID_IGNORE);
+    }
+    if (na_test_unit_progress(&server, &send_info.completed,
+        NA_TEST_RECV_COUNT) != NA_SUCCESS) {
+        fprintf(stderr, "Error: could not send messages\n");
+        goto done;
+    }
+
+    /* Wait for client to be done */
+    NA_Addr_free(server.na_class, cb_info.addr);
+    memset(&cb_info, 0, sizeof(cb_info));
+    NA_Msg_recv_unexpected(server.na_class, server.context, na_test_unit_cb,
+        &cb_info, &buf, sizeof(buf), NULL, NA_OP_ID_IGNORE);
+    if (na_test_unit_progress(&server, &cb_info.completed, 1) != NA_SUCCESS) {
+        fprintf(stderr, "Error: client did not complete\n");
+        goto done;
+    }
+
+    rc = EXIT_SUCCESS;
+
+done:
+    if (cb_info.addr)
+        NA_Addr_free(server.na_class, cb_info.addr);
+    if (server.context)
+        NA_Context_destroy(server.na_class, server.context);
+    NA_Finalize(server.na_class);
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+int
+main(void)
+{
+    int fds[2], status, rc;
+    pid_t pid;
+
+    if (pipe(fds) != 0) {
+        fprintf(stderr, "Error: could not create pipe\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Fork before initializing NA so that nothing is shared */
+    pid = fork();
+    if (pid < 0) {
+        fprintf(stderr, "Error: could not fork\n");
+        return EXIT_FAILURE;
+    }
+    if (pid == 0) {
+        close(fds[1]);
+        rc = test_client(fds[0]);
+        close(fds[0]);
+        _exit(rc);
+    }
+
+    close(fds[0]);
+    rc = test_server(fds[1]);
+    close(fds[1]);
+    /* Client would otherwise wait forever for replies */
+    if (rc != EXIT_SUCCESS)
+        kill(pid, SIGKILL);
+    if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status)
+        || WEXITSTATUS(status) != EXIT_SUCCESS) {
+        fprintf(stderr, "Error: client failed\n");
+        rc = EXIT_FAILURE;
+    }
+
+    return rc;
+}
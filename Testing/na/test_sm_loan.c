@@ -0,0 +1,319 @@
+/*
+ * Copyright (C) 2013-2019 Argonne National Laboratory, Department of Energy,
+ *                    UChicago Argonne, LLC and The HDF Group.
+ * All rights reserved.
+ *
+ * The full copyright notice, including terms governing use, modification,
+ * and redistribution, is contained in the COPYING file that can be
+ * found at the root of the source code distribution tree.
+ */
+
+#include "na_test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/****************/
+/* Local Macros */
+/****************/
+
+#define NA_TEST_INFO            "na+sm"
+
+#define NA_TEST_ADDR_MAX        256
+#define NA_TEST_MSG_SIZE        64
+
+/* More loans held at once than the sender has copy buf slots, messages are
+ * sent in batches so that the ring buffer does not fill up */
+#define NA_TEST_BATCH_SIZE      32
+#define NA_TEST_BATCH_COUNT     10
+#define NA_TEST_LOAN_COUNT      (NA_TEST_BATCH_SIZE * NA_TEST_BATCH_COUNT)
+
+#define NA_TEST_TAG             42
+
+/*---------------------------------------------------------------------------*/
+static int
+na_test_check_buf(const struct na_test_unit_cb_info *cb_info, char value)
+{
+    na_size_t i;
+
+    if (cb_info->ret != NA_SUCCESS || !cb_info->buf
+        || cb_info->buf_size != NA_TEST_MSG_SIZE)
+        return EXIT_FAILURE;
+    for (i = 0; i < cb_info->buf_size; i++)
+        if (((const char *) cb_info->buf)[i] != value)
+            return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+test_client(int fd)
+{
+    struct na_test_unit client;
+    struct na_test_unit_cb_info cb_info, recv_info;
+    char addr_string[NA_TEST_ADDR_MAX];
+    char send_bufs[NA_TEST_LOAN_COUNT][NA_TEST_MSG_SIZE];
+    na_addr_t addr = NA_ADDR_NULL;
+    int i, j, rc = EXIT_FAILURE;
+
+    if (read(fd, addr_string, sizeof(addr_string)) != sizeof(addr_string)) {
+        fprintf(stderr, "Error: could not read server address\n");
+        return EXIT_FAILURE;
+    }
+
+    client.na_class = NA_Initialize(NA_TEST_INFO, NA_FALSE);
+    if (!client.na_class) {
+        fprintf(stderr, "Error: could not initialize client\n");
+        return EXIT_FAILURE;
+    }
+    client.context = NA_Context_create(client.na_class);
+    if (!client.context) {
+        fprintf(stderr, "Error: could not create client context\n");
+        goto done;
+    }
+    if (NA_Addr_lookup2(client.na_class, addr_string, &addr) != NA_SUCCESS) {
+        fprintf(stderr, "Error: could not look up server address\n");
+        goto done;
+    }
+
+    /* Server holds on to all of these, sends must still go through */
+    memset(&cb_info, 0, sizeof(cb_info));
+    for (i = 0; i < NA_TEST_BATCH_COUNT; i++) {
+        /* Reply to each batch is received in a loaned buffer */
+        memset(&recv_info, 0, sizeof(recv_info));
+        NA_Msg_recv_expected(client.na_class, client.context, na_test_unit_cb,
+            &recv_info, NULL, NA_TEST_MSG_SIZE, NULL, addr, 0, NA_TEST_TAG,
+            NA_OP_ID_IGNORE);
+
+        for (j = i * NA_TEST_BATCH_SIZE; j < (i + 1) * NA_TEST_BATCH_SIZE;
+            j++) {
+            memset(send_bufs[j], (char) j, NA_TEST_MSG_SIZE);
+            if (NA_Msg_send_unexpected(client.na_class, client.context,
+                na_test_unit_cb, &cb_info, send_bufs[j], NA_TEST_MSG_SIZE, NULL,
+                addr, 0, NA_TEST_TAG, NA_OP_ID_IGNORE) != NA_SUCCESS) {
+                fprintf(stderr, "Error: could not send message %d\n", j);
+                goto done;
+            }
+        }
+        if (na_test_unit_progress(&client, &cb_info.completed, j)
+            != NA_SUCCESS) {
+            fprintf(stderr, "Error: batch %d was not sent\n", i);
+            goto done;
+        }
+
+        if (na_test_unit_progress(&client, &recv_info.completed, 1)
+            != NA_SUCCESS
+            || na_test_check_buf(&recv_info, (char) i) != EXIT_SUCCESS) {
+            fprintf(stderr, "Error: loaned reply does not match\n");
+            goto done;
+        }
+        if (NA_Msg_loan_release(client.na_class, recv_info.buf,
+            recv_info.buf_size, addr) != NA_SUCCESS) {
+            fprintf(stderr, "Error: could not release loaned reply\n");
+            goto done;
+        }
+    }
+
+    /* Server must not disconnect while the last reply is loaned */
+    NA_Msg_send_unexpected(client.na_class, client.context, na_test_unit_cb,
+        &cb_info, send_bufs[0], NA_TEST_MSG_SIZE, NULL, addr, 0, NA_TEST_TAG,
+        NA_OP_ID_IGNORE);
+    if (na_test_unit_progress(&client, &cb_info.completed,
+        NA_TEST_LOAN_COUNT + 1) != NA_SUCCESS) {
+        fprintf(stderr, "Error: could not send last message\n");
+        goto done;
+    }
+
+    rc = EXIT_SUCCESS;
+
+done:
+    if (addr)
+        NA_Addr_free(client.na_class, addr);
+    if (client.context)
+        NA_Context_destroy(client.na_class, client.context);
+    NA_Finalize(client.na_class);
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+test_release(struct na_test_unit *server, struct na_test_unit_cb_info *cb_info)
+{
+    struct na_test_unit_cb_info *first = &cb_info[0],
+        *last = &cb_info[NA_TEST_LOAN_COUNT - 1];
+    char buf[NA_TEST_MSG_SIZE];
+    int i;
+
+    /* Buffers that were not loaned are rejected */
+    if (NA_Msg_loan_release(server->na_class, buf, sizeof(buf), first->addr)
+        != NA_INVALID_ARG) {
+        fprintf(stderr, "Error: release of unknown buffer not rejected\n");
+        return EXIT_FAILURE;
+    }
+    if (NA_Msg_loan_release(server->na_class, (char *) first->buf + 1,
+        first->buf_size - 1, first->addr) != NA_INVALID_ARG
+        || NA_Msg_loan_release(server->na_class, (char *) last->buf + 1,
+        last->buf_size - 1, last->addr) != NA_INVALID_ARG) {
+        fprintf(stderr, "Error: release of misaligned buffer not rejected\n");
+        return EXIT_FAILURE;
+    }
+    if (NA_Msg_loan_release(server->na_class, first->buf, first->buf_size,
+        NA_ADDR_NULL) != NA_INVALID_ARG) {
+        fprintf(stderr, "Error: release without source not rejected\n");
+        return EXIT_FAILURE;
+    }
+
+    for (i = 0; i < NA_TEST_LOAN_COUNT; i++)
+        if (NA_Msg_loan_release(server->na_class, cb_info[i].buf,
+            cb_info[i].buf_size, cb_info[i].addr) != NA_SUCCESS) {
+            fprintf(stderr, "Error: could not release loan %d\n", i);
+            return EXIT_FAILURE;
+        }
+
+    /* Past the limit messages were copied, a copy can only be released once */
+    if (NA_Msg_loan_release(server->na_class, last->buf, last->buf_size,
+        last->addr) != NA_INVALID_ARG) {
+        fprintf(stderr, "Error: second release of loan not rejected\n");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+test_server(int fd)
+{
+    struct na_test_unit server;
+    struct na_test_unit_cb_info *cb_info = NULL, send_info;
+    char addr_string[NA_TEST_ADDR_MAX], buf[NA_TEST_MSG_SIZE];
+    na_size_t addr_string_size = sizeof(addr_string);
+    na_addr_t self_addr;
+    int i, rc = EXIT_FAILURE;
+
+    server.na_class = NA_Initialize(NA_TEST_INFO, NA_TRUE);
+    if (!server.na_class) {
+        fprintf(stderr, "Error: could not initialize server\n");
+        return EXIT_FAILURE;
+    }
+    server.context = NA_Context_create(server.na_class);
+    if (!server.context) {
+        fprintf(stderr, "Error: could not create server context\n");
+        goto done;
+    }
+    if (!NA_Msg_loan_supported(server.na_class)) {
+        fprintf(stderr, "Error: loans should be supported\n");
+        goto done;
+    }
+
+    memset(addr_string, 0, sizeof(addr_string));
+    NA_Addr_self(server.na_class, &self_addr);
+    NA_Addr_to_string(server.na_class, addr_string, &addr_string_size,
+        self_addr);
+    NA_Addr_free(server.na_class, self_addr);
+
+    /* Receive every message in a loaned buffer */
+    cb_info = (struct na_test_unit_cb_info *) calloc(NA_TEST_LOAN_COUNT,
+        sizeof(*cb_info));
+    if (!cb_info) {
+        fprintf(stderr, "Error: could not allocate callback info\n");
+        goto done;
+    }
+    for (i = 0; i < NA_TEST_LOAN_COUNT; i++)
+        NA_Msg_recv_unexpected(server.na_class, server.context, na_test_unit_cb,
+            &cb_info[i], NULL, NA_TEST_MSG_SIZE, NULL, NA_OP_ID_IGNORE);
+    if (write(fd, addr_string, sizeof(addr_string)) != sizeof(addr_string)) {
+        fprintf(stderr, "Error: could not write server address\n");
+        goto done;
+    }
+    for (i = 0; i < NA_TEST_LOAN_COUNT; i++) {
+        if (na_test_unit_progress(&server, &cb_info[i].completed, 1)
+            != NA_SUCCESS
+            || na_test_check_buf(&cb_info[i], (char) i) != EXIT_SUCCESS) {
+            fprintf(stderr, "Error: loaned message %d does not match\n", i);
+            goto done;
+        }
+        if ((i + 1) % NA_TEST_BATCH_SIZE)
+            continue;
+
+        /* Loans are still held, acknowledge batch */
+        memset(&send_info, 0, sizeof(send_info));
+        memset(buf, i / NA_TEST_BATCH_SIZE, sizeof(buf));
+        NA_Msg_send_expected(server.na_class, server.context, na_test_unit_cb,
+            &send_info, buf, sizeof(buf), NULL, cb_info[i].addr, 0,
+            NA_TEST_TAG, NA_OP_ID_IGNORE);
+        if (na_test_unit_progress(&server, &send_info.completed, 1)
+            != NA_SUCCESS) {
+            fprintf(stderr, "Error: could not acknowledge batch\n");
+            goto done;
+        }
+    }
+
+    rc = test_release(&server, cb_info);
+
+    /* Wait for client to be done */
+    memset(&send_info, 0, sizeof(send_info));
+    NA_Msg_recv_unexpected(server.na_class, server.context, na_test_unit_cb,
+        &send_info, buf, sizeof(buf), NULL, NA_OP_ID_IGNORE);
+    if (na_test_unit_progress(&server, &send_info.completed, 1)
+        != NA_SUCCESS)
+        rc = EXIT_FAILURE;
+    if (send_info.addr)
+        NA_Addr_free(server.na_class, send_info.addr);
+
+done:
+    if (cb_info) {
+        for (i = 0; i < NA_TEST_LOAN_COUNT; i++)
+            if (cb_info[i].addr)
+                NA_Addr_free(server.na_class, cb_info[i].addr);
+        free(cb_info);
+    }
+    if (server.context)
+        NA_Context_destroy(server.na_class, server.context);
+    NA_Finalize(server.na_class);
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+int
+main(void)
+{
+    int fds[2], status, rc;
+    pid_t pid;
+
+    if (pipe(fds) != 0) {
+        fprintf(stderr, "Error: could not create pipe\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Fork before initializing NA so that nothing is shared */
+    pid = fork();
+    if (pid < 0) {
+        fprintf(stderr, "Error: could not fork\n");
+        return EXIT_FAILURE;
+    }
+    if (pid == 0) {
+        close(fds[1]);
+        rc = test_client(fds[0]);
+        close(fds[0]);
+        _exit(rc);
+    }
+
+    close(fds[0]);
+    rc = test_server(fds[1]);
+    close(fds[1]);
+    if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status)
+        || WEXITSTATUS(status) != EXIT_SUCCESS) {
+        fprintf(stderr, "Error: client failed\n");
+        rc = EXIT_FAILURE;
+    }
+
+    return rc;
+}
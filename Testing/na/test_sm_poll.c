@@ -0,0 +1,389 @@
+/*
+ * Copyright (C) 2013-2019 Argonne National Laboratory, Department of Energy,
+ *                    UChicago Argonne, LLC and The HDF Group.
+ * All rights reserved.
+ *
+ * The full copyright notice, including terms governing use, modification,
+ * and redistribution, is contained in the COPYING file that can be
+ * found at the root of the source code distribution tree.
+ */
+
+#include "na_test.h"
+
+#include "mercury_atomic.h"
+#include "mercury_poll.h"
+#include "mercury_thread.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/****************/
+/* Local Macros */
+/****************/
+
+#define NA_TEST_INFO            "na+sm"
+
+/* Max size of addr string sent to the client */
+#define NA_TEST_ADDR_MAX        256
+
+#define NA_TEST_MSG_SIZE        64
+#define NA_TEST_TAG             42
+
+/* Messages exchanged while registering / deregistering poll sets */
+#define NA_TEST_ROUNDS          4
+
+/* Poll sets registered at once by the server */
+#define NA_TEST_POLL_SETS       2
+
+/* Max number of poll waits per operation before giving up */
+#define NA_TEST_POLL_MAX        500
+
+/************************************/
+/* Local Type and Struct Definition */
+/************************************/
+
+/* Poll set registered and deregistered in a loop from a separate thread */
+struct na_test_churn {
+    struct na_test_unit *info;
+    hg_atomic_int32_t stop;
+    hg_atomic_int32_t error;
+    int count;
+};
+
+/*---------------------------------------------------------------------------*/
+static int
+na_test_poll_progress(struct na_test_unit *info, hg_poll_set_t *poll_set,
+    const int *completed, int target)
+{
+    int i;
+
+    /* Only the external poll set is waited on, NA_Progress() is never called
+     * so that operations can only complete through registered fds */
+    for (i = 0; i < NA_TEST_POLL_MAX && *completed < target; i++) {
+        hg_util_bool_t progressed = HG_UTIL_FALSE;
+
+        if (hg_poll_wait(poll_set, 10, &progressed) != HG_UTIL_SUCCESS) {
+            fprintf(stderr, "Error: hg_poll_wait() failed\n");
+            return EXIT_FAILURE;
+        }
+        na_test_unit_trigger(info);
+    }
+    if (*completed < target) {
+        fprintf(stderr, "Error: no progress made through poll set\n");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static HG_THREAD_RETURN_TYPE
+na_test_churn_thread(void *arg)
+{
+    hg_thread_ret_t thread_ret = (hg_thread_ret_t) 0;
+    struct na_test_churn *churn = (struct na_test_churn *) arg;
+    struct na_test_unit *info = churn->info;
+    hg_poll_set_t *poll_set;
+
+    poll_set = hg_poll_create();
+    if (!poll_set) {
+        hg_atomic_set32(&churn->error, 1);
+        goto done;
+    }
+
+    /* Races with fds being added and removed as the client connects,
+     * exchanges messages and disconnects */
+    while (!hg_atomic_get32(&churn->stop)) {
+        if (NA_Poll_register(info->na_class, info->context, poll_set)
+            != NA_SUCCESS
+            || NA_Poll_deregister(info->na_class, info->context, poll_set)
+            != NA_SUCCESS) {
+            hg_atomic_set32(&churn->error, 1);
+            break;
+        }
+        churn->count++;
+    }
+    hg_poll_destroy(poll_set);
+
+done:
+    hg_thread_exit(thread_ret);
+    return thread_ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+test_client(int fd)
+{
+    struct na_test_unit client;
+    struct na_test_unit_cb_info cb_info;
+    char addr_string[NA_TEST_ADDR_MAX];
+    char send_buf[NA_TEST_MSG_SIZE], recv_buf[NA_TEST_MSG_SIZE];
+    na_addr_t addr = NA_ADDR_NULL;
+    int i, rc = EXIT_FAILURE;
+
+    if (read(fd, addr_string, sizeof(addr_string)) != sizeof(addr_string)) {
+        fprintf(stderr, "Error: could not read server address\n");
+        return EXIT_FAILURE;
+    }
+
+    client.na_class = NA_Initialize(NA_TEST_INFO, NA_FALSE);
+    if (!client.na_class) {
+        fprintf(stderr, "Error: could not initialize client\n");
+        return EXIT_FAILURE;
+    }
+    client.context = NA_Context_create(client.na_class);
+    if (!client.context) {
+        fprintf(stderr, "Error: could not create client context\n");
+        goto done;
+    }
+    if (NA_Addr_lookup2(client.na_class, addr_string, &addr) != NA_SUCCESS) {
+        fprintf(stderr, "Error: could not look up server address\n");
+        goto done;
+    }
+
+    /* Wait for each reply so that the server can swap poll sets in between */
+    for (i = 0; i < NA_TEST_ROUNDS; i++) {
+        memset(&cb_info, 0, sizeof(cb_info));
+        memset(recv_buf, 0, sizeof(recv_buf));
+        NA_Msg_recv_expected(client.na_class, client.context, na_test_unit_cb,
+            &cb_info, recv_buf, sizeof(recv_buf), NULL, addr, 0, NA_TEST_TAG,
+            NA_OP_ID_IGNORE);
+        memset(send_buf, i + 1, sizeof(send_buf));
+        NA_Msg_send_unexpected(client.na_class, client.context, na_test_unit_cb,
+            &cb_info, send_buf, sizeof(send_buf), NULL, addr, 0, NA_TEST_TAG,
+            NA_OP_ID_IGNORE);
+        if (na_test_unit_progress(&client, &cb_info.completed, 2)
+            != NA_SUCCESS || cb_info.ret != NA_SUCCESS
+            || recv_buf[0] != i + 1) {
+            fprintf(stderr, "Error: did not receive reply %d\n", i);
+            goto done;
+        }
+    }
+
+    rc = EXIT_SUCCESS;
+
+done:
+    if (addr)
+        NA_Addr_free(client.na_class, addr);
+    if (client.context)
+        NA_Context_destroy(client.na_class, client.context);
+    NA_Finalize(client.na_class);
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+test_server_round(struct na_test_unit *server, hg_poll_set_t *poll_set, int i)
+{
+    struct na_test_unit_cb_info cb_info;
+    char buf[NA_TEST_MSG_SIZE];
+    int rc;
+
+    memset(&cb_info, 0, sizeof(cb_info));
+    NA_Msg_recv_unexpected(server->na_class, server->context, na_test_unit_cb,
+        &cb_info, buf, sizeof(buf), NULL, NA_OP_ID_IGNORE);
+    rc = na_test_poll_progress(server, poll_set, &cb_info.completed, 1);
+    if (rc != EXIT_SUCCESS)
+        return rc;
+    if (cb_info.ret != NA_SUCCESS || buf[0] != i + 1) {
+        fprintf(stderr, "Error: did not receive message %d\n", i);
+        return EXIT_FAILURE;
+    }
+
+    NA_Msg_send_expected(server->na_class, server->context, na_test_unit_cb,
+        &cb_info, buf, sizeof(buf), NULL, cb_info.addr, 0, NA_TEST_TAG,
+        NA_OP_ID_IGNORE);
+    rc = na_test_poll_progress(server, poll_set, &cb_info.completed, 2);
+    NA_Addr_free(server->na_class, cb_info.addr);
+    if (rc == EXIT_SUCCESS && cb_info.ret != NA_SUCCESS) {
+        fprintf(stderr, "Error: could not send reply %d\n", i);
+        rc = EXIT_FAILURE;
+    }
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+test_server(int fd, pid_t pid, pid_t *reaped, int *status)
+{
+    struct na_test_unit server;
+    struct na_test_churn churn;
+    hg_poll_set_t *poll_sets[NA_TEST_POLL_SETS] = {NULL};
+    na_bool_t registered[NA_TEST_POLL_SETS] = {NA_FALSE};
+    char addr_string[NA_TEST_ADDR_MAX];
+    na_size_t addr_string_size = sizeof(addr_string);
+    na_addr_t self_addr;
+    hg_thread_t thread;
+    na_bool_t thread_started = NA_FALSE;
+    int i, rc = EXIT_FAILURE;
+
+    server.na_class = NA_Initialize(NA_TEST_INFO, NA_TRUE);
+    if (!server.na_class) {
+        fprintf(stderr, "Error: could not initialize server\n");
+        return EXIT_FAILURE;
+    }
+    server.context = NA_Context_create(server.na_class);
+    if (!server.context) {
+        fprintf(stderr, "Error: could not create server context\n");
+        goto done;
+    }
+
+    for (i = 0; i < NA_TEST_POLL_SETS; i++) {
+        poll_sets[i] = hg_poll_create();
+        if (!poll_sets[i]) {
+            fprintf(stderr, "Error: could not create poll set\n");
+            goto done;
+        }
+    }
+
+    /* Invalid arguments and unknown poll sets are rejected */
+    if (NA_Poll_register(server.na_class, server.context, NULL)
+        != NA_INVALID_ARG
+        || NA_Poll_deregister(server.na_class, server.context, NULL)
+        != NA_INVALID_ARG
+        || NA_Poll_deregister(server.na_class, server.context, poll_sets[0])
+        == NA_SUCCESS) {
+        fprintf(stderr, "Error: invalid poll set was accepted\n");
+        goto done;
+    }
+
+    /* Listening fd is already registered, connection fds get added later */
+    for (i = 0; i < NA_TEST_POLL_SETS; i++) {
+        if (NA_Poll_register(server.na_class, server.context, poll_sets[i])
+            != NA_SUCCESS) {
+            fprintf(stderr, "Error: could not register poll set\n");
+            goto done;
+        }
+        registered[i] = NA_TRUE;
+    }
+
+    memset(&churn, 0, sizeof(churn));
+    churn.info = &server;
+    hg_atomic_init32(&churn.stop, 0);
+    hg_atomic_init32(&churn.error, 0);
+    if (hg_thread_create(&thread, na_test_churn_thread, &churn) != 0) {
+        fprintf(stderr, "Error: could not create thread\n");
+        goto done;
+    }
+    thread_started = NA_TRUE;
+
+    NA_Addr_self(server.na_class, &self_addr);
+    memset(addr_string, 0, sizeof(addr_string));
+    if (NA_Addr_to_string(server.na_class, addr_string, &addr_string_size,
+        self_addr) != NA_SUCCESS) {
+        fprintf(stderr, "Error: could not get server address\n");
+        NA_Addr_free(server.na_class, self_addr);
+        goto done;
+    }
+    NA_Addr_free(server.na_class, self_addr);
+    if (write(fd, addr_string, sizeof(addr_string)) != sizeof(addr_string)) {
+        fprintf(stderr, "Error: could not write server address\n");
+        goto done;
+    }
+
+    for (i = 0; i < NA_TEST_ROUNDS; i++) {
+        int idx = i % NA_TEST_POLL_SETS;
+
+        /* Progress through one poll set while the other one is swapped out,
+         * re-registering must pick up fds added in the meantime */
+        if (i >= NA_TEST_POLL_SETS) {
+            if (NA_Poll_deregister(server.na_class, server.context,
+                poll_sets[idx]) != NA_SUCCESS) {
+                fprintf(stderr, "Error: could not deregister poll set\n");
+                goto done;
+            }
+            registered[idx] = NA_FALSE;
+            if (NA_Poll_register(server.na_class, server.context,
+                poll_sets[idx]) != NA_SUCCESS) {
+                fprintf(stderr, "Error: could not register poll set\n");
+                goto done;
+            }
+            registered[idx] = NA_TRUE;
+        }
+        if (test_server_round(&server, poll_sets[idx], i) != EXIT_SUCCESS)
+            goto done;
+    }
+
+    /* Client disconnect removes its fds from the registered poll sets */
+    while ((*reaped = waitpid(pid, status, WNOHANG)) == 0) {
+        NA_Progress(server.na_class, server.context, 10);
+        na_test_unit_trigger(&server);
+    }
+    NA_Progress(server.na_class, server.context, 0);
+
+    rc = EXIT_SUCCESS;
+
+done:
+    if (thread_started) {
+        hg_atomic_set32(&churn.stop, 1);
+        hg_thread_join(thread);
+        if (hg_atomic_get32(&churn.error) || churn.count == 0) {
+            fprintf(stderr, "Error: concurrent poll set registration failed\n");
+            rc = EXIT_FAILURE;
+        }
+    }
+    for (i = 0; i < NA_TEST_POLL_SETS; i++) {
+        if (registered[i] && NA_Poll_deregister(server.na_class,
+            server.context, poll_sets[i]) != NA_SUCCESS) {
+            fprintf(stderr, "Error: could not deregister poll set\n");
+            rc = EXIT_FAILURE;
+        }
+        if (poll_sets[i])
+            hg_poll_destroy(poll_sets[i]);
+    }
+    if (server.context)
+        NA_Context_destroy(server.na_class, server.context);
+    NA_Finalize(server.na_class);
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+int
+main(void)
+{
+    int fds[2], status = 0, rc;
+    pid_t pid, reaped = 0;
+
+    if (pipe(fds) != 0) {
+        fprintf(stderr, "Error: could not create pipe\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Fork before initializing NA so that nothing is shared */
+    pid = fork();
+    if (pid < 0) {
+        fprintf(stderr, "Error: could not fork\n");
+        return EXIT_FAILURE;
+    }
+    if (pid == 0) {
+        close(fds[1]);
+        rc = test_client(fds[0]);
+        close(fds[0]);
+        _exit(rc);
+    }
+
+    close(fds[0]);
+    rc = test_server(fds[1], pid, &reaped, &status);
+    close(fds[1]);
+    if (reaped != pid) {
+        /* Client would otherwise wait forever for a reply */
+        if (rc != EXIT_SUCCESS)
+            kill(pid, SIGKILL);
+        reaped = waitpid(pid, &status, 0);
+    }
+    if (reaped != pid || !WIFEXITED(status)
+        || WEXITSTATUS(status) != EXIT_SUCCESS) {
+        fprintf(stderr, "Error: client failed\n");
+        rc = EXIT_FAILURE;
+    }
+
+    return rc;
+}
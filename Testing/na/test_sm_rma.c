@@ -0,0 +1,374 @@
+/*
+ * Copyright (C) 2013-2019 Argonne National Laboratory, Department of Energy,
+ *                    UChicago Argonne, LLC and The HDF Group.
+ * All rights reserved.
+ *
+ * The full copyright notice, including terms governing use, modification,
+ * and redistribution, is contained in the COPYING file that can be
+ * found at the root of the source code distribution tree.
+ */
+
+#include "na_test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/****************/
+/* Local Macros */
+/****************/
+
+#define NA_TEST_INFO            "na+sm"
+
+#define NA_TEST_ADDR_MAX        256
+#define NA_TEST_HANDLE_MAX      256
+
+/* Large enough to be split into chunks copied by helper threads */
+#define NA_TEST_RMA_SIZE        (8 << 20)
+#define NA_TEST_BAD_SIZE        (4 << 20)
+
+/* Unaligned transfer that does not start at the first chunk boundary */
+#define NA_TEST_LOCAL_OFFSET    3
+#define NA_TEST_REMOTE_OFFSET   ((1 << 20) + 5)
+#define NA_TEST_LENGTH          ((5 << 20) + 123)
+
+#define NA_TEST_GET_VALUE(i)    ((unsigned char) ((i) * 7))
+#define NA_TEST_PUT_VALUE(i)    ((unsigned char) ((i) * 3 + 1))
+
+/************************************/
+/* Local Type and Struct Definition */
+/************************************/
+
+/* Server addr and memory handles handed to the client over a pipe */
+struct na_test_handles {
+    char addr_string[NA_TEST_ADDR_MAX];
+    char buf[NA_TEST_HANDLE_MAX];
+    na_size_t buf_size;
+    char bad_buf[NA_TEST_HANDLE_MAX];   /* Partially unmapped memory */
+    na_size_t bad_buf_size;
+};
+
+/*---------------------------------------------------------------------------*/
+static int
+test_get(struct na_test_unit *client, na_addr_t addr, unsigned char *buf,
+    na_mem_handle_t local_handle, na_mem_handle_t remote_handle)
+{
+    struct na_test_unit_cb_info cb_info;
+    size_t i;
+
+    memset(&cb_info, 0, sizeof(cb_info));
+    memset(buf, 0, NA_TEST_RMA_SIZE);
+    NA_Get(client->na_class, client->context, na_test_unit_cb, &cb_info,
+        local_handle, 0, remote_handle, 0, NA_TEST_RMA_SIZE, addr, 0,
+        NA_OP_ID_IGNORE);
+    if (na_test_unit_progress(client, &cb_info.completed, 1) != NA_SUCCESS
+        || cb_info.ret != NA_SUCCESS) {
+        fprintf(stderr, "Error: get failed\n");
+        return EXIT_FAILURE;
+    }
+    for (i = 0; i < NA_TEST_RMA_SIZE; i++)
+        if (buf[i] != NA_TEST_GET_VALUE(i)) {
+            fprintf(stderr, "Error: get data does not match at %zu\n", i);
+            return EXIT_FAILURE;
+        }
+
+    /* Chunks of a transfer at offsets cover exactly the requested range */
+    memset(buf, 0, NA_TEST_RMA_SIZE);
+    NA_Get(client->na_class, client->context, na_test_unit_cb, &cb_info,
+        local_handle, NA_TEST_LOCAL_OFFSET, remote_handle,
+        NA_TEST_REMOTE_OFFSET, NA_TEST_LENGTH, addr, 0, NA_OP_ID_IGNORE);
+    if (na_test_unit_progress(client, &cb_info.completed, 2) != NA_SUCCESS
+        || cb_info.ret != NA_SUCCESS) {
+        fprintf(stderr, "Error: get at offset failed\n");
+        return EXIT_FAILURE;
+    }
+    for (i = 0; i < NA_TEST_RMA_SIZE; i++) {
+        unsigned char value = (i >= NA_TEST_LOCAL_OFFSET
+            && i < NA_TEST_LOCAL_OFFSET + NA_TEST_LENGTH) ?
+            NA_TEST_GET_VALUE(i - NA_TEST_LOCAL_OFFSET
+                + NA_TEST_REMOTE_OFFSET) : 0;
+
+        if (buf[i] != value) {
+            fprintf(stderr, "Error: get at offset does not match at %zu\n",
+                i);
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+test_error(struct na_test_unit *client, na_addr_t addr,
+    na_mem_handle_t local_handle, na_mem_handle_t bad_handle)
+{
+    struct na_test_unit_cb_info cb_info;
+
+    /* Failure of one chunk fails the whole operation */
+    memset(&cb_info, 0, sizeof(cb_info));
+    NA_Get(client->na_class, client->context, na_test_unit_cb, &cb_info,
+        local_handle, 0, bad_handle, 0, NA_TEST_BAD_SIZE, addr, 0,
+        NA_OP_ID_IGNORE);
+    if (na_test_unit_progress(client, &cb_info.completed, 1) != NA_SUCCESS
+        || cb_info.ret == NA_SUCCESS) {
+        fprintf(stderr, "Error: get from unmapped memory did not fail\n");
+        return EXIT_FAILURE;
+    }
+
+    memset(&cb_info, 0, sizeof(cb_info));
+    NA_Put(client->na_class, client->context, na_test_unit_cb, &cb_info,
+        local_handle, 0, bad_handle, 0, NA_TEST_BAD_SIZE, addr, 0,
+        NA_OP_ID_IGNORE);
+    if (na_test_unit_progress(client, &cb_info.completed, 1) != NA_SUCCESS
+        || cb_info.ret == NA_SUCCESS) {
+        fprintf(stderr, "Error: put to unmapped memory did not fail\n");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+test_client(int read_fd, int write_fd)
+{
+    struct na_test_unit client;
+    struct na_test_unit_cb_info cb_info;
+    struct na_test_handles test_handles;
+    na_mem_handle_t local_handle = NA_MEM_HANDLE_NULL,
+        remote_handle = NA_MEM_HANDLE_NULL, bad_handle = NA_MEM_HANDLE_NULL;
+    unsigned char *buf;
+    size_t i;
+    int rc = EXIT_FAILURE;
+
+    if (read(read_fd, &test_handles, sizeof(test_handles))
+        != sizeof(test_handles)) {
+        fprintf(stderr, "Error: could not read server handles\n");
+        return EXIT_FAILURE;
+    }
+    buf = (unsigned char *) malloc(NA_TEST_RMA_SIZE);
+    if (!buf) {
+        fprintf(stderr, "Error: could not allocate client buffer\n");
+        return EXIT_FAILURE;
+    }
+
+    client.na_class = NA_Initialize(NA_TEST_INFO, NA_FALSE);
+    if (!client.na_class) {
+        fprintf(stderr, "Error: could not initialize client\n");
+        goto done;
+    }
+    client.context = NA_Context_create(client.na_class);
+    if (!client.context) {
+        fprintf(stderr, "Error: could not create client context\n");
+        goto done;
+    }
+
+    memset(&cb_info, 0, sizeof(cb_info));
+    NA_Addr_lookup(client.na_class, client.context, na_test_unit_cb, &cb_info,
+        test_handles.addr_string, NA_OP_ID_IGNORE);
+    if (na_test_unit_progress(&client, &cb_info.completed, 1) != NA_SUCCESS
+        || cb_info.ret != NA_SUCCESS) {
+        fprintf(stderr, "Error: could not look up server address\n");
+        goto done;
+    }
+
+    NA_Mem_handle_create(client.na_class, buf, NA_TEST_RMA_SIZE,
+        NA_MEM_READWRITE, &local_handle);
+    NA_Mem_register(client.na_class, local_handle);
+    if (NA_Mem_handle_deserialize(client.na_class, &remote_handle,
+        test_handles.buf, test_handles.buf_size) != NA_SUCCESS
+        || NA_Mem_handle_deserialize(client.na_class, &bad_handle,
+        test_handles.bad_buf, test_handles.bad_buf_size) != NA_SUCCESS) {
+        fprintf(stderr, "Error: could not deserialize server handles\n");
+        goto done;
+    }
+
+    if (test_get(&client, cb_info.addr, buf, local_handle, remote_handle)
+        != EXIT_SUCCESS
+        || test_error(&client, cb_info.addr, local_handle, bad_handle)
+        != EXIT_SUCCESS)
+        goto done;
+
+    /* Finalize while chunks of the put may still be copied, finalize waits
+     * for them (the context is not destroyed as its completion queue is not
+     * empty once the put completes) */
+    for (i = 0; i < NA_TEST_RMA_SIZE; i++)
+        buf[i] = NA_TEST_PUT_VALUE(i);
+    if (NA_Put(client.na_class, client.context, na_test_unit_cb, &cb_info,
+        local_handle, 0, remote_handle, 0, NA_TEST_RMA_SIZE, cb_info.addr, 0,
+        NA_OP_ID_IGNORE) != NA_SUCCESS) {
+        fprintf(stderr, "Error: could not post put\n");
+        goto done;
+    }
+    NA_Mem_handle_free(client.na_class, bad_handle);
+    NA_Mem_handle_free(client.na_class, remote_handle);
+    NA_Addr_free(client.na_class, cb_info.addr);
+    if (NA_Finalize(client.na_class) != NA_SUCCESS) {
+        fprintf(stderr, "Error: could not finalize with put in flight\n");
+        client.na_class = NULL;
+        goto done;
+    }
+    client.na_class = NULL;
+
+    rc = EXIT_SUCCESS;
+
+done:
+    if (client.na_class) {
+        if (bad_handle != NA_MEM_HANDLE_NULL)
+            NA_Mem_handle_free(client.na_class, bad_handle);
+        if (remote_handle != NA_MEM_HANDLE_NULL)
+            NA_Mem_handle_free(client.na_class, remote_handle);
+        if (cb_info.addr)
+            NA_Addr_free(client.na_class, cb_info.addr);
+        if (client.context)
+            NA_Context_destroy(client.na_class, client.context);
+        NA_Finalize(client.na_class);
+    }
+    free(buf);
+
+    /* Server checks put data once the client is gone */
+    if (write(write_fd, &rc, sizeof(rc)) != sizeof(rc))
+        rc = EXIT_FAILURE;
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+test_server(int read_fd, int write_fd)
+{
+    na_class_t *na_class;
+    struct na_test_handles test_handles;
+    na_size_t addr_string_size = sizeof(test_handles.addr_string);
+    na_mem_handle_t mem_handle = NA_MEM_HANDLE_NULL,
+        bad_handle = NA_MEM_HANDLE_NULL;
+    na_addr_t self_addr;
+    unsigned char *buf = NULL;
+    void *bad_buf = MAP_FAILED;
+    size_t i;
+    int client_rc, rc = EXIT_FAILURE;
+
+    na_class = NA_Initialize(NA_TEST_INFO, NA_TRUE);
+    if (!na_class) {
+        fprintf(stderr, "Error: could not initialize server\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Regular memory, transfers go through CMA */
+    buf = (unsigned char *) malloc(NA_TEST_RMA_SIZE);
+    bad_buf = mmap(NULL, NA_TEST_BAD_SIZE, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (!buf || bad_buf == MAP_FAILED) {
+        fprintf(stderr, "Error: could not allocate server buffers\n");
+        goto done;
+    }
+    for (i = 0; i < NA_TEST_RMA_SIZE; i++)
+        buf[i] = NA_TEST_GET_VALUE(i);
+    NA_Mem_handle_create(na_class, buf, NA_TEST_RMA_SIZE, NA_MEM_READWRITE,
+        &mem_handle);
+    NA_Mem_register(na_class, mem_handle);
+    NA_Mem_handle_create(na_class, bad_buf, NA_TEST_BAD_SIZE,
+        NA_MEM_READWRITE, &bad_handle);
+    NA_Mem_register(na_class, bad_handle);
+
+    memset(&test_handles, 0, sizeof(test_handles));
+    NA_Addr_self(na_class, &self_addr);
+    NA_Addr_to_string(na_class, test_handles.addr_string, &addr_string_size,
+        self_addr);
+    NA_Addr_free(na_class, self_addr);
+    test_handles.buf_size = NA_Mem_handle_get_serialize_size(na_class,
+        mem_handle);
+    test_handles.bad_buf_size = NA_Mem_handle_get_serialize_size(na_class,
+        bad_handle);
+    if (test_handles.buf_size > sizeof(test_handles.buf)
+        || test_handles.bad_buf_size > sizeof(test_handles.bad_buf)
+        || NA_Mem_handle_serialize(na_class, test_handles.buf,
+            test_handles.buf_size, mem_handle) != NA_SUCCESS
+        || NA_Mem_handle_serialize(na_class, test_handles.bad_buf,
+            test_handles.bad_buf_size, bad_handle) != NA_SUCCESS) {
+        fprintf(stderr, "Error: could not serialize memory handles\n");
+        goto done;
+    }
+
+    /* Second half of that memory goes away */
+    munmap((char *) bad_buf + NA_TEST_BAD_SIZE / 2, NA_TEST_BAD_SIZE / 2);
+
+    if (write(write_fd, &test_handles, sizeof(test_handles))
+        != sizeof(test_handles)) {
+        fprintf(stderr, "Error: could not write server handles\n");
+        goto done;
+    }
+
+    if (read(read_fd, &client_rc, sizeof(client_rc)) != sizeof(client_rc)
+        || client_rc != EXIT_SUCCESS)
+        goto done;
+    for (i = 0; i < NA_TEST_RMA_SIZE; i++)
+        if (buf[i] != NA_TEST_PUT_VALUE(i)) {
+            fprintf(stderr, "Error: put data does not match at %zu\n", i);
+            goto done;
+        }
+
+    rc = EXIT_SUCCESS;
+
+done:
+    if (bad_handle != NA_MEM_HANDLE_NULL) {
+        NA_Mem_deregister(na_class, bad_handle);
+        NA_Mem_handle_free(na_class, bad_handle);
+    }
+    if (mem_handle != NA_MEM_HANDLE_NULL) {
+        NA_Mem_deregister(na_class, mem_handle);
+        NA_Mem_handle_free(na_class, mem_handle);
+    }
+    if (bad_buf != MAP_FAILED)
+        munmap(bad_buf, NA_TEST_BAD_SIZE / 2);
+    free(buf);
+    NA_Finalize(na_class);
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+int
+main(void)
+{
+    int to_client[2], to_server[2], status, rc;
+    pid_t pid;
+
+    if (pipe(to_client) != 0 || pipe(to_server) != 0) {
+        fprintf(stderr, "Error: could not create pipes\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Fork before initializing NA so that nothing is shared */
+    pid = fork();
+    if (pid < 0) {
+        fprintf(stderr, "Error: could not fork\n");
+        return EXIT_FAILURE;
+    }
+    if (pid == 0) {
+        close(to_client[1]);
+        close(to_server[0]);
+        rc = test_client(to_client[0], to_server[1]);
+        close(to_client[0]);
+        close(to_server[1]);
+        _exit(rc);
+    }
+
+    close(to_client[0]);
+    close(to_server[1]);
+    rc = test_server(to_server[0], to_client[1]);
+    close(to_server[0]);
+    close(to_client[1]);
+    if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status)
+        || WEXITSTATUS(status) != EXIT_SUCCESS) {
+        fprintf(stderr, "Error: client failed\n");
+        rc = EXIT_FAILURE;
+    }
+
+    return rc;
+}
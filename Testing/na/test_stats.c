@@ -0,0 +1,260 @@
+/*
+ * Copyright (C) 2013-2019 Argonne National Laboratory, Department of Energy,
+ *                    UChicago Argonne, LLC and The HDF Group.
+ * All rights reserved.
+ *
+ * The full copyright notice, including terms governing use, modification,
+ * and redistribution, is contained in the COPYING file that can be
+ * found at the root of the source code distribution tree.
+ */
+
+#include "na_test.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/****************/
+/* Local Macros */
+/****************/
+
+#define NA_TEST_SERVER_INFO     "inproc://"
+#define NA_TEST_CLIENT_INFO     "inproc+inproc://"
+
+#define NA_TEST_MSG_COUNT       8
+#define NA_TEST_MSG_SIZE        64
+
+/* Puts issued so that the byte count exceeds 32 bits */
+#define NA_TEST_RMA_SIZE        (16 << 20)
+#define NA_TEST_RMA_COUNT       257
+
+#define NA_TEST_TAG             42
+
+/*---------------------------------------------------------------------------*/
+static na_uint64_t
+na_test_latency_count(const struct na_stats *stats, na_cb_type_t type)
+{
+    na_uint64_t count = 0;
+    int i;
+
+    for (i = 0; i < NA_STATS_HIST_BUCKETS; i++)
+        count += stats->latency[type][i];
+
+    return count;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+test_msg_stats(struct na_test_unit *server, struct na_test_unit *client,
+    na_addr_t addr)
+{
+    struct na_test_unit_cb_info cb_info;
+    struct na_stats stats;
+    char buf[NA_TEST_MSG_SIZE];
+    na_op_id_t op_id;
+    int i;
+
+    /* Messages arrive before receives are posted */
+    memset(&cb_info, 0, sizeof(cb_info));
+    for (i = 0; i < NA_TEST_MSG_COUNT; i++)
+        NA_Msg_send_unexpected(client->na_class, client->context,
+            na_test_unit_cb, &cb_info, buf, sizeof(buf), NULL, addr, 0,
+            NA_TEST_TAG, NA_OP_ID_IGNORE);
+    if (na_test_unit_progress(client, &cb_info.completed, NA_TEST_MSG_COUNT)
+        != NA_SUCCESS)
+        return EXIT_FAILURE;
+
+    op_id = NA_Op_create(server->na_class);
+    for (i = 0; i < NA_TEST_MSG_COUNT; i++) {
+        memset(&cb_info, 0, sizeof(cb_info));
+        NA_Msg_recv_unexpected(server->na_class, server->context,
+            na_test_unit_cb, &cb_info, buf, sizeof(buf), NULL, &op_id);
+        if (na_test_unit_progress(server, &cb_info.completed, 1)
+            != NA_SUCCESS) {
+            NA_Op_destroy(server->na_class, op_id);
+            return EXIT_FAILURE;
+        }
+        NA_Addr_free(server->na_class, cb_info.addr);
+    }
+
+    /* One more receive that is canceled */
+    memset(&cb_info, 0, sizeof(cb_info));
+    NA_Msg_recv_unexpected(server->na_class, server->context, na_test_unit_cb,
+        &cb_info, buf, sizeof(buf), NULL, &op_id);
+    NA_Cancel(server->na_class, server->context, op_id);
+    if (na_test_unit_progress(server, &cb_info.completed, 1) != NA_SUCCESS)
+        return EXIT_FAILURE;
+    NA_Op_destroy(server->na_class, op_id);
+
+    if (NA_Get_stats(client->context, &stats) != NA_SUCCESS) {
+        fprintf(stderr, "Error: could not get client stats\n");
+        return EXIT_FAILURE;
+    }
+    if (stats.posted[NA_CB_SEND_UNEXPECTED] != NA_TEST_MSG_COUNT
+        || stats.completed[NA_CB_SEND_UNEXPECTED] != NA_TEST_MSG_COUNT
+        || na_test_latency_count(&stats, NA_CB_SEND_UNEXPECTED)
+            != NA_TEST_MSG_COUNT
+        || stats.bytes_sent != NA_TEST_MSG_COUNT * NA_TEST_MSG_SIZE) {
+        fprintf(stderr, "Error: unexpected send stats do not match\n");
+        return EXIT_FAILURE;
+    }
+
+    if (NA_Get_stats(server->context, &stats) != NA_SUCCESS) {
+        fprintf(stderr, "Error: could not get server stats\n");
+        return EXIT_FAILURE;
+    }
+    if (stats.posted[NA_CB_RECV_UNEXPECTED] != NA_TEST_MSG_COUNT + 1
+        || stats.completed[NA_CB_RECV_UNEXPECTED] != NA_TEST_MSG_COUNT
+        || stats.canceled[NA_CB_RECV_UNEXPECTED] != 1
+        || stats.errors[NA_CB_RECV_UNEXPECTED] != 0
+        || stats.cancel_count != 1
+        || stats.bytes_received != NA_TEST_MSG_COUNT * NA_TEST_MSG_SIZE
+        || stats.completion_depth != 0
+        || stats.completion_depth_max == 0) {
+        fprintf(stderr, "Error: unexpected receive stats do not match\n");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+test_rma_stats(struct na_test_unit *server, struct na_test_unit *client,
+    na_addr_t addr)
+{
+    struct na_test_unit_cb_info cb_info;
+    struct na_stats stats;
+    char *server_buf, *client_buf;
+    na_mem_handle_t server_handle = NA_MEM_HANDLE_NULL,
+        client_handle = NA_MEM_HANDLE_NULL;
+    int i, rc = EXIT_SUCCESS;
+
+    server_buf = (char *) calloc(1, NA_TEST_RMA_SIZE);
+    client_buf = (char *) calloc(1, NA_TEST_RMA_SIZE);
+    if (!server_buf || !client_buf) {
+        fprintf(stderr, "Error: could not allocate RMA buffers\n");
+        rc = EXIT_FAILURE;
+        goto done;
+    }
+
+    /* Both classes live in the same process, handles can be shared */
+    NA_Mem_handle_create(server->na_class, server_buf, NA_TEST_RMA_SIZE,
+        NA_MEM_READWRITE, &server_handle);
+    NA_Mem_register(server->na_class, server_handle);
+    NA_Mem_handle_create(client->na_class, client_buf, NA_TEST_RMA_SIZE,
+        NA_MEM_READWRITE, &client_handle);
+    NA_Mem_register(client->na_class, client_handle);
+
+    memset(&cb_info, 0, sizeof(cb_info));
+    for (i = 0; i < NA_TEST_RMA_COUNT; i++) {
+        NA_Put(client->na_class, client->context, na_test_unit_cb, &cb_info,
+            client_handle, 0, server_handle, 0, NA_TEST_RMA_SIZE, addr, 0,
+            NA_OP_ID_IGNORE);
+        if (na_test_unit_progress(client, &cb_info.completed, i + 1)
+            != NA_SUCCESS) {
+            rc = EXIT_FAILURE;
+            goto done;
+        }
+    }
+
+    /* Byte count must not wrap past 32 bits */
+    if (NA_Get_stats(client->context, &stats) != NA_SUCCESS) {
+        fprintf(stderr, "Error: could not get client stats\n");
+        rc = EXIT_FAILURE;
+        goto done;
+    }
+    if (stats.completed[NA_CB_PUT] != NA_TEST_RMA_COUNT
+        || stats.bytes_sent - NA_TEST_MSG_COUNT * NA_TEST_MSG_SIZE
+            != (na_uint64_t) NA_TEST_RMA_COUNT * NA_TEST_RMA_SIZE) {
+        fprintf(stderr, "Error: put stats do not match (%llu bytes sent)\n",
+            (unsigned long long) stats.bytes_sent);
+        rc = EXIT_FAILURE;
+    }
+
+done:
+    if (client_handle != NA_MEM_HANDLE_NULL) {
+        NA_Mem_deregister(client->na_class, client_handle);
+        NA_Mem_handle_free(client->na_class, client_handle);
+    }
+    if (server_handle != NA_MEM_HANDLE_NULL) {
+        NA_Mem_deregister(server->na_class, server_handle);
+        NA_Mem_handle_free(server->na_class, server_handle);
+    }
+    free(server_buf);
+    free(client_buf);
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+int
+main(void)
+{
+    struct na_test_unit server = { NULL, NULL }, client = { NULL, NULL };
+    struct na_test_unit_cb_info cb_info;
+    struct na_stats stats;
+    char addr_string[64];
+    na_size_t addr_string_size = sizeof(addr_string);
+    na_addr_t self_addr, addr = NA_ADDR_NULL;
+    int rc = EXIT_FAILURE;
+
+    server.na_class = NA_Initialize(NA_TEST_SERVER_INFO, NA_TRUE);
+    client.na_class = NA_Initialize(NA_TEST_CLIENT_INFO, NA_FALSE);
+    if (!server.na_class || !client.na_class) {
+        fprintf(stderr, "Error: could not initialize NA\n");
+        goto done;
+    }
+    server.context = NA_Context_create(server.na_class);
+    client.context = NA_Context_create(client.na_class);
+    if (!server.context || !client.context) {
+        fprintf(stderr, "Error: could not create NA contexts\n");
+        goto done;
+    }
+
+#ifndef NA_HAS_COLLECT_STATS
+    /* Stats are not collected */
+    if (NA_Get_stats(client.context, &stats) != NA_OPNOTSUPPORTED) {
+        fprintf(stderr, "Error: stats should not be supported\n");
+        goto done;
+    }
+    rc = EXIT_SUCCESS;
+    goto done;
+#endif
+
+    /* Fresh context has no stats */
+    if (NA_Get_stats(client.context, &stats) != NA_SUCCESS
+        || stats.posted[NA_CB_SEND_UNEXPECTED] != 0 || stats.bytes_sent != 0) {
+        fprintf(stderr, "Error: stats of new context are not zero\n");
+        goto done;
+    }
+
+    NA_Addr_self(server.na_class, &self_addr);
+    NA_Addr_to_string(server.na_class, addr_string, &addr_string_size,
+        self_addr);
+    NA_Addr_free(server.na_class, self_addr);
+    memset(&cb_info, 0, sizeof(cb_info));
+    NA_Addr_lookup(client.na_class, client.context, na_test_unit_cb, &cb_info,
+        addr_string, NA_OP_ID_IGNORE);
+    if (na_test_unit_progress(&client, &cb_info.completed, 1) != NA_SUCCESS)
+        goto done;
+    addr = cb_info.addr;
+
+    rc = test_msg_stats(&server, &client, addr);
+    if (rc == EXIT_SUCCESS)
+        rc = test_rma_stats(&server, &client, addr);
+
+done:
+    if (addr)
+        NA_Addr_free(client.na_class, addr);
+    if (client.context)
+        NA_Context_destroy(client.na_class, client.context);
+    if (server.context)
+        NA_Context_destroy(server.na_class, server.context);
+    if (client.na_class)
+        NA_Finalize(client.na_class);
+    if (server.na_class)
+        NA_Finalize(server.na_class);
+
+    return rc;
+}
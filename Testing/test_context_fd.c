@@ -0,0 +1,358 @@
+/*
+ * Copyright (C) 2013-2019 Argonne National Laboratory, Department of Energy,
+ *                    UChicago Argonne, LLC and The HDF Group.
+ * All rights reserved.
+ *
+ * The full copyright notice, including terms governing use, modification,
+ * and redistribution, is contained in the COPYING file that can be
+ * found at the root of the source code distribution tree.
+ */
+
+#include "mercury_core.h"
+
+#include "mercury_atomic.h"
+#include "mercury_thread.h"
+
+#include "mercury_test_config.h"
+
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/****************/
+/* Local Macros */
+/****************/
+
+#define HG_TEST_INFO_STRING     "inproc"
+#define HG_TEST_RPC_ID          1
+#define HG_TEST_RPC_COUNT       100
+
+/* Max time to wait for the descriptor once try_wait allowed blocking */
+#define HG_TEST_POLL_TIMEOUT    5000 /* 5 s */
+
+/************************************/
+/* Local Type and Struct Definition */
+/************************************/
+
+struct hg_test_info {
+    hg_core_class_t *hg_core_class;
+    hg_core_context_t *context;
+    int fd;
+};
+
+/*******************/
+/* Local Variables */
+/*******************/
+
+static int hg_test_completed_g = 0;
+static hg_atomic_int32_t hg_test_handled_g;    /* RPCs handled by server */
+static hg_atomic_int32_t hg_test_error_g;      /* Server thread failed */
+
+/*---------------------------------------------------------------------------*/
+static hg_return_t
+hg_test_respond_cb(const struct hg_core_cb_info *callback_info)
+{
+    (void) callback_info;
+    return HG_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static hg_return_t
+hg_test_rpc_cb(hg_core_handle_t handle)
+{
+    hg_return_t ret;
+
+    ret = HG_Core_respond(handle, hg_test_respond_cb, NULL, 0, 0);
+    HG_Core_destroy(handle);
+    hg_atomic_incr32(&hg_test_handled_g);
+
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static hg_return_t
+hg_test_lookup_cb(const struct hg_core_cb_info *callback_info)
+{
+    hg_core_addr_t *addr = (hg_core_addr_t *) callback_info->arg;
+
+    *addr = callback_info->info.lookup.addr;
+    hg_test_completed_g++;
+
+    return HG_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static hg_return_t
+hg_test_forward_cb(const struct hg_core_cb_info *callback_info)
+{
+    if (callback_info->ret != HG_SUCCESS)
+        fprintf(stderr, "Error: forward completed with %d\n",
+            (int) callback_info->ret);
+    else
+        hg_test_completed_g++;
+
+    return HG_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static unsigned int
+hg_test_progress(struct hg_test_info *info)
+{
+    unsigned int actual_count, total_count = 0;
+
+    HG_Core_progress(info->context, 0);
+    do {
+        actual_count = 0;
+        HG_Core_trigger(info->context, 0, 16, &actual_count);
+        total_count += actual_count;
+    } while (actual_count);
+
+    return total_count;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+hg_test_readable(struct hg_test_info *info)
+{
+    struct pollfd pollfd;
+
+    pollfd.fd = info->fd;
+    pollfd.events = POLLIN;
+    pollfd.revents = 0;
+
+    return poll(&pollfd, 1, 0) == 1 && (pollfd.revents & POLLIN);
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+hg_test_wait(struct hg_test_info *info)
+{
+    struct pollfd pollfd;
+
+    /* Once it is safe to block, the descriptor must signal pending work */
+    if (!HG_Core_context_try_wait(info->context))
+        return EXIT_SUCCESS;
+
+    pollfd.fd = info->fd;
+    pollfd.events = POLLIN;
+    pollfd.revents = 0;
+    if (poll(&pollfd, 1, HG_TEST_POLL_TIMEOUT) != 1
+        || !(pollfd.revents & POLLIN)) {
+        fprintf(stderr, "Error: descriptor did not become readable\n");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static HG_THREAD_RETURN_TYPE
+hg_test_server_thread(void *arg)
+{
+    hg_thread_ret_t thread_ret = (hg_thread_ret_t) 0;
+    struct hg_test_info *server = (struct hg_test_info *) arg;
+
+    /* Event loop that blocks on the descriptor whenever it is allowed to */
+    while (hg_atomic_get32(&hg_test_handled_g) < HG_TEST_RPC_COUNT) {
+        if (hg_test_wait(server) != EXIT_SUCCESS) {
+            hg_atomic_set32(&hg_test_error_g, 1);
+            break;
+        }
+        hg_test_progress(server);
+    }
+
+    hg_thread_exit(thread_ret);
+    return thread_ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+hg_test_init(struct hg_test_info *info, hg_bool_t listen,
+    na_progress_mode_t progress_mode)
+{
+    struct hg_init_info hg_init_info;
+
+    memset(&hg_init_info, 0, sizeof(hg_init_info));
+    hg_init_info.na_init_info.progress_mode = progress_mode;
+    info->hg_core_class = HG_Core_init_opt(HG_TEST_INFO_STRING, listen,
+        &hg_init_info);
+    if (!info->hg_core_class) {
+        fprintf(stderr, "Error: could not initialize class\n");
+        return EXIT_FAILURE;
+    }
+    HG_Core_register(info->hg_core_class, HG_TEST_RPC_ID,
+        listen ? hg_test_rpc_cb : NULL);
+    info->context = HG_Core_context_create(info->hg_core_class);
+    if (!info->context) {
+        fprintf(stderr, "Error: could not create context\n");
+        return EXIT_FAILURE;
+    }
+    info->fd = HG_Core_context_get_fd(info->context);
+
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+hg_test_finalize(struct hg_test_info *info)
+{
+    int rc = EXIT_SUCCESS;
+
+    if (info->context && HG_Core_context_destroy(info->context)
+        != HG_SUCCESS) {
+        fprintf(stderr, "Error: could not destroy context\n");
+        rc = EXIT_FAILURE;
+    }
+    if (info->hg_core_class && HG_Core_finalize(info->hg_core_class)
+        != HG_SUCCESS) {
+        fprintf(stderr, "Error: could not finalize class\n");
+        rc = EXIT_FAILURE;
+    }
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+test_no_block(void)
+{
+    struct hg_test_info info;
+    int rc = EXIT_SUCCESS;
+
+    memset(&info, 0, sizeof(info));
+    if (hg_test_init(&info, HG_FALSE, NA_NO_BLOCK) != EXIT_SUCCESS) {
+        hg_test_finalize(&info);
+        return EXIT_FAILURE;
+    }
+
+    /* Busy spinning contexts never block */
+    if (info.fd >= 0 || HG_Core_context_try_wait(info.context)) {
+        fprintf(stderr, "Error: NA_NO_BLOCK context exposes a descriptor\n");
+        rc = EXIT_FAILURE;
+    }
+    if (HG_Core_context_get_fd(NULL) >= 0
+        || HG_Core_context_try_wait(NULL)) {
+        fprintf(stderr, "Error: NULL context exposes a descriptor\n");
+        rc = EXIT_FAILURE;
+    }
+
+    if (hg_test_finalize(&info) != EXIT_SUCCESS)
+        rc = EXIT_FAILURE;
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+test_forward(struct hg_test_info *server, struct hg_test_info *client,
+    hg_core_addr_t addr)
+{
+    hg_core_handle_t handle;
+    hg_thread_t thread;
+    int i, rc = EXIT_SUCCESS;
+
+    hg_atomic_init32(&hg_test_handled_g, 0);
+    hg_atomic_init32(&hg_test_error_g, 0);
+    hg_thread_create(&thread, hg_test_server_thread, server);
+
+    HG_Core_create(client->context, addr, HG_TEST_RPC_ID, &handle);
+    for (i = 0; i < HG_TEST_RPC_COUNT && rc == EXIT_SUCCESS; i++) {
+        hg_test_completed_g = 0;
+        if (HG_Core_reset(handle, addr, HG_TEST_RPC_ID) != HG_SUCCESS
+            || HG_Core_forward(handle, hg_test_forward_cb, NULL, 0, 0)
+            != HG_SUCCESS) {
+            fprintf(stderr, "Error: could not forward RPC\n");
+            rc = EXIT_FAILURE;
+            break;
+        }
+
+        /* Response sent from the server thread wakes up the client
+         * descriptor, queued completion must keep it readable and prevent
+         * try_wait from blocking until it is triggered */
+        while (rc == EXIT_SUCCESS && !hg_test_completed_g) {
+            rc = hg_test_wait(client);
+            if (rc != EXIT_SUCCESS)
+                break;
+            if (HG_Core_progress(client->context, 0) == HG_SUCCESS) {
+                if (HG_Core_context_try_wait(client->context)) {
+                    fprintf(stderr, "Error: try_wait with queued completion\n");
+                    rc = EXIT_FAILURE;
+                    break;
+                }
+                if (!hg_test_readable(client)) {
+                    fprintf(stderr,
+                        "Error: queued completion left descriptor idle\n");
+                    rc = EXIT_FAILURE;
+                    break;
+                }
+            }
+            hg_test_progress(client);
+        }
+    }
+    HG_Core_destroy(handle);
+
+    if (rc != EXIT_SUCCESS)
+        hg_atomic_set32(&hg_test_handled_g, HG_TEST_RPC_COUNT);
+    hg_thread_join(thread);
+    if (hg_atomic_get32(&hg_test_error_g))
+        rc = EXIT_FAILURE;
+
+    /* Nothing left to do, blocking is safe */
+    hg_test_progress(server);
+    hg_test_progress(client);
+    if (rc == EXIT_SUCCESS && (!HG_Core_context_try_wait(server->context)
+        || !HG_Core_context_try_wait(client->context))) {
+        fprintf(stderr, "Error: try_wait refused to block while idle\n");
+        rc = EXIT_FAILURE;
+    }
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+int
+main(void)
+{
+    struct hg_test_info server, client;
+    char addr_string[256];
+    hg_size_t addr_string_size = sizeof(addr_string);
+    hg_core_addr_t self_addr, addr = HG_CORE_ADDR_NULL;
+    int rc = EXIT_FAILURE;
+
+    memset(&server, 0, sizeof(server));
+    memset(&client, 0, sizeof(client));
+    if (hg_test_init(&server, HG_TRUE, 0) != EXIT_SUCCESS
+        || hg_test_init(&client, HG_FALSE, 0) != EXIT_SUCCESS)
+        goto done;
+    if (server.fd < 0 || client.fd < 0) {
+        fprintf(stderr, "Error: context does not expose a descriptor\n");
+        goto done;
+    }
+    HG_Core_context_post(server.context, 16, HG_TRUE);
+
+    HG_Core_addr_self(server.hg_core_class, &self_addr);
+    HG_Core_addr_to_string(server.hg_core_class, addr_string,
+        &addr_string_size, self_addr);
+    HG_Core_addr_free(server.hg_core_class, self_addr);
+    if (HG_Core_addr_lookup(client.context, hg_test_lookup_cb, &addr,
+        addr_string, HG_CORE_OP_ID_IGNORE) != HG_SUCCESS) {
+        fprintf(stderr, "Error: could not look up server address\n");
+        goto done;
+    }
+    while (!hg_test_completed_g)
+        hg_test_progress(&client);
+
+    rc = test_forward(&server, &client, addr);
+    if (rc == EXIT_SUCCESS)
+        rc = test_no_block();
+
+done:
+    if (addr)
+        HG_Core_addr_free(client.hg_core_class, addr);
+    if (hg_test_finalize(&client) != EXIT_SUCCESS
+        || hg_test_finalize(&server) != EXIT_SUCCESS)
+        rc = EXIT_FAILURE;
+
+    return rc;
+}
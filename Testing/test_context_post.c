@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2013-2019 Argonne National Laboratory, Department of Energy,
+ *                    UChicago Argonne, LLC and The HDF Group.
+ * All rights reserved.
+ *
+ * The full copyright notice, including terms governing use, modification,
+ * and redistribution, is contained in the COPYING file that can be
+ * found at the root of the source code distribution tree.
+ */
+
+#include "mercury_core.h"
+
+#include "mercury_test_config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/****************/
+/* Local Macros */
+/****************/
+
+/* Emulated link on top of the in-process plugin */
+#define HG_TEST_INFO_STRING     "emu+inproc+inproc://"
+
+/* Number of posts accepted by the emulated link before NA_AGAIN */
+#define HG_TEST_POST_LIMIT_ENV  "HG_NA_EMU_POST_LIMIT"
+
+/* Requests posted, more than one batch of unexpected receives */
+#define HG_TEST_REQUEST_COUNT   128
+
+/*---------------------------------------------------------------------------*/
+static int
+test_partial_post(const char *post_limit)
+{
+    hg_core_class_t *hg_core_class;
+    hg_core_context_t *context;
+    hg_return_t ret;
+
+    setenv(HG_TEST_POST_LIMIT_ENV, post_limit, 1);
+    hg_core_class = HG_Core_init(HG_TEST_INFO_STRING, HG_FALSE);
+    unsetenv(HG_TEST_POST_LIMIT_ENV);
+    if (!hg_core_class) {
+        fprintf(stderr, "Error: could not initialize HG core class\n");
+        return EXIT_FAILURE;
+    }
+
+    context = HG_Core_context_create(hg_core_class);
+    if (!context) {
+        fprintf(stderr, "Error: could not create HG core context\n");
+        HG_Core_finalize(hg_core_class);
+        return EXIT_FAILURE;
+    }
+
+    /* Posting stops part way through a batch */
+    ret = HG_Core_context_post(context, HG_TEST_REQUEST_COUNT, HG_TRUE);
+    if (ret == HG_SUCCESS) {
+        fprintf(stderr, "Error: post succeeded past limit of %s\n",
+            post_limit);
+        HG_Core_context_destroy(context);
+        HG_Core_finalize(hg_core_class);
+        return EXIT_FAILURE;
+    }
+
+    /* Posted handles are canceled, others must not be left behind */
+    ret = HG_Core_context_destroy(context);
+    if (ret != HG_SUCCESS) {
+        fprintf(stderr, "Error: could not destroy context after partial post "
+            "(%d)\n", (int) ret);
+        HG_Core_finalize(hg_core_class);
+        return EXIT_FAILURE;
+    }
+
+    ret = HG_Core_finalize(hg_core_class);
+    if (ret != HG_SUCCESS) {
+        fprintf(stderr, "Error: could not finalize HG core class (%d)\n",
+            (int) ret);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+int
+main(void)
+{
+    /* Failure within the first batch, then within the second one */
+    if (test_partial_post("10") != EXIT_SUCCESS)
+        return EXIT_FAILURE;
+    if (test_partial_post("100") != EXIT_SUCCESS)
+        return EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+}
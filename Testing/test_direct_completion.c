@@ -0,0 +1,306 @@
+/*
+ * Copyright (C) 2013-2019 Argonne National Laboratory, Department of Energy,
+ *                    UChicago Argonne, LLC and The HDF Group.
+ * All rights reserved.
+ *
+ * The full copyright notice, including terms governing use, modification,
+ * and redistribution, is contained in the COPYING file that can be
+ * found at the root of the source code distribution tree.
+ */
+
+#include "mercury_core.h"
+
+#include "mercury_test_config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/****************/
+/* Local Macros */
+/****************/
+
+#define HG_TEST_SERVER_INFO     "inproc"
+/* Emulated link on top of the in-process plugin */
+#define HG_TEST_CLIENT_INFO     "emu+inproc+inproc://"
+
+/* Number of posts accepted by the emulated link before NA_AGAIN */
+#define HG_TEST_POST_LIMIT_ENV  "HG_NA_EMU_POST_LIMIT"
+
+#define HG_TEST_RPC_ID          1
+#define HG_TEST_RPC_COUNT       100
+
+/************************************/
+/* Local Type and Struct Definition */
+/************************************/
+
+struct hg_test_info {
+    hg_core_class_t *hg_core_class;
+    hg_core_context_t *context;
+};
+
+/*******************/
+/* Local Variables */
+/*******************/
+
+static int hg_test_completed_g = 0;
+static hg_core_addr_t hg_test_addr_g = HG_CORE_ADDR_NULL;
+
+/*---------------------------------------------------------------------------*/
+static hg_return_t
+hg_test_respond_cb(const struct hg_core_cb_info *callback_info)
+{
+    (void) callback_info;
+    return HG_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static hg_return_t
+hg_test_rpc_cb(hg_core_handle_t handle)
+{
+    hg_return_t ret;
+
+    ret = HG_Core_respond(handle, hg_test_respond_cb, NULL, 0, 0);
+    HG_Core_destroy(handle);
+
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static hg_return_t
+hg_test_lookup_cb(const struct hg_core_cb_info *callback_info)
+{
+    hg_core_addr_t *addr = (hg_core_addr_t *) callback_info->arg;
+
+    *addr = callback_info->info.lookup.addr;
+    hg_test_completed_g++;
+
+    return HG_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static hg_return_t
+hg_test_forward_cb(const struct hg_core_cb_info *callback_info)
+{
+    if (callback_info->ret != HG_SUCCESS)
+        fprintf(stderr, "Error: forward completed with %d\n",
+            (int) callback_info->ret);
+    else
+        hg_test_completed_g++;
+
+    return HG_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+hg_test_progress(struct hg_test_info *server, struct hg_test_info *client)
+{
+    unsigned int actual_count;
+
+    if (server) {
+        HG_Core_progress(server->context, 0);
+        do {
+            actual_count = 0;
+            HG_Core_trigger(server->context, 0, 16, &actual_count);
+        } while (actual_count);
+    }
+    HG_Core_progress(client->context, 10);
+    do {
+        actual_count = 0;
+        HG_Core_trigger(client->context, 0, 16, &actual_count);
+    } while (actual_count);
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+hg_test_client_init(struct hg_test_info *client, const char *info_string,
+    const char *addr_string)
+{
+    struct hg_init_info hg_init_info;
+
+    memset(&hg_init_info, 0, sizeof(hg_init_info));
+    hg_init_info.na_direct_completion = HG_TRUE;
+    client->hg_core_class = HG_Core_init_opt(info_string, HG_FALSE,
+        &hg_init_info);
+    if (!client->hg_core_class) {
+        fprintf(stderr, "Error: could not initialize client class\n");
+        return EXIT_FAILURE;
+    }
+    HG_Core_register(client->hg_core_class, HG_TEST_RPC_ID, NULL);
+    client->context = HG_Core_context_create(client->hg_core_class);
+    if (!client->context) {
+        fprintf(stderr, "Error: could not create client context\n");
+        return EXIT_FAILURE;
+    }
+
+    hg_test_completed_g = 0;
+    if (HG_Core_addr_lookup(client->context, hg_test_lookup_cb,
+        &hg_test_addr_g, addr_string, HG_CORE_OP_ID_IGNORE) != HG_SUCCESS) {
+        fprintf(stderr, "Error: could not look up server address\n");
+        return EXIT_FAILURE;
+    }
+    while (hg_test_completed_g < 1)
+        hg_test_progress(NULL, client);
+    hg_test_completed_g = 0;
+
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+hg_test_client_finalize(struct hg_test_info *client)
+{
+    int rc = EXIT_SUCCESS;
+
+    if (hg_test_addr_g) {
+        HG_Core_addr_free(client->hg_core_class, hg_test_addr_g);
+        hg_test_addr_g = HG_CORE_ADDR_NULL;
+    }
+    if (HG_Core_context_destroy(client->context) != HG_SUCCESS) {
+        fprintf(stderr, "Error: could not destroy client context\n");
+        rc = EXIT_FAILURE;
+    }
+    if (HG_Core_finalize(client->hg_core_class) != HG_SUCCESS) {
+        fprintf(stderr, "Error: could not finalize client class\n");
+        rc = EXIT_FAILURE;
+    }
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+test_forward(struct hg_test_info *server, const char *addr_string)
+{
+    struct hg_test_info client;
+    hg_core_handle_t handle;
+    int i, rc;
+
+    /* RPCs complete through the client context completion queue */
+    rc = hg_test_client_init(&client, HG_TEST_SERVER_INFO, addr_string);
+    if (rc != EXIT_SUCCESS)
+        return rc;
+
+    HG_Core_create(client.context, hg_test_addr_g, HG_TEST_RPC_ID, &handle);
+    for (i = 0; i < HG_TEST_RPC_COUNT; i++) {
+        if (HG_Core_reset(handle, hg_test_addr_g, HG_TEST_RPC_ID) != HG_SUCCESS
+            || HG_Core_forward(handle, hg_test_forward_cb, NULL, 0, 0)
+            != HG_SUCCESS) {
+            fprintf(stderr, "Error: could not forward RPC\n");
+            rc = EXIT_FAILURE;
+            break;
+        }
+        while (hg_test_completed_g < i + 1)
+            hg_test_progress(server, &client);
+    }
+    HG_Core_destroy(handle);
+
+    if (hg_test_client_finalize(&client) != EXIT_SUCCESS)
+        rc = EXIT_FAILURE;
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+test_forward_retry(const char *addr_string)
+{
+    struct hg_test_info client;
+    hg_core_handle_t handle;
+    hg_core_addr_t addr = HG_CORE_ADDR_NULL;
+    hg_return_t ret;
+    int rc;
+
+    /* Recv of response is posted but send of request is not */
+    setenv(HG_TEST_POST_LIMIT_ENV, "1", 1);
+    rc = hg_test_client_init(&client, HG_TEST_CLIENT_INFO, addr_string);
+    unsetenv(HG_TEST_POST_LIMIT_ENV);
+    if (rc != EXIT_SUCCESS)
+        return rc;
+
+    HG_Core_create(client.context, hg_test_addr_g, HG_TEST_RPC_ID, &handle);
+
+    /* Queue a user callback ahead of the completion of the canceled recv */
+    if (HG_Core_addr_lookup(client.context, hg_test_lookup_cb, &addr,
+        addr_string, HG_CORE_OP_ID_IGNORE) != HG_SUCCESS) {
+        fprintf(stderr, "Error: could not look up server address\n");
+        rc = EXIT_FAILURE;
+        goto done;
+    }
+
+    ret = HG_Core_forward(handle, hg_test_forward_cb, NULL, 0, 0);
+    if (ret != HG_AGAIN) {
+        fprintf(stderr, "Error: forward returned %d instead of HG_AGAIN\n",
+            (int) ret);
+        rc = EXIT_FAILURE;
+        goto done;
+    }
+
+    /* Retrying must not run other callbacks from the completion queue */
+    ret = HG_Core_forward(handle, hg_test_forward_cb, NULL, 0, 0);
+    if (hg_test_completed_g != 0) {
+        fprintf(stderr, "Error: forward triggered user callbacks\n");
+        rc = EXIT_FAILURE;
+        goto done;
+    }
+    if (ret != HG_AGAIN) {
+        fprintf(stderr, "Error: retry returned %d instead of HG_AGAIN\n",
+            (int) ret);
+        rc = EXIT_FAILURE;
+        goto done;
+    }
+
+    /* Triggering completes the canceled recv and runs the queued callback */
+    while (hg_test_completed_g < 1)
+        hg_test_progress(NULL, &client);
+
+done:
+    HG_Core_destroy(handle);
+    if (addr)
+        HG_Core_addr_free(client.hg_core_class, addr);
+    if (hg_test_client_finalize(&client) != EXIT_SUCCESS)
+        rc = EXIT_FAILURE;
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+int
+main(void)
+{
+    struct hg_test_info server;
+    char addr_string[256];
+    hg_size_t addr_string_size = sizeof(addr_string);
+    hg_core_addr_t self_addr;
+    int rc;
+
+    server.hg_core_class = HG_Core_init(HG_TEST_SERVER_INFO, HG_TRUE);
+    if (!server.hg_core_class) {
+        fprintf(stderr, "Error: could not initialize server class\n");
+        return EXIT_FAILURE;
+    }
+    HG_Core_register(server.hg_core_class, HG_TEST_RPC_ID, hg_test_rpc_cb);
+    server.context = HG_Core_context_create(server.hg_core_class);
+    if (!server.context) {
+        fprintf(stderr, "Error: could not create server context\n");
+        HG_Core_finalize(server.hg_core_class);
+        return EXIT_FAILURE;
+    }
+    HG_Core_context_post(server.context, 16, HG_TRUE);
+    HG_Core_addr_self(server.hg_core_class, &self_addr);
+    HG_Core_addr_to_string(server.hg_core_class, addr_string,
+        &addr_string_size, self_addr);
+    HG_Core_addr_free(server.hg_core_class, self_addr);
+
+    rc = test_forward(&server, addr_string);
+    if (rc == EXIT_SUCCESS)
+        rc = test_forward_retry(addr_string);
+
+    if (HG_Core_context_destroy(server.context) != HG_SUCCESS
+        || HG_Core_finalize(server.hg_core_class) != HG_SUCCESS) {
+        fprintf(stderr, "Error: could not finalize server\n");
+        rc = EXIT_FAILURE;
+    }
+
+    return rc;
+}
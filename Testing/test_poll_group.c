@@ -0,0 +1,366 @@
+/*
+ * Copyright (C) 2013-2019 Argonne National Laboratory, Department of Energy,
+ *                    UChicago Argonne, LLC and The HDF Group.
+ * All rights reserved.
+ *
+ * The full copyright notice, including terms governing use, modification,
+ * and redistribution, is contained in the COPYING file that can be
+ * found at the root of the source code distribution tree.
+ */
+
+#include "mercury_core.h"
+
+#include "mercury_atomic.h"
+#include "mercury_thread.h"
+
+#include "mercury_test_config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/****************/
+/* Local Macros */
+/****************/
+
+#define HG_TEST_INFO_STRING     "inproc"
+#define HG_TEST_RPC_ID          1
+#define HG_TEST_RPC_COUNT       200
+#define HG_TEST_MAX_CONTEXTS    2
+
+/************************************/
+/* Local Type and Struct Definition */
+/************************************/
+
+struct hg_test_poll_group {
+    hg_core_class_t *server_class;
+    hg_core_class_t *client_class;
+    hg_core_context_t *server_context;
+    hg_core_context_t *client_context;
+    hg_core_poll_group_t *poll_group;
+    hg_core_addr_t addr;
+    hg_atomic_int32_t completed;    /* Client operations completed */
+    hg_atomic_int32_t stop;         /* Progress thread must exit */
+};
+
+/*---------------------------------------------------------------------------*/
+static hg_return_t
+hg_test_respond_cb(const struct hg_core_cb_info *callback_info)
+{
+    (void) callback_info;
+    return HG_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static hg_return_t
+hg_test_rpc_cb(hg_core_handle_t handle)
+{
+    hg_return_t ret;
+
+    ret = HG_Core_respond(handle, hg_test_respond_cb, NULL, 0, 0);
+    HG_Core_destroy(handle);
+
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static hg_return_t
+hg_test_lookup_cb(const struct hg_core_cb_info *callback_info)
+{
+    struct hg_test_poll_group *test =
+        (struct hg_test_poll_group *) callback_info->arg;
+
+    test->addr = callback_info->info.lookup.addr;
+    hg_atomic_incr32(&test->completed);
+
+    return HG_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static hg_return_t
+hg_test_forward_cb(const struct hg_core_cb_info *callback_info)
+{
+    struct hg_test_poll_group *test =
+        (struct hg_test_poll_group *) callback_info->arg;
+
+    if (callback_info->ret != HG_SUCCESS)
+        fprintf(stderr, "Error: forward completed with %d\n",
+            (int) callback_info->ret);
+    else
+        hg_atomic_incr32(&test->completed);
+
+    return HG_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static hg_return_t
+hg_test_poll_group_progress(struct hg_test_poll_group *test,
+    unsigned int timeout)
+{
+    hg_core_context_t *contexts[HG_TEST_MAX_CONTEXTS];
+    unsigned int count = 0, actual_count, i;
+    hg_return_t ret;
+
+    ret = HG_Core_poll_group_progress(test->poll_group, timeout, contexts,
+        HG_TEST_MAX_CONTEXTS, &count);
+    if (ret != HG_SUCCESS)
+        return ret;
+
+    for (i = 0; i < count; i++)
+        do {
+            actual_count = 0;
+            HG_Core_trigger(contexts[i], 0, 16, &actual_count);
+        } while (actual_count);
+
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static hg_return_t
+hg_test_wait(struct hg_test_poll_group *test, int target)
+{
+    while (hg_atomic_get32(&test->completed) < target) {
+        hg_return_t ret = hg_test_poll_group_progress(test, 100);
+        if (ret != HG_SUCCESS && ret != HG_TIMEOUT)
+            return ret;
+    }
+
+    return HG_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static HG_THREAD_RETURN_TYPE
+hg_test_progress_thread(void *arg)
+{
+    hg_thread_ret_t thread_ret = (hg_thread_ret_t) 0;
+    struct hg_test_poll_group *test = (struct hg_test_poll_group *) arg;
+
+    while (!hg_atomic_get32(&test->stop))
+        hg_test_poll_group_progress(test, 1);
+
+    hg_thread_exit(thread_ret);
+    return thread_ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+hg_test_forward(struct hg_test_poll_group *test, hg_core_handle_t handle)
+{
+    hg_return_t ret;
+
+    ret = HG_Core_reset(handle, test->addr, HG_TEST_RPC_ID);
+    if (ret != HG_SUCCESS) {
+        fprintf(stderr, "Error: could not reset handle (%d)\n", (int) ret);
+        return EXIT_FAILURE;
+    }
+    ret = HG_Core_forward(handle, hg_test_forward_cb, test, 0, 0);
+    if (ret != HG_SUCCESS) {
+        fprintf(stderr, "Error: could not forward handle (%d)\n", (int) ret);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+hg_test_init(struct hg_test_poll_group *test)
+{
+    char addr_string[256];
+    hg_size_t addr_string_size = sizeof(addr_string);
+    hg_core_addr_t self_addr;
+    hg_return_t ret;
+
+    hg_atomic_init32(&test->completed, 0);
+    hg_atomic_init32(&test->stop, 0);
+
+    test->server_class = HG_Core_init(HG_TEST_INFO_STRING, HG_TRUE);
+    test->client_class = HG_Core_init(HG_TEST_INFO_STRING, HG_FALSE);
+    if (!test->server_class || !test->client_class) {
+        fprintf(stderr, "Error: could not initialize HG core classes\n");
+        return EXIT_FAILURE;
+    }
+    HG_Core_register(test->server_class, HG_TEST_RPC_ID, hg_test_rpc_cb);
+    HG_Core_register(test->client_class, HG_TEST_RPC_ID, NULL);
+
+    test->server_context = HG_Core_context_create(test->server_class);
+    test->client_context = HG_Core_context_create(test->client_class);
+    if (!test->server_context || !test->client_context) {
+        fprintf(stderr, "Error: could not create HG core contexts\n");
+        return EXIT_FAILURE;
+    }
+    HG_Core_context_post(test->server_context, 16, HG_TRUE);
+
+    HG_Core_addr_self(test->server_class, &self_addr);
+    HG_Core_addr_to_string(test->server_class, addr_string, &addr_string_size,
+        self_addr);
+    HG_Core_addr_free(test->server_class, self_addr);
+
+    test->poll_group = HG_Core_poll_group_create();
+    if (!test->poll_group) {
+        fprintf(stderr, "Error: could not create poll group\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Add */
+    ret = HG_Core_poll_group_add(test->poll_group, test->server_context);
+    if (ret == HG_SUCCESS)
+        ret = HG_Core_poll_group_add(test->poll_group, test->client_context);
+    if (ret != HG_SUCCESS) {
+        fprintf(stderr, "Error: could not add contexts to poll group (%d)\n",
+            (int) ret);
+        return EXIT_FAILURE;
+    }
+    ret = HG_Core_poll_group_add(test->poll_group, test->client_context);
+    if (ret != HG_BUSY) {
+        fprintf(stderr, "Error: context was added twice\n");
+        return EXIT_FAILURE;
+    }
+
+    ret = HG_Core_addr_lookup(test->client_context, hg_test_lookup_cb, test,
+        addr_string, HG_CORE_OP_ID_IGNORE);
+    if (ret == HG_SUCCESS)
+        ret = hg_test_wait(test, 1);
+    if (ret != HG_SUCCESS) {
+        fprintf(stderr, "Error: could not look up address (%d)\n", (int) ret);
+        return EXIT_FAILURE;
+    }
+    hg_atomic_set32(&test->completed, 0);
+
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+hg_test_finalize(struct hg_test_poll_group *test)
+{
+    int rc = EXIT_SUCCESS;
+
+    if (test->addr)
+        HG_Core_addr_free(test->client_class, test->addr);
+    if (test->poll_group) {
+        HG_Core_poll_group_remove(test->poll_group, test->server_context);
+        HG_Core_poll_group_remove(test->poll_group, test->client_context);
+        if (HG_Core_poll_group_destroy(test->poll_group) != HG_SUCCESS)
+            rc = EXIT_FAILURE;
+    }
+    if (HG_Core_context_destroy(test->client_context) != HG_SUCCESS
+        || HG_Core_context_destroy(test->server_context) != HG_SUCCESS)
+        rc = EXIT_FAILURE;
+    if (HG_Core_finalize(test->client_class) != HG_SUCCESS
+        || HG_Core_finalize(test->server_class) != HG_SUCCESS)
+        rc = EXIT_FAILURE;
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+test_progress(struct hg_test_poll_group *test)
+{
+    hg_core_handle_t handle;
+    hg_return_t ret;
+    int i, rc = EXIT_SUCCESS;
+
+    HG_Core_create(test->client_context, test->addr, HG_TEST_RPC_ID, &handle);
+    for (i = 0; i < HG_TEST_RPC_COUNT && rc == EXIT_SUCCESS; i++) {
+        rc = hg_test_forward(test, handle);
+        if (rc == EXIT_SUCCESS && hg_test_wait(test, i + 1) != HG_SUCCESS)
+            rc = EXIT_FAILURE;
+    }
+    HG_Core_destroy(handle);
+    if (rc != EXIT_SUCCESS)
+        return rc;
+
+    /* Nothing left to progress, blocking must be allowed and time out */
+    ret = hg_test_poll_group_progress(test, 10);
+    while (ret == HG_SUCCESS)
+        ret = hg_test_poll_group_progress(test, 10);
+    if (ret != HG_TIMEOUT) {
+        fprintf(stderr, "Error: idle poll group progress returned %d\n",
+            (int) ret);
+        return EXIT_FAILURE;
+    }
+    hg_atomic_set32(&test->completed, 0);
+
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+test_remove_concurrent(struct hg_test_poll_group *test)
+{
+    hg_core_handle_t handle;
+    hg_thread_t thread;
+    hg_return_t ret;
+    int i, rc = EXIT_SUCCESS;
+
+    /* Contexts are removed and added back while another thread progresses
+     * the poll group */
+    hg_thread_create(&thread, hg_test_progress_thread, test);
+    HG_Core_create(test->client_context, test->addr, HG_TEST_RPC_ID, &handle);
+    for (i = 0; i < HG_TEST_RPC_COUNT && rc == EXIT_SUCCESS; i++) {
+        rc = hg_test_forward(test, handle);
+        if (rc != EXIT_SUCCESS)
+            break;
+
+        /* Remove */
+        ret = HG_Core_poll_group_remove(test->poll_group,
+            test->server_context);
+        if (ret == HG_SUCCESS)
+            ret = HG_Core_poll_group_add(test->poll_group,
+                test->server_context);
+        if (ret != HG_SUCCESS) {
+            fprintf(stderr, "Error: could not remove / add context (%d)\n",
+                (int) ret);
+            rc = EXIT_FAILURE;
+            break;
+        }
+
+        while (hg_atomic_get32(&test->completed) < i + 1)
+            hg_thread_yield();
+    }
+    hg_atomic_set32(&test->stop, 1);
+    hg_thread_join(thread);
+    HG_Core_destroy(handle);
+
+    /* Context that is no longer part of the poll group */
+    ret = HG_Core_poll_group_remove(test->poll_group, test->server_context);
+    if (rc == EXIT_SUCCESS && ret != HG_SUCCESS)
+        rc = EXIT_FAILURE;
+    ret = HG_Core_poll_group_remove(test->poll_group, test->server_context);
+    if (rc == EXIT_SUCCESS && ret != HG_NOENTRY) {
+        fprintf(stderr, "Error: context was removed twice\n");
+        rc = EXIT_FAILURE;
+    }
+    ret = HG_Core_poll_group_destroy(test->poll_group);
+    if (rc == EXIT_SUCCESS && ret != HG_BUSY) {
+        fprintf(stderr, "Error: non-empty poll group was destroyed\n");
+        rc = EXIT_FAILURE;
+    }
+    HG_Core_poll_group_add(test->poll_group, test->server_context);
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+int
+main(void)
+{
+    struct hg_test_poll_group test = {0};
+    int rc;
+
+    rc = hg_test_init(&test);
+    if (rc != EXIT_SUCCESS)
+        goto done;
+
+    rc = test_progress(&test);
+    if (rc != EXIT_SUCCESS)
+        goto done;
+
+    rc = test_remove_concurrent(&test);
+
+done:
+    if (hg_test_finalize(&test) != EXIT_SUCCESS)
+        rc = EXIT_FAILURE;
+    return rc;
+}
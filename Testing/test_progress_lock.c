@@ -0,0 +1,305 @@
+/*
+ * Copyright (C) 2013-2019 Argonne National Laboratory, Department of Energy,
+ *                    UChicago Argonne, LLC and The HDF Group.
+ * All rights reserved.
+ *
+ * The full copyright notice, including terms governing use, modification,
+ * and redistribution, is contained in the COPYING file that can be
+ * found at the root of the source code distribution tree.
+ */
+
+#include "mercury_core.h"
+
+#include "mercury_atomic.h"
+#include "mercury_thread.h"
+
+#include "mercury_test_config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/****************/
+/* Local Macros */
+/****************/
+
+/* Plugin that registers its fds directly into the context poll set */
+#define HG_TEST_INFO_STRING     "inproc"
+#define HG_TEST_RPC_ID          1
+#define HG_TEST_RPC_COUNT       1000
+#define HG_TEST_THREAD_COUNT    4
+
+/************************************/
+/* Local Type and Struct Definition */
+/************************************/
+
+struct hg_test_info {
+    hg_core_class_t *hg_core_class;
+    hg_core_context_t *context;
+};
+
+/*******************/
+/* Local Variables */
+/*******************/
+
+static hg_atomic_int32_t hg_test_handled_g;    /* RPCs handled by server */
+static hg_atomic_int32_t hg_test_completed_g;  /* Client operations */
+static hg_atomic_int32_t hg_test_stop_g;       /* Server threads must exit */
+
+/*---------------------------------------------------------------------------*/
+static hg_return_t
+hg_test_respond_cb(const struct hg_core_cb_info *callback_info)
+{
+    (void) callback_info;
+    return HG_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static hg_return_t
+hg_test_rpc_cb(hg_core_handle_t handle)
+{
+    hg_return_t ret;
+
+    hg_atomic_incr32(&hg_test_handled_g);
+    ret = HG_Core_respond(handle, hg_test_respond_cb, NULL, 0, 0);
+    HG_Core_destroy(handle);
+
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static hg_return_t
+hg_test_lookup_cb(const struct hg_core_cb_info *callback_info)
+{
+    hg_core_addr_t *addr = (hg_core_addr_t *) callback_info->arg;
+
+    *addr = callback_info->info.lookup.addr;
+    hg_atomic_incr32(&hg_test_completed_g);
+
+    return HG_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static hg_return_t
+hg_test_forward_cb(const struct hg_core_cb_info *callback_info)
+{
+    if (callback_info->ret != HG_SUCCESS)
+        fprintf(stderr, "Error: forward completed with %d\n",
+            (int) callback_info->ret);
+    else
+        hg_atomic_incr32(&hg_test_completed_g);
+
+    return HG_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+hg_test_progress(struct hg_test_info *info, unsigned int timeout)
+{
+    unsigned int actual_count;
+
+    HG_Core_progress(info->context, timeout);
+    do {
+        actual_count = 0;
+        HG_Core_trigger(info->context, 0, 16, &actual_count);
+    } while (actual_count);
+}
+
+/*---------------------------------------------------------------------------*/
+static HG_THREAD_RETURN_TYPE
+hg_test_server_thread(void *arg)
+{
+    hg_thread_ret_t thread_ret = (hg_thread_ret_t) 0;
+    struct hg_test_info *server = (struct hg_test_info *) arg;
+
+    /* All threads progress the same context concurrently */
+    while (!hg_atomic_get32(&hg_test_stop_g))
+        hg_test_progress(server, 10);
+
+    hg_thread_exit(thread_ret);
+    return thread_ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+hg_test_init(struct hg_test_info *info, hg_bool_t listen)
+{
+    info->hg_core_class = HG_Core_init(HG_TEST_INFO_STRING, listen);
+    if (!info->hg_core_class) {
+        fprintf(stderr, "Error: could not initialize class\n");
+        return EXIT_FAILURE;
+    }
+    HG_Core_register(info->hg_core_class, HG_TEST_RPC_ID,
+        listen ? hg_test_rpc_cb : NULL);
+    info->context = HG_Core_context_create(info->hg_core_class);
+    if (!info->context) {
+        fprintf(stderr, "Error: could not create context\n");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+hg_test_finalize(struct hg_test_info *info)
+{
+    int rc = EXIT_SUCCESS;
+
+    if (info->context && HG_Core_context_destroy(info->context)
+        != HG_SUCCESS) {
+        fprintf(stderr, "Error: could not destroy context\n");
+        rc = EXIT_FAILURE;
+    }
+    if (info->hg_core_class && HG_Core_finalize(info->hg_core_class)
+        != HG_SUCCESS) {
+        fprintf(stderr, "Error: could not finalize class\n");
+        rc = EXIT_FAILURE;
+    }
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+hg_test_forward(hg_core_handle_t handle, hg_core_addr_t addr)
+{
+    if (HG_Core_reset(handle, addr, HG_TEST_RPC_ID) != HG_SUCCESS
+        || HG_Core_forward(handle, hg_test_forward_cb, NULL, 0, 0)
+        != HG_SUCCESS) {
+        fprintf(stderr, "Error: could not forward RPC\n");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+test_locked(struct hg_test_info *server, struct hg_test_info *client,
+    hg_core_addr_t addr)
+{
+#ifdef NA_HAS_MULTI_PROGRESS
+    na_class_t *na_class = HG_Core_class_get_na(server->hg_core_class);
+    na_context_t *na_context = HG_Core_context_get_na(server->context);
+    hg_core_handle_t handle;
+    int i, rc = EXIT_SUCCESS;
+
+    /* Another thread is progressing the server NA context */
+    if (NA_Progress_lock(na_class, na_context, 0) != NA_SUCCESS) {
+        fprintf(stderr, "Error: could not lock NA progress\n");
+        return EXIT_FAILURE;
+    }
+
+    hg_atomic_set32(&hg_test_handled_g, 0);
+    hg_atomic_set32(&hg_test_completed_g, 0);
+    HG_Core_create(client->context, addr, HG_TEST_RPC_ID, &handle);
+    rc = hg_test_forward(handle, addr);
+
+    /* Plugin callbacks must not be dispatched while the lock is held */
+    for (i = 0; i < 10 && rc == EXIT_SUCCESS; i++) {
+        hg_test_progress(client, 0);
+        if (HG_Core_progress(server->context, 10) != HG_TIMEOUT
+            || hg_atomic_get32(&hg_test_handled_g) != 0) {
+            fprintf(stderr, "Error: progressed while NA progress is locked\n");
+            rc = EXIT_FAILURE;
+        }
+    }
+    NA_Progress_unlock(na_class, na_context);
+
+    while (rc == EXIT_SUCCESS && hg_atomic_get32(&hg_test_completed_g) < 1) {
+        hg_test_progress(server, 10);
+        hg_test_progress(client, 0);
+    }
+    HG_Core_destroy(handle);
+
+    return rc;
+#else
+    (void) server;
+    (void) client;
+    (void) addr;
+    return EXIT_SUCCESS;
+#endif
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+test_concurrent(struct hg_test_info *server, struct hg_test_info *client,
+    hg_core_addr_t addr)
+{
+    hg_thread_t threads[HG_TEST_THREAD_COUNT];
+    hg_core_handle_t handle;
+    int i, rc = EXIT_SUCCESS;
+
+    hg_atomic_set32(&hg_test_handled_g, 0);
+    hg_atomic_set32(&hg_test_completed_g, 0);
+    hg_atomic_set32(&hg_test_stop_g, 0);
+    for (i = 0; i < HG_TEST_THREAD_COUNT; i++)
+        hg_thread_create(&threads[i], hg_test_server_thread, server);
+
+    HG_Core_create(client->context, addr, HG_TEST_RPC_ID, &handle);
+    for (i = 0; i < HG_TEST_RPC_COUNT && rc == EXIT_SUCCESS; i++) {
+        rc = hg_test_forward(handle, addr);
+        while (rc == EXIT_SUCCESS
+            && hg_atomic_get32(&hg_test_completed_g) < i + 1)
+            hg_test_progress(client, 10);
+    }
+    HG_Core_destroy(handle);
+
+    hg_atomic_set32(&hg_test_stop_g, 1);
+    for (i = 0; i < HG_TEST_THREAD_COUNT; i++)
+        hg_thread_join(threads[i]);
+
+    if (rc == EXIT_SUCCESS
+        && hg_atomic_get32(&hg_test_handled_g) != HG_TEST_RPC_COUNT) {
+        fprintf(stderr, "Error: server handled %d RPCs, expected %d\n",
+            hg_atomic_get32(&hg_test_handled_g), HG_TEST_RPC_COUNT);
+        rc = EXIT_FAILURE;
+    }
+
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+int
+main(void)
+{
+    struct hg_test_info server = {NULL, NULL}, client = {NULL, NULL};
+    char addr_string[256];
+    hg_size_t addr_string_size = sizeof(addr_string);
+    hg_core_addr_t self_addr, addr = HG_CORE_ADDR_NULL;
+    int rc = EXIT_FAILURE;
+
+    hg_atomic_init32(&hg_test_handled_g, 0);
+    hg_atomic_init32(&hg_test_completed_g, 0);
+    hg_atomic_init32(&hg_test_stop_g, 0);
+
+    if (hg_test_init(&server, HG_TRUE) != EXIT_SUCCESS
+        || hg_test_init(&client, HG_FALSE) != EXIT_SUCCESS)
+        goto done;
+    HG_Core_context_post(server.context, 16, HG_TRUE);
+
+    HG_Core_addr_self(server.hg_core_class, &self_addr);
+    HG_Core_addr_to_string(server.hg_core_class, addr_string,
+        &addr_string_size, self_addr);
+    HG_Core_addr_free(server.hg_core_class, self_addr);
+    if (HG_Core_addr_lookup(client.context, hg_test_lookup_cb, &addr,
+        addr_string, HG_CORE_OP_ID_IGNORE) != HG_SUCCESS) {
+        fprintf(stderr, "Error: could not look up server address\n");
+        goto done;
+    }
+    while (hg_atomic_get32(&hg_test_completed_g) < 1)
+        hg_test_progress(&client, 10);
+
+    rc = test_locked(&server, &client, addr);
+    if (rc == EXIT_SUCCESS)
+        rc = test_concurrent(&server, &client, addr);
+
+done:
+    if (addr)
+        HG_Core_addr_free(client.hg_core_class, addr);
+    if (hg_test_finalize(&client) != EXIT_SUCCESS
+        || hg_test_finalize(&server) != EXIT_SUCCESS)
+        rc = EXIT_FAILURE;
+
+    return rc;
+}
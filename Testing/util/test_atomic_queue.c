@@ -1,4 +1,5 @@
 #include "mercury_atomic_queue.h"
+#include "mercury_time.h"
 
 #include "mercury_test_config.h"
 
@@ -10,6 +11,129 @@ struct my_entry {
 };
 
 #define HG_TEST_QUEUE_SIZE 16
+#define HG_TEST_QUEUE_CHAIN_ENTRIES 1000
+
+static int
+test_queue_chain(void)
+{
+    struct hg_atomic_queue_chain *hg_atomic_queue_chain;
+    struct my_entry my_entries[HG_TEST_QUEUE_CHAIN_ENTRIES];
+    struct my_entry *my_entry_ptr;
+    int ret = EXIT_SUCCESS;
+    int i;
+
+    hg_atomic_queue_chain = hg_atomic_queue_chain_alloc(HG_TEST_QUEUE_SIZE);
+    if (!hg_atomic_queue_chain) {
+        fprintf(stderr, "Error: could not allocate queue chain\n");
+        ret = EXIT_FAILURE;
+        goto done;
+    }
+
+    /* Push more entries than the first segment can hold */
+    for (i = 0; i < HG_TEST_QUEUE_CHAIN_ENTRIES; i++) {
+        my_entries[i].value = i;
+        if (hg_atomic_queue_chain_push(hg_atomic_queue_chain, &my_entries[i])
+            != HG_UTIL_SUCCESS) {
+            fprintf(stderr, "Error: could not push entry %d\n", i);
+            ret = EXIT_FAILURE;
+            goto done;
+        }
+    }
+
+    if (hg_atomic_queue_chain_count(hg_atomic_queue_chain)
+        != HG_TEST_QUEUE_CHAIN_ENTRIES) {
+        fprintf(stderr, "Error: queue chain count is %u, expected %d\n",
+            hg_atomic_queue_chain_count(hg_atomic_queue_chain),
+            HG_TEST_QUEUE_CHAIN_ENTRIES);
+        ret = EXIT_FAILURE;
+        goto done;
+    }
+
+    /* Entries must come out in the order they were pushed */
+    for (i = 0; i < HG_TEST_QUEUE_CHAIN_ENTRIES; i++) {
+        my_entry_ptr = hg_atomic_queue_chain_pop_mc(hg_atomic_queue_chain);
+        if (!my_entry_ptr || my_entry_ptr->value != i) {
+            fprintf(stderr, "Error: values do not match, expected %d\n", i);
+            ret = EXIT_FAILURE;
+            goto done;
+        }
+    }
+
+    if (!hg_atomic_queue_chain_is_empty(hg_atomic_queue_chain)) {
+        fprintf(stderr, "Error: queue chain should be empty\n");
+        ret = EXIT_FAILURE;
+        goto done;
+    }
+
+done:
+    hg_atomic_queue_chain_free(hg_atomic_queue_chain);
+    return ret;
+}
+
+#define HG_TEST_BENCH_QUEUE_SIZE 1024
+#define HG_TEST_BENCH_ITER 10000
+#define HG_TEST_BENCH_BATCH_SIZE 64
+
+/* Measure per-item cost of filling and draining a queue with single and
+ * batch pops */
+static int
+test_queue_bench(void)
+{
+    struct hg_atomic_queue *hg_atomic_queue;
+    struct my_entry my_entry = { .value = 0 };
+    void *entries[HG_TEST_BENCH_BATCH_SIZE];
+    unsigned int batch_sizes[] = { 1, 8, HG_TEST_BENCH_BATCH_SIZE };
+    unsigned int n_items = HG_TEST_BENCH_QUEUE_SIZE - 1;
+    int ret = EXIT_SUCCESS;
+    unsigned int b;
+
+    hg_atomic_queue = hg_atomic_queue_alloc(HG_TEST_BENCH_QUEUE_SIZE);
+    if (!hg_atomic_queue) {
+        fprintf(stderr, "Error: could not allocate queue\n");
+        return EXIT_FAILURE;
+    }
+
+    for (b = 0; b < sizeof(batch_sizes) / sizeof(batch_sizes[0]); b++) {
+        hg_time_t t1, t2;
+        double pop_time = 0;
+        int i;
+
+        for (i = 0; i < HG_TEST_BENCH_ITER; i++) {
+            unsigned int j, popped = 0;
+
+            for (j = 0; j < n_items; j++)
+                hg_atomic_queue_push(hg_atomic_queue, &my_entry);
+
+            hg_time_get_current(&t1);
+            if (batch_sizes[b] == 1) {
+                while (hg_atomic_queue_pop_mc(hg_atomic_queue))
+                    popped++;
+            } else {
+                unsigned int count;
+
+                while ((count = hg_atomic_queue_pop_mc_n(hg_atomic_queue,
+                    entries, batch_sizes[b])) > 0)
+                    popped += count;
+            }
+            hg_time_get_current(&t2);
+            pop_time += hg_time_to_double(hg_time_subtract(t2, t1));
+
+            if (popped != n_items) {
+                fprintf(stderr, "Error: popped %u entries, expected %u\n",
+                    popped, n_items);
+                ret = EXIT_FAILURE;
+                goto done;
+            }
+        }
+
+        printf("pop batch %2u: %.2f ns per item\n", batch_sizes[b],
+            pop_time * 1e9 / ((double) n_items * HG_TEST_BENCH_ITER));
+    }
+
+done:
+    hg_atomic_queue_free(hg_atomic_queue);
+    return ret;
+}
 
 int
 main(void)
@@ -47,6 +171,12 @@ main(void)
         goto done;
     }
 
+    ret = test_queue_chain();
+    if (ret != EXIT_SUCCESS)
+        goto done;
+
+    ret = test_queue_bench();
+
 done:
     hg_atomic_queue_free(hg_atomic_queue);
     return ret;
@@ -1,9 +1,31 @@
 #include "mercury_hash_table.h"
+#include "mercury_hash_map.h"
+#include "mercury_atomic.h"
+#include "mercury_thread.h"
+#include "mercury_thread_rwlock.h"
+#include "mercury_time.h"
 
 #include "mercury_test_config.h"
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#define HG_TEST_MAP_KEYS        10000
+#define HG_TEST_MAP_MT_KEYS     2000
+#define HG_TEST_MAP_MT_ITER     20
+#define HG_TEST_BENCH_KEYS      4096
+#define HG_TEST_BENCH_LOOKUPS   (1 << 20)
+
+struct mt_map_args {
+    hg_hash_map_t *map;
+    hg_hash_table_t *table;
+    hg_thread_rwlock_t *rwlock;
+    hg_util_uint64_t base;
+    double time;
+};
+
+static hg_atomic_int32_t mt_errors;
 
 static int
 int_equal(hg_hash_table_key_t vlocation1, hg_hash_table_key_t vlocation2)
@@ -29,6 +51,308 @@ int_hash_value_free(hg_hash_table_value_t value)
     free((int *) value);
 }
 
+static int
+test_map_int(void)
+{
+    hg_hash_map_t *map;
+    hg_util_uint64_t i;
+    void *value;
+    int ret = EXIT_SUCCESS;
+
+    map = hg_hash_map_new_int();
+    if (!map) {
+        fprintf(stderr, "Error: could not create map\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Insert enough keys to go through several resizes */
+    for (i = 0; i < HG_TEST_MAP_KEYS; i++) {
+        if (hg_hash_map_insert_int(map, i, (void *) (i + 1), &value)
+            != HG_UTIL_SUCCESS || value != (void *) (i + 1)) {
+            fprintf(stderr, "Error: could not insert key %lu\n",
+                (unsigned long) i);
+            ret = EXIT_FAILURE;
+            goto done;
+        }
+    }
+
+    /* Existing keys are not replaced */
+    hg_hash_map_insert_int(map, 0, (void *) 42, &value);
+    if (value != (void *) 1) {
+        fprintf(stderr, "Error: existing value was replaced\n");
+        ret = EXIT_FAILURE;
+        goto done;
+    }
+
+    for (i = 0; i < HG_TEST_MAP_KEYS; i += 2) {
+        if (hg_hash_map_remove_int(map, i, &value) != HG_UTIL_SUCCESS
+            || value != (void *) (i + 1)) {
+            fprintf(stderr, "Error: could not remove key %lu\n",
+                (unsigned long) i);
+            ret = EXIT_FAILURE;
+            goto done;
+        }
+    }
+
+    if (hg_hash_map_count(map) != HG_TEST_MAP_KEYS / 2) {
+        fprintf(stderr, "Error: was expecting %u entries, got %u\n",
+            HG_TEST_MAP_KEYS / 2, hg_hash_map_count(map));
+        ret = EXIT_FAILURE;
+        goto done;
+    }
+
+    for (i = 0; i < HG_TEST_MAP_KEYS; i++) {
+        int rc = hg_hash_map_lookup_int(map, i, &value);
+
+        if ((i % 2 == 0 && rc == HG_UTIL_SUCCESS)
+            || (i % 2 == 1 && (rc != HG_UTIL_SUCCESS
+                || value != (void *) (i + 1)))) {
+            fprintf(stderr, "Error: unexpected lookup result for key %lu\n",
+                (unsigned long) i);
+            ret = EXIT_FAILURE;
+            goto done;
+        }
+    }
+
+done:
+    hg_hash_map_free(map, NULL);
+    return ret;
+}
+
+static int
+test_map_bytes(void)
+{
+    hg_hash_map_t *map;
+    char key[32];
+    int *value1, *value2;
+    void *value;
+    int ret = EXIT_SUCCESS;
+    int i;
+
+    map = hg_hash_map_new_bytes();
+    if (!map) {
+        fprintf(stderr, "Error: could not create map\n");
+        return EXIT_FAILURE;
+    }
+
+    for (i = 0; i < HG_TEST_MAP_KEYS; i++) {
+        int *v = (int *) malloc(sizeof(int));
+
+        *v = i;
+        sprintf(key, "key-%d", i);
+        if (hg_hash_map_insert_bytes(map, key, strlen(key), v, NULL)
+            != HG_UTIL_SUCCESS) {
+            fprintf(stderr, "Error: could not insert key %s\n", key);
+            free(v);
+            ret = EXIT_FAILURE;
+            goto done;
+        }
+    }
+
+    /* Keys are compared by content and length */
+    if (hg_hash_map_lookup_bytes(map, "key-1", 5, &value) != HG_UTIL_SUCCESS
+        || *(int *) value != 1
+        || hg_hash_map_lookup_bytes(map, "key-1", 4, &value)
+        == HG_UTIL_SUCCESS) {
+        fprintf(stderr, "Error: unexpected lookup result\n");
+        ret = EXIT_FAILURE;
+        goto done;
+    }
+
+    if (hg_hash_map_remove_bytes(map, "key-1", 5, (void **) &value1)
+        != HG_UTIL_SUCCESS) {
+        fprintf(stderr, "Error: could not remove key\n");
+        ret = EXIT_FAILURE;
+        goto done;
+    }
+    value2 = (int *) malloc(sizeof(int));
+    *value2 = -1;
+    hg_hash_map_insert_bytes(map, "key-1", 5, value2, NULL);
+    if (hg_hash_map_lookup_bytes(map, "key-1", 5, &value) != HG_UTIL_SUCCESS
+        || *(int *) value != -1) {
+        fprintf(stderr, "Error: values do not match\n");
+        ret = EXIT_FAILURE;
+    }
+    free(value1);
+
+done:
+    hg_hash_map_free(map, free);
+    return ret;
+}
+
+static HG_THREAD_RETURN_TYPE
+mt_map_thread_cb(void *arg)
+{
+    struct mt_map_args *args = (struct mt_map_args *) arg;
+    hg_thread_ret_t thread_ret = (hg_thread_ret_t) 0;
+    hg_util_uint64_t i;
+    void *value;
+    int iter;
+
+    for (iter = 0; iter < HG_TEST_MAP_MT_ITER; iter++) {
+        /* Churn private keys while checking that shared keys stay visible
+         * across resizes */
+        for (i = 0; i < HG_TEST_MAP_MT_KEYS; i++) {
+            hg_util_uint64_t key = args->base + i;
+
+            if (hg_hash_map_insert_int(args->map, key, (void *) key, NULL)
+                != HG_UTIL_SUCCESS)
+                hg_atomic_incr32(&mt_errors);
+            if (hg_hash_map_lookup_int(args->map, i % HG_TEST_MAP_MT_KEYS,
+                &value) != HG_UTIL_SUCCESS
+                || value != (void *) (i % HG_TEST_MAP_MT_KEYS))
+                hg_atomic_incr32(&mt_errors);
+        }
+        for (i = 0; i < HG_TEST_MAP_MT_KEYS; i++) {
+            hg_util_uint64_t key = args->base + i;
+
+            if (hg_hash_map_remove_int(args->map, key, &value)
+                != HG_UTIL_SUCCESS || value != (void *) key)
+                hg_atomic_incr32(&mt_errors);
+        }
+    }
+
+    hg_thread_exit(thread_ret);
+    return thread_ret;
+}
+
+static int
+test_map_mt(void)
+{
+    hg_thread_t threads[HG_TEST_NUM_THREADS_DEFAULT];
+    struct mt_map_args args[HG_TEST_NUM_THREADS_DEFAULT];
+    hg_hash_map_t *map;
+    hg_util_uint64_t i;
+    int ret = EXIT_SUCCESS;
+
+    map = hg_hash_map_new_int();
+    if (!map) {
+        fprintf(stderr, "Error: could not create map\n");
+        return EXIT_FAILURE;
+    }
+    for (i = 0; i < HG_TEST_MAP_MT_KEYS; i++)
+        hg_hash_map_insert_int(map, i, (void *) i, NULL);
+
+    hg_atomic_init32(&mt_errors, 0);
+    for (i = 0; i < HG_TEST_NUM_THREADS_DEFAULT; i++) {
+        args[i].map = map;
+        args[i].base = (i + 1) * HG_TEST_MAP_MT_KEYS;
+        hg_thread_create(&threads[i], mt_map_thread_cb, &args[i]);
+    }
+    for (i = 0; i < HG_TEST_NUM_THREADS_DEFAULT; i++)
+        hg_thread_join(threads[i]);
+
+    if (hg_atomic_get32(&mt_errors) != 0
+        || hg_hash_map_count(map) != HG_TEST_MAP_MT_KEYS) {
+        fprintf(stderr, "Error: %d errors, %u entries\n",
+            hg_atomic_get32(&mt_errors), hg_hash_map_count(map));
+        ret = EXIT_FAILURE;
+    }
+
+    hg_hash_map_free(map, NULL);
+    return ret;
+}
+
+static HG_THREAD_RETURN_TYPE
+bench_thread_cb(void *arg)
+{
+    struct mt_map_args *args = (struct mt_map_args *) arg;
+    hg_thread_ret_t thread_ret = (hg_thread_ret_t) 0;
+    hg_time_t t1, t2;
+    unsigned int i;
+    void *value;
+
+    hg_time_get_current(&t1);
+    for (i = 0; i < HG_TEST_BENCH_LOOKUPS; i++) {
+        hg_util_uint64_t key = (i * 2654435761U) % HG_TEST_BENCH_KEYS;
+
+        if (args->map)
+            hg_hash_map_lookup_int(args->map, key, &value);
+        else {
+            hg_thread_rwlock_rdlock(args->rwlock);
+            value = hg_hash_table_lookup(args->table,
+                (hg_hash_table_key_t) &key);
+            hg_thread_rwlock_release_rdlock(args->rwlock);
+        }
+        if (value == NULL)
+            hg_atomic_incr32(&mt_errors);
+    }
+    hg_time_get_current(&t2);
+    args->time = hg_time_to_double(hg_time_subtract(t2, t1));
+
+    hg_thread_exit(thread_ret);
+    return thread_ret;
+}
+
+static int
+uint64_equal(hg_hash_table_key_t vlocation1, hg_hash_table_key_t vlocation2)
+{
+    return *((hg_util_uint64_t *) vlocation1)
+        == *((hg_util_uint64_t *) vlocation2);
+}
+
+static unsigned int
+uint64_hash(hg_hash_table_key_t vlocation)
+{
+    return (unsigned int) *((hg_util_uint64_t *) vlocation);
+}
+
+/* Compare concurrent lookups in the map with lookups in a hash table
+ * protected by a rwlock, as previously done for addresses */
+static int
+test_map_bench(void)
+{
+    hg_thread_t threads[HG_TEST_NUM_THREADS_DEFAULT];
+    struct mt_map_args args[HG_TEST_NUM_THREADS_DEFAULT];
+    hg_util_uint64_t keys[HG_TEST_BENCH_KEYS];
+    hg_thread_rwlock_t rwlock;
+    hg_hash_table_t *table;
+    hg_hash_map_t *map;
+    unsigned int n_threads[] = { 1, HG_TEST_NUM_THREADS_DEFAULT };
+    int ret = EXIT_SUCCESS;
+    unsigned int i, n, m;
+
+    map = hg_hash_map_new_int();
+    table = hg_hash_table_new(uint64_hash, uint64_equal);
+    hg_thread_rwlock_init(&rwlock);
+    for (i = 0; i < HG_TEST_BENCH_KEYS; i++) {
+        keys[i] = i;
+        hg_hash_map_insert_int(map, i, &keys[i], NULL);
+        hg_hash_table_insert(table, &keys[i], &keys[i]);
+    }
+
+    hg_atomic_init32(&mt_errors, 0);
+    for (m = 0; m < 2; m++) {
+        for (n = 0; n < sizeof(n_threads) / sizeof(n_threads[0]); n++) {
+            double time = 0;
+
+            for (i = 0; i < n_threads[n]; i++) {
+                args[i].map = (m == 0) ? map : NULL;
+                args[i].table = table;
+                args[i].rwlock = &rwlock;
+                hg_thread_create(&threads[i], bench_thread_cb, &args[i]);
+            }
+            for (i = 0; i < n_threads[n]; i++) {
+                hg_thread_join(threads[i]);
+                time += args[i].time;
+            }
+            printf("%s, %u thread(s): %.2f ns per lookup\n",
+                (m == 0) ? "hash map" : "rwlock hash table", n_threads[n],
+                time * 1e9 / ((double) n_threads[n] * HG_TEST_BENCH_LOOKUPS));
+        }
+    }
+    if (hg_atomic_get32(&mt_errors) != 0) {
+        fprintf(stderr, "Error: %d lookups failed\n",
+            hg_atomic_get32(&mt_errors));
+        ret = EXIT_FAILURE;
+    }
+
+    hg_thread_rwlock_destroy(&rwlock);
+    hg_hash_table_free(table);
+    hg_hash_map_free(map, NULL);
+    return ret;
+}
+
 /*---------------------------------------------------------------------------*/
 
 int
@@ -96,6 +420,20 @@ main(int argc, char *argv[])
         goto done;
     }
 
+    ret = test_map_int();
+    if (ret != EXIT_SUCCESS)
+        goto done;
+
+    ret = test_map_bytes();
+    if (ret != EXIT_SUCCESS)
+        goto done;
+
+    ret = test_map_mt();
+    if (ret != EXIT_SUCCESS)
+        goto done;
+
+    ret = test_map_bench();
+
 done:
     hg_hash_table_free(hash_table);
     return ret;
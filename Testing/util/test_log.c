@@ -0,0 +1,191 @@
+#include "mercury_log.h"
+#include "mercury_atomic.h"
+#include "mercury_thread.h"
+#include "mercury_time.h"
+
+#include "mercury_test_config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HG_TEST_LOG_MSGS    1000
+
+static hg_atomic_int32_t n_lines;
+static FILE *log_stream;
+
+/* Count messages written and discard them */
+static int
+count_func(FILE *stream, const char *format, ...)
+{
+    (void) format;
+    if (stream == log_stream)
+        hg_atomic_incr32(&n_lines);
+    return 0;
+}
+
+static HG_THREAD_RETURN_TYPE
+log_thread_cb(void *arg)
+{
+    hg_thread_ret_t thread_ret = (hg_thread_ret_t) 0;
+    unsigned int id = *(unsigned int *) arg;
+    unsigned int i;
+
+    for (i = 0; i < HG_TEST_LOG_MSGS; i++) {
+        hg_log_write(HG_LOG_TYPE_DEBUG, "Test", __FILE__, __LINE__, __func__,
+            "thread %u message %u", id, i);
+        /* Let the background thread keep up */
+        if (i % 100 == 0)
+            hg_thread_yield();
+    }
+
+    hg_thread_exit(thread_ret);
+    return thread_ret;
+}
+
+static hg_thread_key_t exit_key;
+
+/* Log from a thread destructor, possibly after the ring was released */
+static void
+exit_key_destructor(void *arg)
+{
+    (void) arg;
+    hg_log_write(HG_LOG_TYPE_DEBUG, "Test", __FILE__, __LINE__, __func__,
+        "thread exiting");
+}
+
+static HG_THREAD_RETURN_TYPE
+log_exit_thread_cb(void *arg)
+{
+    hg_thread_ret_t thread_ret = (hg_thread_ret_t) 0;
+
+    hg_log_write(HG_LOG_TYPE_DEBUG, "Test", __FILE__, __LINE__, __func__,
+        "thread running");
+    hg_thread_setspecific(exit_key, arg);
+
+    hg_thread_exit(thread_ret);
+    return thread_ret;
+}
+
+static int
+test_log_async(void)
+{
+    hg_thread_t threads[HG_TEST_NUM_THREADS_DEFAULT];
+    unsigned int ids[HG_TEST_NUM_THREADS_DEFAULT];
+    unsigned int i;
+    hg_util_uint64_t dropped;
+    int expected = HG_TEST_NUM_THREADS_DEFAULT * HG_TEST_LOG_MSGS;
+
+    hg_atomic_init32(&n_lines, 0);
+    hg_log_set_func(count_func);
+    hg_log_set_stream_debug(log_stream);
+    hg_log_set_stream_warning(stderr);
+
+    if (hg_log_set_async(HG_UTIL_TRUE) != HG_UTIL_SUCCESS) {
+        fprintf(stderr, "Error: could not enable async logging\n");
+        return EXIT_FAILURE;
+    }
+    for (i = 0; i < HG_TEST_NUM_THREADS_DEFAULT; i++) {
+        ids[i] = i;
+        hg_thread_create(&threads[i], log_thread_cb, &ids[i]);
+    }
+    for (i = 0; i < HG_TEST_NUM_THREADS_DEFAULT; i++)
+        hg_thread_join(threads[i]);
+
+    /* Messages of exited threads are still written */
+    hg_log_flush();
+    dropped = hg_log_get_dropped();
+    if (hg_atomic_get32(&n_lines) + (int) dropped != expected) {
+        fprintf(stderr, "Error: %d messages written, %llu dropped, "
+            "expected %d\n", hg_atomic_get32(&n_lines),
+            (unsigned long long) dropped, expected);
+        return EXIT_FAILURE;
+    }
+
+    /* Messages logged while a thread exits are not lost */
+    hg_thread_key_create(&exit_key, exit_key_destructor);
+    hg_thread_create(&threads[0], log_exit_thread_cb, &ids[0]);
+    hg_thread_join(threads[0]);
+    hg_thread_key_delete(exit_key);
+    hg_log_flush();
+    expected += 2;
+    if (hg_atomic_get32(&n_lines) + (int) dropped != expected) {
+        fprintf(stderr, "Error: message logged at thread exit was lost\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Errors are written synchronously */
+    hg_log_set_stream_error(log_stream);
+    hg_log_write(HG_LOG_TYPE_ERROR, "Test", __FILE__, __LINE__, __func__,
+        "error");
+    if (hg_atomic_get32(&n_lines) + (int) dropped != expected + 1) {
+        fprintf(stderr, "Error: error message was deferred\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Pending messages are written when disabled */
+    hg_log_write(HG_LOG_TYPE_DEBUG, "Test", __FILE__, __LINE__, __func__,
+        "last");
+    hg_log_set_async(HG_UTIL_FALSE);
+    if (hg_atomic_get32(&n_lines) + (int) hg_log_get_dropped()
+        != expected + 2) {
+        fprintf(stderr, "Error: pending message was not written\n");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+#define HG_TEST_BENCH_ITER  100000
+
+/* Measure cost of a debug message for the calling thread */
+static int
+test_log_bench(void)
+{
+    int async;
+
+    hg_log_set_func(count_func);
+    hg_log_set_stream_debug(log_stream);
+
+    for (async = 0; async < 2; async++) {
+        hg_time_t t1, t2;
+        unsigned int i;
+
+        hg_log_set_async((hg_util_bool_t) async);
+        hg_time_get_current(&t1);
+        for (i = 0; i < HG_TEST_BENCH_ITER; i++)
+            hg_log_write(HG_LOG_TYPE_DEBUG, "Test", __FILE__, __LINE__,
+                __func__, "message %u with value %p", i, (void *) &i);
+        hg_time_get_current(&t2);
+
+        printf("%s: %.2f ns per message\n", async ? "async" : "sync",
+            hg_time_to_double(hg_time_subtract(t2, t1)) * 1e9
+            / HG_TEST_BENCH_ITER);
+    }
+    hg_log_set_async(HG_UTIL_FALSE);
+
+    return EXIT_SUCCESS;
+}
+
+int
+main(void)
+{
+    int ret;
+
+    /* Dummy stream used to identify messages */
+    log_stream = tmpfile();
+    if (!log_stream) {
+        fprintf(stderr, "Error: could not create stream\n");
+        return EXIT_FAILURE;
+    }
+
+    ret = test_log_async();
+    if (ret != EXIT_SUCCESS)
+        goto done;
+
+    ret = test_log_bench();
+
+done:
+    fclose(log_stream);
+    return ret;
+}
@@ -0,0 +1,130 @@
+#include "mercury_mem.h"
+
+#include "mercury_test_config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define HG_TEST_MEM_SIZE    (64 * 1024)
+
+static const char *
+backing_name(hg_mem_backing_t backing)
+{
+    switch (backing) {
+        case HG_MEM_BACKING_HUGETLB:
+            return "hugetlb";
+        case HG_MEM_BACKING_THP:
+            return "thp";
+        case HG_MEM_BACKING_REGULAR:
+        default:
+            return "regular";
+    }
+}
+
+static hg_util_uint64_t
+total_bytes(void)
+{
+    struct hg_mem_stats stats;
+
+    hg_mem_get_stats(&stats);
+    return stats.hugetlb_bytes + stats.thp_bytes + stats.regular_bytes;
+}
+
+static int
+test_huge_alloc(void)
+{
+    size_t huge_page_size = hg_mem_get_huge_page_size();
+    hg_mem_backing_t backing;
+    char *mem_ptr;
+    size_t i;
+
+    mem_ptr = (char *) hg_mem_huge_alloc(HG_TEST_MEM_SIZE, &backing);
+    if (!mem_ptr) {
+        fprintf(stderr, "Error: could not allocate memory\n");
+        return EXIT_FAILURE;
+    }
+    printf("huge page size %zu, alloc backing: %s\n", huge_page_size,
+        backing_name(backing));
+
+    /* Memory is zeroed, aligned and accounted for a full huge page */
+    for (i = 0; i < HG_TEST_MEM_SIZE; i++) {
+        if (mem_ptr[i] != 0) {
+            fprintf(stderr, "Error: memory is not zeroed\n");
+            return EXIT_FAILURE;
+        }
+    }
+    if ((size_t) mem_ptr % huge_page_size != 0
+        || total_bytes() != huge_page_size) {
+        fprintf(stderr, "Error: bad alignment or accounting (%p, %llu)\n",
+            (void *) mem_ptr, (unsigned long long) total_bytes());
+        return EXIT_FAILURE;
+    }
+    memset(mem_ptr, 1, HG_TEST_MEM_SIZE);
+
+    hg_mem_huge_free(mem_ptr, HG_TEST_MEM_SIZE, backing);
+    if (total_bytes() != 0) {
+        fprintf(stderr, "Error: memory still accounted after free\n");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+static int
+test_shm_map_huge(void)
+{
+    hg_mem_backing_t backing1, backing2;
+    char name[64];
+    int *ptr1, *ptr2;
+    int ret = EXIT_SUCCESS;
+
+    sprintf(name, "hg_test_mem-%d", (int) getpid());
+    ptr1 = (int *) hg_mem_shm_map_huge(name, HG_TEST_MEM_SIZE, HG_UTIL_TRUE,
+        &backing1);
+    if (!ptr1) {
+        fprintf(stderr, "Error: could not create shared segment\n");
+        return EXIT_FAILURE;
+    }
+    printf("shm backing: %s\n", backing_name(backing1));
+
+    /* Peer maps the segment wherever it was created */
+    ptr2 = (int *) hg_mem_shm_map_huge(name, HG_TEST_MEM_SIZE, HG_UTIL_FALSE,
+        &backing2);
+    if (!ptr2) {
+        fprintf(stderr, "Error: could not open shared segment\n");
+        ret = EXIT_FAILURE;
+        goto done;
+    }
+    *ptr1 = 42;
+    if (*ptr2 != 42) {
+        fprintf(stderr, "Error: segment is not shared\n");
+        ret = EXIT_FAILURE;
+    }
+    hg_mem_shm_unmap_huge(NULL, ptr2, HG_TEST_MEM_SIZE, backing2);
+
+done:
+    hg_mem_shm_unmap_huge(name, ptr1, HG_TEST_MEM_SIZE, backing1);
+    if (ret == EXIT_SUCCESS && total_bytes() != 0) {
+        fprintf(stderr, "Error: memory still accounted after unmap\n");
+        ret = EXIT_FAILURE;
+    }
+
+    return ret;
+}
+
+int
+main(void)
+{
+    int ret;
+
+    ret = test_huge_alloc();
+    if (ret != EXIT_SUCCESS)
+        goto done;
+
+    ret = test_shm_map_huge();
+
+done:
+    return ret;
+}
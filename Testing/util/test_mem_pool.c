@@ -0,0 +1,345 @@
+#include "mercury_mem_pool.h"
+#include "mercury_atomic.h"
+#include "mercury_thread.h"
+#include "mercury_time.h"
+
+#include "mercury_test_config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HG_TEST_POOL_OBJ_SIZE   40
+#define HG_TEST_POOL_OBJS       1000
+
+static int
+test_pool(void)
+{
+    void *objs[HG_TEST_POOL_OBJS];
+    struct hg_mem_pool_stats stats;
+    hg_mem_pool_t *pool;
+    int ret = EXIT_SUCCESS;
+    int i, j;
+
+    pool = hg_mem_pool_create(HG_TEST_POOL_OBJ_SIZE, 16, 0);
+    if (!pool) {
+        fprintf(stderr, "Error: could not create pool\n");
+        return EXIT_FAILURE;
+    }
+
+    for (i = 0; i < HG_TEST_POOL_OBJS; i++) {
+        objs[i] = hg_mem_pool_alloc(pool);
+        if (!objs[i] || ((hg_util_ptr_t) objs[i] % 64) != 0) {
+            fprintf(stderr, "Error: bad object %p\n", objs[i]);
+            ret = EXIT_FAILURE;
+            goto done;
+        }
+        memset(objs[i], i & 0xff, HG_TEST_POOL_OBJ_SIZE);
+    }
+
+    /* Objects must not overlap */
+    for (i = 0; i < HG_TEST_POOL_OBJS; i++) {
+        for (j = 0; j < HG_TEST_POOL_OBJ_SIZE; j++) {
+            if (((unsigned char *) objs[i])[j] != (i & 0xff)) {
+                fprintf(stderr, "Error: object %d was overwritten\n", i);
+                ret = EXIT_FAILURE;
+                goto done;
+            }
+        }
+    }
+
+    hg_mem_pool_get_stats(pool, &stats);
+    if (stats.obj_size != 64 || stats.n_used != HG_TEST_POOL_OBJS
+        || stats.n_allocs != HG_TEST_POOL_OBJS
+        || stats.n_objs < HG_TEST_POOL_OBJS) {
+        fprintf(stderr, "Error: bad stats (size %zu, used %zu, allocs %llu, "
+            "objs %zu)\n", stats.obj_size, stats.n_used,
+            (unsigned long long) stats.n_allocs, stats.n_objs);
+        ret = EXIT_FAILURE;
+        goto done;
+    }
+
+    for (i = 0; i < HG_TEST_POOL_OBJS; i++)
+        hg_mem_pool_free(pool, objs[i]);
+
+    /* Freed objects are reused */
+    hg_mem_pool_get_stats(pool, &stats);
+    if (stats.n_used != 0) {
+        fprintf(stderr, "Error: %zu objects still used\n", stats.n_used);
+        ret = EXIT_FAILURE;
+        goto done;
+    }
+    for (i = 0; i < HG_TEST_POOL_OBJS; i++)
+        objs[i] = hg_mem_pool_alloc(pool);
+    hg_mem_pool_get_stats(pool, &stats);
+    if (stats.n_objs >= 2 * HG_TEST_POOL_OBJS) {
+        fprintf(stderr, "Error: pool grew to %zu objects\n", stats.n_objs);
+        ret = EXIT_FAILURE;
+        goto done;
+    }
+
+done:
+    hg_mem_pool_destroy(pool);
+    return ret;
+}
+
+static int
+test_pool_huge(void)
+{
+    struct hg_mem_pool_stats stats;
+    hg_mem_pool_t *pool;
+    void *obj;
+
+    /* Falls back to regular pages if no huge page is available */
+    pool = hg_mem_pool_create(HG_TEST_POOL_OBJ_SIZE, 0, HG_MEM_POOL_HUGE_PAGE);
+    if (!pool) {
+        fprintf(stderr, "Error: could not create pool\n");
+        return EXIT_FAILURE;
+    }
+    obj = hg_mem_pool_alloc(pool);
+    if (!obj) {
+        fprintf(stderr, "Error: could not allocate object\n");
+        hg_mem_pool_destroy(pool);
+        return EXIT_FAILURE;
+    }
+    memset(obj, 0, HG_TEST_POOL_OBJ_SIZE);
+    hg_mem_pool_get_stats(pool, &stats);
+    printf("huge page chunks: %zu/%zu\n", stats.n_huge_chunks,
+        stats.n_chunks);
+    hg_mem_pool_free(pool, obj);
+    hg_mem_pool_destroy(pool);
+
+    return EXIT_SUCCESS;
+}
+
+#define HG_TEST_POOL_MT_ITER    100000
+#define HG_TEST_POOL_MT_OBJS    48
+
+static hg_atomic_int32_t mt_errors;
+
+/* Each thread allocates objects, then frees them together with objects
+ * allocated by its neighbour so that objects move between magazines */
+struct mt_pool_args {
+    hg_mem_pool_t *pool;
+    hg_atomic_int64_t handoff;  /* Object passed to next thread */
+    struct mt_pool_args *next;
+    unsigned int id;
+};
+
+static HG_THREAD_RETURN_TYPE
+mt_pool_thread_cb(void *arg)
+{
+    struct mt_pool_args *args = (struct mt_pool_args *) arg;
+    hg_thread_ret_t thread_ret = (hg_thread_ret_t) 0;
+    unsigned int *objs[HG_TEST_POOL_MT_OBJS];
+    unsigned int i, j;
+
+    for (i = 0; i < HG_TEST_POOL_MT_ITER / HG_TEST_POOL_MT_OBJS; i++) {
+        hg_util_int64_t old;
+        unsigned int *obj;
+
+        for (j = 0; j < HG_TEST_POOL_MT_OBJS; j++) {
+            objs[j] = (unsigned int *) hg_mem_pool_alloc(args->pool);
+            if (!objs[j]) {
+                hg_atomic_incr32(&mt_errors);
+                goto done;
+            }
+            *objs[j] = args->id;
+        }
+        for (j = 0; j < HG_TEST_POOL_MT_OBJS; j++) {
+            if (*objs[j] != args->id)
+                hg_atomic_incr32(&mt_errors);
+        }
+
+        /* Hand last object to next thread, free one received */
+        do {
+            old = hg_atomic_get64(&args->next->handoff);
+        } while (!hg_atomic_cas64(&args->next->handoff, old,
+            (hg_util_int64_t) (hg_util_ptr_t) objs[HG_TEST_POOL_MT_OBJS - 1]));
+        obj = (unsigned int *) (hg_util_ptr_t) old;
+        if (obj)
+            hg_mem_pool_free(args->pool, obj);
+        for (j = 0; j < HG_TEST_POOL_MT_OBJS - 1; j++)
+            hg_mem_pool_free(args->pool, objs[j]);
+    }
+
+done:
+    hg_thread_exit(thread_ret);
+    return thread_ret;
+}
+
+static int
+test_pool_mt(void)
+{
+    hg_thread_t threads[HG_TEST_NUM_THREADS_DEFAULT];
+    struct mt_pool_args args[HG_TEST_NUM_THREADS_DEFAULT];
+    struct hg_mem_pool_stats stats;
+    hg_mem_pool_t *pool;
+    int ret = EXIT_SUCCESS;
+    unsigned int i;
+
+    pool = hg_mem_pool_create(sizeof(unsigned int), 0, 0);
+    if (!pool) {
+        fprintf(stderr, "Error: could not create pool\n");
+        return EXIT_FAILURE;
+    }
+
+    hg_atomic_init32(&mt_errors, 0);
+    for (i = 0; i < HG_TEST_NUM_THREADS_DEFAULT; i++) {
+        args[i].pool = pool;
+        hg_atomic_init64(&args[i].handoff, 0);
+        args[i].next = &args[(i + 1) % HG_TEST_NUM_THREADS_DEFAULT];
+        args[i].id = i;
+    }
+    for (i = 0; i < HG_TEST_NUM_THREADS_DEFAULT; i++)
+        hg_thread_create(&threads[i], mt_pool_thread_cb, &args[i]);
+    for (i = 0; i < HG_TEST_NUM_THREADS_DEFAULT; i++)
+        hg_thread_join(threads[i]);
+
+    for (i = 0; i < HG_TEST_NUM_THREADS_DEFAULT; i++)
+        hg_mem_pool_free(pool, (void *) (hg_util_ptr_t)
+            hg_atomic_get64(&args[i].handoff));
+
+    /* Magazines of exited threads have been returned to the pool */
+    hg_mem_pool_get_stats(pool, &stats);
+    if (hg_atomic_get32(&mt_errors) != 0 || stats.n_used != 0) {
+        fprintf(stderr, "Error: %d errors, %zu objects still used\n",
+            hg_atomic_get32(&mt_errors), stats.n_used);
+        ret = EXIT_FAILURE;
+    }
+
+    hg_mem_pool_destroy(pool);
+    return ret;
+}
+
+#define HG_TEST_POOL_RACE_ITER  50
+
+static hg_atomic_int32_t race_ready;
+static hg_atomic_int32_t race_exit;
+
+/* Thread that owns a magazine and exits while its pool is destroyed */
+static HG_THREAD_RETURN_TYPE
+race_pool_thread_cb(void *arg)
+{
+    hg_mem_pool_t *pool = (hg_mem_pool_t *) arg;
+    hg_thread_ret_t thread_ret = (hg_thread_ret_t) 0;
+    void *obj;
+
+    obj = hg_mem_pool_alloc(pool);
+    if (!obj)
+        hg_atomic_incr32(&mt_errors);
+    hg_mem_pool_free(pool, obj);
+    hg_atomic_incr32(&race_ready);
+    while (!hg_atomic_get32(&race_exit))
+        hg_thread_yield();
+
+    hg_thread_exit(thread_ret);
+    return thread_ret;
+}
+
+static int
+test_pool_destroy_race(void)
+{
+    hg_thread_t threads[HG_TEST_NUM_THREADS_DEFAULT];
+    hg_mem_pool_t *pool;
+    unsigned int i, j;
+
+    hg_atomic_init32(&mt_errors, 0);
+    for (i = 0; i < HG_TEST_POOL_RACE_ITER; i++) {
+        pool = hg_mem_pool_create(sizeof(unsigned int), 0, 0);
+        if (!pool) {
+            fprintf(stderr, "Error: could not create pool\n");
+            return EXIT_FAILURE;
+        }
+        hg_atomic_init32(&race_ready, 0);
+        hg_atomic_init32(&race_exit, 0);
+        for (j = 0; j < HG_TEST_NUM_THREADS_DEFAULT; j++)
+            hg_thread_create(&threads[j], race_pool_thread_cb, pool);
+        while (hg_atomic_get32(&race_ready) < HG_TEST_NUM_THREADS_DEFAULT)
+            hg_thread_yield();
+
+        /* Thread destructors run concurrently with destroy */
+        hg_atomic_set32(&race_exit, 1);
+        hg_mem_pool_destroy(pool);
+        for (j = 0; j < HG_TEST_NUM_THREADS_DEFAULT; j++)
+            hg_thread_join(threads[j]);
+    }
+    if (hg_atomic_get32(&mt_errors) != 0) {
+        fprintf(stderr, "Error: could not allocate objects\n");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+#define HG_TEST_BENCH_ITER      1000000
+#define HG_TEST_BENCH_OBJS      16
+#define HG_TEST_BENCH_OBJ_SIZE  192
+
+/* Measure cost of an alloc/free pair against malloc() */
+static int
+test_pool_bench(void)
+{
+    void *objs[HG_TEST_BENCH_OBJS];
+    hg_mem_pool_t *pool;
+    int use_pool;
+
+    pool = hg_mem_pool_create(HG_TEST_BENCH_OBJ_SIZE, 0, 0);
+    if (!pool) {
+        fprintf(stderr, "Error: could not create pool\n");
+        return EXIT_FAILURE;
+    }
+
+    for (use_pool = 0; use_pool < 2; use_pool++) {
+        hg_time_t t1, t2;
+        unsigned int i, j;
+
+        hg_time_get_current(&t1);
+        for (i = 0; i < HG_TEST_BENCH_ITER / HG_TEST_BENCH_OBJS; i++) {
+            for (j = 0; j < HG_TEST_BENCH_OBJS; j++)
+                objs[j] = use_pool ? hg_mem_pool_alloc(pool)
+                    : malloc(HG_TEST_BENCH_OBJ_SIZE);
+            for (j = 0; j < HG_TEST_BENCH_OBJS; j++) {
+                if (use_pool)
+                    hg_mem_pool_free(pool, objs[j]);
+                else
+                    free(objs[j]);
+            }
+        }
+        hg_time_get_current(&t2);
+
+        printf("%s: %.2f ns per alloc/free\n", use_pool ? "pool" : "malloc",
+            hg_time_to_double(hg_time_subtract(t2, t1)) * 1e9
+            / HG_TEST_BENCH_ITER);
+    }
+
+    hg_mem_pool_destroy(pool);
+    return EXIT_SUCCESS;
+}
+
+int
+main(void)
+{
+    int ret;
+
+    ret = test_pool();
+    if (ret != EXIT_SUCCESS)
+        goto done;
+
+    ret = test_pool_huge();
+    if (ret != EXIT_SUCCESS)
+        goto done;
+
+    ret = test_pool_mt();
+    if (ret != EXIT_SUCCESS)
+        goto done;
+
+    ret = test_pool_destroy_race();
+    if (ret != EXIT_SUCCESS)
+        goto done;
+
+    ret = test_pool_bench();
+
+done:
+    return ret;
+}
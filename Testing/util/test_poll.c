@@ -22,6 +22,65 @@ poll_cb(void *arg, int error, hg_util_bool_t *progressed)
     return HG_UTIL_SUCCESS;
 }
 
+struct hg_test_poll_remove_args {
+    hg_poll_set_t *poll_set;
+    int event_fds[2];
+    int count;
+};
+
+static int
+poll_remove_cb(void *arg, int error, hg_util_bool_t *progressed)
+{
+    struct hg_test_poll_remove_args *args =
+        (struct hg_test_poll_remove_args *) arg;
+    int i;
+    (void) error;
+
+    /* Whichever fd is dispatched first removes both, the other event was
+     * already returned by the same wait */
+    args->count++;
+    for (i = 0; i < 2; i++) {
+        hg_event_get(args->event_fds[i], progressed);
+        hg_poll_remove(args->poll_set, args->event_fds[i]);
+    }
+    *progressed = HG_UTIL_TRUE;
+
+    return HG_UTIL_SUCCESS;
+}
+
+static int
+test_remove_in_wait(void)
+{
+    struct hg_test_poll_remove_args args;
+    hg_util_bool_t progressed = HG_UTIL_FALSE;
+    int i, ret = EXIT_SUCCESS;
+
+    args.poll_set = hg_poll_create();
+    args.count = 0;
+    for (i = 0; i < 2; i++) {
+        args.event_fds[i] = hg_event_create();
+        hg_poll_add(args.poll_set, args.event_fds[i], HG_POLLIN,
+            poll_remove_cb, &args);
+        hg_event_set(args.event_fds[i]);
+    }
+
+    hg_poll_wait(args.poll_set, 1000, &progressed);
+    if (!progressed || args.count != 1) {
+        /* Removed fd must not be dispatched */
+        fprintf(stderr, "Error: removed fd was dispatched\n");
+        ret = EXIT_FAILURE;
+    }
+
+    if (hg_poll_destroy(args.poll_set) != HG_UTIL_SUCCESS) {
+        fprintf(stderr, "Error: could not destroy poll set\n");
+        ret = EXIT_FAILURE;
+    }
+    for (i = 0; i < 2; i++)
+        hg_event_destroy(args.event_fds[i]);
+
+    return ret;
+}
+
 int
 main(void)
 {
@@ -84,5 +143,8 @@ main(void)
     hg_poll_destroy(poll_set);
     hg_event_destroy(event_fd);
 
+    if (test_remove_in_wait() != EXIT_SUCCESS)
+        ret = EXIT_FAILURE;
+
     return ret;
 }
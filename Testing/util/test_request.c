@@ -1,4 +1,6 @@
 #include "mercury_request.h"
+#include "mercury_thread.h"
+#include "mercury_thread_mutex.h"
 
 #include "mercury_test_config.h"
 
@@ -51,6 +53,110 @@ trigger(unsigned int timeout, unsigned int *flag, void *arg)
     return HG_UTIL_SUCCESS;
 }
 
+#define MT_NUM_THREADS 16
+#define MT_NUM_ITER 1000
+
+static hg_thread_mutex_t mt_mutex;
+static hg_request_t *mt_pending[MT_NUM_THREADS];
+static unsigned int mt_pending_head = 0, mt_pending_count = 0;
+static hg_atomic_int32_t mt_errors;
+
+static int
+mt_progress(unsigned int timeout, void *arg)
+{
+    (void) timeout;
+    (void) arg;
+
+    return HG_UTIL_SUCCESS;
+}
+
+static int
+mt_trigger(unsigned int timeout, unsigned int *flag, void *arg)
+{
+    hg_request_t *mt_request = NULL;
+
+    (void) timeout;
+    (void) arg;
+
+    /* Complete pending requests one at a time, in order */
+    hg_thread_mutex_lock(&mt_mutex);
+    if (mt_pending_count) {
+        mt_request = mt_pending[mt_pending_head];
+        mt_pending_head = (mt_pending_head + 1) % MT_NUM_THREADS;
+        mt_pending_count--;
+    }
+    hg_thread_mutex_unlock(&mt_mutex);
+
+    if (mt_request) {
+        (*(int *) hg_request_get_data(mt_request))++;
+        hg_request_complete(mt_request);
+    }
+    *flag = (mt_request != NULL);
+
+    return HG_UTIL_SUCCESS;
+}
+
+static HG_THREAD_RETURN_TYPE
+mt_thread_cb(void *arg)
+{
+    hg_thread_ret_t thread_ret = (hg_thread_ret_t) 0;
+    hg_request_class_t *request_class = (hg_request_class_t *) arg;
+    hg_request_t *mt_request;
+    int user_data = 0;
+    int i;
+
+    mt_request = hg_request_create(request_class);
+    hg_request_set_data(mt_request, &user_data);
+
+    for (i = 0; i < MT_NUM_ITER; i++) {
+        unsigned int flag = 0;
+
+        hg_thread_mutex_lock(&mt_mutex);
+        mt_pending[(mt_pending_head + mt_pending_count) % MT_NUM_THREADS] =
+            mt_request;
+        mt_pending_count++;
+        hg_thread_mutex_unlock(&mt_mutex);
+
+        hg_request_wait(mt_request, 1000, &flag);
+        if (!flag) {
+            fprintf(stderr, "Error: request did not complete\n");
+            hg_atomic_incr32(&mt_errors);
+            break;
+        }
+    }
+    if (user_data != MT_NUM_ITER) {
+        fprintf(stderr, "Error: user data is %d\n", user_data);
+        hg_atomic_incr32(&mt_errors);
+    }
+
+    hg_request_destroy(mt_request);
+
+    hg_thread_exit(thread_ret);
+    return thread_ret;
+}
+
+static int
+test_request_mt(void)
+{
+    hg_request_class_t *request_class;
+    hg_thread_t threads[MT_NUM_THREADS];
+    int i;
+
+    hg_thread_mutex_init(&mt_mutex);
+    hg_atomic_init32(&mt_errors, 0);
+    request_class = hg_request_init(mt_progress, mt_trigger, NULL);
+
+    for (i = 0; i < MT_NUM_THREADS; i++)
+        hg_thread_create(&threads[i], mt_thread_cb, request_class);
+    for (i = 0; i < MT_NUM_THREADS; i++)
+        hg_thread_join(threads[i]);
+
+    hg_request_finalize(request_class, NULL);
+    hg_thread_mutex_destroy(&mt_mutex);
+
+    return (hg_atomic_get32(&mt_errors) == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -79,5 +185,8 @@ main(int argc, char *argv[])
     hg_request_destroy(request);
     hg_request_finalize(request_class, NULL);
 
+    if (ret == EXIT_SUCCESS)
+        ret = test_request_mt();
+
     return ret;
 }
@@ -56,6 +56,15 @@ done:
     return thread_ret;
 }
 
+static int key_destructor_count = 0;
+
+static void
+key_destructor(void *value)
+{
+    if (value)
+        key_destructor_count++;
+}
+
 static HG_THREAD_RETURN_TYPE
 thread_cb_equal(void *arg)
 {
@@ -95,11 +104,22 @@ main(int argc, char *argv[])
     hg_thread_cancel(thread);
     hg_thread_join(thread);
 
-    hg_thread_key_create(&thread_key);
+    hg_thread_key_create(&thread_key, NULL);
     hg_thread_create(&thread, thread_cb_key, &thread_key);
     hg_thread_join(thread);
     hg_thread_key_delete(thread_key);
 
+    hg_thread_key_create(&thread_key, key_destructor);
+    hg_thread_create(&thread, thread_cb_key, &thread_key);
+    hg_thread_join(thread);
+    hg_thread_key_delete(thread_key);
+    if (key_destructor_count != 1) {
+        fprintf(stderr, "Error: Key destructor called %d times\n",
+            key_destructor_count);
+        ret = EXIT_FAILURE;
+        goto done;
+    }
+
     hg_thread_create(&thread, thread_cb_equal, &thread);
     hg_thread_join(thread);
 
@@ -1,5 +1,6 @@
 #include "mercury_thread_pool.h"
 #include "mercury_thread_mutex.h"
+#include "mercury_atomic.h"
 
 #include "mercury_test_config.h"
 
@@ -29,6 +30,12 @@ myfunc(void *args)
 static unsigned int ncalls = 0;
 static hg_thread_mutex_t mymutex;
 
+#define POOL_NUM_SPAWNS 8
+
+static hg_thread_pool_t *spawn_pool;
+static struct hg_thread_work spawn_work[POOL_NUM_POSTS][POOL_NUM_SPAWNS];
+static hg_atomic_int32_t nspawned;
+
 static HG_THREAD_RETURN_TYPE
 myfunc(void *args)
 {
@@ -43,6 +50,62 @@ myfunc(void *args)
     return ret;
 }
 
+static HG_THREAD_RETURN_TYPE
+spawned_func(void *args)
+{
+    hg_thread_ret_t ret = 0;
+    (void) args;
+
+    hg_atomic_incr32(&nspawned);
+
+    return ret;
+}
+
+/* Post more work from within the pool so that workers queue it locally and
+ * other workers steal it */
+static HG_THREAD_RETURN_TYPE
+spawn_func(void *args)
+{
+    hg_thread_ret_t ret = 0;
+    struct hg_thread_work *work = (struct hg_thread_work *) args;
+    int i;
+
+    for (i = 0; i < POOL_NUM_SPAWNS; i++) {
+        work[i].func = spawned_func;
+        work[i].args = NULL;
+        hg_thread_pool_post(spawn_pool, &work[i]);
+    }
+
+    return ret;
+}
+
+static int
+test_spawn(void)
+{
+    struct hg_thread_work work[POOL_NUM_POSTS];
+    int i;
+
+    hg_atomic_init32(&nspawned, 0);
+    hg_thread_pool_init(HG_TEST_NUM_THREADS_DEFAULT, &spawn_pool);
+
+    for (i = 0; i < POOL_NUM_POSTS; i++) {
+        work[i].func = spawn_func;
+        work[i].args = spawn_work[i];
+        hg_thread_pool_post(spawn_pool, &work[i]);
+    }
+
+    /* Destroy waits for all the work, including spawned work */
+    hg_thread_pool_destroy(spawn_pool);
+
+    if (hg_atomic_get32(&nspawned) != POOL_NUM_POSTS * POOL_NUM_SPAWNS) {
+        fprintf(stderr, "Did not execute all the operations spawned (%d/%d)\n",
+                hg_atomic_get32(&nspawned), POOL_NUM_POSTS * POOL_NUM_SPAWNS);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -71,5 +134,9 @@ main(int argc, char *argv[])
                 ncalls, POOL_NUM_POSTS);
         ret = EXIT_FAILURE;
     }
+
+    if (ret == EXIT_SUCCESS)
+        ret = test_spawn();
+
     return ret;
 }
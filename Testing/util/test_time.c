@@ -6,6 +6,92 @@
 #include <stdlib.h>
 #include <math.h>
 
+static int
+test_ticks(void)
+{
+    hg_time_t sleep_time = {0, 100000};
+    hg_time_t t1, t2, c1, c2;
+    hg_time_ticks_t ticks1, ticks2;
+    double elapsed, ticks_elapsed;
+
+    /* Tick source is selected lazily, not when the library is loaded */
+    if (hg_atomic_get32(&hg_time_ticks_info_g.ready)) {
+        fprintf(stderr, "Error: tick source selected before first use\n");
+        return EXIT_FAILURE;
+    }
+    ticks1 = hg_time_get_ticks();
+    if (!hg_atomic_get32(&hg_time_ticks_info_g.ready)) {
+        fprintf(stderr, "Error: tick source not selected\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("Tick source: %s (%.0f Hz)\n",
+        hg_time_ticks_info_g.use_counter ? "CPU counter" : "monotonic clock",
+        hg_time_ticks_info_g.ticks_per_sec);
+
+    hg_time_get_current_coarse(&c1);
+    hg_time_get_current(&t1);
+    ticks1 = hg_time_get_ticks();
+    hg_time_sleep(sleep_time);
+    ticks2 = hg_time_get_ticks();
+    hg_time_get_current(&t2);
+    hg_time_get_current_coarse(&c2);
+
+    if (ticks2 <= ticks1 || hg_time_less(c2, c1)) {
+        fprintf(stderr, "Error: clock went backwards\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Tick interval must agree with regular clock */
+    elapsed = hg_time_to_double(hg_time_subtract(t2, t1));
+    ticks_elapsed = hg_time_ticks_to_double(ticks2 - ticks1);
+    if (ticks_elapsed < hg_time_to_double(sleep_time)
+        || fabs(ticks_elapsed - elapsed) > 0.01 * elapsed + 1e-5) {
+        fprintf(stderr, "Error: ticks measured %f s, clock measured %f s\n",
+            ticks_elapsed, elapsed);
+        return EXIT_FAILURE;
+    }
+
+    if (hg_time_ticks_to_ns(hg_time_ticks_from_double(1.0)) < 999000000
+        || hg_time_ticks_to_ns(hg_time_ticks_from_double(1.0)) > 1001000000) {
+        fprintf(stderr, "Error: tick conversion mismatch\n");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+#define HG_TEST_BENCH_ITER 1000000
+
+/* Measure cost of reading each clock */
+static void
+test_ticks_bench(void)
+{
+    hg_time_ticks_t start, sum = 0;
+    hg_time_t tv;
+    int i;
+
+    start = hg_time_get_ticks();
+    for (i = 0; i < HG_TEST_BENCH_ITER; i++)
+        sum += hg_time_get_ticks();
+    printf("hg_time_get_ticks: %.2f ns\n", (double) hg_time_ticks_to_ns(
+        hg_time_get_ticks() - start) / HG_TEST_BENCH_ITER);
+
+    start = hg_time_get_ticks();
+    for (i = 0; i < HG_TEST_BENCH_ITER; i++)
+        hg_time_get_current(&tv);
+    printf("hg_time_get_current: %.2f ns\n", (double) hg_time_ticks_to_ns(
+        hg_time_get_ticks() - start) / HG_TEST_BENCH_ITER);
+
+    start = hg_time_get_ticks();
+    for (i = 0; i < HG_TEST_BENCH_ITER; i++)
+        hg_time_get_current_coarse(&tv);
+    printf("hg_time_get_current_coarse: %.2f ns\n", (double)
+        hg_time_ticks_to_ns(hg_time_get_ticks() - start) / HG_TEST_BENCH_ITER);
+
+    (void) sum;
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -63,6 +149,12 @@ main(int argc, char *argv[])
         goto done;
     }
 
+    ret = test_ticks();
+    if (ret != EXIT_SUCCESS)
+        goto done;
+
+    test_ticks_bench();
+
 done:
     return ret;
 }
@@ -12,6 +12,7 @@
 #include "mercury_bulk.h"
 #include "mercury_proc.h"
 #include "mercury_proc_bulk.h"
+#include "mercury_private.h"
 #include "mercury_error.h"
 
 #include "mercury_hash_string.h"
@@ -41,6 +42,7 @@ struct hg_private_class {
     hg_return_t (*handle_create)(hg_handle_t, void *);  /* handle_create */
     void *handle_create_arg;                            /* handle_create arg */
     hg_thread_spin_t register_lock; /* Register lock */
+    hg_mem_pool_t *bulk_op_pool;    /* Pool of bulk op IDs */
 };
 
 /* Info for function map */
@@ -926,6 +928,13 @@ hg_core_respond_cb(const struct hg_core_cb_info *callback_info)
     return ret;
 }
 
+/*---------------------------------------------------------------------------*/
+hg_mem_pool_t *
+hg_bulk_op_pool_get(hg_class_t *hg_class)
+{
+    return ((struct hg_private_class *) hg_class)->bulk_op_pool;
+}
+
 /*---------------------------------------------------------------------------*/
 hg_return_t
 HG_Version_get(unsigned int *major, unsigned int *minor, unsigned int *patch)
@@ -978,6 +987,10 @@ HG_Init_opt(const char *na_info_string, hg_bool_t na_listen,
     memset(hg_class, 0, sizeof(struct hg_private_class));
     hg_thread_spin_init(&hg_class->register_lock);
 
+    hg_class->bulk_op_pool = hg_bulk_op_pool_create();
+    HG_CHECK_ERROR_NORET(hg_class->bulk_op_pool == NULL, error,
+        "Could not create bulk op ID pool");
+
     hg_class->hg_class.core_class = HG_Core_init_opt(na_info_string, na_listen,
         hg_init_info);
     HG_CHECK_ERROR_NORET(hg_class->hg_class.core_class == NULL, error,
@@ -991,6 +1004,7 @@ HG_Init_opt(const char *na_info_string, hg_bool_t na_listen,
 
 error:
     if (hg_class) {
+        hg_mem_pool_destroy(hg_class->bulk_op_pool);
         hg_thread_spin_destroy(&hg_class->register_lock);
         free(hg_class);
     }
@@ -1008,6 +1022,7 @@ HG_Finalize(hg_class_t *hg_class)
     ret = HG_Core_finalize(private_class->hg_class.core_class);
     HG_CHECK_HG_ERROR(done, ret, "Could not finalize HG core class");
 
+    hg_mem_pool_destroy(private_class->bulk_op_pool);
     hg_thread_spin_destroy(&private_class->register_lock);
     free(private_class);
 
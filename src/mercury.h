@@ -374,6 +374,45 @@ HG_Context_get_data(
         const hg_context_t *context
         );
 
+/**
+ * Retrieve a file descriptor associated to the context, so that progress on the
+ * context can be driven from an external event loop (select, poll, epoll, etc).
+ * The descriptor becomes readable when progress on the underlying NA plugin is
+ * needed or when completions are queued to the context, including from another
+ * thread. The descriptor is level-triggered and remains readable until
+ * HG_Progress() has been called; when it is registered in edge-triggered mode,
+ * HG_Progress() with a timeout of 0 and HG_Trigger() must be called until
+ * progress returns HG_TIMEOUT. Since some plugins may have pending work that
+ * does not make the descriptor readable, HG_Context_try_wait() must be called
+ * before blocking on it. A typical loop consists of: blocking on the descriptor
+ * if HG_Context_try_wait() returns HG_TRUE, then calling HG_Progress() with a
+ * timeout of 0 followed by HG_Trigger() until no callback is triggered. The
+ * descriptor must not be read from or closed by the caller.
+ *
+ * \param context [IN]          pointer to HG context
+ *
+ * \return Non-negative integer if supported or negative if the plugin does not
+ * expose any descriptor, if NA_NO_BLOCK was requested or in case of error
+ */
+static HG_INLINE int
+HG_Context_get_fd(
+        hg_context_t *context
+        );
+
+/**
+ * Used to signal when it is safe to block on the descriptor returned by
+ * HG_Context_get_fd() or if blocking could hang the application (e.g.,
+ * completions are already queued).
+ *
+ * \param context [IN]          pointer to HG context
+ *
+ * \return HG_TRUE if it is safe to block or HG_FALSE otherwise
+ */
+static HG_INLINE hg_bool_t
+HG_Context_try_wait(
+        hg_context_t *context
+        );
+
 /**
  * Dynamically register a function func_name as an RPC as well as the
  * RPC callback executed when the RPC request ID associated to func_name is
@@ -996,6 +1035,10 @@ HG_Set_target_id(
  * registered input proc. After completion, user callback is placed into a
  * completion queue and can be triggered using HG_Trigger(). RPC output can
  * be queried using HG_Get_output() and freed using HG_Free_output().
+ * HG_AGAIN is returned when the NA plugin is temporarily out of resources,
+ * the call can then be retried with the same handle; when NA direct
+ * completion is enabled, HG_Trigger() must be called on the handle's context
+ * before the retry can succeed (see HG_Core_forward()).
  *
  * \remark This routine is internally equivalent to:
  *   - HG_Core_get_input()
@@ -1007,7 +1050,7 @@ HG_Set_target_id(
  * \param arg [IN]              pointer to data passed to callback
  * \param in_struct [IN]        pointer to input structure
  *
- * \return HG_SUCCESS or corresponding HG error code
+ * \return HG_SUCCESS, HG_AGAIN or corresponding HG error code
  */
 HG_PUBLIC hg_return_t
 HG_Forward(
@@ -1229,6 +1272,20 @@ HG_Context_get_data(const hg_context_t *context)
     return HG_Core_context_get_data(context->core_context);
 }
 
+/*---------------------------------------------------------------------------*/
+static HG_INLINE int
+HG_Context_get_fd(hg_context_t *context)
+{
+    return HG_Core_context_get_fd(context->core_context);
+}
+
+/*---------------------------------------------------------------------------*/
+static HG_INLINE hg_bool_t
+HG_Context_try_wait(hg_context_t *context)
+{
+    return HG_Core_context_try_wait(context->core_context);
+}
+
 /*---------------------------------------------------------------------------*/
 static HG_INLINE hg_return_t
 HG_Ref_incr(hg_handle_t handle)
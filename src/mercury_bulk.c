@@ -25,6 +25,10 @@
 #define HG_BULK_MIN(a, b) \
     (a < b) ? a : b
 
+/* Number of NA operation descriptors that can be submitted without
+ * allocating a descriptor array */
+#define HG_BULK_STATIC_OP_DESCS 8
+
 /* Remove warnings when plugin does not use callback arguments */
 #if defined(__cplusplus)
 # define HG_BULK_UNUSED
@@ -54,6 +58,7 @@ struct hg_bulk_op_id {
     struct hg_bulk *hg_bulk_origin;       /* Origin handle */
     struct hg_bulk *hg_bulk_local;        /* Local handle */
     na_op_id_t *na_op_ids ;               /* NA operations IDs */
+    na_op_id_t na_op_id;                  /* Storage for single NA op ID */
     hg_context_t *context;                /* Context */
     na_class_t *na_class;                 /* NA class */
     na_context_t *na_context;             /* NA context */
@@ -100,6 +105,8 @@ struct hg_bulk {
 #endif
     hg_core_addr_t addr;                 /* Addr (valid if bound to handle) */
     struct hg_bulk_segment *segments;    /* Array of segments */
+    na_class_t *segment_na_class;        /* NA class segments come from */
+    void **segment_plugin_data;          /* NA_Mem_alloc() plugin data */
     na_mem_handle_t *na_mem_handles;     /* Array of NA memory handles */
 #ifdef HG_HAS_SM_ROUTING
     na_mem_handle_t *na_sm_mem_handles;  /* Array of NA SM memory handles */
@@ -182,6 +189,7 @@ hg_bulk_transfer_cb(
 static hg_return_t
 hg_bulk_transfer_pieces(
         na_bulk_op_t na_bulk_op,
+        struct na_op_desc *na_op_descs,
         na_addr_t origin_addr,
         na_uint8_t origin_id,
         hg_bool_t use_sm,
@@ -216,6 +224,15 @@ hg_bulk_transfer(
         hg_op_id_t *op_id
         );
 
+/**
+ * Cancel posted NA operations after a partial post failure.
+ */
+static void
+hg_bulk_transfer_abort(
+        struct hg_bulk_op_id *hg_bulk_op_id,
+        unsigned int posted
+        );
+
 /**
  * Complete operation ID.
  */
@@ -373,6 +390,7 @@ hg_bulk_create(struct hg_class *hg_class, hg_uint32_t count,
 #endif
     hg_bool_t use_register_segments = (hg_bool_t)
         (na_class->ops->mem_handle_create_segments && count > 1);
+    na_class_t *segment_na_class = na_class;
     unsigned int i;
 
     hg_bulk = (struct hg_bulk *) malloc(sizeof(struct hg_bulk));
@@ -400,6 +418,20 @@ hg_bulk_create(struct hg_class *hg_class, hg_uint32_t count,
     memset(hg_bulk->segments, 0,
            hg_bulk->segment_count * sizeof(struct hg_bulk_segment));
 
+    if (!buf_ptrs) {
+        /* Let NA allocate memory that peers can access efficiently, prefer
+         * SM so that local peers can map it directly */
+#ifdef HG_HAS_SM_ROUTING
+        if (na_sm_class)
+            segment_na_class = na_sm_class;
+#endif
+        hg_bulk->segment_na_class = segment_na_class;
+        hg_bulk->segment_plugin_data = (void **) calloc(
+            hg_bulk->segment_count, sizeof(void *));
+        HG_CHECK_ERROR(hg_bulk->segment_plugin_data == NULL, error, ret,
+            HG_NOMEM, "Could not allocate segment plugin data array");
+    }
+
     /* Loop over the list of segments */
     for (i = 0; i < hg_bulk->segment_count; i++) {
         hg_bulk->segments[i].size = buf_sizes[i];
@@ -407,10 +439,12 @@ hg_bulk_create(struct hg_class *hg_class, hg_uint32_t count,
 
         if (buf_ptrs)
             hg_bulk->segments[i].address = (hg_ptr_t) buf_ptrs[i];
-        else {
-            /* Use calloc to avoid uninitialized memory used for transfer */
-            hg_bulk->segments[i].address = (hg_ptr_t) calloc(
-                hg_bulk->segments[i].size, sizeof(char));
+        else if (hg_bulk->segments[i].size) {
+            /* Memory is zeroed to avoid uninitialized memory used for
+             * transfer */
+            hg_bulk->segments[i].address = (hg_ptr_t) NA_Mem_alloc(
+                segment_na_class, hg_bulk->segments[i].size,
+                &hg_bulk->segment_plugin_data[i]);
             HG_CHECK_ERROR(hg_bulk->segments[i].address == (hg_ptr_t ) 0, error,
                 ret, HG_NOMEM, "Could not allocate segment");
         }
@@ -607,7 +641,22 @@ hg_bulk_free(struct hg_bulk *hg_bulk)
     }
 
     /* Free segments */
-    if (hg_bulk->segment_alloc) {
+    if (hg_bulk->segment_alloc && hg_bulk->segment_plugin_data) {
+        for (i = 0; i < hg_bulk->segment_count; i++) {
+            na_return_t na_ret;
+
+            if (!hg_bulk->segments[i].address)
+                continue;
+
+            na_ret = NA_Mem_free(hg_bulk->segment_na_class,
+                (void *) hg_bulk->segments[i].address,
+                hg_bulk->segment_plugin_data[i]);
+            HG_CHECK_ERROR(na_ret != NA_SUCCESS, done, ret,
+                (hg_return_t) na_ret, "NA_Mem_free() failed (%s)",
+                NA_Error_to_string(na_ret));
+        }
+        free(hg_bulk->segment_plugin_data);
+    } else if (hg_bulk->segment_alloc) {
         for (i = 0; i < hg_bulk->segment_count; i++) {
             free((void *) hg_bulk->segments[i].address);
         }
@@ -726,7 +775,8 @@ done:
 
 /*---------------------------------------------------------------------------*/
 static hg_return_t
-hg_bulk_transfer_pieces(na_bulk_op_t na_bulk_op, na_addr_t origin_addr, na_uint8_t origin_id,
+hg_bulk_transfer_pieces(na_bulk_op_t na_bulk_op,
+    struct na_op_desc *na_op_descs, na_addr_t origin_addr, na_uint8_t origin_id,
     hg_bool_t HG_BULK_UNUSED use_sm, struct hg_bulk *hg_bulk_origin,
     hg_size_t origin_segment_start_index, hg_size_t origin_segment_start_offset,
     struct hg_bulk *hg_bulk_local, hg_size_t local_segment_start_index,
@@ -776,7 +826,25 @@ hg_bulk_transfer_pieces(na_bulk_op_t na_bulk_op, na_addr_t origin_addr, na_uint8
             transfer_size = HG_BULK_MIN(remaining_size, transfer_size);
         }
 
-        if (na_bulk_op) {
+        if (na_op_descs) {
+            /* Only record operation, posted by caller as a single batch */
+            struct na_op_desc *na_op_desc = &na_op_descs[count];
+
+            na_op_desc->type = (hg_bulk_op_id->op == HG_BULK_PUSH) ?
+                NA_CB_PUT : NA_CB_GET;
+            na_op_desc->callback = hg_bulk_transfer_cb;
+            na_op_desc->arg = hg_bulk_op_id;
+            na_op_desc->info.rma.local_mem_handle =
+                na_local_mem_handles[na_local_segment_index];
+            na_op_desc->info.rma.local_offset = local_segment_offset;
+            na_op_desc->info.rma.remote_mem_handle =
+                na_origin_mem_handles[na_origin_segment_index];
+            na_op_desc->info.rma.remote_offset = origin_segment_offset;
+            na_op_desc->info.rma.length = transfer_size;
+            na_op_desc->info.rma.remote_addr = origin_addr;
+            na_op_desc->info.rma.remote_id = origin_id;
+            na_op_desc->op_id = &hg_bulk_op_id->na_op_ids[count];
+        } else if (na_bulk_op) {
             na_ret = na_bulk_op(hg_bulk_op_id->na_class,
                 hg_bulk_op_id->na_context, hg_bulk_transfer_cb, hg_bulk_op_id,
                 na_local_mem_handles[na_local_segment_index],
@@ -856,8 +924,10 @@ hg_bulk_transfer(hg_context_t *context, hg_cb_t callback, void *arg,
     hg_bool_t scatter_gather =
         (na_class->ops->mem_handle_create_segments && !is_self) ? HG_TRUE :
             HG_FALSE;
+    struct na_op_desc na_op_descs_static[HG_BULK_STATIC_OP_DESCS];
+    struct na_op_desc *na_op_descs = NULL;
+    unsigned int na_op_count = 0, i;
     hg_return_t ret = HG_SUCCESS;
-    unsigned int i;
 
     /* Map op to NA op */
     switch (op) {
@@ -876,8 +946,8 @@ hg_bulk_transfer(hg_context_t *context, hg_cb_t callback, void *arg,
     }
 
     /* Allocate op_id */
-    hg_bulk_op_id = (struct hg_bulk_op_id *) malloc(
-        sizeof(struct hg_bulk_op_id));
+    hg_bulk_op_id = (struct hg_bulk_op_id *) hg_mem_pool_alloc(
+        hg_bulk_op_pool_get(hg_bulk_local->hg_class));
     HG_CHECK_ERROR(hg_bulk_op_id == NULL, error, ret, HG_NOMEM,
         "Could not allocate HG Bulk operation ID");
 
@@ -920,7 +990,8 @@ hg_bulk_transfer(hg_context_t *context, hg_cb_t callback, void *arg,
 
     /* Figure out number of NA operations required */
     if (!scatter_gather) {
-        ret = hg_bulk_transfer_pieces(NULL, NA_ADDR_NULL, origin_id, use_sm,
+        ret = hg_bulk_transfer_pieces(NULL, NULL, NA_ADDR_NULL, origin_id,
+            use_sm,
             hg_bulk_origin, origin_segment_start_index,
             origin_segment_start_offset, hg_bulk_local,
             local_segment_start_index, local_segment_start_offset, size,
@@ -931,26 +1002,69 @@ hg_bulk_transfer(hg_context_t *context, hg_cb_t callback, void *arg,
     }
 
     /* Allocate memory for NA operation IDs */
-    hg_bulk_op_id->na_op_ids = malloc(
-        sizeof(na_op_id_t) * hg_bulk_op_id->op_count);
+    if (hg_bulk_op_id->op_count == 1)
+        hg_bulk_op_id->na_op_ids = &hg_bulk_op_id->na_op_id;
+    else
+        hg_bulk_op_id->na_op_ids = malloc(
+            sizeof(na_op_id_t) * hg_bulk_op_id->op_count);
     HG_CHECK_ERROR(hg_bulk_op_id->na_op_ids == NULL, error, ret, HG_NOMEM,
         "Could not allocate memory for op_ids");
 
-    for (i = 0; i < hg_bulk_op_id->op_count; i++) {
-        hg_bulk_op_id->na_op_ids[i] = NA_Op_create(hg_bulk_op_id->na_class);
-        HG_CHECK_ERROR(hg_bulk_op_id->na_op_ids[i] == NA_OP_ID_NULL, error, ret,
-            HG_NA_ERROR, "Could not create NA op ID");
+    for (na_op_count = 0; na_op_count < hg_bulk_op_id->op_count;
+        na_op_count++) {
+        hg_bulk_op_id->na_op_ids[na_op_count] =
+            NA_Op_create(hg_bulk_op_id->na_class);
+        HG_CHECK_ERROR(hg_bulk_op_id->na_op_ids[na_op_count] == NA_OP_ID_NULL,
+            error, ret, HG_NA_ERROR, "Could not create NA op ID");
+    }
+
+    /* Operations that go through NA are described first and then posted
+     * as a single batch */
+    if (na_bulk_op == hg_bulk_na_put || na_bulk_op == hg_bulk_na_get) {
+        if (hg_bulk_op_id->op_count > HG_BULK_STATIC_OP_DESCS) {
+            na_op_descs = (struct na_op_desc *) malloc(
+                sizeof(struct na_op_desc) * hg_bulk_op_id->op_count);
+            HG_CHECK_ERROR(na_op_descs == NULL, error, ret, HG_NOMEM,
+                "Could not allocate NA operation descriptors");
+        } else
+            na_op_descs = na_op_descs_static;
+        na_bulk_op = NULL;
     }
 
     /* Do actual transfer */
-    ret = hg_bulk_transfer_pieces(na_bulk_op, na_origin_addr, origin_id, use_sm,
-        hg_bulk_origin, origin_segment_start_index, origin_segment_start_offset,
-        hg_bulk_local, local_segment_start_index, local_segment_start_offset,
-        size, scatter_gather, hg_bulk_op_id, NULL);
+    ret = hg_bulk_transfer_pieces(na_bulk_op, na_op_descs, na_origin_addr,
+        origin_id, use_sm, hg_bulk_origin, origin_segment_start_index,
+        origin_segment_start_offset, hg_bulk_local, local_segment_start_index,
+        local_segment_start_offset, size, scatter_gather, hg_bulk_op_id, NULL);
     if (ret == HG_AGAIN)
        goto error;
     HG_CHECK_HG_ERROR(error, ret, "Could not transfer data pieces");
 
+    if (na_op_descs) {
+        na_size_t posted = 0;
+        na_return_t na_ret = NA_Submit(hg_bulk_op_id->na_class,
+            hg_bulk_op_id->na_context, na_op_descs, hg_bulk_op_id->op_count,
+            &posted);
+        if (na_ret != NA_SUCCESS && posted == 0) {
+            if (na_ret == NA_AGAIN)
+                HG_GOTO_DONE(error, ret, HG_AGAIN);
+            HG_GOTO_ERROR(error, ret, (hg_return_t) na_ret,
+                "Could not transfer data (%s)", NA_Error_to_string(na_ret));
+        }
+        if (na_op_descs != na_op_descs_static)
+            free(na_op_descs);
+        na_op_descs = NULL;
+
+        /* Operations already posted still reference the op ID, cancel them
+         * and let the op ID complete as canceled once they have returned */
+        if (na_ret != NA_SUCCESS) {
+            HG_LOG_WARNING("Only %u out of %u NA operations posted (%s), "
+                "canceling transfer", (unsigned int) posted,
+                hg_bulk_op_id->op_count, NA_Error_to_string(na_ret));
+            hg_bulk_transfer_abort(hg_bulk_op_id, (unsigned int) posted);
+        }
+    }
+
     /* Assign op_id */
     if (op_id && op_id != HG_OP_ID_IGNORE)
         *op_id = (hg_op_id_t) hg_bulk_op_id;
@@ -958,13 +1072,50 @@ hg_bulk_transfer(hg_context_t *context, hg_cb_t callback, void *arg,
     return ret;
 
 error:
+    if (na_op_descs != na_op_descs_static)
+        free(na_op_descs);
     if (hg_bulk_op_id) {
-        free(hg_bulk_op_id->na_op_ids);
-        free(hg_bulk_op_id);
+        /* Nothing was posted, NA no longer references the op ID */
+        for (i = 0; i < na_op_count; i++)
+            NA_Op_destroy(hg_bulk_op_id->na_class, hg_bulk_op_id->na_op_ids[i]);
+        if (hg_bulk_op_id->na_op_ids != &hg_bulk_op_id->na_op_id)
+            free(hg_bulk_op_id->na_op_ids);
+        hg_atomic_decr32(&hg_bulk_op_id->hg_bulk_origin->ref_count);
+        hg_atomic_decr32(&hg_bulk_op_id->hg_bulk_local->ref_count);
+        hg_mem_pool_free(hg_bulk_op_pool_get(hg_bulk_local->hg_class),
+            hg_bulk_op_id);
     }
     return ret;
 }
 
+/*---------------------------------------------------------------------------*/
+static void
+hg_bulk_transfer_abort(struct hg_bulk_op_id *hg_bulk_op_id,
+    unsigned int posted)
+{
+    unsigned int i;
+
+    hg_atomic_set32(&hg_bulk_op_id->canceled, 1);
+
+    /* Completion cannot happen before all unposted operations are accounted
+     * for below, op IDs are therefore still valid */
+    for (i = 0; i < posted; i++) {
+        na_return_t na_ret = NA_Cancel(hg_bulk_op_id->na_class,
+            hg_bulk_op_id->na_context, hg_bulk_op_id->na_op_ids[i]);
+        HG_CHECK_WARNING(na_ret != NA_SUCCESS, "Could not cancel NA op ID (%s)",
+            NA_Error_to_string(na_ret));
+    }
+
+    /* Account for unposted operations, op ID may be completed and freed by
+     * the last increment (here or from an NA callback) */
+    for (i = posted; i < hg_bulk_op_id->op_count; i++)
+        if ((unsigned int) hg_atomic_incr32(&hg_bulk_op_id->op_completed_count)
+            == hg_bulk_op_id->op_count) {
+            hg_bulk_complete(hg_bulk_op_id);
+            break;
+        }
+}
+
 /*---------------------------------------------------------------------------*/
 static hg_return_t
 hg_bulk_complete(struct hg_bulk_op_id *hg_bulk_op_id)
@@ -1001,6 +1152,7 @@ done:
 hg_return_t
 hg_bulk_trigger_entry(struct hg_bulk_op_id *hg_bulk_op_id)
 {
+    hg_class_t *hg_class = hg_bulk_op_id->hg_bulk_local->hg_class;
     hg_return_t ret = HG_SUCCESS;
     unsigned int i;
 
@@ -1036,13 +1188,21 @@ hg_bulk_trigger_entry(struct hg_bulk_op_id *hg_bulk_op_id)
         HG_CHECK_ERROR(na_ret != NA_SUCCESS, done, ret, (hg_return_t) na_ret,
             "Could not destroy NA op ID (%s)", NA_Error_to_string(na_ret));
     }
-    free(hg_bulk_op_id->na_op_ids);
-    free(hg_bulk_op_id);
+    if (hg_bulk_op_id->na_op_ids != &hg_bulk_op_id->na_op_id)
+        free(hg_bulk_op_id->na_op_ids);
+    hg_mem_pool_free(hg_bulk_op_pool_get(hg_class), hg_bulk_op_id);
 
 done:
     return ret;
 }
 
+/*---------------------------------------------------------------------------*/
+hg_mem_pool_t *
+hg_bulk_op_pool_create(void)
+{
+    return hg_mem_pool_create(sizeof(struct hg_bulk_op_id), 0, 0);
+}
+
 /*---------------------------------------------------------------------------*/
 hg_return_t
 HG_Bulk_create(hg_class_t *hg_class, hg_uint32_t count, void **buf_ptrs,
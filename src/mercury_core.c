@@ -12,12 +12,11 @@
 #include "mercury_private.h"
 
 #include "mercury_atomic_queue.h"
-#ifdef HG_HAS_SELF_FORWARD
 #include "mercury_event.h"
-#endif
-#include "mercury_hash_table.h"
+#include "mercury_hash_map.h"
 #include "mercury_list.h"
 #include "mercury_mem.h"
+#include "mercury_mem_pool.h"
 #include "mercury_poll.h"
 #include "mercury_queue.h"
 #include "mercury_thread_condition.h"
@@ -38,16 +37,28 @@
 /* Local Macros */
 /****************/
 
-#define HG_CORE_ATOMIC_QUEUE_SIZE   1024
+#define HG_CORE_COMPLETION_QUEUE_SIZE 1024
 #define HG_CORE_PENDING_INCR        256
 #define HG_CORE_CLEANUP_TIMEOUT     1000
-#define HG_CORE_MAX_TRIGGER_COUNT   1
+#define HG_CORE_MAX_TRIGGER_COUNT   64  /* Max NA callbacks per trigger */
+#define HG_CORE_TRIGGER_BATCH_SIZE  64  /* Max entries popped at once */
+#define HG_CORE_POST_BATCH_SIZE     64  /* Max receives posted at once */
+#define HG_CORE_MIN(a, b)           (((a) < (b)) ? (a) : (b)) /* Min macro */
+#define HG_CORE_MAX(a, b)           (((a) > (b)) ? (a) : (b)) /* Max macro */
+
+/* NA completion entries pushed to the HG completion queue are tagged */
+#define HG_CORE_NA_ENTRY_TAG        ((uintptr_t) 0x1)
+#define HG_CORE_IS_NA_ENTRY(entry) \
+    (((uintptr_t) (entry)) & HG_CORE_NA_ENTRY_TAG)
+#define HG_CORE_NA_ENTRY_TO_PTR(entry) \
+    ((void *) (((uintptr_t) (entry)) & ~HG_CORE_NA_ENTRY_TAG))
+#define HG_CORE_PTR_TO_NA_ENTRY(ptr) \
+    ((void *) (((uintptr_t) (ptr)) | HG_CORE_NA_ENTRY_TAG))
 #ifdef HG_HAS_SM_ROUTING
 # define HG_CORE_UUID_MAX_LEN       36
 # define HG_CORE_ADDR_MAX_SIZE      256
 # define HG_CORE_PROTO_DELIMITER    ":"
 # define HG_CORE_ADDR_DELIMITER     "#"
-# define HG_CORE_MIN(a, b)          (a < b) ? a : b /* Min macro */
 #endif
 
 /* Remove warnings when routine does not use arguments */
@@ -91,7 +102,9 @@ struct hg_core_private_class {
 #ifdef HG_HAS_SM_ROUTING
     uuid_t na_sm_uuid;                  /* UUID for local identification */
 #endif
-    hg_hash_table_t *func_map;          /* Function map */
+    hg_hash_map_t *func_map;            /* Function map */
+    hg_mem_pool_t *addr_pool;           /* Pool of addrs */
+    hg_mem_pool_t *op_id_pool;          /* Pool of lookup op IDs */
     hg_return_t (*more_data_acquire)(hg_core_handle_t, hg_op_t,
         hg_return_t (*done_callback)(hg_core_handle_t)); /* more_data_acquire */
     void (*more_data_release)(hg_core_handle_t);         /* more_data_release */
@@ -99,8 +112,11 @@ struct hg_core_private_class {
     hg_atomic_int32_t n_contexts;       /* Atomic used for number of contexts */
     hg_atomic_int32_t n_addrs;          /* Atomic used for number of addrs */
     hg_atomic_int32_t request_tag;      /* Atomic used for tag generation */
-    hg_thread_spin_t func_map_lock;     /* Function map lock */
     na_progress_mode_t progress_mode;   /* NA progress mode */
+    unsigned int completion_queue_size; /* Context completion queue size */
+    hg_thread_key_t trigger_slot_key;   /* Key to thread trigger slot */
+    hg_bool_t na_direct_completion;     /* NA completes into HG queue */
+    hg_bool_t na_loan_recv;             /* Receive input in NA loaned bufs */
     hg_bool_t na_ext_init;              /* NA externally initialized */
 #ifdef HG_HAS_COLLECT_STATS
     hg_bool_t stats;                    /* (Debug) Print stats at exit */
@@ -112,8 +128,7 @@ struct hg_core_private_context {
     struct hg_core_context core_context;        /* Must remain as first field */
     hg_thread_cond_t  completion_queue_cond;    /* Completion queue cond */
     hg_thread_mutex_t completion_queue_mutex;   /* Completion queue mutex */
-    HG_QUEUE_HEAD(hg_completion_entry) backfill_queue;  /* Backfill completion queue */
-    struct hg_atomic_queue *completion_queue;           /* Default completion queue */
+    struct hg_atomic_queue_chain *completion_queue;     /* Completion queue */
     HG_LIST_HEAD(hg_core_private_handle) created_list;  /* List of handles for that context */
     HG_LIST_HEAD(hg_core_private_handle) pending_list;  /* List of pending handles */
 #ifdef HG_HAS_SM_ROUTING
@@ -124,17 +139,47 @@ struct hg_core_private_context {
     struct hg_poll_set *poll_set;               /* Context poll set */
     hg_return_t (*progress)(struct hg_core_private_context *context,
         unsigned int timeout);                  /* Progress function */
-    hg_atomic_int32_t backfill_queue_count;     /* Backfill queue count */
     hg_atomic_int32_t trigger_waiting;          /* Waiting in trigger */
     hg_atomic_int32_t n_handles;                /* Atomic used for number of handles */
     hg_thread_spin_t created_list_lock;         /* Handle list lock */
     hg_thread_spin_t pending_list_lock;         /* Pending list lock */
-#ifdef HG_HAS_SELF_FORWARD
-    int completion_queue_notify;                /* Self notification */
+    int completion_queue_notify;                /* Completion notification */
+    hg_atomic_int32_t fd_exposed;               /* Poll fd handed out */
+    struct hg_core_poll_group_entry *poll_group_entry; /* Poll group entry */
+    hg_bool_t na_poll_registered;               /* NA fds in context poll set */
+#ifdef HG_HAS_SM_ROUTING
+    hg_bool_t na_sm_poll_registered;            /* NA SM fds in context poll set */
 #endif
     hg_bool_t finalizing;                       /* Prevent reposts */
 };
 
+/* Trigger slot, captures the HG completion entry produced by an NA callback
+ * so that it can be triggered without going through the completion queue */
+struct hg_core_trigger_slot {
+    struct hg_core_private_context *context;    /* Context being triggered */
+    struct hg_completion_entry *hg_completion_entry; /* Captured entry */
+    hg_bool_t armed;                            /* Running an NA callback */
+};
+
+/* HG core poll group entry */
+struct hg_core_poll_group_entry {
+    struct hg_core_poll_group *poll_group;      /* Poll group */
+    struct hg_core_private_context *context;    /* Context */
+    hg_atomic_int32_t ready;                    /* Context has progressed */
+    hg_atomic_int32_t removed;                  /* Removed from poll group */
+    hg_atomic_int32_t busy;                     /* Callbacks using context */
+    HG_LIST_ENTRY(hg_core_poll_group_entry) entry; /* Entry in poll group */
+};
+
+/* HG core poll group */
+struct hg_core_poll_group {
+    struct hg_poll_set *poll_set;               /* Poll set shared by contexts */
+    HG_LIST_HEAD(hg_core_poll_group_entry) entry_list; /* List of entries */
+    HG_LIST_HEAD(hg_core_poll_group_entry) removed_list; /* Entries to free */
+    hg_thread_spin_t entry_list_lock;           /* Entry / removed list lock */
+    hg_atomic_int32_t progress_count;           /* Progress calls in flight */
+};
+
 #ifdef HG_HAS_SELF_FORWARD
 /* Info for wrapping callbacks if self addr */
 struct hg_core_self_cb_info {
@@ -186,6 +231,7 @@ struct hg_core_private_handle {
     hg_return_t (*no_respond)(struct hg_core_private_handle *hg_core_handle); /* no_respond */
     void *ack_buf;                      /* Ack buf for more data */
     void *in_buf_plugin_data;           /* Input buffer NA plugin data */
+    void *in_buf_storage;               /* Own input buffer while loaned */
     void *out_buf_plugin_data;          /* Output buffer NA plugin data */
     void *ack_buf_plugin_data;          /* Ack plugin data */
     na_op_id_t na_send_op_id;           /* Operation ID for send */
@@ -206,6 +252,7 @@ struct hg_core_private_handle {
     hg_bool_t repost;                   /* Repost handle on completion (listen) */
     hg_bool_t is_self;                  /* Self processed */
     hg_bool_t no_response;              /* Require response or not */
+    hg_bool_t loan_in_buf;              /* Receive input in NA loaned buf */
 };
 
 /* HG op id */
@@ -239,29 +286,12 @@ hg_core_get_sm_uuid(
         );
 #endif
 
-/**
- * Equal function for function map.
- */
-static HG_INLINE int
-hg_core_int_equal(
-        void *vlocation1,
-        void *vlocation2
-        );
-
-/**
- * Hash function for function map.
- */
-static HG_INLINE unsigned int
-hg_core_int_hash(
-        void *vlocation
-        );
-
 /**
  * Free function for value in function map.
  */
 static void
 hg_core_func_map_value_free(
-        hg_hash_table_value_t value
+        void *value
         );
 
 /**
@@ -436,6 +466,14 @@ hg_core_free_na(
         struct hg_core_private_handle *hg_core_handle
         );
 
+/**
+ * Release input buffer loaned by NA and restore own input buffer.
+ */
+static void
+hg_core_release_input(
+        struct hg_core_private_handle *hg_core_handle
+        );
+
 /**
  * Reset handle.
  */
@@ -635,6 +673,16 @@ hg_core_completion_add(
         hg_bool_t self_notify
         );
 
+/**
+ * Wake up threads waiting for completions, either in trigger or on the context
+ * poll fd.
+ */
+static hg_return_t
+hg_core_completion_signal(
+        struct hg_core_private_context *context,
+        hg_bool_t self_notify
+        );
+
 /**
  * Start listening for incoming RPC requests.
  */
@@ -654,6 +702,22 @@ hg_core_post(
         struct hg_core_private_handle *hg_core_handle
         );
 
+/**
+ * Add handle to pending list.
+ */
+static HG_INLINE void
+hg_core_pending_add(
+        struct hg_core_private_handle *hg_core_handle
+        );
+
+/**
+ * Remove handle from pending list.
+ */
+static HG_INLINE void
+hg_core_pending_remove(
+        struct hg_core_private_handle *hg_core_handle
+        );
+
 /**
  * Reset handle and re-post it.
  */
@@ -671,7 +735,6 @@ hg_core_progress_na(
         unsigned int timeout
         );
 
-#ifdef HG_HAS_SELF_FORWARD
 /**
  * Completion queue notification callback.
  */
@@ -681,7 +744,6 @@ hg_core_completion_queue_notify_cb(
         int error,
         hg_util_bool_t *progressed
         );
-#endif
 
 /**
  * Progress callback on NA layer when hg_core_progress_poll() is used.
@@ -705,6 +767,34 @@ hg_core_progress_na_sm_cb(
         );
 #endif
 
+/**
+ * Trigger NA callbacks of a class whose fds were directly registered to the
+ * context poll set.
+ */
+static hg_return_t
+hg_core_progress_na_trigger(
+        na_context_t *na_context,
+        unsigned int *completed_count
+        );
+
+/**
+ * Acquire NA progress locks of classes whose fds were directly registered to
+ * the context poll set, their callbacks are dispatched from hg_poll_wait().
+ */
+static hg_return_t
+hg_core_progress_poll_lock(
+        struct hg_core_private_context *context,
+        unsigned int timeout
+        );
+
+/**
+ * Release NA progress locks acquired by hg_core_progress_poll_lock().
+ */
+static void
+hg_core_progress_poll_unlock(
+        struct hg_core_private_context *context
+        );
+
 /**
  * Callback for HG poll progress that determines when it is safe to block.
  */
@@ -722,6 +812,32 @@ hg_core_progress_poll(
         unsigned int timeout
         );
 
+/**
+ * Progress callback on context when part of a poll group.
+ */
+static int
+hg_core_poll_group_cb(
+        void *arg,
+        int error,
+        hg_util_bool_t *progressed
+        );
+
+/**
+ * Free removed poll group entries once no progress call may reference them.
+ */
+static void
+hg_core_poll_group_release(
+        struct hg_core_poll_group *hg_core_poll_group
+        );
+
+/**
+ * Callback for poll group progress that determines when it is safe to block.
+ */
+static hg_util_bool_t
+hg_core_poll_group_try_wait_cb(
+        void *arg
+        );
+
 /**
  * Trigger callbacks.
  */
@@ -733,6 +849,34 @@ hg_core_trigger(
         unsigned int *actual_count
         );
 
+/**
+ * Trigger callback from completion entry.
+ */
+static HG_INLINE hg_return_t
+hg_core_trigger_completion_entry(
+        struct hg_completion_entry *hg_completion_entry
+        );
+
+/**
+ * Trigger NA completion entry pushed to the HG completion queue and the HG
+ * completion entry that it may produce.
+ */
+static HG_INLINE hg_return_t
+hg_core_trigger_na_entry(
+        struct hg_core_trigger_slot *hg_core_trigger_slot,
+        void *na_completion_entry,
+        hg_bool_t *completed
+        );
+
+/**
+ * Push NA completion entry to the HG completion queue.
+ */
+static na_return_t
+hg_core_na_completion_push(
+        void *arg,
+        void *na_completion_entry
+        );
+
 /**
  * Trigger callback from HG lookup op ID.
  */
@@ -771,6 +915,14 @@ hg_core_cancel(
  */
 static void
 hg_core_print_stats(void);
+
+/**
+ * Accumulate NA context stats before the context is destroyed.
+ */
+static void
+hg_core_na_stats_add(
+        na_context_t *na_context
+        );
 #endif
 
 /*******************/
@@ -782,6 +934,10 @@ static hg_bool_t hg_core_print_stats_registered_g = HG_FALSE;
 static hg_core_stat_t hg_core_rpc_count_g = HG_CORE_STAT_INIT(0);
 static hg_core_stat_t hg_core_rpc_extra_count_g = HG_CORE_STAT_INIT(0);
 static hg_core_stat_t hg_core_bulk_count_g = HG_CORE_STAT_INIT(0);
+static struct na_stats hg_core_na_stats_g;
+static hg_bool_t hg_core_na_stats_collected_g = HG_FALSE;
+static hg_thread_mutex_t hg_core_na_stats_mutex_g =
+    HG_THREAD_MUTEX_INITIALIZER;
 #endif
 
 /*---------------------------------------------------------------------------*/
@@ -798,6 +954,85 @@ hg_core_print_stats(void)
         (unsigned long) hg_core_stat_get(&hg_core_rpc_extra_count_g));
     printf("Bulk transfer count:  %lu\n",
         (unsigned long) hg_core_stat_get(&hg_core_bulk_count_g));
+
+    /* NA stats of destroyed contexts */
+    if (hg_core_na_stats_collected_g) {
+        static const char *const op_names[NA_STATS_OP_MAX] = {
+            "lookup", "send unexpected", "recv unexpected", "send expected",
+            "recv expected", "put", "get"
+        };
+        const struct na_stats *na_stats = &hg_core_na_stats_g;
+        unsigned int i, j;
+
+        printf("-------------------\n");
+        printf("NA op                 posted    completed canceled  errors\n");
+        for (i = 0; i < NA_STATS_OP_MAX; i++) {
+            if (!na_stats->posted[i] && !na_stats->completed[i])
+                continue;
+            printf("  %-19s %-9lu %-9lu %-9lu %lu\n", op_names[i],
+                (unsigned long) na_stats->posted[i],
+                (unsigned long) na_stats->completed[i],
+                (unsigned long) na_stats->canceled[i],
+                (unsigned long) na_stats->errors[i]);
+            printf("    latency (us, log2):");
+            for (j = 0; j < NA_STATS_HIST_BUCKETS; j++)
+                if (na_stats->latency[i][j])
+                    printf(" <%lu:%lu", 1UL << j,
+                        (unsigned long) na_stats->latency[i][j]);
+            printf("\n");
+        }
+        printf("NA bytes sent:        %lu\n",
+            (unsigned long) na_stats->bytes_sent);
+        printf("NA bytes received:    %lu\n",
+            (unsigned long) na_stats->bytes_received);
+        printf("NA cancel count:      %lu\n",
+            (unsigned long) na_stats->cancel_count);
+        printf("NA again count:       %lu\n",
+            (unsigned long) na_stats->again_count);
+        printf("NA CQ full count:     %lu\n",
+            (unsigned long) na_stats->cq_full_count);
+        printf("NA unexpected queued: %lu (max depth %lu)\n",
+            (unsigned long) na_stats->unexpected_queued,
+            (unsigned long) na_stats->unexpected_depth_max);
+        printf("NA completion depth:  %lu (max)\n",
+            (unsigned long) na_stats->completion_depth_max);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+hg_core_na_stats_add(na_context_t *na_context)
+{
+    struct na_stats na_stats;
+    unsigned int i, j;
+
+    /* Nothing to add if NA does not collect stats */
+    if (NA_Get_stats(na_context, &na_stats) != NA_SUCCESS)
+        return;
+
+    hg_thread_mutex_lock(&hg_core_na_stats_mutex_g);
+    for (i = 0; i < NA_STATS_OP_MAX; i++) {
+        hg_core_na_stats_g.posted[i] += na_stats.posted[i];
+        hg_core_na_stats_g.completed[i] += na_stats.completed[i];
+        hg_core_na_stats_g.canceled[i] += na_stats.canceled[i];
+        hg_core_na_stats_g.errors[i] += na_stats.errors[i];
+        for (j = 0; j < NA_STATS_HIST_BUCKETS; j++)
+            hg_core_na_stats_g.latency[i][j] += na_stats.latency[i][j];
+    }
+    hg_core_na_stats_g.cancel_count += na_stats.cancel_count;
+    hg_core_na_stats_g.bytes_sent += na_stats.bytes_sent;
+    hg_core_na_stats_g.bytes_received += na_stats.bytes_received;
+    hg_core_na_stats_g.again_count += na_stats.again_count;
+    hg_core_na_stats_g.cq_full_count += na_stats.cq_full_count;
+    hg_core_na_stats_g.unexpected_queued += na_stats.unexpected_queued;
+    hg_core_na_stats_g.unexpected_depth_max = HG_CORE_MAX(
+        hg_core_na_stats_g.unexpected_depth_max,
+        na_stats.unexpected_depth_max);
+    hg_core_na_stats_g.completion_depth_max = HG_CORE_MAX(
+        hg_core_na_stats_g.completion_depth_max,
+        na_stats.completion_depth_max);
+    hg_core_na_stats_collected_g = HG_TRUE;
+    hg_thread_mutex_unlock(&hg_core_na_stats_mutex_g);
 }
 #endif
 
@@ -835,23 +1070,9 @@ done:
 }
 #endif
 
-/*---------------------------------------------------------------------------*/
-static HG_INLINE int
-hg_core_int_equal(void *vlocation1, void *vlocation2)
-{
-    return *((int *) vlocation1) == *((int *) vlocation2);
-}
-
-/*---------------------------------------------------------------------------*/
-static HG_INLINE unsigned int
-hg_core_int_hash(void *vlocation)
-{
-    return *((unsigned int *) vlocation);
-}
-
 /*---------------------------------------------------------------------------*/
 static void
-hg_core_func_map_value_free(hg_hash_table_value_t value)
+hg_core_func_map_value_free(void *value)
 {
     struct hg_core_rpc_info *hg_core_rpc_info =
         (struct hg_core_rpc_info *) value;
@@ -978,10 +1199,10 @@ hg_core_context_lists_wait(struct hg_core_private_context *context)
 
     do {
         unsigned int actual_count = 0;
-        hg_time_t t1, t2;
+        hg_time_ticks_t t1, t2;
         hg_return_t trigger_ret, progress_ret;
 
-        hg_time_get_current(&t1);
+        t1 = hg_time_get_ticks();
 
         /* Trigger everything we can from HG */
         do {
@@ -1008,8 +1229,8 @@ hg_core_context_lists_wait(struct hg_core_private_context *context)
             (unsigned int) (remaining * 1000.0));
         HG_CHECK_ERROR(progress_ret != HG_SUCCESS && progress_ret != HG_TIMEOUT,
             done, ret, progress_ret, "Could not make progress");
-        hg_time_get_current(&t2);
-        remaining -= hg_time_to_double(hg_time_subtract(t2, t1));
+        t2 = hg_time_get_ticks();
+        remaining -= hg_time_ticks_to_double(t2 - t1);
         if (remaining < 0)
             remaining = 0;
     } while (remaining > 0 || !pending_list_empty || !sm_pending_list_empty);
@@ -1049,6 +1270,11 @@ hg_core_init(const char *na_info_string, hg_bool_t na_listen,
             hg_core_class->na_ext_init = HG_TRUE;
         }
         hg_core_class->progress_mode = hg_init_info->na_init_info.progress_mode;
+        hg_core_class->completion_queue_size =
+            hg_init_info->completion_queue_size;
+        hg_core_class->na_direct_completion =
+            hg_init_info->na_direct_completion;
+        hg_core_class->na_loan_recv = hg_init_info->na_loan_recv;
 #ifdef HG_HAS_SM_ROUTING
         auto_sm = hg_init_info->auto_sm;
 #else
@@ -1066,6 +1292,14 @@ hg_core_init(const char *na_info_string, hg_bool_t na_listen,
         }
 #endif
     }
+    if (!hg_core_class->completion_queue_size)
+        hg_core_class->completion_queue_size = HG_CORE_COMPLETION_QUEUE_SIZE;
+    if (hg_core_class->na_direct_completion && hg_thread_key_create(
+        &hg_core_class->trigger_slot_key, NULL) != HG_UTIL_SUCCESS) {
+        hg_core_class->na_direct_completion = HG_FALSE;
+        HG_GOTO_ERROR(error, ret, HG_NOMEM,
+            "Could not create trigger slot key");
+    }
 
     /* Initialize NA if not provided externally */
     if (!hg_core_class->na_ext_init) {
@@ -1122,17 +1356,20 @@ hg_core_init(const char *na_info_string, hg_bool_t na_listen,
     hg_atomic_init32(&hg_core_class->n_addrs, 0);
 
     /* Create new function map */
-    hg_core_class->func_map = hg_hash_table_new(hg_core_int_hash,
-        hg_core_int_equal);
+    hg_core_class->func_map = hg_hash_map_new_int();
     HG_CHECK_ERROR(hg_core_class->func_map == NULL, error, ret, HG_NOMEM,
         "Could not create function map");
 
-    /* Automatically free all the values with the hash map */
-    hg_hash_table_register_free_functions(hg_core_class->func_map, free,
-            hg_core_func_map_value_free);
+    /* Create pools for addrs and lookup op IDs */
+    hg_core_class->addr_pool =
+        hg_mem_pool_create(sizeof(struct hg_core_private_addr), 0, 0);
+    HG_CHECK_ERROR(hg_core_class->addr_pool == NULL, error, ret, HG_NOMEM,
+        "Could not create addr pool");
 
-    /* Initialize mutex */
-    hg_thread_spin_init(&hg_core_class->func_map_lock);
+    hg_core_class->op_id_pool =
+        hg_mem_pool_create(sizeof(struct hg_core_op_id), 0, 0);
+    HG_CHECK_ERROR(hg_core_class->op_id_pool == NULL, error, ret, HG_NOMEM,
+        "Could not create op ID pool");
 
     // TODO
     (void)ret;
@@ -1163,19 +1400,20 @@ hg_core_finalize(struct hg_core_private_class *hg_core_class)
     HG_CHECK_ERROR(n_addrs != 0, done, ret, HG_BUSY,
         "HG addrs must be freed before finalizing HG (%d remaining)", n_addrs);
 
-    /* Delete function map */
-    if(hg_core_class->func_map)
-        hg_hash_table_free(hg_core_class->func_map);
+    /* Delete function map and automatically free all the values */
+    hg_hash_map_free(hg_core_class->func_map, hg_core_func_map_value_free);
     hg_core_class->func_map = NULL;
 
+    hg_mem_pool_destroy(hg_core_class->addr_pool);
+    hg_core_class->addr_pool = NULL;
+    hg_mem_pool_destroy(hg_core_class->op_id_pool);
+    hg_core_class->op_id_pool = NULL;
+
     /* Free user data */
     if (hg_core_class->core_class.data_free_callback)
         hg_core_class->core_class.data_free_callback(
             hg_core_class->core_class.data);
 
-    /* Destroy mutex */
-    hg_thread_spin_destroy(&hg_core_class->func_map_lock);
-
     if (!hg_core_class->na_ext_init) {
         /* Finalize interface */
         na_ret = NA_Finalize(hg_core_class->core_class.na_class);
@@ -1191,6 +1429,9 @@ hg_core_finalize(struct hg_core_private_class *hg_core_class)
         "Could not finalize NA SM interface (%s)", NA_Error_to_string(na_ret));
 #endif
 
+    if (hg_core_class->na_direct_completion)
+        hg_thread_key_delete(hg_core_class->trigger_slot_key);
+
     /* Free HG class */
     free(hg_core_class);
 
@@ -1205,8 +1446,8 @@ hg_core_addr_create(struct hg_core_private_class *hg_core_class,
 {
     struct hg_core_private_addr *hg_core_addr = NULL;
 
-    hg_core_addr = (struct hg_core_private_addr *) malloc(
-        sizeof(struct hg_core_private_addr));
+    hg_core_addr = (struct hg_core_private_addr *) hg_mem_pool_alloc(
+        hg_core_class->addr_pool);
     HG_CHECK_ERROR_NORET(hg_core_addr == NULL, done,
         "Could not allocate HG addr");
 
@@ -1243,8 +1484,8 @@ hg_core_addr_lookup(struct hg_core_private_context *context,
     hg_return_t ret = HG_SUCCESS, progress_ret;
 
     /* Allocate op_id */
-    hg_core_op_id = (struct hg_core_op_id *) malloc(
-        sizeof(struct hg_core_op_id));
+    hg_core_op_id = (struct hg_core_op_id *) hg_mem_pool_alloc(
+        HG_CORE_CONTEXT_CLASS(context)->op_id_pool);
     HG_CHECK_ERROR(hg_core_op_id == NULL, error, ret, HG_NOMEM,
         "Could not allocate HG operation ID");
 
@@ -1337,7 +1578,8 @@ hg_core_addr_lookup(struct hg_core_private_context *context,
     return ret;
 
 error:
-    free(hg_core_op_id);
+    hg_mem_pool_free(HG_CORE_CONTEXT_CLASS(context)->op_id_pool,
+        hg_core_op_id);
     hg_core_addr_free(HG_CORE_CONTEXT_CLASS(context), hg_core_addr);
 
     return ret;
@@ -1424,7 +1666,7 @@ hg_core_addr_free(struct hg_core_private_class *hg_core_class,
     HG_CHECK_ERROR(na_ret != NA_SUCCESS, done, ret, (hg_return_t) na_ret,
         "Could not free NA address (%s)", NA_Error_to_string(na_ret));
 
-    free(hg_core_addr);
+    hg_mem_pool_free(hg_core_class->addr_pool, hg_core_addr);
 
 done:
     return ret;
@@ -1646,6 +1888,9 @@ hg_core_destroy(struct hg_core_private_handle *hg_core_handle)
     /* Decrement N handles from HG context */
     hg_atomic_decr32(&HG_CORE_HANDLE_CONTEXT(hg_core_handle)->n_handles);
 
+    /* Loaned input buffer must be released before its source addr */
+    hg_core_release_input(hg_core_handle);
+
     /* Remove reference to HG addr */
     hg_core_addr_free(HG_CORE_HANDLE_CLASS(hg_core_handle),
         (struct hg_core_private_addr *) hg_core_handle->core_handle.info.addr);
@@ -1701,6 +1946,8 @@ hg_core_alloc_na(struct hg_core_private_handle *hg_core_handle,
         NA_Msg_get_unexpected_header_size(hg_core_handle->na_class);
     hg_core_handle->core_handle.na_out_header_offset =
         NA_Msg_get_expected_header_size(hg_core_handle->na_class);
+    hg_core_handle->loan_in_buf = HG_CORE_HANDLE_CLASS(hg_core_handle)->
+        na_loan_recv && NA_Msg_loan_supported(hg_core_handle->na_class);
 
     hg_core_handle->core_handle.in_buf = NA_Msg_buf_alloc(
         hg_core_handle->na_class, hg_core_handle->core_handle.in_buf_size,
@@ -1803,11 +2050,35 @@ done:
     return;
 }
 
+/*---------------------------------------------------------------------------*/
+static void
+hg_core_release_input(struct hg_core_private_handle *hg_core_handle)
+{
+    na_return_t na_ret;
+
+    if (!hg_core_handle->in_buf_storage)
+        return;
+
+    na_ret = NA_Msg_loan_release(hg_core_handle->na_class,
+        hg_core_handle->core_handle.in_buf, hg_core_handle->in_buf_used,
+        hg_core_handle->core_handle.info.addr->na_addr);
+    HG_CHECK_ERROR_NORET(na_ret != NA_SUCCESS, done,
+        "Could not release loaned input buffer (%s)",
+        NA_Error_to_string(na_ret));
+
+done:
+    hg_core_handle->core_handle.in_buf = hg_core_handle->in_buf_storage;
+    hg_core_handle->in_buf_storage = NULL;
+}
+
 /*---------------------------------------------------------------------------*/
 static void
 hg_core_reset(struct hg_core_private_handle *hg_core_handle,
     hg_bool_t reset_info)
 {
+    /* Loaned input buffer must be released before its source addr */
+    hg_core_release_input(hg_core_handle);
+
     /* Reset source address */
     if (reset_info) {
         if (hg_core_handle->core_handle.info.addr != HG_CORE_ADDR_NULL
@@ -1889,17 +2160,12 @@ hg_core_set_rpc(struct hg_core_private_handle *hg_core_handle,
 
     /* We also allow for NULL RPC id to be passed (same reason as above) */
     if (id && hg_core_handle->core_handle.info.id != id) {
-        struct hg_core_rpc_info *hg_core_rpc_info;
+        void *hg_core_rpc_info;
 
         /* Retrieve ID function from function map */
-        hg_thread_spin_lock(
-            &HG_CORE_HANDLE_CLASS(hg_core_handle)->func_map_lock);
-        hg_core_rpc_info = (struct hg_core_rpc_info *) hg_hash_table_lookup(
-        HG_CORE_HANDLE_CLASS(hg_core_handle)->func_map,
-            (hg_hash_table_key_t) &id);
-        hg_thread_spin_unlock(
-            &HG_CORE_HANDLE_CLASS(hg_core_handle)->func_map_lock);
-        if (!hg_core_rpc_info)
+        if (hg_hash_map_lookup_int(
+            HG_CORE_HANDLE_CLASS(hg_core_handle)->func_map, id,
+            &hg_core_rpc_info) != HG_UTIL_SUCCESS)
             HG_GOTO_DONE(done, ret, HG_NOENTRY);
 
         hg_core_handle->core_handle.info.id = id;
@@ -2190,10 +2456,16 @@ hg_core_recv_input_cb(const struct na_cb_info *callback_info)
     hg_core_handle->core_handle.info.addr->na_addr =
         na_cb_info_recv_unexpected->source;
     hg_core_handle->tag = na_cb_info_recv_unexpected->tag;
+    if (hg_core_handle->loan_in_buf) {
+        /* Decode input in place, buffer is released on reset */
+        hg_core_handle->in_buf_storage = hg_core_handle->core_handle.in_buf;
+        hg_core_handle->core_handle.in_buf =
+            na_cb_info_recv_unexpected->actual_buf;
+    }
+    hg_core_handle->in_buf_used = na_cb_info_recv_unexpected->actual_buf_size;
     HG_CHECK_ERROR_NORET(na_cb_info_recv_unexpected->actual_buf_size >
         hg_core_handle->core_handle.in_buf_size, done,
         "Actual transfer size is too large for unexpected recv");
-    hg_core_handle->in_buf_used = na_cb_info_recv_unexpected->actual_buf_size;
 
 #ifndef HG_HAS_POST_LIMIT
     /* Check if we need more handles */
@@ -2562,16 +2834,13 @@ done:
 static hg_return_t
 hg_core_process(struct hg_core_private_handle *hg_core_handle)
 {
-    struct hg_core_rpc_info *hg_core_rpc_info;
+    struct hg_core_rpc_info *hg_core_rpc_info = NULL;
     hg_return_t ret = HG_SUCCESS;
 
     /* Retrieve exe function from function map */
-    hg_thread_spin_lock(&HG_CORE_HANDLE_CLASS(hg_core_handle)->func_map_lock);
-    hg_core_rpc_info = (struct hg_core_rpc_info *) hg_hash_table_lookup(
-        HG_CORE_HANDLE_CLASS(hg_core_handle)->func_map,
-        (hg_hash_table_key_t) &hg_core_handle->core_handle.info.id);
-    hg_thread_spin_unlock(&HG_CORE_HANDLE_CLASS(hg_core_handle)->func_map_lock);
-    if (!hg_core_rpc_info) {
+    if (hg_hash_map_lookup_int(HG_CORE_HANDLE_CLASS(hg_core_handle)->func_map,
+        hg_core_handle->core_handle.info.id, (void **) &hg_core_rpc_info)
+        != HG_UTIL_SUCCESS) {
         HG_LOG_WARNING("Could not find RPC ID in function map");
         ret = HG_NOENTRY;
         goto done;
@@ -2656,35 +2925,81 @@ hg_core_completion_add(struct hg_core_context *context,
         hg_core_stat_incr(&hg_core_bulk_count_g);
 #endif
 
-    if (hg_atomic_queue_push(private_context->completion_queue, hg_completion_entry)
-        != HG_UTIL_SUCCESS) {
-        /* Queue is full */
-        hg_thread_mutex_lock(&private_context->completion_queue_mutex);
-        HG_QUEUE_PUSH_TAIL(&private_context->backfill_queue, hg_completion_entry,
-            entry);
-        hg_atomic_incr32(&private_context->backfill_queue_count);
-        hg_thread_mutex_unlock(&private_context->completion_queue_mutex);
+    /* When called from an NA callback that is being triggered from this
+     * context, hand the entry back to the trigger instead of queuing it */
+    if (HG_CORE_CONTEXT_CLASS(private_context)->na_direct_completion) {
+        struct hg_core_trigger_slot *hg_core_trigger_slot =
+            (struct hg_core_trigger_slot *) hg_thread_getspecific(
+                HG_CORE_CONTEXT_CLASS(private_context)->trigger_slot_key);
+
+        if (hg_core_trigger_slot && hg_core_trigger_slot->armed
+            && hg_core_trigger_slot->context == private_context
+            && !hg_core_trigger_slot->hg_completion_entry) {
+            hg_core_trigger_slot->hg_completion_entry = hg_completion_entry;
+            goto done;
+        }
     }
 
-    if (hg_atomic_get32(&private_context->trigger_waiting)) {
-        hg_thread_mutex_lock(&private_context->completion_queue_mutex);
+    /* Queue grows if full so this only fails when out of memory */
+    HG_CHECK_ERROR(hg_atomic_queue_chain_push(private_context->completion_queue,
+        hg_completion_entry) != HG_UTIL_SUCCESS, done, ret, HG_NOMEM,
+        "Could not push completion entry to completion queue");
+
+    ret = hg_core_completion_signal(private_context, self_notify);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static hg_return_t
+hg_core_completion_signal(struct hg_core_private_context *context,
+    hg_bool_t self_notify)
+{
+    hg_return_t ret = HG_SUCCESS;
+
+    if (hg_atomic_get32(&context->trigger_waiting)) {
+        hg_thread_mutex_lock(&context->completion_queue_mutex);
         /* Callback is pushed to the completion queue when something completes
          * so wake up anyone waiting in the trigger */
-        hg_thread_cond_signal(&private_context->completion_queue_cond);
-        hg_thread_mutex_unlock(&private_context->completion_queue_mutex);
+        hg_thread_cond_signal(&context->completion_queue_cond);
+        hg_thread_mutex_unlock(&context->completion_queue_mutex);
     }
 
-#ifdef HG_HAS_SELF_FORWARD
+#ifndef HG_HAS_SELF_FORWARD
+    self_notify = HG_FALSE;
+#endif
+    /* Once the poll fd is handed out, an external event loop may be blocked
+     * on it, any completion must therefore make it readable */
     /* TODO could prevent from self notifying if hg_poll_wait() not entered */
-    if ((HG_CORE_CONTEXT_CLASS(private_context)->progress_mode != NA_NO_BLOCK)
-        && self_notify && private_context->completion_queue_notify) {
-        int rc = hg_event_set(private_context->completion_queue_notify);
+    if ((HG_CORE_CONTEXT_CLASS(context)->progress_mode != NA_NO_BLOCK)
+        && (self_notify || hg_atomic_get32(&context->fd_exposed))
+        && context->completion_queue_notify > 0) {
+        int rc = hg_event_set(context->completion_queue_notify);
         HG_CHECK_ERROR(rc != HG_UTIL_SUCCESS, done, ret, HG_FAULT,
             "Could not signal completion queue");
     }
-#else
-    (void) self_notify;
-#endif
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+hg_core_na_completion_push(void *arg, void *na_completion_entry)
+{
+    struct hg_core_private_context *context =
+        (struct hg_core_private_context *) arg;
+    na_return_t ret = NA_SUCCESS;
+
+    /* Queue grows if full so this only fails when out of memory */
+    HG_CHECK_ERROR(hg_atomic_queue_chain_push(context->completion_queue,
+        HG_CORE_PTR_TO_NA_ENTRY(na_completion_entry)) != HG_UTIL_SUCCESS,
+        done, ret, NA_NOMEM,
+        "Could not push NA completion entry to completion queue");
+
+    HG_CHECK_ERROR(hg_core_completion_signal(context, HG_FALSE) != HG_SUCCESS,
+        done, ret, NA_PROTOCOL_ERROR, "Could not signal completion queue");
 
 done:
     return ret;
@@ -2695,16 +3010,20 @@ static hg_return_t
 hg_core_context_post(struct hg_core_private_context *context,
     unsigned int request_count, hg_bool_t repost, hg_bool_t use_sm)
 {
-    unsigned int nentry = 0;
+    struct hg_core_private_handle *hg_core_handles[HG_CORE_POST_BATCH_SIZE];
+    struct na_op_desc na_op_descs[HG_CORE_POST_BATCH_SIZE];
+    struct hg_core_private_handle *hg_core_handle = NULL;
+    unsigned int nentry = 0, batch_count = 0, i;
+    na_size_t posted = 0;
+    na_return_t na_ret;
     hg_return_t ret = HG_SUCCESS;
 
-    /* Create a bunch of handles and post unexpected receives */
+    /* Create a bunch of handles and post unexpected receives in batches */
     for (nentry = 0; nentry < request_count; nentry++) {
-        struct hg_core_private_handle *hg_core_handle = NULL;
         struct hg_core_private_addr *hg_core_addr = NULL;
+        struct na_op_desc *na_op_desc = &na_op_descs[batch_count];
 
         /* Create a new handle */
-        // TODO
         hg_core_handle = hg_core_create(context, use_sm);
         HG_CHECK_ERROR(hg_core_handle == NULL, error, ret, HG_NOMEM,
             "Could not create HG core handle");
@@ -2719,7 +3038,6 @@ hg_core_context_post(struct hg_core_private_context *context,
         }
 
         /* Create internal addresses */
-        // TODO
         hg_core_addr = hg_core_addr_create(HG_CORE_CONTEXT_CLASS(context),
             hg_core_handle->na_class);
         HG_CHECK_ERROR(hg_core_addr == NULL, error, ret, HG_NOMEM,
@@ -2732,24 +3050,54 @@ hg_core_context_post(struct hg_core_private_context *context,
         /* Repost handle on completion if told so */
         hg_core_handle->repost = repost;
 
-        ret = hg_core_post(hg_core_handle);
-        HG_CHECK_HG_ERROR(error, ret, "Cannot post handle");
+        /* Handle is now in use */
+        hg_core_pending_add(hg_core_handle);
+
+        /* Describe unexpected receive */
+        na_op_desc->type = NA_CB_RECV_UNEXPECTED;
+        na_op_desc->callback = hg_core_recv_input_cb;
+        na_op_desc->arg = hg_core_handle;
+        na_op_desc->info.msg.buf = (hg_core_handle->loan_in_buf) ? NULL :
+            hg_core_handle->core_handle.in_buf;
+        na_op_desc->info.msg.buf_size = hg_core_handle->core_handle.in_buf_size;
+        na_op_desc->info.msg.plugin_data = hg_core_handle->in_buf_plugin_data;
+        na_op_desc->op_id = &hg_core_handle->na_recv_op_id;
+        hg_core_handles[batch_count++] = hg_core_handle;
+        hg_core_handle = NULL;
+
+        if (batch_count < HG_CORE_POST_BATCH_SIZE
+            && nentry + 1 < request_count)
+            continue;
+
+        /* All handles of a context post share the same NA class/context */
+        na_ret = NA_Submit(hg_core_handles[0]->na_class,
+            hg_core_handles[0]->na_context, na_op_descs, batch_count, &posted);
+        HG_CHECK_ERROR(na_ret != NA_SUCCESS, error, ret, (hg_return_t) na_ret,
+            "Could not post unexpected recvs for input buffers (%s)",
+            NA_Error_to_string(na_ret));
+        batch_count = 0;
+        posted = 0;
     }
 
     return ret;
 
 error:
-    /* TODO */
+    /* Handles that were posted remain pending and complete normally, the
+     * ones that were not posted (including the one being set up) are not
+     * referenced by NA and can be destroyed */
+    for (i = (unsigned int) posted; i < batch_count; i++) {
+        hg_core_pending_remove(hg_core_handles[i]);
+        hg_core_destroy(hg_core_handles[i]);
+    }
+    hg_core_destroy(hg_core_handle);
+
     return ret;
 }
 
 /*---------------------------------------------------------------------------*/
-static hg_return_t
-hg_core_post(struct hg_core_private_handle *hg_core_handle)
+static HG_INLINE void
+hg_core_pending_add(struct hg_core_private_handle *hg_core_handle)
 {
-    na_return_t na_ret;
-    hg_return_t ret = HG_SUCCESS;
-
     /* Handle is now in use */
     hg_atomic_set32(&hg_core_handle->in_use, HG_TRUE);
 
@@ -2775,11 +3123,35 @@ hg_core_post(struct hg_core_private_handle *hg_core_handle)
 #ifdef HG_HAS_SM_ROUTING
     }
 #endif
+}
+
+/*---------------------------------------------------------------------------*/
+static HG_INLINE void
+hg_core_pending_remove(struct hg_core_private_handle *hg_core_handle)
+{
+    hg_thread_spin_lock(
+        &HG_CORE_HANDLE_CONTEXT(hg_core_handle)->pending_list_lock);
+    HG_LIST_REMOVE(hg_core_handle, pending);
+    hg_thread_spin_unlock(
+        &HG_CORE_HANDLE_CONTEXT(hg_core_handle)->pending_list_lock);
+    hg_atomic_set32(&hg_core_handle->in_use, HG_FALSE);
+}
+
+/*---------------------------------------------------------------------------*/
+static hg_return_t
+hg_core_post(struct hg_core_private_handle *hg_core_handle)
+{
+    na_return_t na_ret;
+    hg_return_t ret = HG_SUCCESS;
+
+    /* Handle is now in use */
+    hg_core_pending_add(hg_core_handle);
 
     /* Post a new unexpected receive */
     na_ret = NA_Msg_recv_unexpected(hg_core_handle->na_class,
         hg_core_handle->na_context, hg_core_recv_input_cb, hg_core_handle,
-        hg_core_handle->core_handle.in_buf,
+        (hg_core_handle->loan_in_buf) ? NULL :
+            hg_core_handle->core_handle.in_buf,
         hg_core_handle->core_handle.in_buf_size,
         hg_core_handle->in_buf_plugin_data, &hg_core_handle->na_recv_op_id);
     HG_CHECK_ERROR(na_ret != NA_SUCCESS, error, ret, (hg_return_t) na_ret,
@@ -2789,12 +3161,7 @@ hg_core_post(struct hg_core_private_handle *hg_core_handle)
     return ret;
 
 error:
-    hg_thread_spin_lock(
-        &HG_CORE_HANDLE_CONTEXT(hg_core_handle)->pending_list_lock);
-    HG_LIST_REMOVE(hg_core_handle, pending);
-    hg_thread_spin_unlock(
-        &HG_CORE_HANDLE_CONTEXT(hg_core_handle)->pending_list_lock);
-    hg_atomic_set32(&hg_core_handle->in_use, HG_FALSE);
+    hg_core_pending_remove(hg_core_handle);
     return ret;
 }
 
@@ -2823,7 +3190,6 @@ done:
 }
 
 /*---------------------------------------------------------------------------*/
-#ifdef HG_HAS_SELF_FORWARD
 static HG_INLINE int
 hg_core_completion_queue_notify_cb(void *arg,
     int HG_UNUSED error, hg_util_bool_t *progressed)
@@ -2840,8 +3206,7 @@ hg_core_completion_queue_notify_cb(void *arg,
             "Could not get completion notification");
     }
 
-    if (notified || !hg_atomic_queue_is_empty(context->completion_queue)
-        || hg_atomic_get32(&context->backfill_queue_count)) {
+    if (notified || !hg_atomic_queue_chain_is_empty(context->completion_queue)) {
         *progressed = HG_UTIL_TRUE; /* Progressed */
         goto done;
     }
@@ -2851,7 +3216,6 @@ hg_core_completion_queue_notify_cb(void *arg,
 done:
     return rc;
 }
-#endif
 
 /*---------------------------------------------------------------------------*/
 static int
@@ -2896,8 +3260,7 @@ hg_core_progress_na_cb(void *arg, int HG_UNUSED error,
     /* We can't only verify that the completion queue is not empty, we need
      * to check what was added to the completion queue, as the completion queue
      * may have been concurrently emptied */
-    if (!completed_count && hg_atomic_queue_is_empty(context->completion_queue)
-        && !hg_atomic_get32(&context->backfill_queue_count)) {
+    if (!completed_count && hg_atomic_queue_chain_is_empty(context->completion_queue)) {
         /* Nothing progressed */
         *progressed = HG_UTIL_FALSE;
         goto done;
@@ -2954,8 +3317,7 @@ hg_core_progress_na_sm_cb(void *arg, int HG_UNUSED error,
     /* We can't only verify that the completion queue is not empty, we need
      * to check what was added to the completion queue, as the completion queue
      * may have been concurrently emptied */
-    if (!completed_count && hg_atomic_queue_is_empty(context->completion_queue)
-        && !hg_atomic_get32(&context->backfill_queue_count)) {
+    if (!completed_count && hg_atomic_queue_chain_is_empty(context->completion_queue)) {
         /* Nothing progressed */
         *progressed = HG_UTIL_FALSE;
         goto done;
@@ -2989,7 +3351,7 @@ hg_core_progress_na(struct hg_core_private_context *context,
         unsigned int completed_count = 0;
         unsigned int progress_timeout;
         na_return_t na_ret;
-        hg_time_t t1, t2;
+        hg_time_ticks_t t1, t2;
 
         /* Trigger everything we can from NA, if something completed it will
          * be moved to the HG context completion queue */
@@ -3011,8 +3373,7 @@ hg_core_progress_na(struct hg_core_private_context *context,
          * to check what was added to the completion queue, as the completion
          * queue may have been concurrently emptied */
         if (completed_count
-            || !hg_atomic_queue_is_empty(context->completion_queue)
-            || hg_atomic_get32(&context->backfill_queue_count)) {
+            || !hg_atomic_queue_chain_is_empty(context->completion_queue)) {
             ret = HG_SUCCESS; /* Progressed */
             break;
         }
@@ -3021,7 +3382,7 @@ hg_core_progress_na(struct hg_core_private_context *context,
             break;
 
         if (timeout)
-            hg_time_get_current(&t1);
+            t1 = hg_time_get_ticks();
 
         /* Make sure that it is safe to block */
         if (timeout && NA_Poll_try_wait(
@@ -3037,8 +3398,8 @@ hg_core_progress_na(struct hg_core_private_context *context,
             context->core_context.na_context, progress_timeout);
 
         if (timeout) {
-            hg_time_get_current(&t2);
-            remaining -= hg_time_to_double(hg_time_subtract(t2, t1));
+            t2 = hg_time_get_ticks();
+            remaining -= hg_time_ticks_to_double(t2 - t1);
         }
 
         /* Trigger NA callbacks and check whether we completed something */
@@ -3055,6 +3416,37 @@ done:
     return ret;
 }
 
+/*---------------------------------------------------------------------------*/
+static hg_return_t
+hg_core_progress_na_trigger(na_context_t *na_context,
+    unsigned int *completed_count)
+{
+    unsigned int actual_count = 0;
+    int cb_ret[HG_CORE_MAX_TRIGGER_COUNT] = {0};
+    hg_return_t ret = HG_SUCCESS;
+    na_return_t na_ret;
+
+    /* Progress was already made from the context poll set, trigger everything
+     * we can from NA, if something completed it will be moved to the HG
+     * context completion queue */
+    do {
+        unsigned int i;
+
+        na_ret = NA_Trigger(na_context, 0, HG_CORE_MAX_TRIGGER_COUNT, cb_ret,
+            &actual_count);
+
+        /* Return value of callback is completion count */
+        for (i = 0; i < actual_count; i++)
+            *completed_count += (unsigned int) cb_ret[i];
+    } while ((na_ret == NA_SUCCESS) && actual_count);
+    HG_CHECK_ERROR(na_ret != NA_SUCCESS && na_ret != NA_TIMEOUT, done, ret,
+        (hg_return_t) na_ret, "Could not trigger NA callback (%s)",
+        NA_Error_to_string(na_ret));
+
+done:
+    return ret;
+}
+
 /*---------------------------------------------------------------------------*/
 static HG_INLINE hg_util_bool_t
 hg_core_poll_try_wait_cb(void *arg)
@@ -3066,9 +3458,8 @@ hg_core_poll_try_wait_cb(void *arg)
     if (HG_CORE_CONTEXT_CLASS(context)->progress_mode == NA_NO_BLOCK)
         return NA_FALSE;
 
-    /* Something is in one of the completion queues */
-    if (!hg_atomic_queue_is_empty(context->completion_queue) ||
-        hg_atomic_get32(&context->backfill_queue_count)) {
+    /* Something is in the completion queue */
+    if (!hg_atomic_queue_chain_is_empty(context->completion_queue)) {
         return NA_FALSE;
     }
 
@@ -3077,7 +3468,7 @@ hg_core_poll_try_wait_cb(void *arg)
         na_bool_t ret = NA_Poll_try_wait(
             context->core_context.core_class->na_sm_class,
             context->core_context.na_sm_context);
-        if (ret)
+        if (!ret)
             return ret;
     }
 #endif
@@ -3088,34 +3479,142 @@ hg_core_poll_try_wait_cb(void *arg)
 
 /*---------------------------------------------------------------------------*/
 static hg_return_t
-hg_core_progress_poll(struct hg_core_private_context *context,
+hg_core_progress_poll_lock(struct hg_core_private_context *context,
     unsigned int timeout)
 {
-    double remaining;
-    hg_return_t ret = HG_TIMEOUT;
-
-    /* Do not block if NA_NO_BLOCK option is passed */
-    if (HG_CORE_CONTEXT_CLASS(context)->progress_mode == NA_NO_BLOCK) {
-        timeout = 0;
-        remaining = 0;
-    } else {
-        remaining = timeout / 1000.0; /* Convert timeout in ms into seconds */
-    }
+    hg_core_class_t *hg_core_class = context->core_context.core_class;
+    na_return_t na_ret;
+    hg_return_t ret = HG_SUCCESS;
+
+    /* Same lock as NA_Progress(), another thread may be progressing the same
+     * NA context through the poll set or through NA_Progress() */
+    if (context->na_poll_registered) {
+        na_ret = NA_Progress_lock(hg_core_class->na_class,
+            context->core_context.na_context, timeout);
+        if (na_ret == NA_TIMEOUT) {
+            ret = HG_TIMEOUT;
+            goto done;
+        }
+        HG_CHECK_ERROR(na_ret != NA_SUCCESS, done, ret,
+            (hg_return_t) na_ret, "Could not lock NA progress (%s)",
+            NA_Error_to_string(na_ret));
+    }
+#ifdef HG_HAS_SM_ROUTING
+    /* Always locked after the NA class lock */
+    if (context->na_sm_poll_registered) {
+        na_ret = NA_Progress_lock(hg_core_class->na_sm_class,
+            context->core_context.na_sm_context, timeout);
+        if (na_ret != NA_SUCCESS) {
+            if (context->na_poll_registered)
+                NA_Progress_unlock(hg_core_class->na_class,
+                    context->core_context.na_context);
+            if (na_ret == NA_TIMEOUT) {
+                ret = HG_TIMEOUT;
+                goto done;
+            }
+            HG_GOTO_ERROR(done, ret, (hg_return_t) na_ret,
+                "Could not lock NA SM progress (%s)",
+                NA_Error_to_string(na_ret));
+        }
+    }
+#endif
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+hg_core_progress_poll_unlock(struct hg_core_private_context *context)
+{
+    hg_core_class_t *hg_core_class = context->core_context.core_class;
+
+#ifdef HG_HAS_SM_ROUTING
+    if (context->na_sm_poll_registered)
+        NA_Progress_unlock(hg_core_class->na_sm_class,
+            context->core_context.na_sm_context);
+#endif
+    if (context->na_poll_registered)
+        NA_Progress_unlock(hg_core_class->na_class,
+            context->core_context.na_context);
+}
+
+/*---------------------------------------------------------------------------*/
+static hg_return_t
+hg_core_progress_poll(struct hg_core_private_context *context,
+    unsigned int timeout)
+{
+    double remaining, poll_timeout;
+    hg_return_t ret = HG_TIMEOUT;
+
+    /* Do not block if NA_NO_BLOCK option is passed */
+    if (HG_CORE_CONTEXT_CLASS(context)->progress_mode == NA_NO_BLOCK) {
+        timeout = 0;
+        remaining = 0;
+    } else {
+        remaining = timeout / 1000.0; /* Convert timeout in ms into seconds */
+    }
 
     do {
-        hg_time_t t1, t2;
+        hg_time_ticks_t t1 = 0, t2;
         hg_util_bool_t progressed;
         int rc;
 
         if (timeout)
-            hg_time_get_current(&t1);
+            t1 = hg_time_get_ticks();
+
+        ret = hg_core_progress_poll_lock(context,
+            (unsigned int)(remaining * 1000.0));
+        if (ret == HG_TIMEOUT)
+            break;
+        HG_CHECK_HG_ERROR(done, ret, "Could not lock NA progress");
+        ret = HG_TIMEOUT;
+
+        /* Time spent waiting for the lock is not spent polling */
+        if (timeout) {
+            t2 = hg_time_get_ticks();
+            poll_timeout = remaining - hg_time_ticks_to_double(t2 - t1);
+            if (poll_timeout < 0)
+                poll_timeout = 0;
+        } else
+            poll_timeout = 0;
 
         /* Will call hg_core_poll_try_wait_cb if timeout is not 0 */
-        rc = hg_poll_wait(context->poll_set, (unsigned int)(remaining * 1000.0),
-            &progressed);
+        rc = hg_poll_wait(context->poll_set,
+            (unsigned int)(poll_timeout * 1000.0), &progressed);
+        hg_core_progress_poll_unlock(context);
         HG_CHECK_ERROR(rc != HG_UTIL_SUCCESS, done, ret, HG_PROTOCOL_ERROR,
             "hg_poll_wait() failed");
 
+        /* Plugin callbacks were directly dispatched from the poll set, NA
+         * completions must now be triggered */
+        if (context->na_poll_registered
+#ifdef HG_HAS_SM_ROUTING
+            || context->na_sm_poll_registered
+#endif
+            ) {
+            unsigned int completed_count = 0;
+
+            if (context->na_poll_registered) {
+                ret = hg_core_progress_na_trigger(
+                    context->core_context.na_context, &completed_count);
+                HG_CHECK_HG_ERROR(done, ret, "Could not trigger NA callbacks");
+            }
+#ifdef HG_HAS_SM_ROUTING
+            if (context->na_sm_poll_registered) {
+                ret = hg_core_progress_na_trigger(
+                    context->core_context.na_sm_context, &completed_count);
+                HG_CHECK_HG_ERROR(done, ret,
+                    "Could not trigger NA SM callbacks");
+            }
+#endif
+            ret = HG_TIMEOUT;
+
+            /* Only report progress if something reached the HG layer */
+            progressed = (completed_count
+                || !hg_atomic_queue_chain_is_empty(context->completion_queue));
+        }
+
         /* We progressed, return success */
         if (progressed) {
             ret = HG_SUCCESS;
@@ -3123,8 +3622,8 @@ hg_core_progress_poll(struct hg_core_private_context *context,
         }
 
         if (timeout) {
-            hg_time_get_current(&t2);
-            remaining -= hg_time_to_double(hg_time_subtract(t2, t1));
+            t2 = hg_time_get_ticks();
+            remaining -= hg_time_ticks_to_double(t2 - t1);
         }
     } while ((int)(remaining * 1000.0) > 0);
 
@@ -3132,11 +3631,99 @@ done:
     return ret;
 }
 
+/*---------------------------------------------------------------------------*/
+static int
+hg_core_poll_group_cb(void *arg, int HG_UNUSED error,
+    hg_util_bool_t *progressed)
+{
+    struct hg_core_poll_group_entry *hg_core_poll_group_entry =
+        (struct hg_core_poll_group_entry *) arg;
+    struct hg_core_private_context *context =
+        hg_core_poll_group_entry->context;
+    hg_return_t ret;
+    int rc = HG_UTIL_SUCCESS;
+
+    /* Event may have been returned before context was removed, context must
+     * no longer be used once removal has been observed */
+    hg_atomic_incr32(&hg_core_poll_group_entry->busy);
+    if (hg_atomic_get32(&hg_core_poll_group_entry->removed)) {
+        *progressed = HG_UTIL_FALSE;
+        goto done;
+    }
+
+    /* Context poll set has events, progress on it without blocking */
+    ret = context->progress(context, 0);
+    if (ret == HG_TIMEOUT) {
+        /* Nothing progressed */
+        *progressed = HG_UTIL_FALSE;
+        goto done;
+    } else
+        HG_CHECK_ERROR(ret != HG_SUCCESS, done, rc, HG_UTIL_FAIL,
+            "Could not make progress on context");
+
+    /* Mark context as ready, it will be reported by poll group progress */
+    hg_atomic_set32(&hg_core_poll_group_entry->ready, HG_TRUE);
+    *progressed = HG_UTIL_TRUE;
+
+done:
+    hg_atomic_decr32(&hg_core_poll_group_entry->busy);
+    return rc;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+hg_core_poll_group_release(struct hg_core_poll_group *hg_core_poll_group)
+{
+    struct hg_core_poll_group_entry *hg_core_poll_group_entry, *next;
+
+    /* Entries are no longer in the poll set, a progress call started after
+     * that point cannot return them */
+    hg_thread_spin_lock(&hg_core_poll_group->entry_list_lock);
+    hg_core_poll_group_entry = HG_LIST_FIRST(&hg_core_poll_group->removed_list);
+    HG_LIST_INIT(&hg_core_poll_group->removed_list);
+    hg_thread_spin_unlock(&hg_core_poll_group->entry_list_lock);
+
+    while (hg_core_poll_group_entry) {
+        next = HG_LIST_NEXT(hg_core_poll_group_entry, entry);
+        free(hg_core_poll_group_entry);
+        hg_core_poll_group_entry = next;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+static hg_util_bool_t
+hg_core_poll_group_try_wait_cb(void *arg)
+{
+    struct hg_core_poll_group *hg_core_poll_group =
+        (struct hg_core_poll_group *) arg;
+    struct hg_core_poll_group_entry *hg_core_poll_group_entry;
+    hg_util_bool_t ret = HG_UTIL_TRUE;
+
+    /* Only safe to block if it is safe to block on every context */
+    hg_thread_spin_lock(&hg_core_poll_group->entry_list_lock);
+    HG_LIST_FOREACH(hg_core_poll_group_entry,
+        &hg_core_poll_group->entry_list, entry) {
+        if (hg_atomic_get32(&hg_core_poll_group_entry->ready)
+            || !hg_core_poll_try_wait_cb(hg_core_poll_group_entry->context)) {
+            ret = HG_UTIL_FALSE;
+            break;
+        }
+    }
+    hg_thread_spin_unlock(&hg_core_poll_group->entry_list_lock);
+
+    return ret;
+}
+
 /*---------------------------------------------------------------------------*/
 static hg_return_t
 hg_core_trigger(struct hg_core_private_context *context, unsigned int timeout,
     unsigned int max_count, unsigned int *actual_count)
 {
+    struct hg_core_trigger_slot hg_core_trigger_slot = {context, NULL,
+        HG_FALSE};
+    struct hg_core_trigger_slot *prev_trigger_slot = NULL;
+    hg_bool_t na_direct_completion =
+        HG_CORE_CONTEXT_CLASS(context)->na_direct_completion;
     double remaining;
     unsigned int count = 0;
     hg_return_t ret = HG_SUCCESS;
@@ -3149,96 +3736,157 @@ hg_core_trigger(struct hg_core_private_context *context, unsigned int timeout,
         remaining = timeout / 1000.0; /* Convert timeout in ms into seconds */
     }
 
+    /* NA entries may be in the completion queue, install trigger slot */
+    if (na_direct_completion) {
+        prev_trigger_slot = (struct hg_core_trigger_slot *)
+            hg_thread_getspecific(
+                HG_CORE_CONTEXT_CLASS(context)->trigger_slot_key);
+        hg_thread_setspecific(HG_CORE_CONTEXT_CLASS(context)->trigger_slot_key,
+            &hg_core_trigger_slot);
+    }
+
     while (count < max_count) {
-        struct hg_completion_entry *hg_completion_entry = NULL;
-
-        hg_completion_entry =
-            hg_atomic_queue_pop_mc(context->completion_queue);
-        if (!hg_completion_entry) {
-            /* Check backfill queue */
-            if (hg_atomic_get32(&context->backfill_queue_count)) {
-                hg_thread_mutex_lock(&context->completion_queue_mutex);
-                hg_completion_entry = HG_QUEUE_FIRST(&context->backfill_queue);
-                HG_QUEUE_POP_HEAD(&context->backfill_queue, entry);
-                hg_atomic_decr32(&context->backfill_queue_count);
-                hg_thread_mutex_unlock(&context->completion_queue_mutex);
-                if (!hg_completion_entry)
-                    continue; /* Give another change to grab it */
-            } else {
-                hg_time_t t1, t2;
+        struct hg_completion_entry *hg_completion_entries[
+            HG_CORE_TRIGGER_BATCH_SIZE];
+        unsigned int batch_count, i;
+
+        /* Claim a batch of entries at once */
+        batch_count = hg_atomic_queue_chain_pop_mc_n(context->completion_queue,
+            (void **) hg_completion_entries,
+            HG_CORE_MIN(max_count - count, HG_CORE_TRIGGER_BATCH_SIZE));
+        if (!batch_count) {
+            hg_time_ticks_t t1, t2;
+
+            /* If something was already processed leave */
+            if (count)
+                break;
 
-                /* If something was already processed leave */
-                if (count)
-                    break;
+            /* Timeout is 0 so leave */
+            if ((int)(remaining * 1000.0) <= 0) {
+                ret = HG_TIMEOUT;
+                break;
+            }
+
+            t1 = hg_time_get_ticks();
 
-                /* Timeout is 0 so leave */
-                if ((int)(remaining * 1000.0) <= 0) {
+            hg_atomic_incr32(&context->trigger_waiting);
+            hg_thread_mutex_lock(&context->completion_queue_mutex);
+            /* Otherwise wait timeout ms */
+            while (hg_atomic_queue_chain_is_empty(context->completion_queue)) {
+                if (hg_thread_cond_timedwait(&context->completion_queue_cond,
+                    &context->completion_queue_mutex, timeout)
+                    != HG_UTIL_SUCCESS) {
+                    /* Timeout occurred so leave */
                     ret = HG_TIMEOUT;
                     break;
                 }
-
-                hg_time_get_current(&t1);
-
-                hg_atomic_incr32(&context->trigger_waiting);
-                hg_thread_mutex_lock(&context->completion_queue_mutex);
-                /* Otherwise wait timeout ms */
-                while (hg_atomic_queue_is_empty(context->completion_queue) &&
-                    !hg_atomic_get32(&context->backfill_queue_count)) {
-                    if (hg_thread_cond_timedwait(&context->completion_queue_cond,
-                        &context->completion_queue_mutex, timeout)
-                        != HG_UTIL_SUCCESS) {
-                        /* Timeout occurred so leave */
-                        ret = HG_TIMEOUT;
-                        break;
-                    }
-                }
-                hg_thread_mutex_unlock(&context->completion_queue_mutex);
-                hg_atomic_decr32(&context->trigger_waiting);
-                if (ret == HG_TIMEOUT)
-                    break;
-
-                hg_time_get_current(&t2);
-                remaining -= hg_time_to_double(hg_time_subtract(t2, t1));
-                continue; /* Give another change to grab it */
             }
+            hg_thread_mutex_unlock(&context->completion_queue_mutex);
+            hg_atomic_decr32(&context->trigger_waiting);
+            if (ret == HG_TIMEOUT)
+                break;
+
+            t2 = hg_time_get_ticks();
+            remaining -= hg_time_ticks_to_double(t2 - t1);
+            continue; /* Give another change to grab it */
         }
 
-        /* Completion queue should not be empty now */
-        HG_CHECK_ERROR(hg_completion_entry == NULL, done, ret,
-            HG_FAULT, "NULL completion entry");
+        /* Entries of the batch are no longer in the queue, trigger all of
+         * them even if one fails and report the first error. NA entries
+         * only count if they completed an HG operation. */
+        for (i = 0; i < batch_count; i++) {
+            hg_return_t trigger_ret;
 
-        /* Trigger entry */
-        switch(hg_completion_entry->op_type) {
-            case HG_ADDR:
-                ret = hg_core_trigger_lookup_entry(
-                    hg_completion_entry->op_id.hg_core_op_id);
-                HG_CHECK_HG_ERROR(done, ret,
-                    "Could not trigger addr completion entry");
-                break;
-            case HG_RPC:
-                ret = hg_core_trigger_entry((struct hg_core_private_handle *)
-                    hg_completion_entry->op_id.hg_core_handle);
-                HG_CHECK_HG_ERROR(done, ret,
-                    "Could not trigger RPC completion entry");
-                break;
-            case HG_BULK:
-                ret = hg_bulk_trigger_entry(
-                    hg_completion_entry->op_id.hg_bulk_op_id);
-                HG_CHECK_HG_ERROR(done, ret,
-                    "Could not trigger bulk completion entry");
-                break;
-            default:
-                HG_GOTO_ERROR(done, ret, HG_INVALID_ARG,
-                    "Invalid type of completion entry (%d)",
-                    (int) hg_completion_entry->op_type);
-        }
+            if (HG_CORE_IS_NA_ENTRY(hg_completion_entries[i])) {
+                hg_bool_t completed = HG_FALSE;
 
-        count++;
+                trigger_ret = hg_core_trigger_na_entry(&hg_core_trigger_slot,
+                    HG_CORE_NA_ENTRY_TO_PTR(hg_completion_entries[i]),
+                    &completed);
+                if (completed)
+                    count++;
+            } else {
+                trigger_ret =
+                    hg_core_trigger_completion_entry(hg_completion_entries[i]);
+                count++;
+            }
+            if (trigger_ret != HG_SUCCESS && ret == HG_SUCCESS)
+                ret = trigger_ret;
+        }
+        HG_CHECK_HG_ERROR(done, ret, "Could not trigger completion entries");
     }
 
     if (actual_count)
         *actual_count = count;
 
+done:
+    if (na_direct_completion)
+        hg_thread_setspecific(HG_CORE_CONTEXT_CLASS(context)->trigger_slot_key,
+            prev_trigger_slot);
+
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static HG_INLINE hg_return_t
+hg_core_trigger_completion_entry(
+    struct hg_completion_entry *hg_completion_entry)
+{
+    hg_return_t ret = HG_SUCCESS;
+
+    switch(hg_completion_entry->op_type) {
+        case HG_ADDR:
+            ret = hg_core_trigger_lookup_entry(
+                hg_completion_entry->op_id.hg_core_op_id);
+            HG_CHECK_HG_ERROR(done, ret,
+                "Could not trigger addr completion entry");
+            break;
+        case HG_RPC:
+            ret = hg_core_trigger_entry((struct hg_core_private_handle *)
+                hg_completion_entry->op_id.hg_core_handle);
+            HG_CHECK_HG_ERROR(done, ret,
+                "Could not trigger RPC completion entry");
+            break;
+        case HG_BULK:
+            ret = hg_bulk_trigger_entry(
+                hg_completion_entry->op_id.hg_bulk_op_id);
+            HG_CHECK_HG_ERROR(done, ret,
+                "Could not trigger bulk completion entry");
+            break;
+        default:
+            HG_GOTO_ERROR(done, ret, HG_INVALID_ARG,
+                "Invalid type of completion entry (%d)",
+                (int) hg_completion_entry->op_type);
+    }
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static HG_INLINE hg_return_t
+hg_core_trigger_na_entry(struct hg_core_trigger_slot *hg_core_trigger_slot,
+    void *na_completion_entry, hg_bool_t *completed)
+{
+    struct hg_completion_entry *hg_completion_entry;
+    hg_return_t ret = HG_SUCCESS;
+
+    /* Run NA callback, which also releases NA resources, the HG entry that it
+     * produces is only triggered once the NA operation ID can be re-used */
+    hg_core_trigger_slot->hg_completion_entry = NULL;
+    hg_core_trigger_slot->armed = HG_TRUE;
+    NA_Trigger_entry(na_completion_entry);
+    hg_core_trigger_slot->armed = HG_FALSE;
+
+    hg_completion_entry = hg_core_trigger_slot->hg_completion_entry;
+    if (!hg_completion_entry)
+        goto done;
+    hg_core_trigger_slot->hg_completion_entry = NULL;
+
+    *completed = HG_TRUE;
+    ret = hg_core_trigger_completion_entry(hg_completion_entry);
+    HG_CHECK_HG_ERROR(done, ret, "Could not trigger completion entry");
+
 done:
     return ret;
 }
@@ -3272,7 +3920,8 @@ hg_core_trigger_lookup_entry(struct hg_core_op_id *hg_core_op_id)
     }
 
 done:
-    free(hg_core_op_id);
+    hg_mem_pool_free(HG_CORE_CONTEXT_CLASS(hg_core_op_id->context)->op_id_pool,
+        hg_core_op_id);
     return ret;
 }
 
@@ -3477,10 +4126,9 @@ hg_core_context_t *
 HG_Core_context_create_id(hg_core_class_t *hg_core_class, hg_uint8_t id)
 {
     struct hg_core_private_context *context = NULL;
+    na_return_t na_ret;
     int na_poll_fd;
-#ifdef HG_HAS_SELF_FORWARD
     int fd;
-#endif
 
     HG_CHECK_ERROR_NORET(hg_core_class == NULL, error, "NULL HG core class");
 
@@ -3491,13 +4139,11 @@ HG_Core_context_create_id(hg_core_class_t *hg_core_class, hg_uint8_t id)
 
     memset(context, 0, sizeof(struct hg_core_private_context));
     context->core_context.core_class = hg_core_class;
-    context->completion_queue =
-        hg_atomic_queue_alloc(HG_CORE_ATOMIC_QUEUE_SIZE);
+    context->completion_queue = hg_atomic_queue_chain_alloc(
+        ((struct hg_core_private_class *) hg_core_class)->completion_queue_size);
     HG_CHECK_ERROR_NORET(context->completion_queue == NULL, error,
         "Could not allocate queue");
 
-    HG_QUEUE_INIT(&context->backfill_queue);
-    hg_atomic_init32(&context->backfill_queue_count, 0);
     HG_LIST_INIT(&context->pending_list);
 #ifdef HG_HAS_SM_ROUTING
     HG_LIST_INIT(&context->sm_pending_list);
@@ -3529,33 +4175,63 @@ HG_Core_context_create_id(hg_core_class_t *hg_core_class, hg_uint8_t id)
     }
 #endif
 
+    /* Let NA complete directly into the context completion queue */
+    if (((struct hg_core_private_class *) hg_core_class)->na_direct_completion) {
+        na_ret = NA_Context_set_completion_push(
+            context->core_context.na_context, hg_core_na_completion_push,
+            context);
+        HG_CHECK_ERROR_NORET(na_ret != NA_SUCCESS, error,
+            "Could not set NA completion push (%s)",
+            NA_Error_to_string(na_ret));
+#ifdef HG_HAS_SM_ROUTING
+        if (context->core_context.na_sm_context) {
+            na_ret = NA_Context_set_completion_push(
+                context->core_context.na_sm_context,
+                hg_core_na_completion_push, context);
+            HG_CHECK_ERROR_NORET(na_ret != NA_SUCCESS, error,
+                "Could not set NA SM completion push (%s)",
+                NA_Error_to_string(na_ret));
+        }
+#endif
+    }
+
     /* Create poll set */
     context->poll_set = hg_poll_create();
     HG_CHECK_ERROR_NORET(context->poll_set == NULL, error,
         "Could not create poll set");
 
-#ifdef HG_HAS_SELF_FORWARD
     /* Create event for completion queue notification */
     fd = hg_event_create();
     HG_CHECK_ERROR_NORET(fd < 0, error, "Could not create event");
     context->completion_queue_notify = fd;
+    hg_atomic_init32(&context->fd_exposed, HG_FALSE);
 
     /* Add event to context poll set */
     hg_poll_add(context->poll_set, fd, HG_POLLIN,
         hg_core_completion_queue_notify_cb, context);
-#endif
 
     if (HG_CORE_CONTEXT_CLASS(context)->progress_mode == NA_NO_BLOCK)
         /* Force to use progress poll */
         na_poll_fd = 0;
-    else
+    else {
+        /* If NA plugin can register its fds directly, avoid polling on a
+         * nested poll set */
+        na_ret = NA_Poll_register(hg_core_class->na_class,
+            context->core_context.na_context, context->poll_set);
+        HG_CHECK_ERROR_NORET(na_ret != NA_SUCCESS
+            && na_ret != NA_OPNOTSUPPORTED, error,
+            "Could not register NA poll set (%s)", NA_Error_to_string(na_ret));
+        context->na_poll_registered = (na_ret == NA_SUCCESS);
+
         /* If NA plugin exposes fd, add it to poll set and use appropriate
          * progress function */
-        na_poll_fd = NA_Poll_get_fd(hg_core_class->na_class,
-            context->core_context.na_context);
+        na_poll_fd = (context->na_poll_registered) ? 0 : NA_Poll_get_fd(
+            hg_core_class->na_class, context->core_context.na_context);
+    }
     if (na_poll_fd >= 0) {
-        hg_poll_add(context->poll_set, na_poll_fd, HG_POLLIN,
-            hg_core_progress_na_cb, context);
+        if (!context->na_poll_registered)
+            hg_poll_add(context->poll_set, na_poll_fd, HG_POLLIN,
+                hg_core_progress_na_cb, context);
         hg_poll_set_try_wait(context->poll_set, hg_core_poll_try_wait_cb,
             context);
         context->progress = hg_core_progress_poll;
@@ -3572,13 +4248,23 @@ HG_Core_context_create_id(hg_core_class_t *hg_core_class, hg_uint8_t id)
             /* Force to use progress poll */
             na_poll_fd = 0;
         else {
-            na_poll_fd = NA_Poll_get_fd(hg_core_class->na_sm_class,
-                context->core_context.na_sm_context);
+            /* Register NA SM fds directly if possible */
+            na_ret = NA_Poll_register(hg_core_class->na_sm_class,
+                context->core_context.na_sm_context, context->poll_set);
+            HG_CHECK_ERROR_NORET(na_ret != NA_SUCCESS
+                && na_ret != NA_OPNOTSUPPORTED, error,
+                "Could not register NA SM poll set (%s)",
+                NA_Error_to_string(na_ret));
+            context->na_sm_poll_registered = (na_ret == NA_SUCCESS);
+
+            na_poll_fd = (context->na_sm_poll_registered) ? 0 : NA_Poll_get_fd(
+                hg_core_class->na_sm_class, context->core_context.na_sm_context);
             HG_CHECK_ERROR_NORET(na_poll_fd < 0, error,
                 "Could not get NA SM poll fd");
         }
-        hg_poll_add(context->poll_set, na_poll_fd, HG_POLLIN,
-            hg_core_progress_na_sm_cb, context);
+        if (!context->na_sm_poll_registered)
+            hg_poll_add(context->poll_set, na_poll_fd, HG_POLLIN,
+                hg_core_progress_na_sm_cb, context);
     }
 #endif
 
@@ -3604,7 +4290,6 @@ HG_Core_context_destroy(hg_core_context_t *context)
     unsigned int actual_count;
     int na_poll_fd;
     hg_util_int32_t n_handles;
-    hg_bool_t empty;
     na_return_t na_ret;
     hg_return_t ret = HG_SUCCESS;
     int rc;
@@ -3612,6 +4297,9 @@ HG_Core_context_destroy(hg_core_context_t *context)
     if (!context)
         goto done;
 
+    HG_CHECK_ERROR(private_context->poll_group_entry != NULL, done, ret,
+        HG_BUSY, "Context must be removed from poll group first");
+
     /* Prevent repost of handles */
     private_context->finalizing = HG_TRUE;
 
@@ -3660,32 +4348,52 @@ HG_Core_context_destroy(hg_core_context_t *context)
         goto done;
     }
 
-    /* Check that completion queue is empty now */
-    HG_CHECK_ERROR(!hg_atomic_queue_is_empty(private_context->completion_queue),
-        done, ret, HG_BUSY, "Completion queue should be empty");
-    hg_atomic_queue_free(private_context->completion_queue);
+    /* Detach NA contexts from the completion queue */
+    if (HG_CORE_CONTEXT_CLASS(private_context)->na_direct_completion) {
+        na_ret = NA_Context_set_completion_push(context->na_context, NULL,
+            NULL);
+        HG_CHECK_ERROR(na_ret != NA_SUCCESS, done, ret, (hg_return_t) na_ret,
+            "Could not reset NA completion push (%s)",
+            NA_Error_to_string(na_ret));
+#ifdef HG_HAS_SM_ROUTING
+        if (context->na_sm_context) {
+            na_ret = NA_Context_set_completion_push(context->na_sm_context,
+                NULL, NULL);
+            HG_CHECK_ERROR(na_ret != NA_SUCCESS, done, ret,
+                (hg_return_t) na_ret,
+                "Could not reset NA SM completion push (%s)",
+                NA_Error_to_string(na_ret));
+        }
+#endif
+    }
 
     /* Check that completion queue is empty now */
-    hg_thread_mutex_lock(&private_context->completion_queue_mutex);
-    empty = HG_QUEUE_IS_EMPTY(&private_context->backfill_queue);
-    hg_thread_mutex_unlock(&private_context->completion_queue_mutex);
-    HG_CHECK_ERROR(!empty, done, ret, HG_BUSY,
-        "Completion queue should be empty");
+    HG_CHECK_ERROR(
+        !hg_atomic_queue_chain_is_empty(private_context->completion_queue),
+        done, ret, HG_BUSY, "Completion queue should be empty");
+    hg_atomic_queue_chain_free(private_context->completion_queue);
 
-#ifdef HG_HAS_SELF_FORWARD
     if (private_context->completion_queue_notify > 0) {
         rc = hg_poll_remove(private_context->poll_set,
             private_context->completion_queue_notify);
         HG_CHECK_ERROR(rc != HG_UTIL_SUCCESS, done, ret, HG_NOENTRY,
-            "Could not remove self processing event from poll set");
+            "Could not remove completion event from poll set");
 
         rc = hg_event_destroy(private_context->completion_queue_notify);
         HG_CHECK_ERROR(rc != HG_UTIL_SUCCESS, done, ret, HG_NOENTRY,
-            "Could not destroy self processing event");
+            "Could not destroy completion event");
     }
-#endif
 
-    if (HG_CORE_CONTEXT_CLASS(private_context)->progress_mode == NA_NO_BLOCK)
+    if (private_context->na_poll_registered) {
+        /* NA plugin registered its fds directly */
+        na_ret = NA_Poll_deregister(context->core_class->na_class,
+            context->na_context, private_context->poll_set);
+        HG_CHECK_ERROR(na_ret != NA_SUCCESS, done, ret, (hg_return_t) na_ret,
+            "Could not deregister NA poll set (%s)", NA_Error_to_string(na_ret));
+        private_context->na_poll_registered = HG_FALSE;
+        na_poll_fd = -1;
+    } else if (HG_CORE_CONTEXT_CLASS(private_context)->progress_mode
+        == NA_NO_BLOCK)
         /* Was forced to use progress poll */
         na_poll_fd = 0;
     else
@@ -3699,7 +4407,15 @@ HG_Core_context_destroy(hg_core_context_t *context)
     }
 
 #ifdef HG_HAS_SM_ROUTING
-    if (context->na_sm_context) {
+    if (private_context->na_sm_poll_registered) {
+        /* NA SM registered its fds directly */
+        na_ret = NA_Poll_deregister(context->core_class->na_sm_class,
+            context->na_sm_context, private_context->poll_set);
+        HG_CHECK_ERROR(na_ret != NA_SUCCESS, done, ret, (hg_return_t) na_ret,
+            "Could not deregister NA SM poll set (%s)",
+            NA_Error_to_string(na_ret));
+        private_context->na_sm_poll_registered = HG_FALSE;
+    } else if (context->na_sm_context) {
         if (HG_CORE_CONTEXT_CLASS(private_context)->progress_mode == NA_NO_BLOCK)
             /* Was forced to use progress poll */
             na_poll_fd = 0;
@@ -3722,6 +4438,10 @@ HG_Core_context_destroy(hg_core_context_t *context)
 
     /* Destroy NA context */
     if (context->na_context) {
+#ifdef HG_HAS_COLLECT_STATS
+        if (HG_CORE_CONTEXT_CLASS(private_context)->stats)
+            hg_core_na_stats_add(context->na_context);
+#endif
         na_ret = NA_Context_destroy(context->core_class->na_class,
             context->na_context);
         HG_CHECK_ERROR(na_ret != NA_SUCCESS, done, ret, (hg_return_t) na_ret,
@@ -3731,6 +4451,10 @@ HG_Core_context_destroy(hg_core_context_t *context)
 #ifdef HG_HAS_SM_ROUTING
     /* Destroy NA SM context */
     if (context->na_sm_context) {
+#ifdef HG_HAS_COLLECT_STATS
+        if (HG_CORE_CONTEXT_CLASS(private_context)->stats)
+            hg_core_na_stats_add(context->na_sm_context);
+#endif
         na_ret = NA_Context_destroy(context->core_class->na_sm_class,
             context->na_sm_context);
         HG_CHECK_ERROR(na_ret != NA_SUCCESS, done, ret, (hg_return_t) na_ret,
@@ -3757,6 +4481,52 @@ done:
     return ret;
 }
 
+/*---------------------------------------------------------------------------*/
+int
+HG_Core_context_get_fd(hg_core_context_t *context)
+{
+    struct hg_core_private_context *private_context =
+        (struct hg_core_private_context *) context;
+    int fd = -1;
+
+    HG_CHECK_ERROR_NORET(context == NULL, done, "NULL HG core context");
+
+    /* Only contexts that make progress through their poll set expose a fd */
+    HG_CHECK_ERROR_NORET(private_context->progress != hg_core_progress_poll
+        || HG_CORE_CONTEXT_CLASS(private_context)->progress_mode
+        == NA_NO_BLOCK, done, "Context does not expose a file descriptor");
+
+    /* Poll set fd aggregates NA fds and completion queue notification */
+    fd = hg_poll_get_fd(private_context->poll_set);
+    HG_CHECK_ERROR_NORET(fd <= 0, done,
+        "Could not get poll fd from context poll set");
+
+    /* From now on, every completion signals the completion queue event */
+    hg_atomic_set32(&private_context->fd_exposed, HG_TRUE);
+
+done:
+    return fd;
+}
+
+/*---------------------------------------------------------------------------*/
+hg_bool_t
+HG_Core_context_try_wait(hg_core_context_t *context)
+{
+    struct hg_core_private_context *private_context =
+        (struct hg_core_private_context *) context;
+    hg_bool_t ret = HG_FALSE;
+
+    HG_CHECK_ERROR_NORET(context == NULL, done, "NULL HG core context");
+
+    if (private_context->progress != hg_core_progress_poll)
+        goto done;
+
+    ret = (hg_bool_t) hg_core_poll_try_wait_cb(private_context);
+
+done:
+    return ret;
+}
+
 /*---------------------------------------------------------------------------*/
 hg_return_t
 HG_Core_context_set_handle_create_callback(hg_core_context_t *context,
@@ -3813,29 +4583,17 @@ HG_Core_register(hg_core_class_t *hg_core_class, hg_id_t id,
 {
     struct hg_core_private_class *private_class =
         (struct hg_core_private_class *) hg_core_class;
-    hg_id_t *func_key = NULL;
     struct hg_core_rpc_info *hg_core_rpc_info = NULL;
+    void *cur_rpc_info = NULL;
     hg_return_t ret = HG_SUCCESS;
     int hash_ret;
 
     HG_CHECK_ERROR(hg_core_class == NULL, error, ret, HG_INVALID_ARG,
         "NULL HG core class");
 
-    /* Check if registered and set RPC CB */
-    hg_thread_spin_lock(&private_class->func_map_lock);
-    hg_core_rpc_info = (struct hg_core_rpc_info *) hg_hash_table_lookup(
-            private_class->func_map, (hg_hash_table_key_t) &id);
-    if (hg_core_rpc_info && rpc_cb)
-        hg_core_rpc_info->rpc_cb = rpc_cb;
-    hg_thread_spin_unlock(&private_class->func_map_lock);
-
-    if (!hg_core_rpc_info) {
-        /* Allocate the key */
-        func_key = (hg_id_t *) malloc(sizeof(hg_id_t));
-        HG_CHECK_ERROR(func_key == NULL, error, ret, HG_NOMEM,
-            "Could not allocate ID key");
-        *func_key = id;
-
+    /* Check if registered */
+    if (hg_hash_map_lookup_int(private_class->func_map, id, &cur_rpc_info)
+        != HG_UTIL_SUCCESS) {
         /* Fill info and store it into the function map */
         hg_core_rpc_info = (struct hg_core_rpc_info *) malloc(
             sizeof(struct hg_core_rpc_info));
@@ -3846,18 +4604,23 @@ HG_Core_register(hg_core_class_t *hg_core_class, hg_id_t id,
         hg_core_rpc_info->data = NULL;
         hg_core_rpc_info->free_callback = NULL;
 
-        hg_thread_spin_lock(&private_class->func_map_lock);
-        hash_ret = hg_hash_table_insert(private_class->func_map,
-            (hg_hash_table_key_t) func_key, hg_core_rpc_info);
-        hg_thread_spin_unlock(&private_class->func_map_lock);
-        HG_CHECK_ERROR(hash_ret == 0, error, ret, HG_INVALID_ARG,
-            "Could not insert RPC ID into function map (already registered?)");
+        hash_ret = hg_hash_map_insert_int(private_class->func_map, id,
+            hg_core_rpc_info, &cur_rpc_info);
+        HG_CHECK_ERROR(hash_ret != HG_UTIL_SUCCESS, error, ret, HG_NOMEM,
+            "Could not insert RPC ID into function map");
+
+        /* Concurrently registered */
+        if (cur_rpc_info != hg_core_rpc_info)
+            free(hg_core_rpc_info);
     }
 
+    /* Set RPC CB */
+    if (rpc_cb)
+        ((struct hg_core_rpc_info *) cur_rpc_info)->rpc_cb = rpc_cb;
+
     return ret;
 
 error:
-    free(func_key);
     free(hg_core_rpc_info);
 
     return ret;
@@ -3869,19 +4632,20 @@ HG_Core_deregister(hg_core_class_t *hg_core_class, hg_id_t id)
 {
     struct hg_core_private_class *private_class =
         (struct hg_core_private_class *) hg_core_class;
+    void *hg_core_rpc_info;
     hg_return_t ret = HG_SUCCESS;
     int hash_ret;
 
     HG_CHECK_ERROR(hg_core_class == NULL, done, ret, HG_INVALID_ARG,
         "NULL HG core class");
 
-    hg_thread_spin_lock(&private_class->func_map_lock);
-    hash_ret = hg_hash_table_remove(private_class->func_map,
-        (hg_hash_table_key_t) &id);
-    hg_thread_spin_unlock(&private_class->func_map_lock);
-    HG_CHECK_ERROR(hash_ret == 0, done, ret, HG_NOENTRY,
+    hash_ret = hg_hash_map_remove_int(private_class->func_map, id,
+        &hg_core_rpc_info);
+    HG_CHECK_ERROR(hash_ret != HG_UTIL_SUCCESS, done, ret, HG_NOENTRY,
         "Could not deregister RPC ID from function map");
 
+    hg_core_func_map_value_free(hg_core_rpc_info);
+
 done:
     return ret;
 }
@@ -3899,10 +4663,8 @@ HG_Core_registered(hg_core_class_t *hg_core_class, hg_id_t id, hg_bool_t *flag)
     HG_CHECK_ERROR(flag == NULL, done, ret, HG_INVALID_ARG,
         "NULL flag");
 
-    hg_thread_spin_lock(&private_class->func_map_lock);
-    *flag = (hg_bool_t) (hg_hash_table_lookup(private_class->func_map,
-            (hg_hash_table_key_t) &id) != HG_HASH_TABLE_NULL);
-    hg_thread_spin_unlock(&private_class->func_map_lock);
+    *flag = (hg_bool_t) (hg_hash_map_lookup_int(private_class->func_map, id,
+        NULL) == HG_UTIL_SUCCESS);
 
 done:
     return ret;
@@ -3921,10 +4683,8 @@ HG_Core_register_data(hg_core_class_t *hg_core_class, hg_id_t id, void *data,
     HG_CHECK_ERROR(hg_core_class == NULL, done, ret, HG_INVALID_ARG,
         "NULL HG core class");
 
-    hg_thread_spin_lock(&private_class->func_map_lock);
-    hg_core_rpc_info = (struct hg_core_rpc_info *) hg_hash_table_lookup(
-        private_class->func_map, (hg_hash_table_key_t) &id);
-    hg_thread_spin_unlock(&private_class->func_map_lock);
+    hg_hash_map_lookup_int(private_class->func_map, id,
+        (void **) &hg_core_rpc_info);
     HG_CHECK_ERROR(hg_core_rpc_info == NULL, done, ret, HG_NOENTRY,
         "Could not find RPC ID in function map");
 
@@ -3948,10 +4708,8 @@ HG_Core_registered_data(hg_core_class_t *hg_core_class, hg_id_t id)
 
     HG_CHECK_ERROR_NORET(hg_core_class == NULL, done, "NULL HG core class");
 
-    hg_thread_spin_lock(&private_class->func_map_lock);
-    hg_core_rpc_info = (struct hg_core_rpc_info *) hg_hash_table_lookup(
-        private_class->func_map, (hg_hash_table_key_t) &id);
-    hg_thread_spin_unlock(&private_class->func_map_lock);
+    hg_hash_map_lookup_int(private_class->func_map, id,
+        (void **) &hg_core_rpc_info);
     HG_CHECK_ERROR_NORET(hg_core_rpc_info == NULL, done,
         "Could not find RPC ID in function map");
 
@@ -4320,6 +5078,14 @@ HG_Core_forward(hg_core_handle_t handle, hg_core_cb_t callback, void *arg,
         unsigned int trigger_count = 0;
         na_return_t na_ret;
 
+        /* NA completions are in the HG completion queue, which also holds
+         * user callbacks that must not be run from here, let the caller
+         * trigger the context and retry */
+        if (HG_CORE_HANDLE_CLASS(hg_core_handle)->na_direct_completion) {
+            hg_atomic_set32(&hg_core_handle->in_use, HG_FALSE);
+            HG_GOTO_DONE(done, ret, HG_AGAIN);
+        }
+
         na_ret = NA_Trigger(hg_core_handle->na_context, 0,
             HG_CORE_MAX_TRIGGER_COUNT, cb_ret, &trigger_count);
         HG_CHECK_ERROR(na_ret != NA_SUCCESS && na_ret != NA_TIMEOUT, done, ret,
@@ -4487,6 +5253,252 @@ done:
     return ret;
 }
 
+/*---------------------------------------------------------------------------*/
+hg_core_poll_group_t *
+HG_Core_poll_group_create(void)
+{
+    struct hg_core_poll_group *hg_core_poll_group = NULL;
+
+    hg_core_poll_group = (struct hg_core_poll_group *) malloc(
+        sizeof(struct hg_core_poll_group));
+    HG_CHECK_ERROR_NORET(hg_core_poll_group == NULL, error,
+        "Could not allocate poll group");
+
+    HG_LIST_INIT(&hg_core_poll_group->entry_list);
+    HG_LIST_INIT(&hg_core_poll_group->removed_list);
+    hg_thread_spin_init(&hg_core_poll_group->entry_list_lock);
+    hg_atomic_init32(&hg_core_poll_group->progress_count, 0);
+
+    hg_core_poll_group->poll_set = hg_poll_create();
+    HG_CHECK_ERROR_NORET(hg_core_poll_group->poll_set == NULL, error,
+        "Could not create poll set");
+
+    hg_poll_set_try_wait(hg_core_poll_group->poll_set,
+        hg_core_poll_group_try_wait_cb, hg_core_poll_group);
+
+    return (hg_core_poll_group_t *) hg_core_poll_group;
+
+error:
+    if (hg_core_poll_group) {
+        hg_thread_spin_destroy(&hg_core_poll_group->entry_list_lock);
+        free(hg_core_poll_group);
+    }
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+hg_return_t
+HG_Core_poll_group_destroy(hg_core_poll_group_t *poll_group)
+{
+    hg_bool_t empty;
+    hg_return_t ret = HG_SUCCESS;
+    int rc;
+
+    if (!poll_group)
+        goto done;
+
+    hg_thread_spin_lock(&poll_group->entry_list_lock);
+    empty = HG_LIST_IS_EMPTY(&poll_group->entry_list);
+    hg_thread_spin_unlock(&poll_group->entry_list_lock);
+    HG_CHECK_ERROR(!empty, done, ret, HG_BUSY,
+        "Contexts must be removed from poll group before destroying it");
+    HG_CHECK_ERROR(hg_atomic_get32(&poll_group->progress_count) != 0, done,
+        ret, HG_BUSY, "Poll group is being progressed");
+
+    hg_core_poll_group_release(poll_group);
+
+    rc = hg_poll_destroy(poll_group->poll_set);
+    HG_CHECK_ERROR(rc != HG_UTIL_SUCCESS, done, ret, HG_FAULT,
+        "Could not destroy poll set");
+
+    hg_thread_spin_destroy(&poll_group->entry_list_lock);
+    free(poll_group);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+hg_return_t
+HG_Core_poll_group_add(hg_core_poll_group_t *poll_group,
+    hg_core_context_t *context)
+{
+    struct hg_core_private_context *private_context =
+        (struct hg_core_private_context *) context;
+    struct hg_core_poll_group_entry *hg_core_poll_group_entry = NULL;
+    hg_return_t ret = HG_SUCCESS;
+    int fd, rc;
+
+    HG_CHECK_ERROR(poll_group == NULL, error, ret, HG_INVALID_ARG,
+        "NULL poll group");
+    HG_CHECK_ERROR(context == NULL, error, ret, HG_INVALID_ARG,
+        "NULL HG core context");
+    HG_CHECK_ERROR(private_context->poll_group_entry != NULL, error, ret,
+        HG_BUSY, "Context is already part of a poll group");
+
+    /* Contexts that do not use a poll set cannot be aggregated */
+    HG_CHECK_ERROR(private_context->progress != hg_core_progress_poll, error,
+        ret, HG_OPNOTSUPPORTED,
+        "Poll group not supported with selected plugin");
+    fd = hg_poll_get_fd(private_context->poll_set);
+    HG_CHECK_ERROR(fd <= 0, error, ret, HG_OPNOTSUPPORTED,
+        "Could not get poll fd from context poll set");
+
+    hg_core_poll_group_entry = (struct hg_core_poll_group_entry *) malloc(
+        sizeof(struct hg_core_poll_group_entry));
+    HG_CHECK_ERROR(hg_core_poll_group_entry == NULL, error, ret, HG_NOMEM,
+        "Could not allocate poll group entry");
+    hg_core_poll_group_entry->poll_group = poll_group;
+    hg_core_poll_group_entry->context = private_context;
+    hg_atomic_init32(&hg_core_poll_group_entry->ready, HG_FALSE);
+    hg_atomic_init32(&hg_core_poll_group_entry->removed, HG_FALSE);
+    hg_atomic_init32(&hg_core_poll_group_entry->busy, 0);
+
+    /* Context poll set becomes readable as soon as one of its fds is */
+    rc = hg_poll_add(poll_group->poll_set, fd, HG_POLLIN,
+        hg_core_poll_group_cb, hg_core_poll_group_entry);
+    HG_CHECK_ERROR(rc != HG_UTIL_SUCCESS, error, ret, HG_NOENTRY,
+        "Could not add context poll fd to poll group");
+
+    /* Group may block on the context fd, completions must signal it */
+    hg_atomic_set32(&private_context->fd_exposed, HG_TRUE);
+
+    hg_thread_spin_lock(&poll_group->entry_list_lock);
+    HG_LIST_INSERT_HEAD(&poll_group->entry_list, hg_core_poll_group_entry,
+        entry);
+    hg_thread_spin_unlock(&poll_group->entry_list_lock);
+
+    private_context->poll_group_entry = hg_core_poll_group_entry;
+
+    return ret;
+
+error:
+    free(hg_core_poll_group_entry);
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+hg_return_t
+HG_Core_poll_group_remove(hg_core_poll_group_t *poll_group,
+    hg_core_context_t *context)
+{
+    struct hg_core_private_context *private_context =
+        (struct hg_core_private_context *) context;
+    struct hg_core_poll_group_entry *hg_core_poll_group_entry;
+    hg_return_t ret = HG_SUCCESS;
+    int rc;
+
+    HG_CHECK_ERROR(poll_group == NULL, done, ret, HG_INVALID_ARG,
+        "NULL poll group");
+    HG_CHECK_ERROR(context == NULL, done, ret, HG_INVALID_ARG,
+        "NULL HG core context");
+
+    hg_core_poll_group_entry = private_context->poll_group_entry;
+    HG_CHECK_ERROR(hg_core_poll_group_entry == NULL
+        || hg_core_poll_group_entry->poll_group != poll_group, done, ret,
+        HG_NOENTRY, "Context is not part of that poll group");
+
+    rc = hg_poll_remove(poll_group->poll_set,
+        hg_poll_get_fd(private_context->poll_set));
+    HG_CHECK_ERROR(rc != HG_UTIL_SUCCESS, done, ret, HG_NOENTRY,
+        "Could not remove context poll fd from poll group");
+
+    /* Entry may still be referenced by events that concurrent progress calls
+     * have not dispatched yet, defer its release */
+    hg_thread_spin_lock(&poll_group->entry_list_lock);
+    HG_LIST_REMOVE(hg_core_poll_group_entry, entry);
+    HG_LIST_INSERT_HEAD(&poll_group->removed_list, hg_core_poll_group_entry,
+        entry);
+    hg_thread_spin_unlock(&poll_group->entry_list_lock);
+
+    /* Wait for callbacks that are already progressing the context */
+    hg_atomic_set32(&hg_core_poll_group_entry->removed, HG_TRUE);
+    hg_atomic_fence();
+    while (hg_atomic_get32(&hg_core_poll_group_entry->busy))
+        cpu_spinwait();
+
+    private_context->poll_group_entry = NULL;
+
+    if (hg_atomic_get32(&poll_group->progress_count) == 0)
+        hg_core_poll_group_release(poll_group);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+hg_return_t
+HG_Core_poll_group_progress(hg_core_poll_group_t *poll_group,
+    unsigned int timeout, hg_core_context_t **contexts, unsigned int max_count,
+    unsigned int *actual_count)
+{
+    double remaining = timeout / 1000.0; /* Convert timeout in ms into seconds */
+    unsigned int count = 0;
+    hg_return_t ret = HG_TIMEOUT;
+
+    HG_CHECK_ERROR(poll_group == NULL, done, ret, HG_INVALID_ARG,
+        "NULL poll group");
+    HG_CHECK_ERROR(contexts == NULL || max_count == 0, done, ret,
+        HG_INVALID_ARG, "NULL contexts array");
+
+    hg_atomic_incr32(&poll_group->progress_count);
+
+    do {
+        struct hg_core_poll_group_entry *hg_core_poll_group_entry;
+        hg_time_ticks_t t1, t2;
+        hg_util_bool_t progressed;
+        int rc;
+
+        if (timeout)
+            t1 = hg_time_get_ticks();
+
+        /* Will call hg_core_poll_group_try_wait_cb if timeout is not 0 */
+        rc = hg_poll_wait(poll_group->poll_set,
+            (unsigned int)(remaining * 1000.0), &progressed);
+        HG_CHECK_ERROR(rc != HG_UTIL_SUCCESS, release, ret, HG_PROTOCOL_ERROR,
+            "hg_poll_wait() failed");
+
+        /* Report contexts that progressed or that have completions pending,
+         * completions may also have been added outside of this call */
+        hg_thread_spin_lock(&poll_group->entry_list_lock);
+        HG_LIST_FOREACH(hg_core_poll_group_entry, &poll_group->entry_list,
+            entry) {
+            struct hg_core_private_context *context =
+                hg_core_poll_group_entry->context;
+
+            if (count == max_count)
+                break;
+
+            if (hg_atomic_cas32(&hg_core_poll_group_entry->ready, HG_TRUE,
+                HG_FALSE)
+                || !hg_atomic_queue_chain_is_empty(context->completion_queue))
+                contexts[count++] = &context->core_context;
+        }
+        hg_thread_spin_unlock(&poll_group->entry_list_lock);
+
+        if (count) {
+            ret = HG_SUCCESS;
+            break;
+        }
+
+        if (timeout) {
+            t2 = hg_time_get_ticks();
+            remaining -= hg_time_ticks_to_double(t2 - t1);
+        }
+    } while ((int)(remaining * 1000.0) > 0);
+
+    if (actual_count)
+        *actual_count = count;
+
+release:
+    /* Last progress call releases entries removed in the meantime */
+    if (hg_atomic_decr32(&poll_group->progress_count) == 0)
+        hg_core_poll_group_release(poll_group);
+
+done:
+    return ret;
+}
+
 /*---------------------------------------------------------------------------*/
 hg_return_t
 HG_Core_cancel(hg_core_handle_t handle)
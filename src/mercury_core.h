@@ -25,6 +25,7 @@ typedef struct hg_core_context hg_core_context_t; /* Opaque HG core context */
 typedef struct hg_core_addr *hg_core_addr_t;      /* Abstract HG address */
 typedef struct hg_core_handle *hg_core_handle_t;  /* Abstract RPC handle */
 typedef struct hg_core_op_id *hg_core_op_id_t;    /* Abstract operation id */
+typedef struct hg_core_poll_group hg_core_poll_group_t; /* Opaque poll group */
 
 /* HG info struct */
 struct hg_core_info {
@@ -405,6 +406,46 @@ HG_Core_context_get_data(
         const hg_core_context_t *context
         );
 
+/**
+ * Retrieve a file descriptor associated to the context, so that progress on the
+ * context can be driven from an external event loop (select, poll, epoll, etc).
+ * The descriptor becomes readable when progress on the underlying NA plugin is
+ * needed or when completions are queued to the context, including from another
+ * thread. The descriptor is level-triggered and remains readable until
+ * HG_Core_progress() has been called; when it is registered in edge-triggered
+ * mode, HG_Core_progress() with a timeout of 0 and HG_Core_trigger() must be
+ * called until progress returns HG_TIMEOUT. Since some plugins may have pending
+ * work that does not make the descriptor readable, HG_Core_context_try_wait()
+ * must be called before blocking on it. A typical loop consists of: blocking on
+ * the descriptor if HG_Core_context_try_wait() returns HG_TRUE, then calling
+ * HG_Core_progress() with a timeout of 0 followed by HG_Core_trigger() until no
+ * callback is triggered. The descriptor must not be read from or closed by the
+ * caller.
+ *
+ * \param context [IN]          pointer to HG core context
+ *
+ * \return Non-negative integer if supported or negative if the plugin does not
+ * expose any descriptor, if NA_NO_BLOCK was requested or in case of error
+ */
+HG_PUBLIC int
+HG_Core_context_get_fd(
+        hg_core_context_t *context
+        );
+
+/**
+ * Used to signal when it is safe to block on the descriptor returned by
+ * HG_Core_context_get_fd() or if blocking could hang the application (e.g.,
+ * completions are already queued).
+ *
+ * \param context [IN]          pointer to HG core context
+ *
+ * \return HG_TRUE if it is safe to block or HG_FALSE otherwise
+ */
+HG_PUBLIC hg_bool_t
+HG_Core_context_try_wait(
+        hg_core_context_t *context
+        );
+
 /**
  * Set callback to be called on HG core handle creation. Handles are created
  * both on HG_Core_create() and HG_Core_context_post() calls. This allows
@@ -895,13 +936,20 @@ HG_Core_get_output(
  * After completion, the handle must be freed using HG_Core_destroy(), the user
  * callback is placed into a completion queue and can be triggered using
  * HG_Core_trigger().
+ * HG_AGAIN is returned when the NA plugin is temporarily out of resources,
+ * in which case nothing was sent, no callback is placed into the completion
+ * queue and the forward can be retried with the same handle. When NA direct
+ * completion is enabled (na_direct_completion in hg_init_info), the retry
+ * itself returns HG_AGAIN until the cancelation of the response receive that
+ * was pre-posted by the failed forward has been processed, which is done by
+ * calling HG_Core_trigger() on the handle's context.
  *
  * \param handle [IN]           HG handle
  * \param callback [IN]         pointer to function callback
  * \param arg [IN]              pointer to data passed to callback
  * \param payload_size [IN]     size of payload to send
  *
- * \return HG_SUCCESS or corresponding HG error code
+ * \return HG_SUCCESS, HG_AGAIN or corresponding HG error code
  */
 HG_PUBLIC hg_return_t
 HG_Core_forward(
@@ -972,6 +1020,89 @@ HG_Core_trigger(
         unsigned int *actual_count
         );
 
+/**
+ * Create a new poll group. A poll group allows a single thread to block on
+ * multiple contexts at once, progress being made only on the contexts that
+ * are ready. Must be destroyed by calling HG_Core_poll_group_destroy().
+ *
+ * \return Pointer to poll group or NULL in case of failure
+ */
+HG_PUBLIC hg_core_poll_group_t *
+HG_Core_poll_group_create(void);
+
+/**
+ * Destroy a poll group created by HG_Core_poll_group_create(). All contexts
+ * must have been removed from the poll group and no thread may be
+ * progressing it before it can be destroyed.
+ *
+ * \param poll_group [IN]       pointer to poll group
+ *
+ * \return HG_SUCCESS or corresponding HG error code
+ */
+HG_PUBLIC hg_return_t
+HG_Core_poll_group_destroy(
+        hg_core_poll_group_t *poll_group
+        );
+
+/**
+ * Add context to poll group. A context can only be part of one poll group at
+ * a time and must be removed from it before being destroyed. Contexts that
+ * are part of a poll group can still be progressed individually through
+ * HG_Core_progress().
+ *
+ * \param poll_group [IN]       pointer to poll group
+ * \param context [IN]          pointer to HG core context
+ *
+ * \return HG_SUCCESS or corresponding HG error code
+ */
+HG_PUBLIC hg_return_t
+HG_Core_poll_group_add(
+        hg_core_poll_group_t *poll_group,
+        hg_core_context_t *context
+        );
+
+/**
+ * Remove context from poll group. This may be called while another thread is
+ * in HG_Core_poll_group_progress(), the context is no longer progressed by the
+ * poll group once this call returns and can then be destroyed. Must not be
+ * called from an HG callback.
+ *
+ * \param poll_group [IN]       pointer to poll group
+ * \param context [IN]          pointer to HG core context
+ *
+ * \return HG_SUCCESS or corresponding HG error code
+ */
+HG_PUBLIC hg_return_t
+HG_Core_poll_group_remove(
+        hg_core_poll_group_t *poll_group,
+        hg_core_context_t *context
+        );
+
+/**
+ * Try to progress all the contexts of a poll group for at most timeout until
+ * timeout is reached or any completion has occurred on one of them. Contexts
+ * that have completions ready to be triggered are returned in the contexts
+ * array (at most max_count), HG_Core_trigger() should then be called on each
+ * of them. Contexts that could not be reported because max_count was reached
+ * are reported on the next call.
+ *
+ * \param poll_group [IN]       pointer to poll group
+ * \param timeout [IN]          timeout (in milliseconds)
+ * \param contexts [OUT]        array of ready contexts
+ * \param max_count [IN]        maximum number of contexts returned
+ * \param actual_count [OUT]    actual number of contexts returned
+ *
+ * \return HG_SUCCESS if any completion has occurred / HG error code otherwise
+ */
+HG_PUBLIC hg_return_t
+HG_Core_poll_group_progress(
+        hg_core_poll_group_t *poll_group,
+        unsigned int timeout,
+        hg_core_context_t **contexts,
+        unsigned int max_count,
+        unsigned int *actual_count
+        );
+
 /**
  * Cancel an ongoing operation.
  *
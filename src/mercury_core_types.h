@@ -27,6 +27,12 @@ struct hg_init_info {
     na_class_t *na_class;               /* NA class */
     hg_bool_t auto_sm;                  /* Use NA SM plugin with local addrs */
     hg_bool_t stats;                    /* (Debug) Print stats at exit */
+    hg_uint32_t completion_queue_size;  /* Initial context completion queue
+                                         * size (0 for default) */
+    hg_bool_t na_direct_completion;     /* Let NA complete directly into the
+                                         * context completion queue */
+    hg_bool_t na_loan_recv;             /* Decode RPC input in place from
+                                         * buffers loaned by NA, if supported */
 };
 
 /* Error return codes:
@@ -12,7 +12,9 @@
 #define MERCURY_PRIVATE_H
 
 #include "mercury_core.h"
+#include "mercury_types.h"
 
+#include "mercury_mem_pool.h"
 #include "mercury_queue.h"
 
 /*************************************/
@@ -33,8 +35,29 @@ struct hg_completion_entry {
         hg_core_handle_t hg_core_handle;
         struct hg_bulk_op_id *hg_bulk_op_id;
     } op_id;
-    HG_QUEUE_ENTRY(hg_completion_entry) entry;
     hg_op_type_t op_type;
 };
 
+/*********************/
+/* Public Prototypes */
+/*********************/
+
+/**
+ * Create pool of bulk operation IDs, one pool is attached to each HG class.
+ *
+ * \return Pointer to pool or NULL on failure
+ */
+HG_PRIVATE hg_mem_pool_t *
+hg_bulk_op_pool_create(void);
+
+/**
+ * Get pool of bulk operation IDs attached to HG class.
+ *
+ * \param hg_class [IN]         pointer to HG class
+ *
+ * \return Pointer to pool
+ */
+HG_PRIVATE hg_mem_pool_t *
+hg_bulk_op_pool_get(hg_class_t *hg_class);
+
 #endif /* MERCURY_PRIVATE_H */
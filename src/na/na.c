@@ -12,6 +12,9 @@
 
 #include "mercury_time.h"
 #include "mercury_mem.h"
+#include "mercury_mem_pool.h"
+#include "mercury_list.h"
+#include "mercury_thread.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -28,18 +31,74 @@
 #  define strdup _strdup
 #endif
 
-#define NA_ATOMIC_QUEUE_SIZE 1024   /* TODO make it configurable */
+#define NA_COMPLETION_QUEUE_SIZE 1024 /* Default completion queue size */
+#define NA_TRIGGER_BATCH_SIZE 64       /* Max entries popped at once */
 
 #define NA_PROGRESS_LOCK 0x80000000 /* 32-bit lock value for serial progress */
 
+/* Plugin data of buffers allocated by NA when the plugin does not */
+#define NA_BUF_ALIGNED ((void *) 1) /* From hg_mem_aligned_alloc() */
+#define NA_BUF_POOL ((void *) 2)    /* From msg_buf_pool */
+
+#define NA_OP_MAG_SIZE 16           /* Op IDs cached per thread */
+#define NA_OP_QUEUE_SIZE 256        /* Op IDs cached per class */
+
+/* Stats are 64-bit so that byte counts do not wrap, OPA only provides 64-bit
+ * load and CAS (pointer-sized, i.e., 32-bit on 32-bit platforms) */
+#ifdef NA_HAS_COLLECT_STATS
+typedef hg_atomic_int64_t na_stat_t;
+typedef hg_util_int64_t na_stat_value_t;
+#define na_stat_get hg_atomic_get64
+#define na_stat_cas hg_atomic_cas64
+#ifndef HG_UTIL_HAS_OPA_PRIMITIVES_H
+#define na_stat_incr hg_atomic_incr64
+#else
+#define na_stat_incr(stat) na_stat_add(stat, 1)
+#endif
+#endif
+
 /************************************/
 /* Local Type and Struct Definition */
 /************************************/
 
+/* Per-thread cache of reset op IDs */
+struct na_op_mag {
+    struct na_private_class *na_private_class;  /* Owning class */
+    hg_thread_t thread;                         /* Owning thread */
+    unsigned int count;                         /* Number of cached op IDs */
+    HG_LIST_ENTRY(na_op_mag) entry;             /* Entry in global list */
+    na_op_id_t op_ids[NA_OP_MAG_SIZE];          /* Cached op IDs */
+};
+
 struct na_private_class {
     struct na_class na_class;                   /* Must remain as first field */
+    unsigned int completion_queue_size;         /* Completion queue size */
+    hg_mem_pool_t *msg_buf_pool;                /* Huge page msg buffers */
+    na_size_t msg_buf_size;                     /* Size of pool buffers */
+    struct hg_atomic_queue *op_id_queue;        /* Op IDs shared by threads */
+    hg_thread_key_t op_mag_key;                 /* Op ID cache of thread */
 };
 
+#ifdef NA_HAS_COLLECT_STATS
+/* Context stats, see struct na_stats */
+struct na_private_stats {
+    na_stat_t posted[NA_STATS_OP_MAX];
+    na_stat_t completed[NA_STATS_OP_MAX];
+    na_stat_t canceled[NA_STATS_OP_MAX];
+    na_stat_t errors[NA_STATS_OP_MAX];
+    na_stat_t latency[NA_STATS_OP_MAX][NA_STATS_HIST_BUCKETS];
+    na_stat_t cancel_count;
+    na_stat_t bytes_sent;
+    na_stat_t bytes_received;
+    na_stat_t again_count;
+    na_stat_t cq_full_count;
+    na_stat_t unexpected_queued;
+    na_stat_t unexpected_depth_max;
+    na_stat_t completion_depth;
+    na_stat_t completion_depth_max;
+};
+#endif
+
 /* Private context / do not expose private members to plugins */
 struct na_private_context {
     struct na_context context;                  /* Must remain as first field */
@@ -51,14 +110,17 @@ struct na_private_context {
 #ifdef NA_HAS_MULTI_PROGRESS
     hg_thread_mutex_t progress_mutex;           /* Progress mutex */
 #endif
-    HG_QUEUE_HEAD(na_cb_completion_data) backfill_queue; /* Backfill completion queue */
-    struct hg_atomic_queue *completion_queue;   /* Default completion queue */
+    struct hg_atomic_queue_chain *completion_queue; /* Completion queue */
+    na_cb_completion_push_t completion_push;    /* External completion queue */
+    void *completion_push_arg;                  /* Arg of completion_push */
     na_class_t *na_class;                       /* Pointer to NA class */
-    hg_atomic_int32_t backfill_queue_count;     /* Number of entries in backfill queue */
     hg_atomic_int32_t trigger_waiting;          /* Polling/waiting in trigger */
 #ifdef NA_HAS_MULTI_PROGRESS
     hg_atomic_int32_t progressing;              /* Progressing count */
 #endif
+#ifdef NA_HAS_COLLECT_STATS
+    struct na_private_stats stats;              /* Context stats */
+#endif
 };
 
 /********************/
@@ -78,6 +140,68 @@ na_info_free(
     struct na_info *na_info
     );
 
+/* Create op ID caches if plugin can reset op IDs */
+static na_return_t
+na_op_cache_init(
+    struct na_private_class *na_private_class
+    );
+
+/* Destroy cached op IDs */
+static void
+na_op_cache_finalize(
+    struct na_private_class *na_private_class
+    );
+
+/* Get op ID cache of calling thread */
+static struct na_op_mag *
+na_op_mag_get(
+    struct na_private_class *na_private_class
+    );
+
+/* Move op IDs cached by an exiting thread to the class */
+static void
+na_op_mag_release(
+    void *arg
+    );
+
+#ifdef NA_HAS_MULTI_PROGRESS
+/* Acquire progress lock of context within remaining time */
+static na_return_t
+na_progress_lock(
+    struct na_private_context *na_private_context,
+    double *remaining
+    );
+
+/* Release progress lock of context and wake up next waiter */
+static void
+na_progress_unlock(
+    struct na_private_context *na_private_context
+    );
+#endif
+
+#ifdef NA_HAS_COLLECT_STATS
+/* Add value to stat and return new value */
+static NA_INLINE na_stat_value_t
+na_stat_add(
+    na_stat_t *stat,
+    na_stat_value_t value
+    );
+
+/* Raise stat to value if value is larger */
+static NA_INLINE void
+na_stat_max(
+    na_stat_t *stat,
+    na_stat_value_t value
+    );
+
+/* Count completion of operation */
+static void
+na_stats_complete(
+    struct na_private_stats *stats,
+    struct na_cb_completion_data *na_cb_completion_data
+    );
+#endif
+
 /*******************/
 /* Local Variables */
 /*******************/
@@ -98,10 +222,22 @@ static const struct na_class_ops *const na_class_table[] = {
 #endif
 #ifdef NA_HAS_CCI
     &NA_PLUGIN_OPS(cci),
+#endif
+#ifdef NA_HAS_INPROC
+    &NA_PLUGIN_OPS(inproc),
+#endif
+#ifdef NA_HAS_EMU
+    &NA_PLUGIN_OPS(emu), /* Keep last, only selected by "emu+" prefix */
 #endif
     NULL
 };
 
+/* Per-thread op ID caches of all classes, the mutex outlives the classes so
+ * that thread destructors racing with na_op_cache_finalize() can use it */
+static HG_LIST_HEAD(na_op_mag) na_op_mags_g = HG_LIST_HEAD_INITIALIZER(
+    na_op_mags_g);
+static hg_thread_mutex_t na_op_mags_mutex_g = HG_THREAD_MUTEX_INITIALIZER;
+
 /* Return code string table */
 #define X(a) #a,
 static const char *const na_return_name[] = { NA_RETURN_VALUES };
@@ -205,6 +341,287 @@ na_info_free(struct na_info *na_info)
     free(na_info);
 }
 
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_op_cache_init(struct na_private_class *na_private_class)
+{
+    na_return_t ret = NA_SUCCESS;
+    int rc;
+
+    if (!na_private_class->na_class.ops->op_reset)
+        goto done;
+
+    rc = hg_thread_key_create(&na_private_class->op_mag_key,
+        na_op_mag_release);
+    NA_CHECK_ERROR(rc != HG_UTIL_SUCCESS, done, ret, NA_NOMEM,
+        "Could not create op ID cache key");
+
+    na_private_class->op_id_queue = hg_atomic_queue_alloc(NA_OP_QUEUE_SIZE);
+    NA_CHECK_ERROR(na_private_class->op_id_queue == NULL, error, ret,
+        NA_NOMEM, "Could not allocate op ID queue");
+
+done:
+    return ret;
+
+error:
+    hg_thread_key_delete(na_private_class->op_mag_key);
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+na_op_cache_finalize(struct na_private_class *na_private_class)
+{
+    na_class_t *na_class = &na_private_class->na_class;
+    struct na_op_mag *mag;
+    na_op_id_t op_id;
+
+    if (!na_private_class->op_id_queue)
+        return;
+
+    /* Exiting threads no longer release their cache. A release already in
+     * progress either completes first, as it holds the mutex, or no longer
+     * finds its cache registered and leaves it alone */
+    hg_thread_mutex_lock(&na_op_mags_mutex_g);
+    hg_thread_key_delete(na_private_class->op_mag_key);
+
+    mag = HG_LIST_FIRST(&na_op_mags_g);
+    while (mag) {
+        struct na_op_mag *next = HG_LIST_NEXT(mag, entry);
+
+        if (mag->na_private_class == na_private_class) {
+            while (mag->count > 0)
+                na_class->ops->op_destroy(na_class, mag->op_ids[--mag->count]);
+            HG_LIST_REMOVE(mag, entry);
+            free(mag);
+        }
+        mag = next;
+    }
+    hg_thread_mutex_unlock(&na_op_mags_mutex_g);
+
+    while ((op_id = hg_atomic_queue_pop_mc(na_private_class->op_id_queue))
+        != NA_OP_ID_NULL)
+        na_class->ops->op_destroy(na_class, op_id);
+    hg_atomic_queue_free(na_private_class->op_id_queue);
+}
+
+/*---------------------------------------------------------------------------*/
+static struct na_op_mag *
+na_op_mag_get(struct na_private_class *na_private_class)
+{
+    struct na_op_mag *mag;
+
+    mag = (struct na_op_mag *) hg_thread_getspecific(
+        na_private_class->op_mag_key);
+    if (mag)
+        return mag;
+
+    mag = (struct na_op_mag *) malloc(sizeof(struct na_op_mag));
+    if (!mag)
+        return NULL;
+    mag->na_private_class = na_private_class;
+    mag->thread = hg_thread_self();
+    mag->count = 0;
+    if (hg_thread_setspecific(na_private_class->op_mag_key, mag)
+        != HG_UTIL_SUCCESS) {
+        free(mag);
+        return NULL;
+    }
+
+    hg_thread_mutex_lock(&na_op_mags_mutex_g);
+    HG_LIST_INSERT_HEAD(&na_op_mags_g, mag, entry);
+    hg_thread_mutex_unlock(&na_op_mags_mutex_g);
+
+    return mag;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+na_op_mag_release(void *arg)
+{
+    struct na_op_mag *mag;
+
+    /* Serialize with na_op_cache_finalize(), which frees the caches of its
+     * class. Only dereference arg once it is known to be still registered,
+     * the owner check protects against its memory having been reused. */
+    hg_thread_mutex_lock(&na_op_mags_mutex_g);
+    HG_LIST_FOREACH(mag, &na_op_mags_g, entry)
+        if (mag == arg && hg_thread_equal(mag->thread, hg_thread_self()))
+            break;
+    if (mag) {
+        struct na_private_class *na_private_class = mag->na_private_class;
+        na_class_t *na_class = &na_private_class->na_class;
+
+        while (mag->count > 0) {
+            na_op_id_t op_id = mag->op_ids[--mag->count];
+
+            if (hg_atomic_queue_push(na_private_class->op_id_queue, op_id)
+                != HG_UTIL_SUCCESS)
+                na_class->ops->op_destroy(na_class, op_id);
+        }
+        HG_LIST_REMOVE(mag, entry);
+    }
+    hg_thread_mutex_unlock(&na_op_mags_mutex_g);
+    free(mag);
+}
+
+#ifdef NA_HAS_COLLECT_STATS
+/*---------------------------------------------------------------------------*/
+static NA_INLINE na_stat_value_t
+na_stat_add(na_stat_t *stat, na_stat_value_t value)
+{
+    na_stat_value_t old;
+
+    do {
+        old = na_stat_get(stat);
+    } while (!na_stat_cas(stat, old, old + value));
+
+    return old + value;
+}
+
+/*---------------------------------------------------------------------------*/
+static NA_INLINE void
+na_stat_max(na_stat_t *stat, na_stat_value_t value)
+{
+    na_stat_value_t old;
+
+    do {
+        old = na_stat_get(stat);
+    } while (value > old && !na_stat_cas(stat, old, value));
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+na_stats_complete(struct na_private_stats *stats,
+    struct na_cb_completion_data *na_cb_completion_data)
+{
+    const struct na_cb_info *callback_info =
+        &na_cb_completion_data->callback_info;
+    na_cb_type_t type = callback_info->type;
+
+    if ((unsigned int) type >= NA_STATS_OP_MAX)
+        return;
+
+    if (callback_info->ret == NA_CANCELED)
+        na_stat_incr(&stats->canceled[type]);
+    else if (callback_info->ret != NA_SUCCESS)
+        na_stat_incr(&stats->errors[type]);
+    else {
+        na_stat_incr(&stats->completed[type]);
+
+        switch (type) {
+            case NA_CB_SEND_UNEXPECTED:
+            case NA_CB_SEND_EXPECTED:
+            case NA_CB_PUT:
+                na_stat_add(&stats->bytes_sent,
+                    (na_stat_value_t) na_cb_completion_data->stats_size);
+                break;
+            case NA_CB_RECV_UNEXPECTED:
+                na_stat_add(&stats->bytes_received, (na_stat_value_t)
+                    callback_info->info.recv_unexpected.actual_buf_size);
+                break;
+            case NA_CB_GET:
+                na_stat_add(&stats->bytes_received,
+                    (na_stat_value_t) na_cb_completion_data->stats_size);
+                break;
+            case NA_CB_RECV_EXPECTED:  /* Actual size is not reported */
+            case NA_CB_LOOKUP:
+            default:
+                break;
+        }
+    }
+
+    /* Operations that were not posted through na_stats_post() have no
+     * latency (e.g., plugin internal operations) */
+    if (na_cb_completion_data->stats_ticks) {
+        hg_util_uint64_t us = hg_time_ticks_to_ns(hg_time_get_ticks()
+            - na_cb_completion_data->stats_ticks) / 1000;
+        unsigned int bucket = 0;
+
+        while (us && bucket < NA_STATS_HIST_BUCKETS - 1) {
+            us >>= 1;
+            bucket++;
+        }
+        na_stat_incr(&stats->latency[type][bucket]);
+        na_cb_completion_data->stats_ticks = 0;
+    }
+}
+#endif
+
+#ifdef NA_HAS_MULTI_PROGRESS
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_progress_lock(struct na_private_context *na_private_context,
+    double *remaining)
+{
+    hg_util_int32_t old, num;
+
+    hg_atomic_incr32(&na_private_context->progressing);
+    for (;;) {
+        hg_time_ticks_t t1, t2;
+
+        old = hg_atomic_get32(&na_private_context->progressing)
+            & (hg_util_int32_t) ~NA_PROGRESS_LOCK;
+        num = old | (hg_util_int32_t) NA_PROGRESS_LOCK;
+        if (hg_atomic_cas32(&na_private_context->progressing, old, num))
+            break; /* No other thread is progressing */
+
+        /* Timeout is 0 so leave */
+        if (*remaining <= 0) {
+            hg_atomic_decr32(&na_private_context->progressing);
+            return NA_TIMEOUT;
+        }
+
+        t1 = hg_time_get_ticks();
+
+        /* Prevent multiple threads from concurrently calling progress on
+         * the same context */
+        hg_thread_mutex_lock(&na_private_context->progress_mutex);
+
+        num = hg_atomic_get32(&na_private_context->progressing);
+        /* Do not need to enter condition if lock is already released */
+        if (((num & (hg_util_int32_t) NA_PROGRESS_LOCK) != 0)
+            && (hg_thread_cond_timedwait(&na_private_context->progress_cond,
+                &na_private_context->progress_mutex,
+                (unsigned int) (*remaining * 1000.0)) != HG_UTIL_SUCCESS)) {
+            /* Timeout occurred so leave */
+            hg_atomic_decr32(&na_private_context->progressing);
+            hg_thread_mutex_unlock(&na_private_context->progress_mutex);
+            return NA_TIMEOUT;
+        }
+
+        hg_thread_mutex_unlock(&na_private_context->progress_mutex);
+
+        t2 = hg_time_get_ticks();
+        *remaining -= hg_time_ticks_to_double(t2 - t1);
+        /* Give a chance to call progress with timeout of 0 */
+        if (*remaining < 0)
+            *remaining = 0;
+    }
+
+    return NA_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+na_progress_unlock(struct na_private_context *na_private_context)
+{
+    hg_util_int32_t old, num;
+
+    do {
+        old = hg_atomic_get32(&na_private_context->progressing);
+        num = (old - 1) ^ (hg_util_int32_t) NA_PROGRESS_LOCK;
+    } while (!hg_atomic_cas32(&na_private_context->progressing, old, num));
+
+    if (num > 0) {
+        /* If there is another processes entered in progress, signal it */
+        hg_thread_mutex_lock(&na_private_context->progress_mutex);
+        hg_thread_cond_signal(&na_private_context->progress_cond);
+        hg_thread_mutex_unlock(&na_private_context->progress_mutex);
+    }
+}
+#endif
+
 /*---------------------------------------------------------------------------*/
 na_class_t *
 NA_Initialize(const char *info_string, na_bool_t listen)
@@ -238,6 +655,9 @@ NA_Initialize_opt(const char *info_string, na_bool_t listen,
         NA_LOG_MASK |= HG_LOG_TYPE_DEBUG;
 #endif
 
+    /* Select tick source now rather than on first use in a progress loop */
+    hg_time_ticks_init();
+
     na_private_class = (struct na_private_class *) malloc(
         sizeof(struct na_private_class));
     NA_CHECK_ERROR(na_private_class == NULL, error, ret, NA_NOMEM,
@@ -248,8 +668,13 @@ NA_Initialize_opt(const char *info_string, na_bool_t listen,
     NA_CHECK_NA_ERROR(error, ret, "Could not parse host string");
 
     na_info->na_init_info = na_init_info;
-    if (na_init_info)
+    if (na_init_info) {
         na_private_class->na_class.progress_mode = na_init_info->progress_mode;
+        na_private_class->completion_queue_size =
+            na_init_info->completion_queue_size;
+    }
+    if (!na_private_class->completion_queue_size)
+        na_private_class->completion_queue_size = NA_COMPLETION_QUEUE_SIZE;
 
     /* Print debug info */
     NA_LOG_DEBUG("Class: %s, Protocol: %s, Hostname: %s" , na_info->class_name,
@@ -317,6 +742,35 @@ NA_Initialize_opt(const char *info_string, na_bool_t listen,
 
     na_private_class->na_class.listen = listen;
 
+    ret = na_op_cache_init(na_private_class);
+    NA_CHECK_NA_ERROR(error, ret, "Could not create op ID cache");
+
+    /* Carve default message buffers out of huge pages, plugins that
+     * allocate their own buffers (e.g., to register them) are not affected */
+    if (na_init_info && na_init_info->huge_pages
+        && !na_private_class->na_class.ops->msg_buf_alloc) {
+        na_class_t *na_class = &na_private_class->na_class;
+        struct hg_mem_stats mem_stats;
+
+        na_private_class->msg_buf_size = NA_Msg_get_max_unexpected_size(
+            na_class);
+        if (NA_Msg_get_max_expected_size(na_class)
+            > na_private_class->msg_buf_size)
+            na_private_class->msg_buf_size = NA_Msg_get_max_expected_size(
+                na_class);
+        na_private_class->msg_buf_pool = hg_mem_pool_create(
+            na_private_class->msg_buf_size, 0, HG_MEM_POOL_HUGE_PAGE);
+        if (!na_private_class->msg_buf_pool)
+            NA_LOG_WARNING("Could not create message buffer pool, using "
+                "regular pages");
+
+        hg_mem_get_stats(&mem_stats);
+        NA_LOG_DEBUG("Huge pages: %llu bytes hugetlb, %llu bytes THP, "
+            "%llu bytes regular", (unsigned long long) mem_stats.hugetlb_bytes,
+            (unsigned long long) mem_stats.thp_bytes,
+            (unsigned long long) mem_stats.regular_bytes);
+    }
+
     na_info_free(na_info);
 
     return (na_class_t *) na_private_class;
@@ -346,8 +800,13 @@ NA_Finalize(na_class_t *na_class)
     NA_CHECK_ERROR(na_class->ops->finalize == NULL, done, ret,
         NA_OPNOTSUPPORTED, "finalize plugin callback is not defined");
 
+    /* Cached op IDs belong to the plugin */
+    na_op_cache_finalize(na_private_class);
+
     ret = na_class->ops->finalize(&na_private_class->na_class);
 
+    if (na_private_class->msg_buf_pool)
+        hg_mem_pool_destroy(na_private_class->msg_buf_pool);
     free(na_private_class->na_class.protocol_name);
     free(na_private_class);
 
@@ -393,6 +852,11 @@ NA_Context_create_id(na_class_t *na_class, na_uint8_t id)
     NA_CHECK_ERROR(na_private_context == NULL, error, ret, NA_NOMEM,
         "Could not allocate context");
     na_private_context->na_class = na_class;
+    na_private_context->completion_push = NULL;
+    na_private_context->completion_push_arg = NULL;
+#ifdef NA_HAS_COLLECT_STATS
+    memset(&na_private_context->stats, 0, sizeof(struct na_private_stats));
+#endif
 
     NA_CHECK_ERROR(na_class->ops == NULL, error, ret, NA_INVALID_ARG,
         "NULL NA class ops");
@@ -403,12 +867,10 @@ NA_Context_create_id(na_class_t *na_class, na_uint8_t id)
     }
 
     /* Initialize completion queue */
-    na_private_context->completion_queue =
-        hg_atomic_queue_alloc(NA_ATOMIC_QUEUE_SIZE);
+    na_private_context->completion_queue = hg_atomic_queue_chain_alloc(
+        ((struct na_private_class *) na_class)->completion_queue_size);
     NA_CHECK_ERROR(na_private_context->completion_queue == NULL, error, ret,
         NA_NOMEM, "Could not allocate queue");
-    HG_QUEUE_INIT(&na_private_context->backfill_queue);
-    hg_atomic_init32(&na_private_context->backfill_queue_count, 0);
 
     /* Initialize completion queue mutex/cond */
     hg_thread_mutex_init(&na_private_context->completion_queue_mutex);
@@ -444,17 +906,11 @@ NA_Context_destroy(na_class_t *na_class, na_context_t *context)
         goto done;
 
     /* Check that completion queue is empty now */
-    empty = hg_atomic_queue_is_empty(na_private_context->completion_queue);
-    NA_CHECK_ERROR(empty == NA_FALSE, done, ret, NA_BUSY,
-        "Completion queue should be empty");
-    hg_atomic_queue_free(na_private_context->completion_queue);
-
-    /* Check that backfill completion queue is empty now */
-    hg_thread_mutex_lock(&na_private_context->completion_queue_mutex);
-    empty = HG_QUEUE_IS_EMPTY(&na_private_context->backfill_queue);
-    hg_thread_mutex_unlock(&na_private_context->completion_queue_mutex);
+    empty = hg_atomic_queue_chain_is_empty(
+        na_private_context->completion_queue);
     NA_CHECK_ERROR(empty == NA_FALSE, done, ret, NA_BUSY,
         "Completion queue should be empty");
+    hg_atomic_queue_chain_free(na_private_context->completion_queue);
 
     /* Destroy completion queue mutex/cond */
     hg_thread_mutex_destroy(&na_private_context->completion_queue_mutex);
@@ -481,10 +937,34 @@ done:
     return ret;
 }
 
+/*---------------------------------------------------------------------------*/
+na_return_t
+NA_Context_set_completion_push(na_context_t *context,
+    na_cb_completion_push_t push, void *arg)
+{
+    struct na_private_context *na_private_context =
+        (struct na_private_context *) context;
+    na_return_t ret = NA_SUCCESS;
+
+    NA_CHECK_ERROR(context == NULL, done, ret, NA_INVALID_ARG,
+        "NULL context");
+    NA_CHECK_ERROR(!hg_atomic_queue_chain_is_empty(
+        na_private_context->completion_queue), done, ret, NA_BUSY,
+        "Completion queue should be empty");
+
+    na_private_context->completion_push = push;
+    na_private_context->completion_push_arg = arg;
+
+done:
+    return ret;
+}
+
 /*---------------------------------------------------------------------------*/
 na_op_id_t
 NA_Op_create(na_class_t *na_class)
 {
+    struct na_private_class *na_private_class =
+        (struct na_private_class *) na_class;
     na_op_id_t ret = NA_OP_ID_NULL;
 
     NA_CHECK_ERROR_NORET(na_class == NULL, done, "NULL NA class");
@@ -492,6 +972,18 @@ NA_Op_create(na_class_t *na_class)
     NA_CHECK_ERROR_NORET(na_class->ops->op_create == NULL, done,
         "op_create plugin callback is not defined");
 
+    /* Reuse op ID previously reset */
+    if (na_private_class->op_id_queue) {
+        struct na_op_mag *mag = na_op_mag_get(na_private_class);
+
+        if (mag && mag->count > 0)
+            return mag->op_ids[--mag->count];
+        ret = (na_op_id_t) hg_atomic_queue_pop_mc(
+            na_private_class->op_id_queue);
+        if (ret != NA_OP_ID_NULL)
+            return ret;
+    }
+
     ret = na_class->ops->op_create(na_class);
 
 done:
@@ -502,6 +994,8 @@ done:
 na_return_t
 NA_Op_destroy(na_class_t *na_class, na_op_id_t op_id)
 {
+    struct na_private_class *na_private_class =
+        (struct na_private_class *) na_class;
     na_return_t ret = NA_SUCCESS;
 
     NA_CHECK_ERROR(na_class == NULL, done, ret, NA_INVALID_ARG,
@@ -516,6 +1010,28 @@ NA_Op_destroy(na_class_t *na_class, na_op_id_t op_id)
     NA_CHECK_ERROR(na_class->ops->op_destroy == NULL, done, ret,
         NA_OPNOTSUPPORTED, "op_destroy plugin callback is not defined");
 
+    /* Keep op ID for reuse once the plugin no longer references it */
+    if (na_private_class->op_id_queue) {
+        struct na_op_mag *mag;
+
+        ret = na_class->ops->op_reset(na_class, op_id);
+        if (ret == NA_BUSY) {
+            /* Still in use, released by plugin */
+            ret = NA_SUCCESS;
+            goto done;
+        }
+        NA_CHECK_NA_ERROR(done, ret, "Could not reset op ID");
+
+        mag = na_op_mag_get(na_private_class);
+        if (mag && mag->count < NA_OP_MAG_SIZE) {
+            mag->op_ids[mag->count++] = op_id;
+            goto done;
+        }
+        if (hg_atomic_queue_push(na_private_class->op_id_queue, op_id)
+            == HG_UTIL_SUCCESS)
+            goto done;
+    }
+
     ret = na_class->ops->op_destroy(na_class, op_id);
 
 done:
@@ -827,6 +1343,8 @@ done:
 void *
 NA_Msg_buf_alloc(na_class_t *na_class, na_size_t buf_size, void **plugin_data)
 {
+    struct na_private_class *na_private_class =
+        (struct na_private_class *) na_class;
     void *ret = NULL;
 
     NA_CHECK_ERROR_NORET(na_class == NULL, done, "NULL NA class");
@@ -837,14 +1355,21 @@ NA_Msg_buf_alloc(na_class_t *na_class, na_size_t buf_size, void **plugin_data)
     NA_CHECK_ERROR_NORET(na_class->ops == NULL, done, "NULL NA class ops");
     if (na_class->ops->msg_buf_alloc)
         ret = na_class->ops->msg_buf_alloc(na_class, buf_size, plugin_data);
-    else {
+    else if (na_private_class->msg_buf_pool
+        && buf_size <= na_private_class->msg_buf_size) {
+        ret = hg_mem_pool_alloc(na_private_class->msg_buf_pool);
+        NA_CHECK_ERROR_NORET(ret == NULL, done,
+            "Could not allocate %d bytes", (int) buf_size);
+        memset(ret, 0, buf_size);
+        *plugin_data = NA_BUF_POOL;
+    } else {
         na_size_t page_size = (na_size_t) hg_mem_get_page_size();
 
         ret = hg_mem_aligned_alloc(page_size, buf_size);
         NA_CHECK_ERROR_NORET(ret == NULL, done,
             "Could not allocate %d bytes", (int) buf_size);
         memset(ret, 0, buf_size);
-        *plugin_data = (void *)1; /* Sanity check on free */
+        *plugin_data = NA_BUF_ALIGNED;
     }
 
 done:
@@ -855,6 +1380,8 @@ done:
 na_return_t
 NA_Msg_buf_free(na_class_t *na_class, void *buf, void *plugin_data)
 {
+    struct na_private_class *na_private_class =
+        (struct na_private_class *) na_class;
     na_return_t ret = NA_SUCCESS;
 
     NA_CHECK_ERROR(na_class == NULL, done, ret, NA_INVALID_ARG,
@@ -866,8 +1393,10 @@ NA_Msg_buf_free(na_class_t *na_class, void *buf, void *plugin_data)
         "NULL NA class ops");
     if (na_class->ops->msg_buf_free)
         ret = na_class->ops->msg_buf_free(na_class, buf, plugin_data);
+    else if (plugin_data == NA_BUF_POOL)
+        hg_mem_pool_free(na_private_class->msg_buf_pool, buf);
     else {
-        NA_CHECK_ERROR(plugin_data != (void *)1, done, ret, NA_FAULT,
+        NA_CHECK_ERROR(plugin_data != NA_BUF_ALIGNED, done, ret, NA_FAULT,
             "Invalid plugin data value");
         hg_mem_aligned_free(buf);
     }
@@ -920,6 +1449,59 @@ done:
     return ret;
 }
 
+/*---------------------------------------------------------------------------*/
+void *
+NA_Mem_alloc(na_class_t *na_class, na_size_t buf_size, void **plugin_data)
+{
+    void *ret = NULL;
+
+    NA_CHECK_ERROR_NORET(na_class == NULL, done, "NULL NA class");
+    NA_CHECK_ERROR_NORET(buf_size == 0, done, "NULL buffer size");
+    NA_CHECK_ERROR_NORET(plugin_data == NULL, done,
+        "NULL pointer to plugin data");
+
+    NA_CHECK_ERROR_NORET(na_class->ops == NULL, done, "NULL NA class ops");
+    if (na_class->ops->mem_alloc)
+        ret = na_class->ops->mem_alloc(na_class, buf_size, plugin_data);
+    else {
+        na_size_t page_size = (na_size_t) hg_mem_get_page_size();
+
+        ret = hg_mem_aligned_alloc(page_size, buf_size);
+        NA_CHECK_ERROR_NORET(ret == NULL, done,
+            "Could not allocate %d bytes", (int) buf_size);
+        memset(ret, 0, buf_size);
+        *plugin_data = NA_BUF_ALIGNED;
+    }
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+na_return_t
+NA_Mem_free(na_class_t *na_class, void *buf, void *plugin_data)
+{
+    na_return_t ret = NA_SUCCESS;
+
+    NA_CHECK_ERROR(na_class == NULL, done, ret, NA_INVALID_ARG,
+        "NULL NA class");
+    NA_CHECK_ERROR(buf == NULL, done, ret, NA_INVALID_ARG,
+        "NULL buffer");
+
+    NA_CHECK_ERROR(na_class->ops == NULL, done, ret, NA_INVALID_ARG,
+        "NULL NA class ops");
+    if (na_class->ops->mem_free)
+        ret = na_class->ops->mem_free(na_class, buf, plugin_data);
+    else {
+        NA_CHECK_ERROR(plugin_data != NA_BUF_ALIGNED, done, ret, NA_FAULT,
+            "Invalid plugin data value");
+        hg_mem_aligned_free(buf);
+    }
+
+done:
+    return ret;
+}
+
 /*---------------------------------------------------------------------------*/
 na_return_t
 NA_Mem_handle_create(na_class_t *na_class, void *buf, na_size_t buf_size,
@@ -1138,6 +1720,98 @@ done:
     return ret;
 }
 
+/*---------------------------------------------------------------------------*/
+na_return_t
+NA_Submit(na_class_t *na_class, na_context_t *context,
+    const struct na_op_desc *op_descs, na_size_t count, na_size_t *posted)
+{
+    na_size_t i = 0;
+    na_return_t ret = NA_SUCCESS;
+
+    NA_CHECK_ERROR(na_class == NULL, done, ret, NA_INVALID_ARG,
+        "NULL NA class");
+    NA_CHECK_ERROR(context == NULL, done, ret, NA_INVALID_ARG,
+        "NULL context");
+    NA_CHECK_ERROR(op_descs == NULL && count > 0, done, ret, NA_INVALID_ARG,
+        "NULL operation descriptors");
+    NA_CHECK_ERROR(na_class->ops == NULL, done, ret, NA_INVALID_ARG,
+        "NULL NA class ops");
+
+    if (na_class->ops->submit) {
+        /* Plugin takes care of setting posted count */
+        return na_class->ops->submit(na_class, context, op_descs, count,
+            posted);
+    }
+
+    /* Generic fallback, post one operation at a time */
+    for (i = 0; i < count; i++) {
+        const struct na_op_desc *desc = &op_descs[i];
+
+        switch (desc->type) {
+            case NA_CB_SEND_UNEXPECTED:
+                ret = NA_Msg_send_unexpected(na_class, context,
+                    desc->callback, desc->arg, desc->info.msg.buf,
+                    desc->info.msg.buf_size, desc->info.msg.plugin_data,
+                    desc->info.msg.addr, desc->info.msg.id,
+                    desc->info.msg.tag, desc->op_id);
+                break;
+            case NA_CB_RECV_UNEXPECTED:
+                ret = NA_Msg_recv_unexpected(na_class, context,
+                    desc->callback, desc->arg, desc->info.msg.buf,
+                    desc->info.msg.buf_size, desc->info.msg.plugin_data,
+                    desc->op_id);
+                break;
+            case NA_CB_SEND_EXPECTED:
+                ret = NA_Msg_send_expected(na_class, context,
+                    desc->callback, desc->arg, desc->info.msg.buf,
+                    desc->info.msg.buf_size, desc->info.msg.plugin_data,
+                    desc->info.msg.addr, desc->info.msg.id,
+                    desc->info.msg.tag, desc->op_id);
+                break;
+            case NA_CB_RECV_EXPECTED:
+                ret = NA_Msg_recv_expected(na_class, context,
+                    desc->callback, desc->arg, desc->info.msg.buf,
+                    desc->info.msg.buf_size, desc->info.msg.plugin_data,
+                    desc->info.msg.addr, desc->info.msg.id,
+                    desc->info.msg.tag, desc->op_id);
+                break;
+            case NA_CB_PUT:
+                ret = NA_Put(na_class, context, desc->callback, desc->arg,
+                    desc->info.rma.local_mem_handle,
+                    desc->info.rma.local_offset,
+                    desc->info.rma.remote_mem_handle,
+                    desc->info.rma.remote_offset, desc->info.rma.length,
+                    desc->info.rma.remote_addr, desc->info.rma.remote_id,
+                    desc->op_id);
+                break;
+            case NA_CB_GET:
+                ret = NA_Get(na_class, context, desc->callback, desc->arg,
+                    desc->info.rma.local_mem_handle,
+                    desc->info.rma.local_offset,
+                    desc->info.rma.remote_mem_handle,
+                    desc->info.rma.remote_offset, desc->info.rma.length,
+                    desc->info.rma.remote_addr, desc->info.rma.remote_id,
+                    desc->op_id);
+                break;
+            default:
+                NA_GOTO_ERROR(done, ret, NA_INVALID_ARG,
+                    "Operation type %d not supported", desc->type);
+        }
+        if (ret != NA_SUCCESS) {
+            /* Silently return on NA_AGAIN so that callers can retry */
+            if (ret != NA_AGAIN)
+                NA_LOG_ERROR("Could not post operation %zu (%s)", (size_t) i,
+                    NA_Error_to_string(ret));
+            goto done;
+        }
+    }
+
+done:
+    if (posted)
+        *posted = i;
+    return ret;
+}
+
 /*---------------------------------------------------------------------------*/
 na_bool_t
 NA_Poll_try_wait(na_class_t *na_class, na_context_t *context)
@@ -1153,9 +1827,8 @@ NA_Poll_try_wait(na_class_t *na_class, na_context_t *context)
     if (na_class->progress_mode == NA_NO_BLOCK)
         return NA_FALSE;
 
-    /* Something is in one of the completion queues */
-    if (!hg_atomic_queue_is_empty(na_private_context->completion_queue) ||
-        hg_atomic_get32(&na_private_context->backfill_queue_count))
+    /* Something is in the completion queue */
+    if (!hg_atomic_queue_chain_is_empty(na_private_context->completion_queue))
         return NA_FALSE;
 
     /* Check plugin try wait */
@@ -1169,6 +1842,112 @@ error:
     return ret;
 }
 
+/*---------------------------------------------------------------------------*/
+na_return_t
+NA_Poll_register(na_class_t *na_class, na_context_t *context,
+    struct hg_poll_set *poll_set)
+{
+    na_return_t ret = NA_SUCCESS;
+
+    NA_CHECK_ERROR(na_class == NULL, done, ret, NA_INVALID_ARG,
+        "NULL NA class");
+    NA_CHECK_ERROR(context == NULL, done, ret, NA_INVALID_ARG,
+        "NULL context");
+    NA_CHECK_ERROR(poll_set == NULL, done, ret, NA_INVALID_ARG,
+        "NULL poll set");
+
+    NA_CHECK_ERROR(na_class->ops == NULL, done, ret, NA_INVALID_ARG,
+        "NULL NA class ops");
+
+    /* Not an error, upper layers can fall back to NA_Poll_get_fd() */
+    if (!na_class->ops->na_poll_register) {
+        ret = NA_OPNOTSUPPORTED;
+        goto done;
+    }
+
+    ret = na_class->ops->na_poll_register(na_class, context, poll_set);
+    NA_CHECK_NA_ERROR(done, ret, "Could not register poll set (%s)",
+        NA_Error_to_string(ret));
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+na_return_t
+NA_Poll_deregister(na_class_t *na_class, na_context_t *context,
+    struct hg_poll_set *poll_set)
+{
+    na_return_t ret = NA_SUCCESS;
+
+    NA_CHECK_ERROR(na_class == NULL, done, ret, NA_INVALID_ARG,
+        "NULL NA class");
+    NA_CHECK_ERROR(context == NULL, done, ret, NA_INVALID_ARG,
+        "NULL context");
+    NA_CHECK_ERROR(poll_set == NULL, done, ret, NA_INVALID_ARG,
+        "NULL poll set");
+
+    NA_CHECK_ERROR(na_class->ops == NULL, done, ret, NA_INVALID_ARG,
+        "NULL NA class ops");
+    NA_CHECK_ERROR(na_class->ops->na_poll_deregister == NULL, done, ret,
+        NA_OPNOTSUPPORTED, "poll_deregister plugin callback is not defined");
+
+    ret = na_class->ops->na_poll_deregister(na_class, context, poll_set);
+    NA_CHECK_NA_ERROR(done, ret, "Could not deregister poll set (%s)",
+        NA_Error_to_string(ret));
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+na_return_t
+NA_Progress_lock(na_class_t *na_class, na_context_t *context,
+    unsigned int timeout)
+{
+    struct na_private_context *na_private_context =
+        (struct na_private_context *) context;
+    na_return_t ret = NA_SUCCESS;
+#ifdef NA_HAS_MULTI_PROGRESS
+    double remaining = timeout / 1000.0; /* Convert timeout in ms into seconds */
+#else
+    (void) timeout;
+#endif
+
+    NA_CHECK_ERROR(na_class == NULL, done, ret, NA_INVALID_ARG,
+        "NULL NA class");
+    NA_CHECK_ERROR(na_private_context == NULL, done, ret, NA_INVALID_ARG,
+        "NULL context");
+
+#ifdef NA_HAS_MULTI_PROGRESS
+    ret = na_progress_lock(na_private_context, &remaining);
+#endif
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+na_return_t
+NA_Progress_unlock(na_class_t *na_class, na_context_t *context)
+{
+    struct na_private_context *na_private_context =
+        (struct na_private_context *) context;
+    na_return_t ret = NA_SUCCESS;
+
+    NA_CHECK_ERROR(na_class == NULL, done, ret, NA_INVALID_ARG,
+        "NULL NA class");
+    NA_CHECK_ERROR(na_private_context == NULL, done, ret, NA_INVALID_ARG,
+        "NULL context");
+
+#ifdef NA_HAS_MULTI_PROGRESS
+    na_progress_unlock(na_private_context);
+#endif
+
+done:
+    return ret;
+}
+
 /*---------------------------------------------------------------------------*/
 na_return_t
 NA_Progress(na_class_t *na_class, na_context_t *context, unsigned int timeout)
@@ -1177,10 +1956,7 @@ NA_Progress(na_class_t *na_class, na_context_t *context, unsigned int timeout)
         (struct na_private_class *) na_class;
     struct na_private_context *na_private_context =
         (struct na_private_context *) context;
-    double remaining ;
-#ifdef NA_HAS_MULTI_PROGRESS
-    hg_util_int32_t old, num;
-#endif
+    double remaining;
     na_return_t ret = NA_TIMEOUT;
 
     NA_CHECK_ERROR(na_class == NULL, done, ret, NA_INVALID_ARG,
@@ -1200,53 +1976,14 @@ NA_Progress(na_class_t *na_class, na_context_t *context, unsigned int timeout)
         remaining = timeout / 1000.0; /* Convert timeout in ms into seconds */
 
 #ifdef NA_HAS_MULTI_PROGRESS
-    hg_atomic_incr32(&na_private_context->progressing);
-    for (;;) {
-        hg_time_t t1, t2;
-
-        old = hg_atomic_get32(&na_private_context->progressing)
-            & (hg_util_int32_t) ~NA_PROGRESS_LOCK;
-        num = old | (hg_util_int32_t) NA_PROGRESS_LOCK;
-        if (hg_atomic_cas32(&na_private_context->progressing, old, num))
-            break; /* No other thread is progressing */
-
-        /* Timeout is 0 so leave */
-        if (remaining <= 0) {
-            hg_atomic_decr32(&na_private_context->progressing);
-            goto done;
-        }
-
-        hg_time_get_current(&t1);
-
-        /* Prevent multiple threads from concurrently calling progress on
-         * the same context */
-        hg_thread_mutex_lock(&na_private_context->progress_mutex);
-
-        num = hg_atomic_get32(&na_private_context->progressing);
-        /* Do not need to enter condition if lock is already released */
-        if (((num & (hg_util_int32_t) NA_PROGRESS_LOCK) != 0)
-            && (hg_thread_cond_timedwait(&na_private_context->progress_cond,
-                &na_private_context->progress_mutex,
-                (unsigned int) (remaining * 1000.0)) != HG_UTIL_SUCCESS)) {
-            /* Timeout occurred so leave */
-            hg_atomic_decr32(&na_private_context->progressing);
-            hg_thread_mutex_unlock(&na_private_context->progress_mutex);
-            goto done;
-        }
-
-        hg_thread_mutex_unlock(&na_private_context->progress_mutex);
-
-        hg_time_get_current(&t2);
-        remaining -= hg_time_to_double(hg_time_subtract(t2, t1));
-        /* Give a chance to call progress with timeout of 0 */
-        if (remaining < 0)
-            remaining = 0;
-    }
+    ret = na_progress_lock(na_private_context, &remaining);
+    if (ret != NA_SUCCESS)
+        goto done;
 #endif
 
-    /* Something is in one of the completion queues */
-    if (!hg_atomic_queue_is_empty(na_private_context->completion_queue)
-        || hg_atomic_get32(&na_private_context->backfill_queue_count)) {
+    /* Something is in the completion queue */
+    if (!hg_atomic_queue_chain_is_empty(
+        na_private_context->completion_queue)) {
         ret = NA_SUCCESS; /* Progressed */
 #ifdef NA_HAS_MULTI_PROGRESS
         goto unlock;
@@ -1261,17 +1998,7 @@ NA_Progress(na_class_t *na_class, na_context_t *context, unsigned int timeout)
 
 #ifdef NA_HAS_MULTI_PROGRESS
 unlock:
-    do {
-        old = hg_atomic_get32(&na_private_context->progressing);
-        num = (old - 1) ^ (hg_util_int32_t) NA_PROGRESS_LOCK;
-    } while (!hg_atomic_cas32(&na_private_context->progressing, old, num));
-
-    if (num > 0) {
-        /* If there is another processes entered in progress, signal it */
-        hg_thread_mutex_lock(&na_private_context->progress_mutex);
-        hg_thread_cond_signal(&na_private_context->progress_cond);
-        hg_thread_mutex_unlock(&na_private_context->progress_mutex);
-    }
+    na_progress_unlock(na_private_context);
 #endif
 
 done:
@@ -1302,91 +2029,65 @@ NA_Trigger(na_context_t *context, unsigned int timeout, unsigned int max_count,
         remaining = timeout / 1000.0; /* Convert timeout in ms into seconds */
 
     while (count < max_count) {
-        struct na_cb_completion_data *completion_data = NULL;
-
-        completion_data = hg_atomic_queue_pop_mc(
-            na_private_context->completion_queue);
-        if (!completion_data) {
-            /* Check backfill queue */
-            if (hg_atomic_get32(&na_private_context->backfill_queue_count)) {
-                hg_thread_mutex_lock(
-                    &na_private_context->completion_queue_mutex);
-                completion_data = HG_QUEUE_FIRST(
-                    &na_private_context->backfill_queue);
-                HG_QUEUE_POP_HEAD(&na_private_context->backfill_queue,
-                    entry);
-                hg_atomic_decr32(&na_private_context->backfill_queue_count);
-                hg_thread_mutex_unlock(
-                    &na_private_context->completion_queue_mutex);
-                if (!completion_data)
-                    continue; /* Give another chance to grab it */
-            } else {
-                hg_time_t t1, t2;
-
-                /* If something was already processed leave */
-                if (count)
-                    break;
+        struct na_cb_completion_data *completion_data[NA_TRIGGER_BATCH_SIZE];
+        unsigned int batch_count, i;
+
+        /* Claim a batch of entries at once */
+        batch_count = hg_atomic_queue_chain_pop_mc_n(
+            na_private_context->completion_queue, (void **) completion_data,
+            MIN(max_count - count, NA_TRIGGER_BATCH_SIZE));
+        if (!batch_count) {
+            hg_time_ticks_t t1, t2;
+
+            /* If something was already processed leave */
+            if (count)
+                break;
+
+            /* Timeout is 0 so leave */
+            if ((int)(remaining * 1000.0) <= 0) {
+                ret = NA_TIMEOUT;
+                break;
+            }
 
-                /* Timeout is 0 so leave */
-                if ((int)(remaining * 1000.0) <= 0) {
+            t1 = hg_time_get_ticks();
+
+            hg_atomic_incr32(&na_private_context->trigger_waiting);
+            hg_thread_mutex_lock(&na_private_context->completion_queue_mutex);
+            /* Otherwise wait timeout ms */
+            while (hg_atomic_queue_chain_is_empty(
+                na_private_context->completion_queue)) {
+                if (hg_thread_cond_timedwait(
+                    &na_private_context->completion_queue_cond,
+                    &na_private_context->completion_queue_mutex,
+                    timeout) != HG_UTIL_SUCCESS) {
+                    /* Timeout occurred so leave */
                     ret = NA_TIMEOUT;
                     break;
                 }
-
-                hg_time_get_current(&t1);
-
-                hg_atomic_incr32(&na_private_context->trigger_waiting);
-                hg_thread_mutex_lock(
-                    &na_private_context->completion_queue_mutex);
-                /* Otherwise wait timeout ms */
-                while (hg_atomic_queue_is_empty(
-                    na_private_context->completion_queue)
-                    && !hg_atomic_get32(
-                        &na_private_context->backfill_queue_count)) {
-                    if (hg_thread_cond_timedwait(
-                        &na_private_context->completion_queue_cond,
-                        &na_private_context->completion_queue_mutex,
-                        timeout) != HG_UTIL_SUCCESS) {
-                        /* Timeout occurred so leave */
-                        ret = NA_TIMEOUT;
-                        break;
-                    }
-                }
-                hg_thread_mutex_unlock(
-                    &na_private_context->completion_queue_mutex);
-                hg_atomic_decr32(&na_private_context->trigger_waiting);
-                if (ret == NA_TIMEOUT)
-                    break;
-
-                hg_time_get_current(&t2);
-                remaining -= hg_time_to_double(hg_time_subtract(t2, t1));
-                continue; /* Give another chance to grab it */
             }
+            hg_thread_mutex_unlock(
+                &na_private_context->completion_queue_mutex);
+            hg_atomic_decr32(&na_private_context->trigger_waiting);
+            if (ret == NA_TIMEOUT)
+                break;
+
+            t2 = hg_time_get_ticks();
+            remaining -= hg_time_ticks_to_double(t2 - t1);
+            continue; /* Give another chance to grab it */
         }
 
-        /* Completion data should be valid */
-        NA_CHECK_ERROR(completion_data == NULL, done, ret, NA_INVALID_ARG,
-            "NULL completion data");
+#ifdef NA_HAS_COLLECT_STATS
+        na_stat_add(&na_private_context->stats.completion_depth,
+            -(na_stat_value_t) batch_count);
+#endif
+
+        for (i = 0; i < batch_count; i++) {
+            int cb_ret = NA_Trigger_entry(completion_data[i]);
 
-        /* Execute callback */
-        if (completion_data->callback) {
-            int cb_ret =
-                completion_data->callback(&completion_data->callback_info);
             if (callback_ret)
                 callback_ret[count] = cb_ret;
+            count++;
         }
-
-        /* Execute plugin callback (free resources etc)
-         * NB. If the NA operation ID is reused by the plugin for another
-         * operation we must be careful that resources are released BEFORE
-         * that operation ID gets re-used. This is currently not protected
-         * and left upon the plugin implementation.
-         */
-        if (completion_data->plugin_callback)
-            completion_data->plugin_callback(
-                completion_data->plugin_callback_args);
-
-        count++;
     }
 
     if (actual_count)
@@ -1396,6 +2097,31 @@ done:
     return ret;
 }
 
+/*---------------------------------------------------------------------------*/
+int
+NA_Trigger_entry(void *completion_entry)
+{
+    struct na_cb_completion_data *completion_data =
+        (struct na_cb_completion_data *) completion_entry;
+    int ret = 0;
+
+    /* Execute callback */
+    if (completion_data->callback)
+        ret = completion_data->callback(&completion_data->callback_info);
+
+    /* Execute plugin callback (free resources etc)
+     * NB. If the NA operation ID is reused by the plugin for another
+     * operation we must be careful that resources are released BEFORE
+     * that operation ID gets re-used. This is currently not protected
+     * and left upon the plugin implementation.
+     */
+    if (completion_data->plugin_callback)
+        completion_data->plugin_callback(
+            completion_data->plugin_callback_args);
+
+    return ret;
+}
+
 /*---------------------------------------------------------------------------*/
 na_return_t
 NA_Cancel(na_class_t *na_class, na_context_t *context, na_op_id_t op_id)
@@ -1414,12 +2140,71 @@ NA_Cancel(na_class_t *na_class, na_context_t *context, na_op_id_t op_id)
     NA_CHECK_ERROR(na_class->ops->cancel == NULL, done, ret, NA_OPNOTSUPPORTED,
         "cancel plugin callback is not defined");
 
+#ifdef NA_HAS_COLLECT_STATS
+    na_stat_incr(
+        &((struct na_private_context *) context)->stats.cancel_count);
+#endif
+
     ret = na_class->ops->cancel(na_class, context, op_id);
 
 done:
     return ret;
 }
 
+/*---------------------------------------------------------------------------*/
+na_return_t
+NA_Get_stats(na_context_t *context, struct na_stats *stats)
+{
+#ifdef NA_HAS_COLLECT_STATS
+    struct na_private_stats *private_stats;
+    unsigned int i, j;
+#endif
+    na_return_t ret = NA_SUCCESS;
+
+    NA_CHECK_ERROR(context == NULL, done, ret, NA_INVALID_ARG,
+        "NULL context");
+    NA_CHECK_ERROR(stats == NULL, done, ret, NA_INVALID_ARG,
+        "NULL stats");
+
+#ifdef NA_HAS_COLLECT_STATS
+    private_stats = &((struct na_private_context *) context)->stats;
+    for (i = 0; i < NA_STATS_OP_MAX; i++) {
+        stats->posted[i] = (na_uint64_t) na_stat_get(&private_stats->posted[i]);
+        stats->completed[i] =
+            (na_uint64_t) na_stat_get(&private_stats->completed[i]);
+        stats->canceled[i] =
+            (na_uint64_t) na_stat_get(&private_stats->canceled[i]);
+        stats->errors[i] = (na_uint64_t) na_stat_get(&private_stats->errors[i]);
+        for (j = 0; j < NA_STATS_HIST_BUCKETS; j++)
+            stats->latency[i][j] =
+                (na_uint64_t) na_stat_get(&private_stats->latency[i][j]);
+    }
+    stats->cancel_count = (na_uint64_t) na_stat_get(
+        &private_stats->cancel_count);
+    stats->bytes_sent = (na_uint64_t) na_stat_get(&private_stats->bytes_sent);
+    stats->bytes_received = (na_uint64_t) na_stat_get(
+        &private_stats->bytes_received);
+    stats->again_count = (na_uint64_t) na_stat_get(&private_stats->again_count);
+    stats->cq_full_count = (na_uint64_t) na_stat_get(
+        &private_stats->cq_full_count);
+    stats->unexpected_queued = (na_uint64_t) na_stat_get(
+        &private_stats->unexpected_queued);
+    stats->unexpected_depth_max = (na_uint64_t) na_stat_get(
+        &private_stats->unexpected_depth_max);
+    stats->completion_depth = (na_uint64_t) na_stat_get(
+        &private_stats->completion_depth);
+    stats->completion_depth_max = (na_uint64_t) na_stat_get(
+        &private_stats->completion_depth_max);
+#else
+    (void) stats;
+    NA_GOTO_ERROR(done, ret, NA_OPNOTSUPPORTED,
+        "Stats are not collected, rebuild with MERCURY_ENABLE_STATS");
+#endif
+
+done:
+    return ret;
+}
+
 /*---------------------------------------------------------------------------*/
 const char *
 NA_Error_to_string(na_return_t errnum)
@@ -1436,15 +2221,26 @@ na_cb_completion_add(na_context_t *context,
         (struct na_private_context *) context;
     na_return_t ret = NA_SUCCESS;
 
-    if (hg_atomic_queue_push(na_private_context->completion_queue,
-        na_cb_completion_data) != HG_UTIL_SUCCESS) {
-        /* Queue is full */
-        hg_thread_mutex_lock(&na_private_context->completion_queue_mutex);
-        HG_QUEUE_PUSH_TAIL(&na_private_context->backfill_queue,
-            na_cb_completion_data, entry);
-        hg_atomic_incr32(&na_private_context->backfill_queue_count);
-        hg_thread_mutex_unlock(&na_private_context->completion_queue_mutex);
-    }
+#ifdef NA_HAS_COLLECT_STATS
+    na_stats_complete(&na_private_context->stats, na_cb_completion_data);
+#endif
+
+    /* Complete directly into the upper layer completion queue */
+    if (na_private_context->completion_push)
+        return na_private_context->completion_push(
+            na_private_context->completion_push_arg, na_cb_completion_data);
+
+#ifdef NA_HAS_COLLECT_STATS
+    /* Count entry before it can be popped by NA_Trigger() */
+    na_stat_max(&na_private_context->stats.completion_depth_max,
+        na_stat_incr(&na_private_context->stats.completion_depth));
+#endif
+
+    /* Queue grows if full so this only fails when out of memory */
+    NA_CHECK_ERROR(hg_atomic_queue_chain_push(
+        na_private_context->completion_queue, na_cb_completion_data)
+        != HG_UTIL_SUCCESS, done, ret, NA_NOMEM,
+        "Could not push completion data to completion queue");
 
     if (hg_atomic_get32(&na_private_context->trigger_waiting)) {
         hg_thread_mutex_lock(&na_private_context->completion_queue_mutex);
@@ -1454,5 +2250,54 @@ na_cb_completion_add(na_context_t *context,
         hg_thread_mutex_unlock(&na_private_context->completion_queue_mutex);
     }
 
+done:
     return ret;
 }
+
+#ifdef NA_HAS_COLLECT_STATS
+/*---------------------------------------------------------------------------*/
+void
+na_stats_post(na_context_t *context,
+    struct na_cb_completion_data *na_cb_completion_data, na_cb_type_t type,
+    na_size_t size)
+{
+    struct na_private_stats *stats =
+        &((struct na_private_context *) context)->stats;
+
+    if ((unsigned int) type < NA_STATS_OP_MAX)
+        na_stat_incr(&stats->posted[type]);
+    na_cb_completion_data->stats_size = size;
+    na_cb_completion_data->stats_ticks = hg_time_get_ticks();
+}
+
+/*---------------------------------------------------------------------------*/
+void
+na_stats_event(na_context_t *context, na_stats_event_t event)
+{
+    struct na_private_stats *stats =
+        &((struct na_private_context *) context)->stats;
+
+    switch (event) {
+        case NA_STATS_AGAIN:
+            na_stat_incr(&stats->again_count);
+            break;
+        case NA_STATS_CQ_FULL:
+            na_stat_incr(&stats->cq_full_count);
+            break;
+        case NA_STATS_UNEXPECTED_QUEUED:
+            na_stat_incr(&stats->unexpected_queued);
+            break;
+        default:
+            break;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+void
+na_stats_unexpected_depth(na_context_t *context, na_size_t depth)
+{
+    na_stat_max(
+        &((struct na_private_context *) context)->stats.unexpected_depth_max,
+        (na_stat_value_t) depth);
+}
+#endif
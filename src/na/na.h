@@ -19,6 +19,8 @@
 
 /* See na_types.h */
 
+struct hg_poll_set; /* Poll set (see mercury_poll.h) */
+
 /*****************/
 /* Public Macros */
 /*****************/
@@ -169,6 +171,29 @@ NA_Context_destroy(
         na_context_t *context
         );
 
+/**
+ * Let an upper layer supply the completion queue of a context. Once set,
+ * completed operations are no longer added to the NA completion queue, the
+ * push callback is instead called with an opaque completion entry that must
+ * later be passed to NA_Trigger_entry() (NA_Trigger() will not return them).
+ * The push callback may be called concurrently from any thread that makes
+ * progress or posts operations and must not trigger the entry itself.
+ * Passing a NULL callback restores the NA completion queue. This can only be
+ * changed while no completion is pending on the context.
+ *
+ * \param context [IN/OUT]      pointer to context of execution
+ * \param push [IN]             pointer to push callback
+ * \param arg [IN]              pointer to data passed to push callback
+ *
+ * \return NA_SUCCESS or corresponding NA error code
+ */
+NA_PUBLIC na_return_t
+NA_Context_set_completion_push(
+        na_context_t            *context,
+        na_cb_completion_push_t  push,
+        void                    *arg
+        );
+
 /**
  * Allocate an operation ID for the higher level layer to save and
  * pass back to the NA layer rather than have the NA layer allocate operation
@@ -188,7 +213,9 @@ NA_Op_create(
 
 /**
  * Destroy operation ID created with NA_Op_create().
- * Reference counting prevents involuntary free.
+ * Reference counting prevents involuntary free. If the plugin supports it,
+ * the operation ID is reset and kept in a per-thread cache so that it can
+ * be returned by a later call to NA_Op_create().
  *
  * \param na_class [IN/OUT]     pointer to NA class
  * \param op_id [IN]            operation ID
@@ -590,6 +617,10 @@ NA_Msg_send_unexpected(
  * The plugin_data parameter returned from the NA_Msg_buf_alloc() call must
  * be passed along with the buffer, it allows plugins to store and retrieve
  * additional buffer information such as memory descriptors.
+ * If the plugin supports loaned buffers (see NA_Msg_loan_supported()), buf
+ * may be NULL, in which case no copy takes place and the callback info
+ * actual_buf field points to the received message, which must then be
+ * released with NA_Msg_loan_release().
  *
  * In the case where op_id is not NA_OP_ID_IGNORE and *op_id is NA_OP_ID_NULL,
  * a new operation ID will be internally created and returned. Users may also
@@ -690,6 +721,8 @@ NA_Msg_send_expected(
  * The plugin_data parameter returned from the NA_Msg_buf_alloc() call must
  * be passed along with the buffer, it allows plugins to store and retrieve
  * additional buffer information such as memory descriptors.
+ * As for NA_Msg_recv_unexpected(), buf may be NULL to receive a loaned
+ * buffer if the plugin supports it.
  *
  * In the case where op_id is not NA_OP_ID_IGNORE and *op_id is NA_OP_ID_NULL,
  * a new operation ID will be internally created and returned. Users may also
@@ -725,6 +758,79 @@ NA_Msg_recv_expected(
         na_op_id_t   *op_id
         );
 
+/**
+ * Indicate whether the plugin can loan its internal receive buffers, i.e.,
+ * whether NULL can be passed as the buffer of NA_Msg_recv_unexpected() and
+ * NA_Msg_recv_expected().
+ *
+ * \param na_class [IN]         pointer to NA class
+ *
+ * \return NA_TRUE if supported or NA_FALSE otherwise
+ */
+static NA_INLINE na_bool_t
+NA_Msg_loan_supported(
+        const na_class_t *na_class
+        );
+
+/**
+ * Release a buffer loaned to a receive callback. Until it is released, the
+ * buffer is not available to the sender, it should therefore be released
+ * as soon as its content has been consumed, and always before source_addr is
+ * freed.
+ *
+ * \param na_class [IN/OUT]     pointer to NA class
+ * \param buf [IN]              actual_buf returned in callback info
+ * \param buf_size [IN]         actual_buf_size returned in callback info
+ * \param source_addr [IN]      abstract address of message source
+ *
+ * \return NA_SUCCESS or corresponding NA error code
+ */
+static NA_INLINE na_return_t
+NA_Msg_loan_release(
+        na_class_t *na_class,
+        void       *buf,
+        na_size_t   buf_size,
+        na_addr_t   source_addr
+        );
+
+/**
+ * Allocate buf_size bytes of zeroed memory intended to be used for RMA
+ * operations. Plugins may return memory that remote peers can access more
+ * efficiently than regular memory once a memory handle is created on it,
+ * plain page-aligned memory is returned otherwise. The plugin_data output
+ * parameter can be used by the underlying plugin implementation to store
+ * internal memory information.
+ *
+ * \param na_class [IN/OUT]     pointer to NA class
+ * \param buf_size [IN]         buffer size
+ * \param plugin_data [OUT]     pointer to internal plugin data
+ *
+ * \return Pointer to allocated memory or NULL in case of failure
+ */
+NA_PUBLIC void *
+NA_Mem_alloc(
+        na_class_t *na_class,
+        na_size_t buf_size,
+        void **plugin_data
+        ) NA_WARN_UNUSED_RESULT;
+
+/**
+ * The NA_Mem_free() function releases the memory space pointed to by buf,
+ * which must have been returned by a previous call to NA_Mem_alloc().
+ *
+ * \param na_class [IN/OUT]     pointer to NA class
+ * \param buf [IN]              pointer to buffer
+ * \param plugin_data [IN]      pointer to internal plugin data
+ *
+ * \return NA_SUCCESS or corresponding NA error code
+ */
+NA_PUBLIC na_return_t
+NA_Mem_free(
+        na_class_t *na_class,
+        void *buf,
+        void *plugin_data
+        );
+
 /**
  * Create memory handle for RMA operations.
  * For non-contiguous memory, use NA_Mem_handle_create_segments() instead.
@@ -992,6 +1098,32 @@ NA_Get(
         na_op_id_t      *op_id
         );
 
+/**
+ * Post a batch of messages and RMA operations described by \op_descs.
+ * Operations are posted in order and behave as if each had been posted
+ * through the corresponding NA_Msg_*() or NA_Put()/NA_Get() call, the op_id
+ * field of each descriptor follows the same rules as the op_id parameter of
+ * these calls. Plugins may amortize notifications and submission costs
+ * across the batch. Posting stops at the first failure, operations posted
+ * before it complete normally.
+ *
+ * \param na_class [IN/OUT]     pointer to NA class
+ * \param context [IN/OUT]      pointer to context of execution
+ * \param op_descs [IN]         array of operation descriptors
+ * \param count [IN]            number of descriptors
+ * \param posted [OUT]          number of operations posted (may be NULL)
+ *
+ * \return NA_SUCCESS or error code of the first operation that failed
+ */
+NA_PUBLIC na_return_t
+NA_Submit(
+        na_class_t               *na_class,
+        na_context_t             *context,
+        const struct na_op_desc  *op_descs,
+        na_size_t                 count,
+        na_size_t                *posted
+        );
+
 /**
  * Retrieve file descriptor from NA plugin when supported. The descriptor
  * can be used by upper layers for manual polling through the usual
@@ -1024,6 +1156,84 @@ NA_Poll_try_wait(
         na_context_t    *context
         );
 
+/**
+ * Register the file descriptors used internally by the NA plugin directly
+ * into an existing poll set, when supported. Instead of exposing a single
+ * descriptor that must itself be polled through NA_Progress(), the plugin
+ * adds each of its descriptors along with its own progress callbacks to the
+ * poll set, so that a single hg_poll_wait() call on that poll set makes
+ * progress on the plugin. Completed operations must still be triggered through
+ * NA_Trigger(). Callbacks are dispatched from hg_poll_wait() directly, the
+ * caller is therefore responsible for serializing progress on the poll set,
+ * either by only waiting on it from a single thread or by holding
+ * NA_Progress_lock() while waiting on it.
+ *
+ * \param na_class [IN/OUT]     pointer to NA class
+ * \param context [IN/OUT]      pointer to context of execution
+ * \param poll_set [IN/OUT]     pointer to poll set
+ *
+ * \return NA_SUCCESS, NA_OPNOTSUPPORTED if the plugin does not support it or
+ * corresponding NA error code
+ */
+NA_PUBLIC na_return_t
+NA_Poll_register(
+        na_class_t          *na_class,
+        na_context_t        *context,
+        struct hg_poll_set  *poll_set
+        );
+
+/**
+ * Deregister file descriptors previously registered through
+ * NA_Poll_register().
+ *
+ * \param na_class [IN/OUT]     pointer to NA class
+ * \param context [IN/OUT]      pointer to context of execution
+ * \param poll_set [IN/OUT]     pointer to poll set
+ *
+ * \return NA_SUCCESS or corresponding NA error code
+ */
+NA_PUBLIC na_return_t
+NA_Poll_deregister(
+        na_class_t          *na_class,
+        na_context_t        *context,
+        struct hg_poll_set  *poll_set
+        );
+
+/**
+ * Acquire the lock that NA_Progress() uses to serialize progress on a context,
+ * waiting at most timeout ms for another thread to release it. This must be
+ * held while waiting on a poll set that the context was registered to with
+ * NA_Poll_register() if other threads may also make progress on that context.
+ * Locking is a no-op if NA was built without NA_HAS_MULTI_PROGRESS.
+ *
+ * \param na_class [IN/OUT]     pointer to NA class
+ * \param context [IN/OUT]      pointer to context of execution
+ * \param timeout [IN]          timeout (in milliseconds)
+ *
+ * \return NA_SUCCESS if lock was acquired, NA_TIMEOUT if timeout was reached
+ * or corresponding NA error code
+ */
+NA_PUBLIC na_return_t
+NA_Progress_lock(
+        na_class_t      *na_class,
+        na_context_t    *context,
+        unsigned int     timeout
+        );
+
+/**
+ * Release lock acquired with NA_Progress_lock().
+ *
+ * \param na_class [IN/OUT]     pointer to NA class
+ * \param context [IN/OUT]      pointer to context of execution
+ *
+ * \return NA_SUCCESS or corresponding NA error code
+ */
+NA_PUBLIC na_return_t
+NA_Progress_unlock(
+        na_class_t      *na_class,
+        na_context_t    *context
+        );
+
 /**
  * Try to progress communication for at most timeout until timeout reached or
  * any completion has occurred.
@@ -1044,6 +1254,20 @@ NA_Progress(
         unsigned int  timeout
         );
 
+/**
+ * Execute callback of a completion entry that was handed to a push callback
+ * (see NA_Context_set_completion_push()) and release plugin resources
+ * associated to it.
+ *
+ * \param completion_entry [IN] completion entry
+ *
+ * \return Return value of callback
+ */
+NA_PUBLIC int
+NA_Trigger_entry(
+        void *completion_entry
+        );
+
 /**
  * Execute at most max_count callbacks. If timeout is non-zero, wait up to
  * timeout before returning. Function can return when at least one or more
@@ -1082,6 +1306,22 @@ NA_Cancel(
         na_op_id_t    op_id
         );
 
+/**
+ * Retrieve a snapshot of the operation counters and latency histograms of
+ * the context. Counters are only collected when NA is built with
+ * MERCURY_ENABLE_STATS, NA_OPNOTSUPPORTED is returned otherwise.
+ *
+ * \param context [IN]          pointer to context of execution
+ * \param stats [OUT]           pointer to stats
+ *
+ * \return NA_SUCCESS or corresponding NA error code
+ */
+NA_PUBLIC na_return_t
+NA_Get_stats(
+        na_context_t    *context,
+        struct na_stats *stats
+        );
+
 /**
  * Convert error return code to string (null terminated).
  *
@@ -1163,6 +1403,11 @@ struct na_class_ops {
             na_op_id_t op_id
             );
     na_return_t
+    (*op_reset)(
+            na_class_t *na_class,
+            na_op_id_t op_id
+            );
+    na_return_t
     (*addr_lookup)(
             na_class_t   *na_class,
             na_context_t *context,
@@ -1433,6 +1678,18 @@ struct na_class_ops {
             na_context_t    *context
             );
     na_return_t
+    (*na_poll_register)(
+            na_class_t          *na_class,
+            na_context_t        *context,
+            struct hg_poll_set  *poll_set
+            );
+    na_return_t
+    (*na_poll_deregister)(
+            na_class_t          *na_class,
+            na_context_t        *context,
+            struct hg_poll_set  *poll_set
+            );
+    na_return_t
     (*progress)(
             na_class_t   *na_class,
             na_context_t *context,
@@ -1444,6 +1701,33 @@ struct na_class_ops {
             na_context_t *context,
             na_op_id_t    op_id
             );
+    na_return_t
+    (*submit)(
+            na_class_t               *na_class,
+            na_context_t             *context,
+            const struct na_op_desc  *op_descs,
+            na_size_t                 count,
+            na_size_t                *posted
+            );
+    na_return_t
+    (*msg_loan_release)(
+            na_class_t   *na_class,
+            void         *buf,
+            na_size_t     buf_size,
+            na_addr_t     source_addr
+            );
+    void *
+    (*mem_alloc)(
+            na_class_t   *na_class,
+            na_size_t     buf_size,
+            void        **plugin_data
+            );
+    na_return_t
+    (*mem_free)(
+            na_class_t   *na_class,
+            void         *buf,
+            void         *plugin_data
+            );
 };
 
 /*---------------------------------------------------------------------------*/
@@ -1561,6 +1845,23 @@ NA_Msg_recv_expected(na_class_t *na_class, na_context_t *context,
         arg, buf, buf_size, plugin_data, source_addr, source_id, tag, op_id);
 }
 
+/*---------------------------------------------------------------------------*/
+static NA_INLINE na_bool_t
+NA_Msg_loan_supported(const na_class_t *na_class)
+{
+    return (na_class->ops->msg_loan_release != NULL);
+}
+
+/*---------------------------------------------------------------------------*/
+static NA_INLINE na_return_t
+NA_Msg_loan_release(na_class_t *na_class, void *buf, na_size_t buf_size,
+    na_addr_t source_addr)
+{
+    return (na_class->ops->msg_loan_release) ?
+        na_class->ops->msg_loan_release(na_class, buf, buf_size, source_addr) :
+        NA_OPNOTSUPPORTED;
+}
+
 /*---------------------------------------------------------------------------*/
 static NA_INLINE na_size_t
 NA_Mem_handle_get_serialize_size(na_class_t *na_class,
@@ -527,6 +527,7 @@ const struct na_class_ops NA_PLUGIN_OPS(bmi) = {
         na_bmi_context_destroy,               /* context_destroy */
         na_bmi_op_create,                     /* op_create */
         na_bmi_op_destroy,                    /* op_destroy */
+        NULL,                                 /* op_reset */
         na_bmi_addr_lookup,                   /* addr_lookup */
         NULL,                                 /* addr_lookup2 */
         na_bmi_addr_free,                     /* addr_free */
@@ -566,8 +567,14 @@ const struct na_class_ops NA_PLUGIN_OPS(bmi) = {
         na_bmi_get,                           /* get */
         NULL,                                 /* poll_get_fd */
         NULL,                                 /* poll_try_wait */
+        NULL,                                 /* poll_register */
+        NULL,                                 /* poll_deregister */
         na_bmi_progress,                      /* progress */
-        na_bmi_cancel                         /* cancel */
+        na_bmi_cancel,                        /* cancel */
+        NULL,                                 /* submit */
+        NULL,                                 /* msg_loan_release */
+        NULL,                                 /* mem_alloc */
+        NULL                                  /* mem_free */
 };
 
 /********************/
@@ -912,6 +919,7 @@ na_bmi_addr_lookup(na_class_t *na_class, na_context_t *context,
     na_bmi_op_id->type = NA_CB_LOOKUP;
     na_bmi_op_id->callback = callback;
     na_bmi_op_id->arg = arg;
+    NA_STATS_POST(context, &na_bmi_op_id->completion_data, NA_CB_LOOKUP, 0);
     hg_atomic_set32(&na_bmi_op_id->completed, 0);
     na_bmi_op_id->cancel = 0;
 
@@ -1158,6 +1166,8 @@ na_bmi_msg_send_unexpected(na_class_t *na_class,
     na_bmi_op_id->type = NA_CB_SEND_UNEXPECTED;
     na_bmi_op_id->callback = callback;
     na_bmi_op_id->arg = arg;
+    NA_STATS_POST(context, &na_bmi_op_id->completion_data,
+        NA_CB_SEND_UNEXPECTED, buf_size);
     hg_atomic_set32(&na_bmi_op_id->completed, 0);
     na_bmi_op_id->info.send_unexpected.op_id = 0;
     na_bmi_op_id->cancel = 0;
@@ -1219,6 +1229,8 @@ na_bmi_msg_recv_unexpected(na_class_t *na_class, na_context_t *context,
     na_bmi_op_id->type = NA_CB_RECV_UNEXPECTED;
     na_bmi_op_id->callback = callback;
     na_bmi_op_id->arg = arg;
+    NA_STATS_POST(context, &na_bmi_op_id->completion_data,
+        NA_CB_RECV_UNEXPECTED, buf_size);
     hg_atomic_set32(&na_bmi_op_id->completed, 0);
     na_bmi_op_id->info.recv_unexpected.buf = buf;
     na_bmi_op_id->info.recv_unexpected.buf_size = (bmi_size_t) buf_size;
@@ -1377,6 +1389,8 @@ na_bmi_msg_send_expected(na_class_t *na_class, na_context_t *context,
     na_bmi_op_id->type = NA_CB_SEND_EXPECTED;
     na_bmi_op_id->callback = callback;
     na_bmi_op_id->arg = arg;
+    NA_STATS_POST(context, &na_bmi_op_id->completion_data,
+        NA_CB_SEND_EXPECTED, buf_size);
     hg_atomic_set32(&na_bmi_op_id->completed, 0);
     na_bmi_op_id->info.send_expected.op_id = 0;
     na_bmi_op_id->cancel = 0;
@@ -1442,6 +1456,8 @@ na_bmi_msg_recv_expected(na_class_t *na_class, na_context_t *context,
     na_bmi_op_id->type = NA_CB_RECV_EXPECTED;
     na_bmi_op_id->callback = callback;
     na_bmi_op_id->arg = arg;
+    NA_STATS_POST(context, &na_bmi_op_id->completion_data,
+        NA_CB_RECV_EXPECTED, buf_size);
     hg_atomic_set32(&na_bmi_op_id->completed, 0);
     na_bmi_op_id->info.recv_expected.op_id = 0;
     na_bmi_op_id->info.recv_expected.buf_size = bmi_buf_size;
@@ -1648,6 +1664,7 @@ na_bmi_put(na_class_t *na_class, na_context_t *context, na_cb_t callback,
     na_bmi_op_id->type = NA_CB_PUT;
     na_bmi_op_id->callback = callback;
     na_bmi_op_id->arg = arg;
+    NA_STATS_POST(context, &na_bmi_op_id->completion_data, NA_CB_PUT, length);
     hg_atomic_set32(&na_bmi_op_id->completed, 0);
     na_bmi_op_id->info.put.request_op_id = 0;
     na_bmi_op_id->info.put.transfer_op_id = 0;
@@ -1791,6 +1808,7 @@ na_bmi_get(na_class_t *na_class, na_context_t *context, na_cb_t callback,
     na_bmi_op_id->type = NA_CB_GET;
     na_bmi_op_id->callback = callback;
     na_bmi_op_id->arg = arg;
+    NA_STATS_POST(context, &na_bmi_op_id->completion_data, NA_CB_GET, length);
     hg_atomic_set32(&na_bmi_op_id->completed, 0);
     na_bmi_op_id->info.get.request_op_id = 0;
     na_bmi_op_id->info.get.transfer_op_id = 0;
@@ -378,6 +378,7 @@ const struct na_class_ops NA_PLUGIN_OPS(cci) = {
     NULL,                                   /* context_destroy */
     na_cci_op_create,                       /* op_create */
     na_cci_op_destroy,                      /* op_destroy */
+    NULL,                                   /* op_reset */
     na_cci_addr_lookup,                     /* addr_lookup */
     NULL,                                   /* addr_lookup2 */
     na_cci_addr_free,                       /* addr_free */
@@ -417,8 +418,14 @@ const struct na_class_ops NA_PLUGIN_OPS(cci) = {
     na_cci_get,                             /* get */
     na_cci_poll_get_fd,                     /* poll_get_fd */
     NULL,                                   /* poll_try_wait */
+    NULL,                                   /* poll_register */
+    NULL,                                   /* poll_deregister */
     na_cci_progress,                        /* progress */
-    na_cci_cancel                           /* cancel */
+    na_cci_cancel,                          /* cancel */
+    NULL,                                   /* submit */
+    NULL,                                   /* msg_loan_release */
+    NULL,                                   /* mem_alloc */
+    NULL                                    /* mem_free */
 };
 
 /********************/
@@ -812,6 +819,7 @@ na_cci_addr_lookup(na_class_t * na_class, na_context_t * context,
     na_cci_op_id->type = NA_CB_LOOKUP;
     na_cci_op_id->callback = callback;
     na_cci_op_id->arg = arg;
+    NA_STATS_POST(context, &na_cci_op_id->completion_data, NA_CB_LOOKUP, 0);
     hg_atomic_set32(&na_cci_op_id->completed, 0);
     hg_atomic_set32(&na_cci_op_id->canceled, 0);
 
@@ -1076,6 +1084,8 @@ na_cci_msg_send_unexpected(na_class_t *na_class, na_context_t * context,
     na_cci_op_id->type = NA_CB_SEND_UNEXPECTED;
     na_cci_op_id->callback = callback;
     na_cci_op_id->arg = arg;
+    NA_STATS_POST(context, &na_cci_op_id->completion_data,
+        NA_CB_SEND_UNEXPECTED, buf_size);
     hg_atomic_set32(&na_cci_op_id->completed, 0);
     hg_atomic_set32(&na_cci_op_id->canceled, 0);
     na_cci_op_id->info.send_unexpected.op_id = 0;
@@ -1136,6 +1146,8 @@ na_cci_msg_recv_unexpected(na_class_t * na_class, na_context_t * context,
     na_cci_op_id->type = NA_CB_RECV_UNEXPECTED;
     na_cci_op_id->callback = callback;
     na_cci_op_id->arg = arg;
+    NA_STATS_POST(context, &na_cci_op_id->completion_data,
+        NA_CB_RECV_UNEXPECTED, buf_size);
     hg_atomic_set32(&na_cci_op_id->completed, 0);
     hg_atomic_set32(&na_cci_op_id->canceled, 0);
     na_cci_op_id->info.recv_unexpected.buf = buf;
@@ -1300,6 +1312,8 @@ na_cci_msg_send_expected(na_class_t *na_class, na_context_t * context,
     na_cci_op_id->type = NA_CB_SEND_EXPECTED;
     na_cci_op_id->callback = callback;
     na_cci_op_id->arg = arg;
+    NA_STATS_POST(context, &na_cci_op_id->completion_data,
+        NA_CB_SEND_EXPECTED, buf_size);
     hg_atomic_set32(&na_cci_op_id->completed, 0);
     hg_atomic_set32(&na_cci_op_id->canceled, 0);
     na_cci_op_id->info.send_expected.op_id = 0;
@@ -1372,6 +1386,8 @@ na_cci_msg_recv_expected(na_class_t * na_class,
     na_cci_op_id->type = NA_CB_RECV_EXPECTED;
     na_cci_op_id->callback = callback;
     na_cci_op_id->arg = arg;
+    NA_STATS_POST(context, &na_cci_op_id->completion_data,
+        NA_CB_RECV_EXPECTED, buf_size);
     hg_atomic_set32(&na_cci_op_id->completed, 0);
     hg_atomic_set32(&na_cci_op_id->canceled, 0);
     na_cci_op_id->info.recv_expected.na_cci_addr = na_cci_addr;
@@ -1639,6 +1655,7 @@ na_cci_put(na_class_t * na_class, na_context_t * context, na_cb_t callback,
     na_cci_op_id->type = NA_CB_PUT;
     na_cci_op_id->callback = callback;
     na_cci_op_id->arg = arg;
+    NA_STATS_POST(context, &na_cci_op_id->completion_data, NA_CB_PUT, length);
     hg_atomic_set32(&na_cci_op_id->completed, 0);
     hg_atomic_set32(&na_cci_op_id->canceled, 0);
     na_cci_op_id->info.put.request_op_id = 0;
@@ -1716,6 +1733,7 @@ na_cci_get(na_class_t * na_class, na_context_t * context, na_cb_t callback,
     na_cci_op_id->type = NA_CB_GET;
     na_cci_op_id->callback = callback;
     na_cci_op_id->arg = arg;
+    NA_STATS_POST(context, &na_cci_op_id->completion_data, NA_CB_GET, length);
     hg_atomic_set32(&na_cci_op_id->completed, 0);
     hg_atomic_set32(&na_cci_op_id->canceled, 0);
     na_cci_op_id->info.get.request_op_id = 0;
@@ -0,0 +1,1648 @@
+/*
+ * Copyright (C) 2013-2019 Argonne National Laboratory, Department of Energy,
+ *                    UChicago Argonne, LLC and The HDF Group.
+ * All rights reserved.
+ *
+ * The full copyright notice, including terms governing use, modification,
+ * and redistribution, is contained in the COPYING file that can be
+ * found at the root of the source code distribution tree.
+ */
+
+#include "na_plugin.h"
+
+#include "mercury_list.h"
+#include "mercury_mem_pool.h"
+#include "mercury_thread_spin.h"
+#include "mercury_time.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+/****************/
+/* Local Macros */
+/****************/
+
+/* Environment variables used to configure the emulated link */
+#define NA_EMU_LATENCY_ENV      "HG_NA_EMU_LATENCY"     /* us */
+#define NA_EMU_JITTER_ENV       "HG_NA_EMU_JITTER"      /* us */
+#define NA_EMU_BANDWIDTH_ENV    "HG_NA_EMU_BANDWIDTH"   /* MB/s */
+#define NA_EMU_LOSS_ENV         "HG_NA_EMU_LOSS"        /* % */
+#define NA_EMU_SEED_ENV         "HG_NA_EMU_SEED"
+#define NA_EMU_POST_LIMIT_ENV   "HG_NA_EMU_POST_LIMIT"  /* ops */
+
+/* Max number of wrapped callbacks triggered at once */
+#define NA_EMU_TRIGGER_MAX      64
+
+/* Get emu class / context */
+#define NA_EMU_CLASS(na_class) \
+    ((struct na_emu_class *) (na_class->plugin_class))
+#define NA_EMU_CONTEXT(context) \
+    ((struct na_emu_context *) (context->plugin_context))
+
+/************************************/
+/* Local Type and Struct Definition */
+/************************************/
+
+/* Emulated link parameters */
+struct na_emu_params {
+    double latency;                 /* One-way latency (s) */
+    double jitter;                  /* Max random delay added (s) */
+    double bandwidth;               /* Bytes per second (0 if unlimited) */
+    double loss;                    /* Probability of loss */
+    unsigned int post_limit;        /* Ops posted before NA_AGAIN (0 if none) */
+};
+
+/* Op state */
+typedef enum {
+    NA_EMU_OP_POSTED,               /* Posted to wrapped class */
+    NA_EMU_OP_QUEUED,               /* Waiting for deadline */
+    NA_EMU_OP_ISSUING               /* Being posted to wrapped class */
+} na_emu_op_state_t;
+
+/* Msg info */
+struct na_emu_info_msg {
+    const void *buf;
+    na_size_t buf_size;
+    void *plugin_data;
+    na_addr_t addr;
+    na_uint8_t id;
+    na_tag_t tag;
+};
+
+/* RMA info */
+struct na_emu_info_rma {
+    na_mem_handle_t local_mem_handle;
+    na_offset_t local_offset;
+    na_mem_handle_t remote_mem_handle;
+    na_offset_t remote_offset;
+    na_size_t length;
+    na_addr_t remote_addr;
+    na_uint8_t remote_id;
+};
+
+/* Operation ID */
+struct na_emu_op_id {
+    na_class_t *na_class;
+    na_context_t *context;
+    struct na_cb_completion_data completion_data;
+    na_op_id_t op_id;               /* Wrapped op ID */
+    hg_time_t deadline;             /* Time at which op is issued */
+    union {
+        struct na_emu_info_msg msg;
+        struct na_emu_info_rma rma;
+    } info;
+    na_emu_op_state_t state;        /* Protected by context timer lock */
+    na_bool_t canceled;             /* Protected by context timer lock */
+    na_bool_t lost;                 /* Op is dropped when issued */
+    hg_atomic_int32_t completed;    /* Operation completed */
+    hg_atomic_int32_t ref_count;    /* Ref count */
+    HG_LIST_ENTRY(na_emu_op_id) entry;
+};
+
+/* Context */
+struct na_emu_context {
+    na_context_t *context;                      /* Wrapped context */
+    HG_LIST_HEAD(na_emu_op_id) timer_list;      /* Ops sorted by deadline */
+    hg_time_t last_deadline;                    /* Deadline of last post */
+    hg_thread_spin_t timer_lock;                /* Timer list lock */
+};
+
+/* Private data */
+struct na_emu_class {
+    na_class_t *na_class;           /* Wrapped class */
+    struct na_emu_params params;    /* Link parameters */
+    hg_time_t link_free;            /* Time at which link becomes idle */
+    unsigned int seed;              /* Random state */
+    hg_thread_spin_t link_lock;     /* Link state lock */
+    hg_mem_pool_t *op_id_pool;      /* Pool of op IDs */
+    hg_atomic_int32_t post_count;   /* Number of ops posted */
+};
+
+/********************/
+/* Local Prototypes */
+/********************/
+
+/* Read link parameter from environment */
+static double
+na_emu_getenv(const char *name);
+
+/* Random number in [0, 1) */
+static NA_INLINE double
+na_emu_rand(unsigned int *seed);
+
+/* Compute time at which op of given size must be issued */
+static void
+na_emu_schedule(struct na_emu_class *na_emu_class, na_size_t size,
+    hg_time_t *deadline, na_bool_t *lost);
+
+/* Check that a new operation can be posted */
+static NA_INLINE na_return_t
+na_emu_post_check(struct na_emu_class *na_emu_class);
+
+/* Get op ID for a new operation */
+static na_return_t
+na_emu_op_get(na_class_t *na_class, na_context_t *context,
+    na_cb_type_t cb_type, na_cb_t callback, void *arg, na_op_id_t *op_id,
+    struct na_emu_op_id **na_emu_op_id_ptr);
+
+/* Complete operation */
+static na_return_t
+na_emu_complete(struct na_emu_op_id *na_emu_op_id, na_return_t op_ret);
+
+/* Callback of wrapped operations */
+static int
+na_emu_complete_cb(const struct na_cb_info *callback_info);
+
+/* Queue op until its deadline or issue it immediately */
+static na_return_t
+na_emu_post(struct na_emu_op_id *na_emu_op_id, na_size_t size);
+
+/* Post op to wrapped class, op is requeued if NA_AGAIN is returned */
+static na_return_t
+na_emu_issue(struct na_emu_op_id *na_emu_op_id);
+
+/* Issue ops whose deadline has expired */
+static unsigned int
+na_emu_timer_fire(struct na_emu_context *na_emu_context, hg_time_t now,
+    hg_time_t *next, na_bool_t *has_next);
+
+/* Trigger wrapped callbacks, which complete emu ops */
+static unsigned int
+na_emu_trigger(struct na_emu_context *na_emu_context);
+
+/* Release op ID after completion */
+static NA_INLINE void
+na_emu_release(void *arg);
+
+/* check_protocol */
+static na_bool_t
+na_emu_check_protocol(const char *protocol_name);
+
+/* initialize */
+static na_return_t
+na_emu_initialize(na_class_t *na_class, const struct na_info *na_info,
+    na_bool_t listen);
+
+/* finalize */
+static na_return_t
+na_emu_finalize(na_class_t *na_class);
+
+/* context_create */
+static na_return_t
+na_emu_context_create(na_class_t *na_class, void **context, na_uint8_t id);
+
+/* context_destroy */
+static na_return_t
+na_emu_context_destroy(na_class_t *na_class, void *context);
+
+/* op_create */
+static na_op_id_t
+na_emu_op_create(na_class_t *na_class);
+
+/* op_destroy */
+static na_return_t
+na_emu_op_destroy(na_class_t *na_class, na_op_id_t op_id);
+
+/* op_reset */
+static na_return_t
+na_emu_op_reset(na_class_t *na_class, na_op_id_t op_id);
+
+/* addr_lookup */
+static na_return_t
+na_emu_addr_lookup(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, const char *name, na_op_id_t *op_id);
+
+/* addr_lookup2 */
+static na_return_t
+na_emu_addr_lookup2(na_class_t *na_class, const char *name, na_addr_t *addr);
+
+/* addr_free */
+static na_return_t
+na_emu_addr_free(na_class_t *na_class, na_addr_t addr);
+
+/* addr_set_remove */
+static na_return_t
+na_emu_addr_set_remove(na_class_t *na_class, na_addr_t addr);
+
+/* addr_self */
+static na_return_t
+na_emu_addr_self(na_class_t *na_class, na_addr_t *addr);
+
+/* addr_dup */
+static na_return_t
+na_emu_addr_dup(na_class_t *na_class, na_addr_t addr, na_addr_t *new_addr);
+
+/* addr_cmp */
+static na_bool_t
+na_emu_addr_cmp(na_class_t *na_class, na_addr_t addr1, na_addr_t addr2);
+
+/* addr_is_self */
+static NA_INLINE na_bool_t
+na_emu_addr_is_self(na_class_t *na_class, na_addr_t addr);
+
+/* addr_to_string */
+static na_return_t
+na_emu_addr_to_string(na_class_t *na_class, char *buf, na_size_t *buf_size,
+    na_addr_t addr);
+
+/* addr_get_serialize_size */
+static NA_INLINE na_size_t
+na_emu_addr_get_serialize_size(na_class_t *na_class, na_addr_t addr);
+
+/* addr_serialize */
+static na_return_t
+na_emu_addr_serialize(na_class_t *na_class, void *buf, na_size_t buf_size,
+    na_addr_t addr);
+
+/* addr_deserialize */
+static na_return_t
+na_emu_addr_deserialize(na_class_t *na_class, na_addr_t *addr,
+    const void *buf, na_size_t buf_size);
+
+/* msg_get_max_unexpected_size */
+static NA_INLINE na_size_t
+na_emu_msg_get_max_unexpected_size(const na_class_t *na_class);
+
+/* msg_get_max_expected_size */
+static NA_INLINE na_size_t
+na_emu_msg_get_max_expected_size(const na_class_t *na_class);
+
+/* msg_get_unexpected_header_size */
+static NA_INLINE na_size_t
+na_emu_msg_get_unexpected_header_size(const na_class_t *na_class);
+
+/* msg_get_expected_header_size */
+static NA_INLINE na_size_t
+na_emu_msg_get_expected_header_size(const na_class_t *na_class);
+
+/* msg_get_max_tag */
+static NA_INLINE na_tag_t
+na_emu_msg_get_max_tag(const na_class_t *na_class);
+
+/* msg_buf_alloc */
+static void *
+na_emu_msg_buf_alloc(na_class_t *na_class, na_size_t buf_size,
+    void **plugin_data);
+
+/* msg_buf_free */
+static na_return_t
+na_emu_msg_buf_free(na_class_t *na_class, void *buf, void *plugin_data);
+
+/* msg_init_unexpected */
+static na_return_t
+na_emu_msg_init_unexpected(na_class_t *na_class, void *buf,
+    na_size_t buf_size);
+
+/* msg_send_unexpected */
+static na_return_t
+na_emu_msg_send_unexpected(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, const void *buf, na_size_t buf_size,
+    void *plugin_data, na_addr_t dest_addr, na_uint8_t dest_id, na_tag_t tag,
+    na_op_id_t *op_id);
+
+/* msg_recv_unexpected */
+static na_return_t
+na_emu_msg_recv_unexpected(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, void *buf, na_size_t buf_size,
+    void *plugin_data, na_op_id_t *op_id);
+
+/* msg_init_expected */
+static na_return_t
+na_emu_msg_init_expected(na_class_t *na_class, void *buf,
+    na_size_t buf_size);
+
+/* msg_send_expected */
+static na_return_t
+na_emu_msg_send_expected(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, const void *buf, na_size_t buf_size,
+    void *plugin_data, na_addr_t dest_addr, na_uint8_t dest_id, na_tag_t tag,
+    na_op_id_t *op_id);
+
+/* msg_recv_expected */
+static na_return_t
+na_emu_msg_recv_expected(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, void *buf, na_size_t buf_size,
+    void *plugin_data, na_addr_t source_addr, na_uint8_t source_id,
+    na_tag_t tag, na_op_id_t *op_id);
+
+/* mem_handle_create */
+static na_return_t
+na_emu_mem_handle_create(na_class_t *na_class, void *buf, na_size_t buf_size,
+    unsigned long flags, na_mem_handle_t *mem_handle);
+
+/* mem_handle_create_segments */
+static na_return_t
+na_emu_mem_handle_create_segments(na_class_t *na_class,
+    struct na_segment *segments, na_size_t segment_count,
+    unsigned long flags, na_mem_handle_t *mem_handle);
+
+/* mem_handle_free */
+static na_return_t
+na_emu_mem_handle_free(na_class_t *na_class, na_mem_handle_t mem_handle);
+
+/* mem_register */
+static na_return_t
+na_emu_mem_register(na_class_t *na_class, na_mem_handle_t mem_handle);
+
+/* mem_deregister */
+static na_return_t
+na_emu_mem_deregister(na_class_t *na_class, na_mem_handle_t mem_handle);
+
+/* mem_publish */
+static na_return_t
+na_emu_mem_publish(na_class_t *na_class, na_mem_handle_t mem_handle);
+
+/* mem_unpublish */
+static na_return_t
+na_emu_mem_unpublish(na_class_t *na_class, na_mem_handle_t mem_handle);
+
+/* mem_handle_get_serialize_size */
+static NA_INLINE na_size_t
+na_emu_mem_handle_get_serialize_size(na_class_t *na_class,
+    na_mem_handle_t mem_handle);
+
+/* mem_handle_serialize */
+static na_return_t
+na_emu_mem_handle_serialize(na_class_t *na_class, void *buf,
+    na_size_t buf_size, na_mem_handle_t mem_handle);
+
+/* mem_handle_deserialize */
+static na_return_t
+na_emu_mem_handle_deserialize(na_class_t *na_class,
+    na_mem_handle_t *mem_handle, const void *buf, na_size_t buf_size);
+
+/* put */
+static na_return_t
+na_emu_put(na_class_t *na_class, na_context_t *context, na_cb_t callback,
+    void *arg, na_mem_handle_t local_mem_handle, na_offset_t local_offset,
+    na_mem_handle_t remote_mem_handle, na_offset_t remote_offset,
+    na_size_t length, na_addr_t remote_addr, na_uint8_t remote_id,
+    na_op_id_t *op_id);
+
+/* get */
+static na_return_t
+na_emu_get(na_class_t *na_class, na_context_t *context, na_cb_t callback,
+    void *arg, na_mem_handle_t local_mem_handle, na_offset_t local_offset,
+    na_mem_handle_t remote_mem_handle, na_offset_t remote_offset,
+    na_size_t length, na_addr_t remote_addr, na_uint8_t remote_id,
+    na_op_id_t *op_id);
+
+/* poll_get_fd */
+static NA_INLINE int
+na_emu_poll_get_fd(na_class_t *na_class, na_context_t *context);
+
+/* poll_try_wait */
+static NA_INLINE na_bool_t
+na_emu_poll_try_wait(na_class_t *na_class, na_context_t *context);
+
+/* progress */
+static na_return_t
+na_emu_progress(na_class_t *na_class, na_context_t *context,
+    unsigned int timeout);
+
+/* cancel */
+static na_return_t
+na_emu_cancel(na_class_t *na_class, na_context_t *context, na_op_id_t op_id);
+
+/*******************/
+/* Local Variables */
+/*******************/
+
+const struct na_class_ops NA_PLUGIN_OPS(emu) = {
+    "emu",                                  /* name */
+    na_emu_check_protocol,                  /* check_protocol */
+    na_emu_initialize,                      /* initialize */
+    na_emu_finalize,                        /* finalize */
+    NULL,                                   /* cleanup */
+    na_emu_context_create,                  /* context_create */
+    na_emu_context_destroy,                 /* context_destroy */
+    na_emu_op_create,                       /* op_create */
+    na_emu_op_destroy,                      /* op_destroy */
+    na_emu_op_reset,                        /* op_reset */
+    na_emu_addr_lookup,                     /* addr_lookup */
+    na_emu_addr_lookup2,                    /* addr_lookup2 */
+    na_emu_addr_free,                       /* addr_free */
+    na_emu_addr_set_remove,                 /* addr_set_remove */
+    na_emu_addr_self,                       /* addr_self */
+    na_emu_addr_dup,                        /* addr_dup */
+    na_emu_addr_cmp,                        /* addr_cmp */
+    na_emu_addr_is_self,                    /* addr_is_self */
+    na_emu_addr_to_string,                  /* addr_to_string */
+    na_emu_addr_get_serialize_size,         /* addr_get_serialize_size */
+    na_emu_addr_serialize,                  /* addr_serialize */
+    na_emu_addr_deserialize,                /* addr_deserialize */
+    na_emu_msg_get_max_unexpected_size,     /* msg_get_max_unexpected_size */
+    na_emu_msg_get_max_expected_size,       /* msg_get_max_expected_size */
+    na_emu_msg_get_unexpected_header_size,  /* msg_get_unexpected_header_size */
+    na_emu_msg_get_expected_header_size,    /* msg_get_expected_header_size */
+    na_emu_msg_get_max_tag,                 /* msg_get_max_tag */
+    na_emu_msg_buf_alloc,                   /* msg_buf_alloc */
+    na_emu_msg_buf_free,                    /* msg_buf_free */
+    na_emu_msg_init_unexpected,             /* msg_init_unexpected */
+    na_emu_msg_send_unexpected,             /* msg_send_unexpected */
+    na_emu_msg_recv_unexpected,             /* msg_recv_unexpected */
+    na_emu_msg_init_expected,               /* msg_init_expected */
+    na_emu_msg_send_expected,               /* msg_send_expected */
+    na_emu_msg_recv_expected,               /* msg_recv_expected */
+    na_emu_mem_handle_create,               /* mem_handle_create */
+    na_emu_mem_handle_create_segments,      /* mem_handle_create_segments */
+    na_emu_mem_handle_free,                 /* mem_handle_free */
+    na_emu_mem_register,                    /* mem_register */
+    na_emu_mem_deregister,                  /* mem_deregister */
+    na_emu_mem_publish,                     /* mem_publish */
+    na_emu_mem_unpublish,                   /* mem_unpublish */
+    na_emu_mem_handle_get_serialize_size,   /* mem_handle_get_serialize_size */
+    na_emu_mem_handle_serialize,            /* mem_handle_serialize */
+    na_emu_mem_handle_deserialize,          /* mem_handle_deserialize */
+    na_emu_put,                             /* put */
+    na_emu_get,                             /* get */
+    na_emu_poll_get_fd,                     /* poll_get_fd */
+    na_emu_poll_try_wait,                   /* poll_try_wait */
+    NULL,                                   /* poll_register */
+    NULL,                                   /* poll_deregister */
+    na_emu_progress,                        /* progress */
+    na_emu_cancel,                          /* cancel */
+    NULL,                                   /* submit */
+    NULL,                                   /* msg_loan_release */
+    NULL,                                   /* mem_alloc */
+    NULL                                    /* mem_free */
+};
+
+/*---------------------------------------------------------------------------*/
+static double
+na_emu_getenv(const char *name)
+{
+    const char *env = getenv(name);
+    double value = 0;
+
+    if (env) {
+        value = strtod(env, NULL);
+        if (value < 0) {
+            NA_LOG_WARNING("Ignoring negative value for %s", name);
+            value = 0;
+        }
+    }
+
+    return value;
+}
+
+/*---------------------------------------------------------------------------*/
+static NA_INLINE double
+na_emu_rand(unsigned int *seed)
+{
+    /* xorshift32, state must never be 0 */
+    *seed ^= *seed << 13;
+    *seed ^= *seed >> 17;
+    *seed ^= *seed << 5;
+
+    return (double) (*seed - 1) / 4294967296.0;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+na_emu_schedule(struct na_emu_class *na_emu_class, na_size_t size,
+    hg_time_t *deadline, na_bool_t *lost)
+{
+    const struct na_emu_params *params = &na_emu_class->params;
+    hg_time_t now, delay;
+    double delay_d = params->latency;
+
+    hg_time_get_current(&now);
+
+    hg_thread_spin_lock(&na_emu_class->link_lock);
+    if (params->jitter > 0)
+        delay_d += params->jitter * na_emu_rand(&na_emu_class->seed);
+    *lost = (params->loss > 0 && na_emu_rand(&na_emu_class->seed)
+        < params->loss) ? NA_TRUE : NA_FALSE;
+    if (params->bandwidth > 0) {
+        /* Messages are serialized on the link */
+        if (hg_time_less(na_emu_class->link_free, now))
+            na_emu_class->link_free = now;
+        na_emu_class->link_free = hg_time_add(na_emu_class->link_free,
+            hg_time_from_double((double) size / params->bandwidth));
+        now = na_emu_class->link_free;
+    }
+    hg_thread_spin_unlock(&na_emu_class->link_lock);
+
+    delay = hg_time_from_double(delay_d);
+    *deadline = hg_time_add(now, delay);
+}
+
+/*---------------------------------------------------------------------------*/
+static NA_INLINE na_return_t
+na_emu_post_check(struct na_emu_class *na_emu_class)
+{
+    /* Emulate resources being exhausted once the limit is reached */
+    if (na_emu_class->params.post_limit > 0
+        && (unsigned int) hg_atomic_incr32(&na_emu_class->post_count)
+        > na_emu_class->params.post_limit) {
+        hg_atomic_decr32(&na_emu_class->post_count);
+        return NA_AGAIN;
+    }
+
+    return NA_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_op_get(na_class_t *na_class, na_context_t *context,
+    na_cb_type_t cb_type, na_cb_t callback, void *arg, na_op_id_t *op_id,
+    struct na_emu_op_id **na_emu_op_id_ptr)
+{
+    struct na_emu_op_id *na_emu_op_id = NULL;
+    na_return_t ret = NA_SUCCESS;
+
+    /* Allocate op_id if not provided */
+    if (op_id && op_id != NA_OP_ID_IGNORE && *op_id != NA_OP_ID_NULL) {
+        na_emu_op_id = (struct na_emu_op_id *) *op_id;
+        /* Make sure op ID can be safely re-used */
+        while (hg_atomic_cas32(&na_emu_op_id->ref_count, 1, 2)
+            != HG_UTIL_TRUE)
+            cpu_spinwait();
+    } else {
+        na_emu_op_id = (struct na_emu_op_id *) na_emu_op_create(na_class);
+        NA_CHECK_ERROR(na_emu_op_id == NULL, done, ret, NA_NOMEM,
+            "Could not allocate NA emu operation ID");
+
+        /* Assign op_id */
+        if (op_id && op_id != NA_OP_ID_IGNORE)
+            *op_id = na_emu_op_id;
+    }
+    na_emu_op_id->context = context;
+    na_emu_op_id->completion_data.callback_info.type = cb_type;
+    na_emu_op_id->completion_data.callback = callback;
+    na_emu_op_id->completion_data.callback_info.arg = arg;
+    na_emu_op_id->state = NA_EMU_OP_POSTED;
+    na_emu_op_id->canceled = NA_FALSE;
+    na_emu_op_id->lost = NA_FALSE;
+    hg_atomic_set32(&na_emu_op_id->completed, NA_FALSE);
+
+    *na_emu_op_id_ptr = na_emu_op_id;
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_complete(struct na_emu_op_id *na_emu_op_id, na_return_t op_ret)
+{
+    struct na_cb_info *callback_info =
+        &na_emu_op_id->completion_data.callback_info;
+    na_return_t ret;
+
+    callback_info->ret = op_ret;
+    if (op_ret != NA_SUCCESS && callback_info->type == NA_CB_RECV_UNEXPECTED) {
+        /* In case of cancellation where no recv'd data */
+        callback_info->info.recv_unexpected.actual_buf_size = 0;
+        callback_info->info.recv_unexpected.source = NA_ADDR_NULL;
+        callback_info->info.recv_unexpected.tag = 0;
+    }
+
+    /* Mark op id as completed */
+    hg_atomic_set32(&na_emu_op_id->completed, NA_TRUE);
+
+    ret = na_cb_completion_add(na_emu_op_id->context,
+        &na_emu_op_id->completion_data);
+    NA_CHECK_NA_ERROR(done, ret, "Could not add callback to completion queue");
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+na_emu_complete_cb(const struct na_cb_info *callback_info)
+{
+    struct na_emu_op_id *na_emu_op_id =
+        (struct na_emu_op_id *) callback_info->arg;
+
+    /* Addresses of the wrapped class are returned as is */
+    na_emu_op_id->completion_data.callback_info.info = callback_info->info;
+
+    return (int) na_emu_complete(na_emu_op_id, callback_info->ret);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_post(struct na_emu_op_id *na_emu_op_id, na_size_t size)
+{
+    struct na_emu_context *na_emu_context =
+        NA_EMU_CONTEXT(na_emu_op_id->context);
+    struct na_emu_op_id *prev = NULL, *next;
+    hg_time_t now;
+    na_bool_t issue = NA_FALSE;
+
+    na_emu_schedule(NA_EMU_CLASS(na_emu_op_id->na_class), size,
+        &na_emu_op_id->deadline, &na_emu_op_id->lost);
+    hg_time_get_current(&now);
+
+    hg_thread_spin_lock(&na_emu_context->timer_lock);
+    /* Jitter only delays ops, ops are issued in the order they were posted on
+     * a context as they would be on an ordered link */
+    if (hg_time_less(na_emu_op_id->deadline, na_emu_context->last_deadline))
+        na_emu_op_id->deadline = na_emu_context->last_deadline;
+    na_emu_context->last_deadline = na_emu_op_id->deadline;
+    if (HG_LIST_IS_EMPTY(&na_emu_context->timer_list)
+        && !hg_time_less(now, na_emu_op_id->deadline)) {
+        /* Nothing to wait for, preserve ordering with queued ops though */
+        na_emu_op_id->state = NA_EMU_OP_ISSUING;
+        issue = NA_TRUE;
+    } else {
+        /* Keep list sorted, ops with the same deadline stay in order */
+        HG_LIST_FOREACH(next, &na_emu_context->timer_list, entry) {
+            if (hg_time_less(na_emu_op_id->deadline, next->deadline))
+                break;
+            prev = next;
+        }
+        if (prev)
+            HG_LIST_INSERT_AFTER(prev, na_emu_op_id, entry);
+        else
+            HG_LIST_INSERT_HEAD(&na_emu_context->timer_list, na_emu_op_id,
+                entry);
+        na_emu_op_id->state = NA_EMU_OP_QUEUED;
+    }
+    hg_thread_spin_unlock(&na_emu_context->timer_lock);
+
+    if (issue)
+        na_emu_issue(na_emu_op_id);
+
+    return NA_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_issue(struct na_emu_op_id *na_emu_op_id)
+{
+    na_class_t *na_class = NA_EMU_CLASS(na_emu_op_id->na_class)->na_class;
+    struct na_emu_context *na_emu_context =
+        NA_EMU_CONTEXT(na_emu_op_id->context);
+    struct na_cb_info *callback_info =
+        &na_emu_op_id->completion_data.callback_info;
+    struct na_emu_info_msg *msg = &na_emu_op_id->info.msg;
+    struct na_emu_info_rma *rma = &na_emu_op_id->info.rma;
+    na_bool_t canceled;
+    na_return_t ret;
+
+    /* Wrapped callback may complete and release op before it is posted */
+    hg_atomic_incr32(&na_emu_op_id->ref_count);
+
+    if (na_emu_op_id->lost) {
+        /* Lost messages are never seen by the target, lost RMA ops fail */
+        ret = (callback_info->type == NA_CB_PUT
+            || callback_info->type == NA_CB_GET) ? NA_TIMEOUT : NA_SUCCESS;
+        na_emu_complete(na_emu_op_id, ret);
+        goto done;
+    }
+
+    switch (callback_info->type) {
+        case NA_CB_SEND_UNEXPECTED:
+            ret = NA_Msg_send_unexpected(na_class, na_emu_context->context,
+                na_emu_complete_cb, na_emu_op_id, msg->buf, msg->buf_size,
+                msg->plugin_data, msg->addr, msg->id, msg->tag,
+                &na_emu_op_id->op_id);
+            break;
+        case NA_CB_SEND_EXPECTED:
+            ret = NA_Msg_send_expected(na_class, na_emu_context->context,
+                na_emu_complete_cb, na_emu_op_id, msg->buf, msg->buf_size,
+                msg->plugin_data, msg->addr, msg->id, msg->tag,
+                &na_emu_op_id->op_id);
+            break;
+        case NA_CB_PUT:
+            ret = NA_Put(na_class, na_emu_context->context,
+                na_emu_complete_cb, na_emu_op_id, rma->local_mem_handle,
+                rma->local_offset, rma->remote_mem_handle, rma->remote_offset,
+                rma->length, rma->remote_addr, rma->remote_id,
+                &na_emu_op_id->op_id);
+            break;
+        case NA_CB_GET:
+            ret = NA_Get(na_class, na_emu_context->context,
+                na_emu_complete_cb, na_emu_op_id, rma->local_mem_handle,
+                rma->local_offset, rma->remote_mem_handle, rma->remote_offset,
+                rma->length, rma->remote_addr, rma->remote_id,
+                &na_emu_op_id->op_id);
+            break;
+        default:
+            ret = NA_INVALID_ARG;
+            break;
+    }
+    if (ret == NA_AGAIN) {
+        /* Wrapped class is out of resources, retry on next progress call,
+         * deadline has expired so op goes back to the head of the list */
+        hg_thread_spin_lock(&na_emu_context->timer_lock);
+        canceled = na_emu_op_id->canceled;
+        if (!canceled) {
+            HG_LIST_INSERT_HEAD(&na_emu_context->timer_list, na_emu_op_id,
+                entry);
+            na_emu_op_id->state = NA_EMU_OP_QUEUED;
+        } else
+            na_emu_op_id->state = NA_EMU_OP_POSTED;
+        hg_thread_spin_unlock(&na_emu_context->timer_lock);
+
+        /* Cancel was requested while op was being posted */
+        if (canceled) {
+            na_emu_complete(na_emu_op_id, NA_CANCELED);
+            ret = NA_SUCCESS;
+        }
+        goto done;
+    }
+    if (ret != NA_SUCCESS) {
+        /* Op was already reported as posted, report error on completion */
+        NA_LOG_ERROR("Could not post delayed operation (%s)",
+            NA_Error_to_string(ret));
+        na_emu_complete(na_emu_op_id, ret);
+        goto done;
+    }
+
+    hg_thread_spin_lock(&na_emu_context->timer_lock);
+    na_emu_op_id->state = NA_EMU_OP_POSTED;
+    canceled = na_emu_op_id->canceled;
+    hg_thread_spin_unlock(&na_emu_context->timer_lock);
+
+    /* Cancel was requested while op was being posted */
+    if (canceled) {
+        NA_Cancel(na_class, na_emu_context->context, na_emu_op_id->op_id);
+        na_emu_trigger(na_emu_context);
+    }
+
+done:
+    na_emu_op_destroy(NULL, (na_op_id_t) na_emu_op_id);
+
+    return (ret == NA_AGAIN) ? NA_AGAIN : NA_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static unsigned int
+na_emu_timer_fire(struct na_emu_context *na_emu_context, hg_time_t now,
+    hg_time_t *next, na_bool_t *has_next)
+{
+    unsigned int count = 0;
+
+    *has_next = NA_FALSE;
+    for (;;) {
+        struct na_emu_op_id *na_emu_op_id;
+
+        hg_thread_spin_lock(&na_emu_context->timer_lock);
+        na_emu_op_id = HG_LIST_FIRST(&na_emu_context->timer_list);
+        if (na_emu_op_id && hg_time_less(now, na_emu_op_id->deadline)) {
+            *next = na_emu_op_id->deadline;
+            *has_next = NA_TRUE;
+            na_emu_op_id = NULL;
+        } else if (na_emu_op_id) {
+            HG_LIST_REMOVE(na_emu_op_id, entry);
+            na_emu_op_id->state = NA_EMU_OP_ISSUING;
+        }
+        hg_thread_spin_unlock(&na_emu_context->timer_lock);
+
+        if (!na_emu_op_id)
+            break;
+
+        if (na_emu_issue(na_emu_op_id) == NA_AGAIN) {
+            /* Op was requeued, retry once wrapped class has progressed */
+            *next = now;
+            *has_next = NA_TRUE;
+            break;
+        }
+        count++;
+    }
+
+    return count;
+}
+
+/*---------------------------------------------------------------------------*/
+static unsigned int
+na_emu_trigger(struct na_emu_context *na_emu_context)
+{
+    unsigned int count, triggered = 0;
+
+    /* Wrapped callbacks only add emu ops to the completion queue so they can
+     * safely be triggered from any thread */
+    do {
+        count = 0;
+        NA_Trigger(na_emu_context->context, 0, NA_EMU_TRIGGER_MAX, NULL,
+            &count);
+        triggered += count;
+    } while (count);
+
+    return triggered;
+}
+
+/*---------------------------------------------------------------------------*/
+static NA_INLINE void
+na_emu_release(void *arg)
+{
+    struct na_emu_op_id *na_emu_op_id = (struct na_emu_op_id *) arg;
+
+    NA_CHECK_WARNING(na_emu_op_id
+        && !hg_atomic_get32(&na_emu_op_id->completed),
+        "Releasing resources from an uncompleted operation");
+
+    na_emu_op_destroy(NULL, (na_op_id_t) na_emu_op_id);
+}
+
+/********************/
+/* Plugin callbacks */
+/********************/
+
+/*---------------------------------------------------------------------------*/
+static na_bool_t
+na_emu_check_protocol(const char *protocol_name)
+{
+    /* Protocol is the info string of the wrapped class, which must name its
+     * class explicitly (e.g., "na+sm"), it can therefore only be selected
+     * with "emu+<class>+<protocol>" */
+    return (strchr(protocol_name, '+') != NULL) ?
+        NA_TRUE : NA_FALSE;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_initialize(na_class_t *na_class, const struct na_info *na_info,
+    na_bool_t listen)
+{
+    struct na_emu_class *na_emu_class = NULL;
+    char *info_string = NULL;
+    size_t info_string_len;
+    const char *seed;
+    na_return_t ret = NA_SUCCESS;
+
+    na_emu_class = (struct na_emu_class *) malloc(sizeof(struct na_emu_class));
+    NA_CHECK_ERROR(na_emu_class == NULL, error, ret, NA_NOMEM,
+        "Could not allocate NA private data class");
+    memset(na_emu_class, 0, sizeof(struct na_emu_class));
+    hg_thread_spin_init(&na_emu_class->link_lock);
+
+    /* Link parameters */
+    na_emu_class->params.latency = na_emu_getenv(NA_EMU_LATENCY_ENV) / 1e6;
+    na_emu_class->params.jitter = na_emu_getenv(NA_EMU_JITTER_ENV) / 1e6;
+    na_emu_class->params.bandwidth =
+        na_emu_getenv(NA_EMU_BANDWIDTH_ENV) * 1e6;
+    na_emu_class->params.loss = na_emu_getenv(NA_EMU_LOSS_ENV) / 100.0;
+    na_emu_class->params.post_limit =
+        (unsigned int) na_emu_getenv(NA_EMU_POST_LIMIT_ENV);
+    hg_atomic_init32(&na_emu_class->post_count, 0);
+    seed = getenv(NA_EMU_SEED_ENV);
+    na_emu_class->seed = (seed) ? (unsigned int) strtoul(seed, NULL, 10) : 0;
+    if (na_emu_class->seed == 0)
+        na_emu_class->seed = 0x9e3779b9; /* Reproducible by default */
+    NA_LOG_DEBUG("Latency: %g s, jitter: %g s, bandwidth: %g B/s, loss: %g",
+        na_emu_class->params.latency, na_emu_class->params.jitter,
+        na_emu_class->params.bandwidth, na_emu_class->params.loss);
+
+    na_emu_class->op_id_pool =
+        hg_mem_pool_create(sizeof(struct na_emu_op_id), 0, 0);
+    NA_CHECK_ERROR(na_emu_class->op_id_pool == NULL, error, ret, NA_NOMEM,
+        "Could not create op ID pool");
+
+    /* Initialize wrapped class with remaining info string */
+    info_string_len = strlen(na_info->protocol_name) + strlen("://")
+        + (na_info->host_name ? strlen(na_info->host_name) : 0) + 1;
+    info_string = (char *) malloc(info_string_len);
+    NA_CHECK_ERROR(info_string == NULL, error, ret, NA_NOMEM,
+        "Could not allocate info string");
+    snprintf(info_string, info_string_len, "%s://%s", na_info->protocol_name,
+        na_info->host_name ? na_info->host_name : "");
+
+    na_emu_class->na_class = NA_Initialize_opt(info_string, listen,
+        na_info->na_init_info);
+    NA_CHECK_ERROR(na_emu_class->na_class == NULL, error, ret,
+        NA_PROTONOSUPPORT, "Could not initialize wrapped class (%s)",
+        info_string);
+    free(info_string);
+
+    na_class->plugin_class = na_emu_class;
+
+    return ret;
+
+error:
+    free(info_string);
+    if (na_emu_class) {
+        if (na_emu_class->op_id_pool)
+            hg_mem_pool_destroy(na_emu_class->op_id_pool);
+        hg_thread_spin_destroy(&na_emu_class->link_lock);
+        free(na_emu_class);
+    }
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_finalize(na_class_t *na_class)
+{
+    struct na_emu_class *na_emu_class = NA_EMU_CLASS(na_class);
+    na_return_t ret = NA_SUCCESS;
+
+    if (!na_emu_class)
+        goto done;
+
+    ret = NA_Finalize(na_emu_class->na_class);
+    NA_CHECK_NA_ERROR(done, ret, "Could not finalize wrapped class");
+
+    hg_mem_pool_destroy(na_emu_class->op_id_pool);
+    hg_thread_spin_destroy(&na_emu_class->link_lock);
+    free(na_emu_class);
+    na_class->plugin_class = NULL;
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_context_create(na_class_t *na_class, void **context, na_uint8_t id)
+{
+    struct na_emu_context *na_emu_context = NULL;
+    na_return_t ret = NA_SUCCESS;
+
+    na_emu_context = (struct na_emu_context *) malloc(
+        sizeof(struct na_emu_context));
+    NA_CHECK_ERROR(na_emu_context == NULL, done, ret, NA_NOMEM,
+        "Could not allocate NA emu context");
+    HG_LIST_INIT(&na_emu_context->timer_list);
+    memset(&na_emu_context->last_deadline, 0, sizeof(hg_time_t));
+    hg_thread_spin_init(&na_emu_context->timer_lock);
+
+    na_emu_context->context =
+        NA_Context_create_id(NA_EMU_CLASS(na_class)->na_class, id);
+    if (!na_emu_context->context) {
+        hg_thread_spin_destroy(&na_emu_context->timer_lock);
+        free(na_emu_context);
+        NA_GOTO_ERROR(done, ret, NA_PROTOCOL_ERROR,
+            "Could not create wrapped context");
+    }
+
+    *context = na_emu_context;
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_context_destroy(na_class_t *na_class, void *context)
+{
+    struct na_emu_context *na_emu_context = (struct na_emu_context *) context;
+    na_return_t ret = NA_SUCCESS;
+
+    NA_CHECK_ERROR(!HG_LIST_IS_EMPTY(&na_emu_context->timer_list), done, ret,
+        NA_BUSY, "Timer list should be empty");
+
+    ret = NA_Context_destroy(NA_EMU_CLASS(na_class)->na_class,
+        na_emu_context->context);
+    NA_CHECK_NA_ERROR(done, ret, "Could not destroy wrapped context");
+
+    hg_thread_spin_destroy(&na_emu_context->timer_lock);
+    free(na_emu_context);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static NA_INLINE void
+na_emu_op_id_init(na_class_t *na_class, struct na_emu_op_id *na_emu_op_id)
+{
+    na_op_id_t op_id = na_emu_op_id->op_id;
+
+    memset(na_emu_op_id, 0, sizeof(struct na_emu_op_id));
+    na_emu_op_id->na_class = na_class;
+    na_emu_op_id->op_id = op_id;
+    hg_atomic_init32(&na_emu_op_id->ref_count, 1);
+    /* Completed by default */
+    hg_atomic_init32(&na_emu_op_id->completed, NA_TRUE);
+
+    /* Set op ID release callbacks */
+    na_emu_op_id->completion_data.plugin_callback = na_emu_release;
+    na_emu_op_id->completion_data.plugin_callback_args = na_emu_op_id;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_op_id_t
+na_emu_op_create(na_class_t *na_class)
+{
+    struct na_emu_op_id *na_emu_op_id = NULL;
+
+    na_emu_op_id = (struct na_emu_op_id *) hg_mem_pool_alloc(
+        NA_EMU_CLASS(na_class)->op_id_pool);
+    NA_CHECK_ERROR_NORET(na_emu_op_id == NULL, done,
+        "Could not allocate NA emu operation ID");
+    na_emu_op_id->op_id = NA_Op_create(NA_EMU_CLASS(na_class)->na_class);
+    if (na_emu_op_id->op_id == NA_OP_ID_NULL) {
+        NA_LOG_ERROR("Could not create wrapped operation ID");
+        hg_mem_pool_free(NA_EMU_CLASS(na_class)->op_id_pool, na_emu_op_id);
+        na_emu_op_id = NULL;
+        goto done;
+    }
+    na_emu_op_id_init(na_class, na_emu_op_id);
+
+done:
+    return (na_op_id_t) na_emu_op_id;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_op_destroy(na_class_t NA_UNUSED *na_class, na_op_id_t op_id)
+{
+    struct na_emu_op_id *na_emu_op_id = (struct na_emu_op_id *) op_id;
+    struct na_emu_class *na_emu_class = NA_EMU_CLASS(na_emu_op_id->na_class);
+
+    if (hg_atomic_decr32(&na_emu_op_id->ref_count))
+        /* Cannot free yet */
+        return NA_SUCCESS;
+
+    NA_Op_destroy(na_emu_class->na_class, na_emu_op_id->op_id);
+    hg_mem_pool_free(na_emu_class->op_id_pool, na_emu_op_id);
+
+    return NA_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_op_reset(na_class_t *na_class, na_op_id_t op_id)
+{
+    struct na_emu_op_id *na_emu_op_id = (struct na_emu_op_id *) op_id;
+
+    if (hg_atomic_decr32(&na_emu_op_id->ref_count))
+        /* Still referenced, freed on release */
+        return NA_BUSY;
+
+    na_emu_op_id_init(na_class, na_emu_op_id);
+
+    return NA_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_addr_lookup(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, const char *name, na_op_id_t *op_id)
+{
+    struct na_emu_op_id *na_emu_op_id = NULL;
+    na_return_t ret;
+
+    ret = na_emu_op_get(na_class, context, NA_CB_LOOKUP, callback, arg, op_id,
+        &na_emu_op_id);
+    NA_CHECK_NA_ERROR(done, ret, "Could not get op ID");
+    NA_STATS_POST(context, &na_emu_op_id->completion_data, NA_CB_LOOKUP, 0);
+
+    /* Lookups are not delayed */
+    ret = NA_Addr_lookup(NA_EMU_CLASS(na_class)->na_class,
+        NA_EMU_CONTEXT(context)->context, na_emu_complete_cb, na_emu_op_id,
+        name, &na_emu_op_id->op_id);
+    NA_CHECK_NA_ERROR(error, ret, "Could not lookup %s", name);
+
+done:
+    return ret;
+
+error:
+    na_emu_op_destroy(na_class, (na_op_id_t) na_emu_op_id);
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_addr_lookup2(na_class_t *na_class, const char *name, na_addr_t *addr)
+{
+    return NA_Addr_lookup2(NA_EMU_CLASS(na_class)->na_class, name, addr);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_addr_free(na_class_t *na_class, na_addr_t addr)
+{
+    return NA_Addr_free(NA_EMU_CLASS(na_class)->na_class, addr);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_addr_set_remove(na_class_t *na_class, na_addr_t addr)
+{
+    return NA_Addr_set_remove(NA_EMU_CLASS(na_class)->na_class, addr);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_addr_self(na_class_t *na_class, na_addr_t *addr)
+{
+    return NA_Addr_self(NA_EMU_CLASS(na_class)->na_class, addr);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_addr_dup(na_class_t *na_class, na_addr_t addr, na_addr_t *new_addr)
+{
+    return NA_Addr_dup(NA_EMU_CLASS(na_class)->na_class, addr, new_addr);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_bool_t
+na_emu_addr_cmp(na_class_t *na_class, na_addr_t addr1, na_addr_t addr2)
+{
+    return NA_Addr_cmp(NA_EMU_CLASS(na_class)->na_class, addr1, addr2);
+}
+
+/*---------------------------------------------------------------------------*/
+static NA_INLINE na_bool_t
+na_emu_addr_is_self(na_class_t *na_class, na_addr_t addr)
+{
+    return NA_Addr_is_self(NA_EMU_CLASS(na_class)->na_class, addr);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_addr_to_string(na_class_t *na_class, char *buf, na_size_t *buf_size,
+    na_addr_t addr)
+{
+    /* Wrapped class prepends its own class name */
+    return NA_Addr_to_string(NA_EMU_CLASS(na_class)->na_class, buf, buf_size,
+        addr);
+}
+
+/*---------------------------------------------------------------------------*/
+static NA_INLINE na_size_t
+na_emu_addr_get_serialize_size(na_class_t *na_class, na_addr_t addr)
+{
+    return NA_Addr_get_serialize_size(NA_EMU_CLASS(na_class)->na_class, addr);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_addr_serialize(na_class_t *na_class, void *buf, na_size_t buf_size,
+    na_addr_t addr)
+{
+    return NA_Addr_serialize(NA_EMU_CLASS(na_class)->na_class, buf, buf_size,
+        addr);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_addr_deserialize(na_class_t *na_class, na_addr_t *addr,
+    const void *buf, na_size_t buf_size)
+{
+    return NA_Addr_deserialize(NA_EMU_CLASS(na_class)->na_class, addr, buf,
+        buf_size);
+}
+
+/*---------------------------------------------------------------------------*/
+static NA_INLINE na_size_t
+na_emu_msg_get_max_unexpected_size(const na_class_t *na_class)
+{
+    return NA_Msg_get_max_unexpected_size(NA_EMU_CLASS(na_class)->na_class);
+}
+
+/*---------------------------------------------------------------------------*/
+static NA_INLINE na_size_t
+na_emu_msg_get_max_expected_size(const na_class_t *na_class)
+{
+    return NA_Msg_get_max_expected_size(NA_EMU_CLASS(na_class)->na_class);
+}
+
+/*---------------------------------------------------------------------------*/
+static NA_INLINE na_size_t
+na_emu_msg_get_unexpected_header_size(const na_class_t *na_class)
+{
+    return NA_Msg_get_unexpected_header_size(
+        NA_EMU_CLASS(na_class)->na_class);
+}
+
+/*---------------------------------------------------------------------------*/
+static NA_INLINE na_size_t
+na_emu_msg_get_expected_header_size(const na_class_t *na_class)
+{
+    return NA_Msg_get_expected_header_size(NA_EMU_CLASS(na_class)->na_class);
+}
+
+/*---------------------------------------------------------------------------*/
+static NA_INLINE na_tag_t
+na_emu_msg_get_max_tag(const na_class_t *na_class)
+{
+    return NA_Msg_get_max_tag(NA_EMU_CLASS(na_class)->na_class);
+}
+
+/*---------------------------------------------------------------------------*/
+static void *
+na_emu_msg_buf_alloc(na_class_t *na_class, na_size_t buf_size,
+    void **plugin_data)
+{
+    return NA_Msg_buf_alloc(NA_EMU_CLASS(na_class)->na_class, buf_size,
+        plugin_data);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_msg_buf_free(na_class_t *na_class, void *buf, void *plugin_data)
+{
+    return NA_Msg_buf_free(NA_EMU_CLASS(na_class)->na_class, buf,
+        plugin_data);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_msg_init_unexpected(na_class_t *na_class, void *buf,
+    na_size_t buf_size)
+{
+    return NA_Msg_init_unexpected(NA_EMU_CLASS(na_class)->na_class, buf,
+        buf_size);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_msg_send_unexpected(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, const void *buf, na_size_t buf_size,
+    void *plugin_data, na_addr_t dest_addr, na_uint8_t dest_id, na_tag_t tag,
+    na_op_id_t *op_id)
+{
+    struct na_emu_op_id *na_emu_op_id = NULL;
+    na_return_t ret;
+
+    ret = na_emu_post_check(NA_EMU_CLASS(na_class));
+    if (ret != NA_SUCCESS)
+        goto done;
+
+    ret = na_emu_op_get(na_class, context, NA_CB_SEND_UNEXPECTED, callback,
+        arg, op_id, &na_emu_op_id);
+    NA_CHECK_NA_ERROR(done, ret, "Could not get op ID");
+    NA_STATS_POST(context, &na_emu_op_id->completion_data,
+        NA_CB_SEND_UNEXPECTED, buf_size);
+    na_emu_op_id->info.msg.buf = buf;
+    na_emu_op_id->info.msg.buf_size = buf_size;
+    na_emu_op_id->info.msg.plugin_data = plugin_data;
+    na_emu_op_id->info.msg.addr = dest_addr;
+    na_emu_op_id->info.msg.id = dest_id;
+    na_emu_op_id->info.msg.tag = tag;
+
+    ret = na_emu_post(na_emu_op_id, buf_size);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_msg_recv_unexpected(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, void *buf, na_size_t buf_size,
+    void *plugin_data, na_op_id_t *op_id)
+{
+    struct na_emu_op_id *na_emu_op_id = NULL;
+    na_return_t ret;
+
+    ret = na_emu_post_check(NA_EMU_CLASS(na_class));
+    if (ret != NA_SUCCESS)
+        goto done;
+
+    ret = na_emu_op_get(na_class, context, NA_CB_RECV_UNEXPECTED, callback,
+        arg, op_id, &na_emu_op_id);
+    NA_CHECK_NA_ERROR(done, ret, "Could not get op ID");
+    NA_STATS_POST(context, &na_emu_op_id->completion_data,
+        NA_CB_RECV_UNEXPECTED, buf_size);
+
+    /* Receives are posted immediately, delay is applied by the sender */
+    ret = NA_Msg_recv_unexpected(NA_EMU_CLASS(na_class)->na_class,
+        NA_EMU_CONTEXT(context)->context, na_emu_complete_cb, na_emu_op_id,
+        buf, buf_size, plugin_data, &na_emu_op_id->op_id);
+    NA_CHECK_NA_ERROR(error, ret, "Could not post unexpected recv");
+
+done:
+    return ret;
+
+error:
+    na_emu_op_destroy(na_class, (na_op_id_t) na_emu_op_id);
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_msg_init_expected(na_class_t *na_class, void *buf, na_size_t buf_size)
+{
+    return NA_Msg_init_expected(NA_EMU_CLASS(na_class)->na_class, buf,
+        buf_size);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_msg_send_expected(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, const void *buf, na_size_t buf_size,
+    void *plugin_data, na_addr_t dest_addr, na_uint8_t dest_id, na_tag_t tag,
+    na_op_id_t *op_id)
+{
+    struct na_emu_op_id *na_emu_op_id = NULL;
+    na_return_t ret;
+
+    ret = na_emu_post_check(NA_EMU_CLASS(na_class));
+    if (ret != NA_SUCCESS)
+        goto done;
+
+    ret = na_emu_op_get(na_class, context, NA_CB_SEND_EXPECTED, callback,
+        arg, op_id, &na_emu_op_id);
+    NA_CHECK_NA_ERROR(done, ret, "Could not get op ID");
+    NA_STATS_POST(context, &na_emu_op_id->completion_data,
+        NA_CB_SEND_EXPECTED, buf_size);
+    na_emu_op_id->info.msg.buf = buf;
+    na_emu_op_id->info.msg.buf_size = buf_size;
+    na_emu_op_id->info.msg.plugin_data = plugin_data;
+    na_emu_op_id->info.msg.addr = dest_addr;
+    na_emu_op_id->info.msg.id = dest_id;
+    na_emu_op_id->info.msg.tag = tag;
+
+    ret = na_emu_post(na_emu_op_id, buf_size);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_msg_recv_expected(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, void *buf, na_size_t buf_size,
+    void *plugin_data, na_addr_t source_addr, na_uint8_t source_id,
+    na_tag_t tag, na_op_id_t *op_id)
+{
+    struct na_emu_op_id *na_emu_op_id = NULL;
+    na_return_t ret;
+
+    ret = na_emu_post_check(NA_EMU_CLASS(na_class));
+    if (ret != NA_SUCCESS)
+        goto done;
+
+    ret = na_emu_op_get(na_class, context, NA_CB_RECV_EXPECTED, callback,
+        arg, op_id, &na_emu_op_id);
+    NA_CHECK_NA_ERROR(done, ret, "Could not get op ID");
+    NA_STATS_POST(context, &na_emu_op_id->completion_data,
+        NA_CB_RECV_EXPECTED, buf_size);
+
+    ret = NA_Msg_recv_expected(NA_EMU_CLASS(na_class)->na_class,
+        NA_EMU_CONTEXT(context)->context, na_emu_complete_cb, na_emu_op_id,
+        buf, buf_size, plugin_data, source_addr, source_id, tag,
+        &na_emu_op_id->op_id);
+    NA_CHECK_NA_ERROR(error, ret, "Could not post expected recv");
+
+done:
+    return ret;
+
+error:
+    na_emu_op_destroy(na_class, (na_op_id_t) na_emu_op_id);
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_mem_handle_create(na_class_t *na_class, void *buf, na_size_t buf_size,
+    unsigned long flags, na_mem_handle_t *mem_handle)
+{
+    return NA_Mem_handle_create(NA_EMU_CLASS(na_class)->na_class, buf,
+        buf_size, flags, mem_handle);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_mem_handle_create_segments(na_class_t *na_class,
+    struct na_segment *segments, na_size_t segment_count,
+    unsigned long flags, na_mem_handle_t *mem_handle)
+{
+    return NA_Mem_handle_create_segments(NA_EMU_CLASS(na_class)->na_class,
+        segments, segment_count, flags, mem_handle);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_mem_handle_free(na_class_t *na_class, na_mem_handle_t mem_handle)
+{
+    return NA_Mem_handle_free(NA_EMU_CLASS(na_class)->na_class, mem_handle);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_mem_register(na_class_t *na_class, na_mem_handle_t mem_handle)
+{
+    return NA_Mem_register(NA_EMU_CLASS(na_class)->na_class, mem_handle);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_mem_deregister(na_class_t *na_class, na_mem_handle_t mem_handle)
+{
+    return NA_Mem_deregister(NA_EMU_CLASS(na_class)->na_class, mem_handle);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_mem_publish(na_class_t *na_class, na_mem_handle_t mem_handle)
+{
+    return NA_Mem_publish(NA_EMU_CLASS(na_class)->na_class, mem_handle);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_mem_unpublish(na_class_t *na_class, na_mem_handle_t mem_handle)
+{
+    return NA_Mem_unpublish(NA_EMU_CLASS(na_class)->na_class, mem_handle);
+}
+
+/*---------------------------------------------------------------------------*/
+static NA_INLINE na_size_t
+na_emu_mem_handle_get_serialize_size(na_class_t *na_class,
+    na_mem_handle_t mem_handle)
+{
+    return NA_Mem_handle_get_serialize_size(NA_EMU_CLASS(na_class)->na_class,
+        mem_handle);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_mem_handle_serialize(na_class_t *na_class, void *buf,
+    na_size_t buf_size, na_mem_handle_t mem_handle)
+{
+    return NA_Mem_handle_serialize(NA_EMU_CLASS(na_class)->na_class, buf,
+        buf_size, mem_handle);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_mem_handle_deserialize(na_class_t *na_class,
+    na_mem_handle_t *mem_handle, const void *buf, na_size_t buf_size)
+{
+    return NA_Mem_handle_deserialize(NA_EMU_CLASS(na_class)->na_class,
+        mem_handle, buf, buf_size);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_put(na_class_t *na_class, na_context_t *context, na_cb_t callback,
+    void *arg, na_mem_handle_t local_mem_handle, na_offset_t local_offset,
+    na_mem_handle_t remote_mem_handle, na_offset_t remote_offset,
+    na_size_t length, na_addr_t remote_addr, na_uint8_t remote_id,
+    na_op_id_t *op_id)
+{
+    struct na_emu_op_id *na_emu_op_id = NULL;
+    na_return_t ret;
+
+    ret = na_emu_post_check(NA_EMU_CLASS(na_class));
+    if (ret != NA_SUCCESS)
+        goto done;
+
+    ret = na_emu_op_get(na_class, context, NA_CB_PUT, callback, arg, op_id,
+        &na_emu_op_id);
+    NA_CHECK_NA_ERROR(done, ret, "Could not get op ID");
+    NA_STATS_POST(context, &na_emu_op_id->completion_data, NA_CB_PUT, length);
+    na_emu_op_id->info.rma.local_mem_handle = local_mem_handle;
+    na_emu_op_id->info.rma.local_offset = local_offset;
+    na_emu_op_id->info.rma.remote_mem_handle = remote_mem_handle;
+    na_emu_op_id->info.rma.remote_offset = remote_offset;
+    na_emu_op_id->info.rma.length = length;
+    na_emu_op_id->info.rma.remote_addr = remote_addr;
+    na_emu_op_id->info.rma.remote_id = remote_id;
+
+    ret = na_emu_post(na_emu_op_id, length);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_get(na_class_t *na_class, na_context_t *context, na_cb_t callback,
+    void *arg, na_mem_handle_t local_mem_handle, na_offset_t local_offset,
+    na_mem_handle_t remote_mem_handle, na_offset_t remote_offset,
+    na_size_t length, na_addr_t remote_addr, na_uint8_t remote_id,
+    na_op_id_t *op_id)
+{
+    struct na_emu_op_id *na_emu_op_id = NULL;
+    na_return_t ret;
+
+    ret = na_emu_post_check(NA_EMU_CLASS(na_class));
+    if (ret != NA_SUCCESS)
+        goto done;
+
+    ret = na_emu_op_get(na_class, context, NA_CB_GET, callback, arg, op_id,
+        &na_emu_op_id);
+    NA_CHECK_NA_ERROR(done, ret, "Could not get op ID");
+    NA_STATS_POST(context, &na_emu_op_id->completion_data, NA_CB_GET, length);
+    na_emu_op_id->info.rma.local_mem_handle = local_mem_handle;
+    na_emu_op_id->info.rma.local_offset = local_offset;
+    na_emu_op_id->info.rma.remote_mem_handle = remote_mem_handle;
+    na_emu_op_id->info.rma.remote_offset = remote_offset;
+    na_emu_op_id->info.rma.length = length;
+    na_emu_op_id->info.rma.remote_addr = remote_addr;
+    na_emu_op_id->info.rma.remote_id = remote_id;
+
+    ret = na_emu_post(na_emu_op_id, length);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static NA_INLINE int
+na_emu_poll_get_fd(na_class_t *na_class, na_context_t *context)
+{
+    return NA_Poll_get_fd(NA_EMU_CLASS(na_class)->na_class,
+        NA_EMU_CONTEXT(context)->context);
+}
+
+/*---------------------------------------------------------------------------*/
+static NA_INLINE na_bool_t
+na_emu_poll_try_wait(na_class_t *na_class, na_context_t *context)
+{
+    struct na_emu_context *na_emu_context = NA_EMU_CONTEXT(context);
+    na_bool_t empty;
+
+    /* Delayed ops are not signaled on the wrapped fd */
+    hg_thread_spin_lock(&na_emu_context->timer_lock);
+    empty = HG_LIST_IS_EMPTY(&na_emu_context->timer_list);
+    hg_thread_spin_unlock(&na_emu_context->timer_lock);
+    if (!empty)
+        return NA_FALSE;
+
+    return NA_Poll_try_wait(NA_EMU_CLASS(na_class)->na_class,
+        na_emu_context->context);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_progress(na_class_t *na_class, na_context_t *context,
+    unsigned int timeout)
+{
+    struct na_emu_context *na_emu_context = NA_EMU_CONTEXT(context);
+    double remaining = timeout / 1000.0; /* Convert timeout in ms into seconds */
+    na_return_t ret = NA_TIMEOUT;
+
+    do {
+        hg_time_t now, next, t2;
+        na_bool_t has_next;
+        double wait;
+        unsigned int fired;
+        na_return_t progress_ret;
+
+        /* Issue ops whose deadline has expired */
+        hg_time_get_current(&now);
+        fired = na_emu_timer_fire(na_emu_context, now, &next, &has_next);
+
+        /* Do not wait past the next deadline */
+        wait = (fired) ? 0 : remaining;
+        if (has_next)
+            wait = MIN(wait, hg_time_to_double(hg_time_subtract(next, now)));
+
+        progress_ret = NA_Progress(NA_EMU_CLASS(na_class)->na_class,
+            na_emu_context->context, (unsigned int) (wait * 1000.0));
+        NA_CHECK_ERROR(progress_ret != NA_SUCCESS
+            && progress_ret != NA_TIMEOUT, done, ret, progress_ret,
+            "Could not make progress on wrapped context (%s)",
+            NA_Error_to_string(progress_ret));
+
+        if (fired || na_emu_trigger(na_emu_context)) {
+            ret = NA_SUCCESS;
+            break;
+        }
+
+        hg_time_get_current(&t2);
+        remaining -= hg_time_to_double(hg_time_subtract(t2, now));
+    } while ((int) (remaining * 1000.0) > 0);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_emu_cancel(na_class_t *na_class, na_context_t *context, na_op_id_t op_id)
+{
+    struct na_emu_context *na_emu_context = NA_EMU_CONTEXT(context);
+    struct na_emu_op_id *na_emu_op_id = (struct na_emu_op_id *) op_id;
+    na_emu_op_state_t state;
+    na_return_t ret = NA_SUCCESS;
+
+    if (hg_atomic_get32(&na_emu_op_id->completed))
+        goto done;
+
+    hg_thread_spin_lock(&na_emu_context->timer_lock);
+    state = na_emu_op_id->state;
+    if (state == NA_EMU_OP_QUEUED) {
+        HG_LIST_REMOVE(na_emu_op_id, entry);
+        na_emu_op_id->state = NA_EMU_OP_POSTED;
+    } else if (state == NA_EMU_OP_ISSUING)
+        /* Canceled once posted */
+        na_emu_op_id->canceled = NA_TRUE;
+    hg_thread_spin_unlock(&na_emu_context->timer_lock);
+
+    switch (state) {
+        case NA_EMU_OP_QUEUED:
+            /* Never issued */
+            ret = na_emu_complete(na_emu_op_id, NA_CANCELED);
+            NA_CHECK_NA_ERROR(done, ret, "Could not complete operation");
+            break;
+        case NA_EMU_OP_POSTED:
+            ret = NA_Cancel(NA_EMU_CLASS(na_class)->na_class,
+                na_emu_context->context, na_emu_op_id->op_id);
+            NA_CHECK_NA_ERROR(done, ret, "Could not cancel wrapped operation");
+
+            /* Canceled ops are expected to complete without progress */
+            na_emu_trigger(na_emu_context);
+            break;
+        case NA_EMU_OP_ISSUING:
+        default:
+            break;
+    }
+
+done:
+    return ret;
+}
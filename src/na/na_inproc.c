@@ -0,0 +1,2071 @@
+/*
+ * Copyright (C) 2013-2019 Argonne National Laboratory, Department of Energy,
+ *                    UChicago Argonne, LLC and The HDF Group.
+ * All rights reserved.
+ *
+ * The full copyright notice, including terms governing use, modification,
+ * and redistribution, is contained in the COPYING file that can be
+ * found at the root of the source code distribution tree.
+ */
+
+#include "na_plugin.h"
+
+#include "mercury_event.h"
+#include "mercury_list.h"
+#include "mercury_queue.h"
+#include "mercury_mem_pool.h"
+#include "mercury_poll.h"
+#include "mercury_thread_mutex.h"
+#include "mercury_thread_spin.h"
+#include "mercury_time.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+/****************/
+/* Local Macros */
+/****************/
+
+#define NA_INPROC_MAX_CONTEXTS  256     /* One receive slot per context ID */
+#define NA_INPROC_MSG_SIZE      4096    /* Max unexpected/expected size */
+#define NA_INPROC_QUEUE_SIZE    256     /* Initial size of receive queues */
+#define NA_INPROC_MAX_TAG       NA_TAG_UB
+#define NA_INPROC_ADDR_NAME_MAX 64
+
+/* Get inproc class / context */
+#define NA_INPROC_CLASS(na_class) \
+    ((struct na_inproc_class *) (na_class->plugin_class))
+#define NA_INPROC_CONTEXT(context) \
+    ((struct na_inproc_context *) (context->plugin_context))
+
+/************************************/
+/* Local Type and Struct Definition */
+/************************************/
+
+/* Receive slot, shared by all the contexts of an endpoint with the same ID */
+struct na_inproc_rx {
+    struct hg_atomic_queue_chain *unexpected_msg_queue; /* Pending messages */
+    struct hg_atomic_queue_chain *unexpected_op_queue;  /* Posted receives */
+    hg_thread_mutex_t match_lock;           /* Only consumer of messages */
+    unsigned int n_contexts;                /* Contexts using that slot */
+};
+
+/* Endpoint, addresses are references to endpoints */
+struct na_inproc_endpoint {
+    struct na_inproc_rx *rx[NA_INPROC_MAX_CONTEXTS]; /* Receive slots */
+    HG_QUEUE_HEAD(na_inproc_op_id) expected_op_queue;  /* Posted receives */
+    HG_QUEUE_HEAD(na_inproc_msg) expected_msg_queue;   /* Pending messages */
+    hg_mem_pool_t *msg_pool;                /* Pool of pending messages */
+    hg_thread_spin_t lock;                  /* Slot and expected queue lock */
+    hg_atomic_int32_t busy;                 /* Senders accessing slots */
+    hg_atomic_int32_t ref_count;            /* Ref count */
+    unsigned int id;                        /* Endpoint ID */
+    HG_LIST_ENTRY(na_inproc_endpoint) entry;
+};
+
+/* Message that could not be handed off to a posted receive */
+struct na_inproc_msg {
+    struct na_inproc_endpoint *source;      /* Source (reference held) */
+    na_tag_t tag;                           /* Message tag */
+    na_size_t buf_size;                     /* Message size */
+    HG_QUEUE_ENTRY(na_inproc_msg) entry;
+    char buf[NA_INPROC_MSG_SIZE];           /* Copy of message */
+};
+
+/* Memory handle */
+struct na_inproc_mem_handle {
+    struct na_segment *segments;            /* Segments */
+    na_size_t segment_count;                /* Number of segments */
+    na_size_t len;                          /* Total length */
+    unsigned long flags;                    /* Flag of operation access */
+    struct na_segment segment;              /* Storage for single segment */
+};
+
+/* Lookup info */
+struct na_inproc_info_lookup {
+    struct na_inproc_endpoint *endpoint;
+};
+
+/* Recv info */
+struct na_inproc_info_recv {
+    void *buf;
+    na_size_t buf_size;
+    na_size_t actual_buf_size;
+    struct na_inproc_endpoint *source;
+    na_tag_t tag;
+};
+
+/* Operation ID */
+struct na_inproc_op_id {
+    na_class_t *na_class;
+    na_context_t *context;
+    struct na_cb_completion_data completion_data;
+    hg_atomic_int32_t completed;    /* Operation completed */
+    union {
+        struct na_inproc_info_lookup lookup;
+        struct na_inproc_info_recv recv;
+    } info;
+    hg_atomic_int32_t ref_count;    /* Ref count */
+    HG_QUEUE_ENTRY(na_inproc_op_id) entry;
+};
+
+/* Context */
+struct na_inproc_context {
+    struct na_inproc_rx *rx;        /* Receive slot */
+    hg_poll_set_t *poll_set;        /* Poll set used to block in progress */
+    int notify;                     /* Completion notification */
+    na_bool_t no_wait;              /* Do not signal notification */
+    na_uint8_t id;                  /* Context ID */
+};
+
+/* Private data */
+struct na_inproc_class {
+    struct na_inproc_endpoint *endpoint;    /* Self endpoint */
+    hg_mem_pool_t *op_id_pool;              /* Pool of op IDs */
+    hg_mem_pool_t *msg_pool;                /* Pool of pending messages */
+    na_bool_t no_wait;                      /* Busy polling */
+};
+
+/********************/
+/* Local Prototypes */
+/********************/
+
+/* Find published endpoint and take a reference to it */
+static struct na_inproc_endpoint *
+na_inproc_endpoint_lookup(unsigned int id);
+
+/* Release reference to endpoint */
+static void
+na_inproc_endpoint_decref(struct na_inproc_endpoint *endpoint);
+
+/* Get receive slot of endpoint (slot must be released with rx_put) */
+static NA_INLINE struct na_inproc_rx *
+na_inproc_rx_get(struct na_inproc_endpoint *endpoint, na_uint8_t id);
+
+/* Release receive slot */
+static NA_INLINE void
+na_inproc_rx_put(struct na_inproc_endpoint *endpoint);
+
+/* Free pending message */
+static void
+na_inproc_msg_free(hg_mem_pool_t *msg_pool, struct na_inproc_msg *msg);
+
+/* Signal context that a completion was added from another context */
+static NA_INLINE void
+na_inproc_notify(struct na_inproc_context *context,
+    struct na_inproc_context *caller);
+
+/* Get op ID for a new operation */
+static na_return_t
+na_inproc_op_get(na_class_t *na_class, na_context_t *context,
+    na_cb_type_t cb_type, na_cb_t callback, void *arg, na_op_id_t *op_id,
+    struct na_inproc_op_id **na_inproc_op_id_ptr);
+
+/* Complete operation */
+static na_return_t
+na_inproc_complete(struct na_inproc_op_id *na_inproc_op_id,
+    na_return_t op_ret);
+
+/* Copy message to posted receive and complete it */
+static void
+na_inproc_deliver(struct na_inproc_op_id *na_inproc_op_id,
+    struct na_inproc_endpoint *source, na_tag_t tag, const void *buf,
+    na_size_t buf_size, struct na_inproc_context *caller);
+
+/* Pop posted unexpected receive that was not canceled */
+static struct na_inproc_op_id *
+na_inproc_unexpected_op_pop(struct na_inproc_rx *rx);
+
+/* Match pending unexpected messages with posted receives */
+static unsigned int
+na_inproc_unexpected_match(struct na_inproc_rx *rx,
+    struct na_inproc_context *caller);
+
+/* Remove canceled receives from unexpected op queue */
+static void
+na_inproc_unexpected_purge(struct na_inproc_rx *rx);
+
+/* Send unexpected message to receive slot */
+static na_return_t
+na_inproc_unexpected_send(struct na_inproc_endpoint *dest,
+    struct na_inproc_rx *rx, struct na_inproc_endpoint *source,
+    const void *buf, na_size_t buf_size, na_tag_t tag,
+    struct na_inproc_context *caller);
+
+/* Send expected message to endpoint */
+static na_return_t
+na_inproc_expected_send(struct na_inproc_endpoint *dest,
+    struct na_inproc_endpoint *source, const void *buf, na_size_t buf_size,
+    na_tag_t tag, struct na_inproc_context *caller);
+
+/* Send message */
+static na_return_t
+na_inproc_msg_send(na_class_t *na_class, na_context_t *context,
+    na_cb_type_t cb_type, na_cb_t callback, void *arg, const void *buf,
+    na_size_t buf_size, na_addr_t dest_addr, na_uint8_t dest_id,
+    na_tag_t tag, na_op_id_t *op_id);
+
+/* Copy between memory handles */
+static na_return_t
+na_inproc_mem_copy(struct na_inproc_mem_handle *dst, na_offset_t dst_offset,
+    struct na_inproc_mem_handle *src, na_offset_t src_offset,
+    na_size_t length);
+
+/* Poll callback */
+static int
+na_inproc_progress_cb(void *arg, int error, hg_util_bool_t *progressed);
+
+/* Release op ID after completion */
+static NA_INLINE void
+na_inproc_release(void *arg);
+
+/* check_protocol */
+static na_bool_t
+na_inproc_check_protocol(const char *protocol_name);
+
+/* initialize */
+static na_return_t
+na_inproc_initialize(na_class_t *na_class, const struct na_info *na_info,
+    na_bool_t listen);
+
+/* finalize */
+static na_return_t
+na_inproc_finalize(na_class_t *na_class);
+
+/* context_create */
+static na_return_t
+na_inproc_context_create(na_class_t *na_class, void **context,
+    na_uint8_t id);
+
+/* context_destroy */
+static na_return_t
+na_inproc_context_destroy(na_class_t *na_class, void *context);
+
+/* op_create */
+static na_op_id_t
+na_inproc_op_create(na_class_t *na_class);
+
+/* op_destroy */
+static na_return_t
+na_inproc_op_destroy(na_class_t *na_class, na_op_id_t op_id);
+
+/* op_reset */
+static na_return_t
+na_inproc_op_reset(na_class_t *na_class, na_op_id_t op_id);
+
+/* addr_lookup */
+static na_return_t
+na_inproc_addr_lookup(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, const char *name, na_op_id_t *op_id);
+
+/* addr_lookup2 */
+static na_return_t
+na_inproc_addr_lookup2(na_class_t *na_class, const char *name,
+    na_addr_t *addr);
+
+/* addr_free */
+static na_return_t
+na_inproc_addr_free(na_class_t *na_class, na_addr_t addr);
+
+/* addr_self */
+static na_return_t
+na_inproc_addr_self(na_class_t *na_class, na_addr_t *addr);
+
+/* addr_dup */
+static na_return_t
+na_inproc_addr_dup(na_class_t *na_class, na_addr_t addr,
+    na_addr_t *new_addr);
+
+/* addr_cmp */
+static na_bool_t
+na_inproc_addr_cmp(na_class_t *na_class, na_addr_t addr1, na_addr_t addr2);
+
+/* addr_is_self */
+static NA_INLINE na_bool_t
+na_inproc_addr_is_self(na_class_t *na_class, na_addr_t addr);
+
+/* addr_to_string */
+static na_return_t
+na_inproc_addr_to_string(na_class_t *na_class, char *buf,
+    na_size_t *buf_size, na_addr_t addr);
+
+/* addr_get_serialize_size */
+static NA_INLINE na_size_t
+na_inproc_addr_get_serialize_size(na_class_t *na_class, na_addr_t addr);
+
+/* addr_serialize */
+static na_return_t
+na_inproc_addr_serialize(na_class_t *na_class, void *buf,
+    na_size_t buf_size, na_addr_t addr);
+
+/* addr_deserialize */
+static na_return_t
+na_inproc_addr_deserialize(na_class_t *na_class, na_addr_t *addr,
+    const void *buf, na_size_t buf_size);
+
+/* msg_get_max_unexpected_size */
+static NA_INLINE na_size_t
+na_inproc_msg_get_max_unexpected_size(const na_class_t *na_class);
+
+/* msg_get_max_expected_size */
+static NA_INLINE na_size_t
+na_inproc_msg_get_max_expected_size(const na_class_t *na_class);
+
+/* msg_get_max_tag */
+static NA_INLINE na_tag_t
+na_inproc_msg_get_max_tag(const na_class_t *na_class);
+
+/* msg_send_unexpected */
+static na_return_t
+na_inproc_msg_send_unexpected(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, const void *buf, na_size_t buf_size,
+    void *plugin_data, na_addr_t dest_addr, na_uint8_t dest_id, na_tag_t tag,
+    na_op_id_t *op_id);
+
+/* msg_recv_unexpected */
+static na_return_t
+na_inproc_msg_recv_unexpected(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, void *buf, na_size_t buf_size,
+    void *plugin_data, na_op_id_t *op_id);
+
+/* msg_send_expected */
+static na_return_t
+na_inproc_msg_send_expected(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, const void *buf, na_size_t buf_size,
+    void *plugin_data, na_addr_t dest_addr, na_uint8_t dest_id, na_tag_t tag,
+    na_op_id_t *op_id);
+
+/* msg_recv_expected */
+static na_return_t
+na_inproc_msg_recv_expected(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, void *buf, na_size_t buf_size,
+    void *plugin_data, na_addr_t source_addr, na_uint8_t source_id,
+    na_tag_t tag, na_op_id_t *op_id);
+
+/* mem_handle_create */
+static na_return_t
+na_inproc_mem_handle_create(na_class_t *na_class, void *buf,
+    na_size_t buf_size, unsigned long flags, na_mem_handle_t *mem_handle);
+
+/* mem_handle_create_segments */
+static na_return_t
+na_inproc_mem_handle_create_segments(na_class_t *na_class,
+    struct na_segment *segments, na_size_t segment_count,
+    unsigned long flags, na_mem_handle_t *mem_handle);
+
+/* mem_handle_free */
+static na_return_t
+na_inproc_mem_handle_free(na_class_t *na_class, na_mem_handle_t mem_handle);
+
+/* mem_handle_get_serialize_size */
+static NA_INLINE na_size_t
+na_inproc_mem_handle_get_serialize_size(na_class_t *na_class,
+    na_mem_handle_t mem_handle);
+
+/* mem_handle_serialize */
+static na_return_t
+na_inproc_mem_handle_serialize(na_class_t *na_class, void *buf,
+    na_size_t buf_size, na_mem_handle_t mem_handle);
+
+/* mem_handle_deserialize */
+static na_return_t
+na_inproc_mem_handle_deserialize(na_class_t *na_class,
+    na_mem_handle_t *mem_handle, const void *buf, na_size_t buf_size);
+
+/* put */
+static na_return_t
+na_inproc_put(na_class_t *na_class, na_context_t *context, na_cb_t callback,
+    void *arg, na_mem_handle_t local_mem_handle, na_offset_t local_offset,
+    na_mem_handle_t remote_mem_handle, na_offset_t remote_offset,
+    na_size_t length, na_addr_t remote_addr, na_uint8_t remote_id,
+    na_op_id_t *op_id);
+
+/* get */
+static na_return_t
+na_inproc_get(na_class_t *na_class, na_context_t *context, na_cb_t callback,
+    void *arg, na_mem_handle_t local_mem_handle, na_offset_t local_offset,
+    na_mem_handle_t remote_mem_handle, na_offset_t remote_offset,
+    na_size_t length, na_addr_t remote_addr, na_uint8_t remote_id,
+    na_op_id_t *op_id);
+
+/* poll_get_fd */
+static NA_INLINE int
+na_inproc_poll_get_fd(na_class_t *na_class, na_context_t *context);
+
+/* poll_try_wait */
+static NA_INLINE na_bool_t
+na_inproc_poll_try_wait(na_class_t *na_class, na_context_t *context);
+
+/* poll_register */
+static na_return_t
+na_inproc_poll_register(na_class_t *na_class, na_context_t *context,
+    struct hg_poll_set *poll_set);
+
+/* poll_deregister */
+static na_return_t
+na_inproc_poll_deregister(na_class_t *na_class, na_context_t *context,
+    struct hg_poll_set *poll_set);
+
+/* progress */
+static na_return_t
+na_inproc_progress(na_class_t *na_class, na_context_t *context,
+    unsigned int timeout);
+
+/* cancel */
+static na_return_t
+na_inproc_cancel(na_class_t *na_class, na_context_t *context,
+    na_op_id_t op_id);
+
+/*******************/
+/* Local Variables */
+/*******************/
+
+const struct na_class_ops NA_PLUGIN_OPS(inproc) = {
+    "inproc",                               /* name */
+    na_inproc_check_protocol,               /* check_protocol */
+    na_inproc_initialize,                   /* initialize */
+    na_inproc_finalize,                     /* finalize */
+    NULL,                                   /* cleanup */
+    na_inproc_context_create,               /* context_create */
+    na_inproc_context_destroy,              /* context_destroy */
+    na_inproc_op_create,                    /* op_create */
+    na_inproc_op_destroy,                   /* op_destroy */
+    na_inproc_op_reset,                     /* op_reset */
+    na_inproc_addr_lookup,                  /* addr_lookup */
+    na_inproc_addr_lookup2,                 /* addr_lookup2 */
+    na_inproc_addr_free,                    /* addr_free */
+    NULL,                                   /* addr_set_remove */
+    na_inproc_addr_self,                    /* addr_self */
+    na_inproc_addr_dup,                     /* addr_dup */
+    na_inproc_addr_cmp,                     /* addr_cmp */
+    na_inproc_addr_is_self,                 /* addr_is_self */
+    na_inproc_addr_to_string,               /* addr_to_string */
+    na_inproc_addr_get_serialize_size,      /* addr_get_serialize_size */
+    na_inproc_addr_serialize,               /* addr_serialize */
+    na_inproc_addr_deserialize,             /* addr_deserialize */
+    na_inproc_msg_get_max_unexpected_size,  /* msg_get_max_unexpected_size */
+    na_inproc_msg_get_max_expected_size,    /* msg_get_max_expected_size */
+    NULL,                                   /* msg_get_unexpected_header_size */
+    NULL,                                   /* msg_get_expected_header_size */
+    na_inproc_msg_get_max_tag,              /* msg_get_max_tag */
+    NULL,                                   /* msg_buf_alloc */
+    NULL,                                   /* msg_buf_free */
+    NULL,                                   /* msg_init_unexpected */
+    na_inproc_msg_send_unexpected,          /* msg_send_unexpected */
+    na_inproc_msg_recv_unexpected,          /* msg_recv_unexpected */
+    NULL,                                   /* msg_init_expected */
+    na_inproc_msg_send_expected,            /* msg_send_expected */
+    na_inproc_msg_recv_expected,            /* msg_recv_expected */
+    na_inproc_mem_handle_create,            /* mem_handle_create */
+    na_inproc_mem_handle_create_segments,   /* mem_handle_create_segments */
+    na_inproc_mem_handle_free,              /* mem_handle_free */
+    NULL,                                   /* mem_register */
+    NULL,                                   /* mem_deregister */
+    NULL,                                   /* mem_publish */
+    NULL,                                   /* mem_unpublish */
+    na_inproc_mem_handle_get_serialize_size, /* mem_handle_get_serialize_size */
+    na_inproc_mem_handle_serialize,         /* mem_handle_serialize */
+    na_inproc_mem_handle_deserialize,       /* mem_handle_deserialize */
+    na_inproc_put,                          /* put */
+    na_inproc_get,                          /* get */
+    na_inproc_poll_get_fd,                  /* poll_get_fd */
+    na_inproc_poll_try_wait,                /* poll_try_wait */
+    na_inproc_poll_register,                /* poll_register */
+    na_inproc_poll_deregister,              /* poll_deregister */
+    na_inproc_progress,                     /* progress */
+    na_inproc_cancel,                       /* cancel */
+    NULL,                                   /* submit */
+    NULL,                                   /* msg_loan_release */
+    NULL,                                   /* mem_alloc */
+    NULL                                    /* mem_free */
+};
+
+/* Endpoints of the process */
+static HG_LIST_HEAD(na_inproc_endpoint)
+na_inproc_endpoint_list_g = HG_LIST_HEAD_INITIALIZER(na_inproc_endpoint);
+
+/* Protects endpoint list */
+static hg_thread_mutex_t na_inproc_endpoint_list_mutex_g =
+    HG_THREAD_MUTEX_INITIALIZER;
+
+/* Endpoint ID generator */
+static hg_atomic_int32_t na_inproc_endpoint_id_g = HG_ATOMIC_VAR_INIT(0);
+
+/*---------------------------------------------------------------------------*/
+static struct na_inproc_endpoint *
+na_inproc_endpoint_lookup(unsigned int id)
+{
+    struct na_inproc_endpoint *endpoint;
+
+    hg_thread_mutex_lock(&na_inproc_endpoint_list_mutex_g);
+    HG_LIST_FOREACH(endpoint, &na_inproc_endpoint_list_g, entry) {
+        if (endpoint->id == id) {
+            hg_atomic_incr32(&endpoint->ref_count);
+            break;
+        }
+    }
+    hg_thread_mutex_unlock(&na_inproc_endpoint_list_mutex_g);
+
+    return endpoint;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+na_inproc_endpoint_decref(struct na_inproc_endpoint *endpoint)
+{
+    if (hg_atomic_decr32(&endpoint->ref_count))
+        return;
+
+    /* Last reference, endpoint was already unpublished */
+    hg_thread_spin_destroy(&endpoint->lock);
+    free(endpoint);
+}
+
+/*---------------------------------------------------------------------------*/
+static NA_INLINE struct na_inproc_rx *
+na_inproc_rx_get(struct na_inproc_endpoint *endpoint, na_uint8_t id)
+{
+    struct na_inproc_rx *rx;
+
+    /* Slots are only freed once no sender is busy, the atomic increment
+     * orders the read of the slot with the unpublishing of the slot */
+    hg_atomic_incr32(&endpoint->busy);
+    rx = endpoint->rx[id];
+    if (!rx)
+        hg_atomic_decr32(&endpoint->busy);
+
+    return rx;
+}
+
+/*---------------------------------------------------------------------------*/
+static NA_INLINE void
+na_inproc_rx_put(struct na_inproc_endpoint *endpoint)
+{
+    hg_atomic_decr32(&endpoint->busy);
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+na_inproc_msg_free(hg_mem_pool_t *msg_pool, struct na_inproc_msg *msg)
+{
+    na_inproc_endpoint_decref(msg->source);
+    hg_mem_pool_free(msg_pool, msg);
+}
+
+/*---------------------------------------------------------------------------*/
+static NA_INLINE void
+na_inproc_notify(struct na_inproc_context *context,
+    struct na_inproc_context *caller)
+{
+    /* Completions added by the context itself are seen on next progress */
+    if (context == caller || context->no_wait)
+        return;
+
+    if (hg_event_set(context->notify) != HG_UTIL_SUCCESS)
+        NA_LOG_ERROR("Could not signal context");
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_op_get(na_class_t *na_class, na_context_t *context,
+    na_cb_type_t cb_type, na_cb_t callback, void *arg, na_op_id_t *op_id,
+    struct na_inproc_op_id **na_inproc_op_id_ptr)
+{
+    struct na_inproc_op_id *na_inproc_op_id = NULL;
+    na_return_t ret = NA_SUCCESS;
+
+    /* Allocate op_id if not provided */
+    if (op_id && op_id != NA_OP_ID_IGNORE && *op_id != NA_OP_ID_NULL) {
+        na_inproc_op_id = (struct na_inproc_op_id *) *op_id;
+        /* Make sure op ID can be safely re-used */
+        while (hg_atomic_cas32(&na_inproc_op_id->ref_count, 1, 2)
+            != HG_UTIL_TRUE)
+            cpu_spinwait();
+    } else {
+        na_inproc_op_id =
+            (struct na_inproc_op_id *) na_inproc_op_create(na_class);
+        NA_CHECK_ERROR(na_inproc_op_id == NULL, done, ret, NA_NOMEM,
+            "Could not allocate NA inproc operation ID");
+
+        /* Assign op_id */
+        if (op_id && op_id != NA_OP_ID_IGNORE)
+            *op_id = na_inproc_op_id;
+    }
+    na_inproc_op_id->context = context;
+    na_inproc_op_id->completion_data.callback_info.type = cb_type;
+    na_inproc_op_id->completion_data.callback = callback;
+    na_inproc_op_id->completion_data.callback_info.arg = arg;
+    hg_atomic_set32(&na_inproc_op_id->completed, NA_FALSE);
+
+    *na_inproc_op_id_ptr = na_inproc_op_id;
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_complete(struct na_inproc_op_id *na_inproc_op_id,
+    na_return_t op_ret)
+{
+    struct na_cb_info *callback_info =
+        &na_inproc_op_id->completion_data.callback_info;
+    na_return_t ret = NA_SUCCESS;
+
+    callback_info->ret = op_ret;
+
+    switch (callback_info->type) {
+        case NA_CB_LOOKUP:
+            callback_info->info.lookup.addr =
+                (na_addr_t) na_inproc_op_id->info.lookup.endpoint;
+            break;
+        case NA_CB_RECV_UNEXPECTED:
+            if (op_ret != NA_SUCCESS) {
+                /* In case of cancellation where no recv'd data */
+                callback_info->info.recv_unexpected.actual_buf_size = 0;
+                callback_info->info.recv_unexpected.source = NA_ADDR_NULL;
+                callback_info->info.recv_unexpected.tag = 0;
+                break;
+            }
+            callback_info->info.recv_unexpected.actual_buf_size =
+                na_inproc_op_id->info.recv.actual_buf_size;
+            callback_info->info.recv_unexpected.source =
+                (na_addr_t) na_inproc_op_id->info.recv.source;
+            callback_info->info.recv_unexpected.tag =
+                na_inproc_op_id->info.recv.tag;
+            break;
+        case NA_CB_SEND_UNEXPECTED:
+        case NA_CB_SEND_EXPECTED:
+        case NA_CB_RECV_EXPECTED:
+        case NA_CB_PUT:
+        case NA_CB_GET:
+            break;
+        default:
+            NA_GOTO_ERROR(done, ret, NA_INVALID_ARG,
+                "Operation type %d not supported", callback_info->type);
+    }
+
+    /* Mark op id as completed */
+    hg_atomic_set32(&na_inproc_op_id->completed, NA_TRUE);
+
+    ret = na_cb_completion_add(na_inproc_op_id->context,
+        &na_inproc_op_id->completion_data);
+    NA_CHECK_NA_ERROR(done, ret, "Could not add callback to completion queue");
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+na_inproc_deliver(struct na_inproc_op_id *na_inproc_op_id,
+    struct na_inproc_endpoint *source, na_tag_t tag, const void *buf,
+    na_size_t buf_size, struct na_inproc_context *caller)
+{
+    na_return_t op_ret = NA_SUCCESS;
+
+    if (buf_size > na_inproc_op_id->info.recv.buf_size) {
+        NA_LOG_ERROR("Message of size %zu exceeds receive buffer size %zu",
+            (size_t) buf_size, (size_t) na_inproc_op_id->info.recv.buf_size);
+        op_ret = NA_MSGSIZE;
+    } else {
+        memcpy(na_inproc_op_id->info.recv.buf, buf, buf_size);
+        na_inproc_op_id->info.recv.actual_buf_size = buf_size;
+        if (na_inproc_op_id->completion_data.callback_info.type
+            == NA_CB_RECV_UNEXPECTED) {
+            /* Source address is returned to the user */
+            hg_atomic_incr32(&source->ref_count);
+            na_inproc_op_id->info.recv.source = source;
+            na_inproc_op_id->info.recv.tag = tag;
+        }
+    }
+
+    if (na_inproc_complete(na_inproc_op_id, op_ret) != NA_SUCCESS)
+        NA_LOG_ERROR("Could not complete operation");
+
+    na_inproc_notify(NA_INPROC_CONTEXT(na_inproc_op_id->context), caller);
+}
+
+/*---------------------------------------------------------------------------*/
+static struct na_inproc_op_id *
+na_inproc_unexpected_op_pop(struct na_inproc_rx *rx)
+{
+    struct na_inproc_op_id *na_inproc_op_id;
+
+    while ((na_inproc_op_id = (struct na_inproc_op_id *)
+        hg_atomic_queue_chain_pop_mc(rx->unexpected_op_queue)) != NULL) {
+        /* Claim receive, canceled receives are already completed */
+        if (hg_atomic_cas32(&na_inproc_op_id->completed, NA_FALSE, NA_TRUE))
+            break;
+
+        /* Drop queue reference */
+        na_inproc_op_destroy(NULL, (na_op_id_t) na_inproc_op_id);
+    }
+
+    return na_inproc_op_id;
+}
+
+/*---------------------------------------------------------------------------*/
+static unsigned int
+na_inproc_unexpected_match(struct na_inproc_rx *rx,
+    struct na_inproc_context *caller)
+{
+    unsigned int count = 0;
+
+    /* Messages are only popped under the match lock so that a claimed receive
+     * always gets the oldest message and nothing is pushed back out of order.
+     * Both sides push before matching so that either one sees the other. */
+    hg_thread_mutex_lock(&rx->match_lock);
+    while (!hg_atomic_queue_chain_is_empty(rx->unexpected_msg_queue)) {
+        struct na_inproc_op_id *na_inproc_op_id;
+        struct na_inproc_msg *msg;
+
+        na_inproc_op_id = na_inproc_unexpected_op_pop(rx);
+        if (!na_inproc_op_id)
+            break;
+
+        msg = (struct na_inproc_msg *) hg_atomic_queue_chain_pop_mc(
+            rx->unexpected_msg_queue);
+
+        na_inproc_deliver(na_inproc_op_id, msg->source, msg->tag, msg->buf,
+            msg->buf_size, caller);
+        na_inproc_msg_free(NA_INPROC_CLASS(na_inproc_op_id->na_class)->msg_pool,
+            msg);
+
+        /* Drop queue reference */
+        na_inproc_op_destroy(NULL, (na_op_id_t) na_inproc_op_id);
+        count++;
+    }
+    hg_thread_mutex_unlock(&rx->match_lock);
+
+    return count;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+na_inproc_unexpected_purge(struct na_inproc_rx *rx)
+{
+    unsigned int count = hg_atomic_queue_chain_count(rx->unexpected_op_queue);
+
+    while (count--) {
+        struct na_inproc_op_id *na_inproc_op_id = (struct na_inproc_op_id *)
+            hg_atomic_queue_chain_pop_mc(rx->unexpected_op_queue);
+        if (!na_inproc_op_id)
+            break;
+
+        if (!hg_atomic_get32(&na_inproc_op_id->completed)) {
+            /* Receives are interchangeable, order does not matter */
+            if (hg_atomic_queue_chain_push(rx->unexpected_op_queue,
+                na_inproc_op_id) == HG_UTIL_SUCCESS)
+                continue;
+
+            /* Receive can no longer be matched, cancel it */
+            NA_LOG_ERROR("Could not push back posted receive");
+            if (hg_atomic_cas32(&na_inproc_op_id->completed, NA_FALSE,
+                NA_TRUE))
+                na_inproc_complete(na_inproc_op_id, NA_CANCELED);
+        }
+
+        /* Drop queue reference */
+        na_inproc_op_destroy(NULL, (na_op_id_t) na_inproc_op_id);
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_unexpected_send(struct na_inproc_endpoint *dest,
+    struct na_inproc_rx *rx, struct na_inproc_endpoint *source,
+    const void *buf, na_size_t buf_size, na_tag_t tag,
+    struct na_inproc_context *caller)
+{
+    struct na_inproc_op_id *na_inproc_op_id = NULL;
+    struct na_inproc_msg *msg;
+    na_return_t ret = NA_SUCCESS;
+
+    /* Hand buffer off to a posted receive if no message is pending */
+    if (hg_atomic_queue_chain_is_empty(rx->unexpected_msg_queue))
+        na_inproc_op_id = na_inproc_unexpected_op_pop(rx);
+    if (na_inproc_op_id) {
+        na_inproc_deliver(na_inproc_op_id, source, tag, buf, buf_size, caller);
+
+        /* Drop queue reference */
+        na_inproc_op_destroy(NULL, (na_op_id_t) na_inproc_op_id);
+        goto done;
+    }
+
+    /* Otherwise keep a copy until a receive is posted */
+    msg = (struct na_inproc_msg *) hg_mem_pool_alloc(dest->msg_pool);
+    NA_CHECK_ERROR(msg == NULL, done, ret, NA_NOMEM,
+        "Could not allocate message");
+    hg_atomic_incr32(&source->ref_count);
+    msg->source = source;
+    msg->tag = tag;
+    msg->buf_size = buf_size;
+    memcpy(msg->buf, buf, buf_size);
+
+    if (hg_atomic_queue_chain_push(rx->unexpected_msg_queue, msg)
+        != HG_UTIL_SUCCESS) {
+        na_inproc_msg_free(dest->msg_pool, msg);
+        NA_GOTO_ERROR(done, ret, NA_NOMEM, "Could not push message");
+    }
+
+    /* A receive may have been posted in the meantime */
+    na_inproc_unexpected_match(rx, caller);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_expected_send(struct na_inproc_endpoint *dest,
+    struct na_inproc_endpoint *source, const void *buf, na_size_t buf_size,
+    na_tag_t tag, struct na_inproc_context *caller)
+{
+    struct na_inproc_op_id *na_inproc_op_id;
+    struct na_inproc_msg *msg = NULL;
+    na_return_t ret = NA_SUCCESS;
+
+    /* Receives and messages are queued in order, oldest match first */
+    hg_thread_spin_lock(&dest->lock);
+    HG_QUEUE_FOREACH(na_inproc_op_id, &dest->expected_op_queue, entry) {
+        if (na_inproc_op_id->info.recv.source == source
+            && na_inproc_op_id->info.recv.tag == tag) {
+            HG_QUEUE_REMOVE(&dest->expected_op_queue, na_inproc_op_id,
+                na_inproc_op_id, entry);
+            break;
+        }
+    }
+    if (!na_inproc_op_id) {
+        /* Receive not posted yet, keep a copy */
+        msg = (struct na_inproc_msg *) hg_mem_pool_alloc(dest->msg_pool);
+        if (msg) {
+            hg_atomic_incr32(&source->ref_count);
+            msg->source = source;
+            msg->tag = tag;
+            msg->buf_size = buf_size;
+            memcpy(msg->buf, buf, buf_size);
+            HG_QUEUE_PUSH_TAIL(&dest->expected_msg_queue, msg, entry);
+        }
+    }
+    hg_thread_spin_unlock(&dest->lock);
+
+    if (na_inproc_op_id)
+        /* Receive was removed from the list so it cannot be canceled */
+        na_inproc_deliver(na_inproc_op_id, source, tag, buf, buf_size, caller);
+    else
+        NA_CHECK_ERROR(msg == NULL, done, ret, NA_NOMEM,
+            "Could not allocate message");
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_msg_send(na_class_t *na_class, na_context_t *context,
+    na_cb_type_t cb_type, na_cb_t callback, void *arg, const void *buf,
+    na_size_t buf_size, na_addr_t dest_addr, na_uint8_t dest_id,
+    na_tag_t tag, na_op_id_t *op_id)
+{
+    struct na_inproc_endpoint *dest = (struct na_inproc_endpoint *) dest_addr;
+    struct na_inproc_op_id *na_inproc_op_id = NULL;
+    struct na_inproc_rx *rx;
+    na_return_t ret;
+
+    NA_CHECK_ERROR(buf_size > NA_INPROC_MSG_SIZE, done, ret, NA_MSGSIZE,
+        "Exceeds message size (%zu)", (size_t) buf_size);
+
+    ret = na_inproc_op_get(na_class, context, cb_type, callback, arg, op_id,
+        &na_inproc_op_id);
+    NA_CHECK_NA_ERROR(done, ret, "Could not get op ID");
+    NA_STATS_POST(context, &na_inproc_op_id->completion_data,
+        cb_type, buf_size);
+
+    /* Destination context must exist */
+    rx = na_inproc_rx_get(dest, dest_id);
+    NA_CHECK_ERROR(rx == NULL, error, ret, NA_ADDRNOTAVAIL,
+        "No context with ID %u at destination", (unsigned int) dest_id);
+
+    if (cb_type == NA_CB_SEND_UNEXPECTED)
+        ret = na_inproc_unexpected_send(dest, rx,
+            NA_INPROC_CLASS(na_class)->endpoint, buf, buf_size, tag,
+            NA_INPROC_CONTEXT(context));
+    else
+        ret = na_inproc_expected_send(dest,
+            NA_INPROC_CLASS(na_class)->endpoint, buf, buf_size, tag,
+            NA_INPROC_CONTEXT(context));
+    na_inproc_rx_put(dest);
+    NA_CHECK_NA_ERROR(error, ret, "Could not send message");
+
+    /* Buffer was either copied to the receive buffer or to a message */
+    ret = na_inproc_complete(na_inproc_op_id, NA_SUCCESS);
+    NA_CHECK_NA_ERROR(done, ret, "Could not complete operation");
+
+done:
+    return ret;
+
+error:
+    na_inproc_op_destroy(na_class, (na_op_id_t) na_inproc_op_id);
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_mem_copy(struct na_inproc_mem_handle *dst, na_offset_t dst_offset,
+    struct na_inproc_mem_handle *src, na_offset_t src_offset,
+    na_size_t length)
+{
+    na_size_t dst_idx = 0, src_idx = 0;
+    na_return_t ret = NA_SUCCESS;
+
+    NA_CHECK_ERROR(dst_offset + length > dst->len
+        || src_offset + length > src->len, done, ret, NA_OVERFLOW,
+        "Exceeds memory handle length");
+
+    /* Fast path for contiguous buffers */
+    if (dst->segment_count == 1 && src->segment_count == 1) {
+        memcpy((char *) dst->segments[0].address + dst_offset,
+            (const char *) src->segments[0].address + src_offset, length);
+        goto done;
+    }
+
+    /* Find first segments */
+    while (dst_offset >= dst->segments[dst_idx].size)
+        dst_offset -= dst->segments[dst_idx++].size;
+    while (src_offset >= src->segments[src_idx].size)
+        src_offset -= src->segments[src_idx++].size;
+
+    while (length > 0) {
+        na_size_t len = MIN(length,
+            MIN(dst->segments[dst_idx].size - dst_offset,
+            src->segments[src_idx].size - src_offset));
+
+        memcpy((char *) dst->segments[dst_idx].address + dst_offset,
+            (const char *) src->segments[src_idx].address + src_offset, len);
+        length -= len;
+        dst_offset += len;
+        src_offset += len;
+        if (dst_offset == dst->segments[dst_idx].size) {
+            dst_idx++;
+            dst_offset = 0;
+        }
+        if (src_offset == src->segments[src_idx].size) {
+            src_idx++;
+            src_offset = 0;
+        }
+    }
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+na_inproc_progress_cb(void *arg, int NA_UNUSED error,
+    hg_util_bool_t *progressed)
+{
+    struct na_inproc_context *na_inproc_context =
+        (struct na_inproc_context *) arg;
+    hg_util_bool_t notified = HG_UTIL_FALSE;
+    int ret = HG_UTIL_SUCCESS;
+
+    ret = hg_event_get(na_inproc_context->notify, &notified);
+    NA_CHECK_ERROR_NORET(ret != HG_UTIL_SUCCESS, done,
+        "Could not get completion notification");
+
+    *progressed = (hg_util_bool_t) (notified
+        || na_inproc_unexpected_match(na_inproc_context->rx,
+            na_inproc_context));
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static NA_INLINE void
+na_inproc_release(void *arg)
+{
+    struct na_inproc_op_id *na_inproc_op_id = (struct na_inproc_op_id *) arg;
+
+    NA_CHECK_WARNING(na_inproc_op_id
+        && !hg_atomic_get32(&na_inproc_op_id->completed),
+        "Releasing resources from an uncompleted operation");
+
+    na_inproc_op_destroy(NULL, (na_op_id_t) na_inproc_op_id);
+}
+
+/********************/
+/* Plugin callbacks */
+/********************/
+
+/*---------------------------------------------------------------------------*/
+static na_bool_t
+na_inproc_check_protocol(const char *protocol_name)
+{
+    return (strcmp("inproc", protocol_name) == 0) ? NA_TRUE : NA_FALSE;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_initialize(na_class_t *na_class, const struct na_info *na_info,
+    na_bool_t NA_UNUSED listen)
+{
+    struct na_inproc_class *na_inproc_class = NULL;
+    struct na_inproc_endpoint *endpoint = NULL;
+    na_return_t ret = NA_SUCCESS;
+
+    na_inproc_class = (struct na_inproc_class *) malloc(
+        sizeof(struct na_inproc_class));
+    NA_CHECK_ERROR(na_inproc_class == NULL, error, ret, NA_NOMEM,
+        "Could not allocate NA private data class");
+    memset(na_inproc_class, 0, sizeof(struct na_inproc_class));
+    na_class->plugin_class = na_inproc_class;
+
+    if (na_info->na_init_info
+        && na_info->na_init_info->progress_mode == NA_NO_BLOCK)
+        na_inproc_class->no_wait = NA_TRUE;
+
+    /* Create pools for op IDs and messages */
+    na_inproc_class->op_id_pool =
+        hg_mem_pool_create(sizeof(struct na_inproc_op_id), 0, 0);
+    NA_CHECK_ERROR(na_inproc_class->op_id_pool == NULL, error, ret,
+        NA_NOMEM, "Could not create op ID pool");
+    na_inproc_class->msg_pool =
+        hg_mem_pool_create(sizeof(struct na_inproc_msg), 0, 0);
+    NA_CHECK_ERROR(na_inproc_class->msg_pool == NULL, error, ret,
+        NA_NOMEM, "Could not create message pool");
+
+    /* Create self endpoint */
+    endpoint = (struct na_inproc_endpoint *) malloc(
+        sizeof(struct na_inproc_endpoint));
+    NA_CHECK_ERROR(endpoint == NULL, error, ret, NA_NOMEM,
+        "Could not allocate endpoint");
+    memset(endpoint, 0, sizeof(struct na_inproc_endpoint));
+    HG_QUEUE_INIT(&endpoint->expected_op_queue);
+    HG_QUEUE_INIT(&endpoint->expected_msg_queue);
+    endpoint->msg_pool = na_inproc_class->msg_pool;
+    hg_thread_spin_init(&endpoint->lock);
+    hg_atomic_init32(&endpoint->busy, 0);
+    hg_atomic_init32(&endpoint->ref_count, 1);
+    endpoint->id =
+        (unsigned int) hg_atomic_incr32(&na_inproc_endpoint_id_g) - 1;
+    na_inproc_class->endpoint = endpoint;
+
+    /* Publish endpoint */
+    hg_thread_mutex_lock(&na_inproc_endpoint_list_mutex_g);
+    HG_LIST_INSERT_HEAD(&na_inproc_endpoint_list_g, endpoint, entry);
+    hg_thread_mutex_unlock(&na_inproc_endpoint_list_mutex_g);
+
+    return ret;
+
+error:
+    if (na_inproc_class) {
+        if (na_inproc_class->msg_pool)
+            hg_mem_pool_destroy(na_inproc_class->msg_pool);
+        if (na_inproc_class->op_id_pool)
+            hg_mem_pool_destroy(na_inproc_class->op_id_pool);
+        free(na_inproc_class);
+        na_class->plugin_class = NULL;
+    }
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_finalize(na_class_t *na_class)
+{
+    struct na_inproc_class *na_inproc_class = NA_INPROC_CLASS(na_class);
+    struct na_inproc_endpoint *endpoint;
+    na_return_t ret = NA_SUCCESS;
+
+    if (!na_inproc_class)
+        goto done;
+    endpoint = na_inproc_class->endpoint;
+
+    NA_CHECK_ERROR(!HG_QUEUE_IS_EMPTY(&endpoint->expected_op_queue), done,
+        ret, NA_BUSY, "Expected op queue should be empty");
+
+    /* Unpublish endpoint, contexts are destroyed so no message can arrive */
+    hg_thread_mutex_lock(&na_inproc_endpoint_list_mutex_g);
+    HG_LIST_REMOVE(endpoint, entry);
+    hg_thread_mutex_unlock(&na_inproc_endpoint_list_mutex_g);
+
+    /* Drop messages that were never received */
+    while (!HG_QUEUE_IS_EMPTY(&endpoint->expected_msg_queue)) {
+        struct na_inproc_msg *msg =
+            HG_QUEUE_FIRST(&endpoint->expected_msg_queue);
+
+        HG_QUEUE_POP_HEAD(&endpoint->expected_msg_queue, entry);
+        na_inproc_msg_free(na_inproc_class->msg_pool, msg);
+    }
+    endpoint->msg_pool = NULL;
+    na_inproc_endpoint_decref(endpoint);
+
+    hg_mem_pool_destroy(na_inproc_class->msg_pool);
+    hg_mem_pool_destroy(na_inproc_class->op_id_pool);
+    free(na_inproc_class);
+    na_class->plugin_class = NULL;
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_context_create(na_class_t *na_class, void **context, na_uint8_t id)
+{
+    struct na_inproc_endpoint *endpoint = NA_INPROC_CLASS(na_class)->endpoint;
+    struct na_inproc_context *na_inproc_context = NULL;
+    struct na_inproc_rx *rx = NULL;
+    na_bool_t poll_added = NA_FALSE;
+    na_return_t ret = NA_SUCCESS;
+
+    na_inproc_context = (struct na_inproc_context *) malloc(
+        sizeof(struct na_inproc_context));
+    NA_CHECK_ERROR(na_inproc_context == NULL, error, ret, NA_NOMEM,
+        "Could not allocate NA inproc context");
+    memset(na_inproc_context, 0, sizeof(struct na_inproc_context));
+    na_inproc_context->no_wait = NA_INPROC_CLASS(na_class)->no_wait;
+    na_inproc_context->id = id;
+    na_inproc_context->notify = -1;
+
+    /* Create notification event and poll set to block on it */
+    na_inproc_context->notify = hg_event_create();
+    NA_CHECK_ERROR(na_inproc_context->notify == HG_UTIL_FAIL, error, ret,
+        NA_PROTOCOL_ERROR, "hg_event_create() failed");
+    na_inproc_context->poll_set = hg_poll_create();
+    NA_CHECK_ERROR(na_inproc_context->poll_set == NULL, error, ret,
+        NA_PROTOCOL_ERROR, "hg_poll_create() failed");
+    NA_CHECK_ERROR(hg_poll_add(na_inproc_context->poll_set,
+        na_inproc_context->notify, HG_POLLIN, na_inproc_progress_cb,
+        na_inproc_context) != HG_UTIL_SUCCESS, error, ret, NA_PROTOCOL_ERROR,
+        "hg_poll_add() failed");
+    poll_added = NA_TRUE;
+
+    /* Create receive slot if this is the first context with that ID */
+    hg_thread_spin_lock(&endpoint->lock);
+    rx = endpoint->rx[id];
+    hg_thread_spin_unlock(&endpoint->lock);
+    if (!rx) {
+        struct na_inproc_rx *new_rx;
+
+        new_rx = (struct na_inproc_rx *) malloc(sizeof(struct na_inproc_rx));
+        NA_CHECK_ERROR(new_rx == NULL, error, ret, NA_NOMEM,
+            "Could not allocate receive slot");
+        new_rx->unexpected_msg_queue =
+            hg_atomic_queue_chain_alloc(NA_INPROC_QUEUE_SIZE);
+        new_rx->unexpected_op_queue =
+            hg_atomic_queue_chain_alloc(NA_INPROC_QUEUE_SIZE);
+        hg_thread_mutex_init(&new_rx->match_lock);
+        new_rx->n_contexts = 0;
+        if (!new_rx->unexpected_msg_queue || !new_rx->unexpected_op_queue) {
+            hg_atomic_queue_chain_free(new_rx->unexpected_msg_queue);
+            hg_atomic_queue_chain_free(new_rx->unexpected_op_queue);
+            hg_thread_mutex_destroy(&new_rx->match_lock);
+            free(new_rx);
+            NA_GOTO_ERROR(error, ret, NA_NOMEM,
+                "Could not allocate receive queues");
+        }
+
+        /* Contexts may be concurrently created with the same ID */
+        hg_thread_spin_lock(&endpoint->lock);
+        rx = endpoint->rx[id];
+        if (!rx)
+            rx = endpoint->rx[id] = new_rx;
+        rx->n_contexts++;
+        hg_thread_spin_unlock(&endpoint->lock);
+        if (rx != new_rx) {
+            hg_atomic_queue_chain_free(new_rx->unexpected_msg_queue);
+            hg_atomic_queue_chain_free(new_rx->unexpected_op_queue);
+            hg_thread_mutex_destroy(&new_rx->match_lock);
+            free(new_rx);
+        }
+    } else {
+        hg_thread_spin_lock(&endpoint->lock);
+        rx->n_contexts++;
+        hg_thread_spin_unlock(&endpoint->lock);
+    }
+    na_inproc_context->rx = rx;
+
+    *context = na_inproc_context;
+
+    return ret;
+
+error:
+    if (na_inproc_context) {
+        if (poll_added)
+            hg_poll_remove(na_inproc_context->poll_set,
+                na_inproc_context->notify);
+        if (na_inproc_context->poll_set)
+            hg_poll_destroy(na_inproc_context->poll_set);
+        if (na_inproc_context->notify != -1)
+            hg_event_destroy(na_inproc_context->notify);
+        free(na_inproc_context);
+    }
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_context_destroy(na_class_t *na_class, void *context)
+{
+    struct na_inproc_class *na_inproc_class = NA_INPROC_CLASS(na_class);
+    struct na_inproc_endpoint *endpoint = na_inproc_class->endpoint;
+    struct na_inproc_context *na_inproc_context =
+        (struct na_inproc_context *) context;
+    struct na_inproc_rx *rx = na_inproc_context->rx;
+    na_bool_t last, busy = NA_FALSE;
+    na_return_t ret = NA_SUCCESS;
+
+    /* Canceled receives may still be queued */
+    na_inproc_unexpected_purge(rx);
+
+    hg_thread_spin_lock(&endpoint->lock);
+    last = (rx->n_contexts == 1);
+    if (last && hg_atomic_queue_chain_is_empty(rx->unexpected_op_queue))
+        endpoint->rx[na_inproc_context->id] = NULL;
+    else if (last)
+        busy = NA_TRUE;
+    else
+        rx->n_contexts--;
+    hg_thread_spin_unlock(&endpoint->lock);
+    NA_CHECK_ERROR(busy, done, ret, NA_BUSY,
+        "Unexpected op queue should be empty");
+
+    if (last) {
+        struct na_inproc_msg *msg;
+
+        /* Wait for senders that may still use the slot */
+        hg_atomic_fence();
+        while (hg_atomic_get32(&endpoint->busy))
+            cpu_spinwait();
+
+        /* Drop messages that were never received */
+        while ((msg = (struct na_inproc_msg *) hg_atomic_queue_chain_pop_mc(
+            rx->unexpected_msg_queue)) != NULL)
+            na_inproc_msg_free(na_inproc_class->msg_pool, msg);
+
+        hg_atomic_queue_chain_free(rx->unexpected_msg_queue);
+        hg_atomic_queue_chain_free(rx->unexpected_op_queue);
+        hg_thread_mutex_destroy(&rx->match_lock);
+        free(rx);
+    }
+
+    hg_poll_remove(na_inproc_context->poll_set, na_inproc_context->notify);
+    hg_poll_destroy(na_inproc_context->poll_set);
+    hg_event_destroy(na_inproc_context->notify);
+    free(na_inproc_context);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static NA_INLINE void
+na_inproc_op_id_init(na_class_t *na_class,
+    struct na_inproc_op_id *na_inproc_op_id)
+{
+    memset(na_inproc_op_id, 0, sizeof(struct na_inproc_op_id));
+    na_inproc_op_id->na_class = na_class;
+    hg_atomic_init32(&na_inproc_op_id->ref_count, 1);
+    /* Completed by default */
+    hg_atomic_init32(&na_inproc_op_id->completed, NA_TRUE);
+
+    /* Set op ID release callbacks */
+    na_inproc_op_id->completion_data.plugin_callback = na_inproc_release;
+    na_inproc_op_id->completion_data.plugin_callback_args = na_inproc_op_id;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_op_id_t
+na_inproc_op_create(na_class_t *na_class)
+{
+    struct na_inproc_op_id *na_inproc_op_id = NULL;
+
+    na_inproc_op_id = (struct na_inproc_op_id *) hg_mem_pool_alloc(
+        NA_INPROC_CLASS(na_class)->op_id_pool);
+    NA_CHECK_ERROR_NORET(na_inproc_op_id == NULL, done,
+        "Could not allocate NA inproc operation ID");
+    na_inproc_op_id_init(na_class, na_inproc_op_id);
+
+done:
+    return (na_op_id_t) na_inproc_op_id;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_op_destroy(na_class_t NA_UNUSED *na_class, na_op_id_t op_id)
+{
+    struct na_inproc_op_id *na_inproc_op_id =
+        (struct na_inproc_op_id *) op_id;
+
+    if (hg_atomic_decr32(&na_inproc_op_id->ref_count))
+        /* Cannot free yet */
+        return NA_SUCCESS;
+
+    hg_mem_pool_free(NA_INPROC_CLASS(na_inproc_op_id->na_class)->op_id_pool,
+        na_inproc_op_id);
+
+    return NA_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_op_reset(na_class_t *na_class, na_op_id_t op_id)
+{
+    struct na_inproc_op_id *na_inproc_op_id =
+        (struct na_inproc_op_id *) op_id;
+
+    if (hg_atomic_decr32(&na_inproc_op_id->ref_count))
+        /* Still referenced, freed on release */
+        return NA_BUSY;
+
+    na_inproc_op_id_init(na_class, na_inproc_op_id);
+
+    return NA_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_addr_lookup(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, const char *name, na_op_id_t *op_id)
+{
+    struct na_inproc_op_id *na_inproc_op_id = NULL;
+    na_addr_t addr = NA_ADDR_NULL;
+    na_return_t ret;
+
+    ret = na_inproc_addr_lookup2(na_class, name, &addr);
+    NA_CHECK_NA_ERROR(done, ret, "Could not lookup %s", name);
+
+    ret = na_inproc_op_get(na_class, context, NA_CB_LOOKUP, callback, arg,
+        op_id, &na_inproc_op_id);
+    NA_CHECK_NA_ERROR(error, ret, "Could not get op ID");
+    NA_STATS_POST(context, &na_inproc_op_id->completion_data, NA_CB_LOOKUP, 0);
+    na_inproc_op_id->info.lookup.endpoint = (struct na_inproc_endpoint *) addr;
+
+    /* Endpoints are already known, complete immediately */
+    ret = na_inproc_complete(na_inproc_op_id, NA_SUCCESS);
+    NA_CHECK_NA_ERROR(done, ret, "Could not complete operation");
+
+done:
+    return ret;
+
+error:
+    na_inproc_addr_free(na_class, addr);
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_addr_lookup2(na_class_t NA_UNUSED *na_class, const char *name,
+    na_addr_t *addr)
+{
+    struct na_inproc_endpoint *endpoint;
+    const char *id_string;
+    char *end = NULL;
+    unsigned long id;
+    na_return_t ret = NA_SUCCESS;
+
+    /**
+     * Strings can be of the format:
+     *   [<protocol>://]<endpoint ID>
+     */
+    id_string = strstr(name, "://");
+    id_string = (id_string) ? id_string + 3 : name;
+
+    id = strtoul(id_string, &end, 10);
+    NA_CHECK_ERROR(end == id_string || *end != '\0', done, ret,
+        NA_INVALID_ARG, "Malformed address string %s", name);
+
+    endpoint = na_inproc_endpoint_lookup((unsigned int) id);
+    NA_CHECK_ERROR(endpoint == NULL, done, ret, NA_ADDRNOTAVAIL,
+        "No endpoint with ID %lu", id);
+
+    *addr = (na_addr_t) endpoint;
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_addr_free(na_class_t NA_UNUSED *na_class, na_addr_t addr)
+{
+    if (addr)
+        na_inproc_endpoint_decref((struct na_inproc_endpoint *) addr);
+
+    return NA_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_addr_self(na_class_t *na_class, na_addr_t *addr)
+{
+    struct na_inproc_endpoint *endpoint = NA_INPROC_CLASS(na_class)->endpoint;
+
+    hg_atomic_incr32(&endpoint->ref_count);
+    *addr = (na_addr_t) endpoint;
+
+    return NA_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_addr_dup(na_class_t NA_UNUSED *na_class, na_addr_t addr,
+    na_addr_t *new_addr)
+{
+    struct na_inproc_endpoint *endpoint = (struct na_inproc_endpoint *) addr;
+
+    hg_atomic_incr32(&endpoint->ref_count);
+    *new_addr = addr;
+
+    return NA_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_bool_t
+na_inproc_addr_cmp(na_class_t NA_UNUSED *na_class, na_addr_t addr1,
+    na_addr_t addr2)
+{
+    return (addr1 == addr2) ? NA_TRUE : NA_FALSE;
+}
+
+/*---------------------------------------------------------------------------*/
+static NA_INLINE na_bool_t
+na_inproc_addr_is_self(na_class_t *na_class, na_addr_t addr)
+{
+    return ((struct na_inproc_endpoint *) addr
+        == NA_INPROC_CLASS(na_class)->endpoint) ? NA_TRUE : NA_FALSE;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_addr_to_string(na_class_t NA_UNUSED *na_class, char *buf,
+    na_size_t *buf_size, na_addr_t addr)
+{
+    struct na_inproc_endpoint *endpoint = (struct na_inproc_endpoint *) addr;
+    char addr_string[NA_INPROC_ADDR_NAME_MAX];
+    na_size_t string_len;
+    na_return_t ret = NA_SUCCESS;
+
+    snprintf(addr_string, sizeof(addr_string), "inproc://%u", endpoint->id);
+    string_len = strlen(addr_string);
+    if (buf) {
+        NA_CHECK_ERROR(string_len >= *buf_size, done, ret, NA_OVERFLOW,
+            "Buffer size too small to copy addr");
+        strcpy(buf, addr_string);
+    }
+    *buf_size = string_len + 1;
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static NA_INLINE na_size_t
+na_inproc_addr_get_serialize_size(na_class_t NA_UNUSED *na_class,
+    na_addr_t NA_UNUSED addr)
+{
+    return sizeof(unsigned int);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_addr_serialize(na_class_t NA_UNUSED *na_class, void *buf,
+    na_size_t buf_size, na_addr_t addr)
+{
+    struct na_inproc_endpoint *endpoint = (struct na_inproc_endpoint *) addr;
+    na_return_t ret = NA_SUCCESS;
+
+    NA_CHECK_ERROR(buf_size < sizeof(unsigned int), done, ret, NA_OVERFLOW,
+        "Buffer size too small for serializing address");
+    memcpy(buf, &endpoint->id, sizeof(unsigned int));
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_addr_deserialize(na_class_t NA_UNUSED *na_class, na_addr_t *addr,
+    const void *buf, na_size_t buf_size)
+{
+    struct na_inproc_endpoint *endpoint;
+    unsigned int id;
+    na_return_t ret = NA_SUCCESS;
+
+    NA_CHECK_ERROR(buf_size < sizeof(unsigned int), done, ret, NA_OVERFLOW,
+        "Buffer size too small for deserializing address");
+    memcpy(&id, buf, sizeof(unsigned int));
+
+    endpoint = na_inproc_endpoint_lookup(id);
+    NA_CHECK_ERROR(endpoint == NULL, done, ret, NA_ADDRNOTAVAIL,
+        "No endpoint with ID %u", id);
+
+    *addr = (na_addr_t) endpoint;
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static NA_INLINE na_size_t
+na_inproc_msg_get_max_unexpected_size(const na_class_t NA_UNUSED *na_class)
+{
+    return NA_INPROC_MSG_SIZE;
+}
+
+/*---------------------------------------------------------------------------*/
+static NA_INLINE na_size_t
+na_inproc_msg_get_max_expected_size(const na_class_t NA_UNUSED *na_class)
+{
+    return NA_INPROC_MSG_SIZE;
+}
+
+/*---------------------------------------------------------------------------*/
+static NA_INLINE na_tag_t
+na_inproc_msg_get_max_tag(const na_class_t NA_UNUSED *na_class)
+{
+    return NA_INPROC_MAX_TAG;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_msg_send_unexpected(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, const void *buf, na_size_t buf_size,
+    void NA_UNUSED *plugin_data, na_addr_t dest_addr, na_uint8_t dest_id,
+    na_tag_t tag, na_op_id_t *op_id)
+{
+    return na_inproc_msg_send(na_class, context, NA_CB_SEND_UNEXPECTED,
+        callback, arg, buf, buf_size, dest_addr, dest_id, tag, op_id);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_msg_recv_unexpected(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, void *buf, na_size_t buf_size,
+    void NA_UNUSED *plugin_data, na_op_id_t *op_id)
+{
+    struct na_inproc_context *na_inproc_context = NA_INPROC_CONTEXT(context);
+    struct na_inproc_op_id *na_inproc_op_id = NULL;
+#ifdef NA_HAS_COLLECT_STATS
+    unsigned int unexpected_msg_count;
+#endif
+    na_return_t ret;
+
+    ret = na_inproc_op_get(na_class, context, NA_CB_RECV_UNEXPECTED, callback,
+        arg, op_id, &na_inproc_op_id);
+    NA_CHECK_NA_ERROR(done, ret, "Could not get op ID");
+    NA_STATS_POST(context, &na_inproc_op_id->completion_data,
+        NA_CB_RECV_UNEXPECTED, buf_size);
+    na_inproc_op_id->info.recv.buf = buf;
+    na_inproc_op_id->info.recv.buf_size = buf_size;
+    na_inproc_op_id->info.recv.actual_buf_size = 0;
+    na_inproc_op_id->info.recv.source = NULL;
+    na_inproc_op_id->info.recv.tag = 0;
+
+#ifdef NA_HAS_COLLECT_STATS
+    /* Messages that arrived before any receive was posted */
+    unexpected_msg_count = hg_atomic_queue_chain_count(
+        na_inproc_context->rx->unexpected_msg_queue);
+    if (unexpected_msg_count) {
+        NA_STATS_EVENT(context, NA_STATS_UNEXPECTED_QUEUED);
+        NA_STATS_UNEXPECTED_DEPTH(context, unexpected_msg_count);
+    }
+#endif
+
+    /* Queue holds a reference until the receive is popped */
+    hg_atomic_incr32(&na_inproc_op_id->ref_count);
+    if (hg_atomic_queue_chain_push(na_inproc_context->rx->unexpected_op_queue,
+        na_inproc_op_id) != HG_UTIL_SUCCESS) {
+        hg_atomic_decr32(&na_inproc_op_id->ref_count);
+        na_inproc_op_destroy(na_class, (na_op_id_t) na_inproc_op_id);
+        NA_GOTO_ERROR(done, ret, NA_NOMEM, "Could not post receive");
+    }
+
+    /* Match messages that are already pending */
+    na_inproc_unexpected_match(na_inproc_context->rx, na_inproc_context);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_msg_send_expected(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, const void *buf, na_size_t buf_size,
+    void NA_UNUSED *plugin_data, na_addr_t dest_addr, na_uint8_t dest_id,
+    na_tag_t tag, na_op_id_t *op_id)
+{
+    return na_inproc_msg_send(na_class, context, NA_CB_SEND_EXPECTED,
+        callback, arg, buf, buf_size, dest_addr, dest_id, tag, op_id);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_msg_recv_expected(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, void *buf, na_size_t buf_size,
+    void NA_UNUSED *plugin_data, na_addr_t source_addr,
+    na_uint8_t NA_UNUSED source_id, na_tag_t tag, na_op_id_t *op_id)
+{
+    struct na_inproc_endpoint *endpoint = NA_INPROC_CLASS(na_class)->endpoint;
+    struct na_inproc_endpoint *source =
+        (struct na_inproc_endpoint *) source_addr;
+    struct na_inproc_op_id *na_inproc_op_id = NULL;
+    struct na_inproc_msg *msg;
+    na_return_t ret;
+
+    ret = na_inproc_op_get(na_class, context, NA_CB_RECV_EXPECTED, callback,
+        arg, op_id, &na_inproc_op_id);
+    NA_CHECK_NA_ERROR(done, ret, "Could not get op ID");
+    NA_STATS_POST(context, &na_inproc_op_id->completion_data,
+        NA_CB_RECV_EXPECTED, buf_size);
+    na_inproc_op_id->info.recv.buf = buf;
+    na_inproc_op_id->info.recv.buf_size = buf_size;
+    na_inproc_op_id->info.recv.actual_buf_size = 0;
+    na_inproc_op_id->info.recv.source = source;
+    na_inproc_op_id->info.recv.tag = tag;
+
+    /* Look for a message that arrived before the receive was posted */
+    hg_thread_spin_lock(&endpoint->lock);
+    HG_QUEUE_FOREACH(msg, &endpoint->expected_msg_queue, entry) {
+        if (msg->source == source && msg->tag == tag) {
+            HG_QUEUE_REMOVE(&endpoint->expected_msg_queue, msg, na_inproc_msg,
+                entry);
+            break;
+        }
+    }
+    if (!msg)
+        HG_QUEUE_PUSH_TAIL(&endpoint->expected_op_queue, na_inproc_op_id,
+            entry);
+    hg_thread_spin_unlock(&endpoint->lock);
+
+    if (msg) {
+        na_inproc_deliver(na_inproc_op_id, msg->source, msg->tag, msg->buf,
+            msg->buf_size, NA_INPROC_CONTEXT(context));
+        na_inproc_msg_free(NA_INPROC_CLASS(na_class)->msg_pool, msg);
+    }
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_mem_handle_create(na_class_t NA_UNUSED *na_class, void *buf,
+    na_size_t buf_size, unsigned long flags, na_mem_handle_t *mem_handle)
+{
+    struct na_inproc_mem_handle *na_inproc_mem_handle = NULL;
+    na_return_t ret = NA_SUCCESS;
+
+    na_inproc_mem_handle = (struct na_inproc_mem_handle *) malloc(
+        sizeof(struct na_inproc_mem_handle));
+    NA_CHECK_ERROR(na_inproc_mem_handle == NULL, done, ret, NA_NOMEM,
+        "Could not allocate NA inproc memory handle");
+    na_inproc_mem_handle->segment.address = (na_ptr_t) buf;
+    na_inproc_mem_handle->segment.size = buf_size;
+    na_inproc_mem_handle->segments = &na_inproc_mem_handle->segment;
+    na_inproc_mem_handle->segment_count = 1;
+    na_inproc_mem_handle->len = buf_size;
+    na_inproc_mem_handle->flags = flags;
+
+    *mem_handle = (na_mem_handle_t) na_inproc_mem_handle;
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_mem_handle_create_segments(na_class_t NA_UNUSED *na_class,
+    struct na_segment *segments, na_size_t segment_count,
+    unsigned long flags, na_mem_handle_t *mem_handle)
+{
+    struct na_inproc_mem_handle *na_inproc_mem_handle = NULL;
+    na_size_t i;
+    na_return_t ret = NA_SUCCESS;
+
+    NA_CHECK_ERROR(segment_count == 0, done, ret, NA_INVALID_ARG,
+        "NULL segment count");
+
+    na_inproc_mem_handle = (struct na_inproc_mem_handle *) malloc(
+        sizeof(struct na_inproc_mem_handle));
+    NA_CHECK_ERROR(na_inproc_mem_handle == NULL, done, ret, NA_NOMEM,
+        "Could not allocate NA inproc memory handle");
+    na_inproc_mem_handle->segments = (struct na_segment *) malloc(
+        segment_count * sizeof(struct na_segment));
+    if (!na_inproc_mem_handle->segments) {
+        free(na_inproc_mem_handle);
+        NA_GOTO_ERROR(done, ret, NA_NOMEM, "Could not allocate segments");
+    }
+    memcpy(na_inproc_mem_handle->segments, segments,
+        segment_count * sizeof(struct na_segment));
+    na_inproc_mem_handle->segment_count = segment_count;
+    na_inproc_mem_handle->len = 0;
+    for (i = 0; i < segment_count; i++)
+        na_inproc_mem_handle->len += segments[i].size;
+    na_inproc_mem_handle->flags = flags;
+
+    *mem_handle = (na_mem_handle_t) na_inproc_mem_handle;
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_mem_handle_free(na_class_t NA_UNUSED *na_class,
+    na_mem_handle_t mem_handle)
+{
+    struct na_inproc_mem_handle *na_inproc_mem_handle =
+        (struct na_inproc_mem_handle *) mem_handle;
+
+    if (na_inproc_mem_handle->segments != &na_inproc_mem_handle->segment)
+        free(na_inproc_mem_handle->segments);
+    free(na_inproc_mem_handle);
+
+    return NA_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static NA_INLINE na_size_t
+na_inproc_mem_handle_get_serialize_size(na_class_t NA_UNUSED *na_class,
+    na_mem_handle_t mem_handle)
+{
+    struct na_inproc_mem_handle *na_inproc_mem_handle =
+        (struct na_inproc_mem_handle *) mem_handle;
+
+    return sizeof(na_size_t) + sizeof(unsigned long)
+        + na_inproc_mem_handle->segment_count * sizeof(struct na_segment);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_mem_handle_serialize(na_class_t *na_class, void *buf,
+    na_size_t buf_size, na_mem_handle_t mem_handle)
+{
+    struct na_inproc_mem_handle *na_inproc_mem_handle =
+        (struct na_inproc_mem_handle *) mem_handle;
+    char *buf_ptr = (char *) buf;
+    na_return_t ret = NA_SUCCESS;
+
+    NA_CHECK_ERROR(buf_size < na_inproc_mem_handle_get_serialize_size(
+        na_class, mem_handle), done, ret, NA_OVERFLOW,
+        "Buffer size too small for serializing handle");
+
+    /* Number of segments */
+    memcpy(buf_ptr, &na_inproc_mem_handle->segment_count, sizeof(na_size_t));
+    buf_ptr += sizeof(na_size_t);
+
+    /* Flags */
+    memcpy(buf_ptr, &na_inproc_mem_handle->flags, sizeof(unsigned long));
+    buf_ptr += sizeof(unsigned long);
+
+    /* Segments, addresses are valid in the whole process */
+    memcpy(buf_ptr, na_inproc_mem_handle->segments,
+        na_inproc_mem_handle->segment_count * sizeof(struct na_segment));
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_mem_handle_deserialize(na_class_t NA_UNUSED *na_class,
+    na_mem_handle_t *mem_handle, const void *buf, na_size_t buf_size)
+{
+    struct na_inproc_mem_handle *na_inproc_mem_handle = NULL;
+    const char *buf_ptr = (const char *) buf;
+    na_size_t segment_count, i;
+    na_return_t ret = NA_SUCCESS;
+
+    NA_CHECK_ERROR(buf_size < sizeof(na_size_t) + sizeof(unsigned long),
+        done, ret, NA_OVERFLOW,
+        "Buffer size too small for deserializing handle");
+
+    /* Number of segments */
+    memcpy(&segment_count, buf_ptr, sizeof(na_size_t));
+    buf_ptr += sizeof(na_size_t);
+    NA_CHECK_ERROR(segment_count == 0, done, ret, NA_INVALID_ARG,
+        "NULL segment count");
+    NA_CHECK_ERROR(buf_size < sizeof(na_size_t) + sizeof(unsigned long)
+        + segment_count * sizeof(struct na_segment), done, ret, NA_OVERFLOW,
+        "Buffer size too small for deserializing handle");
+
+    na_inproc_mem_handle = (struct na_inproc_mem_handle *) malloc(
+        sizeof(struct na_inproc_mem_handle));
+    NA_CHECK_ERROR(na_inproc_mem_handle == NULL, done, ret, NA_NOMEM,
+        "Could not allocate NA inproc memory handle");
+    if (segment_count == 1)
+        na_inproc_mem_handle->segments = &na_inproc_mem_handle->segment;
+    else {
+        na_inproc_mem_handle->segments = (struct na_segment *) malloc(
+            segment_count * sizeof(struct na_segment));
+        if (!na_inproc_mem_handle->segments) {
+            free(na_inproc_mem_handle);
+            NA_GOTO_ERROR(done, ret, NA_NOMEM,
+                "Could not allocate segments");
+        }
+    }
+    na_inproc_mem_handle->segment_count = segment_count;
+
+    /* Flags */
+    memcpy(&na_inproc_mem_handle->flags, buf_ptr, sizeof(unsigned long));
+    buf_ptr += sizeof(unsigned long);
+
+    /* Segments */
+    memcpy(na_inproc_mem_handle->segments, buf_ptr,
+        segment_count * sizeof(struct na_segment));
+    na_inproc_mem_handle->len = 0;
+    for (i = 0; i < segment_count; i++)
+        na_inproc_mem_handle->len += na_inproc_mem_handle->segments[i].size;
+
+    *mem_handle = (na_mem_handle_t) na_inproc_mem_handle;
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_put(na_class_t *na_class, na_context_t *context, na_cb_t callback,
+    void *arg, na_mem_handle_t local_mem_handle, na_offset_t local_offset,
+    na_mem_handle_t remote_mem_handle, na_offset_t remote_offset,
+    na_size_t length, na_addr_t NA_UNUSED remote_addr,
+    na_uint8_t NA_UNUSED remote_id, na_op_id_t *op_id)
+{
+    struct na_inproc_mem_handle *na_inproc_mem_handle_remote =
+        (struct na_inproc_mem_handle *) remote_mem_handle;
+    struct na_inproc_op_id *na_inproc_op_id = NULL;
+    na_return_t ret;
+
+    NA_CHECK_ERROR(na_inproc_mem_handle_remote->flags == NA_MEM_READ_ONLY,
+        done, ret, NA_PERMISSION,
+        "Registered memory requires write permission");
+
+    ret = na_inproc_op_get(na_class, context, NA_CB_PUT, callback, arg, op_id,
+        &na_inproc_op_id);
+    NA_CHECK_NA_ERROR(done, ret, "Could not get op ID");
+    NA_STATS_POST(context, &na_inproc_op_id->completion_data,
+        NA_CB_PUT, length);
+
+    /* Remote memory is in the same address space */
+    ret = na_inproc_mem_copy(na_inproc_mem_handle_remote, remote_offset,
+        (struct na_inproc_mem_handle *) local_mem_handle, local_offset,
+        length);
+    NA_CHECK_NA_ERROR(error, ret, "Could not copy memory");
+
+    ret = na_inproc_complete(na_inproc_op_id, NA_SUCCESS);
+    NA_CHECK_NA_ERROR(done, ret, "Could not complete operation");
+
+done:
+    return ret;
+
+error:
+    na_inproc_op_destroy(na_class, (na_op_id_t) na_inproc_op_id);
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_get(na_class_t *na_class, na_context_t *context, na_cb_t callback,
+    void *arg, na_mem_handle_t local_mem_handle, na_offset_t local_offset,
+    na_mem_handle_t remote_mem_handle, na_offset_t remote_offset,
+    na_size_t length, na_addr_t NA_UNUSED remote_addr,
+    na_uint8_t NA_UNUSED remote_id, na_op_id_t *op_id)
+{
+    struct na_inproc_mem_handle *na_inproc_mem_handle_remote =
+        (struct na_inproc_mem_handle *) remote_mem_handle;
+    struct na_inproc_op_id *na_inproc_op_id = NULL;
+    na_return_t ret;
+
+    NA_CHECK_ERROR(na_inproc_mem_handle_remote->flags == NA_MEM_WRITE_ONLY,
+        done, ret, NA_PERMISSION,
+        "Registered memory requires read permission");
+
+    ret = na_inproc_op_get(na_class, context, NA_CB_GET, callback, arg, op_id,
+        &na_inproc_op_id);
+    NA_CHECK_NA_ERROR(done, ret, "Could not get op ID");
+    NA_STATS_POST(context, &na_inproc_op_id->completion_data,
+        NA_CB_GET, length);
+
+    /* Remote memory is in the same address space */
+    ret = na_inproc_mem_copy((struct na_inproc_mem_handle *) local_mem_handle,
+        local_offset, na_inproc_mem_handle_remote, remote_offset, length);
+    NA_CHECK_NA_ERROR(error, ret, "Could not copy memory");
+
+    ret = na_inproc_complete(na_inproc_op_id, NA_SUCCESS);
+    NA_CHECK_NA_ERROR(done, ret, "Could not complete operation");
+
+done:
+    return ret;
+
+error:
+    na_inproc_op_destroy(na_class, (na_op_id_t) na_inproc_op_id);
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static NA_INLINE int
+na_inproc_poll_get_fd(na_class_t NA_UNUSED *na_class, na_context_t *context)
+{
+    int fd;
+
+    fd = hg_poll_get_fd(NA_INPROC_CONTEXT(context)->poll_set);
+    NA_CHECK_ERROR_NORET(fd == HG_UTIL_FAIL, done,
+        "Could not get poll fd from poll set");
+
+done:
+    return fd;
+}
+
+/*---------------------------------------------------------------------------*/
+static NA_INLINE na_bool_t
+na_inproc_poll_try_wait(na_class_t NA_UNUSED *na_class, na_context_t *context)
+{
+    struct na_inproc_rx *rx = NA_INPROC_CONTEXT(context)->rx;
+
+    /* Pending messages can be matched with posted receives */
+    return (hg_atomic_queue_chain_is_empty(rx->unexpected_msg_queue)
+        || hg_atomic_queue_chain_is_empty(rx->unexpected_op_queue)) ?
+        NA_TRUE : NA_FALSE;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_poll_register(na_class_t NA_UNUSED *na_class, na_context_t *context,
+    struct hg_poll_set *poll_set)
+{
+    struct na_inproc_context *na_inproc_context = NA_INPROC_CONTEXT(context);
+    na_return_t ret = NA_SUCCESS;
+
+    NA_CHECK_ERROR(hg_poll_add(poll_set, na_inproc_context->notify, HG_POLLIN,
+        na_inproc_progress_cb, na_inproc_context) != HG_UTIL_SUCCESS, done,
+        ret, NA_PROTOCOL_ERROR, "hg_poll_add() failed");
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_poll_deregister(na_class_t NA_UNUSED *na_class,
+    na_context_t *context, struct hg_poll_set *poll_set)
+{
+    na_return_t ret = NA_SUCCESS;
+
+    NA_CHECK_ERROR(hg_poll_remove(poll_set, NA_INPROC_CONTEXT(context)->notify)
+        != HG_UTIL_SUCCESS, done, ret, NA_PROTOCOL_ERROR,
+        "hg_poll_remove() failed");
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_progress(na_class_t NA_UNUSED *na_class, na_context_t *context,
+    unsigned int timeout)
+{
+    struct na_inproc_context *na_inproc_context = NA_INPROC_CONTEXT(context);
+    double remaining = timeout / 1000.0; /* Convert timeout in ms into seconds */
+    na_return_t ret = NA_TIMEOUT;
+
+    do {
+        hg_time_ticks_t t1, t2;
+        hg_util_bool_t progressed = HG_UTIL_FALSE;
+
+        /* Match messages that were not matched by senders */
+        if (na_inproc_unexpected_match(na_inproc_context->rx,
+            na_inproc_context)) {
+            ret = NA_SUCCESS;
+            break;
+        }
+
+        if (timeout)
+            t1 = hg_time_get_ticks();
+
+        NA_CHECK_ERROR(hg_poll_wait(na_inproc_context->poll_set,
+            (unsigned int) (remaining * 1000.0), &progressed)
+            != HG_UTIL_SUCCESS, done, ret, NA_PROTOCOL_ERROR,
+            "hg_poll_wait() failed");
+
+        /* We progressed, return success */
+        if (progressed) {
+            ret = NA_SUCCESS;
+            break;
+        }
+
+        if (timeout) {
+            t2 = hg_time_get_ticks();
+            remaining -= hg_time_ticks_to_double(t2 - t1);
+        }
+    } while ((int) (remaining * 1000.0) > 0);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_inproc_cancel(na_class_t *na_class, na_context_t *context,
+    na_op_id_t op_id)
+{
+    struct na_inproc_op_id *na_inproc_op_id =
+        (struct na_inproc_op_id *) op_id;
+    na_return_t ret = NA_SUCCESS;
+
+    switch (na_inproc_op_id->completion_data.callback_info.type) {
+        case NA_CB_RECV_UNEXPECTED:
+            /* Claim receive, fails if it was already matched */
+            if (!hg_atomic_cas32(&na_inproc_op_id->completed, NA_FALSE,
+                NA_TRUE))
+                break;
+
+            /* Release queue reference so that the op ID can be re-used */
+            na_inproc_unexpected_purge(NA_INPROC_CONTEXT(context)->rx);
+
+            ret = na_inproc_complete(na_inproc_op_id, NA_CANCELED);
+            NA_CHECK_NA_ERROR(done, ret, "Could not complete operation");
+            break;
+        case NA_CB_RECV_EXPECTED: {
+            struct na_inproc_endpoint *endpoint =
+                NA_INPROC_CLASS(na_class)->endpoint;
+            struct na_inproc_op_id *na_inproc_var_op_id;
+
+            hg_thread_spin_lock(&endpoint->lock);
+            HG_QUEUE_FOREACH(na_inproc_var_op_id,
+                &endpoint->expected_op_queue, entry) {
+                if (na_inproc_var_op_id == na_inproc_op_id) {
+                    HG_QUEUE_REMOVE(&endpoint->expected_op_queue,
+                        na_inproc_op_id, na_inproc_op_id, entry);
+                    break;
+                }
+            }
+            hg_thread_spin_unlock(&endpoint->lock);
+
+            /* Not found if it was already matched */
+            if (na_inproc_var_op_id) {
+                ret = na_inproc_complete(na_inproc_op_id, NA_CANCELED);
+                NA_CHECK_NA_ERROR(done, ret, "Could not complete operation");
+            }
+            break;
+        }
+        case NA_CB_LOOKUP:
+        case NA_CB_SEND_UNEXPECTED:
+        case NA_CB_SEND_EXPECTED:
+        case NA_CB_PUT:
+        case NA_CB_GET:
+            /* Completed immediately */
+            break;
+        default:
+            NA_GOTO_ERROR(done, ret, NA_INVALID_ARG,
+                "Operation type %d not supported",
+                na_inproc_op_id->completion_data.callback_info.type);
+    }
+
+done:
+    return ret;
+}
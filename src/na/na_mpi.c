@@ -569,6 +569,7 @@ const struct na_class_ops NA_PLUGIN_OPS(mpi) = {
         NULL,                                 /* context_destroy */
         na_mpi_op_create,                     /* op_create */
         na_mpi_op_destroy,                    /* op_destroy */
+        NULL,                                 /* op_reset */
         na_mpi_addr_lookup,                   /* addr_lookup */
         NULL,                                 /* addr_lookup2 */
         na_mpi_addr_free,                     /* addr_free */
@@ -608,8 +609,14 @@ const struct na_class_ops NA_PLUGIN_OPS(mpi) = {
         na_mpi_get,                           /* get */
         NULL,                                 /* poll_get_fd */
         NULL,                                 /* poll_try_wait */
+        NULL,                                 /* poll_register */
+        NULL,                                 /* poll_deregister */
         na_mpi_progress,                      /* progress */
-        na_mpi_cancel                         /* cancel */
+        na_mpi_cancel,                        /* cancel */
+        NULL,                                 /* submit */
+        NULL,                                 /* msg_loan_release */
+        NULL,                                 /* mem_alloc */
+        NULL                                  /* mem_free */
 };
 
 static MPI_Comm na_mpi_init_comm_g = MPI_COMM_NULL; /* MPI comm used at init */
@@ -1298,6 +1305,7 @@ na_mpi_addr_lookup(na_class_t *na_class, na_context_t *context,
     na_mpi_op_id->type = NA_CB_LOOKUP;
     na_mpi_op_id->callback = callback;
     na_mpi_op_id->arg = arg;
+    NA_STATS_POST(context, &na_mpi_op_id->completion_data, NA_CB_LOOKUP, 0);
     hg_atomic_set32(&na_mpi_op_id->completed, 0);
     na_mpi_op_id->canceled = NA_FALSE;
 
@@ -1564,6 +1572,8 @@ na_mpi_msg_send_unexpected(na_class_t *na_class, na_context_t *context,
     na_mpi_op_id->type = NA_CB_SEND_UNEXPECTED;
     na_mpi_op_id->callback = callback;
     na_mpi_op_id->arg = arg;
+    NA_STATS_POST(context, &na_mpi_op_id->completion_data,
+        NA_CB_SEND_UNEXPECTED, buf_size);
     hg_atomic_set32(&na_mpi_op_id->completed, 0);
     na_mpi_op_id->canceled = NA_FALSE;
     na_mpi_op_id->info.send_unexpected.data_request = MPI_REQUEST_NULL;
@@ -1606,6 +1616,8 @@ na_mpi_msg_recv_unexpected(na_class_t *na_class, na_context_t *context,
     na_mpi_op_id->type = NA_CB_RECV_UNEXPECTED;
     na_mpi_op_id->callback = callback;
     na_mpi_op_id->arg = arg;
+    NA_STATS_POST(context, &na_mpi_op_id->completion_data,
+        NA_CB_RECV_UNEXPECTED, buf_size);
     hg_atomic_set32(&na_mpi_op_id->completed, 0);
     na_mpi_op_id->canceled = NA_FALSE;
     na_mpi_op_id->info.recv_unexpected.buf = buf;
@@ -1660,6 +1672,8 @@ na_mpi_msg_send_expected(na_class_t *na_class, na_context_t *context,
     na_mpi_op_id->type = NA_CB_SEND_EXPECTED;
     na_mpi_op_id->callback = callback;
     na_mpi_op_id->arg = arg;
+    NA_STATS_POST(context, &na_mpi_op_id->completion_data,
+        NA_CB_SEND_EXPECTED, buf_size);
     hg_atomic_set32(&na_mpi_op_id->completed, 0);
     na_mpi_op_id->canceled = NA_FALSE;
     na_mpi_op_id->info.send_expected.data_request = MPI_REQUEST_NULL;
@@ -1707,6 +1721,8 @@ na_mpi_msg_recv_expected(na_class_t *na_class, na_context_t *context,
     na_mpi_op_id->type = NA_CB_RECV_EXPECTED;
     na_mpi_op_id->callback = callback;
     na_mpi_op_id->arg = arg;
+    NA_STATS_POST(context, &na_mpi_op_id->completion_data,
+        NA_CB_RECV_EXPECTED, buf_size);
     hg_atomic_set32(&na_mpi_op_id->completed, 0);
     na_mpi_op_id->canceled = NA_FALSE;
     na_mpi_op_id->info.recv_expected.buf_size = mpi_buf_size;
@@ -1895,6 +1911,7 @@ na_mpi_put(na_class_t *na_class, na_context_t *context, na_cb_t callback,
     na_mpi_op_id->type = NA_CB_PUT;
     na_mpi_op_id->callback = callback;
     na_mpi_op_id->arg = arg;
+    NA_STATS_POST(context, &na_mpi_op_id->completion_data, NA_CB_PUT, length);
     hg_atomic_set32(&na_mpi_op_id->completed, 0);
     na_mpi_op_id->canceled = NA_FALSE;
     na_mpi_op_id->info.put.rma_request = MPI_REQUEST_NULL;
@@ -1993,6 +2010,7 @@ na_mpi_get(na_class_t *na_class, na_context_t *context, na_cb_t callback,
     na_mpi_op_id->type = NA_CB_GET;
     na_mpi_op_id->callback = callback;
     na_mpi_op_id->arg = arg;
+    NA_STATS_POST(context, &na_mpi_op_id->completion_data, NA_CB_GET, length);
     hg_atomic_set32(&na_mpi_op_id->completed, 0);
     na_mpi_op_id->canceled = NA_FALSE;
     na_mpi_op_id->info.get.rma_request = MPI_REQUEST_NULL;
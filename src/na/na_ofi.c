@@ -50,10 +50,10 @@
 
 #include "mercury_list.h"
 #include "mercury_thread_spin.h"
-#include "mercury_thread_rwlock.h"
-#include "mercury_hash_table.h"
+#include "mercury_hash_map.h"
 #include "mercury_time.h"
 #include "mercury_mem.h"
+#include "mercury_mem_pool.h"
 
 #include <rdma/fabric.h>
 #include <rdma/fi_domain.h>
@@ -322,6 +322,7 @@ struct na_ofi_op_id {
         struct na_ofi_info_recv_expected recv_expected;
     } info;                                 /* Op info                  */
     struct fi_context fi_ctx;               /* Context handle           */
+    na_class_t *na_class;                   /* NA class associated      */
     na_context_t *context;                  /* NA context associated    */
     struct na_ofi_addr *addr;               /* Address associated       */
     HG_QUEUE_ENTRY(na_ofi_op_id) entry;     /* Entry in queue           */
@@ -359,7 +360,6 @@ struct na_ofi_endpoint {
 /* Domain */
 struct na_ofi_domain {
     hg_thread_mutex_t mutex;                /* Mutex for AV etc         */
-    hg_thread_rwlock_t rwlock;              /* RW lock for addr_ht      */
     HG_LIST_ENTRY(na_ofi_domain) entry;     /* Entry in domain list     */
 #ifdef NA_OFI_HAS_EXT_GNI_H
     struct fi_gni_auth_key fi_gni_auth_key; /* GNI auth key             */
@@ -370,7 +370,7 @@ struct na_ofi_domain {
     struct fid_mr *fi_mr;                   /* Global MR handle         */
     na_uint64_t fi_mr_key;                  /* Global MR key            */
     struct fid_av *fi_av;                   /* Address vector handle    */
-    hg_hash_table_t *addr_ht;               /* Address hash_table       */
+    hg_hash_map_t *addr_ht;                 /* Address hash map         */
     char *prov_name;                        /* Provider name            */
     enum na_ofi_prov_type prov_type;        /* Provider type            */
     hg_atomic_int32_t refcount;             /* Refcount of this domain  */
@@ -404,6 +404,7 @@ struct na_ofi_class {
     struct na_ofi_domain *domain;           /* Domain pointer           */
     struct na_ofi_endpoint *endpoint;       /* Endpoint pointer         */
     hg_thread_spin_t buf_pool_lock;         /* Buf pool lock            */
+    hg_mem_pool_t *op_id_pool;              /* Op ID pool               */
     na_uint8_t contexts;                    /* Number of context        */
     na_uint8_t max_contexts;                /* Max number of contexts   */
     na_bool_t listen;                       /* Listening flag           */
@@ -475,19 +476,6 @@ na_ofi_psm2_to_key(const struct na_ofi_psm2_addr *addr);
 static NA_INLINE na_uint64_t
 na_ofi_gni_to_key(const struct na_ofi_gni_addr *addr);
 
-/**
- * Key hash for hash table.
- */
-static NA_INLINE unsigned int
-na_ofi_addr_ht_key_hash(hg_hash_table_key_t vlocation);
-
-/**
- * Compare key.
- */
-static NA_INLINE int
-na_ofi_addr_ht_key_equal(hg_hash_table_key_t vlocation1,
-    hg_hash_table_key_t vlocation2);
-
 /**
  * Lookup the address in the hash-table. Insert it into the AV if it does not
  * already exist.
@@ -663,6 +651,12 @@ na_ofi_mem_pool_free(na_class_t *na_class, void *mem_ptr, struct fid_mr *mr_hdl)
 static NA_INLINE void
 na_ofi_op_id_addref(struct na_ofi_op_id *na_ofi_op_id);
 
+/**
+ * Initialize OP ID.
+ */
+static NA_INLINE void
+na_ofi_op_id_init(na_class_t *na_class, struct na_ofi_op_id *na_ofi_op_id);
+
 /**
  * Decrement refcount on OP ID.
  */
@@ -739,6 +733,26 @@ na_ofi_complete(struct na_ofi_op_id *na_ofi_op_id, na_return_t ret);
 static NA_INLINE void
 na_ofi_release(void *arg);
 
+/**
+ * Post RMA write, more_flag is either 0 or FI_MORE.
+ */
+static na_return_t
+na_ofi_rma_put(na_class_t *na_class, na_context_t *context, na_cb_t callback,
+    void *arg, na_mem_handle_t local_mem_handle, na_offset_t local_offset,
+    na_mem_handle_t remote_mem_handle, na_offset_t remote_offset,
+    na_size_t length, na_addr_t remote_addr, na_uint8_t remote_id,
+    na_op_id_t *op_id, uint64_t more_flag);
+
+/**
+ * Post RMA read, more_flag is either 0 or FI_MORE.
+ */
+static na_return_t
+na_ofi_rma_get(na_class_t *na_class, na_context_t *context, na_cb_t callback,
+    void *arg, na_mem_handle_t local_mem_handle, na_offset_t local_offset,
+    na_mem_handle_t remote_mem_handle, na_offset_t remote_offset,
+    na_size_t length, na_addr_t remote_addr, na_uint8_t remote_id,
+    na_op_id_t *op_id, uint64_t more_flag);
+
 /********************/
 /* Plugin callbacks */
 /********************/
@@ -772,6 +786,10 @@ na_ofi_op_create(na_class_t *na_class);
 static na_return_t
 na_ofi_op_destroy(na_class_t *na_class, na_op_id_t op_id);
 
+/* op_reset */
+static na_return_t
+na_ofi_op_reset(na_class_t *na_class, na_op_id_t op_id);
+
 /* addr_lookup */
 static na_return_t
 na_ofi_addr_lookup(na_class_t *na_class, na_context_t *context,
@@ -939,6 +957,11 @@ na_ofi_progress(na_class_t *na_class, na_context_t *context,
 static na_return_t
 na_ofi_cancel(na_class_t *na_class, na_context_t *context, na_op_id_t op_id);
 
+/* submit */
+static na_return_t
+na_ofi_submit(na_class_t *na_class, na_context_t *context,
+    const struct na_op_desc *op_descs, na_size_t count, na_size_t *posted);
+
 /*******************/
 /* Local Variables */
 /*******************/
@@ -953,6 +976,7 @@ const struct na_class_ops NA_PLUGIN_OPS(ofi) = {
     na_ofi_context_destroy,                 /* context_destroy */
     na_ofi_op_create,                       /* op_create */
     na_ofi_op_destroy,                      /* op_destroy */
+    na_ofi_op_reset,                        /* op_reset */
     na_ofi_addr_lookup,                     /* addr_lookup */
     na_ofi_addr_lookup2,                    /* addr_lookup2 */
     na_ofi_addr_free,                       /* addr_free */
@@ -992,8 +1016,14 @@ const struct na_class_ops NA_PLUGIN_OPS(ofi) = {
     na_ofi_get,                             /* get */
     na_ofi_poll_get_fd,                     /* poll_get_fd */
     na_ofi_poll_try_wait,                   /* poll_try_wait */
+    NULL,                                   /* poll_register */
+    NULL,                                   /* poll_deregister */
     na_ofi_progress,                        /* progress */
-    na_ofi_cancel                           /* cancel */
+    na_ofi_cancel,                          /* cancel */
+    na_ofi_submit,                          /* submit */
+    NULL,                                   /* msg_loan_release */
+    NULL,                                   /* mem_alloc */
+    NULL                                    /* mem_free */
 };
 
 /* OFI access domain list */
@@ -1238,35 +1268,13 @@ na_ofi_gni_to_key(const struct na_ofi_gni_addr *addr)
     return (((na_uint64_t) addr->device_addr) << 32 | addr->cdm_id);
 }
 
-/*---------------------------------------------------------------------------*/
-static NA_INLINE unsigned int
-na_ofi_addr_ht_key_hash(hg_hash_table_key_t vlocation)
-{
-    na_uint64_t key = *((na_uint64_t *) vlocation);
-    na_uint32_t hi, lo;
-
-    hi = (na_uint32_t) (key >> 32);
-    lo = (key & 0xFFFFFFFFU);
-
-    return ((hi & 0xFFFF0000U) | (lo & 0xFFFFU));
-}
-
-/*---------------------------------------------------------------------------*/
-static NA_INLINE int
-na_ofi_addr_ht_key_equal(hg_hash_table_key_t vlocation1,
-    hg_hash_table_key_t vlocation2)
-{
-    return *((na_uint64_t *) vlocation1) == *((na_uint64_t *) vlocation2);
-}
-
 /*---------------------------------------------------------------------------*/
 static na_return_t
 na_ofi_addr_ht_lookup(struct na_ofi_domain *domain, na_uint32_t addr_format,
     const void *addr, na_size_t addrlen, fi_addr_t *fi_addr,
     na_uint64_t *addr_key)
 {
-    hg_hash_table_key_t ht_key = addr_key;
-    hg_hash_table_value_t ht_value = NULL;
+    void *ht_value = NULL;
     na_return_t ret = NA_SUCCESS;
     int rc;
 
@@ -1276,12 +1284,10 @@ na_ofi_addr_ht_lookup(struct na_ofi_domain *domain, na_uint32_t addr_format,
         "Could not generate key from addr");
 
     /* Lookup key */
-    hg_thread_rwlock_rdlock(&domain->rwlock);
-    ht_value = hg_hash_table_lookup(domain->addr_ht, ht_key);
-    hg_thread_rwlock_release_rdlock(&domain->rwlock);
-    if (ht_value != HG_HASH_TABLE_NULL) {
+    if (hg_hash_map_lookup_int(domain->addr_ht, *addr_key, &ht_value)
+        == HG_UTIL_SUCCESS) {
         /* Found */
-        *fi_addr = *(fi_addr_t *) ht_value;
+        *fi_addr = (fi_addr_t) (hg_util_ptr_t) ht_value;
         goto out;
     }
 
@@ -1292,46 +1298,25 @@ na_ofi_addr_ht_lookup(struct na_ofi_domain *domain, na_uint32_t addr_format,
     NA_CHECK_ERROR(rc < 1, out, ret, NA_PROTOCOL_ERROR,
         "fi_av_insert() failed, rc: %d(%s)", rc, fi_strerror((int) -rc));
 
-    hg_thread_rwlock_wrlock(&domain->rwlock);
+    /* Insert new value */
+    rc = hg_hash_map_insert_int(domain->addr_ht, *addr_key,
+        (void *) (hg_util_ptr_t) *fi_addr, &ht_value);
+    NA_CHECK_ERROR(rc != HG_UTIL_SUCCESS, error, ret, NA_NOMEM,
+        "hg_hash_map_insert_int() failed");
 
-    ht_value = hg_hash_table_lookup(domain->addr_ht, ht_key);
-    if (ht_value != HG_HASH_TABLE_NULL) {
+    if ((fi_addr_t) (hg_util_ptr_t) ht_value != *fi_addr) {
         /* in race condition, use addr in HT and remove the new addr from AV */
         rc = fi_av_remove(domain->fi_av, fi_addr, 1, 0 /* flags */);
-        NA_CHECK_ERROR(rc != 0, unlock, ret, NA_PROTOCOL_ERROR,
+        NA_CHECK_ERROR(rc != 0, out, ret, NA_PROTOCOL_ERROR,
             "fi_av_remove() failed, rc: %d(%s)", rc, fi_strerror((int) -rc));
-        *fi_addr = *(fi_addr_t *) ht_value;
-        goto unlock;
+        *fi_addr = (fi_addr_t) (hg_util_ptr_t) ht_value;
     }
 
-    /* Allocate new key */
-    ht_key = malloc(sizeof(na_uint64_t));
-    NA_CHECK_ERROR(ht_key == NULL, error, ret, NA_NOMEM,
-        "Cannot allocate memory for ht_key");
-
-    /* Allocate new value */
-    ht_value = malloc(sizeof(*fi_addr));
-    NA_CHECK_ERROR(ht_value == NULL, error, ret, NA_NOMEM,
-        "cannot allocate memory for ht_key");
-
-    *((na_uint64_t *) ht_key) = *addr_key;
-    *((na_uint64_t *) ht_value) = *fi_addr;
-
-    /* Insert new value */
-    rc = hg_hash_table_insert(domain->addr_ht, ht_key, ht_value);
-    NA_CHECK_ERROR(rc == 0, error, ret, NA_NOMEM,
-        "hg_hash_table_insert() failed");
-
-unlock:
-    hg_thread_rwlock_release_wrlock(&domain->rwlock);
-
 out:
     return ret;
 
 error:
-    hg_thread_rwlock_release_wrlock(&domain->rwlock);
-    free(ht_key);
-    free(ht_value);
+    fi_av_remove(domain->fi_av, fi_addr, 1, 0 /* flags */);
     return ret;
 }
 
@@ -1343,17 +1328,15 @@ na_ofi_addr_ht_remove(struct na_ofi_domain *domain, fi_addr_t *fi_addr,
     na_return_t ret = NA_SUCCESS;
     int rc;
 
-    hg_thread_rwlock_wrlock(&domain->rwlock);
-    rc = hg_hash_table_remove(domain->addr_ht, (hg_hash_table_key_t) addr_key);
-    NA_CHECK_ERROR(rc != 1, unlock, ret, NA_NOENTRY,
-        "hg_hash_table_remove() failed");
+    rc = hg_hash_map_remove_int(domain->addr_ht, *addr_key, NULL);
+    NA_CHECK_ERROR(rc != HG_UTIL_SUCCESS, out, ret, NA_NOENTRY,
+        "hg_hash_map_remove_int() failed");
 
     rc = fi_av_remove(domain->fi_av, fi_addr, 1, 0 /* flags */);
-    NA_CHECK_ERROR(rc != 0, unlock, ret, NA_PROTOCOL_ERROR,
+    NA_CHECK_ERROR(rc != 0, out, ret, NA_PROTOCOL_ERROR,
         "fi_av_remove() failed, rc: %d(%s)", rc, fi_strerror((int) -rc));
 
-unlock:
-    hg_thread_rwlock_release_wrlock(&domain->rwlock);
+out:
     return ret;
 }
 
@@ -1692,11 +1675,6 @@ na_ofi_domain_open(struct na_ofi_class *priv, enum na_ofi_prov_type prov_type,
     NA_CHECK_ERROR(rc != HG_UTIL_SUCCESS, error, ret, NA_NOMEM,
         "hg_thread_mutex_init() failed");
 
-    /* Init rw lock */
-    rc = hg_thread_rwlock_init(&na_ofi_domain->rwlock);
-    NA_CHECK_ERROR(rc != HG_UTIL_SUCCESS, error, ret, NA_NOMEM,
-        "hg_thread_rwlock_init() failed");
-
     /* Keep fi_info */
     na_ofi_domain->fi_prov = fi_dupinfo(prov);
     NA_CHECK_ERROR(na_ofi_domain->fi_prov == NULL, error, ret,
@@ -1821,12 +1799,10 @@ na_ofi_domain_open(struct na_ofi_class *priv, enum na_ofi_prov_type prov_type,
     NA_CHECK_ERROR(rc != 0, error, ret, NA_PROTOCOL_ERROR,
         "fi_av_open() failed, rc: %d(%s)", rc, fi_strerror(-rc));
 
-    /* Create addr hash-table */
-    na_ofi_domain->addr_ht = hg_hash_table_new(na_ofi_addr_ht_key_hash,
-        na_ofi_addr_ht_key_equal);
-        NA_CHECK_ERROR(na_ofi_domain->addr_ht == NULL, error, ret,
-            NA_NOMEM, "hg_hash_table_new() failed");
-    hg_hash_table_register_free_functions(na_ofi_domain->addr_ht, free, free);
+    /* Create addr hash map */
+    na_ofi_domain->addr_ht = hg_hash_map_new_int();
+    NA_CHECK_ERROR(na_ofi_domain->addr_ht == NULL, error, ret,
+        NA_NOMEM, "hg_hash_map_new_int() failed");
 
     /* Insert to global domain list */
     hg_thread_mutex_lock(&na_ofi_domain_list_mutex_g);
@@ -1910,11 +1886,9 @@ na_ofi_domain_close(struct na_ofi_domain *na_ofi_domain)
         na_ofi_domain->fi_prov = NULL;
     }
 
-    if (na_ofi_domain->addr_ht)
-        hg_hash_table_free(na_ofi_domain->addr_ht);
+    hg_hash_map_free(na_ofi_domain->addr_ht, NULL);
 
     hg_thread_mutex_destroy(&na_ofi_domain->mutex);
-    hg_thread_rwlock_destroy(&na_ofi_domain->rwlock);
 
     free(na_ofi_domain->prov_name);
     free(na_ofi_domain);
@@ -2480,6 +2454,21 @@ na_ofi_op_id_addref(struct na_ofi_op_id *na_ofi_op_id)
     return;
 }
 
+/*---------------------------------------------------------------------------*/
+static NA_INLINE void
+na_ofi_op_id_init(na_class_t *na_class, struct na_ofi_op_id *na_ofi_op_id)
+{
+    memset(na_ofi_op_id, 0, sizeof(struct na_ofi_op_id));
+    na_ofi_op_id->na_class = na_class;
+    hg_atomic_init32(&na_ofi_op_id->refcount, 1);
+    /* Completed by default */
+    hg_atomic_init32(&na_ofi_op_id->status, NA_OFI_OP_COMPLETED);
+
+    /* Set op ID release callbacks */
+    na_ofi_op_id->completion_data.plugin_callback = na_ofi_release;
+    na_ofi_op_id->completion_data.plugin_callback_args = na_ofi_op_id;
+}
+
 /*---------------------------------------------------------------------------*/
 static NA_INLINE void
 na_ofi_op_id_decref(struct na_ofi_op_id *na_ofi_op_id)
@@ -2494,7 +2483,8 @@ na_ofi_op_id_decref(struct na_ofi_op_id *na_ofi_op_id)
         return;
 
     /* No more references, cleanup */
-    free(na_ofi_op_id);
+    hg_mem_pool_free(NA_OFI_CLASS(na_ofi_op_id->na_class)->op_id_pool,
+        na_ofi_op_id);
 
     return;
 }
@@ -3037,6 +3027,11 @@ na_ofi_initialize(na_class_t *na_class, const struct na_info *na_info,
     hg_thread_spin_init(&priv->buf_pool_lock);
     HG_QUEUE_INIT(&priv->buf_pool);
 
+    /* Create op ID pool */
+    priv->op_id_pool = hg_mem_pool_create(sizeof(struct na_ofi_op_id), 0, 0);
+    NA_CHECK_ERROR(priv->op_id_pool == NULL, out, ret, NA_NOMEM,
+        "Could not create op ID pool");
+
     /* Create domain */
     ret = na_ofi_domain_open(na_class->plugin_class, prov_type, domain_name_ptr,
         auth_key, &priv->domain);
@@ -3100,6 +3095,8 @@ na_ofi_finalize(na_class_t *na_class)
         priv->domain = NULL;
     }
 
+    hg_mem_pool_destroy(priv->op_id_pool);
+
     /* Close mutex / free private data */
     hg_thread_mutex_destroy(&priv->mutex);
     free(priv);
@@ -3278,20 +3275,15 @@ out:
 
 /*---------------------------------------------------------------------------*/
 static na_op_id_t
-na_ofi_op_create(na_class_t NA_UNUSED *na_class)
+na_ofi_op_create(na_class_t *na_class)
 {
     struct na_ofi_op_id *na_ofi_op_id = NULL;
 
-    na_ofi_op_id = (struct na_ofi_op_id *)calloc(1, sizeof(struct na_ofi_op_id));
+    na_ofi_op_id = (struct na_ofi_op_id *) hg_mem_pool_alloc(
+        NA_OFI_CLASS(na_class)->op_id_pool);
     NA_CHECK_ERROR_NORET(na_ofi_op_id == NULL, out,
         "Could not allocate NA OFI operation ID");
-    hg_atomic_init32(&na_ofi_op_id->refcount, 1);
-    /* Completed by default */
-    hg_atomic_init32(&na_ofi_op_id->status, NA_OFI_OP_COMPLETED);
-
-    /* Set op ID release callbacks */
-    na_ofi_op_id->completion_data.plugin_callback = na_ofi_release;
-    na_ofi_op_id->completion_data.plugin_callback_args = na_ofi_op_id;
+    na_ofi_op_id_init(na_class, na_ofi_op_id);
 
 out:
     return (na_op_id_t) na_ofi_op_id;
@@ -3308,6 +3300,21 @@ na_ofi_op_destroy(na_class_t NA_UNUSED *na_class, na_op_id_t op_id)
     return NA_SUCCESS;
 }
 
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_ofi_op_reset(na_class_t *na_class, na_op_id_t op_id)
+{
+    struct na_ofi_op_id *na_ofi_op_id = (struct na_ofi_op_id *) op_id;
+
+    if (hg_atomic_decr32(&na_ofi_op_id->refcount))
+        /* Still referenced, freed on release */
+        return NA_BUSY;
+
+    na_ofi_op_id_init(na_class, na_ofi_op_id);
+
+    return NA_SUCCESS;
+}
+
 /*---------------------------------------------------------------------------*/
 static na_return_t
 na_ofi_addr_lookup(na_class_t *na_class, na_context_t *context,
@@ -3328,6 +3335,7 @@ na_ofi_addr_lookup(na_class_t *na_class, na_context_t *context,
     na_ofi_op_id->completion_data.callback_info.type = NA_CB_LOOKUP;
     na_ofi_op_id->completion_data.callback = callback;
     na_ofi_op_id->completion_data.callback_info.arg = arg;
+    NA_STATS_POST(context, &na_ofi_op_id->completion_data, NA_CB_LOOKUP, 0);
     hg_atomic_set32(&na_ofi_op_id->status, 0);
 
     /* Lookup addr */
@@ -3772,6 +3780,8 @@ na_ofi_msg_send_unexpected(na_class_t NA_UNUSED *na_class,
     na_ofi_op_id->completion_data.callback_info.type = NA_CB_SEND_UNEXPECTED;
     na_ofi_op_id->completion_data.callback = callback;
     na_ofi_op_id->completion_data.callback_info.arg = arg;
+    NA_STATS_POST(context, &na_ofi_op_id->completion_data,
+        NA_CB_SEND_UNEXPECTED, buf_size);
     na_ofi_addr_addref(na_ofi_addr); /* decref in na_ofi_complete() */
     na_ofi_op_id->addr = na_ofi_addr;
     hg_atomic_set32(&na_ofi_op_id->status, 0);
@@ -3785,9 +3795,10 @@ na_ofi_msg_send_unexpected(na_class_t NA_UNUSED *na_class,
             &na_ofi_op_id->fi_ctx);
 //        if (rc == -FI_EAGAIN)
 //            NA_GOTO_DONE(error, ret, NA_AGAIN);
-        if (rc == -FI_EAGAIN)
+        if (rc == -FI_EAGAIN) {
+            NA_STATS_EVENT(context, NA_STATS_AGAIN);
             na_ofi_progress(na_class, context, 0);
-        else
+        } else
             break;
     } while (1);
     NA_CHECK_ERROR(rc != 0, error, ret, NA_PROTOCOL_ERROR,
@@ -3827,6 +3838,8 @@ na_ofi_msg_recv_unexpected(na_class_t NA_UNUSED *na_class,
     na_ofi_op_id->completion_data.callback_info.type = NA_CB_RECV_UNEXPECTED;
     na_ofi_op_id->completion_data.callback = callback;
     na_ofi_op_id->completion_data.callback_info.arg = arg;
+    NA_STATS_POST(context, &na_ofi_op_id->completion_data,
+        NA_CB_RECV_UNEXPECTED, buf_size);
     na_ofi_op_id->addr = NULL; /* Make sure the addr is reset */
     hg_atomic_set32(&na_ofi_op_id->status, 0);
     na_ofi_op_id->info.recv_unexpected.buf = buf;
@@ -3840,9 +3853,10 @@ na_ofi_msg_recv_unexpected(na_class_t NA_UNUSED *na_class,
             1 /* tag */, NA_OFI_UNEXPECTED_TAG_IGNORE, &na_ofi_op_id->fi_ctx);
 //        if (rc == -FI_EAGAIN)
 //            NA_GOTO_DONE(error, ret, NA_AGAIN);
-        if (rc == -FI_EAGAIN)
+        if (rc == -FI_EAGAIN) {
+            NA_STATS_EVENT(context, NA_STATS_AGAIN);
             na_ofi_progress(na_class, context, 0);
-        else
+        } else
             break;
     } while (1);
     NA_CHECK_ERROR(rc != 0, error, ret, NA_PROTOCOL_ERROR,
@@ -3885,6 +3899,8 @@ na_ofi_msg_send_expected(na_class_t NA_UNUSED *na_class, na_context_t *context,
     na_ofi_op_id->completion_data.callback_info.type = NA_CB_SEND_EXPECTED;
     na_ofi_op_id->completion_data.callback = callback;
     na_ofi_op_id->completion_data.callback_info.arg = arg;
+    NA_STATS_POST(context, &na_ofi_op_id->completion_data,
+        NA_CB_SEND_EXPECTED, buf_size);
     na_ofi_addr_addref(na_ofi_addr); /* decref in na_ofi_complete() */
     na_ofi_op_id->addr = na_ofi_addr;
     hg_atomic_set32(&na_ofi_op_id->status, 0);
@@ -3898,9 +3914,10 @@ na_ofi_msg_send_expected(na_class_t NA_UNUSED *na_class, na_context_t *context,
             NA_OFI_EXPECTED_TAG_FLAG | tag, &na_ofi_op_id->fi_ctx);
 //        if (rc == -FI_EAGAIN)
 //            NA_GOTO_DONE(error, ret, NA_AGAIN);
-        if (rc == -FI_EAGAIN)
+        if (rc == -FI_EAGAIN) {
+            NA_STATS_EVENT(context, NA_STATS_AGAIN);
             na_ofi_progress(na_class, context, 0);
-        else
+        } else
             break;
     } while (1);
     NA_CHECK_ERROR(rc != 0, error, ret, NA_PROTOCOL_ERROR,
@@ -3943,6 +3960,8 @@ na_ofi_msg_recv_expected(na_class_t NA_UNUSED *na_class, na_context_t *context,
     na_ofi_op_id->completion_data.callback_info.type = NA_CB_RECV_EXPECTED;
     na_ofi_op_id->completion_data.callback = callback;
     na_ofi_op_id->completion_data.callback_info.arg = arg;
+    NA_STATS_POST(context, &na_ofi_op_id->completion_data,
+        NA_CB_RECV_EXPECTED, buf_size);
     hg_atomic_set32(&na_ofi_op_id->status, 0);
     na_ofi_addr_addref(na_ofi_addr); /* decref in na_ofi_complete() */
     na_ofi_op_id->addr = na_ofi_addr;
@@ -3959,9 +3978,10 @@ na_ofi_msg_recv_expected(na_class_t NA_UNUSED *na_class, na_context_t *context,
             NA_OFI_EXPECTED_TAG_FLAG | tag, 0 /* ignore */, &na_ofi_op_id->fi_ctx);
 //        if (rc == -FI_EAGAIN)
 //            NA_GOTO_DONE(error, ret, NA_AGAIN);
-        if (rc == -FI_EAGAIN)
+        if (rc == -FI_EAGAIN) {
+            NA_STATS_EVENT(context, NA_STATS_AGAIN);
             na_ofi_progress(na_class, context, 0);
-        else
+        } else
             break;
     } while (1);
     NA_CHECK_ERROR(rc != 0, error, ret, NA_PROTOCOL_ERROR,
@@ -4142,11 +4162,24 @@ out:
 
 /*---------------------------------------------------------------------------*/
 static na_return_t
-na_ofi_put(na_class_t NA_UNUSED *na_class, na_context_t *context,
+na_ofi_put(na_class_t *na_class, na_context_t *context,
     na_cb_t callback, void *arg, na_mem_handle_t local_mem_handle,
     na_offset_t local_offset, na_mem_handle_t remote_mem_handle,
     na_offset_t remote_offset, na_size_t length, na_addr_t remote_addr,
     na_uint8_t remote_id, na_op_id_t *op_id)
+{
+    return na_ofi_rma_put(na_class, context, callback, arg, local_mem_handle,
+        local_offset, remote_mem_handle, remote_offset, length, remote_addr,
+        remote_id, op_id, 0);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_ofi_rma_put(na_class_t NA_UNUSED *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, na_mem_handle_t local_mem_handle,
+    na_offset_t local_offset, na_mem_handle_t remote_mem_handle,
+    na_offset_t remote_offset, na_size_t length, na_addr_t remote_addr,
+    na_uint8_t remote_id, na_op_id_t *op_id, uint64_t more_flag)
 {
     struct na_ofi_context *ctx = NA_OFI_CONTEXT(context);
     struct fid_ep *ep_hdl = ctx->fi_tx;
@@ -4190,6 +4223,7 @@ na_ofi_put(na_class_t NA_UNUSED *na_class, na_context_t *context,
     na_ofi_op_id->completion_data.callback_info.type = NA_CB_PUT;
     na_ofi_op_id->completion_data.callback = callback;
     na_ofi_op_id->completion_data.callback_info.arg = arg;
+    NA_STATS_POST(context, &na_ofi_op_id->completion_data, NA_CB_PUT, length);
     hg_atomic_set32(&na_ofi_op_id->status, 0);
     na_ofi_addr_addref(na_ofi_addr); /* for na_ofi_complete() */
     na_ofi_op_id->addr = na_ofi_addr;
@@ -4201,12 +4235,14 @@ na_ofi_put(na_class_t NA_UNUSED *na_class, na_context_t *context,
      * For writes, FI_DELIVERY_COMPLETE guarantees that the operation
      * has been processed by the destination */
     do {
-        rc = fi_writemsg(ep_hdl, &msg_rma, FI_COMPLETION | FI_DELIVERY_COMPLETE);
+        rc = fi_writemsg(ep_hdl, &msg_rma,
+            FI_COMPLETION | FI_DELIVERY_COMPLETE | more_flag);
 //        if (rc == -FI_EAGAIN)
 //            NA_GOTO_DONE(error, ret, NA_AGAIN);
-        if (rc == -FI_EAGAIN)
+        if (rc == -FI_EAGAIN) {
+            NA_STATS_EVENT(context, NA_STATS_AGAIN);
             na_ofi_progress(na_class, context, 0);
-        else
+        } else
             break;
     } while (1);
     NA_CHECK_ERROR(rc != 0, error, ret, NA_PROTOCOL_ERROR,
@@ -4224,11 +4260,24 @@ error:
 
 /*---------------------------------------------------------------------------*/
 static na_return_t
-na_ofi_get(na_class_t NA_UNUSED *na_class, na_context_t *context,
+na_ofi_get(na_class_t *na_class, na_context_t *context,
     na_cb_t callback, void *arg, na_mem_handle_t local_mem_handle,
     na_offset_t local_offset, na_mem_handle_t remote_mem_handle,
     na_offset_t remote_offset, na_size_t length, na_addr_t remote_addr,
     na_uint8_t remote_id, na_op_id_t *op_id)
+{
+    return na_ofi_rma_get(na_class, context, callback, arg, local_mem_handle,
+        local_offset, remote_mem_handle, remote_offset, length, remote_addr,
+        remote_id, op_id, 0);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_ofi_rma_get(na_class_t NA_UNUSED *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, na_mem_handle_t local_mem_handle,
+    na_offset_t local_offset, na_mem_handle_t remote_mem_handle,
+    na_offset_t remote_offset, na_size_t length, na_addr_t remote_addr,
+    na_uint8_t remote_id, na_op_id_t *op_id, uint64_t more_flag)
 {
     struct na_ofi_context *ctx = NA_OFI_CONTEXT(context);
     struct fid_ep *ep_hdl = ctx->fi_tx;
@@ -4272,6 +4321,7 @@ na_ofi_get(na_class_t NA_UNUSED *na_class, na_context_t *context,
     na_ofi_op_id->completion_data.callback_info.type = NA_CB_GET;
     na_ofi_op_id->completion_data.callback = callback;
     na_ofi_op_id->completion_data.callback_info.arg = arg;
+    NA_STATS_POST(context, &na_ofi_op_id->completion_data, NA_CB_GET, length);
     hg_atomic_set32(&na_ofi_op_id->status, 0);
     na_ofi_addr_addref(na_ofi_addr); /* for na_ofi_complete() */
     na_ofi_op_id->addr = na_ofi_addr;
@@ -4281,12 +4331,13 @@ na_ofi_get(na_class_t NA_UNUSED *na_class, na_context_t *context,
 
     /* Post the OFI RMA read */
     do {
-        rc = fi_readmsg(ep_hdl, &msg_rma, FI_COMPLETION);
+        rc = fi_readmsg(ep_hdl, &msg_rma, FI_COMPLETION | more_flag);
 //        if (rc == -FI_EAGAIN)
 //            NA_GOTO_DONE(error, ret, NA_AGAIN);
-        if (rc == -FI_EAGAIN)
+        if (rc == -FI_EAGAIN) {
+            NA_STATS_EVENT(context, NA_STATS_AGAIN);
             na_ofi_progress(na_class, context, 0);
-        else
+        } else
             break;
     } while (1);
     NA_CHECK_ERROR(rc != 0, error, ret, NA_PROTOCOL_ERROR,
@@ -4372,12 +4423,12 @@ na_ofi_progress(na_class_t *na_class, na_context_t *context,
         void *src_err_addr_ptr = src_err_addr;
         size_t src_err_addrlen = NA_OFI_CQ_MAX_ERR_DATA_SIZE;
         size_t i, actual_count = 0;
-        hg_time_t t1, t2;
+        hg_time_ticks_t t1, t2;
 
         if (timeout) {
             struct fid_wait *wait_hdl = NA_OFI_CONTEXT(context)->fi_wait;
 
-            hg_time_get_current(&t1);
+            t1 = hg_time_get_ticks();
 
             if (wait_hdl) {
                 /* Wait in wait set if provider does not support wait on FDs */
@@ -4401,8 +4452,8 @@ na_ofi_progress(na_class_t *na_class, na_context_t *context,
             "Could not read events from context CQ");
 
         if (timeout) {
-            hg_time_get_current(&t2);
-            remaining -= hg_time_to_double(hg_time_subtract(t2, t1));
+            t2 = hg_time_get_ticks();
+            remaining -= hg_time_ticks_to_double(t2 - t1);
         }
 
         if (actual_count == 0) {
@@ -4411,6 +4462,8 @@ na_ofi_progress(na_class_t *na_class, na_context_t *context,
                 break;
             continue;
         }
+        if (actual_count == NA_OFI_CQ_EVENT_NUM)
+            NA_STATS_EVENT(context, NA_STATS_CQ_FULL);
         /* Got at least one completion event */
         assert(actual_count > 0);
 
@@ -4485,3 +4538,79 @@ na_ofi_cancel(na_class_t *na_class, na_context_t *context,
 out:
     return ret;
 }
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_ofi_submit(na_class_t *na_class, na_context_t *context,
+    const struct na_op_desc *op_descs, na_size_t count, na_size_t *posted)
+{
+    na_return_t ret = NA_SUCCESS;
+    na_size_t i;
+
+    for (i = 0; i < count; i++) {
+        const struct na_op_desc *desc = &op_descs[i];
+        /* Let the provider defer RMA doorbells while more RMA operations
+         * follow, the last one of a run is always posted without FI_MORE */
+        uint64_t more_flag = (i + 1 < count
+            && (op_descs[i + 1].type == NA_CB_PUT
+                || op_descs[i + 1].type == NA_CB_GET)) ? FI_MORE : 0;
+
+        switch (desc->type) {
+            case NA_CB_SEND_UNEXPECTED:
+                ret = na_ofi_msg_send_unexpected(na_class, context,
+                    desc->callback, desc->arg, desc->info.msg.buf,
+                    desc->info.msg.buf_size, desc->info.msg.plugin_data,
+                    desc->info.msg.addr, desc->info.msg.id,
+                    desc->info.msg.tag, desc->op_id);
+                break;
+            case NA_CB_RECV_UNEXPECTED:
+                ret = na_ofi_msg_recv_unexpected(na_class, context,
+                    desc->callback, desc->arg, desc->info.msg.buf,
+                    desc->info.msg.buf_size, desc->info.msg.plugin_data,
+                    desc->op_id);
+                break;
+            case NA_CB_SEND_EXPECTED:
+                ret = na_ofi_msg_send_expected(na_class, context,
+                    desc->callback, desc->arg, desc->info.msg.buf,
+                    desc->info.msg.buf_size, desc->info.msg.plugin_data,
+                    desc->info.msg.addr, desc->info.msg.id,
+                    desc->info.msg.tag, desc->op_id);
+                break;
+            case NA_CB_RECV_EXPECTED:
+                ret = na_ofi_msg_recv_expected(na_class, context,
+                    desc->callback, desc->arg, desc->info.msg.buf,
+                    desc->info.msg.buf_size, desc->info.msg.plugin_data,
+                    desc->info.msg.addr, desc->info.msg.id,
+                    desc->info.msg.tag, desc->op_id);
+                break;
+            case NA_CB_PUT:
+                ret = na_ofi_rma_put(na_class, context, desc->callback,
+                    desc->arg, desc->info.rma.local_mem_handle,
+                    desc->info.rma.local_offset,
+                    desc->info.rma.remote_mem_handle,
+                    desc->info.rma.remote_offset, desc->info.rma.length,
+                    desc->info.rma.remote_addr, desc->info.rma.remote_id,
+                    desc->op_id, more_flag);
+                break;
+            case NA_CB_GET:
+                ret = na_ofi_rma_get(na_class, context, desc->callback,
+                    desc->arg, desc->info.rma.local_mem_handle,
+                    desc->info.rma.local_offset,
+                    desc->info.rma.remote_mem_handle,
+                    desc->info.rma.remote_offset, desc->info.rma.length,
+                    desc->info.rma.remote_addr, desc->info.rma.remote_id,
+                    desc->op_id, more_flag);
+                break;
+            default:
+                NA_GOTO_ERROR(out, ret, NA_INVALID_ARG,
+                    "Operation type %d not supported", desc->type);
+        }
+        NA_CHECK_NA_ERROR(out, ret, "Could not post operation %zu",
+            (size_t) i);
+    }
+
+out:
+    if (posted)
+        *posted = i;
+    return ret;
+}
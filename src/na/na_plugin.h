@@ -18,6 +18,9 @@
 #include "mercury_queue.h"
 #include "mercury_thread_mutex.h"
 #include "mercury_thread_condition.h"
+#ifdef NA_HAS_COLLECT_STATS
+# include "mercury_time.h"
+#endif
 
 /*************************************/
 /* Public Type and Struct Definition */
@@ -33,9 +36,19 @@ struct na_cb_completion_data {
     na_plugin_cb_t plugin_callback;     /* Callback which will be called after
                                          * the user callback returns. */
     void *plugin_callback_args;         /* Argument to plugin_callback */
-    HG_QUEUE_ENTRY(na_cb_completion_data) entry; /* Completion queue entry */
+#ifdef NA_HAS_COLLECT_STATS
+    hg_time_ticks_t stats_ticks;        /* Time at which op was posted */
+    na_size_t stats_size;               /* Bytes transferred by op */
+#endif
 };
 
+/* Plugin events counted in na_stats */
+typedef enum na_stats_event {
+    NA_STATS_AGAIN,             /* Post retried on resource exhaustion */
+    NA_STATS_CQ_FULL,           /* Completion poll returned a full batch */
+    NA_STATS_UNEXPECTED_QUEUED  /* Unexpected recv matched a queued message */
+} na_stats_event_t;
+
 /*****************/
 /* Public Macros */
 /*****************/
@@ -71,6 +84,23 @@ struct na_cb_completion_data {
 # define MIN(a, b) (((a) < (b)) ? (a) : (b))
 #endif
 
+/**
+ * Stats hooks, compiled out unless NA_HAS_COLLECT_STATS is defined.
+ * NA_STATS_POST must be called before the operation can complete.
+ */
+#ifdef NA_HAS_COLLECT_STATS
+# define NA_STATS_POST(context, completion_data, type, size) \
+    na_stats_post(context, completion_data, type, size)
+# define NA_STATS_EVENT(context, event) \
+    na_stats_event(context, event)
+# define NA_STATS_UNEXPECTED_DEPTH(context, depth) \
+    na_stats_unexpected_depth(context, depth)
+#else
+# define NA_STATS_POST(context, completion_data, type, size) (void) 0
+# define NA_STATS_EVENT(context, event) (void) 0
+# define NA_STATS_UNEXPECTED_DEPTH(context, depth) (void) (depth)
+#endif
+
 /**
  * Plugin ops definition
  */
@@ -100,6 +130,48 @@ na_cb_completion_add(
         struct na_cb_completion_data *na_cb_completion_data
         );
 
+#ifdef NA_HAS_COLLECT_STATS
+/**
+ * Record that an operation is being posted.
+ *
+ * \param context [IN/OUT]              pointer to context of execution
+ * \param na_cb_completion_data [IN]    pointer to completion data
+ * \param type [IN]                     operation type
+ * \param size [IN]                     bytes sent, received or transferred
+ */
+NA_PRIVATE void
+na_stats_post(
+        na_context_t                 *context,
+        struct na_cb_completion_data *na_cb_completion_data,
+        na_cb_type_t                  type,
+        na_size_t                     size
+        );
+
+/**
+ * Count plugin event.
+ *
+ * \param context [IN/OUT]              pointer to context of execution
+ * \param event [IN]                    event type
+ */
+NA_PRIVATE void
+na_stats_event(
+        na_context_t     *context,
+        na_stats_event_t  event
+        );
+
+/**
+ * Report number of unexpected messages waiting for a receive.
+ *
+ * \param context [IN/OUT]              pointer to context of execution
+ * \param depth [IN]                    number of queued messages
+ */
+NA_PRIVATE void
+na_stats_unexpected_depth(
+        na_context_t *context,
+        na_size_t     depth
+        );
+#endif
+
 /*********************/
 /* Public Variables */
 /*********************/
@@ -119,6 +191,12 @@ extern NA_PRIVATE const struct na_class_ops NA_PLUGIN_OPS(cci);
 #ifdef NA_HAS_OFI
 extern NA_PRIVATE const struct na_class_ops NA_PLUGIN_OPS(ofi);
 #endif
+#ifdef NA_HAS_INPROC
+extern NA_PRIVATE const struct na_class_ops NA_PLUGIN_OPS(inproc);
+#endif
+#ifdef NA_HAS_EMU
+extern NA_PRIVATE const struct na_class_ops NA_PLUGIN_OPS(emu);
+#endif
 
 #ifdef __cplusplus
 }
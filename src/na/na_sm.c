@@ -14,10 +14,14 @@
 #include "na_plugin.h"
 
 #include "mercury_thread_spin.h"
+#include "mercury_thread_mutex.h"
+#include "mercury_thread_pool.h"
 #include "mercury_time.h"
 #include "mercury_poll.h"
 #include "mercury_event.h"
 #include "mercury_mem.h"
+#include "mercury_mem_pool.h"
+#include "mercury_list.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -28,6 +32,8 @@
 #else
 #include <pwd.h>
 #include <ftw.h>
+#include <dirent.h>
+#include <limits.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/mman.h>
@@ -55,23 +61,82 @@
 
 /* Plugin constants */
 #define NA_SM_MAX_FILENAME      64
-#define NA_SM_NUM_BUFS          64
+#define NA_SM_NUM_BUFS          256
+#define NA_SM_BUF_WORD_BITS     64
+#define NA_SM_NUM_BUF_WORDS     (NA_SM_NUM_BUFS / NA_SM_BUF_WORD_BITS)
 #define NA_SM_CACHE_LINE_SIZE   HG_UTIL_CACHE_ALIGNMENT
 #define NA_SM_RING_BUF_SIZE \
     (sizeof(struct na_sm_ring_buf) + NA_SM_NUM_BUFS * HG_ATOMIC_QUEUE_ELT_SIZE)
 #define NA_SM_COPY_BUF_SIZE     4096
+/* Reservations never span two mask words, keep at least four messages of
+ * max size per word */
+#define NA_SM_MAX_BUF_SIZE      (NA_SM_BUF_WORD_BITS * NA_SM_COPY_BUF_SIZE / 4)
 #define NA_SM_CLEANUP_NFDS      16
+#define NA_SM_EXPECTED_HASH_SIZE 256 /* Must be a power of 2 */
+
+/* Arena that memory returned by NA_Mem_alloc() is carved from, peers map it
+ * once and then access that memory directly instead of going through CMA.
+ * Every peer doing RMA to arena memory maps the whole arena, so that each
+ * connection costs up to NA_SM_ARENA_SIZE bytes of address space (pages are
+ * only backed once touched) */
+#ifndef NA_SM_ARENA_SIZE
+# define NA_SM_ARENA_SIZE       (64 * 1024 * 1024)
+#endif
+#define NA_SM_ARENA_PAGE_SIZE   4096
+#if (NA_SM_ARENA_SIZE <= 0) || (NA_SM_ARENA_SIZE % NA_SM_ARENA_PAGE_SIZE)
+# error "NA_SM_ARENA_SIZE must be a positive multiple of 4096 bytes"
+#endif
+#define NA_SM_ARENA_PAGES       (NA_SM_ARENA_SIZE / NA_SM_ARENA_PAGE_SIZE)
+
+/* Peer arena mapping status */
+#define NA_SM_ARENA_UNMAPPED    0
+#define NA_SM_ARENA_MAPPED      1
+#define NA_SM_ARENA_FAILED      (-1)
+
+/* RMA transfers of at least two chunks are split across helper threads so
+ * that the progress thread does not copy them itself. The thread count is
+ * set at configure time (4 by default), 0 disables helper threads and leaves
+ * NA_SM_RMA_THREAD_COUNT undefined */
+#ifndef NA_SM_RMA_THREAD_COUNT
+# define NA_SM_RMA_THREAD_COUNT 0
+#endif
+#define NA_SM_RMA_CHUNK_SIZE    (1024 * 1024) /* Min chunk size */
+
+/* RMA helper thread pool status */
+#define NA_SM_RMA_POOL_NONE     0
+#define NA_SM_RMA_POOL_READY    1
+#define NA_SM_RMA_POOL_FAILED   (-1)
 
 #define NA_SM_LISTEN_BACKLOG    64
 #define NA_SM_ACCEPT_INTERVAL   100 /* 100 ms */
 
-/* Msg sizes */
-#define NA_SM_UNEXPECTED_SIZE   NA_SM_COPY_BUF_SIZE
+/* Msg sizes, eager messages larger than a copy buf slot are copied into
+ * contiguous slots */
+#ifndef NA_SM_EAGER_SIZE
+# define NA_SM_EAGER_SIZE       NA_SM_COPY_BUF_SIZE
+#endif
+#if (NA_SM_EAGER_SIZE <= 0) || (NA_SM_EAGER_SIZE > NA_SM_MAX_BUF_SIZE)
+# error "NA_SM_EAGER_SIZE must be between 1 and 65536 bytes"
+#endif
+#define NA_SM_UNEXPECTED_SIZE   NA_SM_EAGER_SIZE
 #define NA_SM_EXPECTED_SIZE     NA_SM_UNEXPECTED_SIZE
 
+/* Number of copy buf slots used by a message of size n */
+#define NA_SM_BUF_COUNT(n) \
+    ((n) ? (((n) + NA_SM_COPY_BUF_SIZE - 1) / NA_SM_COPY_BUF_SIZE) : 1)
+
+/* Copy buf slots of a connection that loaned receive buffers may hold, past
+ * that messages are copied out so that the sender always has free slots */
+#define NA_SM_LOAN_MAX_BUFS     (NA_SM_NUM_BUFS / 2)
+
 /* Max tag */
 #define NA_SM_MAX_TAG           NA_TAG_UB
 
+/* Expected op table bucket for a given (addr, tag) pair */
+#define NA_SM_EXPECTED_HASH(na_sm_addr, tag)                                \
+    ((unsigned int) ((((size_t) (na_sm_addr)) >> 4) ^ (size_t) (tag))      \
+        & (NA_SM_EXPECTED_HASH_SIZE - 1))
+
 /* Private data access */
 #define NA_SM_CLASS(na_class) \
     ((struct na_sm_class *)(na_class->plugin_class))
@@ -86,12 +151,6 @@
 /* Default filenames/paths */
 #define NA_SM_SHM_PATH "/dev/shm"
 
-#define NA_SM_GEN_SHM_NAME(filename, username, na_sm_addr)      \
-    do {                                                        \
-        sprintf(filename, "%s_%s-%d-%u", NA_SM_SHM_PREFIX,      \
-            username, na_sm_addr->pid, na_sm_addr->id);         \
-    } while (0)
-
 #define NA_SM_GEN_SOCK_PATH(pathname, username, na_sm_addr)                 \
     do {                                                                    \
         sprintf(pathname, "%s/%s_%s/%d/%u", NA_SM_TMP_DIRECTORY,            \
@@ -100,18 +159,31 @@
 
 #define NA_SM_SEND_NAME "s" /* used for pair_name */
 #define NA_SM_RECV_NAME "r" /* used for pair_name */
-#define NA_SM_GEN_RING_NAME(filename, pair_name, username, na_sm_addr)      \
+#define NA_SM_COPY_NAME "c" /* used for pair_name */
+/* Ring buffers and copy buffers are created by the connecting side and named
+ * after its own PID / ID and the connection ID it picked */
+#define NA_SM_GEN_RING_NAME(filename, pair_name, username, pid, id, conn_id) \
     do {                                                                    \
         sprintf(filename, "%s_%s-%d-%u-%u-" pair_name, NA_SM_SHM_PREFIX,    \
-            username, na_sm_addr->pid, na_sm_addr->id, na_sm_addr->conn_id);\
+            username, pid, id, conn_id);                                    \
+    } while (0)
+
+/* Arenas are created by their owner and named after its own PID / ID */
+#define NA_SM_GEN_ARENA_NAME(filename, username, pid, id)                   \
+    do {                                                                    \
+        sprintf(filename, "%s_%s-%d-%u-a", NA_SM_SHM_PREFIX, username,      \
+            pid, id);                                                       \
     } while (0)
 
 #ifndef HG_UTIL_HAS_SYSEVENTFD_H
-#define NA_SM_GEN_FIFO_NAME(filename, pair_name, username, na_sm_addr)  \
+/* FIFOs live in the tmp directory of the listening peer, which is the only
+ * one guaranteed to exist */
+#define NA_SM_GEN_FIFO_NAME(filename, pair_name, username, na_sm_addr,  \
+    pid, id, conn_id)                                                   \
     do {                                                                \
-        sprintf(filename, "%s/%s_%s/%d/%u/fifo-%u-" pair_name,          \
+        sprintf(filename, "%s/%s_%s/%d/%u/fifo-%d-%u-%u-" pair_name,    \
             NA_SM_TMP_DIRECTORY, NA_SM_SHM_PREFIX, username,            \
-            na_sm_addr->pid, na_sm_addr->id, na_sm_addr->conn_id);      \
+            na_sm_addr->pid, na_sm_addr->id, pid, id, conn_id);         \
     } while (0)
 #endif
 
@@ -132,10 +204,9 @@ typedef union {
 typedef union {
     struct {
         unsigned int type       : 4;    /* Message type */
-        unsigned int buf_idx    : 8;    /* Index reserved: 64 MAX */
-        unsigned int buf_size   : 16;   /* Buffer length: 4KB MAX */
+        unsigned int buf_idx    : 8;    /* First index reserved: 256 MAX */
+        unsigned int buf_size   : 20;   /* Buffer length: 1MB MAX */
         unsigned int tag        : 32;   /* Message tag : UINT MAX */
-        unsigned int pad        : 4;    /* 4 bits left */
     } hdr;
     na_uint64_t val;
 } na_sm_cacheline_hdr_t;
@@ -147,11 +218,13 @@ struct na_sm_ring_buf {
              - NA_SM_NUM_BUFS * HG_ATOMIC_QUEUE_ELT_SIZE];
 };
 
-/* Shared copy buffer */
+/* Shared copy buffer (one per connection) */
 struct na_sm_copy_buf {
-    na_sm_cacheline_atomic_int64_t available;       /* Atomic bitmask */
+    na_sm_cacheline_atomic_int64_t available[NA_SM_NUM_BUF_WORDS]; /* Masks */
+    na_sm_cacheline_atomic_int32_t next_word;       /* Spreads reservations */
+    char pad[NA_SM_COPY_BUF_SIZE
+             - (NA_SM_NUM_BUF_WORDS + 1) * NA_SM_CACHE_LINE_SIZE];
     char buf[NA_SM_NUM_BUFS][NA_SM_COPY_BUF_SIZE];  /* Buffer used for msgs */
-    char pad[NA_SM_COPY_BUF_SIZE - NA_SM_CACHE_LINE_SIZE];
 };
 
 /* Poll type */
@@ -166,12 +239,19 @@ struct na_sm_poll_data {
     na_class_t *na_class;
     na_sm_poll_type_t type;  /* Type of operation */
     struct na_sm_addr *addr; /* Address */
+    int fd;                  /* File descriptor */
+    HG_LIST_ENTRY(na_sm_poll_data) entry;
+};
+
+/* External poll set */
+struct na_sm_ext_poll_set {
+    hg_poll_set_t *poll_set; /* Poll set registered with NA_Poll_register() */
+    HG_LIST_ENTRY(na_sm_ext_poll_set) entry;
 };
 
 /* Sock progress type */
 typedef enum {
     NA_SM_ADDR_INFO,
-    NA_SM_CONN_ID,
     NA_SM_SOCK_DONE
 } na_sm_sock_progress_t;
 
@@ -183,6 +263,12 @@ struct na_sm_addr {
     struct na_sm_ring_buf *na_sm_send_ring_buf; /* Shared send ring buffer */
     struct na_sm_ring_buf *na_sm_recv_ring_buf; /* Shared recv ring buffer */
     struct na_sm_copy_buf *na_sm_copy_buf;  /* Shared copy buffer */
+    hg_mem_backing_t send_ring_buf_backing; /* Pages backing send ring buf */
+    hg_mem_backing_t recv_ring_buf_backing; /* Pages backing recv ring buf */
+    hg_mem_backing_t copy_buf_backing;      /* Pages backing copy buf */
+    char *arena;                            /* Mapped peer arena */
+    hg_mem_backing_t arena_backing;         /* Pages backing peer arena */
+    hg_atomic_int32_t arena_status;         /* Peer arena mapping status */
     na_bool_t accepted;                     /* Created on accept */
     na_bool_t self;                         /* Self address */
     int sock;                               /* Sock fd */
@@ -192,6 +278,7 @@ struct na_sm_addr {
     struct na_sm_poll_data *local_notify_poll_data; /* Notify poll data */
     int remote_notify;                      /* Remote notify fd */
     hg_atomic_int32_t ref_count;            /* Ref count */
+    hg_atomic_int32_t loan_count;           /* Copy buf slots loaned */
     HG_QUEUE_ENTRY(na_sm_addr) entry;       /* Next queue entry */
     HG_QUEUE_ENTRY(na_sm_addr) poll_entry;  /* Next poll queue entry */
 };
@@ -203,12 +290,22 @@ struct na_sm_unexpected_info {
     HG_QUEUE_ENTRY(na_sm_unexpected_info) entry;
 };
 
+/* Copy of a message loaned in place of copy buf slots */
+struct na_sm_loan_copy {
+    struct na_sm_addr *na_sm_addr;          /* Source addr */
+    void *buf;                              /* Message (follows struct) */
+    HG_LIST_ENTRY(na_sm_loan_copy) entry;
+};
+
 /* Memory handle */
 struct na_sm_mem_handle {
     struct iovec *iov;
     unsigned long iovcnt;
     unsigned long flags; /* Flag of operation access */
     size_t len;
+    void *arena_base;    /* Owner arena base if memory lies in it */
+    pid_t arena_pid;     /* Arena owner PID */
+    unsigned int arena_id; /* Arena owner SM ID */
 };
 
 /* Lookup info */
@@ -239,6 +336,13 @@ struct na_sm_info_recv_expected {
     na_tag_t tag;
 };
 
+/* Put / get info */
+struct na_sm_info_rma {
+    struct na_sm_rma_chunk *chunks;     /* Chunks of parallel transfer */
+    hg_atomic_int32_t pending;          /* Chunks left to transfer */
+    hg_atomic_int32_t ret;              /* Transfer error if any */
+};
+
 /* Operation ID */
 struct na_sm_op_id {
     na_class_t *na_class;
@@ -251,9 +355,24 @@ struct na_sm_op_id {
         struct na_sm_info_send send;
         struct na_sm_info_recv_unexpected recv_unexpected;
         struct na_sm_info_recv_expected recv_expected;
+        struct na_sm_info_rma rma;
     } info;
     hg_atomic_int32_t ref_count;    /* Ref count */
     HG_QUEUE_ENTRY(na_sm_op_id) entry;
+    HG_QUEUE_ENTRY(na_sm_op_id) expected_entry; /* Expected op table entry */
+};
+
+/* Chunk of a parallel RMA transfer */
+struct na_sm_rma_chunk {
+    struct hg_thread_work work;         /* Posted to RMA thread pool */
+    struct na_sm_op_id *na_sm_op_id;    /* Parent operation */
+    pid_t pid;                          /* Remote PID */
+    na_bool_t arena;                    /* Remote iov is in mapped arena */
+    struct iovec *local_iov;
+    unsigned long liovcnt;
+    struct iovec *remote_iov;
+    unsigned long riovcnt;
+    na_size_t length;
 };
 
 /* Private data */
@@ -261,21 +380,36 @@ struct na_sm_class {
     char *username;
     struct na_sm_addr *self_addr;
     hg_poll_set_t *poll_set;
+    HG_LIST_HEAD(na_sm_ext_poll_set) ext_poll_set_list;
+    HG_LIST_HEAD(na_sm_poll_data) poll_data_list;
     HG_QUEUE_HEAD(na_sm_addr) accepted_addr_queue;
     HG_QUEUE_HEAD(na_sm_addr) poll_addr_queue;
     HG_QUEUE_HEAD(na_sm_unexpected_info) unexpected_msg_queue;
-    HG_QUEUE_HEAD(na_sm_op_id) lookup_op_queue;
+    na_size_t unexpected_msg_count;
     HG_QUEUE_HEAD(na_sm_op_id) unexpected_op_queue;
-    HG_QUEUE_HEAD(na_sm_op_id) expected_op_queue;
+    HG_QUEUE_HEAD(na_sm_op_id) expected_op_table[NA_SM_EXPECTED_HASH_SIZE];
+    hg_mem_pool_t *op_id_pool;
+    hg_mem_pool_t *unexpected_info_pool;
     hg_thread_spin_t accepted_addr_queue_lock;
     hg_thread_spin_t poll_addr_queue_lock;
     hg_thread_spin_t unexpected_msg_queue_lock;
-    hg_thread_spin_t lookup_op_queue_lock;
     hg_thread_spin_t unexpected_op_queue_lock;
-    hg_thread_spin_t expected_op_queue_lock;
-    hg_thread_spin_t copy_buf_lock;
+    hg_thread_spin_t expected_op_table_lock;
+    hg_thread_mutex_t poll_data_list_lock; /* Held across hg_poll_add/remove */
+    HG_LIST_HEAD(na_sm_loan_copy) loan_copy_list;
+    hg_thread_spin_t loan_copy_list_lock;
+    hg_thread_mutex_t arena_lock;   /* Held across arena creation/mapping */
+    char *arena;                /* Arena used by NA_Mem_alloc() */
+    unsigned char *arena_map;   /* Pages in use */
+    hg_mem_backing_t arena_backing;
+    na_bool_t arena_failed;     /* Do not retry arena creation */
+    hg_thread_pool_t *rma_pool; /* RMA helper threads, created on first use */
+    hg_atomic_int32_t rma_pool_status;
+    hg_thread_mutex_t rma_pool_lock; /* Held across thread creation */
     hg_time_t last_accept_time;
+    hg_atomic_int32_t conn_id;  /* Next connection ID */
     na_bool_t no_wait;
+    na_bool_t huge_pages;
 };
 
 /********************/
@@ -294,9 +428,11 @@ getlogin_safe(void);
  */
 static void *
 na_sm_open_shared_buf(
+    na_class_t *na_class,
     const char *name,
     size_t buf_size,
-    na_bool_t create
+    na_bool_t create,
+    hg_mem_backing_t *backing
     );
 
 /**
@@ -306,7 +442,105 @@ static na_return_t
 na_sm_close_shared_buf(
     const char *filename,
     void *buf,
-    size_t buf_size
+    size_t buf_size,
+    hg_mem_backing_t backing
+    );
+
+/**
+ * Map arena of remote peer if not already mapped.
+ */
+static char *
+na_sm_arena_map(
+    na_class_t *na_class,
+    struct na_sm_addr *na_sm_addr
+    );
+
+/**
+ * Translate iovecs of a remote memory handle that lies in the arena of the
+ * remote peer into local addresses. Returns NA_FALSE if the arena cannot be
+ * used, in which case CMA must be used instead.
+ */
+static na_bool_t
+na_sm_arena_translate(
+    na_class_t *na_class,
+    struct na_sm_addr *na_sm_addr,
+    struct na_sm_mem_handle *na_sm_mem_handle,
+    const struct iovec *iov,
+    unsigned long iovcnt,
+    struct iovec *arena_iov
+    );
+
+/**
+ * Record arena information if all segments of memory handle lie in our
+ * arena.
+ */
+static void
+na_sm_mem_handle_set_arena(
+    na_class_t *na_class,
+    struct na_sm_mem_handle *na_sm_mem_handle
+    );
+
+/**
+ * Transfer data between local and remote iovecs using CMA, or memcpy if
+ * remote iovecs point to the mapped arena of the peer.
+ */
+static na_return_t
+na_sm_rma_transfer(
+    na_cb_type_t type,
+    pid_t pid,
+    na_bool_t arena,
+    const struct iovec *local_iov,
+    unsigned long liovcnt,
+    const struct iovec *remote_iov,
+    unsigned long riovcnt,
+    na_size_t length
+    );
+
+/**
+ * Number of chunks a transfer of length bytes should be split into, creates
+ * RMA helper threads on first use. Returns 1 if the transfer must not be
+ * split.
+ */
+static unsigned int
+na_sm_rma_chunk_count(
+    na_class_t *na_class,
+    na_size_t length
+    );
+
+/**
+ * Split transfer into chunk_count chunks and post them to RMA helper threads.
+ */
+static na_return_t
+na_sm_rma_post_chunks(
+    na_class_t *na_class,
+    struct na_sm_op_id *na_sm_op_id,
+    struct na_sm_addr *na_sm_addr,
+    struct na_sm_mem_handle *na_sm_mem_handle_local,
+    na_offset_t local_offset,
+    struct na_sm_mem_handle *na_sm_mem_handle_remote,
+    na_offset_t remote_offset,
+    na_size_t length,
+    unsigned int chunk_count
+    );
+
+/**
+ * Transfer chunk, completes operation once all its chunks are transferred.
+ */
+static HG_THREAD_RETURN_TYPE
+na_sm_rma_chunk_process(
+    void *arg
+    );
+
+/**
+ * Copy length bytes between two iovec arrays.
+ */
+static void
+na_sm_iov_copy(
+    const struct iovec *dst_iov,
+    unsigned long dst_iovcnt,
+    const struct iovec *src_iov,
+    unsigned long src_iovcnt,
+    na_size_t length
     );
 
 /**
@@ -349,6 +583,14 @@ na_sm_cleanup_shm(
     struct FTW *ftwbuf
     );
 
+/**
+ * Clean up shared segments created on hugetlbfs.
+ */
+static void
+na_sm_cleanup_hugetlbfs(
+    const char *path
+    );
+
 #ifndef HG_UTIL_HAS_SYSEVENTFD_H
 
 /**
@@ -416,7 +658,7 @@ static na_return_t na_sm_setup_shm(
     );
 
 /**
- * Send addr info.
+ * Send addr info (PID / ID / connection ID and notify fds).
  */
 static na_return_t
 na_sm_send_addr_info(
@@ -425,7 +667,7 @@ na_sm_send_addr_info(
     );
 
 /**
- * Recv addr info.
+ * Recv addr info (PID / ID / connection ID and notify fds).
  */
 static na_return_t
 na_sm_recv_addr_info(
@@ -434,20 +676,14 @@ na_sm_recv_addr_info(
     );
 
 /**
- * Send connection ID.
- */
-static na_return_t
-na_sm_send_conn_id(
-    struct na_sm_addr *na_sm_addr
-    );
-
-/**
- * Recv connection ID.
+ * Connect to remote PID / ID or reuse an existing connection.
  */
 static na_return_t
-na_sm_recv_conn_id(
-    struct na_sm_addr *na_sm_addr,
-    na_bool_t *received
+na_sm_addr_connect(
+    na_class_t *na_class,
+    pid_t pid,
+    unsigned int id,
+    struct na_sm_addr **addr
     );
 
 /**
@@ -485,11 +721,18 @@ na_sm_ring_buf_is_empty(
     );
 
 /**
- * Reserve shared copy buf.
+ * Initialize shared copy buf.
+ */
+static void
+na_sm_copy_buf_init(
+    struct na_sm_copy_buf *na_sm_copy_buf
+    );
+
+/**
+ * Reserve contiguous slots of shared copy buf and copy buf into them.
  */
 static NA_INLINE na_return_t
 na_sm_reserve_and_copy_buf(
-    na_class_t *na_class,
     struct na_sm_copy_buf *na_sm_copy_buf,
     const void *buf,
     size_t buf_size,
@@ -497,17 +740,103 @@ na_sm_reserve_and_copy_buf(
     );
 
 /**
- * Free shared copy buf.
+ * Copy slots of shared copy buf into buf (if not NULL) and free them.
  */
 static NA_INLINE void
 na_sm_copy_and_free_buf(
-    na_class_t *na_class,
     struct na_sm_copy_buf *na_sm_copy_buf,
     void *buf,
     size_t buf_size,
     unsigned int idx_reserved
     );
 
+/**
+ * Loan slots of shared copy buf holding a received message, or a copy of it
+ * if too many slots of that connection are already loaned.
+ */
+static void *
+na_sm_loan_buf(
+    na_class_t *na_class,
+    struct na_sm_addr *na_sm_addr,
+    size_t buf_size,
+    unsigned int idx_reserved
+    );
+
+/**
+ * Notify remote that count messages were inserted into its ring buffer.
+ */
+static NA_INLINE na_return_t
+na_sm_notify_remote(
+    na_class_t *na_class,
+    struct na_sm_addr *na_sm_addr,
+    unsigned int count
+    );
+
+/**
+ * Notify local completion.
+ */
+static NA_INLINE na_return_t
+na_sm_notify_local(
+    na_class_t *na_class
+    );
+
+/**
+ * Post message send, when pending_count is not NULL, remote notification is
+ * left to the caller and pending_count is incremented.
+ */
+static na_return_t
+na_sm_msg_send(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_cb_type_t cb_type,
+    na_cb_t callback,
+    void *arg,
+    const void *buf,
+    na_size_t buf_size,
+    na_addr_t dest_addr,
+    na_tag_t tag,
+    na_op_id_t *op_id,
+    unsigned int *pending_count
+    );
+
+/**
+ * Post put, local notification is left to the caller if notify is false.
+ */
+static na_return_t
+na_sm_rma_put(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_cb_t callback,
+    void *arg,
+    na_mem_handle_t local_mem_handle,
+    na_offset_t local_offset,
+    na_mem_handle_t remote_mem_handle,
+    na_offset_t remote_offset,
+    na_size_t length,
+    na_addr_t remote_addr,
+    na_op_id_t *op_id,
+    na_bool_t notify
+    );
+
+/**
+ * Post get, local notification is left to the caller if notify is false.
+ */
+static na_return_t
+na_sm_rma_get(
+    na_class_t *na_class,
+    na_context_t *context,
+    na_cb_t callback,
+    void *arg,
+    na_mem_handle_t local_mem_handle,
+    na_offset_t local_offset,
+    na_mem_handle_t remote_mem_handle,
+    na_offset_t remote_offset,
+    na_size_t length,
+    na_addr_t remote_addr,
+    na_op_id_t *op_id,
+    na_bool_t notify
+    );
+
 /**
  * Translate offset from mem_handle into usable iovec.
  */
@@ -632,6 +961,15 @@ na_sm_cleanup(
     void
     );
 
+/**
+ * Initialize op ID.
+ */
+static NA_INLINE void
+na_sm_op_id_init(
+    na_class_t *na_class,
+    struct na_sm_op_id *na_sm_op_id
+    );
+
 /* op_create */
 static na_op_id_t
 na_sm_op_create(
@@ -645,6 +983,13 @@ na_sm_op_destroy(
     na_op_id_t op_id
     );
 
+/* op_reset */
+static na_return_t
+na_sm_op_reset(
+    na_class_t *na_class,
+    na_op_id_t op_id
+    );
+
 /* addr_lookup */
 static na_return_t
 na_sm_addr_lookup(
@@ -656,6 +1001,14 @@ na_sm_addr_lookup(
     na_op_id_t *op_id
     );
 
+/* addr_lookup2 */
+static na_return_t
+na_sm_addr_lookup2(
+    na_class_t *na_class,
+    const char *name,
+    na_addr_t *addr
+    );
+
 /* addr_free */
 static na_return_t
 na_sm_addr_free(
@@ -702,6 +1055,31 @@ na_sm_addr_to_string(
     na_addr_t addr
     );
 
+/* addr_get_serialize_size */
+static NA_INLINE na_size_t
+na_sm_addr_get_serialize_size(
+    na_class_t *na_class,
+    na_addr_t addr
+    );
+
+/* addr_serialize */
+static na_return_t
+na_sm_addr_serialize(
+    na_class_t *na_class,
+    void *buf,
+    na_size_t buf_size,
+    na_addr_t addr
+    );
+
+/* addr_deserialize */
+static na_return_t
+na_sm_addr_deserialize(
+    na_class_t *na_class,
+    na_addr_t *addr,
+    const void *buf,
+    na_size_t buf_size
+    );
+
 /* msg_get_max_unexpected_size */
 static NA_INLINE na_size_t
 na_sm_msg_get_max_unexpected_size(
@@ -883,6 +1261,22 @@ na_sm_poll_try_wait(
     na_context_t    *context
     );
 
+/* poll_register */
+static na_return_t
+na_sm_poll_set_register(
+    na_class_t *na_class,
+    na_context_t *context,
+    struct hg_poll_set *poll_set
+    );
+
+/* poll_deregister */
+static na_return_t
+na_sm_poll_set_deregister(
+    na_class_t *na_class,
+    na_context_t *context,
+    struct hg_poll_set *poll_set
+    );
+
 /* progress */
 static na_return_t
 na_sm_progress(
@@ -899,6 +1293,41 @@ na_sm_cancel(
     na_op_id_t op_id
     );
 
+/* submit */
+static na_return_t
+na_sm_submit(
+    na_class_t *na_class,
+    na_context_t *context,
+    const struct na_op_desc *op_descs,
+    na_size_t count,
+    na_size_t *posted
+    );
+
+/* msg_loan_release */
+static na_return_t
+na_sm_msg_loan_release(
+    na_class_t *na_class,
+    void *buf,
+    na_size_t buf_size,
+    na_addr_t source_addr
+    );
+
+/* mem_alloc */
+static void *
+na_sm_mem_alloc(
+    na_class_t *na_class,
+    na_size_t buf_size,
+    void **plugin_data
+    );
+
+/* mem_free */
+static na_return_t
+na_sm_mem_free(
+    na_class_t *na_class,
+    void *buf,
+    void *plugin_data
+    );
+
 /*******************/
 /* Local Variables */
 /*******************/
@@ -913,8 +1342,9 @@ const struct na_class_ops NA_PLUGIN_OPS(sm) = {
     NULL,                                   /* context_destroy */
     na_sm_op_create,                        /* op_create */
     na_sm_op_destroy,                       /* op_destroy */
+    na_sm_op_reset,                         /* op_reset */
     na_sm_addr_lookup,                      /* addr_lookup */
-    NULL,                                   /* addr_lookup2 */
+    na_sm_addr_lookup2,                     /* addr_lookup2 */
     na_sm_addr_free,                        /* addr_free */
     NULL,                                   /* addr_set_remove */
     na_sm_addr_self,                        /* addr_self */
@@ -922,9 +1352,9 @@ const struct na_class_ops NA_PLUGIN_OPS(sm) = {
     na_sm_addr_cmp,                         /* addr_cmp */
     na_sm_addr_is_self,                     /* addr_is_self */
     na_sm_addr_to_string,                   /* addr_to_string */
-    NULL,                                   /* addr_get_serialize_size */
-    NULL,                                   /* addr_serialize */
-    NULL,                                   /* addr_deserialize */
+    na_sm_addr_get_serialize_size,          /* addr_get_serialize_size */
+    na_sm_addr_serialize,                   /* addr_serialize */
+    na_sm_addr_deserialize,                 /* addr_deserialize */
     na_sm_msg_get_max_unexpected_size,      /* msg_get_max_unexpected_size */
     na_sm_msg_get_max_expected_size,        /* msg_get_max_expected_size */
     NULL,                                   /* msg_get_unexpected_header_size */
@@ -956,8 +1386,14 @@ const struct na_class_ops NA_PLUGIN_OPS(sm) = {
     na_sm_get,                              /* get */
     na_sm_poll_get_fd,                      /* poll_get_fd */
     na_sm_poll_try_wait,                    /* poll_try_wait */
+    na_sm_poll_set_register,                /* poll_register */
+    na_sm_poll_set_deregister,              /* poll_deregister */
     na_sm_progress,                         /* progress */
-    na_sm_cancel                            /* cancel */
+    na_sm_cancel,                           /* cancel */
+    na_sm_submit,                           /* submit */
+    na_sm_msg_loan_release,                 /* msg_loan_release */
+    na_sm_mem_alloc,                        /* mem_alloc */
+    na_sm_mem_free                          /* mem_free */
 };
 
 /********************/
@@ -1006,7 +1442,8 @@ getlogin_safe(void)
 
 /*---------------------------------------------------------------------------*/
 static void *
-na_sm_open_shared_buf(const char *name, size_t buf_size, na_bool_t create)
+na_sm_open_shared_buf(na_class_t *na_class, const char *name, size_t buf_size,
+    na_bool_t create, hg_mem_backing_t *backing)
 {
 //    na_size_t page_size = (na_size_t) hg_mem_get_page_size();
     void *ret = NULL;
@@ -1019,7 +1456,17 @@ na_sm_open_shared_buf(const char *name, size_t buf_size, na_bool_t create)
 //        goto done;
 //    }
 
-    ret = hg_mem_shm_map(name, buf_size, create);
+    /* Huge page segments are rounded up to the huge page size, so only
+     * back segments of at least half a huge page with them (e.g., copy
+     * buffers and arenas but not rings). Peers may use huge pages even if
+     * we do not. */
+    if ((NA_SM_CLASS(na_class)->huge_pages
+        && buf_size >= hg_mem_get_huge_page_size() / 2) || !create)
+        ret = hg_mem_shm_map_huge(name, buf_size, create, backing);
+    else {
+        ret = hg_mem_shm_map(name, buf_size, create);
+        *backing = HG_MEM_BACKING_REGULAR;
+    }
 
 //done:
     return ret;
@@ -1027,33 +1474,398 @@ na_sm_open_shared_buf(const char *name, size_t buf_size, na_bool_t create)
 
 /*---------------------------------------------------------------------------*/
 static na_return_t
-na_sm_close_shared_buf(const char *filename, void *buf, size_t buf_size)
+na_sm_close_shared_buf(const char *filename, void *buf, size_t buf_size,
+    hg_mem_backing_t backing)
 {
-    return hg_mem_shm_unmap(filename, buf, buf_size);
+    return hg_mem_shm_unmap_huge(filename, buf, buf_size, backing);
 }
 
 /*---------------------------------------------------------------------------*/
-static na_return_t
-na_sm_create_sock(const char *pathname, na_bool_t na_listen, int *sock)
+static char *
+na_sm_arena_map(na_class_t *na_class, struct na_sm_addr *na_sm_addr)
 {
-    struct sockaddr_un addr;
-    na_return_t ret = NA_SUCCESS;
-    int fd;
+    char na_sm_arena_name[NA_SM_MAX_FILENAME];
+    hg_util_int32_t status = hg_atomic_get32(&na_sm_addr->arena_status);
+
+    if (status == NA_SM_ARENA_MAPPED)
+        return na_sm_addr->arena;
+    if (status == NA_SM_ARENA_FAILED)
+        return NULL;
+
+    hg_thread_mutex_lock(&NA_SM_CLASS(na_class)->arena_lock);
+    if (hg_atomic_get32(&na_sm_addr->arena_status) == NA_SM_ARENA_UNMAPPED) {
+        NA_SM_GEN_ARENA_NAME(na_sm_arena_name, NA_SM_CLASS(na_class)->username,
+            na_sm_addr->pid, na_sm_addr->id);
+        na_sm_addr->arena = (char *) na_sm_open_shared_buf(na_class,
+            na_sm_arena_name, NA_SM_ARENA_SIZE, NA_FALSE,
+            &na_sm_addr->arena_backing);
+        if (!na_sm_addr->arena)
+            NA_LOG_WARNING("Could not map arena of peer, using CMA instead");
+        /* Make mapping visible before status */
+        hg_atomic_fence();
+        hg_atomic_set32(&na_sm_addr->arena_status,
+            na_sm_addr->arena ? NA_SM_ARENA_MAPPED : NA_SM_ARENA_FAILED);
+    }
+    hg_thread_mutex_unlock(&NA_SM_CLASS(na_class)->arena_lock);
+
+    return na_sm_addr->arena;
+}
 
-    /* Create a non-blocking socket so that we can poll for incoming connections */
-#ifdef SOCK_NONBLOCK
-    fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK, 0);
-#else
-    fd = socket(AF_UNIX, SOCK_STREAM, 0);
-#endif
-    if (fd == -1) {
-        NA_LOG_ERROR("socket() failed (%s)", strerror(errno));
-        ret = NA_PROTOCOL_ERROR;
-        goto done;
+/*---------------------------------------------------------------------------*/
+static na_bool_t
+na_sm_arena_translate(na_class_t *na_class, struct na_sm_addr *na_sm_addr,
+    struct na_sm_mem_handle *na_sm_mem_handle, const struct iovec *iov,
+    unsigned long iovcnt, struct iovec *arena_iov)
+{
+    char *arena;
+    unsigned long i;
+
+    /* Memory handle must describe arena memory of that same peer */
+    if (!na_sm_mem_handle->arena_base
+        || na_sm_mem_handle->arena_pid != na_sm_addr->pid
+        || na_sm_mem_handle->arena_id != na_sm_addr->id)
+        return NA_FALSE;
+
+    arena = na_sm_addr->self ? NA_SM_CLASS(na_class)->arena :
+        na_sm_arena_map(na_class, na_sm_addr);
+    if (!arena)
+        return NA_FALSE;
+
+    /* Check all segments first, iov and arena_iov may be the same array */
+    for (i = 0; i < iovcnt; i++) {
+        size_t offset = (size_t) ((char *) iov[i].iov_base
+            - (char *) na_sm_mem_handle->arena_base);
+
+        if (offset > NA_SM_ARENA_SIZE
+            || iov[i].iov_len > NA_SM_ARENA_SIZE - offset)
+            return NA_FALSE;
     }
-#ifndef SOCK_NONBLOCK
-    if (fcntl(fd, F_SETFL, O_NONBLOCK) == -1) {
-        NA_LOG_ERROR("fcntl() failed (%s)", strerror(errno));
+
+    for (i = 0; i < iovcnt; i++) {
+        arena_iov[i].iov_base = arena + ((char *) iov[i].iov_base
+            - (char *) na_sm_mem_handle->arena_base);
+        arena_iov[i].iov_len = iov[i].iov_len;
+    }
+
+    return NA_TRUE;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+na_sm_mem_handle_set_arena(na_class_t *na_class,
+    struct na_sm_mem_handle *na_sm_mem_handle)
+{
+    char *arena = NA_SM_CLASS(na_class)->arena;
+    unsigned long i;
+
+    na_sm_mem_handle->arena_base = NULL;
+    na_sm_mem_handle->arena_pid = 0;
+    na_sm_mem_handle->arena_id = 0;
+    if (!arena)
+        return;
+
+    for (i = 0; i < na_sm_mem_handle->iovcnt; i++) {
+        char *base = (char *) na_sm_mem_handle->iov[i].iov_base;
+
+        if (base < arena || base + na_sm_mem_handle->iov[i].iov_len
+            > arena + NA_SM_ARENA_SIZE)
+            return;
+    }
+
+    na_sm_mem_handle->arena_base = arena;
+    na_sm_mem_handle->arena_pid = NA_SM_CLASS(na_class)->self_addr->pid;
+    na_sm_mem_handle->arena_id = NA_SM_CLASS(na_class)->self_addr->id;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+na_sm_iov_copy(const struct iovec *dst_iov, unsigned long dst_iovcnt,
+    const struct iovec *src_iov, unsigned long src_iovcnt, na_size_t length)
+{
+    size_t dst_off = 0, src_off = 0;
+    unsigned long i = 0, j = 0;
+
+    while (length && i < dst_iovcnt && j < src_iovcnt) {
+        size_t len = NA_SM_MIN(dst_iov[i].iov_len - dst_off,
+            src_iov[j].iov_len - src_off);
+
+        len = NA_SM_MIN(len, length);
+        memcpy((char *) dst_iov[i].iov_base + dst_off,
+            (const char *) src_iov[j].iov_base + src_off, len);
+        length -= len;
+
+        dst_off += len;
+        if (dst_off == dst_iov[i].iov_len) {
+            dst_off = 0;
+            i++;
+        }
+        src_off += len;
+        if (src_off == src_iov[j].iov_len) {
+            src_off = 0;
+            j++;
+        }
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_sm_rma_transfer(na_cb_type_t type, pid_t pid, na_bool_t arena,
+    const struct iovec *local_iov, unsigned long liovcnt,
+    const struct iovec *remote_iov, unsigned long riovcnt, na_size_t length)
+{
+    na_return_t ret = NA_SUCCESS;
+#if defined(NA_SM_HAS_CMA)
+    ssize_t nbytes;
+#elif defined(__APPLE__)
+    mach_vm_size_t nread;
+    kern_return_t kret;
+    mach_port_name_t remote_task;
+#endif
+
+    /* Remote memory lies in the arena of the peer, copy directly */
+    if (arena) {
+        if (type == NA_CB_PUT)
+            na_sm_iov_copy(remote_iov, riovcnt, local_iov, liovcnt, length);
+        else
+            na_sm_iov_copy(local_iov, liovcnt, remote_iov, riovcnt, length);
+        goto done;
+    }
+
+#if defined(NA_SM_HAS_CMA)
+    if (type == NA_CB_PUT)
+        nbytes = process_vm_writev(pid, local_iov, liovcnt, remote_iov,
+            riovcnt, /* unused */0);
+    else
+        nbytes = process_vm_readv(pid, local_iov, liovcnt, remote_iov,
+            riovcnt, /* unused */0);
+    if (nbytes < 0) {
+        NA_LOG_ERROR("%s() failed (%s)", (type == NA_CB_PUT) ?
+            "process_vm_writev" : "process_vm_readv", strerror(errno));
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+    if ((na_size_t)nbytes != length) {
+        NA_LOG_ERROR("Transferred %ld bytes, was expecting %lu bytes", nbytes,
+            length);
+        ret = NA_SIZE_ERROR;
+        goto done;
+    }
+#elif defined(__APPLE__)
+    kret = task_for_pid(mach_task_self(), pid, &remote_task);
+    if (kret != KERN_SUCCESS) {
+        NA_LOG_ERROR("task_for_pid() failed (%s)\n"
+                     "Permission must be set to access remote memory, please refer to the documentation for instructions.", mach_error_string(kret));
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+
+    if (liovcnt > 1 || riovcnt > 1) {
+        NA_LOG_ERROR("Non-contiguous transfers are not supported");
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+
+    if (type == NA_CB_PUT) {
+        kret = mach_vm_write(remote_task,
+            (mach_vm_address_t) remote_iov->iov_base,
+            (mach_vm_address_t) local_iov->iov_base,
+            (mach_msg_type_number_t) length);
+        if (kret != KERN_SUCCESS) {
+            NA_LOG_ERROR("mach_vm_write() failed (%s)",
+                mach_error_string(kret));
+            ret = NA_PROTOCOL_ERROR;
+            goto done;
+        }
+    } else {
+        kret = mach_vm_read_overwrite(remote_task,
+            (mach_vm_address_t) remote_iov->iov_base, length,
+            (mach_vm_address_t) local_iov->iov_base, &nread);
+        if (kret != KERN_SUCCESS) {
+            NA_LOG_ERROR("mach_vm_read_overwrite() failed (%s)",
+                mach_error_string(kret));
+            ret = NA_PROTOCOL_ERROR;
+            goto done;
+        }
+        if ((na_size_t)nread != length) {
+            NA_LOG_ERROR("Read %ld bytes, was expecting %lu bytes", nread,
+                length);
+            ret = NA_SIZE_ERROR;
+            goto done;
+        }
+    }
+#else
+    (void) pid;
+    (void) liovcnt;
+    (void) riovcnt;
+    NA_LOG_ERROR("Not implemented for this platform");
+    ret = NA_PROTOCOL_ERROR;
+#endif
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static unsigned int
+na_sm_rma_chunk_count(na_class_t *na_class, na_size_t length)
+{
+    struct na_sm_class *na_sm_class = NA_SM_CLASS(na_class);
+    na_size_t chunk_count = length / NA_SM_RMA_CHUNK_SIZE;
+
+    if (NA_SM_RMA_THREAD_COUNT < 1 || chunk_count < 2)
+        return 1;
+
+    /* Create helper threads on first use */
+    if (hg_atomic_get32(&na_sm_class->rma_pool_status) == NA_SM_RMA_POOL_NONE) {
+        hg_thread_mutex_lock(&na_sm_class->rma_pool_lock);
+        if (hg_atomic_get32(&na_sm_class->rma_pool_status)
+            == NA_SM_RMA_POOL_NONE) {
+            if (hg_thread_pool_init(NA_SM_RMA_THREAD_COUNT,
+                &na_sm_class->rma_pool) != HG_UTIL_SUCCESS) {
+                NA_LOG_WARNING("Could not create RMA thread pool");
+                na_sm_class->rma_pool = NULL;
+            }
+            /* Make pool visible before status */
+            hg_atomic_fence();
+            hg_atomic_set32(&na_sm_class->rma_pool_status,
+                na_sm_class->rma_pool ? NA_SM_RMA_POOL_READY :
+                NA_SM_RMA_POOL_FAILED);
+        }
+        hg_thread_mutex_unlock(&na_sm_class->rma_pool_lock);
+    }
+    if (hg_atomic_get32(&na_sm_class->rma_pool_status) != NA_SM_RMA_POOL_READY)
+        return 1;
+
+    return (unsigned int) NA_SM_MIN(chunk_count,
+        (na_size_t) NA_SM_RMA_THREAD_COUNT);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_sm_rma_post_chunks(na_class_t *na_class, struct na_sm_op_id *na_sm_op_id,
+    struct na_sm_addr *na_sm_addr,
+    struct na_sm_mem_handle *na_sm_mem_handle_local, na_offset_t local_offset,
+    struct na_sm_mem_handle *na_sm_mem_handle_remote,
+    na_offset_t remote_offset, na_size_t length, unsigned int chunk_count)
+{
+    na_size_t chunk_size = length / chunk_count;
+    struct na_sm_rma_chunk *chunks;
+    struct iovec *iov;
+    na_return_t ret = NA_SUCCESS;
+    unsigned int i;
+
+    /* Chunks and their iovecs are allocated at once */
+    chunks = (struct na_sm_rma_chunk *) malloc(chunk_count
+        * (sizeof(struct na_sm_rma_chunk) + (na_sm_mem_handle_local->iovcnt
+        + na_sm_mem_handle_remote->iovcnt) * sizeof(struct iovec)));
+    if (!chunks) {
+        NA_LOG_ERROR("Could not allocate RMA chunks");
+        ret = NA_NOMEM_ERROR;
+        goto done;
+    }
+    iov = (struct iovec *) (chunks + chunk_count);
+
+    for (i = 0; i < chunk_count; i++) {
+        struct na_sm_rma_chunk *chunk = &chunks[i];
+        na_size_t chunk_offset = i * chunk_size;
+
+        chunk->work.func = na_sm_rma_chunk_process;
+        chunk->work.args = chunk;
+        chunk->na_sm_op_id = na_sm_op_id;
+        chunk->pid = na_sm_addr->pid;
+        chunk->length = (i == chunk_count - 1) ?
+            length - chunk_offset : chunk_size;
+
+        /* Disjoint iovec ranges */
+        chunk->local_iov = iov;
+        iov += na_sm_mem_handle_local->iovcnt;
+        na_sm_offset_translate(na_sm_mem_handle_local,
+            local_offset + chunk_offset, chunk->length, chunk->local_iov,
+            &chunk->liovcnt);
+        chunk->remote_iov = iov;
+        iov += na_sm_mem_handle_remote->iovcnt;
+        na_sm_offset_translate(na_sm_mem_handle_remote,
+            remote_offset + chunk_offset, chunk->length, chunk->remote_iov,
+            &chunk->riovcnt);
+        chunk->arena = na_sm_arena_translate(na_class, na_sm_addr,
+            na_sm_mem_handle_remote, chunk->remote_iov, chunk->riovcnt,
+            chunk->remote_iov);
+    }
+
+    na_sm_op_id->info.rma.chunks = chunks;
+    hg_atomic_set32(&na_sm_op_id->info.rma.pending, (hg_util_int32_t)
+        chunk_count);
+
+    /* Chunks that cannot be posted are transferred by the caller */
+    for (i = 0; i < chunk_count; i++) {
+        if (hg_thread_pool_post(NA_SM_CLASS(na_class)->rma_pool,
+            &chunks[i].work) != HG_UTIL_SUCCESS)
+            na_sm_rma_chunk_process(&chunks[i]);
+    }
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static HG_THREAD_RETURN_TYPE
+na_sm_rma_chunk_process(void *arg)
+{
+    struct na_sm_rma_chunk *chunk = (struct na_sm_rma_chunk *) arg;
+    struct na_sm_op_id *na_sm_op_id = chunk->na_sm_op_id;
+    na_class_t *na_class = na_sm_op_id->na_class;
+    hg_thread_ret_t thread_ret = (hg_thread_ret_t) 0;
+    na_return_t ret;
+
+    ret = na_sm_rma_transfer(na_sm_op_id->completion_data.callback_info.type,
+        chunk->pid, chunk->arena, chunk->local_iov, chunk->liovcnt,
+        chunk->remote_iov, chunk->riovcnt, chunk->length);
+    if (ret != NA_SUCCESS)
+        hg_atomic_cas32(&na_sm_op_id->info.rma.ret, NA_SUCCESS, ret);
+
+    /* Last chunk completes the operation */
+    if (hg_atomic_decr32(&na_sm_op_id->info.rma.pending))
+        goto done;
+
+    free(na_sm_op_id->info.rma.chunks);
+    na_sm_op_id->info.rma.chunks = NULL;
+
+    ret = na_sm_complete(na_sm_op_id);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not complete operation");
+        goto done;
+    }
+
+    ret = na_sm_notify_local(na_class);
+    if (ret != NA_SUCCESS)
+        NA_LOG_ERROR("Could not notify local completion");
+
+done:
+    return thread_ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_sm_create_sock(const char *pathname, na_bool_t na_listen, int *sock)
+{
+    struct sockaddr_un addr;
+    na_return_t ret = NA_SUCCESS;
+    int fd;
+
+    /* Create a non-blocking socket so that we can poll for incoming connections */
+#ifdef SOCK_NONBLOCK
+    fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK, 0);
+#else
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+#endif
+    if (fd == -1) {
+        NA_LOG_ERROR("socket() failed (%s)", strerror(errno));
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+#ifndef SOCK_NONBLOCK
+    if (fcntl(fd, F_SETFL, O_NONBLOCK) == -1) {
+        NA_LOG_ERROR("fcntl() failed (%s)", strerror(errno));
         ret = NA_PROTOCOL_ERROR;
         goto done;
     };
@@ -1196,6 +2008,37 @@ na_sm_cleanup_shm(const char *fpath, const struct stat NA_UNUSED *sb,
     return ret;
 }
 
+/*---------------------------------------------------------------------------*/
+static void
+na_sm_cleanup_hugetlbfs(const char *path)
+{
+    char prefix[NA_SM_MAX_FILENAME], pathname[PATH_MAX];
+    struct dirent *entry;
+    DIR *dir;
+
+    /* Segments are only created at the top of the mount, which may be
+     * shared with other applications, so do not walk the whole tree */
+    dir = opendir(path);
+    if (!dir) {
+        if (errno != ENOENT)
+            NA_LOG_WARNING("opendir() failed (%s)", strerror(errno));
+        return;
+    }
+
+    snprintf(prefix, NA_SM_MAX_FILENAME, "%s_%s-", NA_SM_SHM_PREFIX,
+        getlogin_safe());
+    while ((entry = readdir(dir)) != NULL) {
+        if (strncmp(entry->d_name, prefix, strlen(prefix)) != 0)
+            continue;
+        snprintf(pathname, PATH_MAX, "%s/%s", path, entry->d_name);
+        if (remove(pathname) != 0)
+            NA_LOG_WARNING("Could not remove %s (%s)", pathname,
+                strerror(errno));
+    }
+
+    closedir(dir);
+}
+
 /*---------------------------------------------------------------------------*/
 #ifndef HG_UTIL_HAS_SYSEVENTFD_H
 
@@ -1303,6 +2146,7 @@ na_sm_poll_register(na_class_t *na_class, na_sm_poll_type_t poll_type,
 {
     struct na_sm_poll_data *na_sm_poll_data = NULL;
     struct na_sm_poll_data **na_sm_poll_data_ptr = NULL;
+    struct na_sm_ext_poll_set *na_sm_ext_poll_set;
     unsigned int flags = HG_POLLIN;
     int fd;
     na_return_t ret = NA_SUCCESS;
@@ -1335,6 +2179,7 @@ na_sm_poll_register(na_class_t *na_class, na_sm_poll_type_t poll_type,
     na_sm_poll_data->na_class = na_class;
     na_sm_poll_data->type = poll_type;
     na_sm_poll_data->addr = na_sm_addr;
+    na_sm_poll_data->fd = fd;
     *na_sm_poll_data_ptr = na_sm_poll_data;
 
     if (hg_poll_add(NA_SM_CLASS(na_class)->poll_set, fd, flags,
@@ -1344,6 +2189,20 @@ na_sm_poll_register(na_class_t *na_class, na_sm_poll_type_t poll_type,
         goto done;
     }
 
+    /* Also add fd to external poll sets */
+    hg_thread_mutex_lock(&NA_SM_CLASS(na_class)->poll_data_list_lock);
+    HG_LIST_INSERT_HEAD(&NA_SM_CLASS(na_class)->poll_data_list,
+        na_sm_poll_data, entry);
+    HG_LIST_FOREACH(na_sm_ext_poll_set,
+        &NA_SM_CLASS(na_class)->ext_poll_set_list, entry) {
+        if (hg_poll_add(na_sm_ext_poll_set->poll_set, fd, flags,
+            na_sm_progress_cb, na_sm_poll_data) != HG_UTIL_SUCCESS) {
+            NA_LOG_ERROR("hg_poll_add failed");
+            ret = NA_PROTOCOL_ERROR;
+        }
+    }
+    hg_thread_mutex_unlock(&NA_SM_CLASS(na_class)->poll_data_list_lock);
+
 done:
     return ret;
 }
@@ -1355,6 +2214,7 @@ na_sm_poll_deregister(na_class_t *na_class, na_sm_poll_type_t poll_type,
 {
     int fd;
     struct na_sm_poll_data *na_sm_poll_data = NULL;
+    struct na_sm_ext_poll_set *na_sm_ext_poll_set;
     na_return_t ret = NA_SUCCESS;
 
     switch (poll_type) {
@@ -1376,6 +2236,20 @@ na_sm_poll_deregister(na_class_t *na_class, na_sm_poll_type_t poll_type,
             goto done;
     }
 
+    hg_thread_mutex_lock(&NA_SM_CLASS(na_class)->poll_data_list_lock);
+    HG_LIST_REMOVE(na_sm_poll_data, entry);
+    HG_LIST_FOREACH(na_sm_ext_poll_set,
+        &NA_SM_CLASS(na_class)->ext_poll_set_list, entry) {
+        if (hg_poll_remove(na_sm_ext_poll_set->poll_set, fd)
+            != HG_UTIL_SUCCESS) {
+            NA_LOG_ERROR("hg_poll_remove failed");
+            ret = NA_PROTOCOL_ERROR;
+        }
+    }
+    hg_thread_mutex_unlock(&NA_SM_CLASS(na_class)->poll_data_list_lock);
+    if (ret != NA_SUCCESS)
+        goto done;
+
     if (hg_poll_remove(NA_SM_CLASS(na_class)->poll_set,
         fd) != HG_UTIL_SUCCESS) {
         NA_LOG_ERROR("hg_poll_remove failed");
@@ -1392,25 +2266,11 @@ done:
 static na_return_t
 na_sm_setup_shm(na_class_t *na_class, struct na_sm_addr *na_sm_addr)
 {
-    char filename[NA_SM_MAX_FILENAME], pathname[NA_SM_MAX_FILENAME];
-    struct na_sm_copy_buf *na_sm_copy_buf = NULL;
+    char pathname[NA_SM_MAX_FILENAME];
     int listen_sock;
     na_return_t ret = NA_SUCCESS;
 
-    /* Create SHM buffer */
-    NA_SM_GEN_SHM_NAME(filename, NA_SM_CLASS(na_class)->username, na_sm_addr);
-    na_sm_copy_buf = (struct na_sm_copy_buf *) na_sm_open_shared_buf(
-        filename, sizeof(struct na_sm_copy_buf), NA_TRUE);
-    if (!na_sm_copy_buf) {
-        NA_LOG_ERROR("Could not create copy buffer");
-        ret = NA_PROTOCOL_ERROR;
-        goto done;
-    }
-    /* Initialize copy buf, store 1111111111...1111 */
-    hg_atomic_init64(&na_sm_copy_buf->available.val, ~((hg_util_int64_t)0));
-    na_sm_addr->na_sm_copy_buf = na_sm_copy_buf;
-
-    /* Create SHM sock */
+    /* Create SHM sock, copy buffers are created per connection */
     NA_SM_GEN_SOCK_PATH(pathname, NA_SM_CLASS(na_class)->username, na_sm_addr);
     ret = na_sm_create_sock(pathname, NA_TRUE, &listen_sock);
     if (ret != NA_SUCCESS) {
@@ -1433,67 +2293,6 @@ done:
 /*---------------------------------------------------------------------------*/
 static na_return_t
 na_sm_send_addr_info(na_class_t *na_class, struct na_sm_addr *na_sm_addr)
-{
-    struct msghdr msg = NA_SM_MSGHDR_INITIALIZER;
-    ssize_t nsend;
-    struct iovec iovec[2];
-    na_return_t ret = NA_SUCCESS;
-
-    /* Send local PID / ID */
-    iovec[0].iov_base = &NA_SM_CLASS(na_class)->self_addr->pid;
-    iovec[0].iov_len = sizeof(pid_t);
-    iovec[1].iov_base = &NA_SM_CLASS(na_class)->self_addr->id;
-    iovec[1].iov_len = sizeof(unsigned int);
-    msg.msg_iov = iovec;
-    msg.msg_iovlen = 2;
-
-    nsend = sendmsg(na_sm_addr->sock, &msg, 0);
-    if (nsend == -1) {
-        NA_LOG_ERROR("sendmsg() failed (%s)", strerror(errno));
-        ret = NA_PROTOCOL_ERROR;
-        goto done;
-    }
-
-done:
-    return ret;
-}
-
-/*---------------------------------------------------------------------------*/
-static na_return_t
-na_sm_recv_addr_info(struct na_sm_addr *na_sm_addr, na_bool_t *received)
-{
-    struct msghdr msg = NA_SM_MSGHDR_INITIALIZER;
-    ssize_t nrecv;
-    struct iovec iovec[2];
-    na_return_t ret = NA_SUCCESS;
-
-    /* Receive remote PID / ID */
-    iovec[0].iov_base = &na_sm_addr->pid;
-    iovec[0].iov_len = sizeof(pid_t);
-    iovec[1].iov_base = &na_sm_addr->id;
-    iovec[1].iov_len = sizeof(unsigned int);
-    msg.msg_iov = iovec;
-    msg.msg_iovlen = 2;
-
-    nrecv = recvmsg(na_sm_addr->sock, &msg, 0);
-    if (nrecv == -1) {
-        if (errno == EAGAIN) {
-            *received = NA_FALSE;
-            goto done;
-        }
-        NA_LOG_ERROR("recvmsg() failed (%s)", strerror(errno));
-        ret = NA_PROTOCOL_ERROR;
-        goto done;
-    }
-    *received = NA_TRUE;
-
-done:
-    return ret;
-}
-
-/*---------------------------------------------------------------------------*/
-static na_return_t
-na_sm_send_conn_id(struct na_sm_addr *na_sm_addr)
 {
     struct msghdr msg = NA_SM_MSGHDR_INITIALIZER;
     struct cmsghdr *cmsg;
@@ -1506,15 +2305,19 @@ na_sm_send_conn_id(struct na_sm_addr *na_sm_addr)
         struct cmsghdr align;
     } u;
     int *fdptr;
-    struct iovec iovec[1];
+    struct iovec iovec[3];
     ssize_t nsend;
     na_return_t ret = NA_SUCCESS;
 
-    /* Send local PID / ID */
-    iovec[0].iov_base = &na_sm_addr->conn_id;
-    iovec[0].iov_len = sizeof(unsigned int);
+    /* Send local PID / ID and the connection ID used to name ring bufs */
+    iovec[0].iov_base = &NA_SM_CLASS(na_class)->self_addr->pid;
+    iovec[0].iov_len = sizeof(pid_t);
+    iovec[1].iov_base = &NA_SM_CLASS(na_class)->self_addr->id;
+    iovec[1].iov_len = sizeof(unsigned int);
+    iovec[2].iov_base = &na_sm_addr->conn_id;
+    iovec[2].iov_len = sizeof(unsigned int);
     msg.msg_iov = iovec;
-    msg.msg_iovlen = 1;
+    msg.msg_iovlen = 3;
 
     /* Send notify event descriptors as ancillary data */
     msg.msg_control = u.buf;
@@ -1541,7 +2344,7 @@ done:
 
 /*---------------------------------------------------------------------------*/
 static na_return_t
-na_sm_recv_conn_id(struct na_sm_addr *na_sm_addr, na_bool_t *received)
+na_sm_recv_addr_info(struct na_sm_addr *na_sm_addr, na_bool_t *received)
 {
     struct msghdr msg = NA_SM_MSGHDR_INITIALIZER;
     struct cmsghdr *cmsg;
@@ -1554,14 +2357,18 @@ na_sm_recv_conn_id(struct na_sm_addr *na_sm_addr, na_bool_t *received)
         struct cmsghdr align;
     } u;
     ssize_t nrecv;
-    struct iovec iovec[1];
+    struct iovec iovec[3];
     na_return_t ret = NA_SUCCESS;
 
-    /* Receive remote PID / ID */
-    iovec[0].iov_base = &na_sm_addr->conn_id;
-    iovec[0].iov_len = sizeof(unsigned int);
+    /* Receive remote PID / ID / connection ID */
+    iovec[0].iov_base = &na_sm_addr->pid;
+    iovec[0].iov_len = sizeof(pid_t);
+    iovec[1].iov_base = &na_sm_addr->id;
+    iovec[1].iov_len = sizeof(unsigned int);
+    iovec[2].iov_base = &na_sm_addr->conn_id;
+    iovec[2].iov_len = sizeof(unsigned int);
     msg.msg_iov = iovec;
-    msg.msg_iovlen = 1;
+    msg.msg_iovlen = 3;
 
     /* Recv notify event descriptor as ancillary data */
     msg.msg_control = u.buf;
@@ -1654,81 +2461,144 @@ na_sm_ring_buf_is_empty(struct na_sm_ring_buf *na_sm_ring_buf)
 }
 
 /*---------------------------------------------------------------------------*/
-static NA_INLINE na_return_t
-na_sm_reserve_and_copy_buf(na_class_t *na_class,
-    struct na_sm_copy_buf *na_sm_copy_buf, const void *buf, size_t buf_size,
-    unsigned int *idx_reserved)
+static void
+na_sm_copy_buf_init(struct na_sm_copy_buf *na_sm_copy_buf)
 {
-    hg_util_int64_t bits = 1LL;
-    na_return_t ret = NA_SIZE_ERROR;
-    unsigned int i = 0;
+    unsigned int i;
 
-    hg_thread_spin_lock(&NA_SM_CLASS(na_class)->copy_buf_lock);
+    /* Store 1111111111...1111 in each word */
+    for (i = 0; i < NA_SM_NUM_BUF_WORDS; i++)
+        hg_atomic_init64(&na_sm_copy_buf->available[i].val,
+            ~((hg_util_int64_t)0));
+    hg_atomic_init32(&na_sm_copy_buf->next_word.val, 0);
+}
 
-    do {
-        hg_util_int64_t available = hg_atomic_get64(
-            &na_sm_copy_buf->available.val);
-        if (!available)
-            /* Nothing available */
-            break;
-        if ((available & bits) != bits) {
-            /* Already reserved */
-            hg_atomic_fence();
-            i++;
-            bits <<= 1;
-            continue;
-        }
+/*---------------------------------------------------------------------------*/
+static NA_INLINE na_return_t
+na_sm_reserve_and_copy_buf(struct na_sm_copy_buf *na_sm_copy_buf,
+    const void *buf, size_t buf_size, unsigned int *idx_reserved)
+{
+    unsigned int count = NA_SM_BUF_COUNT(buf_size);
+    hg_util_uint64_t mask = (1ULL << count) - 1;
+    unsigned int first_word, w;
+
+    /* Concurrent senders start from different words */
+    first_word = (unsigned int) hg_atomic_incr32(
+        &na_sm_copy_buf->next_word.val);
+
+    for (w = 0; w < NA_SM_NUM_BUF_WORDS; w++) {
+        unsigned int word = (first_word + w) % NA_SM_NUM_BUF_WORDS;
+        hg_atomic_int64_t *available_ptr =
+            &na_sm_copy_buf->available[word].val;
+        hg_util_uint64_t bits = mask;
+        unsigned int i = 0;
+
+        while (i + count <= NA_SM_BUF_WORD_BITS) {
+            hg_util_uint64_t available =
+                (hg_util_uint64_t) hg_atomic_get64(available_ptr);
+
+            if ((available >> i) == 0)
+                /* Nothing available in the rest of this word */
+                break;
+            if ((available & bits) != bits) {
+                /* Already reserved */
+                i++;
+                bits <<= 1;
+                continue;
+            }
 
-        if (hg_atomic_cas64(&na_sm_copy_buf->available.val, available,
-            available & ~bits)) {
-            /* Reservation succeeded, copy buffer */
-            memcpy(na_sm_copy_buf->buf[i], buf, buf_size);
-            *idx_reserved = i;
-//            NA_LOG_DEBUG("Reserved %u is:\n%s", i,
-//                itoa(hg_atomic_get64(&na_sm_copy_buf->available.val), 2));
-            ret = NA_SUCCESS;
-            break;
+            /* If there is a race and the cas fails, retry at the same index
+             * with the new mask value */
+            if (hg_atomic_cas64(available_ptr, (hg_util_int64_t) available,
+                (hg_util_int64_t) (available & ~bits))) {
+                *idx_reserved = word * NA_SM_BUF_WORD_BITS + i;
+
+                /* Slots are owned until the receiver frees them, copy without
+                 * holding anything */
+                memcpy(na_sm_copy_buf->buf[*idx_reserved], buf, buf_size);
+                return NA_SUCCESS;
+            }
         }
-        /* Can't use atomic XOR directly, if there is a race and the cas
-         * fails, we should be able to pick the next one available */
-    } while (i < (NA_SM_NUM_BUFS - 1));
+    }
 
-    hg_thread_spin_unlock(&NA_SM_CLASS(na_class)->copy_buf_lock);
-    return ret;
+    return NA_SIZE_ERROR;
 }
 
 /*---------------------------------------------------------------------------*/
 static NA_INLINE void
-na_sm_copy_and_free_buf(na_class_t *na_class,
-    struct na_sm_copy_buf *na_sm_copy_buf, void *buf, size_t buf_size,
-    unsigned int idx_reserved)
+na_sm_copy_and_free_buf(struct na_sm_copy_buf *na_sm_copy_buf, void *buf,
+    size_t buf_size, unsigned int idx_reserved)
 {
-    hg_util_int64_t bits = 1LL << idx_reserved;
+    hg_atomic_int64_t *available_ptr = &na_sm_copy_buf->available[
+        idx_reserved / NA_SM_BUF_WORD_BITS].val;
+    hg_util_int64_t bits = (hg_util_int64_t)
+        (((1ULL << NA_SM_BUF_COUNT(buf_size)) - 1)
+        << (idx_reserved % NA_SM_BUF_WORD_BITS));
 #if defined(HG_UTIL_HAS_OPA_PRIMITIVES_H)
     hg_util_int64_t available;
 #endif
 
-    hg_thread_spin_lock(&NA_SM_CLASS(na_class)->copy_buf_lock);
-
-    memcpy(buf, na_sm_copy_buf->buf[idx_reserved], buf_size);
+    if (buf)
+        memcpy(buf, na_sm_copy_buf->buf[idx_reserved], buf_size);
 
 #if !defined(HG_UTIL_HAS_OPA_PRIMITIVES_H)
-    hg_atomic_or64(&na_sm_copy_buf->available.val, bits);
+    hg_atomic_or64(available_ptr, bits);
 #else
     do {
-        available = hg_atomic_get64(&na_sm_copy_buf->available.val);
-    } while (!hg_atomic_cas64(&na_sm_copy_buf->available.val, available,
-        (available | bits)));
+        available = hg_atomic_get64(available_ptr);
+    } while (!hg_atomic_cas64(available_ptr, available, (available | bits)));
 #endif
-
-    hg_thread_spin_unlock(&NA_SM_CLASS(na_class)->copy_buf_lock);
+}
+
+/*---------------------------------------------------------------------------*/
+static void *
+na_sm_loan_buf(na_class_t *na_class, struct na_sm_addr *na_sm_addr,
+    size_t buf_size, unsigned int idx_reserved)
+{
+    hg_util_int32_t count = (hg_util_int32_t) NA_SM_BUF_COUNT(buf_size);
+    hg_util_int32_t loan_count;
+    struct na_sm_loan_copy *na_sm_loan_copy;
+
+    do {
+        loan_count = hg_atomic_get32(&na_sm_addr->loan_count);
+        if (loan_count + count > NA_SM_LOAN_MAX_BUFS)
+            break;
+    } while (!hg_atomic_cas32(&na_sm_addr->loan_count, loan_count,
+        loan_count + count));
+    if (loan_count + count <= NA_SM_LOAN_MAX_BUFS)
+        return na_sm_addr->na_sm_copy_buf->buf[idx_reserved];
+
+    /* Receiver holds on to too many slots, the sender would spin waiting for
+     * them to be released */
+    na_sm_loan_copy = (struct na_sm_loan_copy *) malloc(
+        sizeof(struct na_sm_loan_copy) + buf_size);
+    if (!na_sm_loan_copy) {
+        NA_LOG_WARNING("Could not allocate copy, loaning slots past limit");
+        do {
+            loan_count = hg_atomic_get32(&na_sm_addr->loan_count);
+        } while (!hg_atomic_cas32(&na_sm_addr->loan_count, loan_count,
+            loan_count + count));
+        return na_sm_addr->na_sm_copy_buf->buf[idx_reserved];
+    }
+    na_sm_loan_copy->na_sm_addr = na_sm_addr;
+    na_sm_loan_copy->buf = na_sm_loan_copy + 1;
+    na_sm_copy_and_free_buf(na_sm_addr->na_sm_copy_buf, na_sm_loan_copy->buf,
+        buf_size, idx_reserved);
+
+    hg_thread_spin_lock(&NA_SM_CLASS(na_class)->loan_copy_list_lock);
+    HG_LIST_INSERT_HEAD(&NA_SM_CLASS(na_class)->loan_copy_list,
+        na_sm_loan_copy, entry);
+    hg_thread_spin_unlock(&NA_SM_CLASS(na_class)->loan_copy_list_lock);
+
+    return na_sm_loan_copy->buf;
 }
 
 /*---------------------------------------------------------------------------*/
 static na_return_t
 na_sm_msg_insert(na_class_t *na_class, struct na_sm_op_id *na_sm_op_id,
     na_cb_type_t cb_type, struct na_sm_addr *na_sm_addr,
-    unsigned int idx_reserved, na_size_t buf_size, na_tag_t tag)
+    unsigned int idx_reserved, na_size_t buf_size, na_tag_t tag,
+    na_bool_t notify)
 {
     na_sm_cacheline_hdr_t na_sm_hdr;
     na_return_t ret = NA_SUCCESS;
@@ -1736,11 +2606,11 @@ na_sm_msg_insert(na_class_t *na_class, struct na_sm_op_id *na_sm_op_id,
     /* Post the SM send request */
     na_sm_hdr.hdr.type = cb_type;
     na_sm_hdr.hdr.buf_idx = idx_reserved & 0xff;
-    na_sm_hdr.hdr.buf_size = buf_size & 0xffff;
+    na_sm_hdr.hdr.buf_size = buf_size & 0xfffff;
     na_sm_hdr.hdr.tag = tag;
     if (!na_sm_ring_buf_push(na_sm_addr->na_sm_send_ring_buf, na_sm_hdr)) {
-        NA_LOG_ERROR("Full ring buffer");
-        ret = NA_PROTOCOL_ERROR;
+        /* Full ring buffer, caller must retry */
+        ret = NA_AGAIN;
         goto done;
     }
 
@@ -1751,33 +2621,77 @@ na_sm_msg_insert(na_class_t *na_class, struct na_sm_op_id *na_sm_op_id,
         goto done;
     }
 
+    /* Batched messages are notified by the caller */
+    if (!notify)
+        goto done;
+
     /* Notify remote */
-    if (!NA_SM_CLASS(na_class)->no_wait) {
+    ret = na_sm_notify_remote(na_class, na_sm_addr, 1);
+    if (ret != NA_SUCCESS)
+        goto done;
+
+    /* Notify local completion */
+    ret = na_sm_notify_local(na_class);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static NA_INLINE na_return_t
+na_sm_notify_remote(na_class_t *na_class, struct na_sm_addr *na_sm_addr,
+    unsigned int count)
+{
+    na_return_t ret = NA_SUCCESS;
+
+    if (NA_SM_CLASS(na_class)->no_wait)
+        goto done;
+
 #ifdef HG_UTIL_HAS_SYSEVENTFD_H
-        if (hg_event_set(na_sm_addr->remote_notify) != HG_UTIL_SUCCESS) {
-            NA_LOG_ERROR("Could not send completion notification");
+    /* Notification fds are semaphores, a single write of count lets the
+     * remote process count messages */
+    if (count > 1) {
+        uint64_t value = count;
+
+        if (write(na_sm_addr->remote_notify, &value, sizeof(value))
+            != sizeof(value) && errno != EAGAIN) {
+            NA_LOG_ERROR("write() failed (%s)", strerror(errno));
             ret = NA_PROTOCOL_ERROR;
-            goto done;
         }
+        goto done;
+    }
+    if (hg_event_set(na_sm_addr->remote_notify) != HG_UTIL_SUCCESS) {
+        NA_LOG_ERROR("Could not send completion notification");
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
 #else
+    while (count--) {
         if (na_sm_event_set(na_sm_addr->remote_notify) != NA_SUCCESS) {
             NA_LOG_ERROR("Could not send completion notification");
             ret = NA_PROTOCOL_ERROR;
             goto done;
         }
-#endif
     }
+#endif
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static NA_INLINE na_return_t
+na_sm_notify_local(na_class_t *na_class)
+{
+    na_return_t ret = NA_SUCCESS;
 
-    /* Notify local completion */
     if (!NA_SM_CLASS(na_class)->no_wait
         && (hg_event_set(NA_SM_CLASS(na_class)->self_addr->local_notify)
         != HG_UTIL_SUCCESS)) {
         NA_LOG_ERROR("Could not signal local completion");
         ret = NA_PROTOCOL_ERROR;
-        goto done;
     }
 
-done:
     return ret;
 }
 
@@ -1904,9 +2818,7 @@ na_sm_progress_accept(na_class_t *na_class, struct na_sm_addr *poll_addr,
     na_bool_t *progressed)
 {
     struct na_sm_addr *na_sm_addr = NULL;
-    struct na_sm_ring_buf *na_sm_ring_buf = NULL;
-    char filename[NA_SM_MAX_FILENAME];
-    int conn_sock, local_notify, remote_notify;
+    int conn_sock;
     hg_time_t now;
     double elapsed_ms;
     na_return_t ret = NA_SUCCESS;
@@ -1918,7 +2830,7 @@ na_sm_progress_accept(na_class_t *na_class, struct na_sm_addr *poll_addr,
     }
 
     /* Prevent from entering accept too often */
-    hg_time_get_current(&now);
+    hg_time_get_current_coarse(&now);
     elapsed_ms = hg_time_to_double(hg_time_subtract(now,
         NA_SM_CLASS(na_class)->last_accept_time)) * 1000.0;
     if (elapsed_ms < NA_SM_ACCEPT_INTERVAL) {
@@ -1958,11 +2870,14 @@ na_sm_progress_accept(na_class_t *na_class, struct na_sm_addr *poll_addr,
     }
     memset(na_sm_addr, 0, sizeof(struct na_sm_addr));
     hg_atomic_init32(&na_sm_addr->ref_count, 1);
+    hg_atomic_init32(&na_sm_addr->loan_count, 0);
     na_sm_addr->accepted = NA_TRUE;
-    na_sm_addr->na_sm_copy_buf = poll_addr->na_sm_copy_buf;
     na_sm_addr->sock = conn_sock;
-    /* We need to receive addr info in sock progress */
+    /* Ring bufs, copy buf and notify fds are set up by the connecting peer,
+     * we only need to receive addr info in sock progress */
     na_sm_addr->sock_progress = NA_SM_ADDR_INFO;
+    na_sm_addr->local_notify = -1;
+    na_sm_addr->remote_notify = -1;
 
     /* Add conn_sock to poll set */
     ret = na_sm_poll_register(na_class, NA_SM_SOCK, na_sm_addr);
@@ -1971,101 +2886,6 @@ na_sm_progress_accept(na_class_t *na_class, struct na_sm_addr *poll_addr,
         goto done;
     }
 
-    /* Set up ring buffer pair (send/recv) for connection IDs */
-    na_sm_addr->conn_id = NA_SM_CLASS(na_class)->self_addr->conn_id;
-    NA_SM_GEN_RING_NAME(filename, NA_SM_SEND_NAME,
-        NA_SM_CLASS(na_class)->username, NA_SM_CLASS(na_class)->self_addr);
-    na_sm_ring_buf = (struct na_sm_ring_buf *) na_sm_open_shared_buf(filename,
-        NA_SM_RING_BUF_SIZE, NA_TRUE);
-    if (!na_sm_ring_buf) {
-        NA_LOG_ERROR("Could not open ring buf");
-        ret = NA_PROTOCOL_ERROR;
-        goto done;
-    }
-    /* Initialize ring buffer */
-    na_sm_ring_buf_init(na_sm_ring_buf);
-    na_sm_addr->na_sm_send_ring_buf = na_sm_ring_buf;
-
-    NA_SM_GEN_RING_NAME(filename, NA_SM_RECV_NAME,
-        NA_SM_CLASS(na_class)->username, NA_SM_CLASS(na_class)->self_addr);
-    na_sm_ring_buf = (struct na_sm_ring_buf *) na_sm_open_shared_buf(filename,
-        NA_SM_RING_BUF_SIZE, NA_TRUE);
-    if (!na_sm_ring_buf) {
-        NA_LOG_ERROR("Could not open ring buf");
-        ret = NA_PROTOCOL_ERROR;
-        goto done;
-    }
-    /* Initialize ring buffer */
-    na_sm_ring_buf_init(na_sm_ring_buf);
-    na_sm_addr->na_sm_recv_ring_buf = na_sm_ring_buf;
-
-    /* Create local signal event */
-#ifdef HG_UTIL_HAS_SYSEVENTFD_H
-    local_notify = hg_event_create();
-    if (local_notify == HG_UTIL_FAIL) {
-        NA_LOG_ERROR("hg_event_create() failed");
-        ret = NA_PROTOCOL_ERROR;
-        goto done;
-    }
-#else
-    /**
-     * If eventfd is not supported, we need to explicitly use named pipes in
-     * this case as kqueue file descriptors cannot be exchanged through
-     * ancillary data
-     */
-    NA_SM_GEN_FIFO_NAME(filename, NA_SM_RECV_NAME,
-        NA_SM_CLASS(na_class)->username, NA_SM_CLASS(na_class)->self_addr);
-    local_notify = na_sm_event_create(filename);
-    if (local_notify == -1) {
-        NA_LOG_ERROR("na_sm_event_create() failed");
-        ret = NA_PROTOCOL_ERROR;
-        goto done;
-    }
-#endif
-    na_sm_addr->local_notify = local_notify;
-
-    /* Create remote signal event */
-#ifdef HG_UTIL_HAS_SYSEVENTFD_H
-    remote_notify = hg_event_create();
-    if (remote_notify == HG_UTIL_FAIL) {
-        NA_LOG_ERROR("hg_event_create() failed");
-        ret = NA_PROTOCOL_ERROR;
-        goto done;
-    }
-#else
-    /**
-     * If eventfd is not supported, we need to explicitly use named pipes in
-     * this case as kqueue file descriptors cannot be exchanged through
-     * ancillary data
-     */
-    NA_SM_GEN_FIFO_NAME(filename, NA_SM_SEND_NAME,
-        NA_SM_CLASS(na_class)->username, NA_SM_CLASS(na_class)->self_addr);
-    remote_notify = na_sm_event_create(filename);
-    if (remote_notify == -1) {
-        NA_LOG_ERROR("na_sm_event_create() failed");
-        ret = NA_PROTOCOL_ERROR;
-        goto done;
-    }
-#endif
-    na_sm_addr->remote_notify = remote_notify;
-
-    /* Add local notify to poll set */
-    ret = na_sm_poll_register(na_class, NA_SM_NOTIFY, na_sm_addr);
-    if (ret != NA_SUCCESS) {
-        NA_LOG_ERROR("Could not add notify to poll set");
-        goto done;
-    }
-
-    /* Send connection ID / event IDs */
-    ret = na_sm_send_conn_id(na_sm_addr);
-    if (ret != NA_SUCCESS) {
-        NA_LOG_ERROR("Could not send connection ID");
-        goto done;
-    }
-
-    /* Increment connection ID */
-    NA_SM_CLASS(na_class)->self_addr->conn_id++;
-
     /* Push the addr to accepted addr queue so that we can free it later */
     hg_thread_spin_lock(&NA_SM_CLASS(na_class)->accepted_addr_queue_lock);
     HG_QUEUE_PUSH_TAIL(&NA_SM_CLASS(na_class)->accepted_addr_queue, na_sm_addr,
@@ -2092,42 +2912,15 @@ na_sm_progress_sock(na_class_t *na_class, struct na_sm_addr *poll_addr,
 
     switch (poll_addr->sock_progress) {
         case NA_SM_ADDR_INFO: {
-            na_bool_t received = NA_FALSE;
-
-            /* Receive addr info (PID / ID) */
-            ret = na_sm_recv_addr_info(poll_addr, &received);
-            if (ret != NA_SUCCESS) {
-                NA_LOG_ERROR("Could not recv addr info");
-                ret = NA_PROTOCOL_ERROR;
-                goto done;
-            }
-            if (!received) {
-                *progressed = NA_FALSE;
-                goto done;
-            }
-
-            poll_addr->sock_progress = NA_SM_SOCK_DONE;
-
-            /* Add addr to poll addr queue */
-            hg_thread_spin_lock(&NA_SM_CLASS(na_class)->poll_addr_queue_lock);
-            HG_QUEUE_PUSH_TAIL(&NA_SM_CLASS(na_class)->poll_addr_queue,
-                poll_addr, poll_entry);
-            hg_thread_spin_unlock(&NA_SM_CLASS(na_class)->poll_addr_queue_lock);
-
-            /* Progressed */
-            *progressed = NA_TRUE;
-        }
-        break;
-        case NA_SM_CONN_ID: {
             char filename[NA_SM_MAX_FILENAME];
             struct na_sm_ring_buf *na_sm_ring_buf;
-            struct na_sm_op_id *na_sm_op_id = NULL;
+            struct na_sm_copy_buf *na_sm_copy_buf;
             na_bool_t received = NA_FALSE;
 
-            /* Receive connection ID / event IDs */
-            ret = na_sm_recv_conn_id(poll_addr, &received);
+            /* Receive addr info (PID / ID / connection ID / event IDs) */
+            ret = na_sm_recv_addr_info(poll_addr, &received);
             if (ret != NA_SUCCESS) {
-                NA_LOG_ERROR("Could not recv connection ID");
+                NA_LOG_ERROR("Could not recv addr info");
                 ret = NA_PROTOCOL_ERROR;
                 goto done;
             }
@@ -2135,33 +2928,15 @@ na_sm_progress_sock(na_class_t *na_class, struct na_sm_addr *poll_addr,
                 *progressed = NA_FALSE;
                 goto done;
             }
-            poll_addr->sock_progress = NA_SM_SOCK_DONE;
-
-            /* Find op ID that corresponds to addr */
-            hg_thread_spin_lock(&NA_SM_CLASS(na_class)->lookup_op_queue_lock);
-            HG_QUEUE_FOREACH(na_sm_op_id,
-                &NA_SM_CLASS(na_class)->lookup_op_queue, entry) {
-                if (na_sm_op_id->info.lookup.na_sm_addr == poll_addr) {
-                    HG_QUEUE_REMOVE(&NA_SM_CLASS(na_class)->lookup_op_queue,
-                        na_sm_op_id, na_sm_op_id, entry);
-                    break;
-                }
-            }
-            hg_thread_spin_unlock(&NA_SM_CLASS(na_class)->lookup_op_queue_lock);
-
-            if (!na_sm_op_id) {
-                NA_LOG_ERROR("Could not find lookup op ID, conn ID=%u, PID=%u",
-                    poll_addr->conn_id, (unsigned int) poll_addr->pid);
-                ret = NA_PROTOCOL_ERROR;
-                goto done;
-            }
 
             /* Open remote ring buf pair (send and recv names correspond to
              * remote ring buffer pair) */
             NA_SM_GEN_RING_NAME(filename, NA_SM_RECV_NAME,
-                NA_SM_CLASS(na_class)->username, poll_addr);
+                NA_SM_CLASS(na_class)->username, poll_addr->pid, poll_addr->id,
+                poll_addr->conn_id);
             na_sm_ring_buf = (struct na_sm_ring_buf *) na_sm_open_shared_buf(
-                filename, NA_SM_RING_BUF_SIZE, NA_FALSE);
+                na_class, filename, NA_SM_RING_BUF_SIZE, NA_FALSE,
+                &poll_addr->send_ring_buf_backing);
             if (!na_sm_ring_buf) {
                 NA_LOG_ERROR("Could not open ring buf");
                 ret = NA_PROTOCOL_ERROR;
@@ -2170,9 +2945,11 @@ na_sm_progress_sock(na_class_t *na_class, struct na_sm_addr *poll_addr,
             poll_addr->na_sm_send_ring_buf = na_sm_ring_buf;
 
             NA_SM_GEN_RING_NAME(filename, NA_SM_SEND_NAME,
-                NA_SM_CLASS(na_class)->username, poll_addr);
+                NA_SM_CLASS(na_class)->username, poll_addr->pid, poll_addr->id,
+                poll_addr->conn_id);
             na_sm_ring_buf = (struct na_sm_ring_buf *) na_sm_open_shared_buf(
-                filename, NA_SM_RING_BUF_SIZE, NA_FALSE);
+                na_class, filename, NA_SM_RING_BUF_SIZE, NA_FALSE,
+                &poll_addr->recv_ring_buf_backing);
             if (!na_sm_ring_buf) {
                 NA_LOG_ERROR("Could not open ring buf");
                 ret = NA_PROTOCOL_ERROR;
@@ -2180,26 +2957,36 @@ na_sm_progress_sock(na_class_t *na_class, struct na_sm_addr *poll_addr,
             }
             poll_addr->na_sm_recv_ring_buf = na_sm_ring_buf;
 
-            /* Add received local notify to poll set */
+            /* Open connection copy buf */
+            NA_SM_GEN_RING_NAME(filename, NA_SM_COPY_NAME,
+                NA_SM_CLASS(na_class)->username, poll_addr->pid, poll_addr->id,
+                poll_addr->conn_id);
+            na_sm_copy_buf = (struct na_sm_copy_buf *) na_sm_open_shared_buf(
+                na_class, filename, sizeof(struct na_sm_copy_buf), NA_FALSE,
+                &poll_addr->copy_buf_backing);
+            if (!na_sm_copy_buf) {
+                NA_LOG_ERROR("Could not open copy buf");
+                ret = NA_PROTOCOL_ERROR;
+                goto done;
+            }
+            poll_addr->na_sm_copy_buf = na_sm_copy_buf;
+
+            /* Add received local notify to poll set, messages that were
+             * posted before we got there are picked up from the event count */
             ret = na_sm_poll_register(na_class, NA_SM_NOTIFY, poll_addr);
             if (ret != NA_SUCCESS) {
                 NA_LOG_ERROR("Could not add notify to poll set");
                 goto done;
             }
 
+            poll_addr->sock_progress = NA_SM_SOCK_DONE;
+
             /* Add addr to poll addr queue */
             hg_thread_spin_lock(&NA_SM_CLASS(na_class)->poll_addr_queue_lock);
             HG_QUEUE_PUSH_TAIL(&NA_SM_CLASS(na_class)->poll_addr_queue,
                 poll_addr, poll_entry);
             hg_thread_spin_unlock(&NA_SM_CLASS(na_class)->poll_addr_queue_lock);
 
-            /* Completion */
-            ret = na_sm_complete(na_sm_op_id);
-            if (ret != NA_SUCCESS) {
-                NA_LOG_ERROR("Could not complete operation");
-                goto done;
-            }
-
             /* Progressed */
             *progressed = NA_TRUE;
         }
@@ -2321,8 +3108,8 @@ na_sm_progress_unexpected(na_class_t *na_class, struct na_sm_addr *poll_addr,
     } else {
         /* If no error and message arrived, keep a copy of the struct in
          * the unexpected message queue (should rarely happen) */
-        na_sm_unexpected_info = (struct na_sm_unexpected_info *) malloc(
-            sizeof(struct na_sm_unexpected_info));
+        na_sm_unexpected_info = (struct na_sm_unexpected_info *)
+            hg_mem_pool_alloc(NA_SM_CLASS(na_class)->unexpected_info_pool);
         if (!na_sm_unexpected_info) {
             NA_LOG_ERROR("Could not allocate unexpected info");
             ret = NA_NOMEM_ERROR;
@@ -2336,6 +3123,7 @@ na_sm_progress_unexpected(na_class_t *na_class, struct na_sm_addr *poll_addr,
         hg_thread_spin_lock(&NA_SM_CLASS(na_class)->unexpected_msg_queue_lock);
         HG_QUEUE_PUSH_TAIL(&NA_SM_CLASS(na_class)->unexpected_msg_queue,
             na_sm_unexpected_info, entry);
+        NA_SM_CLASS(na_class)->unexpected_msg_count++;
         hg_thread_spin_unlock(
             &NA_SM_CLASS(na_class)->unexpected_msg_queue_lock);
     }
@@ -2350,34 +3138,52 @@ na_sm_progress_expected(na_class_t *na_class, struct na_sm_addr *poll_addr,
     na_sm_cacheline_hdr_t na_sm_hdr)
 {
     struct na_sm_op_id *na_sm_op_id = NULL;
+    struct na_cb_info_recv_expected *recv_expected;
+    unsigned int bucket = NA_SM_EXPECTED_HASH(poll_addr, na_sm_hdr.hdr.tag);
     na_return_t ret = NA_SUCCESS;
 
+    /* Ops are pushed at the tail of their bucket, the first match is the
+     * oldest op posted with that (addr, tag) */
     hg_thread_spin_lock(
-        &NA_SM_CLASS(na_class)->expected_op_queue_lock);
+        &NA_SM_CLASS(na_class)->expected_op_table_lock);
     HG_QUEUE_FOREACH(na_sm_op_id,
-        &NA_SM_CLASS(na_class)->expected_op_queue, entry) {
+        &NA_SM_CLASS(na_class)->expected_op_table[bucket], expected_entry) {
         if (na_sm_op_id->info.recv_expected.na_sm_addr == poll_addr &&
             na_sm_op_id->info.recv_expected.tag == na_sm_hdr.hdr.tag) {
-            HG_QUEUE_REMOVE(&NA_SM_CLASS(na_class)->expected_op_queue,
-                na_sm_op_id, na_sm_op_id, entry);
+            HG_QUEUE_REMOVE(&NA_SM_CLASS(na_class)->expected_op_table[bucket],
+                na_sm_op_id, na_sm_op_id, expected_entry);
             break;
         }
     }
     hg_thread_spin_unlock(
-        &NA_SM_CLASS(na_class)->expected_op_queue_lock);
+        &NA_SM_CLASS(na_class)->expected_op_table_lock);
 
     if (!na_sm_op_id) {
         /* No match if either the message was not pre-posted or it was canceled */
         NA_LOG_WARNING("Ignored expected message received (canceled?)");
 //        NA_LOG_DEBUG("Expected: pid=%d, tag=%d", poll_addr->pid,
 //            na_sm_hdr.hdr.tag);
+        /* Release the slots so that the sender does not run out of them */
+        na_sm_copy_and_free_buf(poll_addr->na_sm_copy_buf, NULL,
+            na_sm_hdr.hdr.buf_size, na_sm_hdr.hdr.buf_idx);
         goto done;
     }
 
-    /* Copy and free buffer atomically */
-    na_sm_copy_and_free_buf(na_class, poll_addr->na_sm_copy_buf,
-        na_sm_op_id->info.recv_expected.buf, na_sm_hdr.hdr.buf_size,
-        na_sm_hdr.hdr.buf_idx);
+    recv_expected = &na_sm_op_id->completion_data.callback_info.info.
+        recv_expected;
+    recv_expected->actual_buf_size = (na_size_t) na_sm_hdr.hdr.buf_size;
+    if (na_sm_op_id->info.recv_expected.buf) {
+        recv_expected->actual_buf = na_sm_op_id->info.recv_expected.buf;
+
+        /* Copy and free buffer atomically */
+        na_sm_copy_and_free_buf(poll_addr->na_sm_copy_buf,
+            na_sm_op_id->info.recv_expected.buf, na_sm_hdr.hdr.buf_size,
+            na_sm_hdr.hdr.buf_idx);
+    } else {
+        /* Loan copy buffer, freed by na_sm_msg_loan_release() */
+        recv_expected->actual_buf = na_sm_loan_buf(na_class, poll_addr,
+            na_sm_hdr.hdr.buf_size, na_sm_hdr.hdr.buf_idx);
+    }
 
     ret = na_sm_complete(na_sm_op_id);
     if (ret != NA_SUCCESS) {
@@ -2432,9 +3238,21 @@ na_sm_complete(struct na_sm_op_id *na_sm_op_id)
             callback_info->info.recv_unexpected.tag =
                 (na_tag_t) na_sm_unexpected_info->na_sm_hdr.hdr.tag;
 
-            /* Copy and free buffer atomically */
             na_sm_copy_buf = na_sm_unexpected_info->na_sm_addr->na_sm_copy_buf;
-            na_sm_copy_and_free_buf(na_sm_op_id->na_class, na_sm_copy_buf,
+            if (!na_sm_op_id->info.recv_unexpected.buf) {
+                /* Loan copy buffer, freed by na_sm_msg_loan_release() */
+                callback_info->info.recv_unexpected.actual_buf =
+                    na_sm_loan_buf(na_sm_op_id->na_class,
+                        na_sm_unexpected_info->na_sm_addr,
+                        na_sm_unexpected_info->na_sm_hdr.hdr.buf_size,
+                        na_sm_unexpected_info->na_sm_hdr.hdr.buf_idx);
+                break;
+            }
+            callback_info->info.recv_unexpected.actual_buf =
+                na_sm_op_id->info.recv_unexpected.buf;
+
+            /* Copy and free buffer atomically */
+            na_sm_copy_and_free_buf(na_sm_copy_buf,
                 na_sm_op_id->info.recv_unexpected.buf,
                 na_sm_unexpected_info->na_sm_hdr.hdr.buf_size,
                 na_sm_unexpected_info->na_sm_hdr.hdr.buf_idx);
@@ -2443,10 +3261,17 @@ na_sm_complete(struct na_sm_op_id *na_sm_op_id)
         case NA_CB_SEND_EXPECTED:
             break;
         case NA_CB_RECV_EXPECTED:
+            if (canceled) {
+                callback_info->info.recv_expected.actual_buf_size = 0;
+                callback_info->info.recv_expected.actual_buf = NULL;
+            }
             break;
         case NA_CB_PUT:
-            break;
         case NA_CB_GET:
+            /* Parallel transfers report errors on completion */
+            if (!canceled)
+                callback_info->ret =
+                    (na_return_t) hg_atomic_get32(&na_sm_op_id->info.rma.ret);
             break;
         default:
             NA_LOG_ERROR("Operation not supported");
@@ -2503,7 +3328,9 @@ na_sm_initialize(na_class_t *na_class, const struct na_info NA_UNUSED *na_info,
     char *username = NULL;
     hg_poll_set_t *poll_set;
     na_bool_t no_wait = NA_FALSE;
+    na_bool_t huge_pages = NA_FALSE;
     int local_notify;
+    unsigned int i;
     na_return_t ret = NA_SUCCESS;
 
     /* TODO parse host name */
@@ -2513,6 +3340,8 @@ na_sm_initialize(na_class_t *na_class, const struct na_info NA_UNUSED *na_info,
         /* Progress mode */
         if (na_info->na_init_info->progress_mode == NA_NO_BLOCK)
             no_wait = NA_TRUE;
+        /* Huge pages */
+        huge_pages = na_info->na_init_info->huge_pages;
     }
 
     /* Get PID */
@@ -2538,6 +3367,23 @@ na_sm_initialize(na_class_t *na_class, const struct na_info NA_UNUSED *na_info,
     }
     memset(na_class->plugin_class, 0, sizeof(struct na_sm_class));
     NA_SM_CLASS(na_class)->no_wait = no_wait;
+    NA_SM_CLASS(na_class)->huge_pages = huge_pages;
+
+    /* Create pools for op IDs and unexpected messages */
+    NA_SM_CLASS(na_class)->op_id_pool =
+        hg_mem_pool_create(sizeof(struct na_sm_op_id), 0, 0);
+    if (!NA_SM_CLASS(na_class)->op_id_pool) {
+        NA_LOG_ERROR("Could not create op ID pool");
+        ret = NA_NOMEM_ERROR;
+        goto done;
+    }
+    NA_SM_CLASS(na_class)->unexpected_info_pool =
+        hg_mem_pool_create(sizeof(struct na_sm_unexpected_info), 0, 0);
+    if (!NA_SM_CLASS(na_class)->unexpected_info_pool) {
+        NA_LOG_ERROR("Could not create unexpected info pool");
+        ret = NA_NOMEM_ERROR;
+        goto done;
+    }
 
     /* Copy username */
     NA_SM_CLASS(na_class)->username = strdup(username);
@@ -2555,6 +3401,9 @@ na_sm_initialize(na_class_t *na_class, const struct na_info NA_UNUSED *na_info,
         goto done;
     }
     NA_SM_CLASS(na_class)->poll_set = poll_set;
+    HG_LIST_INIT(&NA_SM_CLASS(na_class)->ext_poll_set_list);
+    HG_LIST_INIT(&NA_SM_CLASS(na_class)->poll_data_list);
+    hg_thread_mutex_init(&NA_SM_CLASS(na_class)->poll_data_list_lock);
 
     /* Create self addr */
     na_sm_addr = (struct na_sm_addr *) malloc(sizeof(struct na_sm_addr));
@@ -2567,7 +3416,10 @@ na_sm_initialize(na_class_t *na_class, const struct na_info NA_UNUSED *na_info,
     na_sm_addr->pid = pid;
     na_sm_addr->id = (unsigned int) hg_atomic_incr32(&id) - 1;
     na_sm_addr->self = NA_TRUE;
+    na_sm_addr->sock = -1; /* Only set if listening */
+    na_sm_addr->remote_notify = -1;
     hg_atomic_init32(&na_sm_addr->ref_count, 1);
+    hg_atomic_init32(&na_sm_addr->loan_count, 0);
     /* If we're listening, create a new shm region */
     if (listen) {
         ret = na_sm_setup_shm(na_class, na_sm_addr);
@@ -2597,18 +3449,22 @@ na_sm_initialize(na_class_t *na_class, const struct na_info NA_UNUSED *na_info,
     HG_QUEUE_INIT(&NA_SM_CLASS(na_class)->accepted_addr_queue);
     HG_QUEUE_INIT(&NA_SM_CLASS(na_class)->poll_addr_queue);
     HG_QUEUE_INIT(&NA_SM_CLASS(na_class)->unexpected_msg_queue);
-    HG_QUEUE_INIT(&NA_SM_CLASS(na_class)->lookup_op_queue);
+    NA_SM_CLASS(na_class)->unexpected_msg_count = 0;
     HG_QUEUE_INIT(&NA_SM_CLASS(na_class)->unexpected_op_queue);
-    HG_QUEUE_INIT(&NA_SM_CLASS(na_class)->expected_op_queue);
+    for (i = 0; i < NA_SM_EXPECTED_HASH_SIZE; i++)
+        HG_QUEUE_INIT(&NA_SM_CLASS(na_class)->expected_op_table[i]);
+    hg_atomic_init32(&NA_SM_CLASS(na_class)->conn_id, 0);
+    HG_LIST_INIT(&NA_SM_CLASS(na_class)->loan_copy_list);
 
     /* Initialize mutexes */
     hg_thread_spin_init(&NA_SM_CLASS(na_class)->accepted_addr_queue_lock);
     hg_thread_spin_init(&NA_SM_CLASS(na_class)->poll_addr_queue_lock);
     hg_thread_spin_init(&NA_SM_CLASS(na_class)->unexpected_msg_queue_lock);
-    hg_thread_spin_init(&NA_SM_CLASS(na_class)->lookup_op_queue_lock);
     hg_thread_spin_init(&NA_SM_CLASS(na_class)->unexpected_op_queue_lock);
-    hg_thread_spin_init(&NA_SM_CLASS(na_class)->expected_op_queue_lock);
-    hg_thread_spin_init(&NA_SM_CLASS(na_class)->copy_buf_lock);
+    hg_thread_spin_init(&NA_SM_CLASS(na_class)->expected_op_table_lock);
+    hg_thread_spin_init(&NA_SM_CLASS(na_class)->loan_copy_list_lock);
+    hg_thread_mutex_init(&NA_SM_CLASS(na_class)->arena_lock);
+    hg_thread_mutex_init(&NA_SM_CLASS(na_class)->rma_pool_lock);
 
 done:
     return ret;
@@ -2618,18 +3474,22 @@ done:
 static na_return_t
 na_sm_finalize(na_class_t *na_class)
 {
+    unsigned int i;
     na_return_t ret = NA_SUCCESS;
 
     if (!na_class->plugin_class) {
         goto done;
     }
 
-    /* Check that lookup op queue is empty */
-    if (!HG_QUEUE_IS_EMPTY(&NA_SM_CLASS(na_class)->lookup_op_queue)) {
-        NA_LOG_ERROR("Lookup op queue should be empty");
+    /* Wait for pending RMA chunks and stop helper threads */
+    if (NA_SM_CLASS(na_class)->rma_pool
+        && hg_thread_pool_destroy(NA_SM_CLASS(na_class)->rma_pool)
+        != HG_UTIL_SUCCESS) {
+        NA_LOG_ERROR("Could not destroy RMA thread pool");
         ret = NA_PROTOCOL_ERROR;
         goto done;
     }
+    NA_SM_CLASS(na_class)->rma_pool = NULL;
 
     /* Check that unexpected op queue is empty */
     if (!HG_QUEUE_IS_EMPTY(&NA_SM_CLASS(na_class)->unexpected_op_queue)) {
@@ -2645,11 +3505,13 @@ na_sm_finalize(na_class_t *na_class)
         goto done;
     }
 
-    /* Check that expected op queue is empty */
-    if (!HG_QUEUE_IS_EMPTY(&NA_SM_CLASS(na_class)->expected_op_queue)) {
-        NA_LOG_ERROR("Expected op queue should be empty");
-        ret = NA_PROTOCOL_ERROR;
-        goto done;
+    /* Check that expected op table is empty */
+    for (i = 0; i < NA_SM_EXPECTED_HASH_SIZE; i++) {
+        if (!HG_QUEUE_IS_EMPTY(&NA_SM_CLASS(na_class)->expected_op_table[i])) {
+            NA_LOG_ERROR("Expected op table should be empty");
+            ret = NA_PROTOCOL_ERROR;
+            goto done;
+        }
     }
 
     /* Check that accepted addr queue is empty */
@@ -2663,6 +3525,34 @@ na_sm_finalize(na_class_t *na_class)
         }
     }
 
+    /* Close and remove arena */
+    if (NA_SM_CLASS(na_class)->arena) {
+        char na_sm_arena_name[NA_SM_MAX_FILENAME];
+
+        NA_SM_GEN_ARENA_NAME(na_sm_arena_name, NA_SM_CLASS(na_class)->username,
+            NA_SM_CLASS(na_class)->self_addr->pid,
+            NA_SM_CLASS(na_class)->self_addr->id);
+        ret = na_sm_close_shared_buf(na_sm_arena_name,
+            NA_SM_CLASS(na_class)->arena, NA_SM_ARENA_SIZE,
+            NA_SM_CLASS(na_class)->arena_backing);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not close arena");
+            goto done;
+        }
+        NA_SM_CLASS(na_class)->arena = NULL;
+        free(NA_SM_CLASS(na_class)->arena_map);
+        NA_SM_CLASS(na_class)->arena_map = NULL;
+    }
+
+    /* Free copies of loaned messages that were not released */
+    while (!HG_LIST_IS_EMPTY(&NA_SM_CLASS(na_class)->loan_copy_list)) {
+        struct na_sm_loan_copy *na_sm_loan_copy =
+            HG_LIST_FIRST(&NA_SM_CLASS(na_class)->loan_copy_list);
+
+        HG_LIST_REMOVE(na_sm_loan_copy, entry);
+        free(na_sm_loan_copy);
+    }
+
     /* Free self addr */
     ret = na_sm_addr_free(na_class, NA_SM_CLASS(na_class)->self_addr);
     if (ret != NA_SUCCESS) {
@@ -2681,10 +3571,15 @@ na_sm_finalize(na_class_t *na_class)
     hg_thread_spin_destroy(&NA_SM_CLASS(na_class)->accepted_addr_queue_lock);
     hg_thread_spin_destroy(&NA_SM_CLASS(na_class)->poll_addr_queue_lock);
     hg_thread_spin_destroy(&NA_SM_CLASS(na_class)->unexpected_msg_queue_lock);
-    hg_thread_spin_destroy(&NA_SM_CLASS(na_class)->lookup_op_queue_lock);
     hg_thread_spin_destroy(&NA_SM_CLASS(na_class)->unexpected_op_queue_lock);
-    hg_thread_spin_destroy(&NA_SM_CLASS(na_class)->expected_op_queue_lock);
-    hg_thread_spin_destroy(&NA_SM_CLASS(na_class)->copy_buf_lock);
+    hg_thread_spin_destroy(&NA_SM_CLASS(na_class)->expected_op_table_lock);
+    hg_thread_mutex_destroy(&NA_SM_CLASS(na_class)->poll_data_list_lock);
+    hg_thread_spin_destroy(&NA_SM_CLASS(na_class)->loan_copy_list_lock);
+    hg_thread_mutex_destroy(&NA_SM_CLASS(na_class)->arena_lock);
+    hg_thread_mutex_destroy(&NA_SM_CLASS(na_class)->rma_pool_lock);
+
+    hg_mem_pool_destroy(NA_SM_CLASS(na_class)->op_id_pool);
+    hg_mem_pool_destroy(NA_SM_CLASS(na_class)->unexpected_info_pool);
 
     free(NA_SM_CLASS(na_class)->username);
     free(na_class->plugin_class);
@@ -2717,19 +3612,15 @@ na_sm_cleanup(void)
     if (ret != 0 && errno != ENOENT) {
         NA_LOG_WARNING("nftw() failed (%s)", strerror(errno));
     }
+
+    if (hg_mem_get_hugetlbfs_path())
+        na_sm_cleanup_hugetlbfs(hg_mem_get_hugetlbfs_path());
 }
 
 /*---------------------------------------------------------------------------*/
-static na_op_id_t
-na_sm_op_create(na_class_t *na_class)
+static NA_INLINE void
+na_sm_op_id_init(na_class_t *na_class, struct na_sm_op_id *na_sm_op_id)
 {
-    struct na_sm_op_id *na_sm_op_id = NULL;
-
-    na_sm_op_id = (struct na_sm_op_id *) malloc(sizeof(struct na_sm_op_id));
-    if (!na_sm_op_id) {
-        NA_LOG_ERROR("Could not allocate NA SM operation ID");
-        goto done;
-    }
     memset(na_sm_op_id, 0, sizeof(struct na_sm_op_id));
     na_sm_op_id->na_class = na_class;
     hg_atomic_init32(&na_sm_op_id->ref_count, 1);
@@ -2738,6 +3629,21 @@ na_sm_op_create(na_class_t *na_class)
     /* Set op ID release callbacks */
     na_sm_op_id->completion_data.plugin_callback = na_sm_release;
     na_sm_op_id->completion_data.plugin_callback_args = na_sm_op_id;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_op_id_t
+na_sm_op_create(na_class_t *na_class)
+{
+    struct na_sm_op_id *na_sm_op_id = NULL;
+
+    na_sm_op_id = (struct na_sm_op_id *) hg_mem_pool_alloc(
+        NA_SM_CLASS(na_class)->op_id_pool);
+    if (!na_sm_op_id) {
+        NA_LOG_ERROR("Could not allocate NA SM operation ID");
+        goto done;
+    }
+    na_sm_op_id_init(na_class, na_sm_op_id);
 
 done:
     return (na_op_id_t) na_sm_op_id;
@@ -2754,7 +3660,8 @@ na_sm_op_destroy(na_class_t NA_UNUSED *na_class, na_op_id_t op_id)
         /* Cannot free yet */
         goto done;
     }
-    free(na_sm_op_id);
+    hg_mem_pool_free(NA_SM_CLASS(na_sm_op_id->na_class)->op_id_pool,
+        na_sm_op_id);
 
 done:
     return ret;
@@ -2762,38 +3669,56 @@ done:
 
 /*---------------------------------------------------------------------------*/
 static na_return_t
-na_sm_addr_lookup(na_class_t *na_class, na_context_t *context,
-    na_cb_t callback, void *arg, const char *name, na_op_id_t *op_id)
+na_sm_op_reset(na_class_t *na_class, na_op_id_t op_id)
 {
-    struct na_sm_op_id *na_sm_op_id = NULL;
+    struct na_sm_op_id *na_sm_op_id = (struct na_sm_op_id *) op_id;
+
+    if (hg_atomic_decr32(&na_sm_op_id->ref_count))
+        /* Still referenced, freed on release */
+        return NA_BUSY;
+
+    na_sm_op_id_init(na_class, na_sm_op_id);
+
+    return NA_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_sm_addr_connect(na_class_t *na_class, pid_t pid, unsigned int id,
+    struct na_sm_addr **addr)
+{
+    struct na_sm_addr *self_addr = NA_SM_CLASS(na_class)->self_addr;
     struct na_sm_addr *na_sm_addr = NULL;
     struct na_sm_copy_buf *na_sm_copy_buf = NULL;
+    struct na_sm_ring_buf *na_sm_ring_buf = NULL;
     char filename[NA_SM_MAX_FILENAME];
     char pathname[NA_SM_MAX_FILENAME];
-    int conn_sock;
-    char *name_string = NULL, *short_name = NULL;
+    int conn_sock, local_notify, remote_notify;
     na_return_t ret = NA_SUCCESS;
 
-    /* Allocate op_id if not provided */
-    if (op_id && op_id != NA_OP_ID_IGNORE && *op_id != NA_OP_ID_NULL) {
-        na_sm_op_id = (struct na_sm_op_id *) *op_id;
-        /* Make sure op ID can be safely re-used */
-        while (hg_atomic_cas32(&na_sm_op_id->ref_count, 1, 2) != HG_UTIL_TRUE)
-            cpu_spinwait();
-    } else {
-        na_sm_op_id = (struct na_sm_op_id *) na_sm_op_create(na_class);
-        if (!na_sm_op_id) {
-            NA_LOG_ERROR("Could not allocate NA SM operation ID");
-            ret = NA_NOMEM_ERROR;
-            goto done;
-        }
+    /* Reuse an existing connection to that peer if there is one, addrs that
+     * are being freed (ref count already dropped to 0) are skipped */
+    hg_thread_spin_lock(&NA_SM_CLASS(na_class)->poll_addr_queue_lock);
+    HG_QUEUE_FOREACH(na_sm_addr, &NA_SM_CLASS(na_class)->poll_addr_queue,
+        poll_entry) {
+        hg_util_int32_t ref_count;
+
+        if (na_sm_addr->accepted || na_sm_addr->pid != pid
+            || na_sm_addr->id != id)
+            continue;
+
+        do {
+            ref_count = hg_atomic_get32(&na_sm_addr->ref_count);
+        } while (ref_count && !hg_atomic_cas32(&na_sm_addr->ref_count,
+            ref_count, ref_count + 1));
+        if (ref_count)
+            break;
+    }
+    hg_thread_spin_unlock(&NA_SM_CLASS(na_class)->poll_addr_queue_lock);
+    if (na_sm_addr) {
+        *addr = na_sm_addr;
+        goto done;
     }
-    na_sm_op_id->context = context;
-    na_sm_op_id->completion_data.callback_info.type = NA_CB_LOOKUP;
-    na_sm_op_id->completion_data.callback = callback;
-    na_sm_op_id->completion_data.callback_info.arg = arg;
-    hg_atomic_set32(&na_sm_op_id->completed, NA_FALSE);
-    hg_atomic_set32(&na_sm_op_id->canceled, NA_FALSE);
 
     /* Allocate addr */
     na_sm_addr = (struct na_sm_addr *) malloc(sizeof(struct na_sm_addr));
@@ -2804,37 +3729,111 @@ na_sm_addr_lookup(na_class_t *na_class, na_context_t *context,
     }
     memset(na_sm_addr, 0, sizeof(struct na_sm_addr));
     hg_atomic_init32(&na_sm_addr->ref_count, 1);
-    na_sm_op_id->info.lookup.na_sm_addr = na_sm_addr;
+    hg_atomic_init32(&na_sm_addr->loan_count, 0);
+    na_sm_addr->pid = pid;
+    na_sm_addr->id = id;
+    na_sm_addr->conn_id =
+        (unsigned int) hg_atomic_incr32(&NA_SM_CLASS(na_class)->conn_id) - 1;
+    na_sm_addr->sock = -1;
+    na_sm_addr->local_notify = -1;
+    na_sm_addr->remote_notify = -1;
+
+    /* Set up copy buf and ring buffer pair (send/recv), the peer maps them by
+     * name once it receives our addr info so that we do not have to wait for
+     * it */
+    NA_SM_GEN_RING_NAME(filename, NA_SM_COPY_NAME,
+        NA_SM_CLASS(na_class)->username, self_addr->pid, self_addr->id,
+        na_sm_addr->conn_id);
+    na_sm_copy_buf = (struct na_sm_copy_buf *) na_sm_open_shared_buf(na_class,
+        filename, sizeof(struct na_sm_copy_buf), NA_TRUE,
+        &na_sm_addr->copy_buf_backing);
+    if (!na_sm_copy_buf) {
+        NA_LOG_ERROR("Could not open copy buf");
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+    /* Initialize copy buf */
+    na_sm_copy_buf_init(na_sm_copy_buf);
+    na_sm_addr->na_sm_copy_buf = na_sm_copy_buf;
+
+    NA_SM_GEN_RING_NAME(filename, NA_SM_SEND_NAME,
+        NA_SM_CLASS(na_class)->username, self_addr->pid, self_addr->id,
+        na_sm_addr->conn_id);
+    na_sm_ring_buf = (struct na_sm_ring_buf *) na_sm_open_shared_buf(na_class,
+        filename, NA_SM_RING_BUF_SIZE, NA_TRUE,
+        &na_sm_addr->send_ring_buf_backing);
+    if (!na_sm_ring_buf) {
+        NA_LOG_ERROR("Could not open ring buf");
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+    /* Initialize ring buffer */
+    na_sm_ring_buf_init(na_sm_ring_buf);
+    na_sm_addr->na_sm_send_ring_buf = na_sm_ring_buf;
 
+    NA_SM_GEN_RING_NAME(filename, NA_SM_RECV_NAME,
+        NA_SM_CLASS(na_class)->username, self_addr->pid, self_addr->id,
+        na_sm_addr->conn_id);
+    na_sm_ring_buf = (struct na_sm_ring_buf *) na_sm_open_shared_buf(na_class,
+        filename, NA_SM_RING_BUF_SIZE, NA_TRUE,
+        &na_sm_addr->recv_ring_buf_backing);
+    if (!na_sm_ring_buf) {
+        NA_LOG_ERROR("Could not open ring buf");
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+    /* Initialize ring buffer */
+    na_sm_ring_buf_init(na_sm_ring_buf);
+    na_sm_addr->na_sm_recv_ring_buf = na_sm_ring_buf;
+
+    /* Create local signal event */
+#ifdef HG_UTIL_HAS_SYSEVENTFD_H
+    local_notify = hg_event_create();
+    if (local_notify == HG_UTIL_FAIL) {
+        NA_LOG_ERROR("hg_event_create() failed");
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+#else
     /**
-     * Clean up name, strings can be of the format:
-     *   <protocol>://<host string>
+     * If eventfd is not supported, we need to explicitly use named pipes in
+     * this case as kqueue file descriptors cannot be exchanged through
+     * ancillary data. The name is no longer needed once the FIFO is open.
      */
-    name_string = strdup(name);
-    if (!name_string) {
-        NA_LOG_ERROR("Could not duplicate string");
-        ret = NA_NOMEM_ERROR;
+    NA_SM_GEN_FIFO_NAME(filename, NA_SM_RECV_NAME,
+        NA_SM_CLASS(na_class)->username, na_sm_addr, self_addr->pid,
+        self_addr->id, na_sm_addr->conn_id);
+    local_notify = na_sm_event_create(filename);
+    if (local_notify == -1) {
+        NA_LOG_ERROR("na_sm_event_create() failed");
+        ret = NA_PROTOCOL_ERROR;
         goto done;
     }
-    if (strstr(name_string, ":") != NULL) {
-         strtok_r(name_string, ":", &short_name);
-         short_name += 2;
-    } else
-         short_name = name_string;
-
-    /* Get PID / ID from name */
-    sscanf(short_name, "%d/%u", &na_sm_addr->pid, &na_sm_addr->id);
+    unlink(filename);
+#endif
+    na_sm_addr->local_notify = local_notify;
 
-    /* Open shared copy buf */
-    NA_SM_GEN_SHM_NAME(filename, NA_SM_CLASS(na_class)->username, na_sm_addr);
-    na_sm_copy_buf = (struct na_sm_copy_buf *) na_sm_open_shared_buf(
-        filename, sizeof(struct na_sm_copy_buf), NA_FALSE);
-    if (!na_sm_copy_buf) {
-        NA_LOG_ERROR("Could not open copy buf");
+    /* Create remote signal event */
+#ifdef HG_UTIL_HAS_SYSEVENTFD_H
+    remote_notify = hg_event_create();
+    if (remote_notify == HG_UTIL_FAIL) {
+        NA_LOG_ERROR("hg_event_create() failed");
         ret = NA_PROTOCOL_ERROR;
         goto done;
     }
-    na_sm_addr->na_sm_copy_buf = na_sm_copy_buf;
+#else
+    NA_SM_GEN_FIFO_NAME(filename, NA_SM_SEND_NAME,
+        NA_SM_CLASS(na_class)->username, na_sm_addr, self_addr->pid,
+        self_addr->id, na_sm_addr->conn_id);
+    remote_notify = na_sm_event_create(filename);
+    if (remote_notify == -1) {
+        NA_LOG_ERROR("na_sm_event_create() failed");
+        ret = NA_PROTOCOL_ERROR;
+        goto done;
+    }
+    unlink(filename);
+#endif
+    na_sm_addr->remote_notify = remote_notify;
 
     /* Open SHM sock */
     NA_SM_GEN_SOCK_PATH(pathname, NA_SM_CLASS(na_class)->username, na_sm_addr);
@@ -2844,38 +3843,143 @@ na_sm_addr_lookup(na_class_t *na_class, na_context_t *context,
         goto done;
     }
     na_sm_addr->sock = conn_sock;
-    /* We only need to receive conn ID in sock progress */
-    na_sm_addr->sock_progress = NA_SM_CONN_ID;
 
-    /* Push op ID to lookup op queue */
-    hg_thread_spin_lock(&NA_SM_CLASS(na_class)->lookup_op_queue_lock);
-    HG_QUEUE_PUSH_TAIL(&NA_SM_CLASS(na_class)->lookup_op_queue, na_sm_op_id,
-        entry);
-    hg_thread_spin_unlock(&NA_SM_CLASS(na_class)->lookup_op_queue_lock);
+    /* Add local notify to poll set */
+    ret = na_sm_poll_register(na_class, NA_SM_NOTIFY, na_sm_addr);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not add notify to poll set");
+        goto done;
+    }
 
-    /* Assign op_id */
-    if (op_id && op_id != NA_OP_ID_IGNORE && *op_id == NA_OP_ID_NULL)
-        *op_id = na_sm_op_id;
+    /* Send addr info (PID / ID / connection ID / event IDs), the connection
+     * can be used right away, the peer picks up pending messages from the
+     * notify event count once it has accepted it */
+    ret = na_sm_send_addr_info(na_class, na_sm_addr);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not send addr info");
+        goto done;
+    }
+    na_sm_addr->sock_progress = NA_SM_SOCK_DONE;
 
-    /* Add conn_sock to poll set */
+    /* Add addr to poll addr queue */
+    hg_thread_spin_lock(&NA_SM_CLASS(na_class)->poll_addr_queue_lock);
+    HG_QUEUE_PUSH_TAIL(&NA_SM_CLASS(na_class)->poll_addr_queue, na_sm_addr,
+        poll_entry);
+    hg_thread_spin_unlock(&NA_SM_CLASS(na_class)->poll_addr_queue_lock);
+
+    /* Add conn_sock to poll set so that peer disconnection is detected */
     ret = na_sm_poll_register(na_class, NA_SM_SOCK, na_sm_addr);
     if (ret != NA_SUCCESS) {
         NA_LOG_ERROR("Could not add conn_sock to poll set");
         goto done;
     }
 
-    /* Send addr info (PID / ID) */
-    ret = na_sm_send_addr_info(na_class, na_sm_addr);
+    *addr = na_sm_addr;
+
+done:
+    if (ret != NA_SUCCESS && na_sm_addr)
+        na_sm_addr_free(na_class, (na_addr_t) na_sm_addr);
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_sm_addr_lookup(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, const char *name, na_op_id_t *op_id)
+{
+    struct na_sm_op_id *na_sm_op_id = NULL;
+    struct na_sm_addr *na_sm_addr = NULL;
+    na_return_t ret = NA_SUCCESS;
+
+    /* Allocate op_id if not provided */
+    if (op_id && op_id != NA_OP_ID_IGNORE && *op_id != NA_OP_ID_NULL) {
+        na_sm_op_id = (struct na_sm_op_id *) *op_id;
+        /* Make sure op ID can be safely re-used */
+        while (hg_atomic_cas32(&na_sm_op_id->ref_count, 1, 2) != HG_UTIL_TRUE)
+            cpu_spinwait();
+    } else {
+        na_sm_op_id = (struct na_sm_op_id *) na_sm_op_create(na_class);
+        if (!na_sm_op_id) {
+            NA_LOG_ERROR("Could not allocate NA SM operation ID");
+            ret = NA_NOMEM_ERROR;
+            goto done;
+        }
+    }
+    na_sm_op_id->context = context;
+    na_sm_op_id->completion_data.callback_info.type = NA_CB_LOOKUP;
+    na_sm_op_id->completion_data.callback = callback;
+    na_sm_op_id->completion_data.callback_info.arg = arg;
+    NA_STATS_POST(context, &na_sm_op_id->completion_data, NA_CB_LOOKUP, 0);
+    hg_atomic_set32(&na_sm_op_id->completed, NA_FALSE);
+    hg_atomic_set32(&na_sm_op_id->canceled, NA_FALSE);
+
+    /* Lookup addr */
+    ret = na_sm_addr_lookup2(na_class, name, (na_addr_t *) &na_sm_addr);
     if (ret != NA_SUCCESS) {
-        NA_LOG_ERROR("Could not send addr info");
+        NA_LOG_ERROR("Could not lookup %s", name);
+        goto done;
+    }
+    na_sm_op_id->info.lookup.na_sm_addr = na_sm_addr;
+
+    /* Assign op_id */
+    if (op_id && op_id != NA_OP_ID_IGNORE && *op_id == NA_OP_ID_NULL)
+        *op_id = na_sm_op_id;
+
+    /* Connection does not wait for the peer, always complete here */
+    ret = na_sm_complete(na_sm_op_id);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not complete operation");
         goto done;
     }
 
 done:
-    if (ret != NA_SUCCESS) {
-        free(na_sm_addr);
+    if (ret != NA_SUCCESS && na_sm_op_id)
         na_sm_op_destroy(na_class, (na_op_id_t) na_sm_op_id);
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_sm_addr_lookup2(na_class_t *na_class, const char *name, na_addr_t *addr)
+{
+    struct na_sm_addr *na_sm_addr = NULL;
+    char *name_string = NULL, *short_name = NULL;
+    pid_t pid;
+    unsigned int id;
+    na_return_t ret = NA_SUCCESS;
+
+    /**
+     * Clean up name, strings can be of the format:
+     *   <protocol>://<host string>
+     */
+    name_string = strdup(name);
+    if (!name_string) {
+        NA_LOG_ERROR("Could not duplicate string");
+        ret = NA_NOMEM_ERROR;
+        goto done;
+    }
+    if (strstr(name_string, ":") != NULL) {
+         strtok_r(name_string, ":", &short_name);
+         short_name += 2;
+    } else
+         short_name = name_string;
+
+    /* Get PID / ID from name */
+    if (sscanf(short_name, "%d/%u", &pid, &id) != 2) {
+        NA_LOG_ERROR("Could not parse SM address %s", name);
+        ret = NA_INVALID_PARAM;
+        goto done;
     }
+
+    ret = na_sm_addr_connect(na_class, pid, id, &na_sm_addr);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not connect to %d/%u", pid, id);
+        goto done;
+    }
+
+    *addr = (na_addr_t) na_sm_addr;
+
+done:
     free(name_string);
     return ret;
 }
@@ -2912,16 +4016,20 @@ na_sm_addr_free(na_class_t *na_class, na_addr_t addr)
         hg_thread_spin_unlock(&NA_SM_CLASS(na_class)->accepted_addr_queue_lock);
     }
 
-    /* Deregister event file descriptors from poll set */
-    ret = na_sm_poll_deregister(na_class, NA_SM_NOTIFY, na_sm_addr);
-    if (ret != NA_SUCCESS) {
-        NA_LOG_ERROR("Could not delete notify from poll set");
-        goto done;
+    /* Deregister event file descriptors from poll set (accepted addrs only
+     * get them once addr info has been received) */
+    if (na_sm_addr->local_notify_poll_data) {
+        ret = na_sm_poll_deregister(na_class, NA_SM_NOTIFY, na_sm_addr);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not delete notify from poll set");
+            goto done;
+        }
     }
 
     /* Destroy local event */
 #ifdef HG_UTIL_HAS_SYSEVENTFD_H
-    if (hg_event_destroy(na_sm_addr->local_notify) == HG_UTIL_FAIL) {
+    if (na_sm_addr->local_notify >= 0
+        && hg_event_destroy(na_sm_addr->local_notify) == HG_UTIL_FAIL) {
         NA_LOG_ERROR("hg_event_destroy() failed");
         ret = NA_PROTOCOL_ERROR;
         goto done;
@@ -2929,74 +4037,68 @@ na_sm_addr_free(na_class_t *na_class, na_addr_t addr)
 #endif
 
     if (!na_sm_addr->self) { /* Created by lookup/connect or accept */
-#ifndef HG_UTIL_HAS_SYSEVENTFD_H
-        char na_sm_local_event_name[NA_SM_MAX_FILENAME],
-            na_sm_remote_event_name[NA_SM_MAX_FILENAME];
-        const char *local_event_name = NULL, *remote_event_name = NULL;
-#endif
-
         /* Deregister sock file descriptor */
-        ret = na_sm_poll_deregister(na_class, NA_SM_SOCK, na_sm_addr);
-        if (ret != NA_SUCCESS) {
-            NA_LOG_ERROR("Could not delete sock from poll set");
-            goto done;
+        if (na_sm_addr->sock_poll_data) {
+            ret = na_sm_poll_deregister(na_class, NA_SM_SOCK, na_sm_addr);
+            if (ret != NA_SUCCESS) {
+                NA_LOG_ERROR("Could not delete sock from poll set");
+                goto done;
+            }
         }
 
         /* Remove addr from poll addr queue */
-        hg_thread_spin_lock(&NA_SM_CLASS(na_class)->poll_addr_queue_lock);
-        HG_QUEUE_REMOVE(&NA_SM_CLASS(na_class)->poll_addr_queue, na_sm_addr,
-            na_sm_addr, poll_entry);
-        hg_thread_spin_unlock(&NA_SM_CLASS(na_class)->poll_addr_queue_lock);
-
-        if (na_sm_addr->accepted) { /* Created by accept */
-            /* Get file names from ring bufs / events to delete files */
-            sprintf(na_sm_send_ring_buf_name, "%s_%s-%d-%d-%d-" NA_SM_SEND_NAME,
-                NA_SM_SHM_PREFIX, NA_SM_CLASS(na_class)->username,
-                NA_SM_CLASS(na_class)->self_addr->pid,
-                NA_SM_CLASS(na_class)->self_addr->id,
-                na_sm_addr->conn_id);
-            sprintf(na_sm_recv_ring_buf_name, "%s_%s-%d-%d-%d-" NA_SM_RECV_NAME,
-                NA_SM_SHM_PREFIX, NA_SM_CLASS(na_class)->username,
-                NA_SM_CLASS(na_class)->self_addr->pid,
-                NA_SM_CLASS(na_class)->self_addr->id,
-                na_sm_addr->conn_id);
-            send_ring_buf_name = na_sm_send_ring_buf_name;
-            recv_ring_buf_name = na_sm_recv_ring_buf_name;
+        if (na_sm_addr->sock_progress == NA_SM_SOCK_DONE) {
+            hg_thread_spin_lock(&NA_SM_CLASS(na_class)->poll_addr_queue_lock);
+            HG_QUEUE_REMOVE(&NA_SM_CLASS(na_class)->poll_addr_queue,
+                na_sm_addr, na_sm_addr, poll_entry);
+            hg_thread_spin_unlock(&NA_SM_CLASS(na_class)->poll_addr_queue_lock);
+        }
 
-#ifndef HG_UTIL_HAS_SYSEVENTFD_H
-            sprintf(na_sm_local_event_name, "%s/%s_%s/%d/%u/fifo-%u-%s",
-                NA_SM_TMP_DIRECTORY, NA_SM_SHM_PREFIX,
-                NA_SM_CLASS(na_class)->username,
-                NA_SM_CLASS(na_class)->self_addr->pid,
-                NA_SM_CLASS(na_class)->self_addr->id,
-                na_sm_addr->conn_id, NA_SM_RECV_NAME);
-            sprintf(na_sm_remote_event_name, "%s/%s_%s/%d/%u/fifo-%u-%s",
-                NA_SM_TMP_DIRECTORY, NA_SM_SHM_PREFIX,
-                NA_SM_CLASS(na_class)->username,
-                NA_SM_CLASS(na_class)->self_addr->pid,
-                NA_SM_CLASS(na_class)->self_addr->id,
-                na_sm_addr->conn_id, NA_SM_SEND_NAME);
-            local_event_name = na_sm_local_event_name;
-            remote_event_name = na_sm_remote_event_name;
-#endif
+        if (!na_sm_addr->accepted) { /* Created by lookup/connect */
+            /* Ring bufs and copy buf are owned by the connecting side, get
+             * file names to delete files */
+            if (na_sm_addr->na_sm_copy_buf) {
+                NA_SM_GEN_RING_NAME(na_sm_copy_buf_name, NA_SM_COPY_NAME,
+                    NA_SM_CLASS(na_class)->username,
+                    NA_SM_CLASS(na_class)->self_addr->pid,
+                    NA_SM_CLASS(na_class)->self_addr->id, na_sm_addr->conn_id);
+                copy_buf_name = na_sm_copy_buf_name;
+            }
+            if (na_sm_addr->na_sm_send_ring_buf) {
+                NA_SM_GEN_RING_NAME(na_sm_send_ring_buf_name, NA_SM_SEND_NAME,
+                    NA_SM_CLASS(na_class)->username,
+                    NA_SM_CLASS(na_class)->self_addr->pid,
+                    NA_SM_CLASS(na_class)->self_addr->id, na_sm_addr->conn_id);
+                send_ring_buf_name = na_sm_send_ring_buf_name;
+            }
+            if (na_sm_addr->na_sm_recv_ring_buf) {
+                NA_SM_GEN_RING_NAME(na_sm_recv_ring_buf_name, NA_SM_RECV_NAME,
+                    NA_SM_CLASS(na_class)->username,
+                    NA_SM_CLASS(na_class)->self_addr->pid,
+                    NA_SM_CLASS(na_class)->self_addr->id, na_sm_addr->conn_id);
+                recv_ring_buf_name = na_sm_recv_ring_buf_name;
+            }
         }
 
-        /* Destroy events */
+        /* Destroy events (FIFO names were already removed on creation) */
 #ifdef HG_UTIL_HAS_SYSEVENTFD_H
-        if (hg_event_destroy(na_sm_addr->remote_notify) == HG_UTIL_FAIL) {
+        if (na_sm_addr->remote_notify >= 0
+            && hg_event_destroy(na_sm_addr->remote_notify) == HG_UTIL_FAIL) {
             NA_LOG_ERROR("hg_event_destroy() failed");
             ret = NA_PROTOCOL_ERROR;
             goto done;
         }
 #else
-        if (na_sm_event_destroy(local_event_name, na_sm_addr->local_notify)
+        if (na_sm_addr->local_notify >= 0
+            && na_sm_event_destroy(NULL, na_sm_addr->local_notify)
             != NA_SUCCESS) {
             NA_LOG_ERROR("na_sm_event_destroy() failed");
             ret = NA_PROTOCOL_ERROR;
             goto done;
         }
 
-        if (na_sm_event_destroy(remote_event_name, na_sm_addr->remote_notify)
+        if (na_sm_addr->remote_notify >= 0
+            && na_sm_event_destroy(NULL, na_sm_addr->remote_notify)
             != NA_SUCCESS) {
             NA_LOG_ERROR("na_sm_event_destroy() failed");
             ret = NA_PROTOCOL_ERROR;
@@ -3012,16 +4114,13 @@ na_sm_addr_free(na_class_t *na_class, na_addr_t addr)
             goto done;
         }
 #endif
-        if (na_sm_addr->na_sm_copy_buf) { /* Self addr and listen */
+        if (na_sm_addr->sock_poll_data) { /* Self addr and listen */
             ret = na_sm_poll_deregister(na_class, NA_SM_ACCEPT, na_sm_addr);
             if (ret != NA_SUCCESS) {
                 NA_LOG_ERROR("Could not delete listen from poll set");
                 goto done;
             }
 
-            NA_SM_GEN_SHM_NAME(na_sm_copy_buf_name,
-                NA_SM_CLASS(na_class)->username, na_sm_addr);
-            copy_buf_name = na_sm_copy_buf_name;
             NA_SM_GEN_SOCK_PATH(na_sock_name,
                 NA_SM_CLASS(na_class)->username, na_sm_addr);
             pathname = na_sock_name;
@@ -3029,15 +4128,18 @@ na_sm_addr_free(na_class_t *na_class, na_addr_t addr)
     }
 
     /* Close sock (delete also tmp dir if pathname is set) */
-    ret = na_sm_close_sock(na_sm_addr->sock, pathname);
-    if (ret != NA_SUCCESS) {
-        NA_LOG_ERROR("Could not close sock");
-        goto done;
+    if (na_sm_addr->sock >= 0) {
+        ret = na_sm_close_sock(na_sm_addr->sock, pathname);
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not close sock");
+            goto done;
+        }
     }
 
     /* Close ring buf (send) */
     ret = na_sm_close_shared_buf(send_ring_buf_name,
-        na_sm_addr->na_sm_send_ring_buf, sizeof(struct na_sm_ring_buf));
+        na_sm_addr->na_sm_send_ring_buf, NA_SM_RING_BUF_SIZE,
+        na_sm_addr->send_ring_buf_backing);
     if (ret != NA_SUCCESS) {
         NA_LOG_ERROR("Could not close send ring buffer");
         goto done;
@@ -3045,18 +4147,27 @@ na_sm_addr_free(na_class_t *na_class, na_addr_t addr)
 
     /* Close ring buf (recv) */
     ret = na_sm_close_shared_buf(recv_ring_buf_name,
-        na_sm_addr->na_sm_recv_ring_buf, sizeof(struct na_sm_ring_buf));
+        na_sm_addr->na_sm_recv_ring_buf, NA_SM_RING_BUF_SIZE,
+        na_sm_addr->recv_ring_buf_backing);
     if (ret != NA_SUCCESS) {
         NA_LOG_ERROR("Could not close recv ring buffer");
         goto done;
     }
 
     /* Close copy buf */
-    if (!na_sm_addr->accepted) { /* Created by accept */
-        ret = na_sm_close_shared_buf(copy_buf_name, na_sm_addr->na_sm_copy_buf,
-            sizeof(struct na_sm_copy_buf));
+    ret = na_sm_close_shared_buf(copy_buf_name, na_sm_addr->na_sm_copy_buf,
+        sizeof(struct na_sm_copy_buf), na_sm_addr->copy_buf_backing);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not close copy buffer");
+        goto done;
+    }
+
+    /* Unmap peer arena (only its owner removes it) */
+    if (na_sm_addr->arena) {
+        ret = na_sm_close_shared_buf(NULL, na_sm_addr->arena, NA_SM_ARENA_SIZE,
+            na_sm_addr->arena_backing);
         if (ret != NA_SUCCESS) {
-            NA_LOG_ERROR("Could not close copy buffer");
+            NA_LOG_ERROR("Could not close peer arena");
             goto done;
         }
     }
@@ -3146,6 +4257,79 @@ done:
     return ret;
 }
 
+/*---------------------------------------------------------------------------*/
+static NA_INLINE na_size_t
+na_sm_addr_get_serialize_size(na_class_t NA_UNUSED *na_class,
+    na_addr_t NA_UNUSED addr)
+{
+    /* Connection state is private to each pair of processes, only the PID / ID
+     * of the peer is needed to reconnect to it */
+    return sizeof(pid_t) + sizeof(unsigned int);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_sm_addr_serialize(na_class_t NA_UNUSED *na_class, void *buf,
+    na_size_t buf_size, na_addr_t addr)
+{
+    struct na_sm_addr *na_sm_addr = (struct na_sm_addr *) addr;
+    char *buf_ptr = (char *) buf;
+    na_return_t ret = NA_SUCCESS;
+
+    if (buf_size < sizeof(pid_t) + sizeof(unsigned int)) {
+        NA_LOG_ERROR("Buffer size too small for serializing address");
+        ret = NA_SIZE_ERROR;
+        goto done;
+    }
+
+    /* PID */
+    memcpy(buf_ptr, &na_sm_addr->pid, sizeof(pid_t));
+    buf_ptr += sizeof(pid_t);
+
+    /* ID */
+    memcpy(buf_ptr, &na_sm_addr->id, sizeof(unsigned int));
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_sm_addr_deserialize(na_class_t *na_class, na_addr_t *addr, const void *buf,
+    na_size_t buf_size)
+{
+    struct na_sm_addr *na_sm_addr = NULL;
+    const char *buf_ptr = (const char *) buf;
+    pid_t pid;
+    unsigned int id;
+    na_return_t ret = NA_SUCCESS;
+
+    if (buf_size < sizeof(pid_t) + sizeof(unsigned int)) {
+        NA_LOG_ERROR("Buffer size too small for deserializing address");
+        ret = NA_SIZE_ERROR;
+        goto done;
+    }
+
+    /* PID */
+    memcpy(&pid, buf_ptr, sizeof(pid_t));
+    buf_ptr += sizeof(pid_t);
+
+    /* ID */
+    memcpy(&id, buf_ptr, sizeof(unsigned int));
+
+    /* Reuse existing connection or map peer's shared buffers */
+    ret = na_sm_addr_connect(na_class, pid, id, &na_sm_addr);
+    if (ret != NA_SUCCESS) {
+        NA_LOG_ERROR("Could not connect to %d/%u", pid, id);
+        goto done;
+    }
+
+    *addr = (na_addr_t) na_sm_addr;
+
+done:
+    return ret;
+}
+
 /*---------------------------------------------------------------------------*/
 static NA_INLINE na_size_t
 na_sm_msg_get_max_unexpected_size(const na_class_t NA_UNUSED *na_class)
@@ -3169,22 +4353,16 @@ na_sm_msg_get_max_tag(const na_class_t NA_UNUSED *na_class)
 
 /*---------------------------------------------------------------------------*/
 static na_return_t
-na_sm_msg_send_unexpected(na_class_t *na_class, na_context_t *context,
-    na_cb_t callback, void *arg, const void *buf, na_size_t buf_size,
-    void NA_UNUSED *plugin_data, na_addr_t dest_addr,
-    na_uint8_t NA_UNUSED dest_id, na_tag_t tag, na_op_id_t *op_id)
+na_sm_msg_send(na_class_t *na_class, na_context_t *context,
+    na_cb_type_t cb_type, na_cb_t callback, void *arg, const void *buf,
+    na_size_t buf_size, na_addr_t dest_addr, na_tag_t tag, na_op_id_t *op_id,
+    unsigned int *pending_count)
 {
     struct na_sm_op_id *na_sm_op_id = NULL;
     struct na_sm_addr *na_sm_addr = (struct na_sm_addr *) dest_addr;
     unsigned int idx_reserved;
     na_return_t ret = NA_SUCCESS;
 
-    if (buf_size > NA_SM_UNEXPECTED_SIZE) {
-        NA_LOG_ERROR("Exceeds unexpected size");
-        ret = NA_SIZE_ERROR;
-        goto done;
-    }
-
     /* Allocate op_id if not provided */
     if (op_id && op_id != NA_OP_ID_IGNORE && *op_id != NA_OP_ID_NULL) {
         na_sm_op_id = (struct na_sm_op_id *) *op_id;
@@ -3200,9 +4378,10 @@ na_sm_msg_send_unexpected(na_class_t *na_class, na_context_t *context,
         }
     }
     na_sm_op_id->context = context;
-    na_sm_op_id->completion_data.callback_info.type = NA_CB_SEND_UNEXPECTED;
+    na_sm_op_id->completion_data.callback_info.type = cb_type;
     na_sm_op_id->completion_data.callback = callback;
     na_sm_op_id->completion_data.callback_info.arg = arg;
+    NA_STATS_POST(context, &na_sm_op_id->completion_data, cb_type, buf_size);
     hg_atomic_set32(&na_sm_op_id->completed, NA_FALSE);
     hg_atomic_set32(&na_sm_op_id->canceled, NA_FALSE);
 
@@ -3210,12 +4389,35 @@ na_sm_msg_send_unexpected(na_class_t *na_class, na_context_t *context,
     if (op_id && op_id != NA_OP_ID_IGNORE && *op_id == NA_OP_ID_NULL)
         *op_id = na_sm_op_id;
 
-    /* Try to reserve buffer atomically */
+    /* Try to reserve buffer atomically and insert message into ring buffer
+     * (complete OP ID), retry until the remote has released enough slots */
     do {
-        ret = na_sm_reserve_and_copy_buf(na_class, na_sm_addr->na_sm_copy_buf,
-            buf, buf_size, &idx_reserved);
-        if (ret != NA_SUCCESS) {
-            na_return_t progress_ret = na_sm_progress(na_class, context, 0);
+        ret = na_sm_reserve_and_copy_buf(na_sm_addr->na_sm_copy_buf, buf,
+            buf_size, &idx_reserved);
+        if (ret == NA_SUCCESS) {
+            ret = na_sm_msg_insert(na_class, na_sm_op_id,
+                (cb_type == NA_CB_SEND_UNEXPECTED) ? NA_CB_RECV_UNEXPECTED :
+                    NA_CB_RECV_EXPECTED, na_sm_addr, idx_reserved, buf_size,
+                tag, (pending_count == NULL));
+            if (ret == NA_AGAIN)
+                /* Ring buffer has one entry less than there are slots, give
+                 * slots back until the remote pops messages */
+                na_sm_copy_and_free_buf(na_sm_addr->na_sm_copy_buf, NULL,
+                    buf_size, idx_reserved);
+        }
+        if (ret == NA_SIZE_ERROR || ret == NA_AGAIN) {
+            na_return_t progress_ret;
+
+            /* Messages that were not notified yet may be what prevents the
+             * remote from releasing copy buffers */
+            if (pending_count && *pending_count) {
+                ret = na_sm_notify_remote(na_class, na_sm_addr,
+                    *pending_count);
+                if (ret != NA_SUCCESS)
+                    goto done;
+                *pending_count = 0;
+            }
+            progress_ret = na_sm_progress(na_class, context, 0);
 
             if (progress_ret != NA_SUCCESS && progress_ret != NA_TIMEOUT) {
                 NA_LOG_ERROR("Could not make progress");
@@ -3226,14 +4428,12 @@ na_sm_msg_send_unexpected(na_class_t *na_class, na_context_t *context,
         }
         break;
     } while (1);
-
-    /* Insert message into ring buffer (complete OP ID) */
-    ret = na_sm_msg_insert(na_class, na_sm_op_id, NA_CB_RECV_UNEXPECTED,
-        na_sm_addr, idx_reserved, buf_size, tag);
     if (ret != NA_SUCCESS) {
         NA_LOG_ERROR("Could not insert message");
         goto done;
     }
+    if (pending_count)
+        (*pending_count)++;
 
 done:
     if (ret != NA_SUCCESS) {
@@ -3242,6 +4442,22 @@ done:
     return ret;
 }
 
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_sm_msg_send_unexpected(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, const void *buf, na_size_t buf_size,
+    void NA_UNUSED *plugin_data, na_addr_t dest_addr,
+    na_uint8_t NA_UNUSED dest_id, na_tag_t tag, na_op_id_t *op_id)
+{
+    if (buf_size > NA_SM_UNEXPECTED_SIZE) {
+        NA_LOG_ERROR("Exceeds unexpected size");
+        return NA_SIZE_ERROR;
+    }
+
+    return na_sm_msg_send(na_class, context, NA_CB_SEND_UNEXPECTED, callback,
+        arg, buf, buf_size, dest_addr, tag, op_id, NULL);
+}
+
 /*---------------------------------------------------------------------------*/
 static na_return_t
 na_sm_msg_recv_unexpected(na_class_t *na_class, na_context_t *context,
@@ -3250,6 +4466,7 @@ na_sm_msg_recv_unexpected(na_class_t *na_class, na_context_t *context,
 {
     struct na_sm_unexpected_info *na_sm_unexpected_info;
     struct na_sm_op_id *na_sm_op_id = NULL;
+    na_size_t unexpected_msg_count;
     na_return_t ret = NA_SUCCESS;
 
     if (buf_size > NA_SM_UNEXPECTED_SIZE) {
@@ -3277,6 +4494,8 @@ na_sm_msg_recv_unexpected(na_class_t *na_class, na_context_t *context,
     na_sm_op_id->completion_data.callback_info.type = NA_CB_RECV_UNEXPECTED;
     na_sm_op_id->completion_data.callback = callback;
     na_sm_op_id->completion_data.callback_info.arg = arg;
+    NA_STATS_POST(context, &na_sm_op_id->completion_data,
+        NA_CB_RECV_UNEXPECTED, buf_size);
     hg_atomic_set32(&na_sm_op_id->completed, NA_FALSE);
     hg_atomic_set32(&na_sm_op_id->canceled, NA_FALSE);
     na_sm_op_id->info.recv_unexpected.buf = buf;
@@ -3292,11 +4511,17 @@ na_sm_msg_recv_unexpected(na_class_t *na_class, na_context_t *context,
     na_sm_unexpected_info = HG_QUEUE_FIRST(
         &NA_SM_CLASS(na_class)->unexpected_msg_queue);
     HG_QUEUE_POP_HEAD(&NA_SM_CLASS(na_class)->unexpected_msg_queue, entry);
+    unexpected_msg_count = NA_SM_CLASS(na_class)->unexpected_msg_count;
+    if (na_sm_unexpected_info)
+        NA_SM_CLASS(na_class)->unexpected_msg_count--;
     hg_thread_spin_unlock(&NA_SM_CLASS(na_class)->unexpected_msg_queue_lock);
     if (na_sm_unexpected_info) {
+        NA_STATS_EVENT(context, NA_STATS_UNEXPECTED_QUEUED);
+        NA_STATS_UNEXPECTED_DEPTH(context, unexpected_msg_count);
         na_sm_op_id->info.recv_unexpected.unexpected_info =
             *na_sm_unexpected_info;
-        free(na_sm_unexpected_info);
+        hg_mem_pool_free(NA_SM_CLASS(na_class)->unexpected_info_pool,
+            na_sm_unexpected_info);
 
         ret = na_sm_complete(na_sm_op_id);
         if (ret != NA_SUCCESS) {
@@ -3304,86 +4529,11 @@ na_sm_msg_recv_unexpected(na_class_t *na_class, na_context_t *context,
             goto done;
         }
     } else {
-        /* Nothing has been received yet so add op_id to progress queue */
-        hg_thread_spin_lock(&NA_SM_CLASS(na_class)->unexpected_op_queue_lock);
-        HG_QUEUE_PUSH_TAIL(&NA_SM_CLASS(na_class)->unexpected_op_queue,
-            na_sm_op_id, entry);
-        hg_thread_spin_unlock(&NA_SM_CLASS(na_class)->unexpected_op_queue_lock);
-    }
-
-done:
-    if (ret != NA_SUCCESS) {
-        na_sm_op_destroy(na_class, (na_op_id_t) na_sm_op_id);
-    }
-    return ret;
-}
-
-/*---------------------------------------------------------------------------*/
-static na_return_t
-na_sm_msg_send_expected(na_class_t NA_UNUSED *na_class, na_context_t *context,
-    na_cb_t callback, void *arg, const void *buf, na_size_t buf_size,
-    void NA_UNUSED *plugin_data, na_addr_t dest_addr,
-    na_uint8_t NA_UNUSED dest_id, na_tag_t tag, na_op_id_t *op_id)
-{
-    struct na_sm_op_id *na_sm_op_id = NULL;
-    struct na_sm_addr *na_sm_addr = (struct na_sm_addr *) dest_addr;
-    unsigned int idx_reserved;
-    na_return_t ret = NA_SUCCESS;
-
-    if (buf_size > NA_SM_EXPECTED_SIZE) {
-        NA_LOG_ERROR("Exceeds expected size");
-        ret = NA_SIZE_ERROR;
-        goto done;
-    }
-
-    /* Allocate op_id if not provided */
-    if (op_id && op_id != NA_OP_ID_IGNORE && *op_id != NA_OP_ID_NULL) {
-        na_sm_op_id = (struct na_sm_op_id *) *op_id;
-        /* Make sure op ID can be safely re-used */
-        while (hg_atomic_cas32(&na_sm_op_id->ref_count, 1, 2) != HG_UTIL_TRUE)
-            cpu_spinwait();
-    } else {
-        na_sm_op_id = (struct na_sm_op_id *) na_sm_op_create(na_class);
-        if (!na_sm_op_id) {
-            NA_LOG_ERROR("Could not allocate NA SM operation ID");
-            ret = NA_NOMEM_ERROR;
-            goto done;
-        }
-    }
-    na_sm_op_id->context = context;
-    na_sm_op_id->completion_data.callback_info.type = NA_CB_SEND_EXPECTED;
-    na_sm_op_id->completion_data.callback = callback;
-    na_sm_op_id->completion_data.callback_info.arg = arg;
-    hg_atomic_set32(&na_sm_op_id->completed, NA_FALSE);
-    hg_atomic_set32(&na_sm_op_id->canceled, NA_FALSE);
-
-    /* Assign op_id */
-    if (op_id && op_id != NA_OP_ID_IGNORE && *op_id == NA_OP_ID_NULL)
-        *op_id = na_sm_op_id;
-
-    /* Try to reserve buffer atomically */
-    do {
-        ret = na_sm_reserve_and_copy_buf(na_class, na_sm_addr->na_sm_copy_buf,
-            buf, buf_size, &idx_reserved);
-        if (ret != NA_SUCCESS) {
-            na_return_t progress_ret = na_sm_progress(na_class, context, 0);
-
-            if (progress_ret != NA_SUCCESS && progress_ret != NA_TIMEOUT) {
-                NA_LOG_ERROR("Could not make progress");
-                ret = progress_ret;
-                goto done;
-            }
-            continue;
-        }
-        break;
-    } while (1);
-
-    /* Insert message into ring buffer (complete OP ID) */
-    ret = na_sm_msg_insert(na_class, na_sm_op_id, NA_CB_RECV_EXPECTED,
-        na_sm_addr, idx_reserved, buf_size, tag);
-    if (ret != NA_SUCCESS) {
-        NA_LOG_ERROR("Could not insert message");
-        goto done;
+        /* Nothing has been received yet so add op_id to progress queue */
+        hg_thread_spin_lock(&NA_SM_CLASS(na_class)->unexpected_op_queue_lock);
+        HG_QUEUE_PUSH_TAIL(&NA_SM_CLASS(na_class)->unexpected_op_queue,
+            na_sm_op_id, entry);
+        hg_thread_spin_unlock(&NA_SM_CLASS(na_class)->unexpected_op_queue_lock);
     }
 
 done:
@@ -3393,6 +4543,22 @@ done:
     return ret;
 }
 
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_sm_msg_send_expected(na_class_t *na_class, na_context_t *context,
+    na_cb_t callback, void *arg, const void *buf, na_size_t buf_size,
+    void NA_UNUSED *plugin_data, na_addr_t dest_addr,
+    na_uint8_t NA_UNUSED dest_id, na_tag_t tag, na_op_id_t *op_id)
+{
+    if (buf_size > NA_SM_EXPECTED_SIZE) {
+        NA_LOG_ERROR("Exceeds expected size");
+        return NA_SIZE_ERROR;
+    }
+
+    return na_sm_msg_send(na_class, context, NA_CB_SEND_EXPECTED, callback,
+        arg, buf, buf_size, dest_addr, tag, op_id, NULL);
+}
+
 /*---------------------------------------------------------------------------*/
 static na_return_t
 na_sm_msg_recv_expected(na_class_t *na_class, na_context_t *context,
@@ -3427,6 +4593,8 @@ na_sm_msg_recv_expected(na_class_t *na_class, na_context_t *context,
     na_sm_op_id->completion_data.callback_info.type = NA_CB_RECV_EXPECTED;
     na_sm_op_id->completion_data.callback = callback;
     na_sm_op_id->completion_data.callback_info.arg = arg;
+    NA_STATS_POST(context, &na_sm_op_id->completion_data,
+        NA_CB_RECV_EXPECTED, buf_size);
     hg_atomic_set32(&na_sm_op_id->completed, NA_FALSE);
     hg_atomic_set32(&na_sm_op_id->canceled, NA_FALSE);
     na_sm_op_id->info.recv_expected.buf = buf;
@@ -3440,11 +4608,11 @@ na_sm_msg_recv_expected(na_class_t *na_class, na_context_t *context,
 
     /* Expected messages must always be pre-posted, therefore a message should
      * never arrive before that call returns (not completes), simply add
-     * op_id to queue */
-    hg_thread_spin_lock(&NA_SM_CLASS(na_class)->expected_op_queue_lock);
-    HG_QUEUE_PUSH_TAIL(&NA_SM_CLASS(na_class)->expected_op_queue, na_sm_op_id,
-        entry);
-    hg_thread_spin_unlock(&NA_SM_CLASS(na_class)->expected_op_queue_lock);
+     * op_id to its bucket */
+    hg_thread_spin_lock(&NA_SM_CLASS(na_class)->expected_op_table_lock);
+    HG_QUEUE_PUSH_TAIL(&NA_SM_CLASS(na_class)->expected_op_table[
+        NA_SM_EXPECTED_HASH(source_addr, tag)], na_sm_op_id, expected_entry);
+    hg_thread_spin_unlock(&NA_SM_CLASS(na_class)->expected_op_table_lock);
 
 done:
     if (ret != NA_SUCCESS) {
@@ -3455,7 +4623,7 @@ done:
 
 /*---------------------------------------------------------------------------*/
 static na_return_t
-na_sm_mem_handle_create(na_class_t NA_UNUSED *na_class, void *buf,
+na_sm_mem_handle_create(na_class_t *na_class, void *buf,
     na_size_t buf_size, unsigned long flags, na_mem_handle_t *mem_handle)
 {
     struct na_sm_mem_handle *na_sm_mem_handle = NULL;
@@ -3480,6 +4648,7 @@ na_sm_mem_handle_create(na_class_t NA_UNUSED *na_class, void *buf,
     na_sm_mem_handle->iovcnt = 1;
     na_sm_mem_handle->flags = flags;
     na_sm_mem_handle->len = buf_size;
+    na_sm_mem_handle_set_arena(na_class, na_sm_mem_handle);
 
     *mem_handle = (na_mem_handle_t) na_sm_mem_handle;
 
@@ -3490,7 +4659,7 @@ done:
 /*---------------------------------------------------------------------------*/
 #ifdef NA_SM_HAS_CMA
 static na_return_t
-na_sm_mem_handle_create_segments(na_class_t NA_UNUSED *na_class,
+na_sm_mem_handle_create_segments(na_class_t *na_class,
     struct na_segment *segments, na_size_t segment_count, unsigned long flags,
     na_mem_handle_t *mem_handle)
 {
@@ -3528,6 +4697,7 @@ na_sm_mem_handle_create_segments(na_class_t NA_UNUSED *na_class,
     }
     na_sm_mem_handle->iovcnt = segment_count;
     na_sm_mem_handle->flags = flags;
+    na_sm_mem_handle_set_arena(na_class, na_sm_mem_handle);
 
     *mem_handle = (na_mem_handle_t) na_sm_mem_handle;
 
@@ -3559,7 +4729,8 @@ na_sm_mem_handle_get_serialize_size(na_class_t NA_UNUSED *na_class,
     struct na_sm_mem_handle *na_sm_mem_handle =
         (struct na_sm_mem_handle *) mem_handle;
     unsigned long i;
-    na_size_t ret = 2 * sizeof(unsigned long) + sizeof(size_t);
+    na_size_t ret = 2 * sizeof(unsigned long) + sizeof(size_t)
+        + sizeof(void *) + sizeof(pid_t) + sizeof(unsigned int);
 
     for (i = 0; i < na_sm_mem_handle->iovcnt; i++) {
         ret += sizeof(void *) + sizeof(size_t);
@@ -3591,6 +4762,14 @@ na_sm_mem_handle_serialize(na_class_t NA_UNUSED *na_class, void *buf,
     memcpy(buf_ptr, &na_sm_mem_handle->len, sizeof(size_t));
     buf_ptr += sizeof(size_t);
 
+    /* Arena */
+    memcpy(buf_ptr, &na_sm_mem_handle->arena_base, sizeof(void *));
+    buf_ptr += sizeof(void *);
+    memcpy(buf_ptr, &na_sm_mem_handle->arena_pid, sizeof(pid_t));
+    buf_ptr += sizeof(pid_t);
+    memcpy(buf_ptr, &na_sm_mem_handle->arena_id, sizeof(unsigned int));
+    buf_ptr += sizeof(unsigned int);
+
     /* Segments */
     for (i = 0; i < na_sm_mem_handle->iovcnt; i++) {
         memcpy(buf_ptr, &na_sm_mem_handle->iov[i].iov_base, sizeof(void *));
@@ -3638,6 +4817,14 @@ na_sm_mem_handle_deserialize(na_class_t NA_UNUSED *na_class,
     memcpy(&na_sm_mem_handle->len, buf_ptr, sizeof(size_t));
     buf_ptr += sizeof(size_t);
 
+    /* Arena */
+    memcpy(&na_sm_mem_handle->arena_base, buf_ptr, sizeof(void *));
+    buf_ptr += sizeof(void *);
+    memcpy(&na_sm_mem_handle->arena_pid, buf_ptr, sizeof(pid_t));
+    buf_ptr += sizeof(pid_t);
+    memcpy(&na_sm_mem_handle->arena_id, buf_ptr, sizeof(unsigned int));
+    buf_ptr += sizeof(unsigned int);
+
     /* Segments */
     na_sm_mem_handle->iov = (struct iovec *) malloc(na_sm_mem_handle->iovcnt *
         sizeof(struct iovec));
@@ -3662,11 +4849,11 @@ done:
 
 /*---------------------------------------------------------------------------*/
 static na_return_t
-na_sm_put(na_class_t *na_class, na_context_t *context, na_cb_t callback,
+na_sm_rma_put(na_class_t *na_class, na_context_t *context, na_cb_t callback,
     void *arg, na_mem_handle_t local_mem_handle, na_offset_t local_offset,
     na_mem_handle_t remote_mem_handle, na_offset_t remote_offset,
-    na_size_t length, na_addr_t remote_addr, na_uint8_t NA_UNUSED remote_id,
-    na_op_id_t *op_id)
+    na_size_t length, na_addr_t remote_addr, na_op_id_t *op_id,
+    na_bool_t notify)
 {
     struct na_sm_op_id *na_sm_op_id = NULL;
     struct na_sm_mem_handle *na_sm_mem_handle_local =
@@ -3674,15 +4861,11 @@ na_sm_put(na_class_t *na_class, na_context_t *context, na_cb_t callback,
     struct na_sm_mem_handle *na_sm_mem_handle_remote =
         (struct na_sm_mem_handle *) remote_mem_handle;
     struct na_sm_addr *na_sm_addr = (struct na_sm_addr *) remote_addr;
-    struct iovec *local_iov, *remote_iov;
+    struct iovec *local_iov, *remote_iov, *arena_iov;
     unsigned long liovcnt, riovcnt;
+    unsigned int chunk_count;
+    na_bool_t arena;
     na_return_t ret = NA_SUCCESS;
-#if defined(NA_SM_HAS_CMA)
-    ssize_t nwrite;
-#elif defined(__APPLE__)
-    kern_return_t kret;
-    mach_port_name_t remote_task;
-#endif
 
 #if !defined(NA_SM_HAS_CMA) && !defined(__APPLE__)
     (void) na_sm_addr;
@@ -3723,13 +4906,25 @@ na_sm_put(na_class_t *na_class, na_context_t *context, na_cb_t callback,
     na_sm_op_id->completion_data.callback_info.type = NA_CB_PUT;
     na_sm_op_id->completion_data.callback = callback;
     na_sm_op_id->completion_data.callback_info.arg = arg;
+    NA_STATS_POST(context, &na_sm_op_id->completion_data, NA_CB_PUT, length);
     hg_atomic_set32(&na_sm_op_id->completed, NA_FALSE);
     hg_atomic_set32(&na_sm_op_id->canceled, NA_FALSE);
+    hg_atomic_set32(&na_sm_op_id->info.rma.ret, NA_SUCCESS);
 
     /* Assign op_id */
     if (op_id && op_id != NA_OP_ID_IGNORE && *op_id == NA_OP_ID_NULL)
         *op_id = na_sm_op_id;
 
+    /* Split large transfers across RMA helper threads, the thread that
+     * transfers the last chunk completes the operation */
+    chunk_count = na_sm_rma_chunk_count(na_class, length);
+    if (chunk_count > 1) {
+        ret = na_sm_rma_post_chunks(na_class, na_sm_op_id, na_sm_addr,
+            na_sm_mem_handle_local, local_offset, na_sm_mem_handle_remote,
+            remote_offset, length, chunk_count);
+        goto done;
+    }
+
     /* Translate local offset, skip this step if not necessary */
     if (local_offset || length != na_sm_mem_handle_local->len) {
         /* TODO fix allocation */
@@ -3754,44 +4949,15 @@ na_sm_put(na_class_t *na_class, na_context_t *context, na_cb_t callback,
         riovcnt = na_sm_mem_handle_remote->iovcnt;
     }
 
-#if defined(NA_SM_HAS_CMA)
-    nwrite = process_vm_writev(na_sm_addr->pid, local_iov, liovcnt, remote_iov,
-        riovcnt, /* unused */0);
-    if (nwrite < 0) {
-        NA_LOG_ERROR("process_vm_writev() failed (%s)", strerror(errno));
-        ret = NA_PROTOCOL_ERROR;
-        goto done;
-    }
-    if ((na_size_t)nwrite != length) {
-        NA_LOG_ERROR("Wrote %ld bytes, was expecting %lu bytes", nwrite, length);
-        ret = NA_SIZE_ERROR;
-        goto done;
-    }
-#elif defined(__APPLE__)
-    kret = task_for_pid(mach_task_self(), na_sm_addr->pid, &remote_task);
-    if (kret != KERN_SUCCESS) {
-        NA_LOG_ERROR("task_for_pid() failed (%s)\n"
-                     "Permission must be set to access remote memory, please refer to the documentation for instructions.", mach_error_string(kret));
-        ret = NA_PROTOCOL_ERROR;
-        goto done;
-    }
-
-    if (liovcnt > 1 || riovcnt > 1) {
-        NA_LOG_ERROR("Non-contiguous transfers are not supported");
-        ret = NA_PROTOCOL_ERROR;
-        goto done;
-    }
+    /* Remote memory may lie in the arena of the peer */
+    arena_iov = (struct iovec *) alloca(riovcnt * sizeof(struct iovec));
+    arena = na_sm_arena_translate(na_class, na_sm_addr,
+        na_sm_mem_handle_remote, remote_iov, riovcnt, arena_iov);
 
-    kret = mach_vm_write(remote_task,
-        (mach_vm_address_t) remote_iov->iov_base,
-        (mach_vm_address_t) local_iov->iov_base,
-        (mach_msg_type_number_t) length);
-    if (kret != KERN_SUCCESS) {
-        NA_LOG_ERROR("mach_vm_write() failed (%s)", mach_error_string(kret));
-        ret = NA_PROTOCOL_ERROR;
+    ret = na_sm_rma_transfer(NA_CB_PUT, na_sm_addr->pid, arena, local_iov,
+        liovcnt, arena ? arena_iov : remote_iov, riovcnt, length);
+    if (ret != NA_SUCCESS)
         goto done;
-    }
-#endif
 
     /* Immediate completion */
     ret = na_sm_complete(na_sm_op_id);
@@ -3800,14 +4966,9 @@ na_sm_put(na_class_t *na_class, na_context_t *context, na_cb_t callback,
         goto done;
     }
 
-    /* Notify local completion */
-    if (!NA_SM_CLASS(na_class)->no_wait
-        && (hg_event_set(NA_SM_CLASS(na_class)->self_addr->local_notify)
-        != HG_UTIL_SUCCESS)) {
-        NA_LOG_ERROR("Could not signal local completion");
-        ret = NA_PROTOCOL_ERROR;
-        goto done;
-    }
+    /* Notify local completion, batched operations are notified by caller */
+    if (notify)
+        ret = na_sm_notify_local(na_class);
 
 done:
     if (ret != NA_SUCCESS) {
@@ -3818,11 +4979,24 @@ done:
 
 /*---------------------------------------------------------------------------*/
 static na_return_t
-na_sm_get(na_class_t *na_class, na_context_t *context, na_cb_t callback,
+na_sm_put(na_class_t *na_class, na_context_t *context, na_cb_t callback,
     void *arg, na_mem_handle_t local_mem_handle, na_offset_t local_offset,
     na_mem_handle_t remote_mem_handle, na_offset_t remote_offset,
     na_size_t length, na_addr_t remote_addr, na_uint8_t NA_UNUSED remote_id,
     na_op_id_t *op_id)
+{
+    return na_sm_rma_put(na_class, context, callback, arg, local_mem_handle,
+        local_offset, remote_mem_handle, remote_offset, length, remote_addr,
+        op_id, NA_TRUE);
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_sm_rma_get(na_class_t *na_class, na_context_t *context, na_cb_t callback,
+    void *arg, na_mem_handle_t local_mem_handle, na_offset_t local_offset,
+    na_mem_handle_t remote_mem_handle, na_offset_t remote_offset,
+    na_size_t length, na_addr_t remote_addr, na_op_id_t *op_id,
+    na_bool_t notify)
 {
     struct na_sm_op_id *na_sm_op_id = NULL;
     struct na_sm_mem_handle *na_sm_mem_handle_local =
@@ -3830,16 +5004,11 @@ na_sm_get(na_class_t *na_class, na_context_t *context, na_cb_t callback,
     struct na_sm_mem_handle *na_sm_mem_handle_remote =
         (struct na_sm_mem_handle *) remote_mem_handle;
     struct na_sm_addr *na_sm_addr = (struct na_sm_addr *) remote_addr;
-    struct iovec *local_iov, *remote_iov;
+    struct iovec *local_iov, *remote_iov, *arena_iov;
     unsigned long liovcnt, riovcnt;
+    unsigned int chunk_count;
+    na_bool_t arena;
     na_return_t ret = NA_SUCCESS;
-#if defined(NA_SM_HAS_CMA)
-    ssize_t nread;
-#elif defined(__APPLE__)
-    mach_vm_size_t nread;
-    kern_return_t kret;
-    mach_port_name_t remote_task;
-#endif
 
 #if !defined(NA_SM_HAS_CMA) && !defined(__APPLE__)
     (void) na_sm_addr;
@@ -3880,13 +5049,25 @@ na_sm_get(na_class_t *na_class, na_context_t *context, na_cb_t callback,
     na_sm_op_id->completion_data.callback_info.type = NA_CB_GET;
     na_sm_op_id->completion_data.callback = callback;
     na_sm_op_id->completion_data.callback_info.arg = arg;
+    NA_STATS_POST(context, &na_sm_op_id->completion_data, NA_CB_GET, length);
     hg_atomic_set32(&na_sm_op_id->completed, NA_FALSE);
     hg_atomic_set32(&na_sm_op_id->canceled, NA_FALSE);
+    hg_atomic_set32(&na_sm_op_id->info.rma.ret, NA_SUCCESS);
 
     /* Assign op_id */
     if (op_id && op_id != NA_OP_ID_IGNORE && *op_id == NA_OP_ID_NULL)
         *op_id = na_sm_op_id;
 
+    /* Split large transfers across RMA helper threads, the thread that
+     * transfers the last chunk completes the operation */
+    chunk_count = na_sm_rma_chunk_count(na_class, length);
+    if (chunk_count > 1) {
+        ret = na_sm_rma_post_chunks(na_class, na_sm_op_id, na_sm_addr,
+            na_sm_mem_handle_local, local_offset, na_sm_mem_handle_remote,
+            remote_offset, length, chunk_count);
+        goto done;
+    }
+
     /* Translate local offset, skip this step if not necessary */
     if (local_offset || length != na_sm_mem_handle_local->len) {
         /* TODO fix allocation */
@@ -3911,45 +5092,15 @@ na_sm_get(na_class_t *na_class, na_context_t *context, na_cb_t callback,
         riovcnt = na_sm_mem_handle_remote->iovcnt;
     }
 
-#if defined(NA_SM_HAS_CMA)
-    nread = process_vm_readv(na_sm_addr->pid, local_iov, liovcnt, remote_iov,
-        riovcnt, /* unused */0);
-    if (nread < 0) {
-        NA_LOG_ERROR("process_vm_readv() failed (%s)", strerror(errno));
-        ret = NA_PROTOCOL_ERROR;
-        goto done;
-    }
-#elif defined(__APPLE__)
-    kret = task_for_pid(mach_task_self(), na_sm_addr->pid, &remote_task);
-    if (kret != KERN_SUCCESS) {
-        NA_LOG_ERROR("task_for_pid() failed (%s)\n"
-                     "Permission must be set to access remote memory, please refer to the documentation for instructions.", mach_error_string(kret));
-        ret = NA_PROTOCOL_ERROR;
-        goto done;
-    }
-
-    if (liovcnt > 1 || riovcnt > 1) {
-        NA_LOG_ERROR("Non-contiguous transfers are not supported");
-        ret = NA_PROTOCOL_ERROR;
-        goto done;
-    }
+    /* Remote memory may lie in the arena of the peer */
+    arena_iov = (struct iovec *) alloca(riovcnt * sizeof(struct iovec));
+    arena = na_sm_arena_translate(na_class, na_sm_addr,
+        na_sm_mem_handle_remote, remote_iov, riovcnt, arena_iov);
 
-    kret = mach_vm_read_overwrite(remote_task,
-        (mach_vm_address_t) remote_iov->iov_base, length,
-        (mach_vm_address_t) local_iov->iov_base, &nread);
-    if (kret != KERN_SUCCESS) {
-        NA_LOG_ERROR("mach_vm_read_overwrite() failed (%s)", mach_error_string(kret));
-        ret = NA_PROTOCOL_ERROR;
-        goto done;
-    }
-#endif
-#if defined(NA_SM_HAS_CMA) || defined(__APPLE__)
-    if ((na_size_t)nread != length) {
-        NA_LOG_ERROR("Read %ld bytes, was expecting %lu bytes", nread, length);
-        ret = NA_SIZE_ERROR;
+    ret = na_sm_rma_transfer(NA_CB_GET, na_sm_addr->pid, arena, local_iov,
+        liovcnt, arena ? arena_iov : remote_iov, riovcnt, length);
+    if (ret != NA_SUCCESS)
         goto done;
-    }
-#endif
 
     /* Immediate completion */
     ret = na_sm_complete(na_sm_op_id);
@@ -3958,14 +5109,9 @@ na_sm_get(na_class_t *na_class, na_context_t *context, na_cb_t callback,
         goto done;
     }
 
-    /* Notify local completion */
-    if (!NA_SM_CLASS(na_class)->no_wait
-        && (hg_event_set(NA_SM_CLASS(na_class)->self_addr->local_notify)
-        != HG_UTIL_SUCCESS)) {
-        NA_LOG_ERROR("Could not signal local completion");
-        ret = NA_PROTOCOL_ERROR;
-        goto done;
-    }
+    /* Notify local completion, batched operations are notified by caller */
+    if (notify)
+        ret = na_sm_notify_local(na_class);
 
 done:
     if (ret != NA_SUCCESS) {
@@ -3974,6 +5120,19 @@ done:
     return ret;
 }
 
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_sm_get(na_class_t *na_class, na_context_t *context, na_cb_t callback,
+    void *arg, na_mem_handle_t local_mem_handle, na_offset_t local_offset,
+    na_mem_handle_t remote_mem_handle, na_offset_t remote_offset,
+    na_size_t length, na_addr_t remote_addr, na_uint8_t NA_UNUSED remote_id,
+    na_op_id_t *op_id)
+{
+    return na_sm_rma_get(na_class, context, callback, arg, local_mem_handle,
+        local_offset, remote_mem_handle, remote_offset, length, remote_addr,
+        op_id, NA_TRUE);
+}
+
 /*---------------------------------------------------------------------------*/
 static NA_INLINE int
 na_sm_poll_get_fd(na_class_t *na_class, na_context_t NA_UNUSED *context)
@@ -4009,6 +5168,93 @@ na_sm_poll_try_wait(na_class_t *na_class, na_context_t NA_UNUSED *context)
     return ret;
 }
 
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_sm_poll_set_register(na_class_t *na_class, na_context_t NA_UNUSED *context,
+    struct hg_poll_set *poll_set)
+{
+    struct na_sm_ext_poll_set *na_sm_ext_poll_set = NULL;
+    struct na_sm_poll_data *na_sm_poll_data;
+    na_return_t ret = NA_SUCCESS;
+
+    na_sm_ext_poll_set = (struct na_sm_ext_poll_set *) malloc(
+        sizeof(struct na_sm_ext_poll_set));
+    if (!na_sm_ext_poll_set) {
+        NA_LOG_ERROR("Could not allocate NA SM external poll set");
+        ret = NA_NOMEM_ERROR;
+        goto done;
+    }
+    na_sm_ext_poll_set->poll_set = poll_set;
+
+    /* Add fds that are already registered, new fds will be added to all
+     * poll sets as they get registered */
+    hg_thread_mutex_lock(&NA_SM_CLASS(na_class)->poll_data_list_lock);
+    HG_LIST_FOREACH(na_sm_poll_data, &NA_SM_CLASS(na_class)->poll_data_list,
+        entry) {
+        if (hg_poll_add(poll_set, na_sm_poll_data->fd, HG_POLLIN,
+            na_sm_progress_cb, na_sm_poll_data) != HG_UTIL_SUCCESS) {
+            struct na_sm_poll_data *na_sm_poll_data_added;
+
+            /* Remove fds that were added */
+            HG_LIST_FOREACH(na_sm_poll_data_added,
+                &NA_SM_CLASS(na_class)->poll_data_list, entry) {
+                if (na_sm_poll_data_added == na_sm_poll_data)
+                    break;
+                hg_poll_remove(poll_set, na_sm_poll_data_added->fd);
+            }
+            hg_thread_mutex_unlock(
+                &NA_SM_CLASS(na_class)->poll_data_list_lock);
+            NA_LOG_ERROR("hg_poll_add failed");
+            free(na_sm_ext_poll_set);
+            ret = NA_PROTOCOL_ERROR;
+            goto done;
+        }
+    }
+    HG_LIST_INSERT_HEAD(&NA_SM_CLASS(na_class)->ext_poll_set_list,
+        na_sm_ext_poll_set, entry);
+    hg_thread_mutex_unlock(&NA_SM_CLASS(na_class)->poll_data_list_lock);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_sm_poll_set_deregister(na_class_t *na_class,
+    na_context_t NA_UNUSED *context, struct hg_poll_set *poll_set)
+{
+    struct na_sm_ext_poll_set *na_sm_ext_poll_set;
+    struct na_sm_poll_data *na_sm_poll_data;
+    na_return_t ret = NA_SUCCESS;
+
+    hg_thread_mutex_lock(&NA_SM_CLASS(na_class)->poll_data_list_lock);
+    HG_LIST_FOREACH(na_sm_ext_poll_set,
+        &NA_SM_CLASS(na_class)->ext_poll_set_list, entry) {
+        if (na_sm_ext_poll_set->poll_set == poll_set)
+            break;
+    }
+    if (!na_sm_ext_poll_set) {
+        hg_thread_mutex_unlock(&NA_SM_CLASS(na_class)->poll_data_list_lock);
+        NA_LOG_ERROR("Poll set was not registered");
+        ret = NA_INVALID_PARAM;
+        goto done;
+    }
+    HG_LIST_REMOVE(na_sm_ext_poll_set, entry);
+
+    HG_LIST_FOREACH(na_sm_poll_data, &NA_SM_CLASS(na_class)->poll_data_list,
+        entry) {
+        if (hg_poll_remove(poll_set, na_sm_poll_data->fd) != HG_UTIL_SUCCESS) {
+            NA_LOG_ERROR("hg_poll_remove failed");
+            ret = NA_PROTOCOL_ERROR;
+        }
+    }
+    hg_thread_mutex_unlock(&NA_SM_CLASS(na_class)->poll_data_list_lock);
+    free(na_sm_ext_poll_set);
+
+done:
+    return ret;
+}
+
 /*---------------------------------------------------------------------------*/
 static na_return_t
 na_sm_progress(na_class_t *na_class, na_context_t NA_UNUSED *context,
@@ -4018,11 +5264,11 @@ na_sm_progress(na_class_t *na_class, na_context_t NA_UNUSED *context,
     na_return_t ret = NA_TIMEOUT;
 
     do {
-        hg_time_t t1, t2;
+        hg_time_ticks_t t1, t2;
         hg_util_bool_t progressed;
 
         if (timeout)
-            hg_time_get_current(&t1);
+            t1 = hg_time_get_ticks();
 
         if (hg_poll_wait(NA_SM_CLASS(na_class)->poll_set,
             (unsigned int) (remaining * 1000.0), &progressed) != HG_UTIL_SUCCESS) {
@@ -4038,8 +5284,8 @@ na_sm_progress(na_class_t *na_class, na_context_t NA_UNUSED *context,
         }
 
         if (timeout) {
-            hg_time_get_current(&t2);
-            remaining -= hg_time_to_double(hg_time_subtract(t2, t1));
+            t2 = hg_time_get_ticks();
+            remaining -= hg_time_ticks_to_double(t2 - t1);
         }
     } while ((int)(remaining * 1000.0) > 0);
 
@@ -4098,19 +5344,24 @@ na_sm_cancel(na_class_t *na_class, na_context_t NA_UNUSED *context,
             break;
         case NA_CB_RECV_EXPECTED: {
             struct na_sm_op_id *na_sm_var_op_id = NULL;
+            unsigned int bucket = NA_SM_EXPECTED_HASH(
+                na_sm_op_id->info.recv_expected.na_sm_addr,
+                na_sm_op_id->info.recv_expected.tag);
 
-            /* Must remove op_id from unexpected op_id queue */
-            hg_thread_spin_lock(&NA_SM_CLASS(na_class)->expected_op_queue_lock);
+            /* Must remove op_id from its bucket if it was not matched yet */
+            hg_thread_spin_lock(&NA_SM_CLASS(na_class)->expected_op_table_lock);
             HG_QUEUE_FOREACH(na_sm_var_op_id,
-                &NA_SM_CLASS(na_class)->expected_op_queue, entry) {
+                &NA_SM_CLASS(na_class)->expected_op_table[bucket],
+                expected_entry) {
                 if (na_sm_var_op_id == na_sm_op_id) {
-                    HG_QUEUE_REMOVE(&NA_SM_CLASS(na_class)->expected_op_queue,
-                        na_sm_var_op_id, na_sm_op_id, entry);
+                    HG_QUEUE_REMOVE(
+                        &NA_SM_CLASS(na_class)->expected_op_table[bucket],
+                        na_sm_var_op_id, na_sm_op_id, expected_entry);
                     break;
                 }
             }
             hg_thread_spin_unlock(
-                &NA_SM_CLASS(na_class)->expected_op_queue_lock);
+                &NA_SM_CLASS(na_class)->expected_op_table_lock);
 
             /* Cancel op id */
             if (na_sm_var_op_id == na_sm_op_id) {
@@ -4138,3 +5389,267 @@ na_sm_cancel(na_class_t *na_class, na_context_t NA_UNUSED *context,
 done:
     return ret;
 }
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_sm_submit(na_class_t *na_class, na_context_t *context,
+    const struct na_op_desc *op_descs, na_size_t count, na_size_t *posted)
+{
+    struct na_sm_addr *pending_addr = NULL;
+    unsigned int pending_count = 0;
+    na_bool_t completed = NA_FALSE;
+    na_return_t ret = NA_SUCCESS, notify_ret;
+    na_size_t i;
+
+    for (i = 0; i < count; i++) {
+        const struct na_op_desc *desc = &op_descs[i];
+
+        switch (desc->type) {
+            case NA_CB_SEND_UNEXPECTED:
+            case NA_CB_SEND_EXPECTED:
+                if (desc->info.msg.buf_size > ((desc->type
+                    == NA_CB_SEND_UNEXPECTED) ? NA_SM_UNEXPECTED_SIZE :
+                        NA_SM_EXPECTED_SIZE)) {
+                    NA_LOG_ERROR("Exceeds message size");
+                    ret = NA_SIZE_ERROR;
+                    goto done;
+                }
+
+                /* Ring the remote once per run of messages to the same
+                 * address */
+                if (pending_addr
+                    && pending_addr != (struct na_sm_addr *) desc->info.msg.addr
+                    && pending_count) {
+                    ret = na_sm_notify_remote(na_class, pending_addr,
+                        pending_count);
+                    if (ret != NA_SUCCESS)
+                        goto done;
+                    pending_count = 0;
+                }
+                pending_addr = (struct na_sm_addr *) desc->info.msg.addr;
+
+                ret = na_sm_msg_send(na_class, context, desc->type,
+                    desc->callback, desc->arg, desc->info.msg.buf,
+                    desc->info.msg.buf_size, desc->info.msg.addr,
+                    desc->info.msg.tag, desc->op_id, &pending_count);
+                completed = NA_TRUE;
+                break;
+            case NA_CB_RECV_UNEXPECTED:
+                ret = na_sm_msg_recv_unexpected(na_class, context,
+                    desc->callback, desc->arg, desc->info.msg.buf,
+                    desc->info.msg.buf_size, desc->info.msg.plugin_data,
+                    desc->op_id);
+                break;
+            case NA_CB_RECV_EXPECTED:
+                ret = na_sm_msg_recv_expected(na_class, context,
+                    desc->callback, desc->arg, desc->info.msg.buf,
+                    desc->info.msg.buf_size, desc->info.msg.plugin_data,
+                    desc->info.msg.addr, desc->info.msg.id,
+                    desc->info.msg.tag, desc->op_id);
+                break;
+            case NA_CB_PUT:
+                ret = na_sm_rma_put(na_class, context, desc->callback,
+                    desc->arg, desc->info.rma.local_mem_handle,
+                    desc->info.rma.local_offset,
+                    desc->info.rma.remote_mem_handle,
+                    desc->info.rma.remote_offset, desc->info.rma.length,
+                    desc->info.rma.remote_addr, desc->op_id, NA_FALSE);
+                completed = NA_TRUE;
+                break;
+            case NA_CB_GET:
+                ret = na_sm_rma_get(na_class, context, desc->callback,
+                    desc->arg, desc->info.rma.local_mem_handle,
+                    desc->info.rma.local_offset,
+                    desc->info.rma.remote_mem_handle,
+                    desc->info.rma.remote_offset, desc->info.rma.length,
+                    desc->info.rma.remote_addr, desc->op_id, NA_FALSE);
+                completed = NA_TRUE;
+                break;
+            default:
+                NA_LOG_ERROR("Operation type %d not supported", desc->type);
+                ret = NA_INVALID_PARAM;
+                goto done;
+        }
+        if (ret != NA_SUCCESS) {
+            NA_LOG_ERROR("Could not post operation %zu", (size_t) i);
+            goto done;
+        }
+    }
+
+done:
+    /* Operations that were posted must be notified even on error */
+    if (pending_count) {
+        notify_ret = na_sm_notify_remote(na_class, pending_addr,
+            pending_count);
+        if (notify_ret != NA_SUCCESS && ret == NA_SUCCESS)
+            ret = notify_ret;
+    }
+    if (completed) {
+        notify_ret = na_sm_notify_local(na_class);
+        if (notify_ret != NA_SUCCESS && ret == NA_SUCCESS)
+            ret = notify_ret;
+    }
+    if (posted)
+        *posted = i;
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_sm_msg_loan_release(na_class_t *na_class, void *buf, na_size_t buf_size,
+    na_addr_t source_addr)
+{
+    struct na_sm_addr *na_sm_addr = (struct na_sm_addr *) source_addr;
+    struct na_sm_copy_buf *na_sm_copy_buf;
+    struct na_sm_loan_copy *na_sm_loan_copy;
+    hg_util_int32_t count, loan_count;
+    size_t offset;
+    na_return_t ret = NA_SUCCESS;
+
+    if (!na_sm_addr || !na_sm_addr->na_sm_copy_buf) {
+        NA_LOG_ERROR("NULL or unconnected source address");
+        ret = NA_INVALID_PARAM;
+        goto done;
+    }
+    na_sm_copy_buf = na_sm_addr->na_sm_copy_buf;
+
+    /* Buffer may be a copy made once too many slots were loaned */
+    if ((char *) buf < (char *) na_sm_copy_buf->buf
+        || (char *) buf >= (char *) na_sm_copy_buf->buf
+            + sizeof(na_sm_copy_buf->buf)) {
+        hg_thread_spin_lock(&NA_SM_CLASS(na_class)->loan_copy_list_lock);
+        HG_LIST_FOREACH(na_sm_loan_copy,
+            &NA_SM_CLASS(na_class)->loan_copy_list, entry) {
+            if (na_sm_loan_copy->buf == buf
+                && na_sm_loan_copy->na_sm_addr == na_sm_addr) {
+                HG_LIST_REMOVE(na_sm_loan_copy, entry);
+                break;
+            }
+        }
+        hg_thread_spin_unlock(&NA_SM_CLASS(na_class)->loan_copy_list_lock);
+        if (!na_sm_loan_copy) {
+            NA_LOG_ERROR("Buffer was not loaned from that source address");
+            ret = NA_INVALID_PARAM;
+            goto done;
+        }
+        free(na_sm_loan_copy);
+        goto done;
+    }
+
+    /* Loaned buffers always start at a slot boundary of the source copy buf */
+    offset = (size_t) ((char *) buf - (char *) na_sm_copy_buf->buf);
+    if ((char *) buf < (char *) na_sm_copy_buf->buf
+        || offset % NA_SM_COPY_BUF_SIZE
+        || offset / NA_SM_COPY_BUF_SIZE + NA_SM_BUF_COUNT(buf_size)
+            > NA_SM_NUM_BUFS) {
+        NA_LOG_ERROR("Buffer was not loaned from that source address");
+        ret = NA_INVALID_PARAM;
+        goto done;
+    }
+
+    na_sm_copy_and_free_buf(na_sm_copy_buf, NULL, buf_size,
+        (unsigned int) (offset / NA_SM_COPY_BUF_SIZE));
+
+    count = (hg_util_int32_t) NA_SM_BUF_COUNT(buf_size);
+    do {
+        loan_count = hg_atomic_get32(&na_sm_addr->loan_count);
+    } while (!hg_atomic_cas32(&na_sm_addr->loan_count, loan_count,
+        loan_count - count));
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static void *
+na_sm_mem_alloc(na_class_t *na_class, na_size_t buf_size, void **plugin_data)
+{
+    struct na_sm_class *na_sm_class = NA_SM_CLASS(na_class);
+    size_t npages = (buf_size + NA_SM_ARENA_PAGE_SIZE - 1)
+        / NA_SM_ARENA_PAGE_SIZE;
+    size_t i, run = 0;
+    void *ret = NULL;
+
+    hg_thread_mutex_lock(&na_sm_class->arena_lock);
+
+    /* Create arena on first use */
+    if (!na_sm_class->arena && !na_sm_class->arena_failed) {
+        char na_sm_arena_name[NA_SM_MAX_FILENAME];
+
+        NA_SM_GEN_ARENA_NAME(na_sm_arena_name, na_sm_class->username,
+            na_sm_class->self_addr->pid, na_sm_class->self_addr->id);
+        na_sm_class->arena_map = (unsigned char *) calloc(NA_SM_ARENA_PAGES,
+            sizeof(unsigned char));
+        if (na_sm_class->arena_map)
+            na_sm_class->arena = (char *) na_sm_open_shared_buf(na_class,
+                na_sm_arena_name, NA_SM_ARENA_SIZE, NA_TRUE,
+                &na_sm_class->arena_backing);
+        if (!na_sm_class->arena) {
+            NA_LOG_WARNING("Could not create arena, using regular memory");
+            free(na_sm_class->arena_map);
+            na_sm_class->arena_map = NULL;
+            na_sm_class->arena_failed = NA_TRUE;
+        }
+    }
+
+    /* First fit */
+    if (na_sm_class->arena && npages <= NA_SM_ARENA_PAGES) {
+        for (i = 0; i < NA_SM_ARENA_PAGES; i++) {
+            run = na_sm_class->arena_map[i] ? 0 : run + 1;
+            if (run == npages) {
+                i = i + 1 - npages;
+                memset(&na_sm_class->arena_map[i], 1, npages);
+                ret = na_sm_class->arena + i * NA_SM_ARENA_PAGE_SIZE;
+                break;
+            }
+        }
+    }
+
+    hg_thread_mutex_unlock(&na_sm_class->arena_lock);
+
+    if (ret) {
+        *plugin_data = (void *) npages;
+    } else {
+        /* Arena is full or unavailable */
+        ret = hg_mem_aligned_alloc((size_t) hg_mem_get_page_size(), buf_size);
+        if (!ret) {
+            NA_LOG_ERROR("Could not allocate %zu bytes", (size_t) buf_size);
+            goto done;
+        }
+        *plugin_data = NULL;
+    }
+    memset(ret, 0, buf_size);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static na_return_t
+na_sm_mem_free(na_class_t *na_class, void *buf, void *plugin_data)
+{
+    struct na_sm_class *na_sm_class = NA_SM_CLASS(na_class);
+    size_t npages = (size_t) plugin_data, offset;
+    na_return_t ret = NA_SUCCESS;
+
+    if (!npages) {
+        hg_mem_aligned_free(buf);
+        goto done;
+    }
+
+    offset = (size_t) ((char *) buf - na_sm_class->arena);
+    if (!na_sm_class->arena || (char *) buf < na_sm_class->arena
+        || offset % NA_SM_ARENA_PAGE_SIZE
+        || offset / NA_SM_ARENA_PAGE_SIZE + npages > NA_SM_ARENA_PAGES) {
+        NA_LOG_ERROR("Buffer was not allocated from arena");
+        ret = NA_INVALID_PARAM;
+        goto done;
+    }
+
+    hg_thread_mutex_lock(&na_sm_class->arena_lock);
+    memset(&na_sm_class->arena_map[offset / NA_SM_ARENA_PAGE_SIZE], 0, npages);
+    hg_thread_mutex_unlock(&na_sm_class->arena_lock);
+
+done:
+    return ret;
+}
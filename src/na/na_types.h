@@ -40,6 +40,10 @@ struct na_init_info {
     const char *auth_key;               /* Authorization key */
     na_progress_mode_t progress_mode;   /* Progress mode */
     na_uint8_t max_contexts;            /* Max contexts */
+    na_uint32_t completion_queue_size;  /* Initial completion queue size
+                                         * (0 for default) */
+    na_bool_t huge_pages;               /* Back message buffers and large
+                                         * shared segments with huge pages */
 };
 
 /* Segment */
@@ -97,6 +101,12 @@ struct na_cb_info_recv_unexpected {
     na_size_t actual_buf_size;
     na_addr_t source;
     na_tag_t  tag;
+    void     *actual_buf;       /* Loaned buffer (see NA_Msg_loan_release()) */
+};
+
+struct na_cb_info_recv_expected {
+    na_size_t actual_buf_size;
+    void     *actual_buf;       /* Loaned buffer (see NA_Msg_loan_release()) */
 };
 
 /* Callback info struct */
@@ -104,6 +114,7 @@ struct na_cb_info {
     union {             /* Union of callback info structures */
         struct na_cb_info_lookup lookup;
         struct na_cb_info_recv_unexpected recv_unexpected;
+        struct na_cb_info_recv_expected recv_expected;
     } info;
     void *arg;          /* User data */
     na_cb_type_t type;  /* Callback type */
@@ -113,6 +124,64 @@ struct na_cb_info {
 /* Callback type */
 typedef int (*na_cb_t)(const struct na_cb_info *callback_info);
 
+/* Completion push callback (see NA_Context_set_completion_push()) */
+typedef na_return_t (*na_cb_completion_push_t)(void *arg,
+    void *completion_entry);
+
+/* Operation descriptor for batch submission (see NA_Submit()) */
+struct na_op_desc {
+    na_cb_type_t type;          /* Operation type (no lookup) */
+    na_cb_t callback;           /* Completion callback */
+    void *arg;                  /* User data passed to callback */
+    union {
+        struct {
+            void *buf;                  /* Send or receive buffer */
+            na_size_t buf_size;         /* Buffer size */
+            void *plugin_data;          /* Plugin data of buffer */
+            na_addr_t addr;             /* Destination or source address */
+            na_uint8_t id;              /* Destination or source context ID */
+            na_tag_t tag;               /* Tag */
+        } msg;                  /* Messages (address, ID and tag are ignored
+                                 * for unexpected receives) */
+        struct {
+            na_mem_handle_t local_mem_handle;   /* Local memory handle */
+            na_offset_t local_offset;           /* Local offset */
+            na_mem_handle_t remote_mem_handle;  /* Remote memory handle */
+            na_offset_t remote_offset;          /* Remote offset */
+            na_size_t length;                   /* Size of data */
+            na_addr_t remote_addr;              /* Remote address */
+            na_uint8_t remote_id;               /* Remote context ID */
+        } rma;                  /* Puts and gets */
+    } info;
+    na_op_id_t *op_id;          /* Pointer to operation ID */
+};
+
+/* Number of operation types and latency buckets tracked in na_stats */
+#define NA_STATS_OP_MAX         (NA_CB_GET + 1)
+#define NA_STATS_HIST_BUCKETS   (24)
+
+/* Context statistics (see NA_Get_stats()), arrays are indexed by
+ * na_cb_type_t and latency bucket i counts operations that completed
+ * in [2^(i-1), 2^i) us after being posted (bucket 0 is < 1 us) */
+struct na_stats {
+    na_uint64_t posted[NA_STATS_OP_MAX];    /* Operations posted */
+    na_uint64_t completed[NA_STATS_OP_MAX]; /* Completed successfully */
+    na_uint64_t canceled[NA_STATS_OP_MAX];  /* Completed as canceled */
+    na_uint64_t errors[NA_STATS_OP_MAX];    /* Completed with an error */
+    na_uint64_t latency[NA_STATS_OP_MAX][NA_STATS_HIST_BUCKETS]; /* Latency */
+    na_uint64_t cancel_count;       /* Calls to NA_Cancel() */
+    na_uint64_t bytes_sent;         /* Bytes sent or put (completed ops) */
+    na_uint64_t bytes_received;     /* Bytes got or received as unexpected
+                                     * messages (completed ops) */
+    na_uint64_t again_count;        /* Transient resource exhaustion retries */
+    na_uint64_t cq_full_count;      /* Plugin completion polls that were full */
+    na_uint64_t unexpected_queued;  /* Unexpected receives matched to a message
+                                     * that arrived before they were posted */
+    na_uint64_t unexpected_depth_max;   /* Max unexpected message backlog */
+    na_uint64_t completion_depth;   /* Current completion queue depth */
+    na_uint64_t completion_depth_max;   /* Max completion queue depth */
+};
+
 /*****************/
 /* Public Macros */
 /*****************/
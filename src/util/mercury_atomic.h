@@ -602,7 +602,7 @@ hg_atomic_fence()
 #elif defined(HG_UTIL_HAS_STDATOMIC_H)
 #ifdef __INTEL_COMPILER
 #else
-    atomic_thread_fence(memory_order_acq_rel);
+    atomic_thread_fence(memory_order_seq_cst);
 #endif
 #elif defined(__APPLE__)
     OSMemoryBarrier();
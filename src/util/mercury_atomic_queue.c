@@ -85,3 +85,107 @@ hg_atomic_queue_free(struct hg_atomic_queue *hg_atomic_queue)
 {
     free(hg_atomic_queue);
 }
+
+/*---------------------------------------------------------------------------*/
+struct hg_atomic_queue_chain *
+hg_atomic_queue_chain_alloc(unsigned int count)
+{
+    struct hg_atomic_queue_chain *hg_atomic_queue_chain = NULL;
+    unsigned int seg_size = 2;
+
+    while (seg_size < count)
+        seg_size <<= 1;
+
+    hg_atomic_queue_chain = malloc(sizeof(struct hg_atomic_queue_chain));
+    if (!hg_atomic_queue_chain) {
+        HG_UTIL_LOG_ERROR("Could not allocate atomic queue chain");
+        goto done;
+    }
+
+    hg_atomic_queue_chain->segs[0] = hg_atomic_queue_alloc(seg_size);
+    if (!hg_atomic_queue_chain->segs[0]) {
+        HG_UTIL_LOG_ERROR("Could not allocate atomic queue");
+        free(hg_atomic_queue_chain);
+        hg_atomic_queue_chain = NULL;
+        goto done;
+    }
+    hg_atomic_init32(&hg_atomic_queue_chain->count, 1);
+    hg_atomic_init32(&hg_atomic_queue_chain->growing, 0);
+
+done:
+    return hg_atomic_queue_chain;
+}
+
+/*---------------------------------------------------------------------------*/
+void
+hg_atomic_queue_chain_free(struct hg_atomic_queue_chain *hg_atomic_queue_chain)
+{
+    hg_util_int32_t i;
+
+    if (!hg_atomic_queue_chain)
+        return;
+
+    for (i = 0; i < hg_atomic_get32(&hg_atomic_queue_chain->count); i++)
+        hg_atomic_queue_free(hg_atomic_queue_chain->segs[i]);
+    free(hg_atomic_queue_chain);
+}
+
+/*---------------------------------------------------------------------------*/
+int
+hg_atomic_queue_chain_grow(struct hg_atomic_queue_chain *hg_atomic_queue_chain,
+    hg_util_int32_t seg_count)
+{
+    struct hg_atomic_queue *last_seg;
+    int ret = HG_UTIL_SUCCESS;
+
+    if (!hg_atomic_cas32(&hg_atomic_queue_chain->growing, 0, 1)) {
+        /* Another thread is adding a segment, wait for it and retry */
+        while (hg_atomic_get32(&hg_atomic_queue_chain->growing))
+            cpu_spinwait();
+        goto done;
+    }
+
+    /* Segment was already added since caller looked */
+    if (hg_atomic_get32(&hg_atomic_queue_chain->count) != seg_count)
+        goto unlock;
+
+    if (seg_count == HG_ATOMIC_QUEUE_CHAIN_MAX) {
+        HG_UTIL_LOG_ERROR("Reached maximum number of queue segments");
+        ret = HG_UTIL_FAIL;
+        goto unlock;
+    }
+
+    last_seg = hg_atomic_queue_chain->segs[seg_count - 1];
+    hg_atomic_queue_chain->segs[seg_count] =
+        hg_atomic_queue_alloc(last_seg->prod_size << 1);
+    if (!hg_atomic_queue_chain->segs[seg_count]) {
+        HG_UTIL_LOG_ERROR("Could not allocate atomic queue");
+        ret = HG_UTIL_FAIL;
+        goto unlock;
+    }
+
+    /* Publish new segment */
+    hg_atomic_set32(&hg_atomic_queue_chain->count, seg_count + 1);
+
+unlock:
+    hg_atomic_set32(&hg_atomic_queue_chain->growing, 0);
+
+done:
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+unsigned int
+hg_atomic_queue_chain_count(
+    struct hg_atomic_queue_chain *hg_atomic_queue_chain)
+{
+    hg_util_int32_t seg_count =
+        hg_atomic_get32(&hg_atomic_queue_chain->count);
+    hg_util_int32_t i;
+    unsigned int ret = 0;
+
+    for (i = 0; i < seg_count; i++)
+        ret += hg_atomic_queue_count(hg_atomic_queue_chain->segs[i]);
+
+    return ret;
+}
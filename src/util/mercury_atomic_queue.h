@@ -62,6 +62,18 @@ struct hg_atomic_queue {
     hg_atomic_int64_t *ring[1] __attribute__((aligned(HG_UTIL_CACHE_ALIGNMENT)));
 };
 
+/* Maximum number of segments in a queue chain */
+#define HG_ATOMIC_QUEUE_CHAIN_MAX 16
+
+/* Chain of atomic queues, each new segment being twice as large as the
+ * previous one. Segments are only added, never removed until the chain is
+ * freed, so that they can be accessed without locking. */
+struct hg_atomic_queue_chain {
+    hg_atomic_int32_t count;    /* Number of segments visible */
+    hg_atomic_int32_t growing;  /* Segment currently being added */
+    struct hg_atomic_queue *segs[HG_ATOMIC_QUEUE_CHAIN_MAX];
+};
+
 /*****************/
 /* Public Macros */
 /*****************/
@@ -123,6 +135,20 @@ hg_atomic_queue_push(struct hg_atomic_queue *hg_atomic_queue, void *entry);
 static HG_UTIL_INLINE void *
 hg_atomic_queue_pop_mc(struct hg_atomic_queue *hg_atomic_queue);
 
+/**
+ * Pop up to \count entries from the queue (multi-consumer). Entries are
+ * claimed with a single atomic operation.
+ *
+ * \param hg_atomic_queue [IN/OUT]  pointer to queue
+ * \param entries [OUT]             array of popped objects
+ * \param count [IN]                maximum number of entries to pop
+ *
+ * \return Number of entries popped or 0 if queue is empty
+ */
+static HG_UTIL_INLINE unsigned int
+hg_atomic_queue_pop_mc_n(struct hg_atomic_queue *hg_atomic_queue,
+    void **entries, unsigned int count);
+
 /**
  * Pop an entry from the queue (single consumer).
  *
@@ -153,6 +179,102 @@ hg_atomic_queue_is_empty(struct hg_atomic_queue *hg_atomic_queue);
 static HG_UTIL_INLINE unsigned int
 hg_atomic_queue_count(struct hg_atomic_queue *hg_atomic_queue);
 
+/**
+ * Allocate a new queue chain whose first segment can hold \count elements.
+ * \count is rounded up to the next power of 2.
+ *
+ * \param count [IN]                initial number of elements
+ *
+ * \return pointer to allocated queue chain or NULL on failure
+ */
+HG_UTIL_EXPORT struct hg_atomic_queue_chain *
+hg_atomic_queue_chain_alloc(unsigned int count);
+
+/**
+ * Free an existing queue chain.
+ *
+ * \param hg_atomic_queue_chain [IN] pointer to queue chain
+ */
+HG_UTIL_EXPORT void
+hg_atomic_queue_chain_free(struct hg_atomic_queue_chain *hg_atomic_queue_chain);
+
+/**
+ * Add a new segment to the queue chain if \seg_count is still the current
+ * number of segments. This is the slow path of hg_atomic_queue_chain_push()
+ * and should not be called directly.
+ *
+ * \param hg_atomic_queue_chain [IN/OUT] pointer to queue chain
+ * \param seg_count [IN]            number of segments seen by caller
+ *
+ * \return Non-negative on success or negative on failure
+ */
+HG_UTIL_EXPORT int
+hg_atomic_queue_chain_grow(struct hg_atomic_queue_chain *hg_atomic_queue_chain,
+    hg_util_int32_t seg_count);
+
+/**
+ * Push an entry to the queue chain. If the last segment is full, a new
+ * segment is appended so that push only fails if memory is exhausted.
+ *
+ * \param hg_atomic_queue_chain [IN/OUT] pointer to queue chain
+ * \param entry [IN]                pointer to object
+ *
+ * \return Non-negative on success or negative on failure
+ */
+static HG_UTIL_INLINE int
+hg_atomic_queue_chain_push(struct hg_atomic_queue_chain *hg_atomic_queue_chain,
+    void *entry);
+
+/**
+ * Pop an entry from the queue chain (multi-consumer). Entries are taken
+ * from older segments first.
+ *
+ * \param hg_atomic_queue_chain [IN/OUT] pointer to queue chain
+ *
+ * \return Pointer to popped object or NULL if queue chain is empty
+ */
+static HG_UTIL_INLINE void *
+hg_atomic_queue_chain_pop_mc(
+    struct hg_atomic_queue_chain *hg_atomic_queue_chain);
+
+/**
+ * Pop up to \count entries from the queue chain (multi-consumer). Entries
+ * are taken from older segments first.
+ *
+ * \param hg_atomic_queue_chain [IN/OUT] pointer to queue chain
+ * \param entries [OUT]             array of popped objects
+ * \param count [IN]                maximum number of entries to pop
+ *
+ * \return Number of entries popped or 0 if queue chain is empty
+ */
+static HG_UTIL_INLINE unsigned int
+hg_atomic_queue_chain_pop_mc_n(
+    struct hg_atomic_queue_chain *hg_atomic_queue_chain, void **entries,
+    unsigned int count);
+
+/**
+ * Determine whether queue chain is empty.
+ *
+ * \param hg_atomic_queue_chain [IN/OUT] pointer to queue chain
+ *
+ * \return HG_UTIL_TRUE if empty, HG_UTIL_FALSE if not
+ */
+static HG_UTIL_INLINE hg_util_bool_t
+hg_atomic_queue_chain_is_empty(
+    struct hg_atomic_queue_chain *hg_atomic_queue_chain);
+
+/**
+ * Determine number of entries in a queue chain. This walks all segments and is
+ * not meant to be called on a fast path.
+ *
+ * \param hg_atomic_queue_chain [IN/OUT] pointer to queue chain
+ *
+ * \return Number of entries queued or 0 if none
+ */
+HG_UTIL_EXPORT unsigned int
+hg_atomic_queue_chain_count(
+    struct hg_atomic_queue_chain *hg_atomic_queue_chain);
+
 /*---------------------------------------------------------------------------*/
 static HG_UTIL_INLINE int
 hg_atomic_queue_push(struct hg_atomic_queue *hg_atomic_queue, void *entry)
@@ -229,6 +351,48 @@ done:
     return entry;
 }
 
+/*---------------------------------------------------------------------------*/
+static HG_UTIL_INLINE unsigned int
+hg_atomic_queue_pop_mc_n(struct hg_atomic_queue *hg_atomic_queue,
+    void **entries, unsigned int count)
+{
+    hg_util_int32_t cons_head, cons_next;
+    unsigned int avail, i;
+
+    if (count == 0)
+        return 0;
+
+    do {
+        cons_head = hg_atomic_get32(&hg_atomic_queue->cons_head);
+        avail = ((unsigned int) hg_atomic_get32(&hg_atomic_queue->prod_tail)
+            - (unsigned int) cons_head) & hg_atomic_queue->cons_mask;
+        if (avail == 0)
+            return 0;
+        if (avail < count)
+            count = avail;
+        cons_next = (cons_head + (hg_util_int32_t) count)
+            & (int) hg_atomic_queue->cons_mask;
+    } while (!hg_atomic_cas32(&hg_atomic_queue->cons_head, cons_head,
+        cons_next));
+
+    for (i = 0; i < count; i++)
+        entries[i] = (void *) hg_atomic_get64((hg_atomic_int64_t *)
+            &hg_atomic_queue->ring[((unsigned int) cons_head + i)
+                & hg_atomic_queue->cons_mask]);
+
+    /*
+     * If there are other dequeues in progress
+     * that preceded us, we need to wait for them
+     * to complete
+     */
+    while (hg_atomic_get32(&hg_atomic_queue->cons_tail) != cons_head)
+        cpu_spinwait();
+
+    hg_atomic_set32(&hg_atomic_queue->cons_tail, cons_next);
+
+    return count;
+}
+
 /*---------------------------------------------------------------------------*/
 static HG_UTIL_INLINE void *
 hg_atomic_queue_pop_sc(struct hg_atomic_queue *hg_atomic_queue)
@@ -274,6 +438,77 @@ hg_atomic_queue_count(struct hg_atomic_queue *hg_atomic_queue)
         & hg_atomic_queue->prod_mask);
 }
 
+/*---------------------------------------------------------------------------*/
+static HG_UTIL_INLINE int
+hg_atomic_queue_chain_push(struct hg_atomic_queue_chain *hg_atomic_queue_chain,
+    void *entry)
+{
+    hg_util_int32_t seg_count;
+    int ret;
+
+    do {
+        seg_count = hg_atomic_get32(&hg_atomic_queue_chain->count);
+        ret = hg_atomic_queue_push(hg_atomic_queue_chain->segs[seg_count - 1],
+            entry);
+        if (ret == HG_UTIL_SUCCESS)
+            break;
+        /* Last segment is full */
+        ret = hg_atomic_queue_chain_grow(hg_atomic_queue_chain, seg_count);
+    } while (ret == HG_UTIL_SUCCESS);
+
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static HG_UTIL_INLINE void *
+hg_atomic_queue_chain_pop_mc(
+    struct hg_atomic_queue_chain *hg_atomic_queue_chain)
+{
+    hg_util_int32_t seg_count =
+        hg_atomic_get32(&hg_atomic_queue_chain->count);
+    hg_util_int32_t i;
+    void *entry = NULL;
+
+    for (i = 0; i < seg_count && !entry; i++)
+        entry = hg_atomic_queue_pop_mc(hg_atomic_queue_chain->segs[i]);
+
+    return entry;
+}
+
+/*---------------------------------------------------------------------------*/
+static HG_UTIL_INLINE unsigned int
+hg_atomic_queue_chain_pop_mc_n(
+    struct hg_atomic_queue_chain *hg_atomic_queue_chain, void **entries,
+    unsigned int count)
+{
+    hg_util_int32_t seg_count =
+        hg_atomic_get32(&hg_atomic_queue_chain->count);
+    hg_util_int32_t i;
+    unsigned int ret = 0;
+
+    for (i = 0; i < seg_count && ret < count; i++)
+        ret += hg_atomic_queue_pop_mc_n(hg_atomic_queue_chain->segs[i],
+            entries + ret, count - ret);
+
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static HG_UTIL_INLINE hg_util_bool_t
+hg_atomic_queue_chain_is_empty(
+    struct hg_atomic_queue_chain *hg_atomic_queue_chain)
+{
+    hg_util_int32_t seg_count =
+        hg_atomic_get32(&hg_atomic_queue_chain->count);
+    hg_util_int32_t i;
+
+    for (i = 0; i < seg_count; i++)
+        if (!hg_atomic_queue_is_empty(hg_atomic_queue_chain->segs[i]))
+            return HG_UTIL_FALSE;
+
+    return HG_UTIL_TRUE;
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,1169 @@
+/*
+ * Copyright (C) 2013-2019 Argonne National Laboratory, Department of Energy,
+ *                    UChicago Argonne, LLC and The HDF Group.
+ * All rights reserved.
+ *
+ * The full copyright notice, including terms governing use, modification,
+ * and redistribution, is contained in the COPYING file that can be
+ * found at the root of the source code distribution tree.
+ */
+
+#include "mercury_hash_map.h"
+#include "mercury_atomic.h"
+#include "mercury_thread.h"
+#include "mercury_thread_mutex.h"
+#include "mercury_thread_spin.h"
+#include "mercury_util_error.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/****************/
+/* Local Macros */
+/****************/
+
+/* Initial number of slots (must be a power of 2) */
+#define HG_HASH_MAP_MIN_SIZE        16
+
+/* Number of update locks (must be a power of 2) */
+#define HG_HASH_MAP_LOCK_COUNT      64
+
+/* Number of old slots migrated by each update while resizing */
+#define HG_HASH_MAP_MIGRATE_CHUNK   64
+
+/* Slot states. Slots are never reused once filled so that lookups can read
+ * a slot without locking; removed keys leave DELETED slots that are dropped
+ * when the table is next resized. */
+#define HG_HASH_MAP_EMPTY           0   /* Never used */
+#define HG_HASH_MAP_BUSY            1   /* Being filled */
+#define HG_HASH_MAP_FULL            2   /* Holds a key */
+#define HG_HASH_MAP_DELETED         3   /* Key was removed */
+#define HG_HASH_MAP_MOVED           4   /* Key was migrated to next table */
+#define HG_HASH_MAP_CLOSED          5   /* Empty slot closed by migration */
+
+/* Probe results */
+#define HG_HASH_MAP_FOUND           0
+#define HG_HASH_MAP_NOT_FOUND       1
+#define HG_HASH_MAP_RETRY           2
+
+#define HG_HASH_MAP_TO_PTR(x)       ((void *) (hg_util_ptr_t) (x))
+#define HG_HASH_MAP_TO_INT(x)       ((hg_util_int64_t) (hg_util_ptr_t) (x))
+
+#define HG_HASH_MAP_LOCK(map, hash) \
+    (&(map)->locks[((hash) >> 32) & (HG_HASH_MAP_LOCK_COUNT - 1)])
+
+/* Number of table size classes kept for reuse */
+#define HG_HASH_MAP_POOL_COUNT      32
+
+#ifndef cpu_spinwait
+# if defined(__x86_64__) || defined(__amd64__)
+#  define cpu_spinwait() asm volatile("pause\n": : :"memory");
+# else
+#  define cpu_spinwait();
+# endif
+#endif
+
+/************************************/
+/* Local Type and Struct Definition */
+/************************************/
+
+/* Objects that are released once no writer can access them anymore. Tables
+ * are kept for reuse instead of being freed, see hg_hash_map_lookup(). */
+struct hg_hash_map_retired {
+    struct hg_hash_map_retired *next;
+    hg_util_bool_t is_table;
+};
+
+/* Copy of a byte-string key */
+struct hg_hash_map_key {
+    struct hg_hash_map_retired retired; /* Must remain first */
+    size_t size;
+    char data[1];
+};
+
+/* Key being looked up */
+struct hg_hash_map_key_desc {
+    hg_util_uint64_t hash;
+    hg_util_uint64_t word;      /* Integer key or pointer to key copy */
+    const void *data;           /* Byte-string key */
+    size_t size;                /* Byte-string key size */
+};
+
+/* Hash and key are written once before the slot becomes FULL, they are
+ * atomic only because recycled tables are reset under concurrent lookups */
+struct hg_hash_map_slot {
+    hg_atomic_int32_t state;
+    hg_atomic_int64_t hash;
+    hg_atomic_int64_t key;
+    hg_atomic_int64_t value;
+};
+
+struct hg_hash_map_table {
+    struct hg_hash_map_retired retired; /* Must remain first */
+    unsigned int size;
+    unsigned int mask;
+    unsigned int pool_index;            /* Size class */
+    hg_atomic_int32_t used;             /* Slots no longer EMPTY */
+    hg_atomic_int32_t migrate_next;     /* Next slot to migrate */
+    hg_atomic_int32_t migrate_done;     /* Number of slots migrated */
+    struct hg_hash_map_slot slots[1];
+};
+
+struct hg_hash_map {
+    hg_atomic_int64_t table;            /* Current table */
+    hg_atomic_int64_t old_table;        /* Table being migrated */
+    hg_atomic_int32_t count;            /* Number of keys */
+    hg_atomic_int32_t gen;              /* Incremented when reusing table */
+    hg_atomic_int32_t epoch;            /* Reclamation epoch */
+    hg_atomic_int32_t active[2];        /* Threads in even/odd epoch */
+    struct hg_hash_map_retired *retired[2]; /* Retired in even/odd epoch */
+    struct hg_hash_map_retired *deferred;   /* Keys still in old table */
+    struct hg_hash_map_retired *pool[HG_HASH_MAP_POOL_COUNT]; /* Tables */
+    hg_thread_mutex_t retire_mutex;     /* Protects retired lists and pool */
+    hg_thread_mutex_t resize_mutex;     /* Serializes resizes */
+    hg_util_bool_t bytes;               /* Byte-string keys */
+    hg_thread_spin_t locks[HG_HASH_MAP_LOCK_COUNT]; /* Update locks */
+};
+
+/********************/
+/* Local Prototypes */
+/********************/
+
+/**
+ * Create a new map.
+ */
+static struct hg_hash_map *
+hg_hash_map_new(hg_util_bool_t bytes);
+
+/**
+ * Allocate a table of size slots, reusing a retired table if possible.
+ */
+static struct hg_hash_map_table *
+hg_hash_map_table_alloc(struct hg_hash_map *map, unsigned int size);
+
+/**
+ * Free keys and values of a table and the table itself.
+ */
+static void
+hg_hash_map_table_free(struct hg_hash_map *map,
+    struct hg_hash_map_table *table, hg_hash_map_value_free_t value_free);
+
+/**
+ * Hash an integer key.
+ */
+static HG_UTIL_INLINE hg_util_uint64_t
+hg_hash_map_hash_int(hg_util_uint64_t key);
+
+/**
+ * Hash a byte-string key.
+ */
+static HG_UTIL_INLINE hg_util_uint64_t
+hg_hash_map_hash_bytes(const void *key, size_t key_size);
+
+/**
+ * Compare the key of a FULL or MOVED slot.
+ */
+static HG_UTIL_INLINE hg_util_bool_t
+hg_hash_map_key_match(const struct hg_hash_map *map,
+    struct hg_hash_map_slot *slot,
+    const struct hg_hash_map_key_desc *desc);
+
+/**
+ * Enter a reclamation epoch, objects retired from now on are not freed
+ * until hg_hash_map_leave() is called.
+ */
+static HG_UTIL_INLINE hg_util_int32_t
+hg_hash_map_enter(struct hg_hash_map *map);
+
+/**
+ * Leave reclamation epoch.
+ */
+static HG_UTIL_INLINE void
+hg_hash_map_leave(struct hg_hash_map *map, hg_util_int32_t epoch);
+
+/**
+ * Retire an object that is no longer reachable.
+ */
+static void
+hg_hash_map_retire(struct hg_hash_map *map, struct hg_hash_map_retired *obj);
+
+/**
+ * Retire a removed key that may still be referenced by the old table.
+ */
+static void
+hg_hash_map_retire_key(struct hg_hash_map *map,
+    struct hg_hash_map_table *old_table, struct hg_hash_map_key *key);
+
+/**
+ * Release the objects retired two epochs ago if no thread is still in them,
+ * must be called with the retire mutex held.
+ */
+static void
+hg_hash_map_advance(struct hg_hash_map *map);
+
+/**
+ * Look up key in table without locking.
+ */
+static int
+hg_hash_map_probe(const struct hg_hash_map *map,
+    struct hg_hash_map_table *table, const struct hg_hash_map_key_desc *desc,
+    void **value);
+
+/**
+ * Look up key in table and optionally claim an empty slot for it if not
+ * found, must be called with the key lock held.
+ */
+static int
+hg_hash_map_find_locked(const struct hg_hash_map *map,
+    struct hg_hash_map_table *table, const struct hg_hash_map_key_desc *desc,
+    hg_util_bool_t claim, struct hg_hash_map_slot **slot_ptr);
+
+/**
+ * Copy a FULL slot into the new table and mark it MOVED, must be called with
+ * the key lock held.
+ */
+static int
+hg_hash_map_copy_slot(const struct hg_hash_map *map,
+    struct hg_hash_map_slot *slot, struct hg_hash_map_table *table);
+
+/**
+ * Migrate key from the old table, must be called with the key lock held.
+ */
+static int
+hg_hash_map_migrate_key(const struct hg_hash_map *map,
+    struct hg_hash_map_table *old_table, struct hg_hash_map_table *table,
+    const struct hg_hash_map_key_desc *desc);
+
+/**
+ * Migrate one slot of the old table.
+ */
+static int
+hg_hash_map_migrate_slot(struct hg_hash_map *map,
+    struct hg_hash_map_table *old_table, struct hg_hash_map_table *table,
+    unsigned int index);
+
+/**
+ * Migrate the next chunk of the old table if a resize is in progress.
+ */
+static hg_util_bool_t
+hg_hash_map_help_migrate(struct hg_hash_map *map);
+
+/**
+ * Wait until the old table is fully migrated.
+ */
+static void
+hg_hash_map_finish_migrate(struct hg_hash_map *map);
+
+/**
+ * Start resizing the map if the table is more than half used, completing the
+ * previous resize first if needed.
+ */
+static int
+hg_hash_map_resize(struct hg_hash_map *map);
+
+/**
+ * Insert key.
+ */
+static int
+hg_hash_map_insert(struct hg_hash_map *map,
+    const struct hg_hash_map_key_desc *desc, void *value, void **cur_value);
+
+/**
+ * Look up key.
+ */
+static int
+hg_hash_map_lookup(struct hg_hash_map *map,
+    const struct hg_hash_map_key_desc *desc, void **value);
+
+/**
+ * Remove key.
+ */
+static int
+hg_hash_map_remove(struct hg_hash_map *map,
+    const struct hg_hash_map_key_desc *desc, void **value);
+
+/*---------------------------------------------------------------------------*/
+static struct hg_hash_map *
+hg_hash_map_new(hg_util_bool_t bytes)
+{
+    struct hg_hash_map *map = NULL;
+    struct hg_hash_map_table *table = NULL;
+    unsigned int i;
+
+    map = (struct hg_hash_map *) malloc(sizeof(struct hg_hash_map));
+    if (!map) {
+        HG_UTIL_LOG_ERROR("Could not allocate hash map");
+        goto error;
+    }
+    memset(map, 0, sizeof(struct hg_hash_map));
+    map->bytes = bytes;
+    hg_atomic_init64(&map->old_table, 0);
+    hg_atomic_init32(&map->count, 0);
+    hg_atomic_init32(&map->gen, 0);
+    hg_atomic_init32(&map->epoch, 0);
+    hg_atomic_init32(&map->active[0], 0);
+    hg_atomic_init32(&map->active[1], 0);
+
+    hg_thread_mutex_init(&map->retire_mutex);
+    hg_thread_mutex_init(&map->resize_mutex);
+    for (i = 0; i < HG_HASH_MAP_LOCK_COUNT; i++)
+        hg_thread_spin_init(&map->locks[i]);
+
+    table = hg_hash_map_table_alloc(map, HG_HASH_MAP_MIN_SIZE);
+    if (!table) {
+        HG_UTIL_LOG_ERROR("Could not allocate hash map table");
+        goto error;
+    }
+    hg_atomic_init64(&map->table, HG_HASH_MAP_TO_INT(table));
+
+    return map;
+
+error:
+    if (map) {
+        for (i = 0; i < HG_HASH_MAP_LOCK_COUNT; i++)
+            hg_thread_spin_destroy(&map->locks[i]);
+        hg_thread_mutex_destroy(&map->resize_mutex);
+        hg_thread_mutex_destroy(&map->retire_mutex);
+        free(map);
+    }
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+static struct hg_hash_map_table *
+hg_hash_map_table_alloc(struct hg_hash_map *map, unsigned int size)
+{
+    struct hg_hash_map_table *table = NULL;
+    unsigned int pool_index = 0, i;
+
+    while ((1U << pool_index) < size)
+        pool_index++;
+
+    hg_thread_mutex_lock(&map->retire_mutex);
+    /* Tables retired by the previous resize may be ready for reuse */
+    hg_hash_map_advance(map);
+    hg_hash_map_advance(map);
+    if (map->pool[pool_index]) {
+        table = (struct hg_hash_map_table *) map->pool[pool_index];
+        map->pool[pool_index] = table->retired.next;
+    }
+    hg_thread_mutex_unlock(&map->retire_mutex);
+
+    if (table) {
+        /* Lookups that may still be reading that table must retry */
+        hg_atomic_incr32(&map->gen);
+    } else {
+        table = (struct hg_hash_map_table *) malloc(
+            sizeof(struct hg_hash_map_table)
+            + (size - 1) * sizeof(struct hg_hash_map_slot));
+        if (!table)
+            return NULL;
+        table->retired.is_table = HG_UTIL_TRUE;
+        table->size = size;
+        table->mask = size - 1;
+        table->pool_index = pool_index;
+    }
+
+    table->retired.next = NULL;
+    hg_atomic_init32(&table->used, 0);
+    hg_atomic_init32(&table->migrate_next, 0);
+    hg_atomic_init32(&table->migrate_done, 0);
+    for (i = 0; i < size; i++) {
+        hg_atomic_set32(&table->slots[i].state, HG_HASH_MAP_EMPTY);
+        hg_atomic_set64(&table->slots[i].hash, 0);
+        hg_atomic_set64(&table->slots[i].key, 0);
+        hg_atomic_set64(&table->slots[i].value, 0);
+    }
+
+    return table;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+hg_hash_map_table_free(struct hg_hash_map *map,
+    struct hg_hash_map_table *table, hg_hash_map_value_free_t value_free)
+{
+    unsigned int i;
+
+    for (i = 0; i < table->size; i++) {
+        struct hg_hash_map_slot *slot = &table->slots[i];
+
+        /* MOVED keys belong to the new table, DELETED keys were retired */
+        if (hg_atomic_get32(&slot->state) != HG_HASH_MAP_FULL)
+            continue;
+        if (value_free)
+            value_free(HG_HASH_MAP_TO_PTR(hg_atomic_get64(&slot->value)));
+        if (map->bytes)
+            free(HG_HASH_MAP_TO_PTR(hg_atomic_get64(&slot->key)));
+    }
+    free(table);
+}
+
+/*---------------------------------------------------------------------------*/
+static HG_UTIL_INLINE hg_util_uint64_t
+hg_hash_map_hash_int(hg_util_uint64_t key)
+{
+    /* 64-bit finalizer from MurmurHash3 */
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+
+    return key;
+}
+
+/*---------------------------------------------------------------------------*/
+static HG_UTIL_INLINE hg_util_uint64_t
+hg_hash_map_hash_bytes(const void *key, size_t key_size)
+{
+    /* 64-bit FNV-1a */
+    const unsigned char *p = (const unsigned char *) key;
+    hg_util_uint64_t hash = 0xcbf29ce484222325ULL;
+    size_t i;
+
+    for (i = 0; i < key_size; i++) {
+        hash ^= p[i];
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hg_hash_map_hash_int(hash);
+}
+
+/*---------------------------------------------------------------------------*/
+static HG_UTIL_INLINE hg_util_bool_t
+hg_hash_map_key_match(const struct hg_hash_map *map,
+    struct hg_hash_map_slot *slot,
+    const struct hg_hash_map_key_desc *desc)
+{
+    const struct hg_hash_map_key *key;
+
+    if ((hg_util_uint64_t) hg_atomic_get64(&slot->hash) != desc->hash)
+        return HG_UTIL_FALSE;
+    if (!map->bytes)
+        return (hg_util_bool_t) (
+            (hg_util_uint64_t) hg_atomic_get64(&slot->key) == desc->word);
+
+    key = (const struct hg_hash_map_key *) HG_HASH_MAP_TO_PTR(
+        hg_atomic_get64(&slot->key));
+    return (hg_util_bool_t) (key && key->size == desc->size
+        && memcmp(key->data, desc->data, desc->size) == 0);
+}
+
+/*---------------------------------------------------------------------------*/
+static HG_UTIL_INLINE hg_util_int32_t
+hg_hash_map_enter(struct hg_hash_map *map)
+{
+    hg_util_int32_t epoch;
+
+    for (;;) {
+        epoch = hg_atomic_get32(&map->epoch);
+        hg_atomic_incr32(&map->active[epoch & 1]);
+        hg_atomic_fence();
+        /* Epoch may have advanced before we were accounted for */
+        if (hg_atomic_get32(&map->epoch) == epoch)
+            break;
+        hg_atomic_decr32(&map->active[epoch & 1]);
+    }
+
+    return epoch;
+}
+
+/*---------------------------------------------------------------------------*/
+static HG_UTIL_INLINE void
+hg_hash_map_leave(struct hg_hash_map *map, hg_util_int32_t epoch)
+{
+    hg_atomic_decr32(&map->active[epoch & 1]);
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+hg_hash_map_retire(struct hg_hash_map *map, struct hg_hash_map_retired *obj)
+{
+    hg_util_int32_t epoch;
+
+    hg_thread_mutex_lock(&map->retire_mutex);
+    epoch = hg_atomic_get32(&map->epoch);
+    obj->next = map->retired[epoch & 1];
+    map->retired[epoch & 1] = obj;
+    hg_hash_map_advance(map);
+    hg_thread_mutex_unlock(&map->retire_mutex);
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+hg_hash_map_retire_key(struct hg_hash_map *map,
+    struct hg_hash_map_table *old_table, struct hg_hash_map_key *key)
+{
+    /* A MOVED slot of the old table may still point to the key, keep it
+     * until the old table itself is retired */
+    hg_thread_mutex_lock(&map->retire_mutex);
+    if (old_table
+        && hg_atomic_get64(&map->old_table) == HG_HASH_MAP_TO_INT(old_table)) {
+        key->retired.next = map->deferred;
+        map->deferred = &key->retired;
+        hg_thread_mutex_unlock(&map->retire_mutex);
+        return;
+    }
+    hg_thread_mutex_unlock(&map->retire_mutex);
+
+    hg_hash_map_retire(map, &key->retired);
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+hg_hash_map_advance(struct hg_hash_map *map)
+{
+    hg_util_int32_t epoch = hg_atomic_get32(&map->epoch);
+    struct hg_hash_map_retired *obj;
+
+    /* Pairs with the fence in hg_hash_map_enter() */
+    hg_atomic_fence();
+    if (hg_atomic_get32(&map->active[(epoch + 1) & 1]) != 0)
+        return;
+
+    /* Nobody is left in the previous epoch, anything retired during it can no
+     * longer be reached by writers */
+    obj = map->retired[(epoch + 1) & 1];
+    while (obj) {
+        struct hg_hash_map_retired *next = obj->next;
+
+        if (obj->is_table) {
+            unsigned int pool_index =
+                ((struct hg_hash_map_table *) obj)->pool_index;
+
+            obj->next = map->pool[pool_index];
+            map->pool[pool_index] = obj;
+        } else
+            free(obj);
+        obj = next;
+    }
+    map->retired[(epoch + 1) & 1] = NULL;
+
+    hg_atomic_set32(&map->epoch, epoch + 1);
+    hg_atomic_fence();
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+hg_hash_map_probe(const struct hg_hash_map *map,
+    struct hg_hash_map_table *table, const struct hg_hash_map_key_desc *desc,
+    void **value)
+{
+    unsigned int index = (unsigned int) desc->hash & table->mask;
+    unsigned int i;
+
+    for (i = 0; i < table->size; i++, index = (index + 1) & table->mask) {
+        struct hg_hash_map_slot *slot = &table->slots[index];
+
+        switch (hg_atomic_get32(&slot->state)) {
+            case HG_HASH_MAP_EMPTY:
+            case HG_HASH_MAP_CLOSED:
+                return HG_HASH_MAP_NOT_FOUND;
+            case HG_HASH_MAP_FULL:
+                if (hg_hash_map_key_match(map, slot, desc)) {
+                    *value = HG_HASH_MAP_TO_PTR(
+                        hg_atomic_get64(&slot->value));
+                    return HG_HASH_MAP_FOUND;
+                }
+                break;
+            case HG_HASH_MAP_MOVED:
+                if (hg_hash_map_key_match(map, slot, desc))
+                    return HG_HASH_MAP_RETRY;
+                break;
+            default:
+                /* BUSY slots are not visible yet, DELETED slots may be
+                 * followed by a new copy of the key */
+                break;
+        }
+    }
+
+    return HG_HASH_MAP_NOT_FOUND;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+hg_hash_map_find_locked(const struct hg_hash_map *map,
+    struct hg_hash_map_table *table, const struct hg_hash_map_key_desc *desc,
+    hg_util_bool_t claim, struct hg_hash_map_slot **slot_ptr)
+{
+    unsigned int index = (unsigned int) desc->hash & table->mask;
+    unsigned int i;
+
+    *slot_ptr = NULL;
+    for (i = 0; i < table->size; i++, index = (index + 1) & table->mask) {
+        struct hg_hash_map_slot *slot = &table->slots[index];
+        hg_util_int32_t state = hg_atomic_get32(&slot->state);
+
+        /* Other keys may be claiming slots concurrently */
+        while (state == HG_HASH_MAP_EMPTY) {
+            if (!claim)
+                return HG_HASH_MAP_NOT_FOUND;
+            if (hg_atomic_cas32(&slot->state, HG_HASH_MAP_EMPTY,
+                HG_HASH_MAP_BUSY)) {
+                hg_atomic_incr32(&table->used);
+                *slot_ptr = slot;
+                return HG_HASH_MAP_NOT_FOUND;
+            }
+            state = hg_atomic_get32(&slot->state);
+        }
+
+        switch (state) {
+            case HG_HASH_MAP_CLOSED:
+                /* Table is being migrated */
+                return claim ? HG_HASH_MAP_RETRY : HG_HASH_MAP_NOT_FOUND;
+            case HG_HASH_MAP_FULL:
+                if (hg_hash_map_key_match(map, slot, desc)) {
+                    *slot_ptr = slot;
+                    return HG_HASH_MAP_FOUND;
+                }
+                break;
+            case HG_HASH_MAP_MOVED:
+                if (hg_hash_map_key_match(map, slot, desc))
+                    return HG_HASH_MAP_RETRY;
+                break;
+            default:
+                break;
+        }
+    }
+
+    return HG_HASH_MAP_NOT_FOUND;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+hg_hash_map_copy_slot(const struct hg_hash_map *map,
+    struct hg_hash_map_slot *slot, struct hg_hash_map_table *table)
+{
+    struct hg_hash_map_key_desc desc;
+    struct hg_hash_map_slot *new_slot;
+
+    desc.hash = (hg_util_uint64_t) hg_atomic_get64(&slot->hash);
+    desc.word = (hg_util_uint64_t) hg_atomic_get64(&slot->key);
+    if (map->bytes) {
+        const struct hg_hash_map_key *key =
+            (const struct hg_hash_map_key *) HG_HASH_MAP_TO_PTR(desc.word);
+        desc.data = key->data;
+        desc.size = key->size;
+    } else {
+        desc.data = NULL;
+        desc.size = 0;
+    }
+
+    hg_hash_map_find_locked(map, table, &desc, HG_UTIL_TRUE, &new_slot);
+    if (!new_slot)
+        return HG_UTIL_FAIL;
+
+    hg_atomic_set64(&new_slot->hash, hg_atomic_get64(&slot->hash));
+    hg_atomic_set64(&new_slot->key, hg_atomic_get64(&slot->key));
+    hg_atomic_set64(&new_slot->value, hg_atomic_get64(&slot->value));
+    hg_atomic_set32(&new_slot->state, HG_HASH_MAP_FULL);
+    hg_atomic_set32(&slot->state, HG_HASH_MAP_MOVED);
+
+    return HG_UTIL_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+hg_hash_map_migrate_key(const struct hg_hash_map *map,
+    struct hg_hash_map_table *old_table, struct hg_hash_map_table *table,
+    const struct hg_hash_map_key_desc *desc)
+{
+    struct hg_hash_map_slot *slot;
+
+    if (hg_hash_map_find_locked(map, old_table, desc, HG_UTIL_FALSE, &slot)
+        != HG_HASH_MAP_FOUND)
+        return HG_UTIL_SUCCESS;
+
+    return hg_hash_map_copy_slot(map, slot, table);
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+hg_hash_map_migrate_slot(struct hg_hash_map *map,
+    struct hg_hash_map_table *old_table, struct hg_hash_map_table *table,
+    unsigned int index)
+{
+    struct hg_hash_map_slot *slot = &old_table->slots[index];
+    int ret = HG_UTIL_SUCCESS;
+
+    for (;;) {
+        hg_util_int32_t state = hg_atomic_get32(&slot->state);
+        hg_thread_spin_t *lock;
+
+        switch (state) {
+            case HG_HASH_MAP_EMPTY:
+                /* Prevent further claims of that slot */
+                if (hg_atomic_cas32(&slot->state, HG_HASH_MAP_EMPTY,
+                    HG_HASH_MAP_CLOSED))
+                    return ret;
+                break;
+            case HG_HASH_MAP_BUSY:
+                /* Slot is being filled by a concurrent insert */
+                cpu_spinwait();
+                break;
+            case HG_HASH_MAP_FULL:
+                lock = HG_HASH_MAP_LOCK(map,
+                    (hg_util_uint64_t) hg_atomic_get64(&slot->hash));
+                hg_thread_spin_lock(lock);
+                if (hg_atomic_get32(&slot->state) == HG_HASH_MAP_FULL) {
+                    ret = hg_hash_map_copy_slot(map, slot, table);
+                    hg_thread_spin_unlock(lock);
+                    if (ret != HG_UTIL_SUCCESS)
+                        HG_UTIL_LOG_ERROR("Could not migrate key, new table "
+                            "is full");
+                    return ret;
+                }
+                hg_thread_spin_unlock(lock);
+                break;
+            default:
+                return ret;
+        }
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+static hg_util_bool_t
+hg_hash_map_help_migrate(struct hg_hash_map *map)
+{
+    struct hg_hash_map_table *table, *old_table;
+    hg_util_int32_t start, end, done;
+    hg_util_int32_t i;
+
+    table = (struct hg_hash_map_table *) HG_HASH_MAP_TO_PTR(
+        hg_atomic_get64(&map->table));
+    old_table = (struct hg_hash_map_table *) HG_HASH_MAP_TO_PTR(
+        hg_atomic_get64(&map->old_table));
+    if (!old_table || old_table == table)
+        return HG_UTIL_FALSE;
+
+    /* Claim next chunk */
+    do {
+        start = hg_atomic_get32(&old_table->migrate_next);
+        if (start >= (hg_util_int32_t) old_table->size)
+            return HG_UTIL_FALSE;
+        end = start + HG_HASH_MAP_MIGRATE_CHUNK;
+        if (end > (hg_util_int32_t) old_table->size)
+            end = (hg_util_int32_t) old_table->size;
+    } while (!hg_atomic_cas32(&old_table->migrate_next, start, end));
+
+    for (i = start; i < end; i++)
+        hg_hash_map_migrate_slot(map, old_table, table, (unsigned int) i);
+
+    do {
+        done = hg_atomic_get32(&old_table->migrate_done);
+    } while (!hg_atomic_cas32(&old_table->migrate_done, done,
+        done + end - start));
+
+    /* Last chunk retires the old table along with the keys that were removed
+     * while it could still reference them */
+    if (done + end - start == (hg_util_int32_t) old_table->size) {
+        struct hg_hash_map_retired *deferred;
+
+        hg_thread_mutex_lock(&map->retire_mutex);
+        hg_atomic_set64(&map->old_table, 0);
+        deferred = map->deferred;
+        map->deferred = NULL;
+        hg_thread_mutex_unlock(&map->retire_mutex);
+
+        hg_hash_map_retire(map, &old_table->retired);
+        while (deferred) {
+            struct hg_hash_map_retired *next = deferred->next;
+            hg_hash_map_retire(map, deferred);
+            deferred = next;
+        }
+    }
+
+    return HG_UTIL_TRUE;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+hg_hash_map_finish_migrate(struct hg_hash_map *map)
+{
+    while (hg_atomic_get64(&map->old_table) != 0) {
+        hg_util_int32_t epoch = hg_hash_map_enter(map);
+        hg_util_bool_t progress = hg_hash_map_help_migrate(map);
+
+        hg_hash_map_leave(map, epoch);
+        /* Remaining chunks are being migrated by other threads */
+        if (!progress)
+            hg_thread_yield();
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+hg_hash_map_resize(struct hg_hash_map *map)
+{
+    struct hg_hash_map_table *table, *new_table;
+    unsigned int count, new_size;
+    int ret = HG_UTIL_SUCCESS;
+
+    /* New table is already half used, the keys left in the old table must
+     * be moved before it can be replaced */
+    if (hg_atomic_get64(&map->old_table) != 0)
+        hg_hash_map_finish_migrate(map);
+
+    if (hg_thread_mutex_try_lock(&map->resize_mutex) != HG_UTIL_SUCCESS)
+        return ret;
+
+    table = (struct hg_hash_map_table *) HG_HASH_MAP_TO_PTR(
+        hg_atomic_get64(&map->table));
+    if (hg_atomic_get64(&map->old_table) != 0
+        || (unsigned int) hg_atomic_get32(&table->used) * 2 <= table->size)
+        goto done;
+
+    /* Leave room for the keys inserted while the old table is migrated, the
+     * table is not shrunk but DELETED slots are dropped */
+    count = (unsigned int) hg_atomic_get32(&map->count);
+    new_size = table->size;
+    while (new_size < 4 * (count + 1))
+        new_size <<= 1;
+
+    new_table = hg_hash_map_table_alloc(map, new_size);
+    if (!new_table) {
+        HG_UTIL_LOG_ERROR("Could not allocate hash map table");
+        ret = HG_UTIL_FAIL;
+        goto done;
+    }
+
+    /* Old table must be visible before lookups can miss in the new one */
+    hg_atomic_set64(&map->old_table, HG_HASH_MAP_TO_INT(table));
+    hg_atomic_set64(&map->table, HG_HASH_MAP_TO_INT(new_table));
+
+done:
+    hg_thread_mutex_unlock(&map->resize_mutex);
+
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+hg_hash_map_insert(struct hg_hash_map *map,
+    const struct hg_hash_map_key_desc *desc, void *value, void **cur_value)
+{
+    struct hg_hash_map_table *table, *old_table;
+    struct hg_hash_map_slot *slot = NULL;
+    struct hg_hash_map_key *key = NULL;
+    hg_thread_spin_t *lock = HG_HASH_MAP_LOCK(map, desc->hash);
+    hg_util_int32_t epoch;
+    hg_util_bool_t inserted = HG_UTIL_FALSE, resize = HG_UTIL_FALSE,
+        full = HG_UTIL_FALSE;
+    int ret = HG_UTIL_SUCCESS, rc;
+
+    if (map->bytes) {
+        key = (struct hg_hash_map_key *) malloc(
+            sizeof(struct hg_hash_map_key) + desc->size);
+        if (!key) {
+            HG_UTIL_LOG_ERROR("Could not allocate key");
+            return HG_UTIL_FAIL;
+        }
+        key->retired.is_table = HG_UTIL_FALSE;
+        key->size = desc->size;
+        memcpy(key->data, desc->data, desc->size);
+    }
+
+retry:
+    epoch = hg_hash_map_enter(map);
+    hg_hash_map_help_migrate(map);
+
+    hg_thread_spin_lock(lock);
+    do {
+        table = (struct hg_hash_map_table *) HG_HASH_MAP_TO_PTR(
+            hg_atomic_get64(&map->table));
+        old_table = (struct hg_hash_map_table *) HG_HASH_MAP_TO_PTR(
+            hg_atomic_get64(&map->old_table));
+        if (old_table && old_table != table
+            && hg_hash_map_migrate_key(map, old_table, table, desc)
+            != HG_UTIL_SUCCESS) {
+            full = HG_UTIL_TRUE;
+            goto unlock;
+        }
+        rc = hg_hash_map_find_locked(map, table, desc, HG_UTIL_TRUE, &slot);
+    } while (rc == HG_HASH_MAP_RETRY);
+
+    if (rc == HG_HASH_MAP_FOUND) {
+        if (cur_value)
+            *cur_value = HG_HASH_MAP_TO_PTR(hg_atomic_get64(&slot->value));
+    } else if (slot) {
+        hg_atomic_set64(&slot->hash, (hg_util_int64_t) desc->hash);
+        hg_atomic_set64(&slot->key, (map->bytes) ? HG_HASH_MAP_TO_INT(key)
+            : (hg_util_int64_t) desc->word);
+        hg_atomic_set64(&slot->value, HG_HASH_MAP_TO_INT(value));
+        hg_atomic_set32(&slot->state, HG_HASH_MAP_FULL);
+        hg_atomic_incr32(&map->count);
+        if (cur_value)
+            *cur_value = value;
+        inserted = HG_UTIL_TRUE;
+        key = NULL;
+    } else
+        full = HG_UTIL_TRUE;
+
+unlock:
+    hg_thread_spin_unlock(lock);
+
+    if (full || (inserted
+        && (unsigned int) hg_atomic_get32(&table->used) * 2 > table->size))
+        resize = HG_UTIL_TRUE;
+
+    hg_hash_map_leave(map, epoch);
+
+    /* Resize once out of the epoch so that previously retired tables can be
+     * reused */
+    if (resize && hg_hash_map_resize(map) != HG_UTIL_SUCCESS && full)
+        ret = HG_UTIL_FAIL;
+    else if (full) {
+        /* Table filled up before the last resize completed */
+        full = HG_UTIL_FALSE;
+        resize = HG_UTIL_FALSE;
+        goto retry;
+    }
+    free(key);
+
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+hg_hash_map_lookup(struct hg_hash_map *map,
+    const struct hg_hash_map_key_desc *desc, void **value)
+{
+    struct hg_hash_map_table *table, *old_table;
+    hg_util_int32_t epoch = 0, gen;
+    void *found_value = NULL;
+    int rc;
+
+    /* Integer lookups do not dereference anything but the tables, which are
+     * recycled but never freed while the map exists, so that it is enough to
+     * retry if a table was reused while reading it. Byte-string keys must be
+     * protected from being freed. */
+    if (map->bytes)
+        epoch = hg_hash_map_enter(map);
+    do {
+        gen = hg_atomic_get32(&map->gen);
+        /* Table must be read first, see hg_hash_map_resize() */
+        table = (struct hg_hash_map_table *) HG_HASH_MAP_TO_PTR(
+            hg_atomic_get64(&map->table));
+        old_table = (struct hg_hash_map_table *) HG_HASH_MAP_TO_PTR(
+            hg_atomic_get64(&map->old_table));
+        rc = hg_hash_map_probe(map, table, desc, &found_value);
+        if (rc == HG_HASH_MAP_NOT_FOUND && old_table && old_table != table)
+            rc = hg_hash_map_probe(map, old_table, desc, &found_value);
+    } while (rc == HG_HASH_MAP_RETRY || hg_atomic_get32(&map->gen) != gen);
+    if (map->bytes)
+        hg_hash_map_leave(map, epoch);
+
+    if (rc != HG_HASH_MAP_FOUND)
+        return HG_UTIL_FAIL;
+
+    if (value)
+        *value = found_value;
+
+    return HG_UTIL_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+hg_hash_map_remove(struct hg_hash_map *map,
+    const struct hg_hash_map_key_desc *desc, void **value)
+{
+    struct hg_hash_map_table *table, *old_table;
+    struct hg_hash_map_slot *slot = NULL;
+    struct hg_hash_map_key *key = NULL;
+    hg_thread_spin_t *lock = HG_HASH_MAP_LOCK(map, desc->hash);
+    hg_util_int32_t epoch;
+    int ret = HG_UTIL_FAIL, rc;
+
+    epoch = hg_hash_map_enter(map);
+    hg_hash_map_help_migrate(map);
+
+    hg_thread_spin_lock(lock);
+    do {
+        table = (struct hg_hash_map_table *) HG_HASH_MAP_TO_PTR(
+            hg_atomic_get64(&map->table));
+        old_table = (struct hg_hash_map_table *) HG_HASH_MAP_TO_PTR(
+            hg_atomic_get64(&map->old_table));
+        if (old_table == table)
+            old_table = NULL;
+        if (old_table
+            && hg_hash_map_migrate_key(map, old_table, table, desc)
+            != HG_UTIL_SUCCESS)
+            goto unlock;
+        rc = hg_hash_map_find_locked(map, table, desc, HG_UTIL_FALSE, &slot);
+    } while (rc == HG_HASH_MAP_RETRY);
+
+    if (rc == HG_HASH_MAP_FOUND) {
+        if (value)
+            *value = HG_HASH_MAP_TO_PTR(hg_atomic_get64(&slot->value));
+        hg_atomic_set32(&slot->state, HG_HASH_MAP_DELETED);
+        hg_atomic_decr32(&map->count);
+        if (map->bytes)
+            key = (struct hg_hash_map_key *) HG_HASH_MAP_TO_PTR(
+                hg_atomic_get64(&slot->key));
+        ret = HG_UTIL_SUCCESS;
+    }
+
+unlock:
+    hg_thread_spin_unlock(lock);
+
+    /* Concurrent lookups may still be comparing the key */
+    if (key)
+        hg_hash_map_retire_key(map, old_table, key);
+
+    hg_hash_map_leave(map, epoch);
+
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+hg_hash_map_t *
+hg_hash_map_new_int(void)
+{
+    return hg_hash_map_new(HG_UTIL_FALSE);
+}
+
+/*---------------------------------------------------------------------------*/
+hg_hash_map_t *
+hg_hash_map_new_bytes(void)
+{
+    return hg_hash_map_new(HG_UTIL_TRUE);
+}
+
+/*---------------------------------------------------------------------------*/
+void
+hg_hash_map_free(hg_hash_map_t *map, hg_hash_map_value_free_t value_free)
+{
+    struct hg_hash_map_table *table, *old_table;
+    struct hg_hash_map_retired *lists[3 + HG_HASH_MAP_POOL_COUNT];
+    unsigned int i;
+
+    if (!map)
+        return;
+
+    table = (struct hg_hash_map_table *) HG_HASH_MAP_TO_PTR(
+        hg_atomic_get64(&map->table));
+    old_table = (struct hg_hash_map_table *) HG_HASH_MAP_TO_PTR(
+        hg_atomic_get64(&map->old_table));
+    if (old_table && old_table != table)
+        hg_hash_map_table_free(map, old_table, value_free);
+    hg_hash_map_table_free(map, table, value_free);
+
+    lists[0] = map->retired[0];
+    lists[1] = map->retired[1];
+    lists[2] = map->deferred;
+    for (i = 0; i < HG_HASH_MAP_POOL_COUNT; i++)
+        lists[3 + i] = map->pool[i];
+    for (i = 0; i < 3 + HG_HASH_MAP_POOL_COUNT; i++) {
+        struct hg_hash_map_retired *obj = lists[i];
+
+        while (obj) {
+            struct hg_hash_map_retired *next = obj->next;
+            free(obj);
+            obj = next;
+        }
+    }
+
+    for (i = 0; i < HG_HASH_MAP_LOCK_COUNT; i++)
+        hg_thread_spin_destroy(&map->locks[i]);
+    hg_thread_mutex_destroy(&map->resize_mutex);
+    hg_thread_mutex_destroy(&map->retire_mutex);
+    free(map);
+}
+
+/*---------------------------------------------------------------------------*/
+int
+hg_hash_map_insert_int(hg_hash_map_t *map, hg_util_uint64_t key, void *value,
+    void **cur_value)
+{
+    struct hg_hash_map_key_desc desc;
+
+    desc.hash = hg_hash_map_hash_int(key);
+    desc.word = key;
+    desc.data = NULL;
+    desc.size = 0;
+
+    return hg_hash_map_insert(map, &desc, value, cur_value);
+}
+
+/*---------------------------------------------------------------------------*/
+int
+hg_hash_map_lookup_int(hg_hash_map_t *map, hg_util_uint64_t key,
+    void **value)
+{
+    struct hg_hash_map_key_desc desc;
+
+    desc.hash = hg_hash_map_hash_int(key);
+    desc.word = key;
+    desc.data = NULL;
+    desc.size = 0;
+
+    return hg_hash_map_lookup(map, &desc, value);
+}
+
+/*---------------------------------------------------------------------------*/
+int
+hg_hash_map_remove_int(hg_hash_map_t *map, hg_util_uint64_t key,
+    void **value)
+{
+    struct hg_hash_map_key_desc desc;
+
+    desc.hash = hg_hash_map_hash_int(key);
+    desc.word = key;
+    desc.data = NULL;
+    desc.size = 0;
+
+    return hg_hash_map_remove(map, &desc, value);
+}
+
+/*---------------------------------------------------------------------------*/
+int
+hg_hash_map_insert_bytes(hg_hash_map_t *map, const void *key,
+    size_t key_size, void *value, void **cur_value)
+{
+    struct hg_hash_map_key_desc desc;
+
+    desc.hash = hg_hash_map_hash_bytes(key, key_size);
+    desc.word = 0;
+    desc.data = key;
+    desc.size = key_size;
+
+    return hg_hash_map_insert(map, &desc, value, cur_value);
+}
+
+/*---------------------------------------------------------------------------*/
+int
+hg_hash_map_lookup_bytes(hg_hash_map_t *map, const void *key,
+    size_t key_size, void **value)
+{
+    struct hg_hash_map_key_desc desc;
+
+    desc.hash = hg_hash_map_hash_bytes(key, key_size);
+    desc.word = 0;
+    desc.data = key;
+    desc.size = key_size;
+
+    return hg_hash_map_lookup(map, &desc, value);
+}
+
+/*---------------------------------------------------------------------------*/
+int
+hg_hash_map_remove_bytes(hg_hash_map_t *map, const void *key,
+    size_t key_size, void **value)
+{
+    struct hg_hash_map_key_desc desc;
+
+    desc.hash = hg_hash_map_hash_bytes(key, key_size);
+    desc.word = 0;
+    desc.data = key;
+    desc.size = key_size;
+
+    return hg_hash_map_remove(map, &desc, value);
+}
+
+/*---------------------------------------------------------------------------*/
+unsigned int
+hg_hash_map_count(hg_hash_map_t *map)
+{
+    return (unsigned int) hg_atomic_get32(&map->count);
+}
@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2013-2019 Argonne National Laboratory, Department of Energy,
+ *                    UChicago Argonne, LLC and The HDF Group.
+ * All rights reserved.
+ *
+ * The full copyright notice, including terms governing use, modification,
+ * and redistribution, is contained in the COPYING file that can be
+ * found at the root of the source code distribution tree.
+ */
+
+/**
+ * \file mercury_hash_map.h
+ *
+ * \brief Concurrent hash map.
+ *
+ * Open-addressing hash map with linear probing that can be accessed
+ * concurrently without external locking. Lookups never take a lock, updates
+ * take one of several spin locks selected from the key hash, and the table
+ * is grown incrementally by the threads that update it, so that no single
+ * operation pays for a full rehash.
+ *
+ * Keys are either 64-bit integers (\ref hg_hash_map_new_int) or byte
+ * strings (\ref hg_hash_map_new_bytes), in which case the map keeps its own
+ * copy of the key. Values are opaque pointers owned by the caller.
+ */
+
+#ifndef MERCURY_HASH_MAP_H
+#define MERCURY_HASH_MAP_H
+
+#include "mercury_util_config.h"
+
+#include <stddef.h>
+
+/*************************************/
+/* Public Type and Struct Definition */
+/*************************************/
+
+typedef struct hg_hash_map hg_hash_map_t;
+
+/* Function used to free values when the map is freed */
+typedef void (*hg_hash_map_value_free_t)(void *value);
+
+/*********************/
+/* Public Prototypes */
+/*********************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Create a new map that uses 64-bit integer keys.
+ *
+ * \return Pointer to new map or NULL on failure
+ */
+HG_UTIL_EXPORT hg_hash_map_t *
+hg_hash_map_new_int(void);
+
+/**
+ * Create a new map that uses byte-string keys.
+ *
+ * \return Pointer to new map or NULL on failure
+ */
+HG_UTIL_EXPORT hg_hash_map_t *
+hg_hash_map_new_bytes(void);
+
+/**
+ * Free a map. No other thread may access the map concurrently.
+ *
+ * \param map [IN/OUT]          pointer to map
+ * \param value_free [IN]       function called on each remaining value
+ *                              (may be NULL)
+ */
+HG_UTIL_EXPORT void
+hg_hash_map_free(hg_hash_map_t *map, hg_hash_map_value_free_t value_free);
+
+/**
+ * Insert a value into an integer map. If the key is already present, the
+ * map is left unchanged.
+ *
+ * \param map [IN/OUT]          pointer to map
+ * \param key [IN]              key
+ * \param value [IN]            value
+ * \param cur_value [OUT]       value now associated to key (may be NULL),
+ *                              different from \value if the key existed
+ *
+ * \return HG_UTIL_SUCCESS or HG_UTIL_FAIL
+ */
+HG_UTIL_EXPORT int
+hg_hash_map_insert_int(hg_hash_map_t *map, hg_util_uint64_t key, void *value,
+    void **cur_value);
+
+/**
+ * Look up a value in an integer map.
+ *
+ * \param map [IN]              pointer to map
+ * \param key [IN]              key
+ * \param value [OUT]           value associated to key (may be NULL)
+ *
+ * \return HG_UTIL_SUCCESS if found or HG_UTIL_FAIL otherwise
+ */
+HG_UTIL_EXPORT int
+hg_hash_map_lookup_int(hg_hash_map_t *map, hg_util_uint64_t key,
+    void **value);
+
+/**
+ * Remove a key from an integer map.
+ *
+ * \param map [IN/OUT]          pointer to map
+ * \param key [IN]              key
+ * \param value [OUT]           value that was associated to key (may be NULL)
+ *
+ * \return HG_UTIL_SUCCESS if removed or HG_UTIL_FAIL if not found
+ */
+HG_UTIL_EXPORT int
+hg_hash_map_remove_int(hg_hash_map_t *map, hg_util_uint64_t key,
+    void **value);
+
+/**
+ * Insert a value into a byte-string map. If the key is already present, the
+ * map is left unchanged. The key is copied.
+ *
+ * \param map [IN/OUT]          pointer to map
+ * \param key [IN]              pointer to key
+ * \param key_size [IN]         key size
+ * \param value [IN]            value
+ * \param cur_value [OUT]       value now associated to key (may be NULL),
+ *                              different from \value if the key existed
+ *
+ * \return HG_UTIL_SUCCESS or HG_UTIL_FAIL
+ */
+HG_UTIL_EXPORT int
+hg_hash_map_insert_bytes(hg_hash_map_t *map, const void *key,
+    size_t key_size, void *value, void **cur_value);
+
+/**
+ * Look up a value in a byte-string map.
+ *
+ * \param map [IN]              pointer to map
+ * \param key [IN]              pointer to key
+ * \param key_size [IN]         key size
+ * \param value [OUT]           value associated to key (may be NULL)
+ *
+ * \return HG_UTIL_SUCCESS if found or HG_UTIL_FAIL otherwise
+ */
+HG_UTIL_EXPORT int
+hg_hash_map_lookup_bytes(hg_hash_map_t *map, const void *key,
+    size_t key_size, void **value);
+
+/**
+ * Remove a key from a byte-string map.
+ *
+ * \param map [IN/OUT]          pointer to map
+ * \param key [IN]              pointer to key
+ * \param key_size [IN]         key size
+ * \param value [OUT]           value that was associated to key (may be NULL)
+ *
+ * \return HG_UTIL_SUCCESS if removed or HG_UTIL_FAIL if not found
+ */
+HG_UTIL_EXPORT int
+hg_hash_map_remove_bytes(hg_hash_map_t *map, const void *key,
+    size_t key_size, void **value);
+
+/**
+ * Return the number of keys currently in the map.
+ *
+ * \param map [IN]              pointer to map
+ *
+ * \return Number of keys
+ */
+HG_UTIL_EXPORT unsigned int
+hg_hash_map_count(hg_hash_map_t *map);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MERCURY_HASH_MAP_H */
@@ -9,8 +9,15 @@
  */
 
 #include "mercury_log.h"
+#include "mercury_atomic.h"
+#include "mercury_list.h"
+#include "mercury_thread.h"
+#include "mercury_thread_condition.h"
+#include "mercury_thread_mutex.h"
 
 #include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
 
 /****************/
 /* Local Macros */
@@ -18,6 +25,99 @@
 
 #define HG_UTIL_LOG_MAX_BUF 256
 
+/* Size of per-thread ring buffers (must be a power of 2) */
+#define HG_LOG_RING_SIZE            (64 * 1024)
+
+/* Interval at which the background thread writes messages (ms) */
+#define HG_LOG_FLUSH_INTERVAL       10
+
+#define HG_LOG_ALIGN(x)             (((x) + 7) & ~((size_t) 7))
+
+/* Size of record header and of largest record */
+#define HG_LOG_RECORD_HDR_SIZE      offsetof(struct hg_log_record, msg)
+#define HG_LOG_RECORD_MAX_SIZE      HG_LOG_ALIGN(sizeof(struct hg_log_record))
+
+/************************************/
+/* Local Type and Struct Definition */
+/************************************/
+
+/* Message stored in ring buffer. A record of size 0 marks the end of the
+ * data before the ring wraps around. */
+struct hg_log_record {
+    hg_util_uint32_t size;
+    hg_util_uint32_t line;
+    unsigned int type;
+    const char *module;
+    const char *file;
+    const char *func;
+    char msg[HG_UTIL_LOG_MAX_BUF];
+};
+
+/* Ring buffer written by one thread and read by the background thread */
+struct hg_log_ring {
+    hg_atomic_int64_t head;         /* Written by owner thread */
+    hg_atomic_int64_t tail;         /* Written by reader */
+    hg_atomic_int32_t orphaned;     /* Owner thread has exited */
+    HG_LIST_ENTRY(hg_log_ring) entry;
+    hg_util_uint64_t buf[HG_LOG_RING_SIZE / sizeof(hg_util_uint64_t)];
+};
+
+/********************/
+/* Local Prototypes */
+/********************/
+
+/**
+ * Print message to stream corresponding to log type.
+ */
+static void
+hg_log_print(unsigned int log_type, const char *module, const char *file,
+    unsigned int line, const char *func, const char *msg);
+
+/**
+ * Get ring buffer of calling thread, creating it if needed.
+ */
+static struct hg_log_ring *
+hg_log_ring_get(void);
+
+/**
+ * Mark ring buffer of an exiting thread so that it is freed once drained.
+ */
+static void
+hg_log_ring_release(void *arg);
+
+/**
+ * Format message into ring buffer of calling thread.
+ */
+static void
+hg_log_write_async(struct hg_log_ring *ring, unsigned int log_type,
+    const char *module, const char *file, unsigned int line, const char *func,
+    const char *format, va_list ap);
+
+/**
+ * Write all pending messages. Must be called with hg_log_mutex_g held.
+ */
+static void
+hg_log_drain(void);
+
+/**
+ * Background thread writing messages.
+ */
+static HG_THREAD_RETURN_TYPE
+hg_log_flush_thread(void *arg);
+
+/**
+ * Write pending messages at exit.
+ */
+static void
+hg_log_atexit(void);
+
+/**
+ * Enable asynchronous logging if HG_LOG_ASYNC is set, unless it has already
+ * been set explicitly.
+ */
+static void
+hg_log_init_env(void);
+
 /*******************/
 /* Local Variables */
 /*******************/
@@ -27,6 +127,242 @@ static FILE *hg_log_stream_debug_g = NULL;
 static FILE *hg_log_stream_warning_g = NULL;
 static FILE *hg_log_stream_error_g = NULL;
 
+/* Asynchronous logging state, protected by hg_log_mutex_g */
+static hg_atomic_int32_t hg_log_async_g = HG_ATOMIC_VAR_INIT(0);
+static hg_atomic_int64_t hg_log_dropped_g = HG_ATOMIC_VAR_INIT(0);
+static hg_util_uint64_t hg_log_dropped_reported_g = 0;
+static hg_thread_mutex_t hg_log_mutex_g = HG_THREAD_MUTEX_INITIALIZER;
+static hg_thread_cond_t hg_log_cond_g;
+static hg_thread_t hg_log_thread_g;
+static hg_thread_key_t hg_log_ring_key_g;
+static hg_util_bool_t hg_log_ring_key_created_g = HG_UTIL_FALSE;
+static hg_util_bool_t hg_log_running_g = HG_UTIL_FALSE;
+static hg_atomic_int32_t hg_log_env_checked_g = HG_ATOMIC_VAR_INIT(0);
+
+/* Key value of exiting threads whose ring was already released */
+static char hg_log_ring_released_g;
+#define HG_LOG_RING_RELEASED ((struct hg_log_ring *) &hg_log_ring_released_g)
+static HG_LIST_HEAD(hg_log_ring) hg_log_rings_g = HG_LIST_HEAD_INITIALIZER(
+    hg_log_rings_g);
+
+/*---------------------------------------------------------------------------*/
+static void
+hg_log_print(unsigned int log_type, const char *module, const char *file,
+    unsigned int line, const char *func, const char *msg)
+{
+    FILE *stream = NULL;
+    const char *msg_type = NULL;
+
+    switch (log_type) {
+        case HG_LOG_TYPE_DEBUG:
+            stream = hg_log_stream_debug_g ? hg_log_stream_debug_g : stdout;
+            msg_type = "Debug";
+            break;
+        case HG_LOG_TYPE_WARNING:
+            stream = hg_log_stream_warning_g ? hg_log_stream_warning_g : stdout;
+            msg_type = "Warning";
+            break;
+        case HG_LOG_TYPE_ERROR:
+            stream = hg_log_stream_error_g ? hg_log_stream_error_g : stderr;
+            msg_type = "Error";
+            break;
+        default:
+            return;
+    };
+
+    /* Print using logging function */
+    hg_log_func_g(stream, "# %s -- %s -- %s:%d\n"
+        " # %s(): %s\n", module, msg_type, file, line, func, msg);
+}
+
+/*---------------------------------------------------------------------------*/
+static struct hg_log_ring *
+hg_log_ring_get(void)
+{
+    struct hg_log_ring *ring;
+
+    /* Also returns HG_LOG_RING_RELEASED if called from a thread destructor */
+    ring = (struct hg_log_ring *) hg_thread_getspecific(hg_log_ring_key_g);
+    if (ring)
+        return ring;
+
+    ring = (struct hg_log_ring *) malloc(sizeof(struct hg_log_ring));
+    if (!ring)
+        return NULL;
+    hg_atomic_init64(&ring->head, 0);
+    hg_atomic_init64(&ring->tail, 0);
+    hg_atomic_init32(&ring->orphaned, 0);
+    if (hg_thread_setspecific(hg_log_ring_key_g, ring) != HG_UTIL_SUCCESS) {
+        free(ring);
+        return NULL;
+    }
+
+    hg_thread_mutex_lock(&hg_log_mutex_g);
+    HG_LIST_INSERT_HEAD(&hg_log_rings_g, ring, entry);
+    hg_thread_mutex_unlock(&hg_log_mutex_g);
+
+    return ring;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+hg_log_ring_release(void *arg)
+{
+    struct hg_log_ring *ring = (struct hg_log_ring *) arg;
+
+    if (ring != HG_LOG_RING_RELEASED)
+        hg_atomic_set32(&ring->orphaned, 1);
+
+    /* Destructors of other keys may still log, keep them from allocating a
+     * new ring that would never be released */
+    hg_thread_setspecific(hg_log_ring_key_g, HG_LOG_RING_RELEASED);
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+hg_log_write_async(struct hg_log_ring *ring, unsigned int log_type,
+    const char *module, const char *file, unsigned int line, const char *func,
+    const char *format, va_list ap)
+{
+    struct hg_log_record *record;
+    hg_util_int64_t head, tail;
+    size_t offset, pad = 0;
+    int desc_len;
+
+    if (!ring) {
+        hg_atomic_incr64(&hg_log_dropped_g);
+        return;
+    }
+
+    /* Only the owner thread moves the head */
+    head = hg_atomic_get64(&ring->head);
+    tail = hg_atomic_get64(&ring->tail);
+    offset = (size_t) head & (HG_LOG_RING_SIZE - 1);
+
+    /* Records are contiguous, skip end of ring if too small */
+    if (HG_LOG_RING_SIZE - offset < HG_LOG_RECORD_MAX_SIZE)
+        pad = HG_LOG_RING_SIZE - offset;
+    if ((size_t) (head - tail) + pad + HG_LOG_RECORD_MAX_SIZE
+        > HG_LOG_RING_SIZE) {
+        /* Reader is behind */
+        hg_atomic_incr64(&hg_log_dropped_g);
+        return;
+    }
+    if (pad) {
+        record = (struct hg_log_record *) ((char *) ring->buf + offset);
+        record->size = 0;
+        head += (hg_util_int64_t) pad;
+        offset = 0;
+    }
+
+    record = (struct hg_log_record *) ((char *) ring->buf + offset);
+    record->line = line;
+    record->type = log_type;
+    record->module = module;
+    record->file = file;
+    record->func = func;
+    desc_len = vsnprintf(record->msg, HG_UTIL_LOG_MAX_BUF, format, ap);
+    if (desc_len < 0)
+        desc_len = 0;
+    else if (desc_len >= HG_UTIL_LOG_MAX_BUF) {
+#ifdef HG_UTIL_HAS_VERBOSE_ERROR
+        /* Truncated */
+        fprintf(stderr, "Warning, log message truncated\n");
+#endif
+        desc_len = HG_UTIL_LOG_MAX_BUF - 1;
+    }
+    record->size = (hg_util_uint32_t) HG_LOG_ALIGN(HG_LOG_RECORD_HDR_SIZE
+        + (size_t) desc_len + 1);
+
+    /* Publish record */
+    hg_atomic_set64(&ring->head, head + (hg_util_int64_t) record->size);
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+hg_log_drain(void)
+{
+    struct hg_log_ring *ring = HG_LIST_FIRST(&hg_log_rings_g);
+    hg_util_uint64_t dropped;
+
+    while (ring) {
+        struct hg_log_ring *next = HG_LIST_NEXT(ring, entry);
+        /* Owner does not write anymore once orphaned is set */
+        hg_util_bool_t orphaned =
+            (hg_util_bool_t) hg_atomic_get32(&ring->orphaned);
+        hg_util_int64_t head = hg_atomic_get64(&ring->head);
+        hg_util_int64_t tail = hg_atomic_get64(&ring->tail);
+
+        while (tail != head) {
+            size_t offset = (size_t) tail & (HG_LOG_RING_SIZE - 1);
+            struct hg_log_record *record =
+                (struct hg_log_record *) ((char *) ring->buf + offset);
+
+            if (record->size == 0) {
+                tail += (hg_util_int64_t) (HG_LOG_RING_SIZE - offset);
+                continue;
+            }
+            hg_log_print(record->type, record->module, record->file,
+                record->line, record->func, record->msg);
+            tail += (hg_util_int64_t) record->size;
+            hg_atomic_set64(&ring->tail, tail);
+        }
+
+        if (orphaned) {
+            HG_LIST_REMOVE(ring, entry);
+            free(ring);
+        }
+        ring = next;
+    }
+
+    dropped = (hg_util_uint64_t) hg_atomic_get64(&hg_log_dropped_g);
+    if (dropped != hg_log_dropped_reported_g) {
+        char msg[HG_UTIL_LOG_MAX_BUF];
+
+        snprintf(msg, HG_UTIL_LOG_MAX_BUF, "%llu log messages dropped",
+            (unsigned long long) (dropped - hg_log_dropped_reported_g));
+        hg_log_print(HG_LOG_TYPE_WARNING, "HG Util", __FILE__, __LINE__,
+            __func__, msg);
+        hg_log_dropped_reported_g = dropped;
+    }
+}
+
+/*---------------------------------------------------------------------------*/
+static HG_THREAD_RETURN_TYPE
+hg_log_flush_thread(void *arg)
+{
+    hg_thread_ret_t thread_ret = (hg_thread_ret_t) 0;
+
+    (void) arg;
+
+    hg_thread_mutex_lock(&hg_log_mutex_g);
+    while (hg_log_running_g) {
+        hg_log_drain();
+        hg_thread_cond_timedwait(&hg_log_cond_g, &hg_log_mutex_g,
+            HG_LOG_FLUSH_INTERVAL);
+    }
+    hg_thread_mutex_unlock(&hg_log_mutex_g);
+
+    return thread_ret;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+hg_log_atexit(void)
+{
+    hg_log_flush();
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+hg_log_init_env(void)
+{
+    /* Defer debug and warning output of all modules */
+    if (hg_atomic_cas32(&hg_log_env_checked_g, 0, 1)
+        && getenv("HG_LOG_ASYNC"))
+        hg_log_set_async(HG_UTIL_TRUE);
+}
+
 /*---------------------------------------------------------------------------*/
 void
 hg_log_set_func(int (*log_func)(FILE *stream, const char *format, ...))
@@ -55,6 +391,70 @@ hg_log_set_stream_error(FILE *stream)
     hg_log_stream_error_g = stream;
 }
 
+/*---------------------------------------------------------------------------*/
+int
+hg_log_set_async(hg_util_bool_t async)
+{
+    int ret = HG_UTIL_SUCCESS;
+
+    /* Explicit setting overrides HG_LOG_ASYNC */
+    hg_atomic_set32(&hg_log_env_checked_g, 1);
+
+    hg_thread_mutex_lock(&hg_log_mutex_g);
+
+    if (async && !hg_log_running_g) {
+        if (!hg_log_ring_key_created_g) {
+            /* Rings are released when their thread exits */
+            ret = hg_thread_key_create(&hg_log_ring_key_g,
+                hg_log_ring_release);
+            if (ret != HG_UTIL_SUCCESS)
+                goto done;
+            hg_log_ring_key_created_g = HG_UTIL_TRUE;
+            atexit(hg_log_atexit);
+        }
+        hg_thread_cond_init(&hg_log_cond_g);
+        hg_log_running_g = HG_UTIL_TRUE;
+        ret = hg_thread_create(&hg_log_thread_g, hg_log_flush_thread, NULL);
+        if (ret != HG_UTIL_SUCCESS) {
+            hg_log_running_g = HG_UTIL_FALSE;
+            hg_thread_cond_destroy(&hg_log_cond_g);
+            goto done;
+        }
+        hg_atomic_set32(&hg_log_async_g, 1);
+    } else if (!async && hg_log_running_g) {
+        hg_atomic_set32(&hg_log_async_g, 0);
+        hg_log_running_g = HG_UTIL_FALSE;
+        hg_thread_cond_signal(&hg_log_cond_g);
+        hg_thread_mutex_unlock(&hg_log_mutex_g);
+
+        hg_thread_join(hg_log_thread_g);
+
+        hg_thread_mutex_lock(&hg_log_mutex_g);
+        hg_log_drain();
+        hg_thread_cond_destroy(&hg_log_cond_g);
+    }
+
+done:
+    hg_thread_mutex_unlock(&hg_log_mutex_g);
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+void
+hg_log_flush(void)
+{
+    hg_thread_mutex_lock(&hg_log_mutex_g);
+    hg_log_drain();
+    hg_thread_mutex_unlock(&hg_log_mutex_g);
+}
+
+/*---------------------------------------------------------------------------*/
+hg_util_uint64_t
+hg_log_get_dropped(void)
+{
+    return (hg_util_uint64_t) hg_atomic_get64(&hg_log_dropped_g);
+}
+
 /*---------------------------------------------------------------------------*/
 void
 hg_log_write(unsigned int log_type, const char *module, const char *file,
@@ -62,28 +462,30 @@ hg_log_write(unsigned int log_type, const char *module, const char *file,
 {
     char buf[HG_UTIL_LOG_MAX_BUF];
     int desc_len;
-    FILE *stream = NULL;
-    const char *msg_type = NULL;
     va_list ap;
 
-    switch (log_type) {
-        case HG_LOG_TYPE_DEBUG:
-            stream = hg_log_stream_debug_g ? hg_log_stream_debug_g : stdout;
-            msg_type = "Debug";
-            break;
-        case HG_LOG_TYPE_WARNING:
-            stream = hg_log_stream_warning_g ? hg_log_stream_warning_g : stdout;
-            msg_type = "Warning";
-            break;
-        case HG_LOG_TYPE_ERROR:
-            stream = hg_log_stream_error_g ? hg_log_stream_error_g : stderr;
-            msg_type = "Error";
-            break;
-        default:
-            return;
-    };
+    if (log_type != HG_LOG_TYPE_DEBUG && log_type != HG_LOG_TYPE_WARNING
+        && log_type != HG_LOG_TYPE_ERROR)
+        return;
+
+    if (!hg_atomic_get32(&hg_log_env_checked_g))
+        hg_log_init_env();
 
     va_start(ap, format);
+
+    /* Errors are not deferred so that they are not lost on abort */
+    if (log_type != HG_LOG_TYPE_ERROR && hg_atomic_get32(&hg_log_async_g)) {
+        struct hg_log_ring *ring = hg_log_ring_get();
+
+        /* Ring of an exiting thread is gone, write directly */
+        if (ring != HG_LOG_RING_RELEASED) {
+            hg_log_write_async(ring, log_type, module, file, line, func,
+                format, ap);
+            va_end(ap);
+            return;
+        }
+    }
+
     desc_len = vsnprintf(buf, HG_UTIL_LOG_MAX_BUF, format, ap);
 #ifdef HG_UTIL_HAS_VERBOSE_ERROR
     if (desc_len > HG_UTIL_LOG_MAX_BUF)
@@ -94,7 +496,5 @@ hg_log_write(unsigned int log_type, const char *module, const char *file,
 #endif
     va_end(ap);
 
-    /* Print using logging function */
-    hg_log_func_g(stream, "# %s -- %s -- %s:%d\n"
-        " # %s(): %s\n", module, msg_type, file, line, func, buf);
+    hg_log_print(log_type, module, file, line, func, buf);
 }
@@ -80,6 +80,39 @@ hg_log_set_stream_warning(FILE *stream);
 HG_UTIL_EXPORT void
 hg_log_set_stream_error(FILE *stream);
 
+/**
+ * Enable or disable asynchronous logging. When enabled, debug and warning
+ * messages are formatted into a ring buffer owned by the calling thread and
+ * written to their stream by a background thread, so that logging does not
+ * block on stream locks. Messages are dropped if a ring buffer is full.
+ * Error messages are always written synchronously. Disabling asynchronous
+ * logging flushes pending messages and must not be done concurrently with
+ * other log calls. If this function is not called, asynchronous logging is
+ * enabled on the first log call when the HG_LOG_ASYNC environment variable
+ * is set.
+ *
+ * \param async [IN]            HG_UTIL_TRUE to enable, HG_UTIL_FALSE to
+ *                              disable
+ *
+ * \return Non-negative on success or negative on failure
+ */
+HG_UTIL_EXPORT int
+hg_log_set_async(hg_util_bool_t async);
+
+/**
+ * Write all pending asynchronous messages before returning.
+ */
+HG_UTIL_EXPORT void
+hg_log_flush(void);
+
+/**
+ * Get number of asynchronous messages dropped so far.
+ *
+ * \return Number of dropped messages
+ */
+HG_UTIL_EXPORT hg_util_uint64_t
+hg_log_get_dropped(void);
+
 /**
  * Write log.
  *
@@ -9,6 +9,7 @@
  */
 
 #include "mercury_mem.h"
+#include "mercury_atomic.h"
 #include "mercury_util_error.h"
 
 #ifdef _WIN32
@@ -19,10 +20,155 @@
 # include <sys/types.h>
 # include <sys/stat.h>        /* For mode constants */
 # include <fcntl.h>           /* For O_* constants */
-# include <string.h>
 # include <errno.h>
+# include <limits.h>
+# include <pthread.h>
+# include <stdio.h>
 #endif
 #include <stdlib.h>
+#include <string.h>
+
+/****************/
+/* Local Macros */
+/****************/
+
+/* Huge page size used if the system does not report one */
+#define HG_MEM_HUGE_PAGE_SIZE_DEFAULT   (2 * 1024 * 1024)
+
+#define HG_MEM_ROUND(x, a)              (((x) + (a) - 1) & ~((size_t) (a) - 1))
+
+/********************/
+/* Local Prototypes */
+/********************/
+
+#ifndef _WIN32
+/**
+ * Read huge page size and hugetlbfs mount point from the system.
+ */
+static void
+hg_mem_huge_init(void);
+
+/**
+ * Parse a size with an optional K/M/G suffix.
+ */
+static size_t
+hg_mem_parse_size(const char *str);
+#endif
+
+/**
+ * Account for mapped bytes.
+ */
+static void
+hg_mem_account(hg_mem_backing_t backing, size_t size, hg_util_bool_t add);
+
+/*******************/
+/* Local Variables */
+/*******************/
+
+#ifndef _WIN32
+static pthread_once_t hg_mem_huge_once_g = PTHREAD_ONCE_INIT;
+static char hg_mem_hugetlbfs_path_g[PATH_MAX];
+#endif
+static size_t hg_mem_huge_page_size_g = HG_MEM_HUGE_PAGE_SIZE_DEFAULT;
+static const char *hg_mem_hugetlbfs_g = NULL;
+
+static hg_atomic_int64_t hg_mem_stats_g[3] = {
+    HG_ATOMIC_VAR_INIT(0), HG_ATOMIC_VAR_INIT(0), HG_ATOMIC_VAR_INIT(0)
+};
+
+#ifndef _WIN32
+/*---------------------------------------------------------------------------*/
+static size_t
+hg_mem_parse_size(const char *str)
+{
+    char *end = NULL;
+    size_t size = (size_t) strtoull(str, &end, 10);
+
+    switch (*end) {
+        case 'k': case 'K':
+            size <<= 10;
+            break;
+        case 'm': case 'M':
+            size <<= 20;
+            break;
+        case 'g': case 'G':
+            size <<= 30;
+            break;
+        default:
+            break;
+    }
+
+    return size;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+hg_mem_huge_init(void)
+{
+    const char *env = getenv("HG_HUGETLBFS_PATH");
+    char line[PATH_MAX + 256];
+    FILE *file;
+
+    /* "Hugepagesize:    2048 kB" */
+    file = fopen("/proc/meminfo", "r");
+    if (file) {
+        while (fgets(line, sizeof(line), file)) {
+            if (strncmp(line, "Hugepagesize:", strlen("Hugepagesize:")) == 0) {
+                size_t size = (size_t) strtoull(
+                    line + strlen("Hugepagesize:"), NULL, 10) * 1024;
+                if (size)
+                    hg_mem_huge_page_size_g = size;
+                break;
+            }
+        }
+        fclose(file);
+    }
+
+    if (env) {
+        if (strlen(env) < PATH_MAX) {
+            strcpy(hg_mem_hugetlbfs_path_g, env);
+            hg_mem_hugetlbfs_g = hg_mem_hugetlbfs_path_g;
+        }
+        return;
+    }
+
+    /* "hugetlbfs /dev/hugepages hugetlbfs rw,relatime,pagesize=2M 0 0" */
+    file = fopen("/proc/mounts", "r");
+    if (!file)
+        return;
+    while (fgets(line, sizeof(line), file)) {
+        char dev[256], path[PATH_MAX], type[256], opts[256];
+        const char *pagesize;
+
+        if (sscanf(line, "%255s %4095s %255s %255s", dev, path, type, opts)
+            != 4 || strcmp(type, "hugetlbfs") != 0)
+            continue;
+        pagesize = strstr(opts, "pagesize=");
+        if (pagesize && hg_mem_parse_size(pagesize + strlen("pagesize="))
+            != hg_mem_huge_page_size_g)
+            continue;
+        if (access(path, W_OK) != 0)
+            continue;
+        strcpy(hg_mem_hugetlbfs_path_g, path);
+        hg_mem_hugetlbfs_g = hg_mem_hugetlbfs_path_g;
+        break;
+    }
+    fclose(file);
+}
+#endif
+
+/*---------------------------------------------------------------------------*/
+static void
+hg_mem_account(hg_mem_backing_t backing, size_t size, hg_util_bool_t add)
+{
+    hg_atomic_int64_t *counter = &hg_mem_stats_g[backing];
+    hg_util_int64_t old;
+
+    do {
+        old = hg_atomic_get64(counter);
+    } while (!hg_atomic_cas64(counter, old,
+        add ? old + (hg_util_int64_t) size : old - (hg_util_int64_t) size));
+}
 
 /*---------------------------------------------------------------------------*/
 long
@@ -191,3 +337,202 @@ hg_mem_shm_unmap(const char *name, void *mem_ptr, size_t size)
 done:
     return ret;
 }
+
+/*---------------------------------------------------------------------------*/
+size_t
+hg_mem_get_huge_page_size(void)
+{
+#ifndef _WIN32
+    pthread_once(&hg_mem_huge_once_g, hg_mem_huge_init);
+#endif
+    return hg_mem_huge_page_size_g;
+}
+
+/*---------------------------------------------------------------------------*/
+const char *
+hg_mem_get_hugetlbfs_path(void)
+{
+#ifndef _WIN32
+    pthread_once(&hg_mem_huge_once_g, hg_mem_huge_init);
+#endif
+    return hg_mem_hugetlbfs_g;
+}
+
+/*---------------------------------------------------------------------------*/
+void *
+hg_mem_huge_alloc(size_t size, hg_mem_backing_t *backing)
+{
+    size_t huge_page_size = hg_mem_get_huge_page_size();
+    void *mem_ptr = NULL;
+
+    size = HG_MEM_ROUND(size, huge_page_size);
+#ifdef _WIN32
+    mem_ptr = hg_mem_aligned_alloc((size_t) hg_mem_get_page_size(), size);
+    if (!mem_ptr)
+        return NULL;
+    memset(mem_ptr, 0, size);
+    *backing = HG_MEM_BACKING_REGULAR;
+#else
+# ifdef MAP_HUGETLB
+    mem_ptr = mmap(NULL, size, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (mem_ptr != MAP_FAILED)
+        *backing = HG_MEM_BACKING_HUGETLB;
+    else
+# endif
+    {
+        /* No huge page reserved, map an extra huge page so that the region
+         * can be aligned on a huge page boundary, which THP requires */
+        char *base = (char *) mmap(NULL, size + huge_page_size,
+            PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        size_t head;
+
+        if (base == MAP_FAILED) {
+            HG_UTIL_LOG_ERROR("mmap() failed (%s)", strerror(errno));
+            return NULL;
+        }
+        head = HG_MEM_ROUND((size_t) base, huge_page_size) - (size_t) base;
+        if (head)
+            munmap(base, head);
+        munmap(base + head + size, huge_page_size - head);
+        mem_ptr = base + head;
+        *backing = HG_MEM_BACKING_REGULAR;
+# ifdef MADV_HUGEPAGE
+        if (madvise(mem_ptr, size, MADV_HUGEPAGE) == 0)
+            *backing = HG_MEM_BACKING_THP;
+# endif
+    }
+#endif
+    hg_mem_account(*backing, size, HG_UTIL_TRUE);
+
+    return mem_ptr;
+}
+
+/*---------------------------------------------------------------------------*/
+void
+hg_mem_huge_free(void *mem_ptr, size_t size, hg_mem_backing_t backing)
+{
+    if (!mem_ptr)
+        return;
+
+    size = HG_MEM_ROUND(size, hg_mem_get_huge_page_size());
+    hg_mem_account(backing, size, HG_UTIL_FALSE);
+#ifdef _WIN32
+    hg_mem_aligned_free(mem_ptr);
+#else
+    if (munmap(mem_ptr, size) == -1)
+        HG_UTIL_LOG_ERROR("munmap() failed (%s)", strerror(errno));
+#endif
+}
+
+/*---------------------------------------------------------------------------*/
+void *
+hg_mem_shm_map_huge(const char *name, size_t size, hg_util_bool_t create,
+    hg_mem_backing_t *backing)
+{
+    void *mem_ptr = NULL;
+#ifndef _WIN32
+    const char *hugetlbfs = hg_mem_get_hugetlbfs_path();
+
+    if (hugetlbfs) {
+        size_t huge_size = HG_MEM_ROUND(size, hg_mem_get_huge_page_size());
+        char path[PATH_MAX];
+        struct stat shm_stat;
+        int fd;
+
+        snprintf(path, PATH_MAX, "%s/%s", hugetlbfs, name);
+        fd = open(path, O_RDWR | (create ? O_CREAT : 0), S_IRUSR | S_IWUSR);
+        if (fd >= 0) {
+            if (fstat(fd, &shm_stat) == 0
+                && (shm_stat.st_size >= (off_t) huge_size
+                    || (shm_stat.st_size == 0
+                        && ftruncate(fd, (off_t) huge_size) == 0)))
+                mem_ptr = mmap(NULL, huge_size, PROT_WRITE | PROT_READ,
+                    MAP_SHARED, fd, 0);
+            close(fd);
+            if (mem_ptr && mem_ptr != MAP_FAILED) {
+                *backing = HG_MEM_BACKING_HUGETLB;
+                hg_mem_account(*backing, huge_size, HG_UTIL_TRUE);
+                return mem_ptr;
+            }
+            /* Not enough huge pages reserved, fall back to regular shm */
+            mem_ptr = NULL;
+            if (create)
+                unlink(path);
+            else {
+                HG_UTIL_LOG_ERROR("Could not map %s", path);
+                return NULL;
+            }
+        } else if (create || errno != ENOENT) {
+            HG_UTIL_LOG_ERROR("open() failed (%s)", strerror(errno));
+            if (!create)
+                return NULL;
+        }
+    }
+#endif
+
+    mem_ptr = hg_mem_shm_map(name, size, create);
+    if (!mem_ptr)
+        return NULL;
+    *backing = HG_MEM_BACKING_REGULAR;
+#ifdef MADV_HUGEPAGE
+    /* Effective if shmem THP is set to "advise", only full huge pages can
+     * be backed */
+    if (create && size >= hg_mem_get_huge_page_size()
+        && madvise(mem_ptr, size, MADV_HUGEPAGE) == 0)
+        *backing = HG_MEM_BACKING_THP;
+#endif
+    hg_mem_account(*backing, size, HG_UTIL_TRUE);
+
+    return mem_ptr;
+}
+
+/*---------------------------------------------------------------------------*/
+int
+hg_mem_shm_unmap_huge(const char *name, void *mem_ptr, size_t size,
+    hg_mem_backing_t backing)
+{
+    int ret = HG_UTIL_SUCCESS;
+
+#ifndef _WIN32
+    if (backing == HG_MEM_BACKING_HUGETLB) {
+        size = HG_MEM_ROUND(size, hg_mem_get_huge_page_size());
+        if (mem_ptr) {
+            hg_mem_account(backing, size, HG_UTIL_FALSE);
+            if (munmap(mem_ptr, size) == -1) {
+                HG_UTIL_LOG_ERROR("munmap() failed (%s)", strerror(errno));
+                ret = HG_UTIL_FAIL;
+            }
+        }
+        if (name) {
+            char path[PATH_MAX];
+
+            snprintf(path, PATH_MAX, "%s/%s", hg_mem_get_hugetlbfs_path(),
+                name);
+            if (unlink(path) == -1) {
+                HG_UTIL_LOG_ERROR("unlink() failed (%s)", strerror(errno));
+                ret = HG_UTIL_FAIL;
+            }
+        }
+        return ret;
+    }
+#endif
+
+    if (mem_ptr)
+        hg_mem_account(backing, size, HG_UTIL_FALSE);
+    ret = hg_mem_shm_unmap(name, mem_ptr, size);
+
+    return ret;
+}
+
+/*---------------------------------------------------------------------------*/
+void
+hg_mem_get_stats(struct hg_mem_stats *stats)
+{
+    stats->hugetlb_bytes = (hg_util_uint64_t) hg_atomic_get64(
+        &hg_mem_stats_g[HG_MEM_BACKING_HUGETLB]);
+    stats->thp_bytes = (hg_util_uint64_t) hg_atomic_get64(
+        &hg_mem_stats_g[HG_MEM_BACKING_THP]);
+    stats->regular_bytes = (hg_util_uint64_t) hg_atomic_get64(
+        &hg_mem_stats_g[HG_MEM_BACKING_REGULAR]);
+}
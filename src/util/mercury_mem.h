@@ -17,6 +17,29 @@
  * Purpose: memory related utility functions.
  */
 
+/*************************************/
+/* Public Type and Struct Definition */
+/*************************************/
+
+/* Pages backing a memory region */
+typedef enum {
+    HG_MEM_BACKING_REGULAR,     /* Regular pages */
+    HG_MEM_BACKING_THP,         /* Regular pages advised for transparent
+                                 * huge pages */
+    HG_MEM_BACKING_HUGETLB      /* Reserved huge pages */
+} hg_mem_backing_t;
+
+/* Bytes currently mapped through huge page functions, by backing */
+struct hg_mem_stats {
+    hg_util_uint64_t hugetlb_bytes;
+    hg_util_uint64_t thp_bytes;
+    hg_util_uint64_t regular_bytes;
+};
+
+/*********************/
+/* Public Prototypes */
+/*********************/
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -74,6 +97,92 @@ hg_mem_shm_map(const char *name, size_t size, hg_util_bool_t create);
 HG_UTIL_EXPORT int
 hg_mem_shm_unmap(const char *name, void *mem_ptr, size_t size);
 
+/**
+ * Get default huge page size of the system.
+ *
+ * \return huge page size (2 MB if it cannot be determined)
+ */
+HG_UTIL_EXPORT size_t
+hg_mem_get_huge_page_size(void);
+
+/**
+ * Get path of the hugetlbfs mount used for shared huge pages. The path is
+ * taken from the HG_HUGETLBFS_PATH environment variable if set, otherwise
+ * from the first hugetlbfs mount of the default huge page size.
+ *
+ * \return path or NULL if no hugetlbfs is mounted
+ */
+HG_UTIL_EXPORT const char *
+hg_mem_get_hugetlbfs_path(void);
+
+/**
+ * Allocate size bytes backed by huge pages. The size is rounded up to the
+ * huge page size. Reserved huge pages are used if available, otherwise
+ * regular pages are advised for transparent huge pages when supported.
+ * The memory is zeroed.
+ *
+ * \param size [IN]             total requested size
+ * \param backing [OUT]         pointer to returned backing type
+ *
+ * \return a pointer to the allocated memory, or NULL in case of failure
+ */
+HG_UTIL_EXPORT void *
+hg_mem_huge_alloc(size_t size, hg_mem_backing_t *backing);
+
+/**
+ * Free memory allocated from hg_mem_huge_alloc().
+ *
+ * \param mem_ptr [IN]          pointer to allocated memory
+ * \param size [IN]             size passed to hg_mem_huge_alloc()
+ * \param backing [IN]          backing returned by hg_mem_huge_alloc()
+ */
+HG_UTIL_EXPORT void
+hg_mem_huge_free(void *mem_ptr, size_t size, hg_mem_backing_t backing);
+
+/**
+ * Create/open a shared-memory mapped file of size \size with name \name,
+ * backed by huge pages if possible. When creating, the file is placed on
+ * hugetlbfs (see hg_mem_get_hugetlbfs_path()) if huge pages are available
+ * and its size is rounded up to the huge page size; otherwise it falls back
+ * to hg_mem_shm_map() and large regions are advised for transparent huge
+ * pages. When opening, the file is mapped wherever its creator placed it,
+ * so this must be used by peers of a creator that uses huge pages.
+ *
+ * \param name [IN]             name of mapped file
+ * \param size [IN]             total requested size
+ * \param create [IN]           create file if not existing
+ * \param backing [OUT]         pointer to returned backing type
+ *
+ * \return a pointer to the mapped memory region, or NULL in case of failure
+ */
+HG_UTIL_EXPORT void *
+hg_mem_shm_map_huge(const char *name, size_t size, hg_util_bool_t create,
+    hg_mem_backing_t *backing);
+
+/**
+ * Unmap a region mapped with hg_mem_shm_map_huge() and remove the file if
+ * \name is not NULL.
+ *
+ * \param name [IN]             name of mapped file
+ * \param mem_ptr [IN]          pointer to mapped memory region
+ * \param size [IN]             size passed to hg_mem_shm_map_huge()
+ * \param backing [IN]          backing returned by hg_mem_shm_map_huge()
+ *
+ * \return non-negative on success, or negative in case of failure
+ */
+HG_UTIL_EXPORT int
+hg_mem_shm_unmap_huge(const char *name, void *mem_ptr, size_t size,
+    hg_mem_backing_t backing);
+
+/**
+ * Retrieve the amount of memory currently mapped through huge page
+ * functions, by backing type.
+ *
+ * \param stats [OUT]           pointer to stats
+ */
+HG_UTIL_EXPORT void
+hg_mem_get_stats(struct hg_mem_stats *stats);
+
 #ifdef __cplusplus
 }
 #endif
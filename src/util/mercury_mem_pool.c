@@ -0,0 +1,450 @@
+/*
+ * Copyright (C) 2013-2019 Argonne National Laboratory, Department of Energy,
+ *                    UChicago Argonne, LLC and The HDF Group.
+ * All rights reserved.
+ *
+ * The full copyright notice, including terms governing use, modification,
+ * and redistribution, is contained in the COPYING file that can be
+ * found at the root of the source code distribution tree.
+ */
+
+#include "mercury_mem_pool.h"
+#include "mercury_atomic.h"
+#include "mercury_list.h"
+#include "mercury_mem.h"
+#include "mercury_thread.h"
+#include "mercury_thread_mutex.h"
+#include "mercury_util_error.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/****************/
+/* Local Macros */
+/****************/
+
+/* Object and chunk alignment */
+#define HG_MEM_POOL_ALIGNMENT       64
+
+/* Default number of objects per chunk */
+#define HG_MEM_POOL_CHUNK_COUNT     64
+
+/* Number of objects cached per thread, half of them are exchanged with the
+ * shared free list when the magazine runs empty or full */
+#define HG_MEM_POOL_MAG_SIZE        32
+#define HG_MEM_POOL_MAG_BATCH       (HG_MEM_POOL_MAG_SIZE / 2)
+
+#define HG_MEM_POOL_ROUND(x, a)     (((x) + (a) - 1) & ~((size_t) (a) - 1))
+
+/************************************/
+/* Local Type and Struct Definition */
+/************************************/
+
+/* Free objects are linked through their first word */
+struct hg_mem_pool_obj {
+    struct hg_mem_pool_obj *next;
+};
+
+/* Chunk header, stored in the first cache line of each chunk */
+struct hg_mem_pool_chunk {
+    struct hg_mem_pool_chunk *next;
+    size_t size;
+    hg_mem_backing_t backing;   /* Backing if allocated with huge pages */
+};
+
+/* Per-thread magazine. Counters are only written by the owning thread, they
+ * are atomic so that they can be read by hg_mem_pool_get_stats(). */
+struct hg_mem_pool_mag {
+    hg_mem_pool_t *pool;
+    hg_thread_t thread;
+    hg_atomic_int32_t count;
+    hg_atomic_int64_t n_allocs;
+    HG_LIST_ENTRY(hg_mem_pool_mag) entry;
+    void *objs[HG_MEM_POOL_MAG_SIZE];
+};
+
+struct hg_mem_pool {
+    size_t obj_size;                    /* Aligned object size */
+    unsigned int chunk_count;           /* Objects per chunk */
+    unsigned int flags;                 /* Pool flags */
+    hg_thread_key_t mag_key;            /* Thread magazine */
+    hg_thread_mutex_t lock;             /* Protects fields below */
+    struct hg_mem_pool_obj *free_list;  /* Shared free objects */
+    size_t n_free;
+    struct hg_mem_pool_chunk *chunks;   /* Chunks to release */
+    size_t n_chunks;
+    size_t n_huge_chunks;
+    size_t n_objs;
+    hg_util_uint64_t n_allocs;          /* Allocs of released magazines */
+};
+
+/********************/
+/* Local Prototypes */
+/********************/
+
+/**
+ * Release the magazine of an exiting thread.
+ */
+static void
+hg_mem_pool_mag_release(void *arg);
+
+/**
+ * Get the magazine of the calling thread, creating it if needed.
+ */
+static HG_UTIL_INLINE struct hg_mem_pool_mag *
+hg_mem_pool_mag_get(hg_mem_pool_t *pool);
+
+/**
+ * Allocate a new chunk and add its objects to the shared free list.
+ * Must be called with the pool lock held.
+ */
+static int
+hg_mem_pool_grow(hg_mem_pool_t *pool);
+
+/**
+ * Move objects from the shared free list to a magazine.
+ */
+static unsigned int
+hg_mem_pool_refill(hg_mem_pool_t *pool, struct hg_mem_pool_mag *mag);
+
+/**
+ * Move the oldest half of a full magazine to the shared free list.
+ */
+static unsigned int
+hg_mem_pool_flush(hg_mem_pool_t *pool, struct hg_mem_pool_mag *mag);
+
+/*******************/
+/* Local Variables */
+/*******************/
+
+/* Live magazines of all pools. The lock is taken before pool locks and is
+ * never destroyed, so that thread destructors racing with
+ * hg_mem_pool_destroy() can use it. */
+static HG_LIST_HEAD(hg_mem_pool_mag) hg_mem_pool_mags_g =
+    HG_LIST_HEAD_INITIALIZER(hg_mem_pool_mags_g);
+static hg_thread_mutex_t hg_mem_pool_mags_lock_g = HG_THREAD_MUTEX_INITIALIZER;
+
+/*---------------------------------------------------------------------------*/
+static void
+hg_mem_pool_mag_release(void *arg)
+{
+    struct hg_mem_pool_mag *mag;
+
+    /* The pool may have been destroyed and the magazine freed already, only
+     * dereference arg once it is found registered to the exiting thread */
+    hg_thread_mutex_lock(&hg_mem_pool_mags_lock_g);
+    HG_LIST_FOREACH(mag, &hg_mem_pool_mags_g, entry)
+        if (mag == arg && hg_thread_equal(mag->thread, hg_thread_self()))
+            break;
+    if (mag) {
+        hg_mem_pool_t *pool = mag->pool;
+        unsigned int i, count = (unsigned int) hg_atomic_get32(&mag->count);
+
+        hg_thread_mutex_lock(&pool->lock);
+        for (i = 0; i < count; i++) {
+            struct hg_mem_pool_obj *obj =
+                (struct hg_mem_pool_obj *) mag->objs[i];
+
+            obj->next = pool->free_list;
+            pool->free_list = obj;
+        }
+        pool->n_free += count;
+        pool->n_allocs += (hg_util_uint64_t) hg_atomic_get64(&mag->n_allocs);
+        hg_thread_mutex_unlock(&pool->lock);
+        HG_LIST_REMOVE(mag, entry);
+    }
+    hg_thread_mutex_unlock(&hg_mem_pool_mags_lock_g);
+
+    free(mag);
+}
+
+/*---------------------------------------------------------------------------*/
+static HG_UTIL_INLINE struct hg_mem_pool_mag *
+hg_mem_pool_mag_get(hg_mem_pool_t *pool)
+{
+    struct hg_mem_pool_mag *mag;
+
+    mag = (struct hg_mem_pool_mag *) hg_thread_getspecific(pool->mag_key);
+    if (mag)
+        return mag;
+
+    mag = (struct hg_mem_pool_mag *) malloc(sizeof(struct hg_mem_pool_mag));
+    if (!mag)
+        return NULL;
+    mag->pool = pool;
+    mag->thread = hg_thread_self();
+    hg_atomic_init32(&mag->count, 0);
+    hg_atomic_init64(&mag->n_allocs, 0);
+    if (hg_thread_setspecific(pool->mag_key, mag) != HG_UTIL_SUCCESS) {
+        free(mag);
+        return NULL;
+    }
+
+    hg_thread_mutex_lock(&hg_mem_pool_mags_lock_g);
+    HG_LIST_INSERT_HEAD(&hg_mem_pool_mags_g, mag, entry);
+    hg_thread_mutex_unlock(&hg_mem_pool_mags_lock_g);
+
+    return mag;
+}
+
+/*---------------------------------------------------------------------------*/
+static int
+hg_mem_pool_grow(hg_mem_pool_t *pool)
+{
+    struct hg_mem_pool_chunk *chunk = NULL;
+    size_t size = HG_MEM_POOL_ALIGNMENT
+        + pool->obj_size * pool->chunk_count;
+    hg_mem_backing_t backing = HG_MEM_BACKING_REGULAR;
+    size_t i, count;
+    char *objs;
+
+    if (pool->flags & HG_MEM_POOL_HUGE_PAGE) {
+        /* Falls back to regular pages if no huge page is reserved */
+        size = HG_MEM_POOL_ROUND(size, hg_mem_get_huge_page_size());
+        chunk = (struct hg_mem_pool_chunk *) hg_mem_huge_alloc(size, &backing);
+    } else
+        chunk = (struct hg_mem_pool_chunk *) hg_mem_aligned_alloc(
+            HG_MEM_POOL_ALIGNMENT, size);
+    if (!chunk) {
+        HG_UTIL_LOG_ERROR("Could not allocate chunk of %zu bytes", size);
+        return HG_UTIL_FAIL;
+    }
+    chunk->size = size;
+    chunk->backing = backing;
+    chunk->next = pool->chunks;
+    pool->chunks = chunk;
+    pool->n_chunks++;
+    if (backing == HG_MEM_BACKING_HUGETLB)
+        pool->n_huge_chunks++;
+
+    /* Huge pages may fit more objects than requested */
+    count = (size - HG_MEM_POOL_ALIGNMENT) / pool->obj_size;
+    objs = (char *) chunk + HG_MEM_POOL_ALIGNMENT;
+    for (i = count; i > 0; i--) {
+        struct hg_mem_pool_obj *obj =
+            (struct hg_mem_pool_obj *) (objs + (i - 1) * pool->obj_size);
+
+        obj->next = pool->free_list;
+        pool->free_list = obj;
+    }
+    pool->n_free += count;
+    pool->n_objs += count;
+
+    return HG_UTIL_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static unsigned int
+hg_mem_pool_refill(hg_mem_pool_t *pool, struct hg_mem_pool_mag *mag)
+{
+    unsigned int count = 0;
+
+    hg_thread_mutex_lock(&pool->lock);
+    while (count < HG_MEM_POOL_MAG_BATCH) {
+        struct hg_mem_pool_obj *obj = pool->free_list;
+
+        if (!obj) {
+            if (hg_mem_pool_grow(pool) != HG_UTIL_SUCCESS)
+                break;
+            continue;
+        }
+        pool->free_list = obj->next;
+        mag->objs[count++] = obj;
+    }
+    pool->n_free -= count;
+    hg_thread_mutex_unlock(&pool->lock);
+
+    return count;
+}
+
+/*---------------------------------------------------------------------------*/
+static unsigned int
+hg_mem_pool_flush(hg_mem_pool_t *pool, struct hg_mem_pool_mag *mag)
+{
+    unsigned int i;
+
+    /* Keep the most recently freed objects, which are more likely to be
+     * in cache */
+    hg_thread_mutex_lock(&pool->lock);
+    for (i = 0; i < HG_MEM_POOL_MAG_BATCH; i++) {
+        struct hg_mem_pool_obj *obj = (struct hg_mem_pool_obj *) mag->objs[i];
+
+        obj->next = pool->free_list;
+        pool->free_list = obj;
+    }
+    pool->n_free += HG_MEM_POOL_MAG_BATCH;
+    hg_thread_mutex_unlock(&pool->lock);
+
+    memmove(mag->objs, mag->objs + HG_MEM_POOL_MAG_BATCH,
+        (HG_MEM_POOL_MAG_SIZE - HG_MEM_POOL_MAG_BATCH) * sizeof(void *));
+
+    return HG_MEM_POOL_MAG_SIZE - HG_MEM_POOL_MAG_BATCH;
+}
+
+/*---------------------------------------------------------------------------*/
+hg_mem_pool_t *
+hg_mem_pool_create(size_t obj_size, unsigned int chunk_count,
+    unsigned int flags)
+{
+    hg_mem_pool_t *pool = NULL;
+    int rc;
+
+    if (!obj_size) {
+        HG_UTIL_LOG_ERROR("Object size must be non-zero");
+        return NULL;
+    }
+
+    pool = (hg_mem_pool_t *) malloc(sizeof(hg_mem_pool_t));
+    if (!pool) {
+        HG_UTIL_LOG_ERROR("Could not allocate pool");
+        return NULL;
+    }
+    memset(pool, 0, sizeof(hg_mem_pool_t));
+    if (obj_size < sizeof(struct hg_mem_pool_obj))
+        obj_size = sizeof(struct hg_mem_pool_obj);
+    pool->obj_size = HG_MEM_POOL_ROUND(obj_size, HG_MEM_POOL_ALIGNMENT);
+    pool->chunk_count = chunk_count ? chunk_count : HG_MEM_POOL_CHUNK_COUNT;
+    pool->flags = flags;
+
+    /* Magazines must be released when their thread exits */
+    rc = hg_thread_key_create(&pool->mag_key, hg_mem_pool_mag_release);
+    if (rc != HG_UTIL_SUCCESS) {
+        HG_UTIL_LOG_ERROR("Could not create thread key");
+        free(pool);
+        return NULL;
+    }
+    hg_thread_mutex_init(&pool->lock);
+
+    return pool;
+}
+
+/*---------------------------------------------------------------------------*/
+void
+hg_mem_pool_destroy(hg_mem_pool_t *pool)
+{
+    struct hg_mem_pool_mag *mag;
+
+    if (!pool)
+        return;
+
+    /* Exiting threads no longer release their magazine. A release already
+     * in progress either completes first, as it holds the lock, or no longer
+     * finds its magazine registered and leaves it alone. */
+    hg_thread_mutex_lock(&hg_mem_pool_mags_lock_g);
+    hg_thread_key_delete(pool->mag_key);
+    mag = HG_LIST_FIRST(&hg_mem_pool_mags_g);
+    while (mag) {
+        struct hg_mem_pool_mag *next = HG_LIST_NEXT(mag, entry);
+
+        if (mag->pool == pool) {
+            HG_LIST_REMOVE(mag, entry);
+            free(mag);
+        }
+        mag = next;
+    }
+    hg_thread_mutex_unlock(&hg_mem_pool_mags_lock_g);
+
+    while (pool->chunks) {
+        struct hg_mem_pool_chunk *chunk = pool->chunks;
+
+        pool->chunks = chunk->next;
+        if (pool->flags & HG_MEM_POOL_HUGE_PAGE)
+            hg_mem_huge_free(chunk, chunk->size, chunk->backing);
+        else
+            hg_mem_aligned_free(chunk);
+    }
+
+    hg_thread_mutex_destroy(&pool->lock);
+    free(pool);
+}
+
+/*---------------------------------------------------------------------------*/
+void *
+hg_mem_pool_alloc(hg_mem_pool_t *pool)
+{
+    struct hg_mem_pool_mag *mag = hg_mem_pool_mag_get(pool);
+    unsigned int count;
+    void *obj;
+
+    if (!mag) {
+        /* No magazine, take object directly from the shared free list */
+        hg_thread_mutex_lock(&pool->lock);
+        if (!pool->free_list && hg_mem_pool_grow(pool) != HG_UTIL_SUCCESS) {
+            hg_thread_mutex_unlock(&pool->lock);
+            return NULL;
+        }
+        obj = pool->free_list;
+        pool->free_list = pool->free_list->next;
+        pool->n_free--;
+        pool->n_allocs++;
+        hg_thread_mutex_unlock(&pool->lock);
+
+        return obj;
+    }
+
+    count = (unsigned int) hg_atomic_get32(&mag->count);
+    if (!count) {
+        count = hg_mem_pool_refill(pool, mag);
+        if (!count)
+            return NULL;
+    }
+    obj = mag->objs[--count];
+    hg_atomic_set32(&mag->count, (hg_util_int32_t) count);
+    hg_atomic_set64(&mag->n_allocs, hg_atomic_get64(&mag->n_allocs) + 1);
+
+    return obj;
+}
+
+/*---------------------------------------------------------------------------*/
+void
+hg_mem_pool_free(hg_mem_pool_t *pool, void *obj)
+{
+    struct hg_mem_pool_mag *mag;
+    unsigned int count;
+
+    if (!obj)
+        return;
+
+    mag = hg_mem_pool_mag_get(pool);
+    if (!mag) {
+        hg_thread_mutex_lock(&pool->lock);
+        ((struct hg_mem_pool_obj *) obj)->next = pool->free_list;
+        pool->free_list = (struct hg_mem_pool_obj *) obj;
+        pool->n_free++;
+        hg_thread_mutex_unlock(&pool->lock);
+        return;
+    }
+
+    count = (unsigned int) hg_atomic_get32(&mag->count);
+    if (count == HG_MEM_POOL_MAG_SIZE)
+        count = hg_mem_pool_flush(pool, mag);
+    mag->objs[count++] = obj;
+    hg_atomic_set32(&mag->count, (hg_util_int32_t) count);
+}
+
+/*---------------------------------------------------------------------------*/
+void
+hg_mem_pool_get_stats(hg_mem_pool_t *pool, struct hg_mem_pool_stats *stats)
+{
+    struct hg_mem_pool_mag *mag;
+    size_t n_cached = 0;
+
+    hg_thread_mutex_lock(&hg_mem_pool_mags_lock_g);
+    hg_thread_mutex_lock(&pool->lock);
+    stats->obj_size = pool->obj_size;
+    stats->n_chunks = pool->n_chunks;
+    stats->n_huge_chunks = pool->n_huge_chunks;
+    stats->n_objs = pool->n_objs;
+    stats->n_allocs = pool->n_allocs;
+    HG_LIST_FOREACH(mag, &hg_mem_pool_mags_g, entry) {
+        if (mag->pool != pool)
+            continue;
+        n_cached += (size_t) hg_atomic_get32(&mag->count);
+        stats->n_allocs += (hg_util_uint64_t) hg_atomic_get64(&mag->n_allocs);
+    }
+    /* Magazine counts may be read while being updated */
+    stats->n_used = (pool->n_objs > pool->n_free + n_cached) ?
+        pool->n_objs - pool->n_free - n_cached : 0;
+    hg_thread_mutex_unlock(&pool->lock);
+    hg_thread_mutex_unlock(&hg_mem_pool_mags_lock_g);
+}
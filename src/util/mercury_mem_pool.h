@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2013-2019 Argonne National Laboratory, Department of Energy,
+ *                    UChicago Argonne, LLC and The HDF Group.
+ * All rights reserved.
+ *
+ * The full copyright notice, including terms governing use, modification,
+ * and redistribution, is contained in the COPYING file that can be
+ * found at the root of the source code distribution tree.
+ */
+
+/**
+ * \file mercury_mem_pool.h
+ *
+ * \brief Fixed-size object pool.
+ *
+ * Objects are carved out of large chunks and aligned on cache lines. Each
+ * thread keeps a small magazine of free objects so that allocations and
+ * frees do not touch shared state in the common case; magazines are
+ * refilled from and flushed to a shared free list in batches. Memory is
+ * only returned to the system when the pool is destroyed.
+ */
+
+#ifndef MERCURY_MEM_POOL_H
+#define MERCURY_MEM_POOL_H
+
+#include "mercury_util_config.h"
+
+#include <stddef.h>
+
+/*************************************/
+/* Public Type and Struct Definition */
+/*************************************/
+
+typedef struct hg_mem_pool hg_mem_pool_t;
+
+/* Pool usage counters */
+struct hg_mem_pool_stats {
+    size_t obj_size;            /* Object size after alignment */
+    size_t n_chunks;            /* Number of chunks allocated */
+    size_t n_huge_chunks;       /* Number of chunks backed by huge pages */
+    size_t n_objs;              /* Total number of objects */
+    size_t n_used;              /* Number of objects currently allocated */
+    hg_util_uint64_t n_allocs;  /* Number of allocations so far */
+};
+
+/*****************/
+/* Public Macros */
+/*****************/
+
+/* Pool flags */
+#define HG_MEM_POOL_HUGE_PAGE   (1 << 0) /* Back chunks with huge pages */
+
+/*********************/
+/* Public Prototypes */
+/*********************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Create a pool of objects of size \obj_size. Memory is allocated in chunks
+ * of at least \chunk_count objects. If HG_MEM_POOL_HUGE_PAGE is passed,
+ * chunks are rounded up to the huge page size and backed by huge pages
+ * whenever the system provides them, regular pages are used otherwise.
+ *
+ * \param obj_size [IN]         size of objects
+ * \param chunk_count [IN]      number of objects per chunk (0 for default)
+ * \param flags [IN]            pool flags
+ *
+ * \return Pointer to new pool or NULL on failure
+ */
+HG_UTIL_EXPORT hg_mem_pool_t *
+hg_mem_pool_create(size_t obj_size, unsigned int chunk_count,
+    unsigned int flags);
+
+/**
+ * Destroy a pool and release all of its memory, including objects that
+ * have not been freed. No other thread may use the pool concurrently.
+ *
+ * \param pool [IN/OUT]         pointer to pool
+ */
+HG_UTIL_EXPORT void
+hg_mem_pool_destroy(hg_mem_pool_t *pool);
+
+/**
+ * Allocate an object from the pool. The object is not initialized.
+ *
+ * \param pool [IN/OUT]         pointer to pool
+ *
+ * \return Pointer to object or NULL on failure
+ */
+HG_UTIL_EXPORT void *
+hg_mem_pool_alloc(hg_mem_pool_t *pool);
+
+/**
+ * Return an object to the pool. Objects may be freed by a different thread
+ * than the one that allocated them.
+ *
+ * \param pool [IN/OUT]         pointer to pool
+ * \param obj [IN]              pointer to object
+ */
+HG_UTIL_EXPORT void
+hg_mem_pool_free(hg_mem_pool_t *pool, void *obj);
+
+/**
+ * Retrieve pool usage counters. Values are approximate while other threads
+ * use the pool.
+ *
+ * \param pool [IN]             pointer to pool
+ * \param stats [OUT]           pointer to stats
+ */
+HG_UTIL_EXPORT void
+hg_mem_pool_get_stats(hg_mem_pool_t *pool, struct hg_mem_pool_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MERCURY_MEM_POOL_H */
@@ -44,6 +44,7 @@ struct hg_poll_data {
 #endif
     hg_poll_cb_t poll_cb;
     void *poll_arg;
+    hg_atomic_int32_t removed; /* Removed while a wait was in progress */
     HG_LIST_ENTRY(hg_poll_data) entry;
 };
 
@@ -58,9 +59,38 @@ struct hg_poll_set {
     struct pollfd *poll_fds;
 #endif
     HG_LIST_HEAD(hg_poll_data) poll_data_list;
+    HG_LIST_HEAD(hg_poll_data) removed_list; /* Freed once no wait is left */
+    unsigned int wait_count;    /* Waits in progress */
     hg_thread_spin_t poll_data_list_lock;
 };
 
+/*---------------------------------------------------------------------------*/
+static void
+hg_poll_data_release(hg_poll_set_t *poll_set,
+    struct hg_poll_data *hg_poll_data)
+{
+    /* Events returned to a wait that is still in progress may reference the
+     * poll data, only free it once that wait has returned. Must be called
+     * with poll_data_list_lock held. */
+    if (poll_set->wait_count) {
+        hg_atomic_set32(&hg_poll_data->removed, HG_UTIL_TRUE);
+        HG_LIST_INSERT_HEAD(&poll_set->removed_list, hg_poll_data, entry);
+    } else
+        free(hg_poll_data);
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+hg_poll_data_release_all(struct hg_poll_data *hg_poll_data)
+{
+    while (hg_poll_data) {
+        struct hg_poll_data *next = HG_LIST_NEXT(hg_poll_data, entry);
+
+        free(hg_poll_data);
+        hg_poll_data = next;
+    }
+}
+
 /*---------------------------------------------------------------------------*/
 hg_poll_set_t *
 hg_poll_create(void)
@@ -79,6 +109,8 @@ hg_poll_create(void)
     /* TODO */
 #else
     HG_LIST_INIT(&hg_poll_set->poll_data_list);
+    HG_LIST_INIT(&hg_poll_set->removed_list);
+    hg_poll_set->wait_count = 0;
     hg_thread_spin_init(&hg_poll_set->poll_data_list_lock);
     hg_atomic_init32(&hg_poll_set->nfds, 0);
     hg_poll_set->try_wait_cb = NULL;
@@ -142,6 +174,7 @@ hg_poll_destroy(hg_poll_set_t *poll_set)
 #else
     free(poll_set->poll_fds);
 #endif
+    hg_poll_data_release_all(HG_LIST_FIRST(&poll_set->removed_list));
     hg_thread_spin_destroy(&poll_set->poll_data_list_lock);
 #endif /* defined(_WIN32) */
     free(poll_set);
@@ -344,7 +377,7 @@ hg_poll_remove(hg_poll_set_t *poll_set, int fd)
                 hg_thread_spin_unlock(&poll_set->poll_data_list_lock);
                 goto done;
             }
-            free(hg_poll_data);
+            hg_poll_data_release(poll_set, hg_poll_data);
             found = HG_UTIL_TRUE;
             break;
         }
@@ -370,7 +403,7 @@ hg_poll_remove(hg_poll_set_t *poll_set, int fd)
                     goto done;
                 }
             }
-            free(hg_poll_data);
+            hg_poll_data_release(poll_set, hg_poll_data);
             found = HG_UTIL_TRUE;
             break;
         }
@@ -383,7 +416,7 @@ hg_poll_remove(hg_poll_set_t *poll_set, int fd)
             unsigned int i = 0;
 
             HG_LIST_REMOVE(hg_poll_data, entry);
-            free(hg_poll_data);
+            hg_poll_data_release(poll_set, hg_poll_data);
             found = HG_UTIL_TRUE;
 
             if (fd > 0) {
@@ -410,19 +443,13 @@ done:
 }
 
 /*---------------------------------------------------------------------------*/
-int
-hg_poll_wait(hg_poll_set_t *poll_set, unsigned int timeout,
+static int
+hg_poll_wait_dispatch(hg_poll_set_t *poll_set, unsigned int timeout,
     hg_util_bool_t *progressed)
 {
     hg_util_bool_t poll_progressed = HG_UTIL_FALSE;
     int ret = HG_UTIL_SUCCESS;
 
-    if (!poll_set) {
-        HG_UTIL_LOG_ERROR("NULL poll set");
-        ret = HG_UTIL_FAIL;
-        goto done;
-    }
-
     if (timeout && (!poll_set->try_wait_cb || (poll_set->try_wait_cb
         && poll_set->try_wait_cb(poll_set->try_wait_arg))))  {
 #if defined(_WIN32)
@@ -457,6 +484,10 @@ hg_poll_wait(hg_poll_set_t *poll_set, unsigned int timeout,
                 error = EPOLLRDHUP;
             }
 
+            /* Removed after epoll_wait() returned */
+            if (hg_atomic_get32(&hg_poll_data->removed))
+                continue;
+
             if ((events[i].events & (EPOLLIN | EPOLLOUT))
                 && hg_poll_data->poll_cb) {
                 hg_util_bool_t poll_cb_progressed = HG_UTIL_FALSE;
@@ -502,7 +533,8 @@ hg_poll_wait(hg_poll_set_t *poll_set, unsigned int timeout,
                 ret = HG_UTIL_FAIL;
                 goto done;
             }
-            if (hg_poll_data->poll_cb) {
+            if (hg_poll_data->poll_cb
+                && !hg_atomic_get32(&hg_poll_data->removed)) {
                 hg_util_bool_t poll_cb_progressed = HG_UTIL_FALSE;
                 int poll_ret = HG_UTIL_SUCCESS;
 
@@ -545,7 +577,7 @@ hg_poll_wait(hg_poll_set_t *poll_set, unsigned int timeout,
                     hg_thread_spin_unlock(&poll_set->poll_data_list_lock);
 
                     /* TODO check POLLHUP | POLLERR | POLLNVAL */
-                    if (hg_poll_data->poll_cb) {
+                    if (hg_poll_data && hg_poll_data->poll_cb) {
                         hg_util_bool_t poll_cb_progressed = HG_UTIL_FALSE;
                         int poll_ret = HG_UTIL_SUCCESS;
 
@@ -568,10 +600,13 @@ hg_poll_wait(hg_poll_set_t *poll_set, unsigned int timeout,
 #else
         struct hg_poll_data *hg_poll_data;
 
+        /* Lock is dropped while calling back, poll data removed in the
+         * meantime is not freed before this wait returns */
         hg_thread_spin_lock(&poll_set->poll_data_list_lock);
         HG_LIST_FOREACH(hg_poll_data, &poll_set->poll_data_list, entry) {
             hg_thread_spin_unlock(&poll_set->poll_data_list_lock);
-            if (hg_poll_data->poll_cb) {
+            if (hg_poll_data->poll_cb
+                && !hg_atomic_get32(&hg_poll_data->removed)) {
                 hg_util_bool_t poll_cb_progressed = HG_UTIL_FALSE;
                 int poll_ret = HG_UTIL_SUCCESS;
 
@@ -580,7 +615,6 @@ hg_poll_wait(hg_poll_set_t *poll_set, unsigned int timeout,
                 if (poll_ret != HG_UTIL_SUCCESS) {
                     HG_UTIL_LOG_ERROR("poll cb failed");
                     ret = HG_UTIL_FAIL;
-                    hg_thread_spin_unlock(&poll_set->poll_data_list_lock);
                     goto done;
                 }
                 poll_progressed |= poll_cb_progressed;
@@ -600,3 +634,36 @@ hg_poll_wait(hg_poll_set_t *poll_set, unsigned int timeout,
 done:
     return ret;
 }
+
+/*---------------------------------------------------------------------------*/
+int
+hg_poll_wait(hg_poll_set_t *poll_set, unsigned int timeout,
+    hg_util_bool_t *progressed)
+{
+    struct hg_poll_data *removed_list = NULL;
+    int ret = HG_UTIL_SUCCESS;
+
+    if (!poll_set) {
+        HG_UTIL_LOG_ERROR("NULL poll set");
+        ret = HG_UTIL_FAIL;
+        goto done;
+    }
+
+    hg_thread_spin_lock(&poll_set->poll_data_list_lock);
+    poll_set->wait_count++;
+    hg_thread_spin_unlock(&poll_set->poll_data_list_lock);
+
+    ret = hg_poll_wait_dispatch(poll_set, timeout, progressed);
+
+    /* Last wait to return frees poll data removed in the meantime */
+    hg_thread_spin_lock(&poll_set->poll_data_list_lock);
+    if (--poll_set->wait_count == 0) {
+        removed_list = HG_LIST_FIRST(&poll_set->removed_list);
+        HG_LIST_INIT(&poll_set->removed_list);
+    }
+    hg_thread_spin_unlock(&poll_set->poll_data_list_lock);
+    hg_poll_data_release_all(removed_list);
+
+done:
+    return ret;
+}
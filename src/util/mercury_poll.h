@@ -111,7 +111,9 @@ hg_poll_add(hg_poll_set_t *poll_set, int fd, unsigned int flags,
     hg_poll_cb_t poll_cb, void *poll_cb_arg);
 
 /**
- * Remove file descriptor from poll set.
+ * Remove file descriptor from poll set. Can be called while other threads are
+ * in hg_poll_wait(), the callback is not called after removal but a call that
+ * already started may still be running when this returns.
  *
  * \param poll_set [IN]         pointer to poll set
  * \param fd [IN]               file descriptor
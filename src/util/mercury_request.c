@@ -12,17 +12,43 @@
 #include "mercury_thread_mutex.h"
 #include "mercury_thread_condition.h"
 #include "mercury_time.h"
+#include "mercury_queue.h"
 #include "mercury_util_error.h"
 
 #include <stdlib.h>
 
+/****************/
+/* Local Macros */
+/****************/
+
+/* Value of the completed field while the owner of the request is asleep */
+#define HG_REQUEST_SLEEPING (2)
+
+/* Get private request from public request */
+#define HG_REQUEST_PRIVATE(request) \
+    ((struct hg_request_private *) (request))
+
+/************************************/
+/* Local Type and Struct Definition */
+/************************************/
+
+/* Private request, each request has its own condition so that completion
+ * only wakes up the thread that is waiting on it */
+struct hg_request_private {
+    struct hg_request request;                  /* Must remain first */
+    hg_thread_mutex_t mutex;                    /* Protects cond/handoff */
+    hg_thread_cond_t cond;                      /* Signaled on completion */
+    hg_util_bool_t handoff;                     /* Progress handed off */
+    HG_QUEUE_ENTRY(hg_request_private) entry;   /* Entry in waiter queue */
+};
+
 struct hg_request_class {
     hg_request_progress_func_t progress_func;
     hg_request_trigger_func_t trigger_func;
     void *arg;
     hg_util_bool_t progressing;
     hg_thread_mutex_t progress_mutex;
-    hg_thread_cond_t progress_cond;
+    HG_QUEUE_HEAD(hg_request_private) waiter_queue; /* Waiting for progress */
 };
 
 /*---------------------------------------------------------------------------*/
@@ -45,6 +71,57 @@ hg_request_check(hg_request_t *request)
     return ret;
 }
 
+/*---------------------------------------------------------------------------*/
+/* Must be called with progress_mutex held */
+static HG_UTIL_INLINE void
+hg_request_handoff(struct hg_request_class *request_class)
+{
+    struct hg_request_private *hg_request;
+
+    if (request_class->progressing
+        || HG_QUEUE_IS_EMPTY(&request_class->waiter_queue))
+        return;
+
+    /* Only wake up the first waiter so that it takes over progress */
+    hg_request = HG_QUEUE_FIRST(&request_class->waiter_queue);
+    hg_thread_mutex_lock(&hg_request->mutex);
+    hg_request->handoff = HG_UTIL_TRUE;
+    hg_thread_cond_signal(&hg_request->cond);
+    hg_thread_mutex_unlock(&hg_request->mutex);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Must be called with progress_mutex held, returns with progress_mutex held */
+static void
+hg_request_sleep(struct hg_request_private *hg_request, unsigned int timeout)
+{
+    struct hg_request_class *request_class = hg_request->request.request_class;
+
+    HG_QUEUE_PUSH_TAIL(&request_class->waiter_queue, hg_request, entry);
+    hg_thread_mutex_lock(&hg_request->mutex);
+    hg_thread_mutex_unlock(&request_class->progress_mutex);
+
+    /* Announce that we are going to sleep, fails if already completed */
+    if (hg_atomic_cas32(&hg_request->request.completed, HG_UTIL_FALSE,
+        HG_REQUEST_SLEEPING)) {
+        while (!hg_request->handoff && (hg_atomic_get32(
+            &hg_request->request.completed) == HG_REQUEST_SLEEPING)) {
+            if (hg_thread_cond_timedwait(&hg_request->cond, &hg_request->mutex,
+                timeout) != HG_UTIL_SUCCESS)
+                break; /* Timeout occurred */
+        }
+        /* If this fails, request was completed in the meantime */
+        hg_atomic_cas32(&hg_request->request.completed, HG_REQUEST_SLEEPING,
+            HG_UTIL_FALSE);
+    }
+    hg_request->handoff = HG_UTIL_FALSE;
+    hg_thread_mutex_unlock(&hg_request->mutex);
+
+    hg_thread_mutex_lock(&request_class->progress_mutex);
+    HG_QUEUE_REMOVE(&request_class->waiter_queue, hg_request,
+        hg_request_private, entry);
+}
+
 /*---------------------------------------------------------------------------*/
 hg_request_class_t *
 hg_request_init(hg_request_progress_func_t progress_func,
@@ -64,7 +141,7 @@ hg_request_init(hg_request_progress_func_t progress_func,
     hg_request_class->arg = arg;
     hg_request_class->progressing = HG_UTIL_FALSE;
     hg_thread_mutex_init(&hg_request_class->progress_mutex);
-    hg_thread_cond_init(&hg_request_class->progress_cond);
+    HG_QUEUE_INIT(&hg_request_class->waiter_queue);
 
 done:
     return hg_request_class;
@@ -80,7 +157,6 @@ hg_request_finalize(hg_request_class_t *request_class, void **arg)
 
     if (arg) *arg = request_class->arg;
     hg_thread_mutex_destroy(&request_class->progress_mutex);
-    hg_thread_cond_destroy(&request_class->progress_cond);
     free(request_class);
 
 done:
@@ -91,54 +167,87 @@ done:
 hg_request_t *
 hg_request_create(hg_request_class_t *request_class)
 {
-    struct hg_request *hg_request = NULL;
+    struct hg_request_private *hg_request = NULL;
 
-    hg_request = (struct hg_request *) malloc(sizeof(struct hg_request));
+    hg_request = (struct hg_request_private *) malloc(
+        sizeof(struct hg_request_private));
     if (!hg_request) {
         HG_UTIL_LOG_ERROR("Could not allocate hg_request");
         goto done;
     }
 
-    hg_request->data = NULL;
-    hg_atomic_set32(&hg_request->completed, HG_UTIL_FALSE);
-    hg_request->request_class = request_class;
+    hg_request->request.data = NULL;
+    hg_atomic_init32(&hg_request->request.completed, HG_UTIL_FALSE);
+    hg_request->request.request_class = request_class;
+    hg_thread_mutex_init(&hg_request->mutex);
+    hg_thread_cond_init(&hg_request->cond);
+    hg_request->handoff = HG_UTIL_FALSE;
 
 done:
-    return hg_request;
+    return (hg_request_t *) hg_request;
 }
 
 /*---------------------------------------------------------------------------*/
 int
 hg_request_destroy(hg_request_t *request)
 {
+    struct hg_request_private *hg_request = HG_REQUEST_PRIVATE(request);
     int ret = HG_UTIL_SUCCESS;
 
-    free(request);
+    if (!hg_request) goto done;
 
+    hg_thread_mutex_destroy(&hg_request->mutex);
+    hg_thread_cond_destroy(&hg_request->cond);
+    free(hg_request);
+
+done:
     return ret;
 }
 
+/*---------------------------------------------------------------------------*/
+int
+hg_request_wake(hg_request_t *request)
+{
+    struct hg_request_private *hg_request = HG_REQUEST_PRIVATE(request);
+
+    /* Owner may stop sleeping in the meantime, hence the retry */
+    do {
+        hg_thread_mutex_lock(&hg_request->mutex);
+        if (hg_atomic_cas32(&request->completed, HG_REQUEST_SLEEPING,
+            HG_UTIL_TRUE)) {
+            hg_thread_cond_signal(&hg_request->cond);
+            hg_thread_mutex_unlock(&hg_request->mutex);
+            break;
+        }
+        hg_thread_mutex_unlock(&hg_request->mutex);
+    } while (!hg_atomic_cas32(&request->completed, HG_UTIL_FALSE,
+        HG_UTIL_TRUE) && hg_atomic_get32(&request->completed) != HG_UTIL_TRUE);
+
+    return HG_UTIL_SUCCESS;
+}
+
 /*---------------------------------------------------------------------------*/
 /*
+ * if (cas(completed, true, false))
+ *   return;
  * lock(progress_mutex)
  * while (!completed) {
  *   check_request
- *   if (completed) {
- *     unlock(progress_mutex);
- *     return;
- *     }
+ *   if (completed)
+ *     break;
  *   if (in_progress) {
- *     wait_cond(progress_cond);
+ *     queue(request);
+ *     wait_cond(request->cond);
+ *     dequeue(request);
  *     continue;
  *   }
  *   in_progress = true;
  *   unlock(progress_mutex);
- *   trigger;
  *   progress;
- *   lock(progress);
+ *   lock(progress_mutex);
  *   in_progress = false;
- *   signal(progress_cond);
  * }
+ * signal(first_queued_request->cond);
  * unlock(progress_mutex);
  */
 
@@ -146,65 +255,71 @@ hg_request_destroy(hg_request_t *request)
 int
 hg_request_wait(hg_request_t *request, unsigned int timeout, unsigned int *flag)
 {
+    struct hg_request_class *request_class = request->request_class;
     double remaining = timeout / 1000.0; /* Convert timeout in ms into seconds */
     hg_util_bool_t completed = HG_UTIL_FALSE;
     int ret = HG_UTIL_SUCCESS;
 
-    hg_thread_mutex_lock(&request->request_class->progress_mutex);
+    /* Fast path, request already completed */
+    if (hg_atomic_cas32(&request->completed, HG_UTIL_TRUE, HG_UTIL_FALSE)) {
+        completed = HG_UTIL_TRUE;
+        goto done;
+    }
+
+    hg_thread_mutex_lock(&request_class->progress_mutex);
 
     do {
-        hg_time_t t3, t4;
+        hg_time_ticks_t t1, t2;
 
         completed = hg_request_check(request);
         if (completed) break;
 
-        if (request->request_class->progressing) {
-            hg_time_t t1, t2;
-
+        if (request_class->progressing) {
             if (remaining <= 0) {
                 /* Timeout occurred so leave */
                 break;
             }
 
-            hg_time_get_current(&t1);
-            if (hg_thread_cond_timedwait(&request->request_class->progress_cond,
-                    &request->request_class->progress_mutex,
-                    (unsigned int) (remaining * 1000.0)) != HG_UTIL_SUCCESS) {
-                /* Timeout occurred so leave */
+            t1 = hg_time_get_ticks();
+            hg_request_sleep(HG_REQUEST_PRIVATE(request),
+                (unsigned int) (remaining * 1000.0));
+            t2 = hg_time_get_ticks();
+            remaining -= hg_time_ticks_to_double(t2 - t1);
+            if (hg_atomic_cas32(&request->completed, HG_UTIL_TRUE,
+                HG_UTIL_FALSE)) {
+                completed = HG_UTIL_TRUE;
                 break;
             }
-            hg_time_get_current(&t2);
-            remaining -= hg_time_to_double(hg_time_subtract(t2, t1));
-            if (remaining < 0)
-                break;
-            /* Continue as request may have completed in the meantime */
+            /* Continue as progress may have been handed off to us */
             continue;
         }
 
-        request->request_class->progressing = HG_UTIL_TRUE;
+        request_class->progressing = HG_UTIL_TRUE;
 
-        hg_thread_mutex_unlock(&request->request_class->progress_mutex);
+        hg_thread_mutex_unlock(&request_class->progress_mutex);
 
         if (timeout)
-            hg_time_get_current(&t3);
+            t1 = hg_time_get_ticks();
 
-        request->request_class->progress_func(
-                (unsigned int) (remaining * 1000.0),
-                request->request_class->arg);
+        request_class->progress_func((unsigned int) (remaining * 1000.0),
+            request_class->arg);
 
         if (timeout) {
-            hg_time_get_current(&t4);
-            remaining -= hg_time_to_double(hg_time_subtract(t4, t3));
+            t2 = hg_time_get_ticks();
+            remaining -= hg_time_ticks_to_double(t2 - t1);
         }
 
-        hg_thread_mutex_lock(&request->request_class->progress_mutex);
-        request->request_class->progressing = HG_UTIL_FALSE;
-        hg_thread_cond_broadcast(&request->request_class->progress_cond);
+        hg_thread_mutex_lock(&request_class->progress_mutex);
+        request_class->progressing = HG_UTIL_FALSE;
 
     } while (!completed && (remaining > 0));
 
-    hg_thread_mutex_unlock(&request->request_class->progress_mutex);
+    /* Let the next waiter make progress */
+    hg_request_handoff(request_class);
 
+    hg_thread_mutex_unlock(&request_class->progress_mutex);
+
+done:
     if (flag) *flag = completed;
 
     return ret;
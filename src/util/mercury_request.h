@@ -129,7 +129,23 @@ static HG_UTIL_INLINE int
 hg_request_complete(hg_request_t *request);
 
 /**
- * Wait timeout ms for the specified request to complete.
+ * Mark the request as completed and wake up the thread sleeping on it.
+ * This is the slow path of hg_request_complete() and should not be called
+ * directly.
+ *
+ * \param request [IN/OUT]      pointer to request
+ *
+ * \return Non-negative on success or negative on failure
+ */
+HG_UTIL_EXPORT int
+hg_request_wake(hg_request_t *request);
+
+/**
+ * Wait timeout ms for the specified request to complete. If the request has
+ * already completed, this call returns immediately without taking any lock.
+ * Only one thread makes progress at a time, other threads sleep on their own
+ * request and are only woken up when that request completes or when progress
+ * is handed off to them.
  *
  * \param request [IN/OUT]      pointer to request
  * \param timeout [IN]          timeout (in milliseconds)
@@ -215,7 +231,9 @@ hg_request_complete(hg_request_t *request)
 {
     int ret = HG_UTIL_SUCCESS;
 
-    hg_atomic_incr32(&request->completed);
+    /* Fails if the owner of the request is sleeping on it */
+    if (!hg_atomic_cas32(&request->completed, HG_UTIL_FALSE, HG_UTIL_TRUE))
+        ret = hg_request_wake(request);
 
     return ret;
 }
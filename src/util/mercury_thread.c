@@ -108,7 +108,7 @@ hg_thread_yield(void)
 
 /*---------------------------------------------------------------------------*/
 int
-hg_thread_key_create(hg_thread_key_t *key)
+hg_thread_key_create(hg_thread_key_t *key, void (*destructor)(void *))
 {
     int ret = HG_UTIL_SUCCESS;
 
@@ -119,12 +119,14 @@ hg_thread_key_create(hg_thread_key_t *key)
     }
 
 #ifdef _WIN32
-    if ((*key = TlsAlloc()) == TLS_OUT_OF_INDEXES) {
-        HG_UTIL_LOG_ERROR("TlsAlloc() failed");
+    /* Unlike TLS, FLS slots run their callback when the thread exits */
+    if ((*key = FlsAlloc((PFLS_CALLBACK_FUNCTION) destructor))
+        == FLS_OUT_OF_INDEXES) {
+        HG_UTIL_LOG_ERROR("FlsAlloc() failed");
         ret = HG_UTIL_FAIL;
     }
 #else
-    if (pthread_key_create(key, NULL)) {
+    if (pthread_key_create(key, destructor)) {
         HG_UTIL_LOG_ERROR("pthread_key_create() failed");
         ret = HG_UTIL_FAIL;
     }
@@ -140,8 +142,8 @@ hg_thread_key_delete(hg_thread_key_t key)
     int ret = HG_UTIL_SUCCESS;
 
 #ifdef _WIN32
-    if (!TlsFree(key)) {
-        HG_UTIL_LOG_ERROR("TlsFree() failed");
+    if (!FlsFree(key)) {
+        HG_UTIL_LOG_ERROR("FlsFree() failed");
         ret = HG_UTIL_FAIL;
     }
 #else
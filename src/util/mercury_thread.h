@@ -126,13 +126,16 @@ hg_thread_equal(hg_thread_t t1, hg_thread_t t2);
 
 /**
  * Create a thread-specific data key visible to all threads in the process.
+ * If \destructor is not NULL, it is called with the value associated to the
+ * key when a thread exits and that value is not NULL.
  *
  * \param key [OUT]             pointer to thread key object
+ * \param destructor [IN]       optional destructor
  *
  * \return Non-negative on success or negative on failure
  */
 HG_UTIL_EXPORT int
-hg_thread_key_create(hg_thread_key_t *key);
+hg_thread_key_create(hg_thread_key_t *key, void (*destructor)(void *));
 
 /**
  * Delete a thread-specific data key previously returned by
@@ -217,7 +220,7 @@ hg_thread_getspecific(hg_thread_key_t key)
     void *ret;
 
 #ifdef _WIN32
-    ret = TlsGetValue(key);
+    ret = FlsGetValue(key);
 #else
     ret = pthread_getspecific(key);
 #endif
@@ -232,8 +235,8 @@ hg_thread_setspecific(hg_thread_key_t key, const void *value)
     int ret = HG_UTIL_SUCCESS;
 
 #ifdef _WIN32
-    if (!TlsSetValue(key, (LPVOID) value)) {
-        HG_UTIL_LOG_ERROR("TlsSetValue() failed");
+    if (!FlsSetValue(key, (PVOID) value)) {
+        HG_UTIL_LOG_ERROR("FlsSetValue() failed");
         ret = HG_UTIL_FAIL;
     }
 #else
@@ -9,55 +9,304 @@
  */
 
 #include "mercury_thread_pool.h"
+#include "mercury_atomic_queue.h"
+#include "mercury_thread_mutex.h"
+#include "mercury_thread_condition.h"
 
 #include <stdlib.h>
 
-struct hg_thread_pool_private {
-    struct hg_thread_pool pool;
-    unsigned int thread_count;
-    hg_thread_t *threads;
+/****************/
+/* Local Macros */
+/****************/
+
+#define HG_THREAD_POOL_DEQUE_SIZE   256 /* Per-worker deque size */
+#define HG_THREAD_POOL_QUEUE_SIZE   256 /* Initial shared queue size */
+
+/* Worker states */
+#define HG_THREAD_POOL_RUNNING      0
+#define HG_THREAD_POOL_SLEEPING     1
+#define HG_THREAD_POOL_NOTIFIED     2
+
+/************************************/
+/* Local Type and Struct Definition */
+/************************************/
+
+/* Worker, deque is a bounded Chase-Lev deque: the owner pushes and takes at
+ * the bottom, other workers steal from the top */
+struct hg_thread_pool_worker {
+    hg_atomic_int64_t top __attribute__((aligned(HG_UTIL_CACHE_ALIGNMENT)));
+    hg_atomic_int64_t bottom __attribute__((aligned(HG_UTIL_CACHE_ALIGNMENT)));
+    hg_atomic_int64_t deque[HG_THREAD_POOL_DEQUE_SIZE];
+    hg_atomic_int32_t state;        /* Running / sleeping / notified */
+    hg_thread_mutex_t mutex;        /* Mutex used for sleeping */
+    hg_thread_cond_t cond;          /* Cond used for sleeping */
+    struct hg_thread_pool *pool;    /* Pool this worker belongs to */
+    hg_thread_t thread;             /* Worker thread */
+    unsigned int id;                /* Worker index */
+    unsigned int seed;              /* Seed for victim selection */
 };
 
+struct hg_thread_pool {
+    struct hg_atomic_queue_chain *queue;    /* Work posted by non-workers */
+    struct hg_thread_pool_worker *workers;  /* Array of workers */
+    unsigned int thread_count;              /* Number of workers */
+    unsigned int started_count;             /* Number of threads started */
+    hg_atomic_int32_t sleeping_worker_count;/* Number of sleeping workers */
+    hg_atomic_int32_t wake_index;           /* Next worker to try to wake */
+    hg_atomic_int32_t shutdown;             /* Pool is shutting down */
+    hg_thread_key_t worker_key;             /* Key to retrieve self worker */
+};
+
+/********************/
+/* Local Prototypes */
+/********************/
+
+/**
+ * Push work to the bottom of the worker's deque (owner only).
+ */
+static HG_UTIL_INLINE int
+hg_thread_pool_deque_push(struct hg_thread_pool_worker *worker,
+    struct hg_thread_work *work);
+
 /**
- * Worker thread run by the thread pool
+ * Take work from the bottom of the worker's deque (owner only).
  */
+static HG_UTIL_INLINE struct hg_thread_work *
+hg_thread_pool_deque_take(struct hg_thread_pool_worker *worker);
+
+/**
+ * Steal work from the top of the worker's deque.
+ */
+static HG_UTIL_INLINE struct hg_thread_work *
+hg_thread_pool_deque_steal(struct hg_thread_pool_worker *worker);
+
+/**
+ * Get work, first from own deque, then from the shared queue and finally
+ * by stealing from other workers.
+ */
+static struct hg_thread_work *
+hg_thread_pool_get_work(struct hg_thread_pool_worker *worker);
+
+/**
+ * Determine whether work is queued anywhere in the pool.
+ */
+static hg_util_bool_t
+hg_thread_pool_has_work(struct hg_thread_pool *pool);
+
+/**
+ * Put worker to sleep until new work is posted.
+ */
+static void
+hg_thread_pool_park(struct hg_thread_pool_worker *worker);
+
+/**
+ * Wake up a single sleeping worker if there is one.
+ */
+static HG_UTIL_INLINE void
+hg_thread_pool_unpark(struct hg_thread_pool *pool);
+
+/**
+ * Worker thread run by the thread pool.
+ */
+static HG_THREAD_RETURN_TYPE
+hg_thread_pool_worker(void *args);
+
+/*---------------------------------------------------------------------------*/
+static HG_UTIL_INLINE int
+hg_thread_pool_deque_push(struct hg_thread_pool_worker *worker,
+    struct hg_thread_work *work)
+{
+    hg_util_int64_t bottom = hg_atomic_get64(&worker->bottom);
+    hg_util_int64_t top = hg_atomic_get64(&worker->top);
+
+    if (bottom - top >= HG_THREAD_POOL_DEQUE_SIZE)
+        return HG_UTIL_FAIL; /* Full */
+
+    hg_atomic_set64(&worker->deque[bottom & (HG_THREAD_POOL_DEQUE_SIZE - 1)],
+        (hg_util_int64_t) work);
+    hg_atomic_set64(&worker->bottom, bottom + 1);
+
+    return HG_UTIL_SUCCESS;
+}
+
+/*---------------------------------------------------------------------------*/
+static HG_UTIL_INLINE struct hg_thread_work *
+hg_thread_pool_deque_take(struct hg_thread_pool_worker *worker)
+{
+    hg_util_int64_t bottom = hg_atomic_get64(&worker->bottom) - 1;
+    hg_util_int64_t top;
+    struct hg_thread_work *work = NULL;
+
+    hg_atomic_set64(&worker->bottom, bottom);
+    hg_atomic_fence();
+    top = hg_atomic_get64(&worker->top);
+
+    if (top <= bottom) {
+        work = (struct hg_thread_work *) hg_atomic_get64(
+            &worker->deque[bottom & (HG_THREAD_POOL_DEQUE_SIZE - 1)]);
+        if (top == bottom) {
+            /* Last entry, race against thieves */
+            if (!hg_atomic_cas64(&worker->top, top, top + 1))
+                work = NULL;
+            hg_atomic_set64(&worker->bottom, bottom + 1);
+        }
+    } else
+        hg_atomic_set64(&worker->bottom, bottom + 1); /* Empty */
+
+    return work;
+}
+
+/*---------------------------------------------------------------------------*/
+static HG_UTIL_INLINE struct hg_thread_work *
+hg_thread_pool_deque_steal(struct hg_thread_pool_worker *worker)
+{
+    hg_util_int64_t top, bottom;
+    struct hg_thread_work *work = NULL;
+
+    do {
+        top = hg_atomic_get64(&worker->top);
+        hg_atomic_fence();
+        bottom = hg_atomic_get64(&worker->bottom);
+        if (top >= bottom)
+            return NULL; /* Empty */
+
+        work = (struct hg_thread_work *) hg_atomic_get64(
+            &worker->deque[top & (HG_THREAD_POOL_DEQUE_SIZE - 1)]);
+    } while (!hg_atomic_cas64(&worker->top, top, top + 1));
+
+    return work;
+}
+
+/*---------------------------------------------------------------------------*/
+static struct hg_thread_work *
+hg_thread_pool_get_work(struct hg_thread_pool_worker *worker)
+{
+    struct hg_thread_pool *pool = worker->pool;
+    struct hg_thread_work *work;
+    unsigned int i, start;
+
+    work = hg_thread_pool_deque_take(worker);
+    if (work)
+        return work;
+
+    work = (struct hg_thread_work *) hg_atomic_queue_chain_pop_mc(pool->queue);
+    if (work)
+        return work;
+
+    /* Pick a random victim to start from so that thieves spread out */
+    worker->seed = worker->seed * 1103515245 + 12345;
+    start = (worker->seed >> 16) % pool->thread_count;
+    for (i = 0; i < pool->thread_count; i++) {
+        struct hg_thread_pool_worker *victim =
+            &pool->workers[(start + i) % pool->thread_count];
+
+        if (victim == worker)
+            continue;
+        work = hg_thread_pool_deque_steal(victim);
+        if (work)
+            return work;
+    }
+
+    return NULL;
+}
+
+/*---------------------------------------------------------------------------*/
+static hg_util_bool_t
+hg_thread_pool_has_work(struct hg_thread_pool *pool)
+{
+    unsigned int i;
+
+    if (!hg_atomic_queue_chain_is_empty(pool->queue))
+        return HG_UTIL_TRUE;
+
+    for (i = 0; i < pool->thread_count; i++)
+        if (hg_atomic_get64(&pool->workers[i].top)
+            < hg_atomic_get64(&pool->workers[i].bottom))
+            return HG_UTIL_TRUE;
+
+    return HG_UTIL_FALSE;
+}
+
+/*---------------------------------------------------------------------------*/
+static void
+hg_thread_pool_park(struct hg_thread_pool_worker *worker)
+{
+    struct hg_thread_pool *pool = worker->pool;
+
+    hg_atomic_set32(&worker->state, HG_THREAD_POOL_SLEEPING);
+    hg_atomic_incr32(&pool->sleeping_worker_count);
+    hg_atomic_fence();
+
+    /* Check again now that posters can see us sleeping */
+    if (hg_thread_pool_has_work(pool) || hg_atomic_get32(&pool->shutdown)) {
+        /* If this fails, we were notified and count was already updated */
+        if (hg_atomic_cas32(&worker->state, HG_THREAD_POOL_SLEEPING,
+            HG_THREAD_POOL_RUNNING))
+            hg_atomic_decr32(&pool->sleeping_worker_count);
+        hg_atomic_set32(&worker->state, HG_THREAD_POOL_RUNNING);
+        return;
+    }
+
+    hg_thread_mutex_lock(&worker->mutex);
+    while (hg_atomic_get32(&worker->state) == HG_THREAD_POOL_SLEEPING)
+        hg_thread_cond_wait(&worker->cond, &worker->mutex);
+    hg_thread_mutex_unlock(&worker->mutex);
+
+    hg_atomic_set32(&worker->state, HG_THREAD_POOL_RUNNING);
+}
+
+/*---------------------------------------------------------------------------*/
+static HG_UTIL_INLINE void
+hg_thread_pool_unpark(struct hg_thread_pool *pool)
+{
+    unsigned int i, start;
+
+    if (!hg_atomic_get32(&pool->sleeping_worker_count))
+        return;
+
+    start = (unsigned int) hg_atomic_incr32(&pool->wake_index);
+    for (i = 0; i < pool->thread_count; i++) {
+        struct hg_thread_pool_worker *worker =
+            &pool->workers[(start + i) % pool->thread_count];
+
+        if (hg_atomic_cas32(&worker->state, HG_THREAD_POOL_SLEEPING,
+            HG_THREAD_POOL_NOTIFIED)) {
+            hg_atomic_decr32(&pool->sleeping_worker_count);
+            hg_thread_mutex_lock(&worker->mutex);
+            hg_thread_cond_signal(&worker->cond);
+            hg_thread_mutex_unlock(&worker->mutex);
+            break;
+        }
+    }
+}
+
+/*---------------------------------------------------------------------------*/
 static HG_THREAD_RETURN_TYPE
 hg_thread_pool_worker(void *args)
 {
     hg_thread_ret_t ret = 0;
-    hg_thread_pool_t *pool = (hg_thread_pool_t*) args;
-    struct hg_thread_work *work;
+    struct hg_thread_pool_worker *worker =
+        (struct hg_thread_pool_worker *) args;
+    struct hg_thread_pool *pool = worker->pool;
+
+    hg_thread_setspecific(pool->worker_key, worker);
 
     while (1) {
-        hg_thread_mutex_lock(&pool->mutex);
-
-        /* If not shutting down and nothing to do, worker sleeps */
-        while (!pool->shutdown && HG_QUEUE_IS_EMPTY(&pool->queue)) {
-            pool->sleeping_worker_count++;
-            if (hg_thread_cond_wait(&pool->cond, &pool->mutex) != HG_UTIL_SUCCESS) {
-                HG_UTIL_LOG_ERROR("Thread cannot wait on condition variable");
-                goto unlock;
-            }
-            pool->sleeping_worker_count--;
-        }
+        struct hg_thread_work *work = hg_thread_pool_get_work(worker);
 
-        if (pool->shutdown && HG_QUEUE_IS_EMPTY(&pool->queue)) {
-            goto unlock;
+        if (work) {
+            /* Get to work */
+            (*work->func)(work->args);
+            continue;
         }
 
-        /* Grab our task */
-        work = HG_QUEUE_FIRST(&pool->queue);
-        HG_QUEUE_POP_HEAD(&pool->queue, entry);
+        /* Nothing left to do */
+        if (hg_atomic_get32(&pool->shutdown))
+            break;
 
-        /* Unlock */
-        hg_thread_mutex_unlock(&pool->mutex);
-
-        /* Get to work */
-        (*work->func)(work->args);
+        hg_thread_pool_park(worker);
     }
 
-unlock:
-    hg_thread_mutex_unlock(&pool->mutex);
     hg_thread_exit(ret);
     return ret;
 }
@@ -65,9 +314,17 @@ unlock:
 /*---------------------------------------------------------------------------*/
 int
 hg_thread_pool_init(unsigned int thread_count, hg_thread_pool_t **pool_ptr)
+{
+    return hg_thread_pool_init_opt(thread_count, NULL, pool_ptr);
+}
+
+/*---------------------------------------------------------------------------*/
+int
+hg_thread_pool_init_opt(unsigned int thread_count,
+    const hg_cpu_set_t *cpu_masks, hg_thread_pool_t **pool_ptr)
 {
     int ret = HG_UTIL_SUCCESS;
-    struct hg_thread_pool_private *priv_pool = NULL;
+    struct hg_thread_pool *pool = NULL;
     unsigned int i;
 
     if (!pool_ptr) {
@@ -76,56 +333,82 @@ hg_thread_pool_init(unsigned int thread_count, hg_thread_pool_t **pool_ptr)
         goto done;
     }
 
-    priv_pool = (struct hg_thread_pool_private *) malloc(
-        sizeof(struct hg_thread_pool_private));
-    if (!priv_pool) {
+    if (!thread_count) {
+        HG_UTIL_LOG_ERROR("Thread count must be greater than 0");
+        ret = HG_UTIL_FAIL;
+        goto done;
+    }
+
+    pool = (struct hg_thread_pool *) calloc(1, sizeof(struct hg_thread_pool));
+    if (!pool) {
         HG_UTIL_LOG_ERROR("Could not allocate thread pool");
         ret = HG_UTIL_FAIL;
         goto done;
     }
-    priv_pool->pool.sleeping_worker_count = 0;
-    priv_pool->thread_count = thread_count;
-    priv_pool->threads = NULL;
-    HG_QUEUE_INIT(&priv_pool->pool.queue);
-    priv_pool->pool.shutdown = 0;
+    pool->thread_count = thread_count;
+    hg_atomic_init32(&pool->sleeping_worker_count, 0);
+    hg_atomic_init32(&pool->wake_index, 0);
+    hg_atomic_init32(&pool->shutdown, 0);
 
-    if (hg_thread_mutex_init(&priv_pool->pool.mutex) != HG_UTIL_SUCCESS) {
-        HG_UTIL_LOG_ERROR("Could not initialize mutex");
+    if (hg_thread_key_create(&pool->worker_key, NULL) != HG_UTIL_SUCCESS) {
+        HG_UTIL_LOG_ERROR("Could not create thread key");
+        free(pool);
+        pool = NULL;
         ret = HG_UTIL_FAIL;
         goto done;
     }
-    if (hg_thread_cond_init(&priv_pool->pool.cond) != HG_UTIL_SUCCESS) {
-        HG_UTIL_LOG_ERROR("Could not initialize thread condition");
+
+    pool->queue = hg_atomic_queue_chain_alloc(HG_THREAD_POOL_QUEUE_SIZE);
+    if (!pool->queue) {
+        HG_UTIL_LOG_ERROR("Could not allocate thread pool queue");
         ret = HG_UTIL_FAIL;
         goto done;
     }
 
-    priv_pool->threads = (hg_thread_t*) malloc(thread_count * sizeof(hg_thread_t));
-    if (!priv_pool->threads) {
-        HG_UTIL_LOG_ERROR("Could not allocate thread pool array");
+    pool->workers = (struct hg_thread_pool_worker *) calloc(thread_count,
+        sizeof(struct hg_thread_pool_worker));
+    if (!pool->workers) {
+        HG_UTIL_LOG_ERROR("Could not allocate thread pool workers");
         ret = HG_UTIL_FAIL;
         goto done;
     }
 
+    for (i = 0; i < thread_count; i++) {
+        struct hg_thread_pool_worker *worker = &pool->workers[i];
+
+        hg_atomic_init64(&worker->top, 0);
+        hg_atomic_init64(&worker->bottom, 0);
+        hg_atomic_init32(&worker->state, HG_THREAD_POOL_RUNNING);
+        hg_thread_mutex_init(&worker->mutex);
+        hg_thread_cond_init(&worker->cond);
+        worker->pool = pool;
+        worker->id = i;
+        worker->seed = i + 1;
+    }
+
     /* Start worker threads */
     for (i = 0; i < thread_count; i++) {
-        if (hg_thread_create(&priv_pool->threads[i], hg_thread_pool_worker,
-                (void*) priv_pool) != HG_UTIL_SUCCESS) {
+        if (hg_thread_create(&pool->workers[i].thread, hg_thread_pool_worker,
+                (void *) &pool->workers[i]) != HG_UTIL_SUCCESS) {
             HG_UTIL_LOG_ERROR("Could not create thread");
             ret = HG_UTIL_FAIL;
             goto done;
         }
+        pool->started_count++;
+
+        if (cpu_masks && hg_thread_setaffinity(pool->workers[i].thread,
+            &cpu_masks[i]) != HG_UTIL_SUCCESS) {
+            HG_UTIL_LOG_ERROR("Could not set thread affinity");
+            ret = HG_UTIL_FAIL;
+            goto done;
+        }
     }
 
-    *pool_ptr = (struct hg_thread_pool *) priv_pool;
+    *pool_ptr = pool;
 
 done:
-    if (ret != HG_UTIL_SUCCESS) {
-        if (priv_pool) {
-            hg_thread_pool_destroy((struct hg_thread_pool *) priv_pool);
-        }
-        priv_pool = NULL;
-    }
+    if (ret != HG_UTIL_SUCCESS && pool)
+        hg_thread_pool_destroy(pool);
     return ret;
 }
 
@@ -133,51 +416,89 @@ done:
 int
 hg_thread_pool_destroy(hg_thread_pool_t *pool)
 {
-    struct hg_thread_pool_private *priv_pool =
-        (struct hg_thread_pool_private *) pool;
     int ret = HG_UTIL_SUCCESS;
     unsigned int i;
 
-    if (!priv_pool) goto done;
+    if (!pool) goto done;
 
-    if (priv_pool->threads) {
-        hg_thread_mutex_lock(&priv_pool->pool.mutex);
+    hg_atomic_set32(&pool->shutdown, 1);
+    hg_atomic_fence();
 
-        priv_pool->pool.shutdown = 1;
-
-        if (hg_thread_cond_broadcast(&priv_pool->pool.cond) != HG_UTIL_SUCCESS) {
-            HG_UTIL_LOG_ERROR("Could not broadcast condition signal");
+    /* Wake up everyone so that workers can drain queues and exit */
+    for (i = 0; i < pool->started_count; i++)
+        hg_thread_pool_unpark(pool);
+    for (i = 0; i < pool->started_count; i++) {
+        if (hg_thread_join(pool->workers[i].thread) != HG_UTIL_SUCCESS) {
+            HG_UTIL_LOG_ERROR("Could not join thread");
             ret = HG_UTIL_FAIL;
+            goto done;
         }
+    }
 
-        hg_thread_mutex_unlock(&priv_pool->pool.mutex);
+    if (pool->workers) {
+        for (i = 0; i < pool->thread_count; i++) {
+            hg_thread_mutex_destroy(&pool->workers[i].mutex);
+            hg_thread_cond_destroy(&pool->workers[i].cond);
+        }
+        free(pool->workers);
+    }
+    hg_atomic_queue_chain_free(pool->queue);
+    hg_thread_key_delete(pool->worker_key);
+    free(pool);
 
-        if (ret != HG_UTIL_SUCCESS) goto done;
+done:
+    return ret;
+}
 
-        for(i = 0; i < priv_pool->thread_count; i++) {
-            if (hg_thread_join(priv_pool->threads[i]) != HG_UTIL_SUCCESS) {
-                HG_UTIL_LOG_ERROR("Could not join thread");
-                ret = HG_UTIL_FAIL;
-                goto done;
-            }
-        }
+/*---------------------------------------------------------------------------*/
+int
+hg_thread_pool_post(hg_thread_pool_t *pool, struct hg_thread_work *work)
+{
+    struct hg_thread_pool_worker *worker;
+    int ret = HG_UTIL_SUCCESS;
+
+    if (!pool) {
+        HG_UTIL_LOG_ERROR("Thread pool not initialized");
+        ret = HG_UTIL_FAIL;
+        goto done;
     }
 
-    free(priv_pool->threads);
-    priv_pool->threads = NULL;
+    if (!work) {
+        HG_UTIL_LOG_ERROR("Thread work cannot be NULL");
+        ret = HG_UTIL_FAIL;
+        goto done;
+    }
 
-    if (hg_thread_mutex_destroy(&priv_pool->pool.mutex) != HG_UTIL_SUCCESS) {
-        HG_UTIL_LOG_ERROR("Could not destroy mutex");
+    if (!work->func) {
+        HG_UTIL_LOG_ERROR("Function pointer cannot be NULL");
         ret = HG_UTIL_FAIL;
         goto done;
     }
-    if (hg_thread_cond_destroy(&priv_pool->pool.cond) != HG_UTIL_SUCCESS){
-        HG_UTIL_LOG_ERROR("Could not destroy thread condition");
+
+    worker = (struct hg_thread_pool_worker *) hg_thread_getspecific(
+        pool->worker_key);
+
+    /* Are we shutting down ? (workers may still post while draining) */
+    if (!worker && hg_atomic_get32(&pool->shutdown)) {
+        HG_UTIL_LOG_ERROR("Pool is shutting down");
         ret = HG_UTIL_FAIL;
         goto done;
     }
 
-    free(priv_pool);
+    /* Workers push to their own deque, everyone else to the shared queue */
+    if (!worker || (hg_thread_pool_deque_push(worker, work)
+        != HG_UTIL_SUCCESS)) {
+        if (hg_atomic_queue_chain_push(pool->queue, work)
+            != HG_UTIL_SUCCESS) {
+            HG_UTIL_LOG_ERROR("Could not push work to pool queue");
+            ret = HG_UTIL_FAIL;
+            goto done;
+        }
+    }
+
+    /* Make work visible before checking for sleeping workers */
+    hg_atomic_fence();
+    hg_thread_pool_unpark(pool);
 
 done:
     return ret;
@@ -13,18 +13,17 @@
 
 #include "mercury_thread.h"
 #include "mercury_queue.h"
-#include "mercury_thread_condition.h"
 #include "mercury_util_error.h"
 
-typedef struct hg_thread_pool hg_thread_pool_t;
+/**
+ * Purpose: work-stealing thread pool. Each worker owns a bounded deque
+ * where work posted from that worker is pushed and executed in LIFO order,
+ * work posted from other threads goes to a shared lock-free queue. Idle
+ * workers steal from other workers before going to sleep and are woken up
+ * one at a time when new work is posted.
+ */
 
-struct hg_thread_pool {
-    unsigned int sleeping_worker_count;
-    HG_QUEUE_HEAD(hg_thread_work) queue;
-    int shutdown;
-    hg_thread_mutex_t mutex;
-    hg_thread_cond_t cond;
-};
+typedef struct hg_thread_pool hg_thread_pool_t; /* Opaque thread pool */
 
 struct hg_thread_work {
     hg_thread_func_t func;
@@ -49,7 +48,24 @@ HG_UTIL_EXPORT int
 hg_thread_pool_init(unsigned int thread_count, hg_thread_pool_t **pool);
 
 /**
- * Destroy the thread pool.
+ * Initialize the thread pool and bind worker threads. If \cpu_masks is not
+ * NULL, it must contain \thread_count entries and worker i is bound to
+ * cpu_masks[i].
+ *
+ * \param thread_count [IN]     number of threads that will be created at
+ *                              initialization
+ * \param cpu_masks [IN]        array of CPU masks or NULL
+ * \param pool [OUT]            pointer to pool object
+ *
+ * \return Non-negative on success or negative on failure
+ */
+HG_UTIL_EXPORT int
+hg_thread_pool_init_opt(unsigned int thread_count,
+    const hg_cpu_set_t *cpu_masks, hg_thread_pool_t **pool);
+
+/**
+ * Destroy the thread pool. Work that was already posted is executed before
+ * worker threads exit.
  *
  * \param pool [IN/OUT]         pointer to pool object
  *
@@ -60,67 +76,18 @@ hg_thread_pool_destroy(hg_thread_pool_t *pool);
 
 /**
  * Post work to the pool. Note that the operation may be queued depending on
- * the number of threads and number of tasks already running.
+ * the number of threads and number of tasks already running. When called
+ * from one of the pool workers, work is queued to that worker and is
+ * executed before older work.
  *
  * \param pool [IN/OUT]         pointer to pool object
  * \param work [IN]             pointer to work struct
  *
  * \return Non-negative on success or negative on failure
  */
-static HG_UTIL_INLINE int
+HG_UTIL_EXPORT int
 hg_thread_pool_post(hg_thread_pool_t *pool, struct hg_thread_work *work);
 
-/*---------------------------------------------------------------------------*/
-static HG_UTIL_INLINE int
-hg_thread_pool_post(hg_thread_pool_t *pool, struct hg_thread_work *work)
-{
-    int ret = HG_UTIL_SUCCESS;
-
-    if (!pool) {
-        HG_UTIL_LOG_ERROR("Thread pool not initialized");
-        ret = HG_UTIL_FAIL;
-        goto done;
-    }
-
-    if (!work) {
-        HG_UTIL_LOG_ERROR("Thread work cannot be NULL");
-        ret = HG_UTIL_FAIL;
-        goto done;
-    }
-
-    if (!work->func) {
-        HG_UTIL_LOG_ERROR("Function pointer cannot be NULL");
-        ret = HG_UTIL_FAIL;
-        goto done;
-    }
-
-    hg_thread_mutex_lock(&pool->mutex);
-
-    /* Are we shutting down ? */
-    if (pool->shutdown) {
-        HG_UTIL_LOG_ERROR("Pool is shutting down");
-        ret = HG_UTIL_FAIL;
-        goto unlock;
-    }
-
-    /* Add task to task queue */
-    HG_QUEUE_PUSH_TAIL(&pool->queue, work, entry);
-
-    /* Wake up sleeping worker */
-    if (pool->sleeping_worker_count) {
-        if (hg_thread_cond_signal(&pool->cond) != HG_UTIL_SUCCESS) {
-            HG_UTIL_LOG_ERROR("Cannot signal pool condition");
-            ret = HG_UTIL_FAIL;
-        }
-    }
-
-unlock:
-    hg_thread_mutex_unlock(&pool->mutex);
-
-done:
-    return ret;
-}
-
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,203 @@
+/*
+ * Copyright (C) 2013-2019 Argonne National Laboratory, Department of Energy,
+ *                    UChicago Argonne, LLC and The HDF Group.
+ * All rights reserved.
+ *
+ * The full copyright notice, including terms governing use, modification,
+ * and redistribution, is contained in the COPYING file that can be
+ * found at the root of the source code distribution tree.
+ */
+
+#include "mercury_time.h"
+
+#if defined(HG_TIME_HAS_TSC) || defined(HG_TIME_HAS_CNTVCT)
+# include "mercury_thread_mutex.h"
+#endif
+#if defined(HG_TIME_HAS_TSC)
+# include <cpuid.h>
+#endif
+
+/****************/
+/* Local Macros */
+/****************/
+
+/* Period of ticks returned by the monotonic clock fallback */
+#if !defined(_WIN32) && defined(HG_UTIL_HAS_TIME_H) \
+    && defined(HG_UTIL_HAS_CLOCK_GETTIME)
+# define HG_TIME_FALLBACK_FREQ      1e9
+#else
+# define HG_TIME_FALLBACK_FREQ      1e6
+#endif
+
+/* Time spent measuring the CPU counter frequency (in seconds) */
+#define HG_TIME_CALIBRATE_TIME      0.001
+
+/********************/
+/* Local Prototypes */
+/********************/
+
+/**
+ * Read monotonic clock in units of 1 / HG_TIME_FALLBACK_FREQ.
+ */
+static HG_UTIL_INLINE hg_time_ticks_t
+hg_time_get_monotonic(void);
+
+#if defined(HG_TIME_HAS_TSC) || defined(HG_TIME_HAS_CNTVCT)
+/**
+ * Return frequency of the CPU counter or 0 if it cannot be used.
+ */
+static double
+hg_time_counter_freq(void);
+#endif
+
+/*******************/
+/* Local Variables */
+/*******************/
+
+struct hg_time_ticks_info hg_time_ticks_info_g = {
+    1.0 / HG_TIME_FALLBACK_FREQ,
+    1e9 / HG_TIME_FALLBACK_FREQ,
+    HG_TIME_FALLBACK_FREQ,
+    HG_UTIL_FALSE,
+    HG_ATOMIC_VAR_INIT(0)
+};
+
+#if defined(HG_TIME_HAS_TSC) || defined(HG_TIME_HAS_CNTVCT)
+/* Serializes selection of the tick source */
+static hg_thread_mutex_t hg_time_ticks_lock_g = HG_THREAD_MUTEX_INITIALIZER;
+#endif
+
+/*---------------------------------------------------------------------------*/
+static HG_UTIL_INLINE hg_time_ticks_t
+hg_time_get_monotonic(void)
+{
+#if !defined(_WIN32) && defined(HG_UTIL_HAS_TIME_H) \
+    && defined(HG_UTIL_HAS_CLOCK_GETTIME)
+    struct timespec tp = {0, 0};
+
+    clock_gettime(CLOCK_MONOTONIC, &tp);
+    return (hg_time_ticks_t) tp.tv_sec * 1000000000
+        + (hg_time_ticks_t) tp.tv_nsec;
+#else
+    hg_time_t tv;
+
+    hg_time_get_current(&tv);
+    return (hg_time_ticks_t) tv.tv_sec * 1000000
+        + (hg_time_ticks_t) tv.tv_usec;
+#endif
+}
+
+#if defined(HG_TIME_HAS_TSC)
+/*---------------------------------------------------------------------------*/
+static double
+hg_time_counter_freq(void)
+{
+    hg_time_ticks_t t1, t2, c1, c2;
+    unsigned int eax, ebx, ecx, edx;
+
+    /* TSC must be invariant (constant rate and not stopped in idle states) */
+    if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) || !(edx & (1 << 8)))
+        return 0;
+
+    /* Measure against the monotonic clock */
+    t1 = hg_time_get_monotonic();
+    c1 = hg_time_get_counter();
+    do {
+        t2 = hg_time_get_monotonic();
+    } while ((double) (t2 - t1)
+        < HG_TIME_CALIBRATE_TIME * HG_TIME_FALLBACK_FREQ);
+    c2 = hg_time_get_counter();
+
+    return (double) (c2 - c1) * HG_TIME_FALLBACK_FREQ / (double) (t2 - t1);
+}
+
+#elif defined(HG_TIME_HAS_CNTVCT)
+/*---------------------------------------------------------------------------*/
+static double
+hg_time_counter_freq(void)
+{
+    hg_time_ticks_t freq;
+
+    /* Generic timer frequency is provided by firmware */
+    __asm__ __volatile__("mrs %0, cntfrq_el0" : "=r" (freq));
+
+    return (double) freq;
+}
+#endif
+
+/*---------------------------------------------------------------------------*/
+void
+hg_time_ticks_init(void)
+{
+#if defined(HG_TIME_HAS_TSC) || defined(HG_TIME_HAS_CNTVCT)
+    double freq;
+
+    /* Called on every NA class initialization */
+    if (hg_atomic_get32(&hg_time_ticks_info_g.ready))
+        return;
+
+    /* Ticks can only be handed out once the source can no longer change */
+    hg_thread_mutex_lock(&hg_time_ticks_lock_g);
+    if (!hg_atomic_get32(&hg_time_ticks_info_g.ready)) {
+        freq = hg_time_counter_freq();
+        if (freq > 0) {
+            hg_time_ticks_info_g.sec_per_tick = 1.0 / freq;
+            hg_time_ticks_info_g.ns_per_tick = 1e9 / freq;
+            hg_time_ticks_info_g.ticks_per_sec = freq;
+            hg_atomic_fence();
+            hg_time_ticks_info_g.use_counter = HG_UTIL_TRUE;
+        }
+        hg_atomic_set32(&hg_time_ticks_info_g.ready, 1);
+    }
+    hg_thread_mutex_unlock(&hg_time_ticks_lock_g);
+#else
+    hg_atomic_set32(&hg_time_ticks_info_g.ready, 1);
+#endif
+}
+
+/*---------------------------------------------------------------------------*/
+hg_time_ticks_t
+hg_time_get_ticks_fallback(void)
+{
+    if (!hg_atomic_get32(&hg_time_ticks_info_g.ready))
+        hg_time_ticks_init();
+
+#if defined(HG_TIME_HAS_TSC) || defined(HG_TIME_HAS_CNTVCT)
+    /* First call may have selected the CPU counter */
+    if (hg_time_ticks_info_g.use_counter)
+        return hg_time_get_counter();
+#endif
+
+    return hg_time_get_monotonic();
+}
+
+/*---------------------------------------------------------------------------*/
+double
+hg_time_ticks_to_double(hg_time_ticks_t ticks)
+{
+    if (!hg_atomic_get32(&hg_time_ticks_info_g.ready))
+        hg_time_ticks_init();
+
+    return (double) ticks * hg_time_ticks_info_g.sec_per_tick;
+}
+
+/*---------------------------------------------------------------------------*/
+hg_util_uint64_t
+hg_time_ticks_to_ns(hg_time_ticks_t ticks)
+{
+    if (!hg_atomic_get32(&hg_time_ticks_info_g.ready))
+        hg_time_ticks_init();
+
+    return (hg_util_uint64_t) ((double) ticks
+        * hg_time_ticks_info_g.ns_per_tick);
+}
+
+/*---------------------------------------------------------------------------*/
+hg_time_ticks_t
+hg_time_ticks_from_double(double d)
+{
+    if (!hg_atomic_get32(&hg_time_ticks_info_g.ready))
+        hg_time_ticks_init();
+
+    return (hg_time_ticks_t) (d * hg_time_ticks_info_g.ticks_per_sec);
+}
@@ -12,6 +12,7 @@
 #define MERCURY_TIME_H
 
 #include "mercury_util_config.h"
+#include "mercury_atomic.h"
 #if defined(_WIN32)
 # include <windows.h>
 #elif defined(HG_UTIL_HAS_CLOCK_MONOTONIC)
@@ -32,6 +33,25 @@
 #  error "Not supported on this platform."
 # endif
 #endif
+#if !defined(_WIN32) && defined(HG_UTIL_HAS_TIME_H) \
+    && defined(HG_UTIL_HAS_CLOCK_GETTIME)
+# include <time.h>
+#endif
+
+/* CPU counters that can be read from user space */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# define HG_TIME_HAS_TSC
+#elif defined(__GNUC__) && defined(__aarch64__)
+# define HG_TIME_HAS_CNTVCT
+#endif
+
+/* Tick reads are small enough to be inlined even where GCC predicts the call
+ * as unlikely */
+#if defined(__GNUC__)
+# define HG_TIME_TICKS_INLINE HG_UTIL_INLINE __attribute__((always_inline))
+#else
+# define HG_TIME_TICKS_INLINE HG_UTIL_INLINE
+#endif
 
 typedef struct hg_time hg_time_t;
 struct hg_time
@@ -40,6 +60,21 @@ struct hg_time
     long tv_usec;
 };
 
+/* Raw clock ticks, only meaningful as differences */
+typedef hg_util_uint64_t hg_time_ticks_t;
+
+/* Tick source, selected on first use. Ticks are read from the CPU counter if
+ * it runs at a constant rate, from the monotonic clock otherwise. */
+struct hg_time_ticks_info {
+    double sec_per_tick;            /* Tick period in seconds */
+    double ns_per_tick;             /* Tick period in nanoseconds */
+    double ticks_per_sec;           /* Tick frequency */
+    hg_util_bool_t use_counter;     /* Ticks are read from CPU counter */
+    hg_atomic_int32_t ready;        /* Tick source has been selected */
+};
+
+extern HG_UTIL_EXPORT struct hg_time_ticks_info hg_time_ticks_info_g;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -54,6 +89,76 @@ extern "C" {
 static HG_UTIL_INLINE int
 hg_time_get_current(hg_time_t *tv);
 
+/**
+ * Get a coarse elapsed time, typically updated once per scheduler tick but
+ * cheaper to read than hg_time_get_current(). Values can only be compared
+ * with other values returned by this function.
+ *
+ * \param tv [OUT]              pointer to returned time structure
+ *
+ * \return Non-negative on success or negative on failure
+ */
+static HG_UTIL_INLINE int
+hg_time_get_current_coarse(hg_time_t *tv);
+
+/**
+ * Get current value of the tick counter. Reading ticks is much cheaper than
+ * hg_time_get_current() and is intended for measuring intervals on hot
+ * paths; use hg_time_ticks_to_double() to convert a tick difference.
+ *
+ * \return Tick value
+ */
+static HG_TIME_TICKS_INLINE hg_time_ticks_t
+hg_time_get_ticks(void);
+
+/**
+ * Select the tick source if not already done. This is done on first use of
+ * ticks and takes about a millisecond when the CPU counter frequency must be
+ * measured; it can be called earlier to move that cost out of a hot path.
+ * NA_Initialize() calls it so that NA and HG users do not need to.
+ */
+HG_UTIL_EXPORT void
+hg_time_ticks_init(void);
+
+/**
+ * Get current value of the tick counter when it is not read from the CPU
+ * counter. Out-of-line part of hg_time_get_ticks().
+ *
+ * \return Tick value
+ */
+HG_UTIL_EXPORT hg_time_ticks_t
+hg_time_get_ticks_fallback(void);
+
+/**
+ * Convert ticks to seconds.
+ *
+ * \param ticks [IN]            number of ticks
+ *
+ * \return Converted time in seconds
+ */
+HG_UTIL_EXPORT double
+hg_time_ticks_to_double(hg_time_ticks_t ticks);
+
+/**
+ * Convert ticks to nanoseconds.
+ *
+ * \param ticks [IN]            number of ticks
+ *
+ * \return Converted time in nanoseconds
+ */
+HG_UTIL_EXPORT hg_util_uint64_t
+hg_time_ticks_to_ns(hg_time_ticks_t ticks);
+
+/**
+ * Convert seconds to ticks.
+ *
+ * \param d [IN]                time in seconds
+ *
+ * \return Number of ticks
+ */
+HG_UTIL_EXPORT hg_time_ticks_t
+hg_time_ticks_from_double(double d);
+
 /**
  * Convert hg_time_t to double.
  *
@@ -257,6 +362,58 @@ hg_time_get_current(hg_time_t *tv)
 
 # endif
 #endif
+/*---------------------------------------------------------------------------*/
+static HG_UTIL_INLINE int
+hg_time_get_current_coarse(hg_time_t *tv)
+{
+#if !defined(_WIN32) && defined(HG_UTIL_HAS_TIME_H) \
+    && defined(HG_UTIL_HAS_CLOCK_GETTIME) && defined(CLOCK_MONOTONIC_COARSE)
+    struct timespec tp = {0, 0};
+
+    if (!tv)
+        return HG_UTIL_FAIL;
+
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &tp);
+    tv->tv_sec = tp.tv_sec;
+    tv->tv_usec = tp.tv_nsec / 1000;
+
+    return HG_UTIL_SUCCESS;
+#else
+    return hg_time_get_current(tv);
+#endif
+}
+
+#if defined(HG_TIME_HAS_TSC) || defined(HG_TIME_HAS_CNTVCT)
+/*---------------------------------------------------------------------------*/
+static HG_TIME_TICKS_INLINE hg_time_ticks_t
+hg_time_get_counter(void)
+{
+    hg_time_ticks_t ticks;
+#if defined(HG_TIME_HAS_TSC)
+    hg_util_uint32_t lo, hi;
+
+    __asm__ __volatile__("rdtsc" : "=a" (lo), "=d" (hi));
+    ticks = ((hg_time_ticks_t) hi << 32) | lo;
+#else
+    __asm__ __volatile__("mrs %0, cntvct_el0" : "=r" (ticks));
+#endif
+
+    return ticks;
+}
+#endif
+
+/*---------------------------------------------------------------------------*/
+static HG_TIME_TICKS_INLINE hg_time_ticks_t
+hg_time_get_ticks(void)
+{
+#if defined(HG_TIME_HAS_TSC) || defined(HG_TIME_HAS_CNTVCT)
+    if (hg_time_ticks_info_g.use_counter)
+        return hg_time_get_counter();
+#endif
+
+    return hg_time_get_ticks_fallback();
+}
+
 /*---------------------------------------------------------------------------*/
 static HG_UTIL_INLINE double
 hg_time_to_double(hg_time_t tv)